@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+
+# Plays REC files between two headless netplay peers on this machine, with a netrelay in between that adds
+# latency, jitter, reordering and loss. Reports how much rollback the netcode needed, and whether the peers agreed
+# on the game state.
+
+if [ -z "$1" ]; then
+    echo "Usage: $0 <build-dir> [--rec <file>] [--delay <ms>] [--jitter <ms>] [--loss <percent>]" \
+        "[--reorder <percent>] [--port <port>]" >&2
+    exit 1
+fi
+
+find_binary() {
+    local bin
+    bin=$(find "$1" -name "$2" -type f -executable -print -quit)
+    if [ -z "$bin" ]; then
+        echo "Could not find $2 executable from $1" >&2
+        exit 1
+    fi
+    realpath "$bin"
+}
+
+BUILD_DIR="$1"
+OPENOMF_BIN=$(find_binary "$BUILD_DIR" openomf) || exit 1
+RELAY_BIN=$(find_binary "$BUILD_DIR" netrelay) || exit 1
+shift
+
+RUNDIR=$(pwd)
+recs=()
+relay_args=()
+port=2097
+while [ -n "$1" ]; do
+    case "$1" in
+        --rec) recs+=("$(realpath "$2")"); shift ;;
+        --delay|--jitter|--loss|--reorder) relay_args+=("$1" "$2"); shift ;;
+        --port) port="$2"; shift ;;
+    esac
+    shift
+done
+if [ ${#recs[@]} -eq 0 ]; then
+    recs=("$RUNDIR"/rectests/*.REC)
+fi
+
+# Prints the value of a field in a one line JSON report
+json_field() {
+    sed -n "s/.*\"$2\":\([^,}]*\).*/\1/p" "$1" | tr -d '"'
+}
+
+fail_count=0
+workdir=$(mktemp -d)
+
+cd "$BUILD_DIR"
+
+export ASAN_OPTIONS=detect_leaks=0
+
+echo "Running netplay tests with relay options: ${relay_args[*]:-none}"
+
+for rec in "${recs[@]}"; do
+    name=$(basename "$rec")
+    $RELAY_BIN --port $((port + 1)) --server-port $port --idle 3 "${relay_args[@]}" > "$workdir/relay.log" &
+    relay_pid=$!
+    $OPENOMF_BIN --headless -P "$rec" --listen -p $port > "$workdir/server.json" 2>/dev/null &
+    server_pid=$!
+    sleep 1
+    $OPENOMF_BIN --headless -P "$rec" --connect 127.0.0.1 -p $((port + 1)) > "$workdir/client.json" 2>/dev/null
+    wait $server_pid
+    # The relay stops, and prints its statistics, once the peers have been quiet for a while
+    wait $relay_pid
+
+    echo "${name} :"
+    status=MATCH
+    for side in server client; do
+        report="$workdir/$side.json"
+        if [ "$(json_field "$report" result)" != "ok" ]; then
+            echo "    ${side}: FAILED ($(json_field "$report" error))"
+            status=FAILED
+            continue
+        fi
+        echo "    ${side}: $(json_field "$report" rollbacks) rollbacks," \
+            "$(json_field "$report" replayed_ticks_per_sec) replayed ticks/s," \
+            "max rollback $(json_field "$report" max_rollback) ticks," \
+            "rtt $(json_field "$report" avg_rtt) ticks," \
+            "$(json_field "$report" hashes_checked) hashes checked"
+        if [ "$(json_field "$report" desynced)" != "false" ] || [ "$(json_field "$report" hashes_checked)" = "0" ]; then
+            status=DIVERGED
+        fi
+    done
+
+    # Each side checks the hashes of the other, but compare the last ones here as well when they are for the same tick
+    if [ $status = MATCH ] &&
+        [ "$(json_field "$workdir/server.json" hash_tick)" = "$(json_field "$workdir/client.json" hash_tick)" ] &&
+        [ "$(json_field "$workdir/server.json" hash)" != "$(json_field "$workdir/client.json" hash)" ]; then
+        status=DIVERGED
+    fi
+
+    echo "    hashes ${status}"
+    if [ $status != MATCH ]; then
+        ((fail_count++))
+    fi
+    sed -n 's/^\(client\|server\) -> /    relay \1 -> /p' "$workdir/relay.log"
+done
+
+rm -rf "$workdir"
+
+# Exit with non-zero status if any test failed
+exit $fail_count
@@ -1,19 +1,41 @@
 #!/usr/bin/env bash
 
 if [ -z "$1" ]; then
-    echo "Usage: $0 <build-dir>" >&2
+    echo "Usage: $0 <build-dir> [--bench] [--compare <other-build-dir>]" >&2
     exit 1
 fi
 
+find_openomf() {
+    local bin
+    bin=$(find "$1" -name openomf -type f -executable -print -quit)
+    if [ -z "$bin" ]; then
+        echo "Could not find openomf executable from $1" >&2
+        exit 1
+    fi
+    realpath "$bin"
+}
+
 export BUILD_DIR="$1"
-OPENOMF_BIN=$(find "$BUILD_DIR" -name openomf -type f -executable -print -quit)
-if [ -z "$OPENOMF_BIN" ]; then
-    echo "Could not find openomf executable from $BUILD_DIR" >&2
-    exit 1
+OPENOMF_BIN=$(find_openomf "$BUILD_DIR") || exit 1
+export OPENOMF_BIN
+shift
+
+bench=0
+compare_dir=""
+while [ -n "$1" ]; do
+    case "$1" in
+        --bench) bench=1 ;;
+        --compare) compare_dir="$2"; shift ;;
+    esac
+    shift
+done
+if [ -n "$compare_dir" ]; then
+    COMPARE_BIN=$(find_openomf "$compare_dir") || exit 1
+    compare_dir=$(realpath "$compare_dir")
 fi
-export OPENOMF_BIN="./${OPENOMF_BIN#$BUILD_DIR}"
 
 # Define your tests here (description:filename)
+# Debug builds also check every move lookup against a plain scan over all moves, and abort on a mismatch.
 tests=(
     "Overhead throw should throw opponent to the right:OHT.REC"
     "Electra should be able to kick while doing inputs for rolling thunder:65K6P.REC"
@@ -37,7 +59,7 @@ for test in "${tests[@]}"; do
     filename=$(echo "$filename" | xargs)
 
     echo -n "${desc} :"
-    if $OPENOMF_BIN --force-audio-backend=NULL --force-renderer=NULL --speed=10 -P "$RUNDIR/rectests/${filename}" >/dev/null 2>&1; then
+    if $OPENOMF_BIN --headless -P "$RUNDIR/rectests/${filename}" >/dev/null 2>&1; then
         echo " PASS"
     else
         echo " FAILED"
@@ -45,5 +67,55 @@ for test in "${tests[@]}"; do
     fi
 done
 
+# Replay every REC file in parallel, and report how long it took
+if [ $bench -eq 1 ]; then
+    echo "Replaying all of rectests/ ..."
+    time $OPENOMF_BIN --replay-dir "$RUNDIR/rectests" >/dev/null
+fi
+
+# Prints "<tick> <hash>" for every tick of the given REC file in a --replay-dir report
+report_hashes() {
+    grep -F "\"file\":\"$2\"" "$1" | sed -n 's/.*"first_tick":\([0-9]*\),"hashes":\[\(.*\)\]}$/\1 \2/p' |
+        awk '{ n = split($2, h, ","); for(i = 1; i <= n; i++) print $1 + i - 1, h[i] }'
+}
+
+# Replay every REC file with both builds, and compare the per-tick state hashes. Two USE_FIXED_PHYSICS builds must
+# match exactly, whatever compilers and flags they were built with. Float and fixed-point builds round differently,
+# so between those the first diverging tick is only reported.
+if [ -n "$compare_dir" ]; then
+    fixed_a=$(grep -c "^USE_FIXED_PHYSICS:BOOL=ON" CMakeCache.txt 2>/dev/null)
+    fixed_b=$(grep -c "^USE_FIXED_PHYSICS:BOOL=ON" "$compare_dir/CMakeCache.txt" 2>/dev/null)
+    strict=1
+    if [ "${fixed_a:-0}" != "${fixed_b:-0}" ]; then
+        echo "Note: only one of the builds uses fixed-point physics, so differences are not counted as failures."
+        strict=0
+    fi
+
+    echo "Comparing per-tick state hashes against $compare_dir ..."
+    report_a=$(mktemp)
+    report_b=$(mktemp)
+    $OPENOMF_BIN --replay-dir "$RUNDIR/rectests" > "$report_a" 2>/dev/null
+    (cd "$compare_dir" && $COMPARE_BIN --replay-dir "$RUNDIR/rectests" > "$report_b" 2>/dev/null)
+    for rec in "$RUNDIR"/rectests/*.REC "$RUNDIR"/rectests/*.rec; do
+        [ -e "$rec" ] || continue
+        name=$(basename "$rec")
+        echo -n "${name} :"
+        diverged=$(diff <(report_hashes "$report_a" "$name") <(report_hashes "$report_b" "$name") |
+            sed -n 's/^[<>] \([0-9]*\) .*/\1/p' | head -n 1)
+        if [ -z "$(report_hashes "$report_a" "$name")" ] || [ -z "$(report_hashes "$report_b" "$name")" ]; then
+            echo " NOT REPLAYED"
+            ((fail_count++))
+        elif [ -z "$diverged" ]; then
+            echo " MATCH"
+        else
+            echo " DIVERGED at tick ${diverged}"
+            if [ $strict -eq 1 ]; then
+                ((fail_count++))
+            fi
+        fi
+    done
+    rm -f "$report_a" "$report_b"
+fi
+
 # Exit with non-zero status if any test failed
 exit $fail_count
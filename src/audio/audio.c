@@ -3,6 +3,7 @@
 
 #include "audio/audio.h"
 #include "audio/backends/audio_backend.h"
+#include "formats/sounds.h"
 #include "resources/pathmanager.h"
 #include "resources/sounds_loader.h"
 #include "utils/c_array_util.h"
@@ -143,6 +144,7 @@ bool audio_init(const char *try_name, int sample_rate, bool mono, int resampler,
     if(!current_backend.setup_context(current_backend.ctx, sample_rate, mono, resampler, music_volume, sound_volume)) {
         goto exit_1;
     }
+    audio_prewarm_sounds();
     return true;
 
 exit_1:
@@ -174,12 +176,31 @@ int audio_play_sound(int id, float volume, float panning, float pitch) {
     }
 
     // Tell the backend to play it.
-    return current_backend.play_sound(current_backend.ctx, src_buf, src_len, volume, panning, pitch, 0);
+    return current_backend.play_sound(current_backend.ctx, id, src_buf, src_len, volume, panning, pitch, 0);
 }
 
 int audio_play_sound_buf(char *src_buf, int src_len, float volume, float panning, float pitch, int fade) {
-    // Tell the backend to play it.
-    return current_backend.play_sound(current_backend.ctx, src_buf, src_len, volume, panning, pitch, fade);
+    // Tell the backend to play it. Arbitrary buffers have no sound id, so they are not cached.
+    return current_backend.play_sound(current_backend.ctx, -1, src_buf, src_len, volume, panning, pitch, fade);
+}
+
+void audio_prewarm_sounds(void) {
+    char *src_buf;
+    int src_len;
+    int count = 0;
+    for(int id = 0; id < SD_SOUNDS_MAX; id++) {
+        if(!sounds_loader_get(id, &src_buf, &src_len)) {
+            return; // Sounds are not loaded yet
+        }
+        if(src_len == 0) {
+            continue;
+        }
+        if(!current_backend.prewarm_sound(current_backend.ctx, id, src_buf, src_len, PITCH_DEFAULT)) {
+            break;
+        }
+        count++;
+    }
+    log_debug("Prewarmed %d sounds", count);
 }
 
 void audio_fade_out(int playback_id, int ms) {
@@ -41,7 +41,7 @@ void audio_close(void);
 int audio_play_sound(int id, float volume, float panning, float pitch);
 
 /**
- * Plays sound with given parameters from a buffer.
+ * Plays sound with given parameters from a buffer. Unlike audio_play_sound, the converted buffer is not cached.
  *
  * @param src_buf Sound data buffer
  * @param src_len Sound data buffer length
@@ -53,6 +53,12 @@ int audio_play_sound(int id, float volume, float panning, float pitch);
  */
 int audio_play_sound_buf(char *src_buf, int src_len, float volume, float panning, float pitch, int fade);
 
+/**
+ * Converts the loaded sound samples to the output format at the default pitch ahead of time, until the
+ * backend's sound cache is full. Does nothing if the sounds have not been loaded yet. Called by audio_init.
+ */
+void audio_prewarm_sounds(void);
+
 /**
  * Fade out audio already playing
  *
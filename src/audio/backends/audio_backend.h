@@ -52,9 +52,10 @@ typedef bool (*setup_backend_context_fn)(void *ctx, unsigned sample_rate, bool m
                                          float music_volume, float sound_volume);
 typedef void (*close_backend_context_fn)(void *ctx);
 
-// Playback handling.
-typedef int (*play_sound_fn)(void *ctx, const char *buf, size_t len, float volume, float panning, float pitch,
-                             int fade);
+// Playback handling. Sound id is the sample id in the sounds file, or -1 if the buffer is not a whole sample.
+typedef int (*play_sound_fn)(void *ctx, int sound_id, const char *buf, size_t len, float volume, float panning,
+                             float pitch, int fade);
+typedef bool (*prewarm_sound_fn)(void *ctx, int sound_id, const char *buf, size_t len, float pitch);
 typedef void (*play_music_fn)(void *ctx, const char *file_name);
 typedef void (*stop_music_fn)(void *ctx);
 
@@ -78,6 +79,7 @@ struct audio_backend {
     close_backend_context_fn close_context;
 
     play_sound_fn play_sound;
+    prewarm_sound_fn prewarm_sound;
     play_music_fn play_music;
     stop_music_fn stop_music;
 
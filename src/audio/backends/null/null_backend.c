@@ -51,11 +51,15 @@ static void set_backend_sound_volume(void *userdata, float volume) {
 static void set_backend_music_volume(void *userdata, float volume) {
 }
 
-static int play_sound(void *userdata, const char *src_buf, size_t src_len, float volume, float panning, float pitch,
-                      int fade) {
+static int play_sound(void *userdata, int sound_id, const char *src_buf, size_t src_len, float volume, float panning,
+                      float pitch, int fade) {
     return -1;
 }
 
+static bool prewarm_sound(void *userdata, int sound_id, const char *src_buf, size_t src_len, float pitch) {
+    return false;
+}
+
 static void fade_out(int playback_id, int ms) {
 }
 
@@ -89,6 +93,7 @@ void null_audio_backend_set_callbacks(audio_backend *sdl_backend) {
     sdl_backend->close_context = close_backend_context;
     sdl_backend->play_music = play_music;
     sdl_backend->play_sound = play_sound;
+    sdl_backend->prewarm_sound = prewarm_sound;
     sdl_backend->stop_music = stop_music;
     sdl_backend->fade_out = fade_out;
 }
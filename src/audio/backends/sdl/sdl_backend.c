@@ -1,5 +1,6 @@
 #include "audio/backends/sdl/sdl_backend.h"
 #include "audio/backends/audio_backend.h"
+#include "audio/sound_cache.h"
 #include "utils/allocator.h"
 #include "utils/c_array_util.h"
 #include "utils/log.h"
@@ -13,6 +14,14 @@
 #include <xmp.h>
 
 #define CHANNEL_MAX 8
+#define SOUND_CACHE_BYTES (8 * 1024 * 1024)
+
+// Width of a pitch bucket in Hz. Every bucket a sound is played at is converted and cached separately. The
+// default of 1 keeps the exact source frequency. Builds that play sounds at many slightly different pitches
+// can define a larger step to share conversions between them; a sound then plays up to half a step off pitch.
+#ifndef SOUND_PITCH_STEP_HZ
+#define SOUND_PITCH_STEP_HZ 1
+#endif
 
 static const audio_sample_rate supported_sample_rates[] = {
     {11025, 0, "11025Hz"},
@@ -37,6 +46,8 @@ typedef struct sdl_audio_context {
     float music_volume;
     xmp_context xmp_context;
     Mix_Chunk channel_chunks[CHANNEL_MAX];
+    sound_cache_entry *channel_sounds[CHANNEL_MAX]; // Cached sample played on the channel, if any
+    sound_cache sounds;
 } sdl_audio_context;
 
 static bool is_available(void) {
@@ -97,28 +108,38 @@ static const char *get_sdl_audio_format_string(SDL_AudioFormat format) {
 
 static inline void free_chunk(sdl_audio_context *ctx, int i) {
     if(ctx->channel_chunks[i].allocated) {
-        SDL_free(ctx->channel_chunks[i].abuf);
+        omf_free(ctx->channel_chunks[i].abuf);
         ctx->channel_chunks[i].allocated = 0;
     }
+    if(ctx->channel_sounds[i] != NULL) {
+        sound_cache_release(&ctx->sounds, ctx->channel_sounds[i]);
+        ctx->channel_sounds[i] = NULL;
+    }
+}
+
+static int pitch_bucket(float pitch) {
+    return (int)(8000 * pitch / SOUND_PITCH_STEP_HZ + 0.5f) * SOUND_PITCH_STEP_HZ;
 }
 
-static bool audio_get_chunk(sdl_audio_context *ctx, Mix_Chunk *chunk, const char *src_buf, size_t src_len, float volume,
-                            float pitch) {
+static void get_cache_format(sdl_audio_context *ctx, sound_cache_format *format) {
+    format->sample_rate = ctx->sample_rate;
+    format->format = ctx->format;
+    format->channels = ctx->channels;
+}
+
+// Converts an 8 bit mono sample to the output format. The returned buffer is allocated with omf_malloc.
+static char *convert_sample(sdl_audio_context *ctx, const char *src_buf, size_t src_len, int src_freq, size_t *len) {
     Uint8 *dst_buf;
     SDL_AudioCVT cvt;
 
     // Converter for sound samples.
-    int src_freq = 8000 * pitch;
     if(SDL_BuildAudioCVT(&cvt, AUDIO_U8, 1, src_freq, ctx->format, ctx->channels, ctx->sample_rate) < 0) {
         log_error("Unable to build audio converter: %s", SDL_GetError());
         goto exit_0;
     }
 
     // Create a buffer that can hold the source data and final converted data.
-    if((dst_buf = SDL_malloc(src_len * cvt.len_mult + 1)) == NULL) {
-        log_error("Unable to allocate memory for sound buffer");
-        goto exit_0;
-    }
+    dst_buf = omf_malloc(src_len * cvt.len_mult + 1);
     SDL_memcpy((void *)dst_buf, (void *)src_buf, src_len);
 
     // Convert!
@@ -129,16 +150,54 @@ static bool audio_get_chunk(sdl_audio_context *ctx, Mix_Chunk *chunk, const char
         goto exit_1;
     }
 
-    chunk->volume = volume * MIX_MAX_VOLUME;
-    chunk->abuf = dst_buf;
-    chunk->alen = cvt.len_cvt;
-    chunk->allocated = 1;
-    return true;
+    // Drop the conversion headroom.
+    *len = cvt.len_cvt;
+    return omf_realloc(dst_buf, cvt.len_cvt + 1);
 
 exit_1:
-    SDL_free(dst_buf);
+    omf_free(dst_buf);
 exit_0:
-    return false;
+    return NULL;
+}
+
+static bool audio_get_chunk(sdl_audio_context *ctx, int channel, int sound_id, const char *src_buf, size_t src_len,
+                            float volume, float pitch) {
+    Mix_Chunk *chunk = &ctx->channel_chunks[channel];
+    sound_cache_format format;
+    sound_cache_entry *entry = NULL;
+    int src_freq = pitch_bucket(pitch);
+    size_t len;
+    chunk->volume = volume * MIX_MAX_VOLUME;
+    get_cache_format(ctx, &format);
+
+    // Samples that have been played before at this pitch are already converted.
+    if(sound_id >= 0 && (entry = sound_cache_acquire(&ctx->sounds, sound_id, src_freq, &format)) != NULL) {
+        chunk->abuf = (Uint8 *)entry->buf;
+        chunk->alen = entry->len;
+        chunk->allocated = 0;
+        ctx->channel_sounds[channel] = entry;
+        return true;
+    }
+
+    char *buf = convert_sample(ctx, src_buf, src_len, src_freq, &len);
+    if(buf == NULL) {
+        return false;
+    }
+
+    // Hand the buffer over to the cache. Partial samples are not cached, and if the cache has no room,
+    // the channel owns the buffer until it is reused.
+    chunk->abuf = (Uint8 *)buf;
+    chunk->alen = len;
+    if(sound_id >= 0) {
+        entry = sound_cache_add(&ctx->sounds, sound_id, src_freq, &format, buf, len);
+    }
+    if(entry != NULL) {
+        chunk->allocated = 0;
+        ctx->channel_sounds[channel] = entry;
+    } else {
+        chunk->allocated = 1;
+    }
+    return true;
 }
 
 static bool audio_load_module(sdl_audio_context *ctx, const char *file) {
@@ -218,8 +277,8 @@ static void set_backend_music_volume(void *userdata, float volume) {
     xmp_set_player(ctx->xmp_context, XMP_PLAYER_VOLUME, ctx->music_volume * 100);
 }
 
-static int play_sound(void *userdata, const char *src_buf, size_t src_len, float volume, float panning, float pitch,
-                      int fade) {
+static int play_sound(void *userdata, int sound_id, const char *src_buf, size_t src_len, float volume, float panning,
+                      float pitch, int fade) {
     assert(userdata);
     sdl_audio_context *ctx = userdata;
 
@@ -236,7 +295,7 @@ static int play_sound(void *userdata, const char *src_buf, size_t src_len, float
         return -1;
     }
     free_chunk(ctx, channel); // Make sure old chunk is deallocated, if one exists.
-    if(!audio_get_chunk(ctx, &ctx->channel_chunks[channel], src_buf, src_len, volume, pitch)) {
+    if(!audio_get_chunk(ctx, channel, sound_id, src_buf, src_len, volume, pitch)) {
         log_error("Unable to play sound: Failed to load chunk");
         return -1;
     }
@@ -249,6 +308,30 @@ static int play_sound(void *userdata, const char *src_buf, size_t src_len, float
     return channel;
 }
 
+static bool prewarm_sound(void *userdata, int sound_id, const char *src_buf, size_t src_len, float pitch) {
+    assert(userdata);
+    sdl_audio_context *ctx = userdata;
+    sound_cache_format format;
+    int src_freq = pitch_bucket(clampf(pitch, PITCH_MIN, PITCH_MAX));
+    size_t len;
+    get_cache_format(ctx, &format);
+
+    if(sound_cache_contains(&ctx->sounds, sound_id, src_freq, &format)) {
+        return true;
+    }
+    char *buf = convert_sample(ctx, src_buf, src_len, src_freq, &len);
+    if(buf == NULL) {
+        return false;
+    }
+    // Prewarming never evicts; whatever was cached first stays.
+    if(!sound_cache_has_room(&ctx->sounds, len)) {
+        omf_free(buf);
+        return false;
+    }
+    sound_cache_release(&ctx->sounds, sound_cache_add(&ctx->sounds, sound_id, src_freq, &format, buf, len));
+    return true;
+}
+
 static void stop_music(void *ctx) {
     assert(ctx);
     Mix_HaltMusic();
@@ -276,6 +359,7 @@ static bool setup_backend_context(void *userdata, unsigned sample_rate, bool mon
     assert(userdata);
     sdl_audio_context *ctx = userdata;
     memset(ctx, 0, sizeof(sdl_audio_context));
+    sound_cache_create(&ctx->sounds, SOUND_CACHE_BYTES);
 
     if(SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
         log_error("Unable to initialize audio subsystem: %s", SDL_GetError());
@@ -324,6 +408,7 @@ error_2:
 error_1:
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
 error_0:
+    sound_cache_free(&ctx->sounds);
     return false;
 }
 
@@ -338,6 +423,10 @@ static void close_backend_context(void *userdata) {
     for(int i = 0; i < CHANNEL_MAX; i++) {
         free_chunk(ctx, i);
     }
+    unsigned int plays = ctx->sounds.hits + ctx->sounds.misses;
+    log_info("Sound cache: %u hits out of %u plays (%.1f%%), %u evictions, %zu bytes", ctx->sounds.hits, plays,
+             plays ? ctx->sounds.hits * 100.0f / plays : 0.0f, ctx->sounds.evictions, ctx->sounds.bytes);
+    sound_cache_free(&ctx->sounds);
     if(ctx->xmp_context) {
         xmp_free_context(ctx->xmp_context);
         ctx->xmp_context = NULL;
@@ -360,6 +449,7 @@ void sdl_audio_backend_set_callbacks(audio_backend *sdl_backend) {
     sdl_backend->close_context = close_backend_context;
     sdl_backend->play_music = play_music;
     sdl_backend->play_sound = play_sound;
+    sdl_backend->prewarm_sound = prewarm_sound;
     sdl_backend->stop_music = stop_music;
     sdl_backend->fade_out = fade_out;
 }
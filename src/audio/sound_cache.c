@@ -0,0 +1,141 @@
+#include "audio/sound_cache.h"
+#include "utils/allocator.h"
+#include <string.h>
+
+typedef struct sound_cache_key {
+    int32_t sound_id;
+    int32_t src_freq;
+    sound_cache_format format;
+} sound_cache_key;
+
+static void make_key(sound_cache_key *key, int sound_id, int src_freq, const sound_cache_format *format) {
+    memset(key, 0, sizeof(sound_cache_key));
+    key->sound_id = sound_id;
+    key->src_freq = src_freq;
+    key->format.sample_rate = format->sample_rate;
+    key->format.format = format->format;
+    key->format.channels = format->channels;
+}
+
+static void remove_entry(sound_cache *cache, sound_cache_entry *entry) {
+    sound_cache_key key;
+    make_key(&key, entry->sound_id, entry->src_freq, &entry->format);
+    hashmap_del(&cache->index, &key, sizeof(sound_cache_key));
+    cache->bytes -= entry->len;
+    cache->count--;
+    omf_free(entry->buf);
+    memset(entry, 0, sizeof(sound_cache_entry));
+}
+
+// Evicts the least recently used entry that is not playing. Returns false if every entry is in use.
+static bool evict_one(sound_cache *cache) {
+    sound_cache_entry *oldest = NULL;
+    for(unsigned int i = 0; i < SOUND_CACHE_ENTRIES; i++) {
+        sound_cache_entry *entry = &cache->entries[i];
+        if(entry->buf == NULL || entry->users > 0) {
+            continue;
+        }
+        if(oldest == NULL || entry->last_use < oldest->last_use) {
+            oldest = entry;
+        }
+    }
+    if(oldest == NULL) {
+        return false;
+    }
+    remove_entry(cache, oldest);
+    cache->evictions++;
+    return true;
+}
+
+void sound_cache_create(sound_cache *cache, size_t max_bytes) {
+    memset(cache, 0, sizeof(sound_cache));
+    hashmap_create(&cache->index);
+    cache->max_bytes = max_bytes;
+}
+
+void sound_cache_free(sound_cache *cache) {
+    for(unsigned int i = 0; i < SOUND_CACHE_ENTRIES; i++) {
+        omf_free(cache->entries[i].buf);
+    }
+    hashmap_free(&cache->index);
+    cache->count = 0;
+    cache->bytes = 0;
+}
+
+static sound_cache_entry *find_entry(sound_cache *cache, int sound_id, int src_freq, const sound_cache_format *format) {
+    sound_cache_key key;
+    unsigned int *index;
+    make_key(&key, sound_id, src_freq, format);
+    if(hashmap_get(&cache->index, &key, sizeof(sound_cache_key), (void **)&index, NULL) != 0) {
+        return NULL;
+    }
+    return &cache->entries[*index];
+}
+
+sound_cache_entry *sound_cache_acquire(sound_cache *cache, int sound_id, int src_freq,
+                                       const sound_cache_format *format) {
+    sound_cache_entry *entry = find_entry(cache, sound_id, src_freq, format);
+    if(entry == NULL) {
+        cache->misses++;
+        return NULL;
+    }
+    entry->last_use = ++cache->clock;
+    entry->users++;
+    cache->hits++;
+    return entry;
+}
+
+bool sound_cache_contains(sound_cache *cache, int sound_id, int src_freq, const sound_cache_format *format) {
+    return find_entry(cache, sound_id, src_freq, format) != NULL;
+}
+
+sound_cache_entry *sound_cache_add(sound_cache *cache, int sound_id, int src_freq, const sound_cache_format *format,
+                                   char *buf, size_t len) {
+    if(len > cache->max_bytes) {
+        return NULL;
+    }
+    while(cache->count >= SOUND_CACHE_ENTRIES || cache->bytes + len > cache->max_bytes) {
+        if(!evict_one(cache)) {
+            return NULL;
+        }
+    }
+
+    unsigned int index = 0;
+    while(cache->entries[index].buf != NULL) {
+        index++;
+    }
+    sound_cache_entry *entry = &cache->entries[index];
+    entry->sound_id = sound_id;
+    entry->src_freq = src_freq;
+    entry->format = *format;
+    entry->buf = buf;
+    entry->len = len;
+    entry->last_use = ++cache->clock;
+    entry->users = 1;
+    cache->bytes += len;
+    cache->count++;
+
+    sound_cache_key key;
+    make_key(&key, sound_id, src_freq, format);
+    hashmap_put(&cache->index, &key, sizeof(sound_cache_key), &index, sizeof(unsigned int));
+    return entry;
+}
+
+bool sound_cache_has_room(const sound_cache *cache, size_t len) {
+    return cache->count < SOUND_CACHE_ENTRIES && cache->bytes + len <= cache->max_bytes;
+}
+
+void sound_cache_release(sound_cache *cache, sound_cache_entry *entry) {
+    if(entry->users > 0) {
+        entry->users--;
+    }
+}
+
+void sound_cache_flush(sound_cache *cache) {
+    for(unsigned int i = 0; i < SOUND_CACHE_ENTRIES; i++) {
+        sound_cache_entry *entry = &cache->entries[i];
+        if(entry->buf != NULL && entry->users == 0) {
+            remove_entry(cache, entry);
+        }
+    }
+}
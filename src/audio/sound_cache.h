@@ -0,0 +1,89 @@
+#ifndef SOUND_CACHE_H
+#define SOUND_CACHE_H
+
+#include "utils/hashmap.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SOUND_CACHE_ENTRIES 256
+
+/**
+ * Output format of the audio device that a sample was converted to.
+ */
+typedef struct sound_cache_format {
+    int32_t sample_rate;
+    uint16_t format;
+    uint16_t channels;
+} sound_cache_format;
+
+/**
+ * Sound sample converted to the output format of the audio device.
+ *
+ * Entries are keyed by the sound id, the source frequency the sample was played at (its pitch bucket)
+ * and the output format. A sample converted for one device configuration is never handed out for another,
+ * so the cache doesn't have to be flushed when the device is reopened.
+ */
+typedef struct sound_cache_entry {
+    int32_t sound_id;
+    int32_t src_freq;
+    sound_cache_format format;
+    char *buf;
+    size_t len;
+    unsigned int last_use;
+    unsigned int users; // Number of playbacks using this buffer; entries in use are never evicted.
+} sound_cache_entry;
+
+typedef struct sound_cache {
+    hashmap index; // (sound_id, src_freq, format) -> entry index
+    sound_cache_entry entries[SOUND_CACHE_ENTRIES];
+    unsigned int count;
+    size_t bytes;
+    size_t max_bytes;
+    unsigned int clock;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+} sound_cache;
+
+void sound_cache_create(sound_cache *cache, size_t max_bytes);
+void sound_cache_free(sound_cache *cache);
+
+/**
+ * Finds a converted sample and marks it as used. Does not allocate.
+ *
+ * @return Cache entry, or NULL if the sample has not been converted yet.
+ */
+sound_cache_entry *sound_cache_acquire(sound_cache *cache, int sound_id, int src_freq,
+                                       const sound_cache_format *format);
+
+/**
+ * Tells whether a converted sample is cached, without marking it as used or counting a hit or miss.
+ */
+bool sound_cache_contains(sound_cache *cache, int sound_id, int src_freq, const sound_cache_format *format);
+
+/**
+ * Adds a converted sample to the cache and marks it as used, evicting least recently used samples that
+ * are not in use to make room. On success, the cache takes ownership of buf (allocated with omf_malloc).
+ *
+ * @return Cache entry, or NULL if there was no room. In that case the caller keeps ownership of buf.
+ */
+sound_cache_entry *sound_cache_add(sound_cache *cache, int sound_id, int src_freq, const sound_cache_format *format,
+                                   char *buf, size_t len);
+
+/**
+ * Tells whether a converted sample of len bytes would fit without evicting anything.
+ */
+bool sound_cache_has_room(const sound_cache *cache, size_t len);
+
+/**
+ * Marks a playback of the entry as finished. The entry may be evicted after this.
+ */
+void sound_cache_release(sound_cache *cache, sound_cache_entry *entry);
+
+/**
+ * Frees all converted samples that are not in use.
+ */
+void sound_cache_flush(sound_cache *cache);
+
+#endif // SOUND_CACHE_H
@@ -4,7 +4,9 @@
 #include "game/scenes/arena.h"
 #include "game/scenes/mechlab.h"
 #include "resources/ids.h"
+#include "resources/resource_cache.h"
 #include "utils/allocator.h"
+#include "video/video.h"
 #include <stdio.h>
 
 // utils
@@ -281,6 +283,32 @@ int console_cmd_rank(game_state *gs, int argc, char **argv) {
     return 1;
 }
 
+int console_cmd_cache(game_state *gs, int argc, char **argv) {
+    resource_cache_stats stats;
+    char buf[sizeof con->input];
+    resource_cache_get_stats(&stats);
+    snprintf(buf, sizeof buf, "%u hits, %u misses, %u evictions", stats.hits, stats.misses, stats.evictions);
+    console_output_addline(buf);
+    snprintf(buf, sizeof buf, "%u files, %zu KiB, %u prefetched", stats.entries, stats.bytes / 1024,
+             stats.prefetches);
+    console_output_addline(buf);
+    return 0;
+}
+
+int console_cmd_atlas(game_state *gs, int argc, char **argv) {
+    unsigned int items;
+    float occupancy, fragmentation;
+    char buf[sizeof con->input];
+    if(!video_get_atlas_stats(&items, &occupancy, &fragmentation)) {
+        console_output_addline("No texture atlas in use");
+        return 1;
+    }
+    snprintf(buf, sizeof buf, "%u surfaces, %.1f%% occupied, %.1f%% fragmented", items, occupancy * 100.0f,
+             fragmentation * 100.0f);
+    console_output_addline(buf);
+    return 0;
+}
+
 void console_init_cmd(void) {
     // Add console commands
     console_add_cmd("h", &console_cmd_history, "show command history");
@@ -302,4 +330,6 @@ void console_init_cmd(void) {
     console_add_cmd("warp", &console_toggle_warp, "Toggle warp speed");
     console_add_cmd("money", &console_cmd_money, "Set tournament mode money");
     console_add_cmd("rank", &console_cmd_rank, "Set tournament mode rank");
+    console_add_cmd("cache", &console_cmd_cache, "Show resource cache statistics");
+    console_add_cmd("atlas", &console_cmd_atlas, "Show texture atlas statistics");
 }
@@ -8,8 +8,36 @@ typedef struct {
     controller *source;
 } hook_function;
 
+static void event_pool_init(ctrl_event_pool *pool) {
+    pool->free = NULL;
+    pool->overflows = 0;
+    for(int i = CTRL_EVENT_POOL_SIZE - 1; i >= 0; i--) {
+        pool->events[i].next = pool->free;
+        pool->free = &pool->events[i];
+    }
+}
+
+static ctrl_event *event_alloc(controller *ctrl, int type) {
+    ctrl_event_pool *pool = &ctrl->pool;
+    ctrl_event *ev = pool->free;
+    if(ev != NULL) {
+        pool->free = ev->next;
+        ev->pool = pool;
+    } else {
+        ev = omf_calloc(1, sizeof(ctrl_event));
+        ev->pool = NULL;
+        pool->overflows++;
+    }
+    ev->type = type;
+    ev->event_data.action = 0;
+    ev->next = NULL;
+    ev->last = ev;
+    return ev;
+}
+
 void controller_init(controller *ctrl, game_state *gs) {
     list_create(&ctrl->hooks);
+    event_pool_init(&ctrl->pool);
     ctrl->gs = gs;
     ctrl->extra_events = NULL;
     ctrl->har_obj_id = 0;
@@ -44,31 +72,33 @@ void controller_free_chain(ctrl_event *ev) {
     ctrl_event *tmp;
     while(now != NULL) {
         tmp = now->next;
-        omf_free(now);
+        if(now->pool != NULL) {
+            now->next = now->pool->free;
+            now->pool->free = now;
+        } else {
+            omf_free(now);
+        }
         now = tmp;
     }
 }
 
 void controller_free(controller *ctrl) {
+    controller_free_chain(ctrl->extra_events);
+    ctrl->extra_events = NULL;
     controller_clear_hooks(ctrl);
     list_free(&ctrl->hooks);
     ctrl->free_fun(ctrl);
 }
 
-static inline void ctrl_action_push(ctrl_event **ev, int action) {
-    ctrl_event *new = omf_calloc(1, sizeof(ctrl_event));
-
-    new->type = EVENT_TYPE_ACTION;
+static inline void ctrl_action_push(controller *ctrl, ctrl_event **ev, int action) {
+    ctrl_event *new = event_alloc(ctrl, EVENT_TYPE_ACTION);
     new->event_data.action = action;
 
     if(*ev == NULL) {
         *ev = new;
     } else {
-        ctrl_event *i = *ev;
-        while(i->next) {
-            i = i->next;
-        }
-        i->next = new;
+        (*ev)->last->next = new;
+        (*ev)->last = new;
     }
 }
 
@@ -100,15 +130,13 @@ void controller_cmd(controller *ctrl, int action, ctrl_event **ev) {
         (hook.fp)(hook.source, action);
     }
 
-    ctrl_action_push(ev, action);
+    ctrl_action_push(ctrl, ev, action);
 }
 
 void controller_close(controller *ctrl, ctrl_event **ev) {
     // a close event obsoletes all previous events
     controller_free_chain(*ev);
-    *ev = omf_calloc(1, sizeof(ctrl_event));
-    (*ev)->type = EVENT_TYPE_CLOSE;
-    (*ev)->next = NULL;
+    *ev = event_alloc(ctrl, EVENT_TYPE_CLOSE);
 }
 
 int controller_tick(controller *ctrl, uint32_t ticks, ctrl_event **ev) {
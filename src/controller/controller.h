@@ -40,7 +40,10 @@ enum
     EVENT_TYPE_CLOSE
 };
 
+#define CTRL_EVENT_POOL_SIZE 64
+
 typedef struct ctrl_event_t ctrl_event;
+typedef struct ctrl_event_pool_t ctrl_event_pool;
 
 struct ctrl_event_t {
     int type;
@@ -49,6 +52,21 @@ struct ctrl_event_t {
         serial *ser;
     } event_data;
     ctrl_event *next;
+    ctrl_event *last;      // Last event of the chain. Only kept up to date in the first event.
+    ctrl_event_pool *pool; // Pool the event goes back to, or NULL if it was allocated from the heap.
+};
+
+/**
+ * Events handed out by a controller. Events are recycled through a free list, so that polling
+ * does not touch the heap once the game is running. If the pool runs dry, events are allocated
+ * from the heap instead, and counted in overflows.
+ *
+ * Event chains must be freed with controller_free_chain() before their controller is freed.
+ */
+struct ctrl_event_pool_t {
+    ctrl_event events[CTRL_EVENT_POOL_SIZE];
+    ctrl_event *free;
+    unsigned int overflows;
 };
 
 typedef struct controller_t controller;
@@ -72,6 +90,7 @@ struct controller_t {
     int repeat_tick;
     int current;
     int last;
+    ctrl_event_pool pool;
 };
 
 void controller_init(controller *ctrl, game_state *gs);
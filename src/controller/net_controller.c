@@ -5,6 +5,7 @@
 #include <time.h>
 
 #include "controller/net_controller.h"
+#include "game/game_state.h"
 #include "game/game_state_type.h"
 #include "game/protos/scene.h"
 #include "game/scenes/arena.h"
@@ -16,6 +17,14 @@
 #include "utils/log.h"
 #include "utils/miscmath.h"
 
+// Number of agreed on game states kept around for rollback
+#define NET_SNAPSHOT_COUNT 8
+
+typedef struct {
+    uint32_t tick; // int_tick of the game state in the snapshot
+    serial ser;
+} net_snapshot;
+
 typedef struct {
     ENetHost *host;
     ENetPeer *peer;
@@ -49,7 +58,12 @@ typedef struct {
     int8_t last_direction;
     SDL_RWops *trace_file;
     game_state *gs_bak;
+    net_snapshot snapshots[NET_SNAPSHOT_COUNT];
+    int snapshot_head;
+    int snapshot_count;
+    serial replay_ser;
     int winner;
+    net_controller_stats stats;
 } wtf;
 
 typedef struct {
@@ -292,6 +306,39 @@ void send_events(wtf *data) {
     enet_host_flush(host);
 }
 
+// store the game state in the next free snapshot slot, overwriting the oldest one
+static void snapshot_save(wtf *data, game_state *gs) {
+    data->snapshot_head = (data->snapshot_head + 1) % NET_SNAPSHOT_COUNT;
+    net_snapshot *snap = &data->snapshots[data->snapshot_head];
+    serial_reset(&snap->ser);
+    game_state_serialize(gs, &snap->ser);
+    snap->tick = gs->int_tick;
+    data->snapshot_count = min2(data->snapshot_count + 1, NET_SNAPSHOT_COUNT);
+}
+
+// find the newest snapshot that is not past the given tick
+static net_snapshot *snapshot_find(wtf *data, uint32_t tick) {
+    for(int i = 0; i < data->snapshot_count; i++) {
+        net_snapshot *snap = &data->snapshots[(data->snapshot_head - i + NET_SNAPSHOT_COUNT) % NET_SNAPSHOT_COUNT];
+        if(snap->tick <= tick) {
+            return snap;
+        }
+    }
+    return NULL;
+}
+
+// rewind the game state in place to the newest snapshot, returns false if there is none
+static bool snapshot_restore(wtf *data, game_state *gs) {
+    net_snapshot *snap = snapshot_find(data, UINT32_MAX);
+    if(snap == NULL) {
+        log_error("No game state snapshot to rewind to");
+        return false;
+    }
+    serial_read_reset(&snap->ser);
+    game_state_unserialize(gs, &snap->ser);
+    return true;
+}
+
 // replay the game state, using the input logs from both sides
 int rewind_and_replay(wtf *data, game_state *gs_current) {
     // first, find the last frame we have input from the other side
@@ -300,13 +347,12 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
     list *transcript = &data->transcript;
     list_iter_begin(transcript, &it);
     tick_events *ev = NULL;
+    // gs_bak always holds the state of the newest snapshot when we get here
     game_state *gs = data->gs_bak;
-    game_state *gs_new = NULL;
+    uint32_t start_tick = gs->int_tick;
+    bool saved = false;
     char buf[512];
 
-    game_state *gs_old = omf_calloc(1, sizeof(game_state));
-    game_state_clone(gs, gs_old);
-
     log_debug("current game ticks is %" PRIu32 ", stored game ticks are %" PRIu32 ", last tick is %" PRIu32,
               gs_current->int_tick - data->local_proposal, gs->int_tick - data->local_proposal,
               data->last_tick - data->local_proposal);
@@ -336,17 +382,14 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
 
         // The next tick is past when we have agreement, so we need to save the last known good game state
         // for future replays
-        if(gs_new == NULL && ev->tick > last_agreed && gs->int_tick - data->local_proposal <= last_agreed &&
-           gs->int_tick > gs_old->int_tick) {
+        if(!saved && ev->tick > last_agreed && gs->int_tick - data->local_proposal <= last_agreed &&
+           gs->int_tick > start_tick) {
             log_debug("saving game state at last agreed on tick %d with hash %" PRIu32,
                       gs->int_tick - data->local_proposal, arena_state_hash(gs));
             // save off the game state at the point we last agreed
             // on the state of the game
-            gs_new = omf_calloc(1, sizeof(game_state));
-            game_state_clone(gs, gs_new);
-            data->gs_bak = gs_new;
-            game_state_clone_free(gs_old);
-            omf_free(gs_old);
+            snapshot_save(data, gs);
+            saved = true;
         }
 
         // these are 'dynamic ticks'
@@ -426,7 +469,7 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
                         move.action = SD_ACT_NONE;
                     }
 
-                    sd_rec_insert_action(gs->rec, gs->rec->move_count, &move);
+                    sd_rec_append_action(gs->rec, &move);
                     k++;
                 }
             }
@@ -470,6 +513,11 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
 
             log_debug("arena hash mismatch at %d (%d) -- got %" PRIu32 " expected %" PRIu32 "!",
                       gs->int_tick - data->local_proposal, data->peer_last_hash_tick, data->peer_last_hash, arena_hash);
+            data->stats.desynced = true;
+            data->stats.hash_tick = data->peer_last_hash_tick;
+            data->stats.hash = arena_hash;
+            data->stats.peer_hash = data->peer_last_hash;
+            snapshot_restore(data, gs);
             for(int i = 0; i < game_state_num_players(gs); i++) {
                 game_player *gp = game_state_get_player(gs, i);
                 controller *c = game_player_get_ctrl(gp);
@@ -480,6 +528,12 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
             return 1;
         } else if(gs->int_tick - data->local_proposal == data->peer_last_hash_tick) {
             log_debug("arena hashes agree!");
+            if(data->stats.hash_tick != data->peer_last_hash_tick || data->stats.hashes_checked == 0) {
+                data->stats.hash_tick = data->peer_last_hash_tick;
+                data->stats.hash = arena_hash;
+                data->stats.peer_hash = data->peer_last_hash;
+                data->stats.hashes_checked++;
+            }
         }
 
         if(ev->tick <= last_agreed && data->last_hash_tick < gs->int_tick - data->local_proposal) {
@@ -497,29 +551,38 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
     for(int dynamic_wait = (int)ticks; dynamic_wait > 0; dynamic_wait--) {
         // Tick scene
         game_state_dynamic_tick(gs, true);
+        tick_count++;
     }
 
     uint64_t replay_end = SDL_GetTicks64();
-
-    if(gs_new == NULL) {
-        // we weren't able to make a new state backup, so restore the old one
-        data->gs_bak = gs_old;
-    }
+    data->stats.rollbacks++;
+    data->stats.replayed_ticks += tick_count;
+    data->stats.max_rollback = umax2(data->stats.max_rollback, tick_count);
+    data->stats.replay_ms += replay_end - replay_start;
 
     log_debug("advanced game state to %" PRIu32 ", expected %" PRIu32, gs->int_tick - data->local_proposal,
               data->last_tick - data->local_proposal);
 
     log_debug("replayed %d ticks in %d milliseconds", tick_count, replay_end - replay_start);
 
-    // replace the game state with the replayed one
-    gs->new_state = NULL;
-    if(gs_current->new_state) {
-        game_state_clone_free(gs_current->new_state);
-        omf_free(gs_current->new_state);
+    // bring the current game state up to date with the replayed one
+    game_state_merge_sounds(gs_current, gs);
+    serial_reset(&data->replay_ser);
+    game_state_serialize(gs, &data->replay_ser);
+    game_state_unserialize(gs_current, &data->replay_ser);
+
+    // and rewind the replayed state back to the last agreed on tick for the next replay
+    bool rewound = snapshot_restore(data, gs);
+
+    for(int i = 0; i < game_state_num_players(gs); i++) {
+        game_player *gp = game_state_get_player(gs, i);
+        controller *c = game_player_get_ctrl(gp);
+        if(c) {
+            c->gs = gs_current;
+        }
     }
-    gs_current->new_state = gs;
-    data->gs_bak->new_state = NULL;
-    return 0;
+    // without a snapshot the next replay would start from the wrong tick, so give up on the match
+    return rewound ? 0 : 1;
 }
 
 ENetPeer *net_controller_get_lobby_connection(controller *ctrl) {
@@ -548,6 +611,14 @@ int net_controller_get_winner(controller *ctrl) {
     return 1;
 }
 
+void net_controller_get_stats(controller *ctrl, net_controller_stats *stats) {
+    wtf *data = ctrl->data;
+    *stats = data->stats;
+    stats->avg_rtt = avg_rtt(data->rttbuf, data->rttfilled ? 100 : max2(data->rttpos, 1));
+    stats->frame_advantage = data->frame_advantage;
+    stats->disconnected = data->disconnected;
+}
+
 bool net_controller_ready(controller *ctrl) {
     wtf *data = ctrl->data;
     return data->synchronized;
@@ -618,6 +689,10 @@ done:
         game_state_clone_free(data->gs_bak);
         omf_free(data->gs_bak);
     }
+    for(int i = 0; i < NET_SNAPSHOT_COUNT; i++) {
+        serial_free(&data->snapshots[i].ser);
+    }
+    serial_free(&data->replay_ser);
     if(ctrl->data) {
         omf_free(ctrl->data);
     }
@@ -652,23 +727,31 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
         log_debug("missed synchronize tick %" PRIu32 " -- @ %" PRIu32, data->local_proposal, ticks);
     }
 
-    if(data->gs_bak == NULL && data->disconnected == 0 && scene_is_arena(game_state_get_scene(ctrl->gs)) &&
-       (ticks - data->local_proposal) % 7 == 0 &&
+    // Both peers take the first snapshot on the same tick, so wait for the start tick to be agreed on first.
+    if(data->gs_bak == NULL && data->disconnected == 0 && data->synchronized &&
+       scene_is_arena(game_state_get_scene(ctrl->gs)) && (ticks - data->local_proposal) % 7 == 0 &&
        game_state_find_object(ctrl->gs, game_player_get_har_obj_id(game_state_get_player(ctrl->gs, 1)))) {
         arena_reset(ctrl->gs->sc);
+        // Both states get rolled back, keep what they delete so that rollbacks need not allocate
+        game_state_set_keep_deleted(ctrl->gs, true);
         data->gs_bak = omf_calloc(1, sizeof(game_state));
         game_state_clone(ctrl->gs, data->gs_bak);
         // bypass counter that tries to suppress input from previous scene
         data->gs_bak->sc->static_ticks_since_start = 25;
-        log_debug("cloned game state at arena tick %d hash %" PRIu32, data->gs_bak->int_tick - data->local_proposal,
+        log_debug("cloned game state at arena tick %d (%zu bytes of structs copied) hash %" PRIu32,
+                  data->gs_bak->int_tick - data->local_proposal, data->gs_bak->clone_struct_bytes,
                   arena_state_hash(data->gs_bak));
         data->local_proposal = ticks; // reset the tick offset to the start of the match
+        data->stats.start_tick = ticks;
         data->last_hash_tick = data->gs_bak->int_tick - data->local_proposal;
         data->last_hash = arena_state_hash(data->gs_bak);
+        data->snapshot_count = 0;
+        snapshot_save(data, data->gs_bak);
     } else if(data->gs_bak != NULL && !scene_is_arena(game_state_get_scene(ctrl->gs))) {
         // changed scene and no longer need a game state backup, release it
         game_state_clone_free(data->gs_bak);
         omf_free(data->gs_bak);
+        game_state_set_keep_deleted(ctrl->gs, false);
         data->last_action = ACT_NONE;
         data->last_direction = OBJECT_FACE_NONE;
         data->synchronized = false;
@@ -889,6 +972,8 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
                 if(data->gs_bak) {
                     game_state_clone_free(data->gs_bak);
                     omf_free(data->gs_bak);
+                    data->gs_bak = NULL;
+                    game_state_set_keep_deleted(ctrl->gs, false);
                 }
                 if(data->lobby) {
                     data->winner = arena_is_over(ctrl->gs->sc);
@@ -1033,6 +1118,10 @@ void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, ENe
         }
     }
     list_create(&data->transcript);
+    for(int i = 0; i < NET_SNAPSHOT_COUNT; i++) {
+        serial_create(&data->snapshots[i].ser);
+    }
+    serial_create(&data->replay_ser);
     ctrl->data = data;
     ctrl->type = CTRL_TYPE_NETWORK;
     ctrl->tick_fun = &net_controller_tick;
@@ -5,6 +5,26 @@
 #include <SDL.h>
 #include <enet/enet.h>
 
+/**
+ * Rollback and synchronization statistics of a network controller, for measuring the netcode. Unlike the rest of
+ * the controller state, these are kept when the match ends.
+ */
+typedef struct net_controller_stats {
+    uint32_t start_tick;         // Game tick the peers agreed to start the arena at, or 0 before that
+    unsigned int rollbacks;      // Number of rewinds to the last agreed on state
+    unsigned int replayed_ticks; // Dynamic ticks run again by all rollbacks
+    unsigned int max_rollback;   // Most dynamic ticks run again by a single rollback
+    uint64_t replay_ms;          // Time spent in rollbacks
+    int avg_rtt;                 // Round trip time in ticks, without outliers
+    int frame_advantage;         // How many ticks this side is ahead of the peer
+    uint32_t hash_tick;          // Last tick checked against a peer hash, relative to start_tick
+    uint32_t hash;               // Arena state hash at hash_tick
+    uint32_t peer_hash;          // Peer arena state hash at hash_tick
+    unsigned int hashes_checked; // Number of peer hashes that matched
+    bool desynced;               // A peer hash did not match, and the game was stopped
+    bool disconnected;
+} net_controller_stats;
+
 void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, ENetPeer *lobby, int id);
 void net_controller_free(controller *ctrl);
 int net_controller_get_rtt(controller *ctrl);
@@ -18,5 +38,6 @@ ENetPeer *net_controller_get_lobby_connection(controller *ctrl);
 ENetHost *net_controller_get_host(controller *ctrl);
 int net_controller_get_winner(controller *ctrl);
 void net_controller_set_winner(controller *ctrl, int winner);
+void net_controller_get_stats(controller *ctrl, net_controller_stats *stats);
 
 #endif // NET_CONTROLLER_H
@@ -8,16 +8,19 @@
 #include <inttypes.h>
 
 typedef struct {
-    int id;
+    uint32_t start_tick; // Game tick that tick 0 of the recording is played at
+    bool skip_assertions;
     uint32_t last_tick;
     uint32_t max_tick;
-    hashmap tick_lookup;
+    unsigned int cursor; // Next event to play back
+    unsigned int event_count;
+    sd_rec_move *events; // Events of this player, sorted by tick
 } wtf;
 
 void rec_controller_free(controller *ctrl) {
     wtf *data = ctrl->data;
     if(data) {
-        hashmap_free(&data->tick_lookup);
+        omf_free(data->events);
         omf_free(data);
     }
 }
@@ -31,13 +34,13 @@ int get_operand(rec_assertion_operand *op, controller *ctrl) {
         har *har = object_get_userdata(obj);
         switch(op->value.attr.attribute) {
             case ATTR_X_POS:
-                return obj->pos.x;
+                return phys_to_int(obj->pos.x);
             case ATTR_Y_POS:
-                return obj->pos.y;
+                return phys_to_int(obj->pos.y);
             case ATTR_X_VEL:
-                return obj->vel.x;
+                return phys_to_int(obj->vel.x);
             case ATTR_Y_VEL:
-                return obj->vel.y;
+                return phys_to_int(obj->vel.y);
             case ATTR_STATE_ID:
                 return har->state;
             case ATTR_ANIMATION_ID:
@@ -45,7 +48,7 @@ int get_operand(rec_assertion_operand *op, controller *ctrl) {
             case ATTR_HEALTH:
                 return har->health;
             case ATTR_STAMINA:
-                return har->endurance;
+                return phys_to_int(har->endurance);
             default:
                 abort();
         }
@@ -82,63 +85,112 @@ void check_assertion(rec_assertion *ass, controller *ctrl) {
     }
 }
 
+static void play_move(controller *ctrl, const sd_rec_move *move, ctrl_event **ev) {
+    wtf *data = ctrl->data;
+    uint8_t buf[8];
+    if(move->lookup_id == 10) {
+        if(data->skip_assertions) {
+            return;
+        }
+        buf[0] = move->raw_action;
+        memcpy(buf + 1, move->extra_data, 7);
+        rec_assertion ass;
+        if(parse_assertion(buf, &ass)) {
+            print_assertion(&ass);
+            check_assertion(&ass, ctrl);
+        }
+    } else if(move->lookup_id == 2) {
+        if(move->action == SD_ACT_NONE) {
+            controller_cmd(ctrl, ACT_STOP, ev);
+        } else {
+            int action = 0;
+            if(move->action & SD_ACT_UP) {
+                action |= ACT_UP;
+            }
+
+            if(move->action & SD_ACT_DOWN) {
+                action |= ACT_DOWN;
+            }
+
+            if(move->action & SD_ACT_LEFT) {
+                action |= ACT_LEFT;
+            }
+
+            if(move->action & SD_ACT_RIGHT) {
+                action |= ACT_RIGHT;
+            }
+            if(move->action & SD_ACT_PUNCH) {
+                action |= ACT_PUNCH;
+            }
+            if(move->action & SD_ACT_KICK) {
+                action |= ACT_KICK;
+            }
+
+            if(action != 0) {
+                controller_cmd(ctrl, action, ev);
+            }
+        }
+    }
+}
+
+// Index of the first event at or after the given tick
+static unsigned int find_tick(const wtf *data, uint32_t tick) {
+    unsigned int lo = 0;
+    unsigned int hi = data->event_count;
+    while(lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        if(data->events[mid].tick < tick) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void rec_controller_seek(controller *ctrl, uint32_t tick) {
+    wtf *data = ctrl->data;
+    data->cursor = find_tick(data, tick);
+    // Make sure that the events at the tick itself are played on the next poll.
+    data->last_tick = tick - 1;
+}
+
+void rec_controller_set_start_tick(controller *ctrl, uint32_t tick) {
+    wtf *data = ctrl->data;
+    data->start_tick = tick;
+    data->cursor = 0;
+    data->last_tick = 0;
+}
+
+void rec_controller_skip_assertions(controller *ctrl, bool skip) {
+    wtf *data = ctrl->data;
+    data->skip_assertions = skip;
+}
+
 int rec_controller_poll(controller *ctrl, ctrl_event **ev) {
-    uint32_t ticks = ctrl->gs->int_tick;
     wtf *data = ctrl->data;
-    sd_rec_move *move;
-    unsigned int len;
+    if(ctrl->gs->int_tick < data->start_tick) {
+        return 0;
+    }
+    uint32_t ticks = ctrl->gs->int_tick - data->start_tick;
     if(ticks > data->max_tick) {
         log_debug("closing controller");
         controller_close(ctrl, ev);
         return 0;
     }
 
-    uint8_t buf[8];
-
     if(data->last_tick != ticks) {
-        int j = 0;
-        while(hashmap_get_int(&data->tick_lookup, (ticks * 10) + j, (void **)(&move), &len) == 0) {
-            if(move->lookup_id == 10) {
-                buf[0] = move->raw_action;
-                memcpy(buf + 1, move->extra_data, 7);
-                rec_assertion ass;
-                if(parse_assertion(buf, &ass)) {
-                    print_assertion(&ass);
-                    check_assertion(&ass, ctrl);
-                }
-            } else if(move->lookup_id == 2) {
-                if(move->action == SD_ACT_NONE) {
-                    controller_cmd(ctrl, ACT_STOP, ev);
-                } else {
-                    int action = 0;
-                    if(move->action & SD_ACT_UP) {
-                        action |= ACT_UP;
-                    }
-
-                    if(move->action & SD_ACT_DOWN) {
-                        action |= ACT_DOWN;
-                    }
-
-                    if(move->action & SD_ACT_LEFT) {
-                        action |= ACT_LEFT;
-                    }
-
-                    if(move->action & SD_ACT_RIGHT) {
-                        action |= ACT_RIGHT;
-                    }
-                    if(move->action & SD_ACT_PUNCH) {
-                        action |= ACT_PUNCH;
-                    }
-                    if(move->action & SD_ACT_KICK) {
-                        action |= ACT_KICK;
-                    }
-
-                    if(action != 0) {
-                        controller_cmd(ctrl, action, ev);
-                    }
-                }
-            }
-            j++;
+        if(ticks < data->last_tick) {
+            // Time went backwards, find our place again.
+            data->cursor = find_tick(data, ticks);
+        }
+        // Skip over ticks that were never polled
+        while(data->cursor < data->event_count && data->events[data->cursor].tick < ticks) {
+            data->cursor++;
+        }
+        while(data->cursor < data->event_count && data->events[data->cursor].tick == ticks) {
+            play_move(ctrl, &data->events[data->cursor], ev);
+            data->cursor++;
         }
     }
     data->last_tick = ticks;
@@ -147,23 +199,37 @@ int rec_controller_poll(controller *ctrl, ctrl_event **ev) {
 
 void rec_controller_create(controller *ctrl, int player, sd_rec_file *rec) {
     wtf *data = omf_calloc(1, sizeof(wtf));
+    data->start_tick = 0;
+    data->skip_assertions = false;
     data->last_tick = 0;
-    hashmap_create(&data->tick_lookup);
-    uint32_t last_tick = 0;
-    int j = 0;
+    data->cursor = 0;
+
+    unsigned int count = 0;
     for(unsigned int i = 0; i < rec->move_count; i++) {
         if(rec->moves[i].player_id == player && (rec->moves[i].lookup_id == 2 || rec->moves[i].lookup_id == 10)) {
-            if(last_tick == rec->moves[i].tick) {
-                j++;
-            } else {
-                j = 0;
-            }
-            hashmap_put_int(&data->tick_lookup, (rec->moves[i].tick * 10) + j, &rec->moves[i], sizeof(sd_rec_move));
-            last_tick = rec->moves[i].tick;
+            count++;
         }
     }
-    data->max_tick = rec->moves[rec->move_count - 1].tick;
-    log_debug("max tick is %" PRIu32, data->last_tick);
+
+    // Moves are recorded in tick order, so this insertion sort is a plain copy in practice. It is stable,
+    // which keeps events of the same tick in the recorded order.
+    data->events = omf_calloc(count > 0 ? count : 1, sizeof(sd_rec_move));
+    for(unsigned int i = 0; i < rec->move_count; i++) {
+        const sd_rec_move *move = &rec->moves[i];
+        if(move->player_id != player || (move->lookup_id != 2 && move->lookup_id != 10)) {
+            continue;
+        }
+        unsigned int pos = data->event_count;
+        while(pos > 0 && data->events[pos - 1].tick > move->tick) {
+            data->events[pos] = data->events[pos - 1];
+            pos--;
+        }
+        data->events[pos] = *move;
+        data->event_count++;
+    }
+
+    data->max_tick = rec->move_count > 0 ? rec->moves[rec->move_count - 1].tick : 0;
+    log_debug("max tick is %" PRIu32, data->max_tick);
     ctrl->data = data;
     ctrl->type = CTRL_TYPE_REC;
     ctrl->poll_fun = &rec_controller_poll;
@@ -3,9 +3,27 @@
 
 #include "controller/controller.h"
 #include "formats/rec.h"
-#include "utils/hashmap.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 void rec_controller_create(controller *ctrl, int player, sd_rec_file *rec);
 void rec_controller_free(controller *ctrl);
 
+/**
+ * Moves playback to the given tick. The events recorded at that tick are played on the next poll.
+ */
+void rec_controller_seek(controller *ctrl, uint32_t tick);
+
+/**
+ * Plays the recording as if its tick 0 was the given game tick. Nothing is played before it, so UINT32_MAX holds
+ * playback until the real start tick is known.
+ */
+void rec_controller_set_start_tick(controller *ctrl, uint32_t tick);
+
+/**
+ * Skips the assertions in the recording. They expect the game state of the original recording, which a recording
+ * played against a network peer does not have while inputs are still being predicted.
+ */
+void rec_controller_skip_assertions(controller *ctrl, bool skip);
+
 #endif // REC_CONTROLLER_H
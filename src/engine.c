@@ -2,29 +2,93 @@
 #include "audio/audio.h"
 #include "console/console.h"
 #include "controller/controller.h"
+#include "controller/net_controller.h"
+#include "controller/rec_controller.h"
 #include "formats/altpal.h"
 #include "formats/rec.h"
 #include "game/game_player.h"
 #include "game/game_state.h"
 #include "game/gui/text_render.h"
+#include "game/protos/scene.h"
+#include "game/utils/replay_report.h"
+#include "game/utils/state_hash.h"
 #include "game/utils/settings.h"
 #include "resources/languages.h"
+#include "resources/resource_cache.h"
 #include "resources/sounds_loader.h"
 #include "utils/allocator.h"
+#include "utils/c_array_util.h"
+#include "utils/c_string_util.h"
+#include "utils/jobs.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
 #include "utils/png_writer.h"
+#include "utils/scandir.h"
 #include "utils/time_fmt.h"
 #include "video/vga_state.h"
 #include "video/video.h"
 #include <SDL.h>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #define MAX_TICKS_PER_FRAME 10
 #define TICK_EXPIRY_MS 100
 
+// Limits for headless netplay games, in ms
+#define NET_CONNECT_TIMEOUT 30000
+#define NET_GAME_TIMEOUT 600000
+
 static int run = 0;
 static int start_timeout = 30;
+static state_trace trace = {0};
+
+// The data files loaded at startup are independent of each other, so they are loaded in parallel.
+typedef struct startup_load {
+    bool (*load)(void);
+    bool ok;
+} startup_load;
+
+static bool altpals_load_ok(void) {
+    return altpals_init() == 0;
+}
+
+static void startup_load_run(void *userdata) {
+    startup_load *sl = userdata;
+    sl->ok = sl->load();
+}
+
+static bool load_data_files(void) {
+    startup_load loads[] = {
+        {sounds_loader_init, false},
+        {lang_init, false},
+        {fonts_init, false},
+        {altpals_load_ok, false},
+    };
+    job *jobs[N_ELEMENTS(loads)];
+    for(unsigned i = 0; i < N_ELEMENTS(loads); i++) {
+        jobs[i] = job_submit(startup_load_run, &loads[i]);
+    }
+    bool ok = true;
+    for(unsigned i = 0; i < N_ELEMENTS(loads); i++) {
+        job_free(jobs[i]);
+        ok = ok && loads[i].ok;
+    }
+    if(!ok) {
+        // These are all safe to call for files that were not loaded.
+        altpals_close();
+        fonts_close();
+        lang_close();
+        sounds_loader_close();
+    }
+    return ok;
+}
 static int enable_screen_updates = 1;
 static int debug_palette_number = 0;
 
@@ -46,6 +110,10 @@ int engine_init(engine_init_flags *init_flags) {
         player = init_flags->force_audio_backend;
     if(strlen(init_flags->force_renderer) > 0)
         renderer = init_flags->force_renderer;
+    if(init_flags->headless) {
+        player = "NULL";
+        renderer = "NULL";
+    }
 
     // Initialize everything.
     video_scan_renderers();
@@ -54,17 +122,14 @@ int engine_init(engine_init_flags *init_flags) {
         goto exit_0;
     if(!audio_init(player, frequency, mono, resampler, music_volume, sound_volume))
         goto exit_1;
-    if(!sounds_loader_init())
+    jobs_init(0);
+    if(!load_data_files())
         goto exit_2;
-    if(!lang_init())
-        goto exit_3;
-    if(!fonts_init())
-        goto exit_4;
-    if(altpals_init())
-        goto exit_5;
+    audio_prewarm_sounds();
     if(!console_init())
-        goto exit_6;
+        goto exit_3;
     vga_state_init();
+    resource_cache_init((size_t)max2(setting->video.asset_cache_mb, 0) * 1024 * 1024);
 
     // Return successfully
     run = 1;
@@ -72,15 +137,13 @@ int engine_init(engine_init_flags *init_flags) {
     return 0;
 
     // If something failed, close in correct order
-exit_6:
+exit_3:
     altpals_close();
-exit_5:
     fonts_close();
-exit_4:
     lang_close();
-exit_3:
     sounds_loader_close();
 exit_2:
+    jobs_close();
     audio_close();
 exit_1:
     video_close();
@@ -122,6 +185,69 @@ void save_rec(game_state *gs) {
     omf_free(time);
 }
 
+/**
+ * Run the static and dynamic ticks that are due. A controller may replace the game state while ticking, so the
+ * game state to continue with is returned.
+ *
+ * If report is given, this is a headless replay: hit delays do not sleep, and the arena state hash is recorded
+ * after each dynamic tick.
+ */
+static game_state *run_ticks(game_state *gs, int *static_wait, int *dynamic_wait, replay_report *report) {
+    bool has_dynamic = true;
+    bool has_static = true;
+    int tick_limit = MAX_TICKS_PER_FRAME;
+    do {
+        // Tick static features. This is a fixed with-rate tick, and is meant for running things
+        // that are not dependent on game speed (such as menus).
+        has_static = *static_wait > STATIC_TICKS;
+        if(has_static) {
+            game_state_static_tick(gs, false);
+            // check if we need to replace the game state
+            if(gs->new_state) {
+                // one of the controllers wants to replace the game state
+                game_state *old_gs = gs;
+                game_state *new_gs = gs->new_state;
+                log_debug("replacing game state! %p %p", old_gs, new_gs);
+                gs = new_gs;
+                log_debug("gs new state %p", gs->new_state);
+                // gs->new_state = NULL;
+                game_state_clone_free(old_gs);
+                omf_free(old_gs);
+            }
+            console_tick(gs);
+            *static_wait -= STATIC_TICKS;
+        }
+
+        // Tick dynamic features. This is a dynamically changing tick, and it depends on things such as
+        // hit-pause, hit slowdown and game-speed slider. It is meant for ticking everything that has to do
+        // with the actual gameplay stuff.
+        has_dynamic = *dynamic_wait > game_state_ms_per_dyntick(gs);
+        if(has_dynamic) {
+            game_state_dynamic_tick(gs, false);
+            *dynamic_wait -= game_state_ms_per_dyntick(gs);
+            state_trace_tick(&trace, gs);
+            if(report != NULL) {
+                replay_report_tick(report, gs);
+            }
+            if(gs->delay > 0) {
+                log_debug("applying delay %d", gs->delay);
+                if(report == NULL) {
+                    SDL_Delay(4);
+                }
+                gs->delay--;
+                *dynamic_wait -= 4;
+            }
+        }
+
+        // Ensure any pending palette changes are handled after any ticks are made.
+        if(has_dynamic || has_static) {
+            game_state_palette_transform(gs);
+            vga_state_render();
+        }
+    } while(tick_limit-- && (has_dynamic || has_static));
+    return gs;
+}
+
 void engine_run(engine_init_flags *init_flags) {
     SDL_Event e;
     int visual_debugger = 0;
@@ -161,6 +287,9 @@ void engine_run(engine_init_flags *init_flags) {
     }
 
     joystick_init();
+    if(init_flags->state_trace_file[0] != 0) {
+        state_trace_open(&trace, init_flags->state_trace_file);
+    }
 
     // Game loop
     uint64_t frame_start = SDL_GetTicks64(); // Set game tick timer
@@ -290,53 +419,11 @@ void engine_run(engine_init_flags *init_flags) {
         dynamic_wait = min2(dynamic_wait, TICK_EXPIRY_MS);
         static_wait = min2(static_wait, TICK_EXPIRY_MS);
 
-        // In warp mode, allow more ticks to happen per vsync period.
-        bool has_dynamic = true;
-        bool has_static = true;
-        int tick_limit = MAX_TICKS_PER_FRAME;
-        do {
-            // Tick static features. This is a fixed with-rate tick, and is meant for running things
-            // that are not dependent on game speed (such as menus).
-            has_static = static_wait > STATIC_TICKS;
-            if(has_static) {
-                game_state_static_tick(gs, false);
-                // check if we need to replace the game state
-                if(gs->new_state) {
-                    // one of the controllers wants to replace the game state
-                    game_state *old_gs = gs;
-                    game_state *new_gs = gs->new_state;
-                    log_debug("replacing game state! %p %p", old_gs, new_gs);
-                    gs = new_gs;
-                    log_debug("gs new state %p", gs->new_state);
-                    // gs->new_state = NULL;
-                    game_state_clone_free(old_gs);
-                    omf_free(old_gs);
-                }
-                console_tick(gs);
-                static_wait -= STATIC_TICKS;
-            }
+        // Pick up files loaded in the background before the ticks, so that they never appear mid-tick.
+        resource_cache_collect();
 
-            // Tick dynamic features. This is a dynamically changing tick, and it depends on things such as
-            // hit-pause, hit slowdown and game-speed slider. It is meant for ticking everything that has to do
-            // with the actual gameplay stuff.
-            has_dynamic = dynamic_wait > game_state_ms_per_dyntick(gs);
-            if(has_dynamic) {
-                game_state_dynamic_tick(gs, false);
-                dynamic_wait -= game_state_ms_per_dyntick(gs);
-                if(gs->delay > 0) {
-                    log_debug("applying delay %d", gs->delay);
-                    SDL_Delay(4);
-                    gs->delay--;
-                    dynamic_wait -= 4;
-                }
-            }
-
-            // Ensure any pending palette changes are handled after any ticks are made.
-            if(has_dynamic || has_static) {
-                game_state_palette_transform(gs);
-                vga_state_render();
-            }
-        } while(tick_limit-- && (has_dynamic || has_static));
+        // In warp mode, allow more ticks to happen per vsync period.
+        gs = run_ticks(gs, &static_wait, &dynamic_wait, NULL);
 
         // Do the actual video rendering jobs
         if(enable_screen_updates) {
@@ -354,6 +441,7 @@ void engine_run(engine_init_flags *init_flags) {
     }
 
     joystick_close();
+    state_trace_close(&trace);
 
     // Free scene object
     game_state_free(&gs);
@@ -361,9 +449,345 @@ void engine_run(engine_init_flags *init_flags) {
     log_info(" --- END GAME LOG ---");
 }
 
+bool engine_run_headless(engine_init_flags *init_flags, FILE *out) {
+    log_info(" --- BEGIN HEADLESS REPLAY %s ---", init_flags->rec_file);
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create(gs, init_flags)) {
+        replay_report_write_error(init_flags->rec_file, "unable to start replay", out);
+        fflush(out);
+        game_state_free(&gs);
+        return false;
+    }
+
+    // Advance a virtual clock by one static tick at a time. Ticks run in the same order as in engine_run(),
+    // but without waiting for them to be due.
+    replay_report report;
+    replay_report_create(&report);
+    if(init_flags->state_trace_file[0] != 0) {
+        state_trace_open(&trace, init_flags->state_trace_file);
+    }
+    int dynamic_wait = 0;
+    int static_wait = 0;
+    while(game_state_is_running(gs)) {
+        dynamic_wait += STATIC_TICKS;
+        static_wait += STATIC_TICKS;
+        resource_cache_collect();
+        gs = run_ticks(gs, &static_wait, &dynamic_wait, &report);
+    }
+    replay_report_write(&report, gs, init_flags->rec_file, out);
+    fflush(out);
+    replay_report_free(&report);
+    state_trace_close(&trace);
+    game_state_free(&gs);
+    log_info(" --- END HEADLESS REPLAY ---");
+    return true;
+}
+
+// Sets up the connection the same way as the listen and connect menus. Returns NULL if no peer showed up in time.
+static ENetPeer *headless_net_connect(ENetHost **host, bool server) {
+    ENetAddress address;
+    ENetPeer *peer = NULL;
+    ENetEvent event;
+
+    if(server) {
+        address.host = ENET_HOST_ANY;
+        address.port = settings_get()->net.net_listen_port_start;
+        *host = enet_host_create(&address, 1, 3, 0, 0);
+        log_info("Waiting for a client on port %d", address.port);
+    } else {
+        *host = enet_host_create(NULL, 1, 3, 0, 0);
+        if(*host != NULL) {
+            enet_address_set_host(&address, settings_get()->net.net_connect_ip);
+            address.port = settings_get()->net.net_connect_port;
+            peer = enet_host_connect(*host, &address, 3, 0);
+            log_info("Connecting to %s:%d", settings_get()->net.net_connect_ip, address.port);
+        }
+    }
+    if(*host == NULL || (!server && peer == NULL)) {
+        log_error("Unable to set up the network connection");
+        return NULL;
+    }
+
+    uint64_t deadline = SDL_GetTicks64() + NET_CONNECT_TIMEOUT;
+    while(SDL_GetTicks64() < deadline) {
+        if(enet_host_service(*host, &event, 100) <= 0) {
+            continue;
+        }
+        if(event.type == ENET_EVENT_TYPE_RECEIVE) {
+            enet_packet_destroy(event.packet);
+        } else if(event.type == ENET_EVENT_TYPE_CONNECT) {
+            ENetPacket *packet = enet_packet_create("0", 2, ENET_PACKET_FLAG_RELIABLE);
+            enet_peer_send(event.peer, 0, packet);
+            enet_host_flush(*host);
+            return event.peer;
+        }
+    }
+    log_error("Timed out waiting for the network peer");
+    return NULL;
+}
+
+bool engine_run_headless_net(engine_init_flags *init_flags, FILE *out) {
+    bool server = init_flags->net_mode == NET_MODE_SERVER;
+    const char *role = server ? "server" : "client";
+    uint64_t start = SDL_GetTicks64();
+    log_info(" --- BEGIN HEADLESS NETPLAY %s as %s ---", init_flags->rec_file, role);
+
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create(gs, init_flags)) {
+        replay_report_write_error(init_flags->rec_file, "unable to start replay", out);
+        fflush(out);
+        game_state_free(&gs);
+        return false;
+    }
+
+    ENetHost *host = NULL;
+    ENetPeer *peer = headless_net_connect(&host, server);
+    if(peer == NULL) {
+        replay_report_write_error(init_flags->rec_file, "unable to connect to the peer", out);
+        fflush(out);
+        if(host != NULL) {
+            enet_host_destroy(host);
+        }
+        game_state_free(&gs);
+        return false;
+    }
+
+    // Both sides play the same recording. Like in the menus, the server is player 1, and the peer plays the other
+    // player. The network controller owns the host from here on.
+    int remote = server ? 1 : 0;
+    gs->role = server ? ROLE_SERVER : ROLE_CLIENT;
+    game_state_set_speed(gs, 10);
+    game_player *remote_player = game_state_get_player(gs, remote);
+    controller *net_ctrl = omf_calloc(1, sizeof(controller));
+    controller_init(net_ctrl, gs);
+    net_ctrl->har_obj_id = remote_player->har_obj_id;
+    net_controller_create(net_ctrl, host, peer, NULL, gs->role);
+    game_player_set_ctrl(remote_player, net_ctrl);
+
+    // Hold the local inputs until the peers agree on a start tick, and then play them relative to it.
+    controller *local_ctrl = game_player_get_ctrl(game_state_get_player(gs, 1 - remote));
+    rec_controller_set_start_tick(local_ctrl, UINT32_MAX);
+    rec_controller_skip_assertions(local_ctrl, true);
+    controller_clear_hooks(local_ctrl);
+    controller_add_hook(local_ctrl, net_ctrl, net_ctrl->controller_hook);
+
+    // Unlike the headless replay, this runs on the wall clock; the peers have to keep up with each other.
+    net_controller_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    uint64_t frame_start = SDL_GetTicks64();
+    int dynamic_wait = 0;
+    int static_wait = 0;
+    while(game_state_is_running(gs) && SDL_GetTicks64() - start < NET_GAME_TIMEOUT) {
+        uint64_t frame_dt = SDL_GetTicks64() - frame_start;
+        frame_start = SDL_GetTicks64();
+        dynamic_wait += frame_dt;
+        static_wait += frame_dt;
+        dynamic_wait = min2(dynamic_wait, TICK_EXPIRY_MS);
+        static_wait = min2(static_wait, TICK_EXPIRY_MS);
+        resource_cache_collect();
+        gs = run_ticks(gs, &static_wait, &dynamic_wait, NULL);
+
+        controller *ctrl = game_player_get_ctrl(game_state_get_player(gs, remote));
+        if(ctrl->type != CTRL_TYPE_NETWORK) {
+            break;
+        }
+        bool started = stats.start_tick != 0;
+        net_controller_get_stats(ctrl, &stats);
+        if(!started && stats.start_tick != 0) {
+            log_info("Peers agreed to start at tick %" PRIu32, stats.start_tick);
+            rec_controller_set_start_tick(game_player_get_ctrl(game_state_get_player(gs, 1 - remote)),
+                                          stats.start_tick);
+        }
+        // Leaving the arena means that the match is over, or that a desync or disconnect stopped it
+        if(stats.disconnected || (started && !scene_is_arena(game_state_get_scene(gs)))) {
+            break;
+        }
+        SDL_Delay(1);
+    }
+
+    if(stats.start_tick == 0) {
+        replay_report_write_error(init_flags->rec_file, "peers did not synchronize", out);
+    } else {
+        replay_report_write_net(&stats, init_flags->rec_file, role, gs->int_tick - stats.start_tick,
+                                SDL_GetTicks64() - start, out);
+    }
+    fflush(out);
+    game_state_free(&gs);
+    log_info(" --- END HEADLESS NETPLAY ---");
+    return stats.start_tick != 0 && !stats.desynced;
+}
+
+static bool replay_file(engine_init_flags *init_flags, const char *filename, FILE *out) {
+    // REC playback clears the playback flag when the match ends, so set it up again for each file.
+    strncpy_or_truncate(init_flags->rec_file, filename, sizeof(init_flags->rec_file));
+    init_flags->playback = 1;
+    return engine_run_headless(init_flags, out);
+}
+
+static bool has_rec_suffix(const char *filename) {
+    size_t len = strlen(filename);
+    if(len < 4) {
+        return false;
+    }
+    const char *suffix = filename + len - 4;
+    return suffix[0] == '.' && tolower(suffix[1]) == 'r' && tolower(suffix[2]) == 'e' && tolower(suffix[3]) == 'c';
+}
+
+static int compare_filenames(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+#ifndef _WIN32
+typedef struct replay_worker {
+    pid_t pid;
+    FILE *out;
+    const char *filename;
+} replay_worker;
+
+/**
+ * Replay each file in a forked worker process, so that a failed REC assertion only takes down its own worker.
+ * Workers write their report to a temporary file, and the parent copies finished reports to stdout.
+ */
+static int replay_files(engine_init_flags *init_flags, char **files, int count, int jobs) {
+    replay_worker *workers = omf_calloc(jobs, sizeof(replay_worker));
+    int next = 0;
+    int running = 0;
+    int failed = 0;
+    char buf[4096];
+    fflush(NULL);
+    while(next < count || running > 0) {
+        while(running < jobs && next < count) {
+            const char *filename = files[next++];
+            FILE *tmp = tmpfile();
+            if(tmp == NULL) {
+                replay_report_write_error(filename, "unable to create temporary file", stdout);
+                failed++;
+                continue;
+            }
+            log_flush();
+            pid_t pid = fork();
+            if(pid == 0) {
+                log_after_fork();
+                jobs_after_fork();
+                bool ok = replay_file(init_flags, filename, tmp);
+                fflush(tmp);
+                _exit(ok ? 0 : 1);
+            }
+            if(pid < 0) {
+                replay_report_write_error(filename, "unable to start worker process", stdout);
+                fclose(tmp);
+                failed++;
+                continue;
+            }
+            int slot = 0;
+            while(workers[slot].pid != 0) {
+                slot++;
+            }
+            workers[slot].pid = pid;
+            workers[slot].out = tmp;
+            workers[slot].filename = filename;
+            running++;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if(pid < 0) {
+            log_error("Lost track of replay workers: %s", strerror(errno));
+            failed += running;
+            break;
+        }
+        for(int i = 0; i < jobs; i++) {
+            replay_worker *worker = &workers[i];
+            if(worker->pid != pid) {
+                continue;
+            }
+            size_t copied = 0;
+            size_t len;
+            rewind(worker->out);
+            while((len = fread(buf, 1, sizeof(buf), worker->out)) > 0) {
+                fwrite(buf, 1, len, stdout);
+                copied += len;
+            }
+            bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            if(!ok && copied == 0) {
+                if(WIFSIGNALED(status)) {
+                    snprintf(buf, sizeof(buf), "worker terminated by signal %d", WTERMSIG(status));
+                } else {
+                    snprintf(buf, sizeof(buf), "worker exited with status %d", WEXITSTATUS(status));
+                }
+                replay_report_write_error(worker->filename, buf, stdout);
+            }
+            fflush(stdout);
+            fclose(worker->out);
+            memset(worker, 0, sizeof(replay_worker));
+            failed += ok ? 0 : 1;
+            running--;
+        }
+    }
+    omf_free(workers);
+    return failed;
+}
+#else
+// No fork() here; replay the files one by one in this process.
+static int replay_files(engine_init_flags *init_flags, char **files, int count, int jobs) {
+    int failed = 0;
+    for(int i = 0; i < count; i++) {
+        failed += replay_file(init_flags, files[i], stdout) ? 0 : 1;
+    }
+    return failed;
+}
+#endif
+
+int engine_run_headless_dir(engine_init_flags *init_flags, const char *dirname, int jobs) {
+    list dirlist;
+    list_create(&dirlist);
+    if(scan_directory(&dirlist, dirname) != 0) {
+        log_error("Unable to read REC directory %s", dirname);
+        list_free(&dirlist);
+        return -1;
+    }
+
+    // Replay in file name order, so that the output is stable from run to run.
+    char **files = omf_calloc(list_size(&dirlist) + 1, sizeof(char *));
+    int count = 0;
+    bool has_separator = strlen(dirname) > 0 && (dirname[strlen(dirname) - 1] == '/' ||
+                                                 dirname[strlen(dirname) - 1] == '\\');
+    iterator it;
+    list_iter_begin(&dirlist, &it);
+    char *filename;
+    foreach(it, filename) {
+        if(!has_rec_suffix(filename)) {
+            continue;
+        }
+        size_t size = strlen(dirname) + strlen(filename) + 2;
+        files[count] = omf_malloc(size);
+        snprintf(files[count], size, has_separator ? "%s%s" : "%s/%s", dirname, filename);
+        count++;
+    }
+    list_free(&dirlist);
+    qsort(files, count, sizeof(char *), compare_filenames);
+
+    if(jobs < 1) {
+        jobs = 1;
+    }
+    log_info("Replaying %d REC files from %s with %d workers", count, dirname, jobs);
+    uint64_t start = SDL_GetTicks64();
+    int failed = replay_files(init_flags, files, count, jobs);
+    log_info("Replayed %d REC files in %" PRIu64 " ms, %d failed", count, SDL_GetTicks64() - start, failed);
+
+    for(int i = 0; i < count; i++) {
+        omf_free(files[i]);
+    }
+    omf_free(files);
+    return failed;
+}
+
 void engine_close(void) {
+    resource_cache_close();
+    jobs_close();
     console_close();
     altpals_close();
+    text_render_cache_clear();
     fonts_close();
     lang_close();
     sounds_loader_close();
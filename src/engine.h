@@ -1,6 +1,9 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include <stdbool.h>
+#include <stdio.h>
+
 // static tick duration, in ms
 #define STATIC_TICKS 10
 
@@ -11,12 +14,24 @@ typedef struct engine_init_flags_t {
     char force_renderer[16];
     char force_audio_backend[16];
     char rec_file[255];
+    char state_trace_file[255];
     int warpspeed;
     int speed;
+    unsigned int headless;
 } engine_init_flags;
 
 int engine_init(engine_init_flags *init_flags); // Init window, audiodevice, etc.
 void engine_run(engine_init_flags *init_flags); // Run game
 void engine_close(void);                        // Kill window, audiodev
 
+// Replay init_flags->rec_file without rendering or frame pacing, and write the result as a JSON line to out.
+bool engine_run_headless(engine_init_flags *init_flags, FILE *out);
+
+// Play init_flags->rec_file against a network peer that plays the same file, without rendering. The server side
+// listens and the client side connects, as set by init_flags->net_mode. Writes rollback statistics as a JSON line.
+bool engine_run_headless_net(engine_init_flags *init_flags, FILE *out);
+
+// Replay all REC files in a directory on a number of worker processes. Returns the number of failed replays.
+int engine_run_headless_dir(engine_init_flags *init_flags, const char *dirname, int jobs);
+
 #endif // ENGINE_H
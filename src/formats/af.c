@@ -103,13 +103,13 @@ void sd_af_postprocess(sd_af_file *af) {
     }
 }
 
-int sd_af_load(sd_af_file *af, const char *filename) {
+static int load_af(sd_af_file *af, const char *filename, bool shared) {
     int ret = SD_SUCCESS;
     uint8_t moveno = 0;
     sd_reader *r;
 
     // Initialize reader
-    if(!(r = sd_reader_open(filename))) {
+    if(!(r = shared ? sd_reader_open_shared(filename) : sd_reader_open(filename))) {
         return SD_FILE_OPEN_ERROR;
     }
 
@@ -155,6 +155,14 @@ cleanup:
     return ret;
 }
 
+int sd_af_load(sd_af_file *af, const char *filename) {
+    return load_af(af, filename, false);
+}
+
+int sd_af_load_mapped(sd_af_file *af, const char *filename) {
+    return load_af(af, filename, true);
+}
+
 int sd_af_save(const sd_af_file *af, const char *filename) {
     int ret;
     sd_writer *w;
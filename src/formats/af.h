@@ -109,6 +109,17 @@ sd_move *sd_af_get_move(sd_af_file *af, int index);
  */
 int sd_af_load(sd_af_file *af, const char *filename);
 
+/*! \brief Load AF file without copying sprite data
+ *
+ * Like sd_af_load(), but the sprites point directly into the file data instead of owning a
+ * copy of it. The file data is held until the last sprite referencing it is freed, so the file
+ * must not be modified while the structure is alive.
+ *
+ * \param af AF struct pointer.
+ * \param filename Name of the AF file.
+ */
+int sd_af_load_mapped(sd_af_file *af, const char *filename);
+
 /*! \brief Save AF file
  *
  * Saves the given AF file from memory to a file on disk. The structure must be
@@ -92,7 +92,7 @@ void sd_bk_postprocess(sd_bk_file *bk) {
     }
 }
 
-int sd_bk_load(sd_bk_file *bk, const char *filename) {
+static int load_bk(sd_bk_file *bk, const char *filename, bool shared) {
     uint16_t img_w, img_h;
     uint8_t animno = 0;
     sd_reader *r;
@@ -104,7 +104,7 @@ int sd_bk_load(sd_bk_file *bk, const char *filename) {
     }
 
     // Initialize reader
-    if(!(r = sd_reader_open(filename))) {
+    if(!(r = shared ? sd_reader_open_shared(filename) : sd_reader_open(filename))) {
         return SD_FILE_OPEN_ERROR;
     }
 
@@ -164,6 +164,14 @@ exit_0:
     return ret;
 }
 
+int sd_bk_load(sd_bk_file *bk, const char *filename) {
+    return load_bk(bk, filename, false);
+}
+
+int sd_bk_load_mapped(sd_bk_file *bk, const char *filename) {
+    return load_bk(bk, filename, true);
+}
+
 int sd_bk_load_from_pcx(sd_bk_file *bk, const char *filename) {
     int ret;
     pcx_file *pcx = omf_calloc(1, sizeof(pcx_file));
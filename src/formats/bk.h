@@ -197,6 +197,17 @@ vga_palette *sd_bk_get_palette(const sd_bk_file *bk, int index);
  * \param filename Name of the BK file to load from.
  */
 int sd_bk_load(sd_bk_file *bk, const char *filename);
+
+/*! \brief Load .BK file without copying sprite data
+ *
+ * Like sd_bk_load(), but the sprites point directly into the file data instead of owning a
+ * copy of it. The file data is held until the last sprite referencing it is freed, so the file
+ * must not be modified while the structure is alive.
+ *
+ * \param bk BK struct pointer.
+ * \param filename Name of the BK file to load from.
+ */
+int sd_bk_load_mapped(sd_bk_file *bk, const char *filename);
 int sd_bk_load_from_pcx(sd_bk_file *bk, const char *filename);
 
 /*! \brief Save .BK file
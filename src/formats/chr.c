@@ -50,6 +50,91 @@ int sd_chr_from_trn(sd_chr_file *chr, sd_tournament_file *trn, sd_pilot *pilot)
     return SD_SUCCESS;
 }
 
+/**
+ * Decodes the pilot block. The block is XOR encrypted, so it is decoded in a copy.
+ */
+static void parse_pilot_block(sd_chr_file *chr, const char *header) {
+    char buf[SD_CHR_HEADER_SIZE];
+    memcpy(buf, header, SD_CHR_HEADER_SIZE);
+    memreader *mr = memreader_open(buf, SD_CHR_HEADER_SIZE);
+    memreader_xor(mr, 0xAC);
+    sd_pilot_create(&chr->pilot);
+    sd_pilot_load_from_mem(mr, &chr->pilot);
+    memreader_close(mr);
+}
+
+/**
+ * Reads the HAR palette and the pilot photo that follow the enemies block.
+ */
+static int load_photo(sd_reader *r, sd_chr_file *chr) {
+    // Read HAR palette
+    vga_palette_init(&chr->pal);
+    palette_load_range(r, &chr->pal, 0, 48);
+
+    // No idea what this is.
+    // TODO: Find out.
+    chr->unknown_b = sd_read_udword(r);
+
+    // Load sprite
+    chr->photo = omf_calloc(1, sizeof(sd_sprite));
+    sd_sprite_create(chr->photo);
+    if(sd_sprite_load(r, chr->photo) != SD_SUCCESS) {
+        sd_sprite_free(chr->photo);
+        omf_free(chr->photo);
+        chr->photo = NULL;
+        return SD_FILE_PARSE_ERROR;
+    }
+
+    // Fix photo size
+    chr->photo->width++;
+    chr->photo->height++;
+
+    chr->pilot.photo = chr->photo;
+    return SD_SUCCESS;
+}
+
+int sd_chr_read_header(const char *filename, char *header) {
+    if(filename == NULL || header == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    sd_reader *r = sd_reader_open(filename);
+    if(!r) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    int ret = SD_SUCCESS;
+    if(sd_read_buf(r, header, SD_CHR_HEADER_SIZE) != 1) {
+        ret = SD_FILE_PARSE_ERROR;
+    }
+    sd_reader_close(r);
+    return ret;
+}
+
+int sd_chr_load_header(sd_chr_file *chr, const char *header) {
+    if(chr == NULL || header == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    parse_pilot_block(chr, header);
+    return SD_SUCCESS;
+}
+
+int sd_chr_load_photo(sd_chr_file *chr, const char *filename) {
+    if(chr == NULL || filename == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    if(chr->photo != NULL) {
+        return SD_SUCCESS;
+    }
+    sd_reader *r = sd_reader_open(filename);
+    if(!r) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    // Skip over the pilot and enemy blocks
+    sd_reader_set(r, SD_CHR_HEADER_SIZE + 68 * chr->pilot.enemies_inc_unranked);
+    int ret = load_photo(r, chr);
+    sd_reader_close(r);
+    return ret;
+}
+
 int sd_chr_load(sd_chr_file *chr, const char *filename) {
     if(chr == NULL || filename == NULL) {
         return SD_INVALID_INPUT;
@@ -64,11 +149,9 @@ int sd_chr_load(sd_chr_file *chr, const char *filename) {
     }
 
     // Read up pilot block and the unknown data
-    memreader *mr = memreader_open_from_reader(r, 448);
-    memreader_xor(mr, 0xAC);
-    sd_pilot_create(&chr->pilot);
-    sd_pilot_load_from_mem(mr, &chr->pilot);
-    memreader_close(mr);
+    char header[SD_CHR_HEADER_SIZE];
+    sd_read_buf(r, header, SD_CHR_HEADER_SIZE);
+    parse_pilot_block(chr, header);
 
     char tmp[200];
     str pic_file;
@@ -131,7 +214,7 @@ int sd_chr_load(sd_chr_file *chr, const char *filename) {
     }
 
     // Read enemies block
-    mr = memreader_open_from_reader(r, 68 * chr->pilot.enemies_inc_unranked);
+    memreader *mr = memreader_open_from_reader(r, 68 * chr->pilot.enemies_inc_unranked);
     memreader_xor(mr, (chr->pilot.enemies_inc_unranked * 68) & 0xFF);
 
     // Handle enemy data
@@ -213,28 +296,10 @@ int sd_chr_load(sd_chr_file *chr, const char *filename) {
     // Close memory reader for enemy data block
     memreader_close(mr);
 
-    // Read HAR palette
-    vga_palette_init(&chr->pal);
-    palette_load_range(r, &chr->pal, 0, 48);
-
-    // No idea what this is.
-    // TODO: Find out.
-    chr->unknown_b = sd_read_udword(r);
-
-    // Load sprite
-    chr->photo = omf_calloc(1, sizeof(sd_sprite));
-    sd_sprite_create(chr->photo);
-    int ret = sd_sprite_load(r, chr->photo);
-    if(ret != SD_SUCCESS) {
+    if(load_photo(r, chr) != SD_SUCCESS) {
         goto error_1;
     }
 
-    // Fix photo size
-    chr->photo->width++;
-    chr->photo->height++;
-
-    chr->pilot.photo = chr->photo;
-
     // Close & return
     sd_reader_close(r);
 
@@ -246,7 +311,6 @@ error_1:
             omf_free(chr->enemies[i]);
         }
     }
-    sd_sprite_free(chr->photo);
     sd_reader_close(r);
     return SD_FILE_PARSE_ERROR;
 }
@@ -15,7 +15,8 @@
 #include "formats/sprite.h"
 #include "formats/tournament.h"
 
-#define MAX_CHR_ENEMIES 256 ///< Maximum amount of enemies for a CHR file.
+#define MAX_CHR_ENEMIES 256    ///< Maximum amount of enemies for a CHR file.
+#define SD_CHR_HEADER_SIZE 448 ///< Size of the encrypted pilot block at the start of a CHR file.
 
 /*! \brief CHR enemy state entry
  *
@@ -81,6 +82,46 @@ int sd_chr_from_trn(sd_chr_file *chr, sd_tournament_file *trn, sd_pilot *pilot);
  */
 int sd_chr_load(sd_chr_file *chr, const char *filename);
 
+/*! \brief Read the pilot block of a .CHR file
+ *
+ * Reads the encrypted pilot block at the start of the CHR file, without decoding it. The block
+ * can be decoded with sd_chr_load_header().
+ *
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_PARSE_ERROR File is too short.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param filename Name of the CHR file to read from.
+ * \param header Buffer of SD_CHR_HEADER_SIZE bytes.
+ */
+int sd_chr_read_header(const char *filename, char *header);
+
+/*! \brief Load the pilot from a CHR pilot block
+ *
+ * Decodes a pilot block read by sd_chr_read_header() into the pilot field. Enemies, the tournament
+ * data and the photo are not loaded. The structure must be initialized with sd_chr_create().
+ *
+ * \retval SD_SUCCESS Success.
+ *
+ * \param chr CHR struct pointer.
+ * \param header Pilot block of SD_CHR_HEADER_SIZE bytes.
+ */
+int sd_chr_load_header(sd_chr_file *chr, const char *header);
+
+/*! \brief Load the photo of a .CHR file
+ *
+ * Loads the HAR palette and the pilot photo for a CHR struct that only has its pilot loaded.
+ * Does nothing if the photo is already loaded.
+ *
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_PARSE_ERROR File does not contain valid data.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param chr CHR struct pointer, with the pilot loaded.
+ * \param filename Name of the CHR file to load from.
+ */
+int sd_chr_load_photo(sd_chr_file *chr, const char *filename);
+
 /*! \brief Save .CHR file
  *
  * Saves the given CHR file from memory to a file on disk. The structure must be at
@@ -1,29 +1,136 @@
 #include <errno.h>
-#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32) || defined(WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "formats/internal/reader.h"
 #include "utils/allocator.h"
 
+// File contents for the memory backend. Shared between the reader and any sprites that borrow from it.
+struct sd_reader_data {
+    int refcount;
+    bool mapped;
+    char *data;
+    size_t size;
+};
+
 struct sd_reader {
-    FILE *handle;
+    FILE *handle;         // stdio backend
+    sd_reader_data *mem;  // memory backend
+    const char *data;     // shortcut to mem->data
+    size_t size;          // shortcut to mem->size
+    size_t pos;           // may point past the end after sd_reader_set
     long filesize;
+    bool eof;
+    bool shared;
     int sd_errno;
 };
 
-sd_reader *sd_reader_open(const char *file) {
+static sd_reader_backend default_backend = SD_READER_MEMORY;
+
+void sd_reader_set_backend(sd_reader_backend backend) {
+    default_backend = backend;
+}
+
+#if defined(_WIN32) || defined(WIN32)
+
+static bool map_file(const char *file, sd_reader_data *mem) {
+    LARGE_INTEGER size;
+    HANDLE handle = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    if(!GetFileSizeEx(handle, &size) || size.QuadPart <= 0 || (uint64_t)size.QuadPart > SIZE_MAX) {
+        CloseHandle(handle);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if(mapping == NULL) {
+        return false;
+    }
+    // The view keeps the mapping alive after its handle is closed.
+    mem->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(mem->data == NULL) {
+        return false;
+    }
+    mem->size = (size_t)size.QuadPart;
+    return true;
+}
+
+static void unmap_file(sd_reader_data *mem) {
+    UnmapViewOfFile(mem->data);
+}
+
+#else
+
+static bool map_file(const char *file, sd_reader_data *mem) {
+    struct stat info;
+    int fd = open(file, O_RDONLY);
+    if(fd == -1) {
+        return false;
+    }
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || (uint64_t)info.st_size > SIZE_MAX) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        return false;
+    }
+    mem->data = data;
+    mem->size = info.st_size;
+    return true;
+}
+
+static void unmap_file(sd_reader_data *mem) {
+    munmap(mem->data, mem->size);
+}
+
+#endif
+
+static bool read_whole_file(FILE *handle, long filesize, sd_reader_data *mem) {
+    // One extra byte, so that empty files get a valid buffer too.
+    char *data = omf_malloc((size_t)filesize + 1);
+    if(fread(data, 1, filesize, handle) != (size_t)filesize) {
+        omf_free(data);
+        return false;
+    }
+    mem->data = data;
+    mem->size = filesize;
+    return true;
+}
+
+static sd_reader *reader_open(const char *file, sd_reader_backend backend) {
     sd_reader *reader = omf_calloc(1, sizeof(sd_reader));
 
     reader->sd_errno = 0;
 
+    if(backend == SD_READER_MEMORY) {
+        reader->mem = omf_calloc(1, sizeof(sd_reader_data));
+        reader->mem->refcount = 1;
+        if(map_file(file, reader->mem)) {
+            reader->mem->mapped = true;
+            goto done;
+        }
+    }
+
     // Attempt to open file (note: Binary mode!)
     reader->handle = fopen(file, "rb");
     if(!reader->handle) {
-        omf_free(reader);
-        return NULL;
+        goto error;
     }
 
     // Find file size
@@ -38,15 +145,70 @@ sd_reader *sd_reader_open(const char *file) {
         goto error;
     }
 
+    // Memory backend could not map the file, so read it all in one go instead.
+    if(reader->mem != NULL) {
+        if(!read_whole_file(reader->handle, reader->filesize, reader->mem)) {
+            goto error;
+        }
+        fclose(reader->handle);
+        reader->handle = NULL;
+    }
+
+done:
+    if(reader->mem != NULL) {
+        reader->data = reader->mem->data;
+        reader->size = reader->mem->size;
+        reader->filesize = (long)reader->size;
+    }
+
     // All done.
     return reader;
 
 error:
-    fclose(reader->handle);
+    if(reader->handle) {
+        fclose(reader->handle);
+    }
+    omf_free(reader->mem);
     omf_free(reader);
     return NULL;
 }
 
+sd_reader *sd_reader_open(const char *file) {
+    return reader_open(file, default_backend);
+}
+
+sd_reader *sd_reader_open_shared(const char *file) {
+    sd_reader *reader = reader_open(file, default_backend);
+    if(reader != NULL) {
+        reader->shared = reader->mem != NULL;
+    }
+    return reader;
+}
+
+bool sd_reader_is_shared(const sd_reader *reader) {
+    return reader->shared;
+}
+
+sd_reader_data *sd_reader_retain(sd_reader *reader) {
+    if(reader->mem == NULL) {
+        return NULL;
+    }
+    reader->mem->refcount++;
+    return reader->mem;
+}
+
+void sd_reader_release(sd_reader_data *mem) {
+    if(mem == NULL || --mem->refcount > 0) {
+        return;
+    }
+    if(mem->mapped) {
+        unmap_file(mem);
+    } else {
+        omf_free(mem->data);
+    }
+    omf_free(mem);
+}
+
 long sd_reader_filesize(const sd_reader *reader) {
     return reader->filesize;
 }
@@ -56,11 +218,23 @@ int sd_reader_errno(const sd_reader *reader) {
 }
 
 void sd_reader_close(sd_reader *reader) {
-    fclose(reader->handle);
+    if(reader->handle) {
+        fclose(reader->handle);
+    }
+    sd_reader_release(reader->mem);
     omf_free(reader);
 }
 
 int sd_reader_set(sd_reader *reader, long offset) {
+    if(reader->mem != NULL) {
+        if(offset < 0) {
+            reader->sd_errno = EINVAL;
+            return 0;
+        }
+        reader->pos = offset;
+        reader->eof = false;
+        return 1;
+    }
     if(fseek(reader->handle, offset, SEEK_SET) != 0) {
         reader->sd_errno = errno;
         return 0;
@@ -69,6 +243,9 @@ int sd_reader_set(sd_reader *reader, long offset) {
 }
 
 int sd_reader_ok(const sd_reader *reader) {
+    if(reader->mem != NULL) {
+        return !reader->eof;
+    }
     if(feof(reader->handle)) {
         return 0;
     }
@@ -76,6 +253,9 @@ int sd_reader_ok(const sd_reader *reader) {
 }
 
 long sd_reader_pos(sd_reader *reader) {
+    if(reader->mem != NULL) {
+        return (long)reader->pos;
+    }
     long res = ftell(reader->handle);
     if(res == -1) {
         reader->sd_errno = errno;
@@ -83,7 +263,34 @@ long sd_reader_pos(sd_reader *reader) {
     return res;
 }
 
+static inline size_t mem_left(const sd_reader *reader) {
+    return reader->pos < reader->size ? reader->size - reader->pos : 0;
+}
+
+// Short read: copy what is left, and hit the end of file like fread would.
+static int mem_read_short(sd_reader *reader, char *buf) {
+    size_t left = mem_left(reader);
+    if(left > 0) {
+        memcpy(buf, reader->data + reader->pos, left);
+        reader->pos = reader->size;
+    }
+    reader->eof = true;
+    return 0;
+}
+
+static inline int mem_read(sd_reader *reader, char *buf, size_t len) {
+    if(len > mem_left(reader)) {
+        return mem_read_short(reader, buf);
+    }
+    memcpy(buf, reader->data + reader->pos, len);
+    reader->pos += len;
+    return 1;
+}
+
 int sd_read_buf(sd_reader *reader, char *buf, size_t len) {
+    if(reader->mem != NULL) {
+        return mem_read(reader, buf, len);
+    }
     if(fread(buf, 1, len, reader->handle) != len) {
         reader->sd_errno = ferror(reader->handle);
         return 0;
@@ -91,56 +298,67 @@ int sd_read_buf(sd_reader *reader, char *buf, size_t len) {
     return 1;
 }
 
+const char *sd_read_ref(sd_reader *reader, size_t len) {
+    if(reader->mem == NULL || len > mem_left(reader)) {
+        return NULL;
+    }
+    const char *ref = reader->data + reader->pos;
+    reader->pos += len;
+    return ref;
+}
+
 int sd_peek_buf(sd_reader *reader, char *buf, int len) {
-    if(sd_read_buf(reader, buf, len)) {
+    if(reader->mem != NULL) {
+        if((size_t)len > mem_left(reader)) {
+            return 1;
+        }
+        memcpy(buf, reader->data + reader->pos, len);
         return 0;
     }
-    if(fseek(reader->handle, ftell(reader->handle) - len, SEEK_SET) == -1) {
+    long pos = ftell(reader->handle);
+    int ret = sd_read_buf(reader, buf, len) ? 0 : 1;
+    if(fseek(reader->handle, pos, SEEK_SET) == -1) {
         reader->sd_errno = errno;
     }
-    return 1;
+    return ret;
 }
 
-uint8_t sd_read_ubyte(sd_reader *reader) {
-    uint8_t d = 0;
-    sd_read_buf(reader, (char *)&d, 1);
+// Fixed size reads are the bulk of all parsing, so give them an inlined path for the memory backend.
+#define READ_VALUE(reader, type)                                                                                       \
+    type d = 0;                                                                                                        \
+    if(reader->mem != NULL) {                                                                                          \
+        mem_read(reader, (char *)&d, sizeof(type));                                                                    \
+    } else {                                                                                                           \
+        sd_read_buf(reader, (char *)&d, sizeof(type));                                                                 \
+    }                                                                                                                  \
     return d;
+
+uint8_t sd_read_ubyte(sd_reader *reader) {
+    READ_VALUE(reader, uint8_t)
 }
 
 uint16_t sd_read_uword(sd_reader *reader) {
-    uint16_t d = 0;
-    sd_read_buf(reader, (char *)&d, 2);
-    return d;
+    READ_VALUE(reader, uint16_t)
 }
 
 uint32_t sd_read_udword(sd_reader *reader) {
-    uint32_t d = 0;
-    sd_read_buf(reader, (char *)&d, 4);
-    return d;
+    READ_VALUE(reader, uint32_t)
 }
 
 int8_t sd_read_byte(sd_reader *reader) {
-    int8_t d = 0;
-    sd_read_buf(reader, (char *)&d, 1);
-    return d;
+    READ_VALUE(reader, int8_t)
 }
 
 int16_t sd_read_word(sd_reader *reader) {
-    int16_t d = 0;
-    sd_read_buf(reader, (char *)&d, 2);
-    return d;
+    READ_VALUE(reader, int16_t)
 }
 
 int32_t sd_read_dword(sd_reader *reader) {
-    int32_t d = 0;
-    sd_read_buf(reader, (char *)&d, 4);
-    return d;
+    READ_VALUE(reader, int32_t)
 }
 
 float sd_read_float(sd_reader *reader) {
-    float f = 0;
-    sd_read_buf(reader, (char *)&f, 4);
-    return f;
+    READ_VALUE(reader, float)
 }
 
 uint8_t sd_peek_ubyte(sd_reader *reader) {
@@ -196,20 +414,40 @@ int sd_match(sd_reader *reader, const char *buf, unsigned int nbytes) {
 }
 
 void sd_skip(sd_reader *reader, unsigned int nbytes) {
+    if(reader->mem != NULL) {
+        reader->pos += nbytes;
+        reader->eof = false;
+        return;
+    }
     if(fseek(reader->handle, nbytes, SEEK_CUR) == -1) {
         reader->sd_errno = errno;
     }
 }
 
-int sd_read_scan(const sd_reader *reader, const char *format, ...) {
-    va_list argp;
-    va_start(argp, format);
-    int ret = fscanf(reader->handle, format, argp);
-    va_end(argp);
-    return ret;
-}
-
-int sd_read_line(const sd_reader *reader, char *buffer, int maxlen) {
+int sd_read_line(sd_reader *reader, char *buffer, int maxlen) {
+    if(reader->mem != NULL) {
+        if(maxlen <= 0) {
+            return 1;
+        }
+        if(mem_left(reader) == 0) {
+            reader->eof = true;
+            return 1;
+        }
+        int i = 0;
+        while(i < maxlen - 1) {
+            if(mem_left(reader) == 0) {
+                reader->eof = true;
+                break;
+            }
+            char c = reader->data[reader->pos++];
+            buffer[i++] = c;
+            if(c == '\n') {
+                break;
+            }
+        }
+        buffer[i] = 0;
+        return 0;
+    }
     if(fgets(buffer, maxlen, reader->handle) == NULL) {
         return 1;
     }
@@ -7,9 +7,42 @@
 #include "utils/str.h"
 
 typedef struct sd_reader sd_reader;
+typedef struct sd_reader_data sd_reader_data;
+
+typedef enum sd_reader_backend
+{
+    SD_READER_MEMORY, ///< Map the file into memory, or read it whole if it can not be mapped. This is the default.
+    SD_READER_STDIO,  ///< Read the file through stdio, a few bytes at a time.
+} sd_reader_backend;
+
+/**
+ * Selects the backend for readers opened after this call. Meant for benchmarks and debugging.
+ */
+void sd_reader_set_backend(sd_reader_backend backend);
 
 sd_reader *sd_reader_open(const char *file);
 
+/**
+ * Opens a reader that lets loaded sprites point into the file data instead of copying it. The file data stays
+ * alive for as long as something references it, so the file must not be modified while it is loaded.
+ * Falls back to a normal reader with the stdio backend.
+ */
+sd_reader *sd_reader_open_shared(const char *file);
+bool sd_reader_is_shared(const sd_reader *reader);
+
+/**
+ * Returns a pointer to the next len bytes of the file, and advances past them. The pointer stays valid until
+ * the reader is closed, or for as long as a reference from sd_reader_retain() is held.
+ * Returns NULL if the reader is not memory backed, or if there are less than len bytes left.
+ */
+const char *sd_read_ref(sd_reader *reader, size_t len);
+
+/**
+ * Takes a reference to the file data of a memory backed reader.
+ */
+sd_reader_data *sd_reader_retain(sd_reader *reader);
+void sd_reader_release(sd_reader_data *data);
+
 /**
  * Check for errors
  */
@@ -41,8 +74,10 @@ int16_t sd_peek_word(sd_reader *reader);
 int32_t sd_peek_dword(sd_reader *reader);
 float sd_peek_float(sd_reader *reader);
 
-int sd_read_scan(const sd_reader *reader, const char *format, ...);
-int sd_read_line(const sd_reader *reader, char *buffer, int maxlen);
+/**
+ * Reads a line like fgets. Returns 1 if there was nothing left to read.
+ */
+int sd_read_line(sd_reader *reader, char *buffer, int maxlen);
 
 /**
  * Compare following nbytes amount of data and given buffer. Does not advance file pointer.
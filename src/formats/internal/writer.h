@@ -23,6 +23,11 @@ int sd_writer_errno(const sd_writer *writer);
  */
 void sd_writer_close(sd_writer *writer);
 
+/**
+ * Flush buffered data to the file. Returns 0 on success.
+ */
+int sd_writer_flush(sd_writer *writer);
+
 /**
  * Returns the position of the file pointer
  */
@@ -7,6 +7,8 @@
 #include "formats/rec.h"
 #include "utils/allocator.h"
 
+#define REC_MIN_CAPACITY 256
+
 int sd_rec_extra_len(int key) {
     switch(key) {
         case 2:
@@ -113,11 +115,12 @@ int sd_rec_load(sd_rec_file *rec, const char *file) {
     rec->hyper_mode = (in >> 24) & 0x01; // 00000001 00000000 00000000 00000000 (1)
     rec->unknown_m = sd_read_byte(r);
 
-    // Allocate enough space for the record blocks
-    // This will be reduced later when we know the ACTUAL count
+    // Allocate enough space for the record blocks. Records with extra data are longer than 7 bytes,
+    // so the actual count may be smaller; the rest is kept as spare capacity.
     size_t rsize = sd_reader_filesize(r) - sd_reader_pos(r);
     rec->move_count = rsize / 7;
-    rec->moves = omf_calloc(rec->move_count, sizeof(sd_rec_move));
+    rec->move_capacity = rec->move_count;
+    rec->moves = omf_calloc(rec->move_capacity, sizeof(sd_rec_move));
 
     // Read blocks
     for(unsigned i = 0; i < rec->move_count; i++) {
@@ -174,10 +177,6 @@ int sd_rec_load(sd_rec_file *rec, const char *file) {
         }
     }
 
-    // Okay, not reduce the allocated memory to match what we actually need
-    // Realloc should keep our old data intact
-    rec->moves = omf_realloc(rec->moves, rec->move_count * sizeof(sd_rec_move));
-
     // Close & return
     sd_reader_close(r);
     return SD_SUCCESS;
@@ -187,17 +186,7 @@ error_0:
     return ret;
 }
 
-int sd_rec_save(sd_rec_file *rec, const char *file) {
-    sd_writer *w;
-
-    if(rec == NULL || file == NULL) {
-        return SD_INVALID_INPUT;
-    }
-
-    if(!(w = sd_writer_open(file))) {
-        return SD_FILE_OPEN_ERROR;
-    }
-
+static void rec_save_header(sd_writer *w, const sd_rec_file *rec) {
     // Write pilots, palettes, etc.
     for(int i = 0; i < 2; i++) {
         sd_pilot_save(w, &rec->pilots[i].info);
@@ -239,61 +228,126 @@ int sd_rec_save(sd_rec_file *rec, const char *file) {
     out |= (rec->hyper_mode & 0x1) << 24;
     sd_write_udword(w, out);
     sd_write_byte(w, rec->unknown_m);
+}
 
-    // Move records
-    for(unsigned i = 0; i < rec->move_count; i++) {
-        sd_write_udword(w, rec->moves[i].tick);
-        sd_write_ubyte(w, rec->moves[i].lookup_id);
-        sd_write_ubyte(w, rec->moves[i].player_id);
-
-        int extra_length = sd_rec_extra_len(rec->moves[i].lookup_id);
-        if(extra_length == 1) {
-            // Write action information
-            uint8_t raw_action = 0;
-            switch(rec->moves[i].action & SD_MOVE_MASK) {
-                case(SD_ACT_UP):
-                    raw_action = 16;
-                    break;
-                case(SD_ACT_UP | SD_ACT_RIGHT):
-                    raw_action = 32;
-                    break;
-                case(SD_ACT_RIGHT):
-                    raw_action = 48;
-                    break;
-                case(SD_ACT_DOWN | SD_ACT_RIGHT):
-                    raw_action = 64;
-                    break;
-                case(SD_ACT_DOWN):
-                    raw_action = 80;
-                    break;
-                case(SD_ACT_DOWN | SD_ACT_LEFT):
-                    raw_action = 96;
-                    break;
-                case(SD_ACT_LEFT):
-                    raw_action = 112;
-                    break;
-                case(SD_ACT_UP | SD_ACT_LEFT):
-                    raw_action = 128;
-                    break;
-            }
-            if(rec->moves[i].action & SD_ACT_PUNCH)
-                raw_action |= 1;
-            if(rec->moves[i].action & SD_ACT_KICK)
-                raw_action |= 2;
-            sd_write_ubyte(w, raw_action);
-        }
-        // If there is more extra data, write it
-        int unknown_len = extra_length - 1;
-        if(unknown_len > 0) {
-            sd_write_ubyte(w, rec->moves[i].raw_action);
-            sd_write_buf(w, rec->moves[i].extra_data, unknown_len);
+static void rec_save_move(sd_writer *w, const sd_rec_move *move) {
+    sd_write_udword(w, move->tick);
+    sd_write_ubyte(w, move->lookup_id);
+    sd_write_ubyte(w, move->player_id);
+
+    int extra_length = sd_rec_extra_len(move->lookup_id);
+    if(extra_length == 1) {
+        // Write action information
+        uint8_t raw_action = 0;
+        switch(move->action & SD_MOVE_MASK) {
+            case(SD_ACT_UP):
+                raw_action = 16;
+                break;
+            case(SD_ACT_UP | SD_ACT_RIGHT):
+                raw_action = 32;
+                break;
+            case(SD_ACT_RIGHT):
+                raw_action = 48;
+                break;
+            case(SD_ACT_DOWN | SD_ACT_RIGHT):
+                raw_action = 64;
+                break;
+            case(SD_ACT_DOWN):
+                raw_action = 80;
+                break;
+            case(SD_ACT_DOWN | SD_ACT_LEFT):
+                raw_action = 96;
+                break;
+            case(SD_ACT_LEFT):
+                raw_action = 112;
+                break;
+            case(SD_ACT_UP | SD_ACT_LEFT):
+                raw_action = 128;
+                break;
         }
+        if(move->action & SD_ACT_PUNCH)
+            raw_action |= 1;
+        if(move->action & SD_ACT_KICK)
+            raw_action |= 2;
+        sd_write_ubyte(w, raw_action);
+    }
+    // If there is more extra data, write it
+    int unknown_len = extra_length - 1;
+    if(unknown_len > 0) {
+        sd_write_ubyte(w, move->raw_action);
+        sd_write_buf(w, move->extra_data, unknown_len);
+    }
+}
+
+int sd_rec_save(sd_rec_file *rec, const char *file) {
+    sd_writer *w;
+
+    if(rec == NULL || file == NULL) {
+        return SD_INVALID_INPUT;
+    }
+
+    if(!(w = sd_writer_open(file))) {
+        return SD_FILE_OPEN_ERROR;
+    }
+
+    rec_save_header(w, rec);
+    for(unsigned i = 0; i < rec->move_count; i++) {
+        rec_save_move(w, &rec->moves[i]);
     }
 
     sd_writer_close(w);
     return SD_SUCCESS;
 }
 
+struct sd_rec_stream {
+    sd_writer *w;
+    unsigned int written;
+};
+
+sd_rec_stream *sd_rec_stream_open(const sd_rec_file *rec, const char *file) {
+    if(rec == NULL || file == NULL) {
+        return NULL;
+    }
+    sd_writer *w = sd_writer_open(file);
+    if(w == NULL) {
+        return NULL;
+    }
+    sd_rec_stream *stream = omf_calloc(1, sizeof(sd_rec_stream));
+    stream->w = w;
+    stream->written = 0;
+    rec_save_header(w, rec);
+    sd_rec_stream_flush(stream, rec);
+    return stream;
+}
+
+int sd_rec_stream_flush(sd_rec_stream *stream, const sd_rec_file *rec) {
+    if(stream == NULL || rec == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    if(rec->move_count < stream->written) {
+        // Moves that are already on disk were deleted, there is no way to take them back.
+        return SD_INVALID_INPUT;
+    }
+    for(unsigned i = stream->written; i < rec->move_count; i++) {
+        rec_save_move(stream->w, &rec->moves[i]);
+    }
+    stream->written = rec->move_count;
+    if(sd_writer_flush(stream->w) != 0) {
+        return SD_FILE_WRITE_ERROR;
+    }
+    return SD_SUCCESS;
+}
+
+int sd_rec_stream_close(sd_rec_stream *stream, const sd_rec_file *rec) {
+    if(stream == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    int ret = sd_rec_stream_flush(stream, rec);
+    sd_writer_close(stream->w);
+    omf_free(stream);
+    return ret;
+}
+
 int sd_rec_delete_action(sd_rec_file *rec, unsigned int number) {
     if(rec == NULL || number >= rec->move_count) {
         return SD_INVALID_INPUT;
@@ -304,12 +358,32 @@ int sd_rec_delete_action(sd_rec_file *rec, unsigned int number) {
         memmove(rec->moves + number, rec->moves + number + 1, (rec->move_count - number - 1) * sizeof(sd_rec_move));
     }
 
-    // Resize to save memory
+    // Keep the capacity around, moves are likely to be inserted again.
     rec->move_count--;
-    rec->moves = omf_realloc(rec->moves, rec->move_count * sizeof(sd_rec_move));
     return SD_SUCCESS;
 }
 
+int sd_rec_reserve(sd_rec_file *rec, unsigned int count) {
+    if(rec == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    if(count <= rec->move_capacity) {
+        return SD_SUCCESS;
+    }
+    rec->moves = omf_realloc(rec->moves, count * sizeof(sd_rec_move));
+    rec->move_capacity = count;
+    return SD_SUCCESS;
+}
+
+// Grows the move buffer geometrically, so that appending n moves costs O(n) copies in total.
+static void rec_grow(sd_rec_file *rec) {
+    if(rec->move_count < rec->move_capacity) {
+        return;
+    }
+    unsigned int capacity = rec->move_capacity < REC_MIN_CAPACITY ? REC_MIN_CAPACITY : rec->move_capacity * 2;
+    sd_rec_reserve(rec, capacity);
+}
+
 int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_move *move) {
     if(rec == NULL) {
         return SD_INVALID_INPUT;
@@ -318,8 +392,7 @@ int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_mov
         return SD_INVALID_INPUT;
     }
 
-    // Resize
-    rec->moves = omf_realloc(rec->moves, (rec->move_count + 1) * sizeof(sd_rec_move));
+    rec_grow(rec);
 
     // Only move if we are inserting, not appending
     // when number == move_count-1, we are pushing the last entry forwards by one
@@ -333,6 +406,15 @@ int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_mov
     return SD_SUCCESS;
 }
 
+int sd_rec_append_action(sd_rec_file *rec, const sd_rec_move *move) {
+    if(rec == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    rec_grow(rec);
+    rec->moves[rec->move_count++] = *move;
+    return SD_SUCCESS;
+}
+
 void sd_rec_finish(sd_rec_file *rec, unsigned int ticks) {
     sd_rec_move move;
 
@@ -342,5 +424,5 @@ void sd_rec_finish(sd_rec_file *rec, unsigned int ticks) {
     move.player_id = 0;
     move.action = 0;
 
-    sd_rec_insert_action(rec, rec->move_count, &move);
+    sd_rec_append_action(rec, &move);
 }
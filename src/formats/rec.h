@@ -92,10 +92,19 @@ typedef struct {
 
     int8_t unknown_m; ///< Unknown \todo: Find out
 
-    unsigned int move_count; ///< How many REC event records
-    sd_rec_move *moves;      ///< REC event records list
+    unsigned int move_count;    ///< How many REC event records
+    unsigned int move_capacity; ///< How many REC event records fit in the moves list without reallocating
+    sd_rec_move *moves;         ///< REC event records list
 } sd_rec_file;
 
+/*! \brief Incremental REC writer
+ *
+ * Writes the REC header once, and then appends new event records to the file as they are recorded.
+ * REC files have no record count in the header, so the file on disk is always a valid (possibly
+ * truncated) recording.
+ */
+typedef struct sd_rec_stream sd_rec_stream;
+
 /*! \brief Initialize REC file structure
  *
  * Initializes the REC file structure with empty values.
@@ -156,6 +165,19 @@ int sd_rec_save(sd_rec_file *rec, const char *filename);
  */
 int sd_rec_delete_action(sd_rec_file *rec, unsigned int number);
 
+/*! \brief Reserve space for REC event records
+ *
+ * Makes sure that at least count event records fit in the list without reallocating.
+ * Never shrinks the list.
+ *
+ * \retval SD_INVALID_INPUT rec was NULL.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param rec REC struct pointer.
+ * \param count Number of records to make room for
+ */
+int sd_rec_reserve(sd_rec_file *rec, unsigned int count);
+
 int sd_rec_extra_len(int key);
 
 /*! \brief Inserts a REC event record
@@ -176,8 +198,62 @@ int sd_rec_extra_len(int key);
  */
 int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_move *move);
 
+/*! \brief Appends a REC event record
+ *
+ * Pushes a new event record to the end of the list. The list grows geometrically,
+ * so appending is amortized constant time.
+ *
+ * Event record data will be copied. Make sure to free your local copy yourself.
+ *
+ * \retval SD_INVALID_INPUT rec was NULL.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param rec REC struct pointer.
+ * \param move Move to append
+ */
+int sd_rec_append_action(sd_rec_file *rec, const sd_rec_move *move);
+
 /*! \brief Insert a closing ACT_NONE on a rec at `ticks`
  */
 void sd_rec_finish(sd_rec_file *rec, unsigned int ticks);
 
+/*! \brief Start writing a REC file incrementally
+ *
+ * Opens the file, writes the REC header and all event records currently in the REC.
+ * The header is written only once, so fill it in before opening the stream.
+ *
+ * \return Stream handle, or NULL if the file could not be opened for writing.
+ *
+ * \param rec REC struct pointer.
+ * \param filename Name of the REC file to write into.
+ */
+sd_rec_stream *sd_rec_stream_open(const sd_rec_file *rec, const char *filename);
+
+/*! \brief Write new REC event records to disk
+ *
+ * Appends all event records added since the last flush to the file, and flushes it.
+ * Records that were already written must not be changed or deleted.
+ *
+ * \retval SD_INVALID_INPUT stream or rec was NULL, or written records were deleted.
+ * \retval SD_FILE_WRITE_ERROR File could not be written.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param stream Stream handle
+ * \param rec REC struct pointer.
+ */
+int sd_rec_stream_flush(sd_rec_stream *stream, const sd_rec_file *rec);
+
+/*! \brief Finish an incremental REC file
+ *
+ * Flushes the remaining event records and closes the file. The stream handle is freed.
+ *
+ * \retval SD_INVALID_INPUT stream was NULL.
+ * \retval SD_FILE_WRITE_ERROR File could not be written.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param stream Stream handle
+ * \param rec REC struct pointer.
+ */
+int sd_rec_stream_close(sd_rec_stream *stream, const sd_rec_file *rec);
+
 #endif // SD_REC_H
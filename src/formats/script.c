@@ -4,6 +4,7 @@
 #include "utils/allocator.h"
 #include "utils/str.h"
 #include <ctype.h>
+#include <stdint.h>
 #include <string.h>
 
 #define INVALID_TAG_COUNT 5
@@ -19,11 +20,108 @@ int sd_script_create(sd_script *script) {
 }
 
 void sd_script_frame_create(sd_script_frame *frame, int tick_len, int sprite) {
+    memset(frame, 0, sizeof(sd_script_frame));
     vector_create(&frame->tags, sizeof(sd_script_tag));
+    vector_create_with_size(&frame->tag_values, sizeof(int), 0);
     frame->tick_len = tick_len;
     frame->sprite = sprite;
 }
 
+static int count_bits(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return (int)((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// Position of the tag value in the packed value array; the number of set tags with a smaller id.
+static int tag_rank(const sd_script_frame *frame, int id) {
+    int rank = 0;
+    for(int i = 0; i < id / 32; i++) {
+        rank += count_bits(frame->tag_bits[i]);
+    }
+    return rank + count_bits(frame->tag_bits[id / 32] & ((1u << (id % 32)) - 1));
+}
+
+static inline bool tag_bit(const sd_script_frame *frame, int id) {
+    return (frame->tag_bits[id / 32] >> (id % 32)) & 1;
+}
+
+// Known tags always point to the tag list strings, so there is no need to compare the contents.
+static int tag_id(const sd_script_tag *tag) {
+    for(int i = 0; i < SD_TAG_COUNT; i++) {
+        if(tag->key == sd_taglist[i].tag) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Rebuilds the tag bitset and the packed values from the tag list. If a tag is listed more than once,
+// the first one wins, like with sd_script_get_tag().
+static void sd_script_frame_reindex(sd_script_frame *frame) {
+    iterator it;
+    sd_script_tag *tag;
+    memset(frame->tag_bits, 0, sizeof(frame->tag_bits));
+    vector_iter_begin(&frame->tags, &it);
+    foreach(it, tag) {
+        int id = tag_id(tag);
+        if(id >= 0) {
+            frame->tag_bits[id / 32] |= 1u << (id % 32);
+        }
+    }
+
+    vector_clear(&frame->tag_values);
+    for(int i = 0; i < SD_SCRIPT_TAG_WORDS; i++) {
+        for(int b = 0; b < count_bits(frame->tag_bits[i]); b++) {
+            int zero = 0;
+            vector_append(&frame->tag_values, &zero);
+        }
+    }
+    int *values = (int *)frame->tag_values.data;
+    uint32_t seen[SD_SCRIPT_TAG_WORDS] = {0};
+    vector_iter_begin(&frame->tags, &it);
+    foreach(it, tag) {
+        int id = tag_id(tag);
+        if(id >= 0 && !((seen[id / 32] >> (id % 32)) & 1)) {
+            seen[id / 32] |= 1u << (id % 32);
+            values[tag_rank(frame, id)] = tag->value;
+        }
+    }
+}
+
+// Recalculates the frame start ticks, starting from the given frame.
+static void sd_script_reindex_ticks(sd_script *script, int from) {
+    int pos = 0;
+    sd_script_frame *frame;
+    if(from > 0 && (frame = vector_get(&script->frames, from - 1)) != NULL) {
+        pos = frame->tick_start + frame->tick_len;
+    }
+    for(unsigned i = from; i < vector_size(&script->frames); i++) {
+        frame = vector_get(&script->frames, i);
+        frame->tick_start = pos;
+        pos += frame->tick_len;
+    }
+}
+
+void sd_script_reindex(sd_script *script) {
+    if(script == NULL)
+        return;
+    iterator it;
+    sd_script_frame *frame;
+    vector_iter_begin(&script->frames, &it);
+    foreach(it, frame) {
+        sd_script_frame_reindex(frame);
+    }
+    sd_script_reindex_ticks(script, 0);
+}
+
+// Indexes the frame and appends it to the end of the script. The script takes ownership of the frame.
+static void sd_script_push_frame(sd_script *script, sd_script_frame *frame) {
+    frame->tick_start = sd_script_get_total_ticks(script);
+    sd_script_frame_reindex(frame);
+    vector_append(&script->frames, frame);
+}
+
 int sd_script_frame_clone(sd_script_frame *src, sd_script_frame *dst) {
     iterator it;
     sd_script_tag *tag;
@@ -31,6 +129,13 @@ int sd_script_frame_clone(sd_script_frame *src, sd_script_frame *dst) {
     foreach(it, tag) {
         vector_append(&dst->tags, tag);
     }
+    memcpy(dst->tag_bits, src->tag_bits, sizeof(dst->tag_bits));
+    int *value;
+    vector_iter_begin(&src->tag_values, &it);
+    foreach(it, value) {
+        vector_append(&dst->tag_values, value);
+    }
+    dst->tick_start = src->tick_start;
     return SD_SUCCESS;
 }
 
@@ -52,6 +157,7 @@ void sd_script_frame_free(sd_script_frame *frame) {
     if(frame == NULL)
         return;
     vector_free(&frame->tags);
+    vector_free(&frame->tag_values);
 }
 
 static void sd_script_tag_create(sd_script_tag *tag) {
@@ -68,6 +174,7 @@ bool sd_script_frame_add_tag(sd_script_frame *frame, const char *key, int value)
         tag.value = value;
     }
     vector_append(&frame->tags, &tag);
+    sd_script_frame_reindex(frame);
     return true;
 }
 
@@ -90,7 +197,7 @@ int sd_script_append_frame(sd_script *script, int tick_len, int sprite_id) {
 
     sd_script_frame frame;
     sd_script_frame_create(&frame, tick_len, sprite_id);
-    vector_append(&script->frames, &frame);
+    sd_script_push_frame(script, &frame);
     return SD_SUCCESS;
 }
 
@@ -105,6 +212,7 @@ int sd_script_clear_tags(sd_script *script, int frame_id) {
     }
 
     vector_clear(&frame->tags);
+    sd_script_frame_reindex(frame);
     return SD_SUCCESS;
 }
 
@@ -119,6 +227,7 @@ int sd_script_set_tick_len_at_frame(sd_script *script, int frame_id, int duratio
     }
 
     frame->tick_len = duration;
+    sd_script_reindex_ticks(script, frame_id + 1);
     return SD_SUCCESS;
 }
 
@@ -141,17 +250,18 @@ unsigned sd_script_get_total_ticks(const sd_script *script) {
 }
 
 int sd_script_get_tick_pos_at_frame(const sd_script *script, int frame_id) {
-    if(script == NULL) {
+    if(script == NULL || frame_id <= 0) {
         return 0;
     }
-    int len = 0;
-    sd_script_frame *frame;
-    for(int i = 0; i < frame_id; i++) {
-        if((frame = vector_get(&script->frames, i)) != NULL) {
-            len += frame->tick_len;
-        }
+    const sd_script_frame *frame = vector_get(&script->frames, frame_id);
+    if(frame != NULL) {
+        return frame->tick_start;
     }
-    return len;
+    frame = vector_back(&script->frames);
+    if(frame == NULL) {
+        return 0;
+    }
+    return frame->tick_start + frame->tick_len;
 }
 
 int sd_script_get_tick_len_at_frame(const sd_script *script, int frame_id) {
@@ -339,7 +449,7 @@ int sd_script_decode(sd_script *script, const char *input, int *invalid_pos) {
     int now = 0;
     while(now < (int)str_size(&src)) {
         if(parse_frame(&frame, &src, &now)) {
-            vector_append(&script->frames, &frame);
+            sd_script_push_frame(script, &frame);
             sd_script_frame_create(&frame, 0, 0);
             continue;
         }
@@ -360,7 +470,7 @@ int sd_script_decode(sd_script *script, const char *input, int *invalid_pos) {
         }
         // There are a couple of cases where uppercase frame letter is lowercase. Try to fix.
         if(try_parse_bad_frame(&frame, &src, &now)) {
-            vector_append(&script->frames, &frame);
+            sd_script_push_frame(script, &frame);
             sd_script_frame_create(&frame, 0, 0);
             continue;
         }
@@ -424,25 +534,37 @@ int sd_script_encode_frame(const sd_script_frame *frame, str *dst) {
     return SD_SUCCESS;
 }
 
-const sd_script_frame *sd_script_get_frame_at(const sd_script *script, int ticks) {
-    if(script == NULL)
-        return NULL;
+// Binary search for the frame covering the tick. Zero length frames share their start tick with the
+// following frame, so the last frame starting at or before the tick is the only candidate.
+static int find_frame_index_at(const sd_script *script, int ticks) {
     if(ticks < 0)
-        return NULL;
-
-    iterator it;
-    sd_script_frame *frame;
-    int next, pos = 0;
+        return -1;
 
-    vector_iter_begin(&script->frames, &it);
-    foreach(it, frame) {
-        next = pos + frame->tick_len;
-        if(pos <= ticks && ticks < next) {
-            return frame;
+    const sd_script_frame *frames = (const sd_script_frame *)script->frames.data;
+    int low = 0;
+    int high = (int)vector_size(&script->frames);
+    while(low < high) {
+        int mid = low + (high - low) / 2;
+        if(frames[mid].tick_start <= ticks) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
-        pos = next;
     }
-    return NULL;
+    if(low == 0 || ticks >= frames[low - 1].tick_start + frames[low - 1].tick_len) {
+        return -1;
+    }
+    return low - 1;
+}
+
+const sd_script_frame *sd_script_get_frame_at(const sd_script *script, int ticks) {
+    if(script == NULL)
+        return NULL;
+
+    int index = find_frame_index_at(script, ticks);
+    if(index < 0)
+        return NULL;
+    return vector_get(&script->frames, index);
 }
 
 const sd_script_frame *sd_script_get_frame(const sd_script *script, int frame_number) {
@@ -465,28 +587,21 @@ int sd_script_frame_changed(const sd_script *script, int tick_start, int tick_st
 int sd_script_get_frame_index(const sd_script *script, const sd_script_frame *frame) {
     if(script == NULL || frame == NULL)
         return -1;
-    for(unsigned i = 0; i < vector_size(&script->frames); i++) {
-        if(vector_get(&script->frames, i) == frame) {
-            return i;
-        }
+    uintptr_t start = (uintptr_t)script->frames.data;
+    uintptr_t pos = (uintptr_t)frame;
+    if(pos < start || pos >= start + vector_size(&script->frames) * sizeof(sd_script_frame)) {
+        return -1;
     }
-    return -1;
+    if((pos - start) % sizeof(sd_script_frame) != 0) {
+        return -1;
+    }
+    return (int)((pos - start) / sizeof(sd_script_frame));
 }
 
 int sd_script_get_frame_index_at(const sd_script *script, unsigned ticks) {
-    if(script == NULL)
+    if(script == NULL || ticks > INT32_MAX)
         return -1;
-
-    unsigned next, pos = 0;
-    for(unsigned i = 0; i < vector_size(&script->frames); i++) {
-        sd_script_frame *now = vector_get(&script->frames, i);
-        next = pos + now->tick_len;
-        if(pos <= ticks && ticks < next) {
-            return (int)i;
-        }
-        pos = next;
-    }
-    return -1;
+    return find_frame_index_at(script, (int)ticks);
 }
 
 int sd_script_is_last_frame(const sd_script *script, const sd_script_frame *frame) {
@@ -538,6 +653,20 @@ int sd_script_get(const sd_script_frame *frame, const char *tag) {
     return stag->value;
 }
 
+int sd_script_isset_id(const sd_script_frame *frame, sd_tag_id tag) {
+    if(frame == NULL) {
+        return 0;
+    }
+    return tag_bit(frame, tag);
+}
+
+int sd_script_get_id(const sd_script_frame *frame, sd_tag_id tag) {
+    if(frame == NULL || !tag_bit(frame, tag)) {
+        return 0;
+    }
+    return ((const int *)frame->tag_values.data)[tag_rank(frame, tag)];
+}
+
 int sd_script_next_frame_with_sprite(const sd_script *script, int sprite_id, unsigned current_tick) {
     if(script == NULL)
         return -1;
@@ -546,15 +675,12 @@ int sd_script_next_frame_with_sprite(const sd_script *script, int sprite_id, uns
     if(current_tick > sd_script_get_total_ticks(script))
         return -1;
 
-    unsigned next, pos = 0;
     sd_script_frame *frame;
     for(unsigned i = 0; i < vector_size(&script->frames); i++) {
         frame = vector_get(&script->frames, i);
-        next = pos + frame->tick_len;
-        if(current_tick < pos && sprite_id == frame->sprite) {
+        if(current_tick < (unsigned)frame->tick_start && sprite_id == frame->sprite) {
             return (int)i;
         }
-        pos = next;
     }
 
     return -1;
@@ -566,15 +692,29 @@ int sd_script_next_frame_with_tag(const sd_script *script, const char *tag, uint
     if(current_tick > sd_script_get_total_ticks(script))
         return -1;
 
-    unsigned next, pos = 0;
     sd_script_frame *frame;
     for(unsigned i = 0; i < vector_size(&script->frames); i++) {
         frame = vector_get(&script->frames, i);
-        next = pos + frame->tick_len;
-        if(current_tick < pos && sd_script_isset(frame, tag)) {
+        if(current_tick < (unsigned)frame->tick_start && sd_script_isset(frame, tag)) {
+            return (int)i;
+        }
+    }
+
+    return -1;
+}
+
+int sd_script_next_frame_with_tag_id(const sd_script *script, sd_tag_id tag, uint32_t current_tick) {
+    if(script == NULL)
+        return -1;
+    if(current_tick > sd_script_get_total_ticks(script))
+        return -1;
+
+    sd_script_frame *frame;
+    for(unsigned i = 0; i < vector_size(&script->frames); i++) {
+        frame = vector_get(&script->frames, i);
+        if(current_tick < (unsigned)frame->tick_start && tag_bit(frame, tag)) {
             return (int)i;
         }
-        pos = next;
     }
 
     return -1;
@@ -595,6 +735,7 @@ int sd_script_delete_tag(sd_script *script, int frame_id, const char *tag) {
     foreach(it, now) {
         if(strcmp(now->key, tag) == 0) {
             vector_delete(&frame->tags, &it);
+            sd_script_frame_reindex(frame);
             return SD_SUCCESS;
         }
     }
@@ -623,6 +764,7 @@ int sd_script_set_tag(sd_script *script, int frame_id, const char *tag, int valu
     // Delete old tag (if exists), then add new.
     sd_script_delete_tag(script, frame_id, tag);
     vector_append(&frame->tags, &new);
+    sd_script_frame_reindex(frame);
     return SD_SUCCESS;
 }
 
@@ -27,14 +27,22 @@ typedef struct sd_script_tag {
     int value;        ///< Tag parameter value. Only valid if has_param = 1.
 } sd_script_tag;
 
+#define SD_SCRIPT_TAG_WORDS ((SD_TAG_COUNT + 31) / 32)
+
 /*! \brief Animation frame
  *
- * Describes a single frame in animation string.
+ * Describes a single frame in animation string. Besides the tag list, the frame keeps an index of
+ * the known tags it contains: a bitset by tag id, and the tag values packed in tag id order. The index
+ * and the tick position are kept up to date by the script functions; if the tags or tick lengths are
+ * modified directly, sd_script_reindex() must be called afterwards.
  */
 typedef struct sd_script_frame {
-    int sprite;   ///< Sprite ID that the frame relates to
-    int tick_len; ///< Length of the frame in ticks
-    vector tags;  ///< A list of tags in this frame
+    int sprite;                             ///< Sprite ID that the frame relates to
+    int tick_len;                           ///< Length of the frame in ticks
+    int tick_start;                         ///< Tick position at the start of the frame
+    vector tags;                            ///< A list of tags in this frame
+    uint32_t tag_bits[SD_SCRIPT_TAG_WORDS]; ///< Known tags set in this frame, by sd_tag_id
+    vector tag_values;                      ///< Values of the set known tags, in sd_tag_id order
 } sd_script_frame;
 
 /*! \brief Animation script
@@ -57,8 +65,26 @@ typedef struct sd_script {
  */
 int sd_script_create(sd_script *script);
 
+/*! \brief Copy script
+ *
+ * Creates a deep copy of the script. Destination struct must not be initialized.
+ *
+ * \retval SD_SUCCESS Success.
+ *
+ * \param src Script to copy
+ * \param dst Target script struct
+ */
 int sd_script_clone(sd_script *src, sd_script *dst);
 
+/*! \brief Rebuild the script lookup indexes
+ *
+ * Recalculates the frame tick positions and the frame tag indexes. This is only required if the
+ * frames or tags have been modified directly instead of through the script functions.
+ *
+ * \param script Script to reindex
+ */
+void sd_script_reindex(sd_script *script);
+
 /*! \brief Free script parser
  *
  * Frees up all memory reserved by the script parser structure.
@@ -293,6 +319,28 @@ int sd_script_is_first_frame_at(const sd_script *script, int ticks);
  */
 int sd_script_isset(const sd_script_frame *frame, const char *tag);
 
+/*! \brief Tells if the tag is set in frame
+ *
+ * Same as sd_script_isset(), but looks the tag up by id from the frame tag index.
+ * NULL frame is accepted, and returns 0.
+ *
+ * \param frame The frame structure to inspect
+ * \param tag Tag id to find
+ * \return 1 or 0
+ */
+int sd_script_isset_id(const sd_script_frame *frame, sd_tag_id tag);
+
+/*! \brief Returns the tag value in frame
+ *
+ * Same as sd_script_get(), but looks the tag up by id from the frame tag index.
+ * NULL frame is accepted, and returns 0.
+ *
+ * \param frame The frame structure to inspect
+ * \param tag Tag id to find
+ * \return Tag parameter value or 0.
+ */
+int sd_script_get_id(const sd_script_frame *frame, sd_tag_id tag);
+
 /*! \brief Returns the tag value in frame
  *
  * Returns the parameter value of a tag in a given frame. Note that if the tag doesn't
@@ -341,6 +389,17 @@ int sd_script_next_frame_with_sprite(const sd_script *script, int sprite_id, uns
  */
 int sd_script_next_frame_with_tag(const sd_script *script, const char *tag, uint32_t current_tick);
 
+/*! \brief Returns the next frame number with a given tag id
+ *
+ * Same as sd_script_next_frame_with_tag(), but looks the tag up by id.
+ *
+ * \param script Script structure to search through
+ * \param tag Tag id to search for
+ * \param current_tick Current tick time
+ * \return Frame ID or -1 on error
+ */
+int sd_script_next_frame_with_tag_id(const sd_script *script, sd_tag_id tag, uint32_t current_tick);
+
 /*! \brief Sets a tag for the given frame
  *
  * Sets the tag for the given frame. If the tag has not been set previously, a new tag
@@ -45,7 +45,13 @@ void sd_sprite_free(sd_sprite *sprite) {
     // Only attempt to free if there IS something to free
     // AND sprite data belongs to this sprite
     if(sprite->data != NULL && !sprite->missing) {
-        omf_free(sprite->data);
+        if(sprite->source != NULL) {
+            sd_reader_release(sprite->source);
+            sprite->source = NULL;
+            sprite->data = NULL;
+        } else {
+            omf_free(sprite->data);
+        }
     }
 }
 
@@ -58,10 +64,17 @@ int sd_sprite_load(sd_reader *r, sd_sprite *sprite) {
     sprite->index = sd_read_ubyte(r);
     sprite->missing = sd_read_ubyte(r);
 
-    // Copy sprite data, if there is any.
+    // Copy sprite data, if there is any. Shared readers let us point to the file data directly.
+    sprite->source = NULL;
     if(sprite->missing == 0 && sprite->len != 0) {
-        sprite->data = omf_calloc(1, sprite->len);
-        sd_read_buf(r, sprite->data, sprite->len);
+        const char *ref;
+        if(sd_reader_is_shared(r) && (ref = sd_read_ref(r, sprite->len)) != NULL) {
+            sprite->data = (char *)ref;
+            sprite->source = sd_reader_retain(r);
+        } else {
+            sprite->data = omf_calloc(1, sprite->len);
+            sd_read_buf(r, sprite->data, sprite->len);
+        }
     } else {
         sprite->data = NULL;
     }
@@ -191,19 +204,72 @@ int sd_sprite_rgba_encode(sd_sprite *dst, const sd_rgba_image *src, const vga_pa
     dst->height = src->h;
     dst->len = i;
     dst->missing = 0;
+    dst->source = NULL;
     dst->data = omf_calloc(i, 1);
     memcpy(dst->data, buf, i);
     omf_free(buf);
     return ret;
 }
 
+/**
+ * Walks the sprite RLE data and copies each pixel run to dst. With an RGBA table, dst is an RGBA image and
+ * the pixels are looked up from the table; otherwise dst is a VGA image and the runs are copied as is.
+ *
+ * Every run is checked against the input length and the image size once, before it is copied.
+ */
+static int sprite_decode_runs(unsigned char *dst, const sd_sprite *src, const uint8_t (*rgba)[4]) {
+    const uint8_t *data = (const uint8_t *)src->data;
+    const size_t len = src->len;
+    const size_t size = (size_t)src->width * src->height;
+    size_t i = 0;
+    size_t x = 0;
+    size_t y = 0;
+
+    while(i < len) {
+        // read a word
+        if(len - i < 2) {
+            return SD_INVALID_INPUT;
+        }
+        uint16_t c = data[i] | (data[i + 1] << 8);
+        uint16_t arg = c >> 2;
+        i += 2;
+
+        switch(c & 3) {
+            case 0:
+                x = arg;
+                break;
+            case 2:
+                y = arg;
+                break;
+            case 1: {
+                size_t pos = y * src->width + x;
+                if(arg > len - i || (arg > 0 && pos + arg > size)) {
+                    return SD_INVALID_INPUT;
+                }
+                if(rgba == NULL) {
+                    memcpy(dst + pos, data + i, arg);
+                } else {
+                    unsigned char *out = dst + pos * 4;
+                    for(size_t k = 0; k < arg; k++) {
+                        memcpy(out + k * 4, rgba[data[i + k]], 4);
+                    }
+                }
+                i += arg;
+                x = 0;
+                break;
+            }
+            case 3:
+                if(i != len) {
+                    return SD_INVALID_INPUT;
+                }
+                break;
+        }
+    }
+    return SD_SUCCESS;
+}
+
 int sd_sprite_rgba_decode(sd_rgba_image *dst, const sd_sprite *src, const vga_palette *pal) {
-    uint16_t x = 0;
-    uint16_t y = 0;
-    int i = 0;
-    uint16_t c = 0;
-    uint16_t data = 0;
-    char op = 0;
+    uint8_t rgba[256][4];
 
     // Make sure we aren't being fed BS
     if(src == NULL || dst == NULL || pal == NULL) {
@@ -222,56 +288,19 @@ int sd_sprite_rgba_decode(sd_rgba_image *dst, const sd_sprite *src, const vga_pa
         return SD_SUCCESS;
     }
 
-    // Walk through sprite raw data
-    while(i < src->len) {
-        // read a word
-        c = (uint8_t)src->data[i] + ((uint8_t)src->data[i + 1] << 8);
-        op = c % 4;
-        data = c / 4;
-        i += 2; // we read 2 bytes
-
-        // Handle operation
-        switch(op) {
-            case 0:
-                x = data;
-                break;
-            case 2:
-                y = data;
-                break;
-            case 1:
-                while(data > 0) {
-                    uint8_t b = src->data[i];
-                    int pos = ((y * src->width) + x) * 4;
-                    dst->data[pos + 0] = (uint8_t)pal->colors[b].r;
-                    dst->data[pos + 1] = (uint8_t)pal->colors[b].g;
-                    dst->data[pos + 2] = (uint8_t)pal->colors[b].b;
-                    dst->data[pos + 3] = (uint8_t)255; // fully opaque
-                    i++;                               // we read 1 byte
-                    x++;
-                    data--;
-                }
-                x = 0;
-                break;
-            case 3:
-                if(i != src->len) {
-                    return SD_INVALID_INPUT;
-                }
-                break;
-        }
+    // Look up whole pixels instead of separate color channels.
+    for(int k = 0; k < 256; k++) {
+        rgba[k][0] = (uint8_t)pal->colors[k].r;
+        rgba[k][1] = (uint8_t)pal->colors[k].g;
+        rgba[k][2] = (uint8_t)pal->colors[k].b;
+        rgba[k][3] = (uint8_t)255; // fully opaque
     }
 
-    // All done. dst should now contain a valid RGBA image.
-    return SD_SUCCESS;
+    // dst should now contain a valid RGBA image.
+    return sprite_decode_runs((unsigned char *)dst->data, src, (const uint8_t(*)[4])rgba);
 }
 
 int sd_sprite_vga_decode(sd_vga_image *dst, const sd_sprite *src) {
-    uint16_t x = 0;
-    uint16_t y = 0;
-    int i = 0;
-    uint16_t c = 0;
-    uint16_t data = 0;
-    char op = 0;
-
     // Make sure we aren't being fed BS
     if(dst == NULL || src == NULL) {
         return SD_INVALID_INPUT;
@@ -289,43 +318,8 @@ int sd_sprite_vga_decode(sd_vga_image *dst, const sd_sprite *src) {
         return SD_SUCCESS;
     }
 
-    // Walk through raw sprite data
-    while(i < src->len) {
-        // read a word
-        c = (uint8_t)src->data[i] + ((uint8_t)src->data[i + 1] << 8);
-        op = c % 4;
-        data = c / 4;
-        i += 2; // we read 2 bytes
-
-        // Handle operation
-        switch(op) {
-            case 0:
-                x = data;
-                break;
-            case 2:
-                y = data;
-                break;
-            case 1:
-                while(data > 0) {
-                    uint8_t b = src->data[i];
-                    int pos = ((y * src->width) + x);
-                    dst->data[pos] = b;
-                    i++; // we read 1 byte
-                    x++;
-                    data--;
-                }
-                x = 0;
-                break;
-            case 3:
-                if(i != src->len) {
-                    return SD_INVALID_INPUT;
-                }
-                break;
-        }
-    }
-
-    // All done. dst should now contain a valid vga image.
-    return SD_SUCCESS;
+    // dst should now contain a valid vga image.
+    return sprite_decode_runs((unsigned char *)dst->data, src, NULL);
 }
 
 int sd_sprite_vga_encode(sd_sprite *dst, const sd_vga_image *src) {
@@ -344,9 +338,10 @@ int sd_sprite_vga_encode(sd_sprite *dst, const sd_vga_image *src) {
         return SD_INVALID_INPUT;
     }
 
-    // allocate a buffer plenty big enough, we will trim it later
+    // allocate a buffer plenty big enough, we will trim it later. A lone pixel may take a y word, an x word,
+    // a run word and the pixel itself; the y=0 word and the end marker come on top of that.
     vga_size = src->w * src->h;
-    buf = omf_calloc(4, vga_size);
+    buf = omf_calloc(8, vga_size + 1);
 
     // always initialize Y to 0
     buf[i++] = 2;
@@ -411,6 +406,7 @@ int sd_sprite_vga_encode(sd_sprite *dst, const sd_vga_image *src) {
     dst->height = src->h;
     dst->len = i;
     dst->missing = 0;
+    dst->source = NULL;
     dst->data = omf_calloc(i, 1);
     memcpy(dst->data, buf, i);
     omf_free(buf);
@@ -25,14 +25,15 @@
  * "invisible" pixels it has.
  */
 typedef struct {
-    int16_t pos_x;   ///< Position of sprite, X-axis
-    int16_t pos_y;   ///< Position of sprite, Y-axis
-    uint8_t index;   ///< Sprite index
-    uint8_t missing; ///< Is sprite data missing? If this is 1, then data points to the data of another sprite.
-    uint16_t width;  ///< Pixel width of the sprite
-    uint16_t height; ///< Pixel height of the sprite
-    uint16_t len;    ///< Byte length of the packed sprite data
-    char *data;      ///< Packed sprite data
+    int16_t pos_x;          ///< Position of sprite, X-axis
+    int16_t pos_y;          ///< Position of sprite, Y-axis
+    uint8_t index;          ///< Sprite index
+    uint8_t missing;        ///< Is sprite data missing? If this is 1, then data points to the data of another sprite.
+    uint16_t width;         ///< Pixel width of the sprite
+    uint16_t height;        ///< Pixel height of the sprite
+    uint16_t len;           ///< Byte length of the packed sprite data
+    char *data;             ///< Packed sprite data
+    sd_reader_data *source; ///< If set, data is borrowed from the file data of a shared reader. Do not modify it.
 } sd_sprite;
 
 /*! \brief Initialize sprite structure
@@ -93,7 +94,7 @@ int sd_sprite_rgba_encode(sd_sprite *dst, const sd_rgba_image *src, const vga_pa
  * already created by using sd_rgba_image_create() previously, there may
  * potentially be a memory leak, since the old image internals will not be freed.
  *
- * \retval SD_INVALID_INPUT Dst, src or palette was NULL.
+ * \retval SD_INVALID_INPUT Dst, src or palette was NULL, or the sprite data is malformed.
  * \retval SD_SUCCESS Success.
  *
  * \param dst Destination RGBA image struct pointer.
@@ -110,7 +111,7 @@ int sd_sprite_rgba_decode(sd_rgba_image *dst, const sd_sprite *src, const vga_pa
  * already created by using sd_vga_image_create() previously, there may
  * potentially be a memory leak, since the old image internals will not be freed.
  *
- * \retval SD_INVALID_INPUT Dst or src was NULL.
+ * \retval SD_INVALID_INPUT Dst or src was NULL, or the sprite data is malformed.
  * \retval SD_SUCCESS Success.
  *
  * \param dst Destination VGA image struct pointer.
@@ -1,4 +1,5 @@
 #include "formats/taglist.h"
+#include <assert.h>
 
 // This file is generated automatically
 
@@ -158,3 +159,5 @@ const sd_tag sd_taglist[] = {
 };
 
 const int sd_taglist_size = 152;
+
+static_assert(sizeof(sd_taglist) / sizeof(sd_taglist[0]) == SD_TAG_COUNT, "sd_tag_id must match sd_taglist");
@@ -133,27 +133,20 @@ static void parse_tournament_description(sd_tournament_locale *locale) {
     }
 }
 
-int sd_tournament_load(sd_tournament_file *trn, const char *filename) {
-    int ret = SD_FILE_PARSE_ERROR;
-    if(trn == NULL || filename == NULL) {
-        return SD_INVALID_INPUT;
-    }
-
-    sd_reader *r = sd_reader_open(filename);
-    if(!r) {
-        return SD_FILE_OPEN_ERROR;
-    }
-
+/**
+ * Reads the fixed size header at the start of the file.
+ */
+static int load_header(sd_reader *r, sd_tournament_file *trn, const char *filename, int *victory_text_offset) {
     // Make sure that the file looks at least relatively okay
     // TODO: Add other checks.
     if(sd_reader_filesize(r) < 1582) {
-        goto error_0;
+        return SD_FILE_PARSE_ERROR;
     }
 
     // Read enemy count and make sure it seems somwhat correct
     uint32_t enemy_count = sd_read_udword(r);
     if(enemy_count >= MAX_TRN_ENEMIES || enemy_count == 0) {
-        goto error_0;
+        return SD_FILE_PARSE_ERROR;
     }
 
     char *justfile = strrchr(filename, pm_path_sep);
@@ -165,13 +158,50 @@ int sd_tournament_load(sd_tournament_file *trn, const char *filename) {
     trn->enemy_count = enemy_count;
 
     // Read tournament data
-    int victory_text_offset = sd_read_dword(r);
+    *victory_text_offset = sd_read_dword(r);
     sd_read_buf(r, trn->bk_name, 14);
     trn->winnings_multiplier = sd_read_float(r);
     trn->unknown_a = sd_read_dword(r);
     trn->registration_fee = sd_read_dword(r);
     trn->assumed_initial_value = sd_read_dword(r);
     trn->tournament_id = sd_read_dword(r);
+    if(!sd_reader_ok(r)) {
+        return SD_FILE_PARSE_ERROR;
+    }
+    return SD_SUCCESS;
+}
+
+int sd_tournament_load_header(sd_tournament_file *trn, const char *filename) {
+    if(trn == NULL || filename == NULL) {
+        return SD_INVALID_INPUT;
+    }
+
+    sd_reader *r = sd_reader_open(filename);
+    if(!r) {
+        return SD_FILE_OPEN_ERROR;
+    }
+
+    int victory_text_offset;
+    int ret = load_header(r, trn, filename, &victory_text_offset);
+    sd_reader_close(r);
+    return ret;
+}
+
+int sd_tournament_load(sd_tournament_file *trn, const char *filename) {
+    int ret = SD_FILE_PARSE_ERROR;
+    if(trn == NULL || filename == NULL) {
+        return SD_INVALID_INPUT;
+    }
+
+    sd_reader *r = sd_reader_open(filename);
+    if(!r) {
+        return SD_FILE_OPEN_ERROR;
+    }
+
+    int victory_text_offset;
+    if(load_header(r, trn, filename, &victory_text_offset) != SD_SUCCESS) {
+        goto error_0;
+    }
 
     // Read enemy block offsets
     sd_reader_set(r, 300);
@@ -100,6 +100,22 @@ int sd_tournament_create(sd_tournament_file *trn);
  */
 int sd_tournament_load(sd_tournament_file *trn, const char *filename);
 
+/*! \brief Load the header of a .TRN file
+ *
+ * Loads only the fixed size header of the tournament: filename, enemy count, BK name, winnings
+ * multiplier, registration fee, assumed initial value and tournament ID. Enemies, locales, the
+ * palette and the PIC filename are left empty. Use this to list tournaments without parsing the
+ * whole file.
+ *
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_PARSE_ERROR File does not contain valid data.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param trn Tournament structure pointer.
+ * \param filename Name of the tournament file.
+ */
+int sd_tournament_load_header(sd_tournament_file *trn, const char *filename);
+
 /*! \brief Save TRN file
  *
  * Saves the given TRN file from memory to a file on disk. The structure must be at
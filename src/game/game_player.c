@@ -1,4 +1,5 @@
 #include "game/game_player.h"
+#include "game/utils/state_hash.h"
 #include "utils/allocator.h"
 #include <stdlib.h>
 
@@ -90,6 +91,51 @@ void game_player_clone(game_player *src, game_player *dst) {
     har_screencaps_clone(&src->screencaps, &dst->screencaps);
 }
 
+void game_player_serialize(const game_player *gp, serial *ser) {
+    serial_write_uint32(ser, gp->har_obj_id);
+    serial_write_int32(ser, gp->selectable);
+    serial_write_int32(ser, gp->god);
+    serial_write_int32(ser, gp->ez_destruct);
+    serial_write_int32(ser, gp->sp_wins);
+    chr_score_serialize(&gp->score, ser);
+}
+
+// Controller, pilot, portrait and screencaps are not part of the snapshot and are left as they are.
+void game_player_unserialize(game_player *gp, serial *ser) {
+    gp->har_obj_id = serial_read_uint32(ser);
+    gp->selectable = serial_read_int32(ser);
+    gp->god = serial_read_int32(ser);
+    gp->ez_destruct = serial_read_int32(ser);
+    gp->sp_wins = serial_read_int32(ser);
+    chr_score_unserialize(&gp->score, ser);
+}
+
+// The HAR object id is left out, peers number their objects differently.
+void game_player_hash(const game_player *gp, state_hash *h) {
+    if(gp->pilot != NULL) {
+        const sd_pilot *p = gp->pilot;
+        state_hash_int(h, "pilot_id", p->pilot_id);
+        state_hash_int(h, "har_id", p->har_id);
+        state_hash_int(h, "power", p->power);
+        state_hash_int(h, "agility", p->agility);
+        state_hash_int(h, "endurance", p->endurance);
+        state_hash_int(h, "arm_power", p->arm_power);
+        state_hash_int(h, "leg_power", p->leg_power);
+        state_hash_int(h, "arm_speed", p->arm_speed);
+        state_hash_int(h, "leg_speed", p->leg_speed);
+        state_hash_int(h, "armor", p->armor);
+        state_hash_int(h, "stun_resistance", p->stun_resistance);
+    }
+    const chr_score *score = &gp->score;
+    state_hash_int(h, "score", score->score);
+    state_hash_int(h, "rounds", score->rounds);
+    state_hash_int(h, "wins", score->wins);
+    state_hash_int(h, "consecutive_hits", score->consecutive_hits);
+    state_hash_int(h, "consecutive_hit_score", score->consecutive_hit_score);
+    state_hash_int(h, "combo_hits", score->combo_hits);
+    state_hash_int(h, "combo_hit_score", score->combo_hit_score);
+}
+
 int game_player_clone_free(game_player *gp) {
     chr_score_free(&gp->score);
     har_screencaps_free(&gp->screencaps);
@@ -14,6 +14,8 @@
 #include "game/utils/score.h"
 #include "video/surface.h"
 
+typedef struct state_hash state_hash;
+
 typedef struct game_player_t {
     uint32_t har_obj_id;
     controller *ctrl;
@@ -44,5 +46,8 @@ void game_player_set_pilot(game_player *gp, sd_pilot *new_pilot);
 chr_score *game_player_get_score(game_player *gp);
 void game_player_clone(game_player *src, game_player *dst);
 int game_player_clone_free(game_player *gp);
+void game_player_serialize(const game_player *gp, serial *ser);
+void game_player_unserialize(game_player *gp, serial *ser);
+void game_player_hash(const game_player *gp, state_hash *h);
 
 #endif // GAME_PLAYER_H
@@ -23,6 +23,7 @@
 #include "game/scenes/vs.h"
 #include "game/utils/serial.h"
 #include "game/utils/settings.h"
+#include "game/utils/state_hash.h"
 #include "game/utils/ticktimer.h"
 #include "resources/pilots.h"
 #include "resources/sounds_loader.h"
@@ -52,23 +53,9 @@ static void _setup_rec_controller(game_state *gs, int player_id, sd_rec_file *re
 // Used for crossfades
 #define FRAME_WAIT_TICKS 30
 
-typedef struct {
-    int layer;      ///< Object rendering layer
-    int persistent; ///< 1 if the object should keep alive across scene boundaries
-    int singleton;  ///< 1 if object should be the only representative of its animation ID
-    object *obj;
-} render_obj;
-
-typedef struct {
-    int tick;
-    int id;
-    int length;
-    int duration;
-    float volume;
-    float panning;
-    float pitch;
-    int playback_id;
-} playing_sound;
+// Room for more sounds than can play at once in every state, so that restoring a snapshot does not need
+// to grow the sound list
+#define GAME_STATE_SOUNDS_RESERVED 64
 
 // reset the match settings to use all the settings. This is essentially 1/2 player mode & demo mode
 void game_state_match_settings_reset(game_state *gs) {
@@ -120,7 +107,11 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
     gs->clone = false;
     game_state_match_settings_reset(gs);
     vector_create(&gs->objects, sizeof(render_obj));
-    vector_create(&gs->sounds, sizeof(playing_sound));
+    object_index_create(&gs->obj_index);
+    vector_create_with_size(&gs->sounds, sizeof(playing_sound), GAME_STATE_SOUNDS_RESERVED);
+    memset(gs->graveyard, 0, sizeof(gs->graveyard));
+    gs->graveyard_next = 0;
+    gs->keep_deleted = false;
 
     // For screen shake
     gs->screen_shake_horizontal = 0;
@@ -139,6 +130,7 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
 
     gs->hide_ui = false;
     gs->menu_ctrl = omf_calloc(1, sizeof(controller));
+    controller_init(gs->menu_ctrl, gs);
 
     // Set up players
     gs->sc = omf_calloc(1, sizeof(scene));
@@ -243,10 +235,75 @@ error_1:
 error_0:
     omf_free(gs->sc);
     vector_free(&gs->objects);
+    object_index_free(&gs->obj_index);
     vector_free(&gs->sounds);
     return 1;
 }
 
+// Frees an object that was taken out of the game state. Cloned states free their objects the clone way.
+static void game_state_free_object(game_state *gs, object *obj) {
+    if(gs->clone) {
+        object_clone_free(obj);
+    } else {
+        object_free(obj);
+    }
+    omf_free(obj);
+}
+
+// Keeps a deleted object intact in the graveyard, freeing the oldest one there if it is full. Returns false
+// if the object should be freed instead: the graveyard is off, or the object is never part of a snapshot.
+static bool game_state_bury_object(game_state *gs, object *obj) {
+    if(!gs->keep_deleted || obj->cur_animation_own == OWNER_OBJECT) {
+        return false;
+    }
+    object **slot = &gs->graveyard[gs->graveyard_next];
+    if(*slot != NULL) {
+        game_state_free_object(gs, *slot);
+    }
+    *slot = obj;
+    gs->graveyard_next = (gs->graveyard_next + 1) % GAME_STATE_GRAVEYARD_SIZE;
+    return true;
+}
+
+// Takes the object with the given id back out of the graveyard, or returns NULL if it is not there.
+static object *game_state_exhume_object(game_state *gs, uint32_t id) {
+    for(int i = 0; i < GAME_STATE_GRAVEYARD_SIZE; i++) {
+        object *obj = gs->graveyard[i];
+        if(obj != NULL && obj->id == id) {
+            gs->graveyard[i] = NULL;
+            return obj;
+        }
+    }
+    return NULL;
+}
+
+static void game_state_clear_graveyard(game_state *gs) {
+    for(int i = 0; i < GAME_STATE_GRAVEYARD_SIZE; i++) {
+        if(gs->graveyard[i] != NULL) {
+            game_state_free_object(gs, gs->graveyard[i]);
+            gs->graveyard[i] = NULL;
+        }
+    }
+    gs->graveyard_next = 0;
+}
+
+void game_state_set_keep_deleted(game_state *gs, bool keep) {
+    gs->keep_deleted = keep;
+    if(!keep) {
+        game_state_clear_graveyard(gs);
+    }
+}
+
+// Drops the object at the iterator position from the object list and the id index, and frees or buries it.
+static void game_state_remove_object(game_state *gs, iterator *it, render_obj *robj) {
+    object_index_remove(&gs->obj_index, robj->obj->id);
+    if(!game_state_bury_object(gs, robj->obj)) {
+        object_free(robj->obj);
+        omf_free(robj->obj);
+    }
+    vector_delete(&gs->objects, it);
+}
+
 /*
  * \param game_state gs Game state object
  * \param obj Object to add
@@ -273,6 +330,7 @@ int game_state_add_object(game_state *gs, object *obj, int layer, int singleton,
         }
     }
     vector_append(&gs->objects, &o);
+    object_index_set(&gs->obj_index, obj->id, obj);
 
 #ifdef DEBUGMODE_STFU
     animation *ani = object_get_animation(obj);
@@ -308,9 +366,7 @@ void game_state_del_animation(game_state *gs, int anim_id) {
     foreach(it, robj) {
         animation *ani = object_get_animation(robj->obj);
         if(ani != NULL && ani->id == anim_id) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, &it, robj);
             log_debug("Deleted animation %i from game_state.", anim_id);
             return;
         }
@@ -324,9 +380,7 @@ void game_state_del_object(game_state *gs, object *target) {
     vector_iter_begin(&gs->objects, &it);
     foreach(it, robj) {
         if(target == robj->obj) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, &it, robj);
             return;
         }
     }
@@ -338,9 +392,7 @@ void game_state_del_object_by_id(game_state *gs, uint32_t target) {
     vector_iter_begin(&gs->objects, &it);
     foreach(it, robj) {
         if(target == robj->obj->id) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, &it, robj);
             return;
         }
     }
@@ -363,11 +415,22 @@ void game_state_clear_objects(game_state *gs, int mask) {
     vector_iter_begin(&gs->objects, &it);
     foreach(it, robj) {
         if(object_get_group(robj->obj) & mask) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, &it, robj);
+        }
+    }
+}
+
+void game_state_clear_scene_objects(game_state *gs) {
+    iterator it;
+    render_obj *robj;
+    vector_iter_begin(&gs->objects, &it);
+    foreach(it, robj) {
+        if(!robj->persistent) {
+            game_state_remove_object(gs, &it, robj);
         }
     }
+    // Snapshots never reach back past a scene change
+    game_state_clear_graveyard(gs);
 }
 
 void game_state_set_next(game_state *gs, unsigned int next_scene_id) {
@@ -542,16 +605,7 @@ int game_load_new(game_state *gs, int scene_id) {
     omf_free(gs->sc);
 
     // Remove old objects
-    render_obj *robj;
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    foreach(it, robj) {
-        if(!robj->persistent) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
-        }
-    }
+    game_state_clear_scene_objects(gs);
 
     // Free texture items, we are going to create new ones.
     video_signal_scene_change();
@@ -665,12 +719,18 @@ void game_state_call_collide(game_state *gs) {
     unsigned int size = vector_size(&gs->objects);
     for(unsigned i = 0; i < size; i++) {
         a = ((render_obj *)vector_get(&gs->objects, i))->obj;
+        // Only the first object of a pair gets its collide callback called, so objects without
+        // one (scrap, effects, etc.) can never start a collision. Pair order is left untouched.
+        if(a->collide == NULL) {
+            continue;
+        }
         for(unsigned k = i + 1; k < size; k++) {
             b = ((render_obj *)vector_get(&gs->objects, k))->obj;
+            if(!(a->layers & b->layers)) {
+                continue;
+            }
             if(a->group != b->group || a->group == GROUP_UNKNOWN || b->group == GROUP_UNKNOWN) {
-                if(a->layers & b->layers) {
-                    object_collide(a, b);
-                }
+                object_collide(a, b);
             }
         }
     }
@@ -683,9 +743,7 @@ void game_state_cleanup(game_state *gs) {
     foreach(it, robj) {
         if(object_finished(robj->obj)) {
             /*log_debug("Animation object %d is finished, removing.", robj->obj->cur_animation->id);*/
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, &it, robj);
         }
     }
 }
@@ -721,6 +779,8 @@ void game_state_dyntick_controllers(game_state *gs) {
 }
 
 void game_state_ctrl_events_free(game_state *gs) {
+    controller_free_chain(gs->menu_ctrl->extra_events);
+    gs->menu_ctrl->extra_events = NULL;
     for(int i = 0; i < game_state_num_players(gs); i++) {
         game_player *gp = game_state_get_player(gs, i);
         controller *c = game_player_get_ctrl(gp);
@@ -1111,7 +1171,9 @@ void game_state_clone_free(game_state *gs) {
         omf_free(robj->obj);
         vector_delete(&gs->objects, &it);
     }
+    game_state_clear_graveyard(gs);
     vector_free(&gs->objects);
+    object_index_free(&gs->obj_index);
     vector_free(&gs->sounds);
 
     // Free scene
@@ -1140,13 +1202,19 @@ void game_state_free(game_state **_gs) {
         omf_free(robj->obj);
         vector_delete(&gs->objects, &it);
     }
+    game_state_clear_graveyard(gs);
     vector_free(&gs->objects);
+    object_index_free(&gs->obj_index);
     vector_free(&gs->sounds);
 
     // Free scene
     scene_free(gs->sc);
     omf_free(gs->sc);
 
+    if(gs->rec_stream) {
+        sd_rec_stream_close(gs->rec_stream, gs->rec);
+        gs->rec_stream = NULL;
+    }
     if(gs->rec) {
         sd_rec_free(gs->rec);
         omf_free(gs->rec);
@@ -1183,20 +1251,13 @@ int game_state_ms_per_dyntick(game_state *gs) {
 
 int render_obj_clone(render_obj *src, render_obj *dst, game_state *gs) {
     memcpy(dst, src, sizeof(render_obj));
+    gs->clone_struct_bytes += sizeof(render_obj);
     dst->obj = omf_calloc(1, sizeof(object));
     return object_clone(src->obj, dst->obj, gs);
 }
 
 object *game_state_find_object(game_state *gs, uint32_t object_id) {
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    render_obj *robj;
-    foreach(it, robj) {
-        if(robj->obj->id == object_id) {
-            return robj->obj;
-        }
-    }
-    return NULL;
+    return object_index_get(&gs->obj_index, object_id);
 }
 
 void game_state_play_sound(game_state *gs, int id, float volume, float panning, float pitch) {
@@ -1229,7 +1290,7 @@ void game_state_play_sound(game_state *gs, int id, float volume, float panning,
         // do not actually begin playback if this is a cloned game state
         // cloned game states that are promoted to the active game state
         // will have this flag removed
-        s.playback_id = audio_play_sound_buf(src_buf, src_len, volume, panning, pitch, 0);
+        s.playback_id = audio_play_sound(id, volume, panning, pitch);
         if(s.playback_id == -1) {
             // don't track sounds that failed to play
             return;
@@ -1239,12 +1300,27 @@ void game_state_play_sound(game_state *gs, int id, float volume, float panning,
     vector_append(&gs->sounds, &s);
 }
 
+// Rebuilds the id index from the object list.
+static void game_state_index_objects(game_state *gs) {
+    object_index_clear(&gs->obj_index);
+    iterator it;
+    render_obj *robj;
+    vector_iter_begin(&gs->objects, &it);
+    foreach(it, robj) {
+        object_index_set(&gs->obj_index, robj->obj->id, robj->obj);
+    }
+}
+
 int game_state_clone(game_state *src, game_state *dst) {
     // copy all the static fields
     memcpy(dst, src, sizeof(game_state));
+    dst->clone_struct_bytes = sizeof(game_state);
     // fix any pointers to volatile data
-    vector_create(&dst->objects, sizeof(render_obj));
-    vector_create(&dst->sounds, sizeof(playing_sound));
+    vector_create_with_size(&dst->objects, sizeof(render_obj), vector_size(&src->objects));
+    object_index_create(&dst->obj_index);
+    vector_create_with_size(&dst->sounds, sizeof(playing_sound), GAME_STATE_SOUNDS_RESERVED);
+    memset(dst->graveyard, 0, sizeof(dst->graveyard));
+    dst->graveyard_next = 0;
 
     dst->next_wait_ticks = 0;
     dst->this_wait_ticks = 0;
@@ -1257,22 +1333,26 @@ int game_state_clone(game_state *src, game_state *dst) {
         render_obj_clone(robj, &d, dst);
         vector_append(&dst->objects, &d);
     }
+    game_state_index_objects(dst);
 
     vector_iter_begin(&src->sounds, &it);
     playing_sound *s;
     while((s = iter_next(&it)) != NULL) {
         vector_append(&dst->sounds, s);
     }
+    dst->clone_struct_bytes += vector_size(&dst->sounds) * sizeof(playing_sound);
 
     for(int i = 0; i < 2; i++) {
         dst->players[i] = omf_calloc(1, sizeof(game_player));
         game_player_clone(src->players[i], dst->players[i]);
+        dst->clone_struct_bytes += sizeof(game_player);
         // update HAR object pointers
         // dst->players[i]->har_obj_id = src->players[i]->har_obj_id;
     }
 
     dst->sc = omf_calloc(1, sizeof(scene));
     scene_clone(src->sc, dst->sc, dst);
+    dst->clone_struct_bytes += sizeof(scene);
 
     dst->new_state = NULL;
 
@@ -1281,6 +1361,305 @@ int game_state_clone(game_state *src, game_state *dst) {
     return 0;
 }
 
+static void match_settings_serialize(const match_settings *m, serial *ser) {
+    serial_write_int8(ser, m->throw_range);
+    serial_write_int8(ser, m->hit_pause);
+    serial_write_int8(ser, m->block_damage);
+    serial_write_int8(ser, m->vitality);
+    serial_write_int8(ser, m->jump_height);
+    serial_write_int8(ser, m->knock_down);
+    serial_write_int8(ser, m->rehit);
+    serial_write_int8(ser, m->defensive_throws);
+    serial_write_int8(ser, m->power1);
+    serial_write_int8(ser, m->power2);
+    serial_write_int8(ser, m->hazards);
+    serial_write_int8(ser, m->rounds);
+    serial_write_int8(ser, m->fight_mode);
+}
+
+static void match_settings_unserialize(match_settings *m, serial *ser) {
+    m->throw_range = serial_read_int8(ser);
+    m->hit_pause = serial_read_int8(ser);
+    m->block_damage = serial_read_int8(ser);
+    m->vitality = serial_read_int8(ser);
+    m->jump_height = serial_read_int8(ser);
+    m->knock_down = serial_read_int8(ser);
+    m->rehit = serial_read_int8(ser);
+    m->defensive_throws = serial_read_int8(ser);
+    m->power1 = serial_read_int8(ser);
+    m->power2 = serial_read_int8(ser);
+    m->hazards = serial_read_int8(ser);
+    m->rounds = serial_read_int8(ser);
+    m->fight_mode = serial_read_int8(ser);
+}
+
+static void fight_stats_serialize(const fight_stats *f, serial *ser) {
+    serial_write_int32(ser, f->winner);
+    serial_write_uint32(ser, f->plug_text);
+    serial_write(ser, f->sold, sizeof(f->sold));
+    serial_write_int32(ser, f->winnings);
+    serial_write_int32(ser, f->bonuses);
+    serial_write_int32(ser, f->repair_cost);
+    serial_write_int32(ser, f->profit);
+    for(int i = 0; i < 2; i++) {
+        serial_write_uint32(ser, f->hits_landed[i]);
+        serial_write_float(ser, f->average_damage[i]);
+        serial_write_uint32(ser, f->total_attacks[i]);
+        serial_write_uint32(ser, f->hit_miss_ratio[i]);
+    }
+}
+
+static void fight_stats_unserialize(fight_stats *f, serial *ser) {
+    f->winner = serial_read_int32(ser);
+    f->plug_text = serial_read_uint32(ser);
+    serial_read(ser, f->sold, sizeof(f->sold));
+    f->winnings = serial_read_int32(ser);
+    f->bonuses = serial_read_int32(ser);
+    f->repair_cost = serial_read_int32(ser);
+    f->profit = serial_read_int32(ser);
+    for(int i = 0; i < 2; i++) {
+        f->hits_landed[i] = serial_read_uint32(ser);
+        f->average_damage[i] = serial_read_float(ser);
+        f->total_attacks[i] = serial_read_uint32(ser);
+        f->hit_miss_ratio[i] = serial_read_uint32(ser);
+    }
+}
+
+/*
+ * Writes the simulation state into a snapshot buffer, field by field. Whatever belongs to the game state
+ * instance (the object and sound storage, the players, the recording, the net controller delay, and the
+ * run, pause and UI flags) is not part of the snapshot, so restoring one never touches it.
+ */
+void game_state_serialize(const game_state *gs, serial *ser) {
+    serial_write_uint32(ser, gs->this_id);
+    serial_write_uint32(ser, gs->next_id);
+    serial_write_uint32(ser, gs->next_next_id);
+    serial_write_uint32(ser, gs->tick);
+    serial_write_uint32(ser, gs->int_tick);
+    serial_write_uint32(ser, gs->speed);
+    match_settings_serialize(&gs->match_settings, ser);
+    serial_write_int32(ser, gs->screen_shake_horizontal);
+    serial_write_int32(ser, gs->screen_shake_vertical);
+    serial_write_int32(ser, gs->speed_slowdown_previous);
+    serial_write_int32(ser, gs->speed_slowdown_time);
+    fight_stats_serialize(&gs->fight_stats, ser);
+    serial_write_uint32(ser, gs->rand.seed);
+
+    uint32_t count = vector_size(&gs->sounds);
+    serial_write_uint32(ser, count);
+    for(uint32_t i = 0; i < count; i++) {
+        const playing_sound *s = vector_get(&gs->sounds, i);
+        serial_write_int32(ser, s->tick);
+        serial_write_int32(ser, s->id);
+        serial_write_int32(ser, s->length);
+        serial_write_int32(ser, s->duration);
+        serial_write_float(ser, s->volume);
+        serial_write_float(ser, s->panning);
+        serial_write_float(ser, s->pitch);
+        serial_write_int32(ser, s->playback_id);
+    }
+
+    for(int i = 0; i < 2; i++) {
+        game_player_serialize(gs->players[i], ser);
+    }
+    scene_serialize(gs->sc, ser);
+
+    // Objects owning their animation (HAR trails) are cosmetic and are left out. Reserve the
+    // count and fill it in once we know how many objects made it in.
+    size_t count_pos = ser->wpos;
+    serial_write_uint32(ser, 0);
+    count = 0;
+    iterator it;
+    render_obj *robj;
+    vector_iter_begin(&gs->objects, &it);
+    foreach(it, robj) {
+        if(robj->obj->cur_animation_own == OWNER_OBJECT) {
+            continue;
+        }
+        serial_write_uint32(ser, robj->obj->id);
+        serial_write_int32(ser, robj->layer);
+        serial_write_int32(ser, robj->persistent);
+        serial_write_int32(ser, robj->singleton);
+        object_serialize(robj->obj, ser);
+        count++;
+    }
+    size_t end_pos = ser->wpos;
+    ser->wpos = count_pos;
+    serial_write_uint32(ser, count);
+    ser->wpos = end_pos;
+}
+
+enum
+{
+    HASH_HAR,
+    HASH_PROJECTILE,
+    HASH_HAZARD,
+    HASH_SCRAP,
+    HASH_ANNOUNCEMENT,
+    HASH_OBJECT,
+    HASH_SECTION_COUNT
+};
+
+static const char *hash_section_names[HASH_SECTION_COUNT] = {"har",   "projectile",   "hazard",
+                                                             "scrap", "announcement", "object"};
+
+static int hash_section(const object *obj) {
+    switch(obj->group) {
+        case GROUP_HAR:
+            return HASH_HAR;
+        case GROUP_PROJECTILE:
+            return HASH_PROJECTILE;
+        case GROUP_HAZARD:
+            return HASH_HAZARD;
+        case GROUP_SCRAP:
+            return HASH_SCRAP;
+        case GROUP_ANNOUNCEMENT:
+            return HASH_ANNOUNCEMENT;
+        default:
+            return HASH_OBJECT;
+    }
+}
+
+void game_state_hash(game_state *gs, state_hash *h) {
+    // Ticks are left out, since peers count them from a different start.
+    state_hash_begin(h, "game", 0, true);
+    state_hash_int(h, "rand", random_get_seed(&gs->rand));
+    state_hash_int(h, "speed", gs->speed);
+    state_hash_int(h, "screen_shake_h", gs->screen_shake_horizontal);
+    state_hash_int(h, "screen_shake_v", gs->screen_shake_vertical);
+    state_hash_int(h, "slowdown_previous", gs->speed_slowdown_previous);
+    state_hash_int(h, "slowdown_time", gs->speed_slowdown_time);
+
+    // The global RNG is not synchronised between peers; scrap and a few cosmetics draw from it.
+    state_hash_begin(h, "global", 0, false);
+    state_hash_int(h, "rand", rand_get_seed());
+
+    for(int i = 0; i < 2; i++) {
+        state_hash_begin(h, "player", i, true);
+        game_player_hash(gs->players[i], h);
+    }
+    if(gs->sc != NULL) {
+        state_hash_begin(h, "scene", 0, true);
+        scene_hash(gs->sc, h);
+    }
+
+    unsigned int counts[HASH_SECTION_COUNT] = {0};
+    iterator it;
+    render_obj *robj;
+    vector_iter_begin(&gs->objects, &it);
+    foreach(it, robj) {
+        object *obj = robj->obj;
+        if(obj->cur_animation_own == OWNER_OBJECT) {
+            continue;
+        }
+        int section = hash_section(obj);
+        state_hash_begin(h, hash_section_names[section], counts[section]++, section != HASH_SCRAP);
+        object_hash(obj, h);
+    }
+}
+
+static render_obj *game_state_swap_objects(game_state *gs, unsigned int a, unsigned int b) {
+    render_obj *ra = vector_get(&gs->objects, a);
+    if(a != b) {
+        render_obj *rb = vector_get(&gs->objects, b);
+        render_obj tmp = *ra;
+        *ra = *rb;
+        *rb = tmp;
+    }
+    return ra;
+}
+
+// Find the object with the given id at or after index start, and move it to index start.
+static render_obj *game_state_claim_object(game_state *gs, unsigned int start, uint32_t id) {
+    for(unsigned int i = start; i < vector_size(&gs->objects); i++) {
+        render_obj *robj = vector_get(&gs->objects, i);
+        if(robj->obj->id == id) {
+            return game_state_swap_objects(gs, start, i);
+        }
+    }
+    return NULL;
+}
+
+int game_state_unserialize(game_state *gs, serial *ser) {
+    gs->this_id = serial_read_uint32(ser);
+    gs->next_id = serial_read_uint32(ser);
+    gs->next_next_id = serial_read_uint32(ser);
+    gs->tick = serial_read_uint32(ser);
+    gs->int_tick = serial_read_uint32(ser);
+    gs->speed = serial_read_uint32(ser);
+    match_settings_unserialize(&gs->match_settings, ser);
+    gs->screen_shake_horizontal = serial_read_int32(ser);
+    gs->screen_shake_vertical = serial_read_int32(ser);
+    gs->speed_slowdown_previous = serial_read_int32(ser);
+    gs->speed_slowdown_time = serial_read_int32(ser);
+    fight_stats_unserialize(&gs->fight_stats, ser);
+    random_seed(&gs->rand, serial_read_uint32(ser));
+
+    uint32_t count = serial_read_uint32(ser);
+    vector_clear(&gs->sounds);
+    for(uint32_t i = 0; i < count; i++) {
+        playing_sound s;
+        s.tick = serial_read_int32(ser);
+        s.id = serial_read_int32(ser);
+        s.length = serial_read_int32(ser);
+        s.duration = serial_read_int32(ser);
+        s.volume = serial_read_float(ser);
+        s.panning = serial_read_float(ser);
+        s.pitch = serial_read_float(ser);
+        s.playback_id = serial_read_int32(ser);
+        vector_append(&gs->sounds, &s);
+    }
+
+    for(int i = 0; i < 2; i++) {
+        game_player_unserialize(gs->players[i], ser);
+    }
+    scene_unserialize(gs->sc, ser);
+
+    // Objects are matched by id and restored in place. Objects deleted since the snapshot was taken are
+    // brought back from the graveyard, so nothing needs to be allocated unless this state never had the
+    // object or it fell out of the graveyard. The snapshot order is preserved.
+    count = serial_read_uint32(ser);
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t id = serial_read_uint32(ser);
+        render_obj *robj = game_state_claim_object(gs, i, id);
+        if(robj == NULL) {
+            render_obj fresh;
+            fresh.obj = game_state_exhume_object(gs, id);
+            if(fresh.obj == NULL) {
+                fresh.obj = omf_calloc(1, sizeof(object));
+                fresh.obj->id = id;
+            }
+            vector_append(&gs->objects, &fresh);
+            robj = game_state_swap_objects(gs, i, vector_size(&gs->objects) - 1);
+        }
+        robj->layer = serial_read_int32(ser);
+        robj->persistent = serial_read_int32(ser);
+        robj->singleton = serial_read_int32(ser);
+        object_unserialize(robj->obj, ser, gs);
+    }
+
+    // Anything left over did not exist at the time of the snapshot. HAR trails are kept as they are.
+    unsigned int keep = count;
+    for(unsigned int i = count; i < vector_size(&gs->objects); i++) {
+        render_obj *robj = vector_get(&gs->objects, i);
+        if(robj->obj->cur_animation_own == OWNER_OBJECT) {
+            vector_set(&gs->objects, keep++, robj);
+        } else if(!game_state_bury_object(gs, robj->obj)) {
+            game_state_free_object(gs, robj->obj);
+        }
+    }
+    while(vector_size(&gs->objects) > keep) {
+        vector_pop(&gs->objects);
+    }
+
+    game_state_index_objects(gs);
+    for(uint32_t i = 0; i < count; i++) {
+        render_obj *robj = vector_get(&gs->objects, i);
+        player_link_userdata(robj->obj);
+    }
+    return 0;
+}
+
 bool is_netplay(game_state *gs) {
     return game_state_get_player(gs, 0)->ctrl->type == CTRL_TYPE_NETWORK ||
            game_state_get_player(gs, 1)->ctrl->type == CTRL_TYPE_NETWORK;
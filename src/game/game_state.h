@@ -12,6 +12,25 @@ typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct object_t object;
 typedef struct ctrl_event_t ctrl_event;
+typedef struct state_hash state_hash;
+
+typedef struct {
+    int layer;      ///< Object rendering layer
+    int persistent; ///< 1 if the object should keep alive across scene boundaries
+    int singleton;  ///< 1 if object should be the only representative of its animation ID
+    object *obj;
+} render_obj;
+
+typedef struct {
+    int tick;
+    int id;
+    int length;
+    int duration;
+    float volume;
+    float panning;
+    float pitch;
+    int playback_id;
+} playing_sound;
 
 void game_state_match_settings_reset(game_state *gs);
 void game_state_match_settings_defaults(game_state *gs);
@@ -24,6 +43,7 @@ void game_state_debug(game_state *gs);
 void game_state_static_tick(game_state *gs, bool replay);
 void game_state_dynamic_tick(game_state *gs, bool replay);
 void game_state_tick_controllers(game_state *gs);
+void game_state_call_collide(game_state *gs);
 unsigned int game_state_get_tick(game_state *gs);
 scene *game_state_get_scene(game_state *gs);
 unsigned int game_state_is_running(game_state *gs);
@@ -40,9 +60,24 @@ object *game_state_find_object(game_state *gs, uint32_t object_id);
 
 // used to play sounds that may be subject to rollback (eg sounds from player.c, HAR and arena)
 void game_state_play_sound(game_state *gs, int id, float volume, float panning, float pitch);
+void game_state_merge_sounds(game_state *old, game_state *new);
 
 int game_state_clone(game_state *src, game_state *dst);
 void game_state_clone_free(game_state *gs);
+void game_state_serialize(const game_state *gs, serial *ser);
+int game_state_unserialize(game_state *gs, serial *ser);
+
+/**
+ * Keeps the most recently deleted objects intact instead of freeing them, so that restoring a snapshot into
+ * this state can bring them back without allocating. Turning it off frees the kept objects.
+ */
+void game_state_set_keep_deleted(game_state *gs, bool keep);
+
+/**
+ * Feeds the gameplay state into a state hash: the game state, both players, the scene and every object.
+ * HAR trails are left out like in snapshots, and scrap is hashed as a section that is not synced.
+ */
+void game_state_hash(game_state *gs, state_hash *h);
 
 void _setup_keyboard(game_state *gs, int player_id);
 void _setup_ai(game_state *gs, int player_id);
@@ -64,6 +99,7 @@ void game_state_del_object(game_state *gs, object *obj);
 void game_state_del_animation(game_state *gs, int anim_id);
 void game_state_get_projectiles(game_state *gs, vector *obj_proj);
 void game_state_clear_objects(game_state *gs, int mask);
+void game_state_clear_scene_objects(game_state *gs);
 
 bool is_netplay(game_state *gs);
 bool is_singleplayer(game_state *gs);
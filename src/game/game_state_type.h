@@ -2,10 +2,12 @@
 #define GAME_STATE_TYPE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "engine.h"
 #include "formats/rec.h"
 #include "game/protos/fight_stats.h"
+#include "game/utils/object_index.h"
 #include "game/utils/settings.h"
 #include "utils/random.h"
 #include "utils/vector.h"
@@ -31,6 +33,9 @@ enum
     NET_MODE_LOBBY
 };
 
+// How many deleted objects a game state can keep around for snapshot restores, see game_state_set_keep_deleted()
+#define GAME_STATE_GRAVEYARD_SIZE 64
+
 typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct ticktimer_t ticktimer;
@@ -88,16 +93,26 @@ typedef struct game_state_t {
     int net_mode; // NET_MODE_NONE, NET_MODE_CLIENT, NET_MODE_SERVER
     scene *sc;
     vector objects;
+    object_index obj_index; // objects by id
     vector sounds;
     game_player *players[2];
 
+    // Recently deleted objects, oldest first from graveyard_next. Only used with keep_deleted set.
+    object *graveyard[GAME_STATE_GRAVEYARD_SIZE];
+    unsigned int graveyard_next;
+    bool keep_deleted;
+
     fight_stats fight_stats;
     void *new_state;
     bool clone;
+    // Total size of the structs game_state_clone() copied to create this state. Buffers they own, such as
+    // vectors, hashmaps and strings, are not counted.
+    size_t clone_struct_bytes;
     int delay;
     struct random_t rand;
 
     sd_rec_file *rec;
+    sd_rec_stream *rec_stream; // Writes the recording to disk while the match is running
 
     controller *menu_ctrl;
 } game_state;
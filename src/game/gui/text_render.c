@@ -2,10 +2,52 @@
 #include <math.h>
 
 #include "game/gui/text_render.h"
+#include "utils/allocator.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
 #include "video/video.h"
 
+#define LAYOUT_CACHE_SETS 64
+#define LAYOUT_CACHE_WAYS 4
+
+typedef struct text_glyph {
+    const surface *sur;
+    int x;
+    int y;
+} text_glyph;
+
+// Settings that decide where the glyphs go. Colors and shadows only matter when drawing.
+typedef struct text_layout_key {
+    text_valign valign;
+    text_halign halign;
+    text_padding padding;
+    text_direction direction;
+    font_size font;
+    uint8_t cspacing;
+    uint8_t lspacing;
+    uint8_t max_lines;
+    bool strip_leading_whitespace;
+    bool strip_trailing_whitespace;
+    int w;
+    int h;
+} text_layout_key;
+
+typedef struct text_layout {
+    uint32_t hash;
+    text_layout_key key;
+    char *text; // NULL if the slot is free
+    int len;
+    text_glyph *glyphs;
+    int glyph_count;
+    unsigned int last_used;
+} text_layout;
+
+// Set associative cache of text layouts, so that line breaking is not done again on every frame.
+static text_layout layout_cache[LAYOUT_CACHE_SETS][LAYOUT_CACHE_WAYS];
+static unsigned int layout_clock = 0;
+static unsigned int layout_fonts_generation = 0; // fonts_generation() the cached glyphs belong to
+static text_cache_stats layout_stats;
+
 void text_defaults(text_settings *settings) {
     memset(settings, 0, sizeof(text_settings));
     settings->cforeground = 0xFD;
@@ -154,8 +196,13 @@ int text_find_line_count(const text_settings *settings, int cols, int rows, int
     return lines;
 }
 
-static void text_render_len(const text_settings *settings, text_mode mode, int x, int y, int w, int h, const char *text,
-                            int len) {
+/**
+ * Finds the position of each glyph in the text box, relative to the top left corner of the box.
+ * Returns the number of glyphs; glyphs must have room for len entries.
+ */
+static int text_layout_glyphs(const text_settings *settings, int w, int h, const char *text, int len,
+                              text_glyph *glyphs) {
+    int glyph_count = 0;
     int size = text_char_width(settings);
     int x_space = w - settings->padding.left - settings->padding.right;
     int y_space = h - settings->padding.top - settings->padding.bottom;
@@ -167,12 +214,12 @@ static void text_render_len(const text_settings *settings, text_mode mode, int x
     int fit_lines = text_find_line_count(settings, cols, rows, len, text, &longest);
     int max_chars = settings->direction == TEXT_HORIZONTAL ? cols : rows;
     if(max_chars == 0) {
-        log_debug("Warning: Text has zero size! text: '%s'");
+        log_debug("Warning: Text has zero size! text: '%s'", text);
         max_chars = 1;
     }
 
-    int start_x = x + settings->padding.left;
-    int start_y = y + settings->padding.top;
+    int start_x = settings->padding.left;
+    int start_y = settings->padding.top;
     int tmp_s = 0;
 
     // Initial alignment for whole text block
@@ -293,8 +340,10 @@ static void text_render_len(const text_settings *settings, text_mode mode, int x
                 continue;
             }
 
-            render_char_shadow_surface(settings, sur, mx + start_x, my + start_y);
-            render_char_surface(settings, mode, sur, mx + start_x, my + start_y);
+            glyphs[glyph_count].sur = sur;
+            glyphs[glyph_count].x = mx + start_x;
+            glyphs[glyph_count].y = my + start_y;
+            glyph_count++;
 
             // Render to the right direction
             if(settings->direction == TEXT_HORIZONTAL) {
@@ -307,6 +356,109 @@ static void text_render_len(const text_settings *settings, text_mode mode, int x
         ptr += advance;
         line++;
     }
+    return glyph_count;
+}
+
+static void make_layout_key(text_layout_key *key, const text_settings *settings, int w, int h) {
+    // Clear the padding bytes too, keys are hashed and compared as raw memory.
+    memset(key, 0, sizeof(text_layout_key));
+    key->valign = settings->valign;
+    key->halign = settings->halign;
+    key->padding = settings->padding;
+    key->direction = settings->direction;
+    key->font = settings->font;
+    key->cspacing = settings->cspacing;
+    key->lspacing = settings->lspacing;
+    key->max_lines = settings->max_lines;
+    key->strip_leading_whitespace = settings->strip_leading_whitespace;
+    key->strip_trailing_whitespace = settings->strip_trailing_whitespace;
+    key->w = w;
+    key->h = h;
+}
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t len) {
+    const unsigned char *bytes = data;
+    for(size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void free_layout(text_layout *layout) {
+    omf_free(layout->text);
+    omf_free(layout->glyphs);
+    layout->glyph_count = 0;
+}
+
+/**
+ * Returns the cached layout for the text in the box, computing it if needed.
+ */
+static const text_layout *get_layout(const text_settings *settings, int w, int h, const char *text, int len) {
+    // Layouts point at glyph surfaces, drop them all when the fonts are reloaded or freed
+    if(layout_fonts_generation != fonts_generation()) {
+        text_render_cache_clear();
+        layout_fonts_generation = fonts_generation();
+    }
+
+    text_layout_key key;
+    make_layout_key(&key, settings, w, h);
+    uint32_t hash = hash_bytes(hash_bytes(2166136261u, &key, sizeof(key)), text, len);
+    text_layout *set = layout_cache[hash % LAYOUT_CACHE_SETS];
+    text_layout *victim = &set[0];
+    layout_clock++;
+    for(int i = 0; i < LAYOUT_CACHE_WAYS; i++) {
+        text_layout *layout = &set[i];
+        if(layout->text != NULL && layout->hash == hash && layout->len == len &&
+           memcmp(&layout->key, &key, sizeof(key)) == 0 && memcmp(layout->text, text, len) == 0) {
+            layout->last_used = layout_clock;
+            layout_stats.hits++;
+            return layout;
+        }
+        if(victim->text != NULL && (layout->text == NULL || layout->last_used < victim->last_used)) {
+            victim = layout;
+        }
+    }
+
+    layout_stats.misses++;
+    if(victim->text != NULL) {
+        layout_stats.evictions++;
+    }
+    free_layout(victim);
+    victim->hash = hash;
+    victim->key = key;
+    victim->len = len;
+    victim->text = omf_malloc(len);
+    memcpy(victim->text, text, len);
+    victim->glyphs = omf_malloc(len * sizeof(text_glyph));
+    victim->glyph_count = text_layout_glyphs(settings, w, h, text, len, victim->glyphs);
+    victim->last_used = layout_clock;
+    return victim;
+}
+
+void text_render_cache_clear(void) {
+    for(int i = 0; i < LAYOUT_CACHE_SETS; i++) {
+        for(int k = 0; k < LAYOUT_CACHE_WAYS; k++) {
+            free_layout(&layout_cache[i][k]);
+        }
+    }
+}
+
+void text_render_cache_stats(text_cache_stats *stats) {
+    *stats = layout_stats;
+}
+
+static void text_render_len(const text_settings *settings, text_mode mode, int x, int y, int w, int h, const char *text,
+                            int len) {
+    if(len <= 0) {
+        return;
+    }
+    const text_layout *layout = get_layout(settings, w, h, text, len);
+    for(int i = 0; i < layout->glyph_count; i++) {
+        const text_glyph *glyph = &layout->glyphs[i];
+        render_char_shadow_surface(settings, glyph->sur, x + glyph->x, y + glyph->y);
+        render_char_surface(settings, mode, glyph->sur, x + glyph->x, y + glyph->y);
+    }
 }
 
 void text_render(const text_settings *settings, text_mode mode, int x, int y, int w, int h, const char *text) {
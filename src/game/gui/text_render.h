@@ -90,4 +90,21 @@ int text_char_width(const text_settings *settings);
 int text_width(const text_settings *settings, const char *text);
 int text_width_limit(const text_settings *settings, const char *text, int limit);
 
+/**
+ * Text layouts are cached by text, layout settings and box size. The cache drops its layouts by itself when the
+ * fonts are reloaded; this frees them right away.
+ */
+void text_render_cache_clear(void);
+
+typedef struct text_cache_stats {
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions; // misses that replaced another layout
+} text_cache_stats;
+
+/**
+ * Layout cache counters since startup.
+ */
+void text_render_cache_stats(text_cache_stats *stats);
+
 #endif // TEXT_RENDER_H
@@ -16,7 +16,9 @@
 // Local small gauge type
 typedef struct trnselect {
     sprite *img;
-    list *tournaments;
+    list *tournaments; // Header fields only
+    sd_tournament_file current;
+    bool current_loaded;
     component *label;
     int max;
     int selected;
@@ -25,7 +27,9 @@ typedef struct trnselect {
 static void trnselect_render(component *c) {
     trnselect *g = widget_get_obj(c);
 
-    video_draw(g->img->data, c->x + g->img->pos.x, c->y + g->img->pos.y);
+    if(g->img->data != NULL) {
+        video_draw(g->img->data, c->x + g->img->pos.x, c->y + g->img->pos.y);
+    }
     if(g->label) {
         component_render(g->label);
     }
@@ -60,11 +64,60 @@ static void load_description(component **c, const sd_tournament_locale *locale)
     component_layout(*c, x, locale->desc_vmove, locale->desc_width, 130 - locale->desc_vmove);
 }
 
+static void free_current(trnselect *local) {
+    if(local->current_loaded) {
+        sd_tournament_free(&local->current);
+        local->current_loaded = false;
+    }
+}
+
+static void delete_entry(trnselect *local, int index) {
+    iterator it;
+    list_iter_begin(local->tournaments, &it);
+    for(int i = 0; iter_next(&it) != NULL; i++) {
+        if(i == index) {
+            list_delete(local->tournaments, &it);
+            break;
+        }
+    }
+    local->max = list_size(local->tournaments);
+    if(local->selected >= local->max) {
+        local->selected = 0;
+    }
+}
+
+/**
+ * Fully loads the selected tournament, and shows its logo and description. Tournaments that fail to
+ * load are dropped from the list.
+ */
+static void show_selected(trnselect *local) {
+    free_current(local);
+    while(local->max > 0) {
+        sd_tournament_file *entry = list_get(local->tournaments, local->selected);
+        if(trn_load(&local->current, entry->filename) == 0) {
+            break;
+        }
+        delete_entry(local, local->selected);
+    }
+    if(local->max == 0) {
+        return;
+    }
+    local->current_loaded = true;
+
+    sd_tournament_file *trn = &local->current;
+    sd_sprite *logo = trn->locales[0]->logo;
+    vga_state_set_base_palette_from_range(&trn->pal, 128, 128, 40);
+    load_description(&local->label, trn->locales[0]);
+    sprite_free(local->img);
+    sprite_create(local->img, logo, -1);
+}
+
 static void trnselect_free(component *c) {
     trnselect *g = widget_get_obj(c);
     vga_state_pop_palette(); // Recover previous palette
     sprite_free(g->img);
     omf_free(g->img);
+    free_current(g);
     list_free(g->tournaments);
     omf_free(g->tournaments);
     component_free(g->label);
@@ -77,12 +130,7 @@ void trnselect_next(component *c) {
     if(local->selected >= local->max) {
         local->selected = 0;
     }
-    sd_tournament_file *trn = list_get(local->tournaments, local->selected);
-    sd_sprite *logo = trn->locales[0]->logo;
-    vga_state_set_base_palette_from_range(&trn->pal, 128, 128, 40);
-    load_description(&local->label, trn->locales[0]);
-    sprite_free(local->img);
-    sprite_create(local->img, logo, -1);
+    show_selected(local);
 }
 
 void trnselect_prev(component *c) {
@@ -91,17 +139,15 @@ void trnselect_prev(component *c) {
     if(local->selected < 0) {
         local->selected = local->max - 1;
     }
-    sd_tournament_file *trn = list_get(local->tournaments, local->selected);
-    sd_sprite *logo = trn->locales[0]->logo;
-    vga_state_set_base_palette_from_range(&trn->pal, 128, 128, 40);
-    load_description(&local->label, trn->locales[0]);
-    sprite_free(local->img);
-    sprite_create(local->img, logo, -1);
+    show_selected(local);
 }
 
 sd_tournament_file *trnselect_selected(component *c) {
     trnselect *local = widget_get_obj(c);
-    return list_get(local->tournaments, local->selected);
+    if(!local->current_loaded) {
+        return NULL;
+    }
+    return &local->current;
 }
 
 component *trnselect_create(void) {
@@ -121,12 +167,7 @@ component *trnselect_create(void) {
 
     vga_state_push_palette(); // Backup the current palette
 
-    sd_tournament_file *trn = list_get(local->tournaments, local->selected);
-    sd_sprite *logo = trn->locales[0]->logo;
-    vga_state_set_base_palette_from_range(&trn->pal, 128, 128, 40);
-    load_description(&local->label, trn->locales[0]);
-
-    sprite_create(local->img, logo, -1);
+    show_selected(local);
 
     // Set callbacks
     widget_set_obj(c, local);
@@ -8,6 +8,9 @@ component *trnselect_create(void);
 int trnselect_get_pilot_count(component *c, int pic_id);
 void trnselect_next(component *c);
 void trnselect_prev(component *c);
+/**
+ * Returns the selected tournament, or NULL if none of the tournaments could be loaded.
+ */
 sd_tournament_file *trnselect_selected(component *c);
 
 #endif // TRNSELECT_H
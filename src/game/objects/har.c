@@ -15,6 +15,7 @@
 #include "game/protos/intersect.h"
 #include "game/scenes/arena.h"
 #include "game/utils/serial.h"
+#include "game/utils/state_hash.h"
 #include "resources/af_loader.h"
 #include "resources/animation.h"
 #include "resources/pilots.h"
@@ -26,7 +27,7 @@
 #include "video/vga_state.h"
 #include "video/video.h"
 
-#define IS_ZERO(n) (n < 0.8 && n > -0.8)
+#define IS_ZERO(n) (n < phys_from_float(0.8f) && n > phys_from_float(-0.8f))
 
 void har_finished(object *obj);
 int har_act(object *obj, int act_type);
@@ -303,9 +304,9 @@ void har_walk_to(object *obj, int destination) {
 
     h->walk_done_anim = obj->cur_animation->id;
 
-    float vx = h->fwd_speed * object_get_direction(obj);
-    log_debug("set velocity to %f", vx);
-    object_set_vel(obj, vec2f_create(vx, 0));
+    phys vx = h->fwd_speed * object_get_direction(obj);
+    log_debug("set velocity to %f", phys_to_float(vx));
+    obj->vel = vec2p_create(vx, 0);
 
     object_set_animation(obj, &move->ani);
     object_set_repeat(obj, 1);
@@ -345,34 +346,34 @@ int har_is_blocking(har *h, af_move *move) {
 }
 
 int har_is_invincible(object *obj, af_move *move) {
-    if(player_frame_isset(obj, "zz")) {
+    if(player_frame_isset(obj, SD_TAG_ZZ)) {
         // blocks everything
         return 1;
     }
     switch(move->category) {
         // XX 'zg' is not handled here, but the game doesn't use it...
         case CAT_LOW:
-            if(player_frame_isset(obj, "zl")) {
+            if(player_frame_isset(obj, SD_TAG_ZL)) {
                 return 1;
             }
             break;
         case CAT_MEDIUM:
-            if(player_frame_isset(obj, "zm")) {
+            if(player_frame_isset(obj, SD_TAG_ZM)) {
                 return 1;
             }
             break;
         case CAT_HIGH:
-            if(player_frame_isset(obj, "zh")) {
+            if(player_frame_isset(obj, SD_TAG_ZH)) {
                 return 1;
             }
             break;
         case CAT_JUMPING:
-            if(player_frame_isset(obj, "zj")) {
+            if(player_frame_isset(obj, SD_TAG_ZJ)) {
                 return 1;
             }
             break;
         case CAT_PROJECTILE:
-            if(player_frame_isset(obj, "zp")) {
+            if(player_frame_isset(obj, SD_TAG_ZP)) {
                 return 1;
             }
             break;
@@ -448,16 +449,18 @@ void har_floor_landing_effects(object *obj) {
     int amount = rand_int(2) + 1;
     for(int i = 0; i < amount; i++) {
         int variance = rand_int(20) - 10;
-        vec2i coord = vec2i_create(obj->pos.x + variance + i * 10, obj->pos.y);
+        vec2i coord = vec2i_create(phys_to_int(obj->pos.x) + variance + i * 10, phys_to_int(obj->pos.y));
         object *dust = omf_calloc(1, sizeof(object));
         object_create(dust, obj->gs, coord, vec2f_create(0, 0));
         object_set_stl(dust, object_get_stl(obj));
         object_set_animation(dust, &bk_get_info(game_state_get_scene(obj->gs)->bk_data, 26)->ani);
+        // Placed with the unsynchronised RNG, so keep it with the scrap out of the synced state hash
+        object_set_group(dust, GROUP_SCRAP);
         game_state_add_object(obj->gs, dust, RENDER_LAYER_MIDDLE, 0, 0);
     }
 
     // Landing sound
-    float d = ((float)obj->pos.x) / 640.0f;
+    float d = phys_to_float(obj->pos.x) / 640.0f;
     float pos_pan = d - 0.25f;
     game_state_play_sound(obj->gs, 56, 0.3f, pos_pan, 2.2f);
 }
@@ -472,9 +475,9 @@ void har_move(object *obj) {
     har *h = object_get_userdata(obj);
 
     if(h->walk_destination > 0 && h->walk_done_anim &&
-       ((obj->pos.x >= h->walk_destination && object_get_direction(obj) == OBJECT_FACE_RIGHT) ||
-        (obj->pos.x <= h->walk_destination && object_get_direction(obj) == OBJECT_FACE_LEFT))) {
-        obj->pos.x = h->walk_destination;
+       ((obj->pos.x >= phys_from_int(h->walk_destination) && object_get_direction(obj) == OBJECT_FACE_RIGHT) ||
+        (obj->pos.x <= phys_from_int(h->walk_destination) && object_get_direction(obj) == OBJECT_FACE_LEFT))) {
+        obj->pos.x = phys_from_int(h->walk_destination);
         log_debug("reached destination!");
         if(obj->animation_state.shadow_corner_hack) {
             object_set_direction(obj, object_get_direction(obj) * -1);
@@ -497,13 +500,13 @@ void har_move(object *obj) {
         h->walk_done_anim = 0;
         return;
     } else if(h->walk_destination > 0) {
-        log_debug("still walking to %d, at %f", h->walk_destination, obj->pos.x);
+        log_debug("still walking to %d, at %f", h->walk_destination, phys_to_float(obj->pos.x));
     }
 
     // Check for wall hits
-    if(obj->pos.x <= ARENA_LEFT_WALL || obj->pos.x >= ARENA_RIGHT_WALL) {
+    if(obj->pos.x <= phys_from_int(ARENA_LEFT_WALL) || obj->pos.x >= phys_from_int(ARENA_RIGHT_WALL)) {
         h->is_wallhugging = 1;
-        if(player_frame_isset(obj, "cw") && player_frame_isset(obj, "d")) {
+        if(player_frame_isset(obj, SD_TAG_CW) && player_frame_isset(obj, SD_TAG_D)) {
             log_debug("disabling d tag on animation because of wall hit");
             obj->animation_state.disable_d = 1;
         }
@@ -513,12 +516,12 @@ void har_move(object *obj) {
     }
 
     // Handle floor collisions
-    if(obj->pos.y >= ARENA_FLOOR) {
+    if(obj->pos.y >= phys_from_int(ARENA_FLOOR)) {
         controller *ctrl = game_player_get_ctrl(game_state_get_player(obj->gs, h->player_id));
         if(h->state != STATE_FALLEN) {
             // We collided with ground, so set vertical velocity to 0 and
             // make sure object is level with ground
-            obj->pos.y = ARENA_FLOOR;
+            obj->pos.y = phys_from_int(ARENA_FLOOR);
             obj->vel.y = 0;
         }
 
@@ -541,8 +544,8 @@ void har_move(object *obj) {
             } else if(last_input == '7' || last_input == '8' || last_input == '9') {
                 har_set_ani(obj, ANIM_JUMPING, 0);
                 h->state = STATE_JUMPING;
-                float vx = 0.0f;
-                float vy = h->jump_speed;
+                phys vx = 0;
+                phys vy = h->jump_speed;
                 int jump_dir = 0;
                 int direction = object_get_direction(obj);
                 if(last_input == '9') {
@@ -565,7 +568,7 @@ void har_move(object *obj) {
                         object_set_stride(obj, 7);
                     }
                 }
-                object_set_vel(obj, vec2f_create(vx, vy));
+                obj->vel = vec2p_create(vx, vy);
                 har_event_jump(h, jump_dir, ctrl);
             } else {
                 object_set_vel(obj, vec2f_create(0, 0));
@@ -584,13 +587,13 @@ void har_move(object *obj) {
                 har_face_enemy(obj, obj_enemy);
             }
         } else if(h->state == STATE_FALLEN || h->state == STATE_RECOIL) {
-            if(obj->pos.y > ARENA_FLOOR) {
-                obj->pos.y = ARENA_FLOOR;
+            if(obj->pos.y > phys_from_int(ARENA_FLOOR)) {
+                obj->pos.y = phys_from_int(ARENA_FLOOR);
                 har_floor_landing_effects(obj);
             }
 
-            if(obj->pos.x <= ARENA_LEFT_WALL || obj->pos.x >= ARENA_RIGHT_WALL) {
-                obj->vel.x = 0.0;
+            if(obj->pos.x <= phys_from_int(ARENA_LEFT_WALL) || obj->pos.x >= phys_from_int(ARENA_RIGHT_WALL)) {
+                obj->vel.x = 0;
             }
 
             // prevent har from sliding after defeat, unless they're 'fallen'
@@ -599,7 +602,8 @@ void har_move(object *obj) {
                 h->state = STATE_DEFEAT;
                 har_set_ani(obj, ANIM_DEFEAT, 0);
                 // har_event_defeat(h, ctrl);
-            } else if(obj->pos.y >= (ARENA_FLOOR - 5) && IS_ZERO(obj->vel.x) && player_is_last_frame(obj)) {
+            } else if(obj->pos.y >= phys_from_int(ARENA_FLOOR - 5) && IS_ZERO(obj->vel.x) &&
+                      player_is_last_frame(obj)) {
                 if(h->state == STATE_FALLEN) {
                     if(h->health <= 0) {
                         // fallen, but done bouncing
@@ -621,25 +625,27 @@ void har_move(object *obj) {
             // add some friction from the floor if we're not walking during scrap
             // This is important to dampen/eliminate the velocity added from pushing away from the other HAR
             // friction decreases velocity by 1 each tick, and sets it to 0 if its under |2|
-            if(obj->vel.x > 0.0f) {
-                if(obj->vel.x < 2.0f) {
-                    obj->vel.x = 0.0f;
+            if(obj->vel.x > 0) {
+                if(obj->vel.x < phys_from_int(2)) {
+                    obj->vel.x = 0;
                 } else {
-                    obj->vel.x -= 1.0f;
+                    obj->vel.x -= phys_from_int(1);
                 }
-            } else if(obj->vel.x < 0.0f) {
-                if(obj->vel.x > -2.0f) {
-                    obj->vel.x = 0.0f;
+            } else if(obj->vel.x < 0) {
+                if(obj->vel.x > phys_from_int(-2)) {
+                    obj->vel.x = 0;
                 } else {
-                    obj->vel.x += 1.0f;
+                    obj->vel.x += phys_from_int(1);
                 }
             }
         }
 
         if(h->state == STATE_WALKTO) {
-            obj->pos.x += (h->fwd_speed * object_get_direction(obj)) * (h->hard_close ? 0.5 : 1.0);
+            phys step = h->fwd_speed * object_get_direction(obj);
+            obj->pos.x += h->hard_close ? step / 2 : step;
         } else if(h->state == STATE_WALKFROM) {
-            obj->pos.x -= (h->back_speed * object_get_direction(obj)) * (h->hard_close ? 0.5 : 1.0);
+            phys step = h->back_speed * object_get_direction(obj);
+            obj->pos.x -= h->hard_close ? step / 2 : step;
         }
 
         object_apply_controllable_velocity(obj, obj, last_input);
@@ -660,7 +666,7 @@ void har_take_damage(object *obj, const str *string, float damage, float stun) {
     h->in_stasis_ticks = 1;
 
     // Save damage taken
-    h->last_damage_value = damage;
+    h->last_damage_value = phys_from_float(damage);
 
     // interrupted
     h->executing_move = 0;
@@ -679,28 +685,28 @@ void har_take_damage(object *obj, const str *string, float damage, float stun) {
         if(player->pilot->photo) {
             // in tournament mode, damage is mitigated by armor
             // (Armor + 2.5) * .25
-            log_debug("applying %f to %d modulated by armor %f", damage, h->health,
-                      0.25f * (2.5f + player->pilot->armor));
-            h->health -= damage / (0.25f * (2.5f + player->pilot->armor));
+            phys armor = phys_from_int(2 * player->pilot->armor + 5) / 8;
+            log_debug("applying %f to %d modulated by armor %f", damage, h->health, phys_to_float(armor));
+            h->health = phys_to_int(phys_from_int(h->health) - phys_div(phys_from_float(damage), armor));
         } else {
-            h->health -= damage;
+            h->health = phys_to_int(phys_from_int(h->health) - phys_from_float(damage));
         }
     }
 
     // Handle health changes
     if(h->health <= 0) {
         h->health = 0;
-        h->endurance = 0.0f;
+        h->endurance = 0;
     }
 
-    log_debug("applying %f stun damage to %f", stun, h->endurance);
-    h->endurance -= stun;
-    if(h->endurance < 1.0f) {
+    log_debug("applying %f stun damage to %f", stun, phys_to_float(h->endurance));
+    h->endurance -= phys_from_float(stun);
+    if(h->endurance < phys_from_int(1)) {
         if(h->state == STATE_STUNNED) {
             // refill endurance
             h->endurance = h->endurance_max;
         } else {
-            h->endurance = 0.0f;
+            h->endurance = 0;
         }
     }
 
@@ -745,7 +751,7 @@ void har_take_damage(object *obj, const str *string, float damage, float stun) {
 
             if(object_is_airborne(obj)) {
                 // airborne defeat
-                obj->vel.y = -7;
+                obj->vel.y = phys_from_int(-7);
                 object_set_stride(obj, 1);
                 h->state = STATE_FALLEN;
             }
@@ -763,7 +769,7 @@ void har_take_damage(object *obj, const str *string, float damage, float stun) {
             object_set_custom_string(obj, str_c(&n));
             str_free(&n);
 
-            obj->vel.y = -7 * object_get_direction(obj);
+            obj->vel.y = phys_from_int(-7 * object_get_direction(obj));
             h->state = STATE_FALLEN;
             object_set_stride(obj, 1);
         } else {
@@ -773,9 +779,9 @@ void har_take_damage(object *obj, const str *string, float damage, float stun) {
 
         // XXX hack - if the first frame has the 'k' tag, treat it as some vertical knockback
         // we can't do this in player.c because it breaks the jaguar leap, which also uses the 'k' tag.
-        const sd_script_frame *frame = sd_script_get_frame(&obj->animation_state.parser, 0);
-        if(frame != NULL && sd_script_isset(frame, "k")) {
-            obj->vel.y -= 7;
+        const sd_script_frame *frame = sd_script_get_frame(obj->animation_state.parser, 0);
+        if(frame != NULL && sd_script_isset_id(frame, SD_TAG_K)) {
+            obj->vel.y -= phys_from_int(7);
         }
     }
 }
@@ -1114,30 +1120,26 @@ int har_collide_with_har(object *obj_a, object *obj_b, int loop) {
     }
     if(a->damage_done == 0 &&
        (intersect_sprite_hitpoint(obj_a, obj_b, level, &hit_coord) || move->category == CAT_CLOSE ||
-        (player_frame_isset(obj_a, "ue") && b->state != STATE_JUMPING))) {
+        (player_frame_isset(obj_a, SD_TAG_UE) && b->state != STATE_JUMPING))) {
 
         obj_a->q_counter = obj_a->q_val;
 
         if(har_is_blocking(b, move) &&
            // earthquake smash is unblockable
-           !player_frame_isset(obj_a, "ue")) {
+           !player_frame_isset(obj_a, SD_TAG_UE)) {
             a->damage_done = 1;
             har_event_enemy_block(a, move, false, ctrl_a);
             har_event_block(b, move, false, ctrl_b);
             har_block(obj_b, hit_coord, move->block_stun);
+            // (block stun - 2) * 0.74 + 1
+            phys pushback = phys_scale(phys_from_int(74 * (move->block_stun - 2) + 100), 1, 100);
             if(b->is_wallhugging) {
-                vec2f push = object_get_vel(obj_a);
                 // TODO use 90% of the block pushback as cornerpush for now
-                push.x = -1 * object_get_direction(obj_a) * (((move->block_stun - 2) * 0.74) + 1) * 0.9;
-                log_debug("doing block cornerpush of %f",
-                          -1 * object_get_direction(obj_a) * (((move->block_stun - 2) * 0.74) + 1) * 0.9);
-                object_set_vel(obj_a, push);
+                obj_a->vel.x = -1 * object_get_direction(obj_a) * phys_scale(pushback, 9, 10);
+                log_debug("doing block cornerpush of %f", phys_to_float(obj_a->vel.x));
             } else {
-                vec2f push = object_get_vel(obj_b);
-                push.x = -1 * object_get_direction(obj_b) * (((move->block_stun - 2) * 0.74) + 1);
-                log_debug("doing block pushback of %f",
-                          -1 * object_get_direction(obj_b) * (((move->block_stun - 2) * 0.74) + 1));
-                object_set_vel(obj_b, push);
+                obj_b->vel.x = -1 * object_get_direction(obj_b) * pushback;
+                log_debug("doing block pushback of %f", phys_to_float(obj_b->vel.x));
             }
             return 0;
         }
@@ -1181,19 +1183,15 @@ int har_collide_with_har(object *obj_a, object *obj_b, int loop) {
         if(move->category != CAT_CLOSE) {
             if(b->is_wallhugging) {
                 // back the attacker off a little
-                vec2f push = object_get_vel(obj_a);
-                if(fabsf(push.x) < 5.5f) {
+                if(phys_abs(obj_a->vel.x) < phys_from_float(5.5f)) {
                     // TODO need real formula here
                     log_debug("doing corner push of 6.3");
-                    push.x = -6.3f * object_get_direction(obj_a);
-                    object_set_vel(obj_a, push);
+                    obj_a->vel.x = phys_from_float(-6.3f) * object_get_direction(obj_a);
                 }
             } else {
-                vec2f push = object_get_vel(obj_b);
-                if(fabsf(push.x) < 7.0f) {
+                if(phys_abs(obj_b->vel.x) < phys_from_int(7)) {
                     log_debug("doing knockback of 7");
-                    push.x = -7.0f * object_get_direction(obj_b);
-                    object_set_vel(obj_b, push);
+                    obj_b->vel.x = phys_from_int(-7) * object_get_direction(obj_b);
                 }
             }
         }
@@ -1274,7 +1272,7 @@ void har_collide_with_projectile(object *o_har, object *o_pjt) {
 
         // check the animation is still going
         // for some reason this has been observed to happen sometimes, an example is frame 18 of chronos' stasis
-        if(!sd_script_get_frame_at(&o_pjt->animation_state.parser, o_pjt->animation_state.current_tick)) {
+        if(!sd_script_get_frame_at(o_pjt->animation_state.parser, o_pjt->animation_state.current_tick)) {
             log_debug("no such frame at tick %d", o_pjt->animation_state.current_tick);
             return;
         }
@@ -1294,7 +1292,7 @@ void har_collide_with_projectile(object *o_har, object *o_pjt) {
         object_set_vel(o_har, vel);
 
         // Exception case for chronos' time freeze
-        if(player_frame_isset(o_pjt, "af")) {
+        if(player_frame_isset(o_pjt, SD_TAG_AF)) {
             // statis ticks is the raw damage from the move
             h->in_stasis_ticks = move->raw_damage;
         } else {
@@ -1316,7 +1314,7 @@ void har_collide_with_projectile(object *o_har, object *o_pjt) {
         har_spawn_scrap(o_har, hit_coord, move->block_stun);
         h->damage_received = 1;
 
-        if(player_frame_isset(o_pjt, "uz")) {
+        if(player_frame_isset(o_pjt, SD_TAG_UZ)) {
             // associate this with the enemy HAR
             h->linked_obj = o_pjt->id;
             projectile_link_object(o_pjt, o_har);
@@ -1353,7 +1351,7 @@ void har_collide_with_hazard(object *o_har, object *o_hzd) {
     }
 
     // Check if collisions are switched off for the hazard
-    if(player_frame_isset(o_hzd, "n")) {
+    if(player_frame_isset(o_hzd, SD_TAG_N)) {
         return;
     }
 
@@ -1387,6 +1385,13 @@ void har_collide_with_hazard(object *o_har, object *o_hzd) {
 }
 
 void har_collide(object *obj_a, object *obj_b) {
+    // Projectile and hazard hits are only ever decided by sprite hitpoints, so skip
+    // the pixel checks if the two objects are too far apart to touch.
+    if((object_get_layers(obj_a) | object_get_layers(obj_b)) & (LAYER_PROJECTILE | LAYER_HAZARD) &&
+       !intersect_sprite_extents_overlap(obj_a, obj_b)) {
+        return;
+    }
+
     // Check if this is projectile to har collision
     if(object_get_layers(obj_a) & LAYER_PROJECTILE) {
         har_collide_with_projectile(obj_b, obj_a);
@@ -1475,13 +1480,13 @@ void har_tick(object *obj) {
 
     // See if we are being grabbed. We detect this by checking the
     // "e" tag -- force to enemy position.
-    h->is_grabbed = player_frame_isset(obj, "e");
+    h->is_grabbed = player_frame_isset(obj, SD_TAG_E);
 
     // Make sure HAR doesn't walk through walls
     // TODO: Roof!
     vec2i pos = object_get_pos(obj);
     if(h->state != STATE_DEFEAT) {
-        int wall_flag = player_frame_isset(obj, "aw");
+        int wall_flag = player_frame_isset(obj, SD_TAG_AW);
         int wall = 0;
         int hit = 0;
         if(pos.x < ARENA_LEFT_WALL) {
@@ -1508,15 +1513,16 @@ void har_tick(object *obj) {
     }
 
     // Check for HAR specific palette tricks
-    if(player_frame_isset(obj, "ptr") || player_frame_isset(obj, "ptd") || player_frame_isset(obj, "ptp")) {
-        h->p_pal_ref = player_frame_get(obj, "pd");
-        h->p_har_switch = player_frame_isset(obj, "pe");
-        h->p_fade_out_ticks = h->p_fade_out_ticks_left = player_frame_get(obj, "ptr");
-        h->p_fade_in_ticks = h->p_fade_in_ticks_left = player_frame_get(obj, "ptd");
-        h->p_sustain_ticks_left = player_frame_get(obj, "ptp");
-        // h->p_max_intensity = player_frame_get(obj, "pp");
-        // h->p_base_intensity = player_frame_get(obj, "pb");
-        h->p_color_fn = player_frame_isset(obj, "pa");
+    if(player_frame_isset(obj, SD_TAG_PTR) || player_frame_isset(obj, SD_TAG_PTD) ||
+       player_frame_isset(obj, SD_TAG_PTP)) {
+        h->p_pal_ref = player_frame_get(obj, SD_TAG_PD);
+        h->p_har_switch = player_frame_isset(obj, SD_TAG_PE);
+        h->p_fade_out_ticks = h->p_fade_out_ticks_left = player_frame_get(obj, SD_TAG_PTR);
+        h->p_fade_in_ticks = h->p_fade_in_ticks_left = player_frame_get(obj, SD_TAG_PTD);
+        h->p_sustain_ticks_left = player_frame_get(obj, SD_TAG_PTP);
+        // h->p_max_intensity = player_frame_get(obj, SD_TAG_PP);
+        // h->p_base_intensity = player_frame_get(obj, SD_TAG_PB);
+        h->p_color_fn = player_frame_isset(obj, SD_TAG_PA);
     }
 
     // Object took walldamage, but has now landed
@@ -1560,7 +1566,7 @@ void har_tick(object *obj) {
     if(h->endurance < h->endurance_max &&
        !(h->executing_move || h->state == STATE_RECOIL || h->state == STATE_STUNNED || h->state == STATE_FALLEN ||
          h->state == STATE_STANDING_UP || h->state == STATE_DEFEAT)) {
-        h->endurance += 0.0025f * h->endurance_max; // made up but plausible number
+        h->endurance += phys_mul(phys_from_float(0.0025f), h->endurance_max); // made up but plausible number
     }
 
     // Leave shadow trail
@@ -1670,115 +1676,148 @@ void add_input(char *buf, int act_type, int direction) {
     }
 }
 
-af_move *match_move(object *obj, char prefix, char *inputs) {
-    har *h = object_get_userdata(obj);
-    af_move *move = NULL;
-    size_t len;
-    for(int i = 0; i < 70; i++) {
-        if((move = af_get_move(h->af_data, i))) {
-            len = str_size(&move->move_string);
-            if(str_at(&move->move_string, 0) == prefix &&
-               (len == 1 || !strncmp(str_c(&move->move_string) + 1, inputs, len - 1))) {
-                // try to avoid jaguar's K1 chaining into K while you're still
-                // holding a crouch button
-                // the 6 is for HARS, like jaguar, that lack a k6 or p6
-                if(len == 1 && inputs[0] != '5' && inputs[0] != 0 && inputs[0] != '6' &&
-                   move->category != CAT_JUMPING) {
-                    continue;
-                }
-
-                if(move->category == CAT_CLOSE && h->close != 1) {
-                    // not standing close enough
-                    continue;
-                }
-                if(move->category == CAT_JUMPING && h->state != STATE_JUMPING) {
-                    // not jumping
-                    continue;
-                }
-                if(move->category != CAT_JUMPING && h->state == STATE_JUMPING) {
-                    // jumping but this move is not a jumping move
-                    continue;
-                }
-                if((move->category == CAT_SCRAP && h->state != STATE_VICTORY) ||
-                   (h->state == STATE_VICTORY && move->category != CAT_SCRAP)) {
-                    continue;
-                }
-
-                if((move->category == CAT_DESTRUCTION && h->state != STATE_SCRAP) ||
-                   (h->state == STATE_SCRAP && move->category != CAT_DESTRUCTION)) {
-                    continue;
-                }
-
-                if(move->category == CAT_FIRE_ICE) {
-                    continue;
-                }
+typedef enum
+{
+    MOVE_SKIP,
+    MOVE_SELECT,
+    MOVE_ENQUEUE,
+} move_match;
+
+/**
+ * Moves that the HAR may start in its current state and position. This is the category and state gating of
+ * move matching, done with the lookup tables of the AF file instead of looking at each move.
+ */
+static move_mask allowed_moves(const har *h) {
+    const af *a = h->af_data;
+    move_mask mask;
+    switch(h->state) {
+        case STATE_JUMPING:
+            mask = a->category_moves[CAT_JUMPING];
+            break;
+        case STATE_VICTORY:
+            mask = a->category_moves[CAT_SCRAP];
+            break;
+        case STATE_SCRAP:
+            mask = a->category_moves[CAT_DESTRUCTION];
+            break;
+        default:
+            mask = a->all_moves;
+            move_mask_andnot(&mask, &a->category_moves[CAT_JUMPING]);
+            move_mask_andnot(&mask, &a->category_moves[CAT_SCRAP]);
+            move_mask_andnot(&mask, &a->category_moves[CAT_DESTRUCTION]);
+            break;
+    }
+    move_mask_andnot(&mask, &a->category_moves[CAT_FIRE_ICE]);
+    if(h->close != 1) {
+        // not standing close enough
+        move_mask_andnot(&mask, &a->category_moves[CAT_CLOSE]);
+    }
+    if(h->state != STATE_JUMPING) {
+        // required to be jumping
+        move_mask_andnot(&mask, &a->constraint_moves[1]);
+    }
+    if(h->is_wallhugging != 1) {
+        // required to be wall hugging
+        move_mask_andnot(&mask, &a->constraint_moves[0]);
+    }
+    return mask;
+}
 
-                if(h->state != STATE_JUMPING && move->pos_constraints & 0x2) {
-                    log_debug("Position contraint prevents move when not jumping!");
-                    // required to be jumping
-                    continue;
-                }
-                if(h->is_wallhugging != 1 && move->pos_constraints & 0x1) {
-                    log_debug("Position contraint prevents move when not wallhugging!");
-                    // required to be wall hugging
-                    continue;
-                }
+/**
+ * Checks the parts of move matching that depend on the input buffer and the current animation frame.
+ */
+static move_match check_move(object *obj, const har *h, const af_move *move, int i, const char *inputs) {
+    // try to avoid jaguar's K1 chaining into K while you're still
+    // holding a crouch button
+    // the 6 is for HARS, like jaguar, that lack a k6 or p6
+    if(str_size(&move->move_string) == 1 && inputs[0] != '5' && inputs[0] != 0 && inputs[0] != '6' &&
+       move->category != CAT_JUMPING) {
+        return MOVE_SKIP;
+    }
 
-                if(h->executing_move && !h->enqueued) {
-                    // check if the current frame allows chaining
-                    int allowed = 0;
-                    if(player_frame_isset(obj, "jn") && i == player_frame_get(obj, "jn")) {
+    if(h->executing_move && !h->enqueued) {
+        // check if the current frame allows chaining
+        int allowed = 0;
+        if(player_frame_isset(obj, SD_TAG_JN) && i == player_frame_get(obj, SD_TAG_JN)) {
+            allowed = 1;
+        } else {
+            switch(move->category) {
+                case CAT_LOW:
+                    if(player_frame_isset(obj, SD_TAG_JL)) {
                         allowed = 1;
-                    } else {
-                        switch(move->category) {
-                            case CAT_LOW:
-                                if(player_frame_isset(obj, "jl")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_MEDIUM:
-                                if(player_frame_isset(obj, "jm")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_HIGH:
-                                if(player_frame_isset(obj, "jh")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_SCRAP:
-                                if(player_frame_isset(obj, "jf")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_DESTRUCTION:
-                                if(player_frame_isset(obj, "jf2")) {
-                                    allowed = 1;
-                                }
-                                break;
-                        }
                     }
-                    if(player_get_current_tick(obj) >= player_get_len_ticks(obj)) {
-                        log_debug("enqueueing %d %s", i, str_c(&move->move_string));
-                        h->enqueued = i;
-                        return NULL;
+                    break;
+                case CAT_MEDIUM:
+                    if(player_frame_isset(obj, SD_TAG_JM)) {
+                        allowed = 1;
                     }
-
-                    if(!allowed) {
-                        // not allowed
-                        continue;
+                    break;
+                case CAT_HIGH:
+                    if(player_frame_isset(obj, SD_TAG_JH)) {
+                        allowed = 1;
                     }
-                    log_debug("CHAINING");
-                }
-
-                log_debug("matched move %d with string %s in state %d with input buffer %s", i,
-                          str_c(&move->move_string), h->state, h->inputs);
-                /*DEBUG("input was %s", h->inputs);*/
-                return move;
+                    break;
+                case CAT_SCRAP:
+                    if(player_frame_isset(obj, SD_TAG_JF)) {
+                        allowed = 1;
+                    }
+                    break;
+                case CAT_DESTRUCTION:
+                    if(player_frame_isset(obj, SD_TAG_JF2)) {
+                        allowed = 1;
+                    }
+                    break;
             }
         }
+        if(player_get_current_tick(obj) >= player_get_len_ticks(obj)) {
+            return MOVE_ENQUEUE;
+        }
+
+        if(!allowed) {
+            // not allowed
+            return MOVE_SKIP;
+        }
     }
-    return NULL;
+    return MOVE_SELECT;
+}
+
+/**
+ * Finds the first move that matches the input, in move id order. Returns -1 if nothing matches.
+ */
+static int find_move(object *obj, char prefix, const char *inputs, move_match *result) {
+    har *h = object_get_userdata(obj);
+    move_mask candidates = move_trie_match(&h->af_data->move_index, prefix, inputs);
+    move_mask allowed = allowed_moves(h);
+    move_mask_and(&candidates, &allowed);
+    for(int i = move_mask_next(&candidates, 0); i >= 0; i = move_mask_next(&candidates, i + 1)) {
+        *result = check_move(obj, h, af_get_move(h->af_data, i), i, inputs);
+        if(*result != MOVE_SKIP) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+af_move *match_move(object *obj, char prefix, char *inputs) {
+    har *h = object_get_userdata(obj);
+    move_match result = MOVE_SKIP;
+    int i = find_move(obj, prefix, inputs, &result);
+    if(i < 0) {
+        return NULL;
+    }
+
+    af_move *move = af_get_move(h->af_data, i);
+    if(result == MOVE_ENQUEUE) {
+        log_debug("enqueueing %d %s", i, str_c(&move->move_string));
+        h->enqueued = i;
+        return NULL;
+    }
+    if(h->executing_move && !h->enqueued) {
+        log_debug("CHAINING");
+    }
+    log_debug("matched move %d with string %s in state %d with input buffer %s", i, str_c(&move->move_string),
+              h->state, h->inputs);
+    return move;
 }
 
 af_move *scrap_destruction_cheat(object *obj, char *inputs) {
@@ -1787,13 +1826,14 @@ af_move *scrap_destruction_cheat(object *obj, char *inputs) {
         af_move *move;
         if((move = af_get_move(h->af_data, i))) {
             if(move->category == CAT_SCRAP && h->state == STATE_VICTORY && inputs[0] == 'K' &&
-               (player_frame_isset(obj, "jf") || (player_frame_isset(obj, "jn") && i == player_frame_get(obj, "jn")))) {
+               (player_frame_isset(obj, SD_TAG_JF) ||
+                (player_frame_isset(obj, SD_TAG_JN) && i == player_frame_get(obj, SD_TAG_JN)))) {
                 return move;
             }
 
             if(move->category == CAT_DESTRUCTION && h->state == STATE_SCRAP && inputs[0] == 'P' &&
-               (player_frame_isset(obj, "jf2") ||
-                (player_frame_isset(obj, "jn") && i == player_frame_get(obj, "jn")))) {
+               (player_frame_isset(obj, SD_TAG_JF2) ||
+                (player_frame_isset(obj, SD_TAG_JN) && i == player_frame_get(obj, SD_TAG_JN)))) {
                 return move;
             }
         }
@@ -1887,16 +1927,14 @@ int har_act(object *obj, int act_type) {
     if(move) {
         // Move flag is on -- make the HAR move backwards to avoid overlap.
         if(move->collision_opts & 0x20) {
-            obj->pos.x -= object_get_size(obj).x / 2 * object_get_direction(obj);
+            obj->pos.x -= phys_from_int(object_get_size(obj).x / 2 * object_get_direction(obj));
         }
 
         // Stop horizontal movement, when move is done
         // TODO: Make this work better
-        vec2f spd = object_get_vel(obj);
         if(h->state != STATE_JUMPING) {
-            spd.x = 0.0f;
+            obj->vel.x = 0;
         }
-        object_set_vel(obj, spd);
         if(h->state == STATE_WALKTO || h->state == STATE_WALKFROM) {
             // switch to standing to cancel any walk velocity changes
             h->state = STATE_STANDING;
@@ -1918,8 +1956,8 @@ int har_act(object *obj, int act_type) {
         // If animation is scrap or destruction, then remove our customizations
         // from gravity/fall speed, and just use the HARs native value.
         if(move->category == CAT_SCRAP || move->category == CAT_DESTRUCTION) {
-            obj->horizontal_velocity_modifier = 1.0f;
-            obj->vertical_velocity_modifier = 1.0f;
+            obj->horizontal_velocity_modifier = phys_from_int(1);
+            obj->vertical_velocity_modifier = phys_from_int(1);
             object_set_gravity(obj, h->af_data->fall_speed);
             object_set_gravity(enemy_obj, enemy_har->af_data->fall_speed);
         }
@@ -1958,9 +1996,9 @@ int har_act(object *obj, int act_type) {
 
     // Don't allow new movement while we're still executing a move
     if(h->executing_move) {
-        if(obj->pos.y < ARENA_FLOOR) {
+        if(obj->pos.y < phys_from_int(ARENA_FLOOR)) {
             // XXX I think 'i' is for 'not interruptable'
-            if(h->state < STATE_JUMPING && !player_frame_isset(obj, "i")) {
+            if(h->state < STATE_JUMPING && !player_frame_isset(obj, SD_TAG_I)) {
                 log_debug("standing move led to airborne one");
                 h->state = STATE_JUMPING;
             } else if(h->state != STATE_JUMPING) {
@@ -1971,7 +2009,7 @@ int har_act(object *obj, int act_type) {
     }
 
     char last_input = get_last_input(h);
-    if(obj->pos.y < ARENA_FLOOR) {
+    if(obj->pos.y < phys_from_int(ARENA_FLOOR)) {
         // airborne
 
         // HAR can have STATE_NONE here if they started an airborne attack from a crouch, like katana's corkscrew blade
@@ -2006,7 +2044,7 @@ int har_act(object *obj, int act_type) {
         return 0;
     }
 
-    float vx, vy;
+    phys vx, vy;
     // no moves matched, do player movement
     int newstate;
     if((newstate = maybe_har_change_state(h->state, direction, last_input))) {
@@ -2038,7 +2076,7 @@ int har_act(object *obj, int act_type) {
                 break;
             case STATE_JUMPING:
                 har_set_ani(obj, ANIM_JUMPING, 0);
-                vx = 0.0f;
+                vx = 0;
                 vy = h->jump_speed;
                 int jump_dir = 0;
                 if(last_input == '9') {
@@ -2065,7 +2103,7 @@ int har_act(object *obj, int act_type) {
                     // jumping frop crouch makes you jump 25% higher
                     vy = h->superjump_speed;
                 }
-                object_set_vel(obj, vec2f_create(vx, vy));
+                obj->vel = vec2p_create(vx, vy);
                 har_event_jump(h, jump_dir, ctrl);
                 break;
         }
@@ -2130,7 +2168,7 @@ void har_finished(object *obj) {
     } else if(h->state == STATE_RECOIL && h->health <= 0) {
         h->state = STATE_DEFEAT;
         har_set_ani(obj, h->custom_defeat_animation ? h->custom_defeat_animation : ANIM_DEFEAT, 0);
-    } else if((h->state == STATE_RECOIL || h->state == STATE_STANDING_UP) && h->endurance < 1.0f) {
+    } else if((h->state == STATE_RECOIL || h->state == STATE_STANDING_UP) && h->endurance < phys_from_int(1)) {
         if(h->state == STATE_RECOIL) {
             har_event_recover(h, ctrl);
         }
@@ -2202,6 +2240,7 @@ void har_install_hook(har *h, har_hook_cb hook, void *data) {
 int har_clone(object *src, object *dst) {
     har *local = omf_calloc(1, sizeof(har));
     memcpy(local, object_get_userdata(src), sizeof(har));
+    dst->gs->clone_struct_bytes += sizeof(har);
     list_create(&local->har_hooks);
     object_set_userdata(dst, local);
     object_set_spawn_cb(dst, cb_har_spawn_object, local);
@@ -2217,9 +2256,158 @@ int har_clone_free(object *obj) {
     return 0;
 }
 
+int har_serialize(const object *obj, serial *ser) {
+    const har *h = object_get_userdata(obj);
+    serial_write_int8(ser, h->id);
+    serial_write_int8(ser, h->player_id);
+    serial_write_int8(ser, h->pilot_id);
+    serial_write_int8(ser, h->state);
+    serial_write_int8(ser, h->executing_move);
+    serial_write_int8(ser, h->close);
+    serial_write_int8(ser, h->enqueued);
+    serial_write_ptr(ser, h->af_data);
+    serial_write_int8(ser, h->damage_done);
+    serial_write_int8(ser, h->damage_received);
+    serial_write_int8(ser, h->air_attacked);
+    serial_write_int8(ser, h->is_wallhugging);
+    serial_write_int8(ser, h->is_grabbed);
+    serial_write_phys(ser, h->last_damage_value);
+    serial_write_phys(ser, h->jump_speed);
+    serial_write_phys(ser, h->superjump_speed);
+    serial_write_phys(ser, h->fall_speed);
+    serial_write_phys(ser, h->fwd_speed);
+    serial_write_phys(ser, h->back_speed);
+    serial_write_int32(ser, h->in_stasis_ticks);
+    serial_write_int8(ser, h->stride);
+    serial_write_int16(ser, h->health_max);
+    serial_write_int16(ser, h->health);
+    serial_write_phys(ser, h->endurance_max);
+    serial_write_phys(ser, h->endurance);
+    serial_write(ser, h->inputs, sizeof(h->inputs));
+    serial_write_int8(ser, h->hard_close);
+    serial_write_int8(ser, h->stun_timer);
+    serial_write_int8(ser, h->delay);
+    serial_write_int8(ser, h->p_pal_ref);
+    serial_write_int8(ser, h->p_har_switch);
+    serial_write_int16(ser, h->p_fade_out_ticks);
+    serial_write_int16(ser, h->p_fade_out_ticks_left);
+    serial_write_int16(ser, h->p_fade_in_ticks);
+    serial_write_int16(ser, h->p_fade_in_ticks_left);
+    serial_write_int16(ser, h->p_sustain_ticks_left);
+    serial_write_int8(ser, h->p_color_fn);
+    serial_write_uint32(ser, h->linked_obj);
+    serial_write_int32(ser, h->walk_destination);
+    serial_write_int32(ser, h->walk_done_anim);
+    serial_write_int8(ser, h->custom_defeat_animation);
+    return 0;
+}
+
+// Hooks and debug surfaces belong to the game state the HAR lives in, and are not part of the snapshot.
+int har_unserialize(object *obj, serial *ser) {
+    har *h = object_get_userdata(obj);
+    if(h == NULL) {
+        h = omf_calloc(1, sizeof(har));
+        list_create(&h->har_hooks);
+#ifdef DEBUGMODE
+        surface_create(&h->hit_pixel, 1, 1);
+        surface_clear(&h->hit_pixel);
+        surface_create(&h->har_origin, 4, 4);
+        surface_clear(&h->har_origin);
+#endif
+        object_set_userdata(obj, h);
+    }
+
+    h->id = serial_read_int8(ser);
+    h->player_id = serial_read_int8(ser);
+    h->pilot_id = serial_read_int8(ser);
+    h->state = serial_read_int8(ser);
+    h->executing_move = serial_read_int8(ser);
+    h->close = serial_read_int8(ser);
+    h->enqueued = serial_read_int8(ser);
+    serial_read_ptr(ser, h->af_data);
+    h->damage_done = serial_read_int8(ser);
+    h->damage_received = serial_read_int8(ser);
+    h->air_attacked = serial_read_int8(ser);
+    h->is_wallhugging = serial_read_int8(ser);
+    h->is_grabbed = serial_read_int8(ser);
+    h->last_damage_value = serial_read_phys(ser);
+    h->jump_speed = serial_read_phys(ser);
+    h->superjump_speed = serial_read_phys(ser);
+    h->fall_speed = serial_read_phys(ser);
+    h->fwd_speed = serial_read_phys(ser);
+    h->back_speed = serial_read_phys(ser);
+    h->in_stasis_ticks = serial_read_int32(ser);
+    h->stride = serial_read_int8(ser);
+    h->health_max = serial_read_int16(ser);
+    h->health = serial_read_int16(ser);
+    h->endurance_max = serial_read_phys(ser);
+    h->endurance = serial_read_phys(ser);
+    serial_read(ser, h->inputs, sizeof(h->inputs));
+    h->hard_close = serial_read_int8(ser);
+    h->stun_timer = serial_read_int8(ser);
+    h->delay = serial_read_int8(ser);
+    h->p_pal_ref = serial_read_int8(ser);
+    h->p_har_switch = serial_read_int8(ser);
+    h->p_fade_out_ticks = serial_read_int16(ser);
+    h->p_fade_out_ticks_left = serial_read_int16(ser);
+    h->p_fade_in_ticks = serial_read_int16(ser);
+    h->p_fade_in_ticks_left = serial_read_int16(ser);
+    h->p_sustain_ticks_left = serial_read_int16(ser);
+    h->p_color_fn = serial_read_int8(ser);
+    h->linked_obj = serial_read_uint32(ser);
+    h->walk_destination = serial_read_int32(ser);
+    h->walk_done_anim = serial_read_int32(ser);
+    h->custom_defeat_animation = serial_read_int8(ser);
+    return 0;
+}
+
+void har_hash(const object *obj, state_hash *h) {
+    const har *har = object_get_userdata(obj);
+    state_hash_int(h, "har_id", har->id);
+    state_hash_int(h, "player_id", har->player_id);
+    state_hash_int(h, "pilot_id", har->pilot_id);
+    state_hash_int(h, "state", har->state);
+    state_hash_int(h, "executing_move", har->executing_move);
+    state_hash_int(h, "close", har->close);
+    state_hash_int(h, "hard_close", har->hard_close);
+    state_hash_int(h, "enqueued", har->enqueued);
+    state_hash_int(h, "damage_done", har->damage_done);
+    state_hash_int(h, "damage_received", har->damage_received);
+    state_hash_int(h, "air_attacked", har->air_attacked);
+    state_hash_int(h, "is_wallhugging", har->is_wallhugging);
+    state_hash_int(h, "is_grabbed", har->is_grabbed);
+    state_hash_phys(h, "last_damage", har->last_damage_value);
+    state_hash_phys(h, "jump_speed", har->jump_speed);
+    state_hash_phys(h, "superjump_speed", har->superjump_speed);
+    state_hash_phys(h, "fall_speed", har->fall_speed);
+    state_hash_phys(h, "fwd_speed", har->fwd_speed);
+    state_hash_phys(h, "back_speed", har->back_speed);
+    state_hash_int(h, "stasis_ticks", har->in_stasis_ticks);
+    state_hash_int(h, "har_stride", har->stride);
+    state_hash_int(h, "health_max", har->health_max);
+    state_hash_int(h, "health", har->health);
+    state_hash_phys(h, "endurance_max", har->endurance_max);
+    state_hash_phys(h, "endurance", har->endurance);
+    state_hash_buf(h, "inputs", har->inputs, sizeof(har->inputs));
+    state_hash_int(h, "stun_timer", har->stun_timer);
+    // delay is left out, it depends on the network latency of each peer.
+    state_hash_int(h, "p_pal_ref", har->p_pal_ref);
+    state_hash_int(h, "p_har_switch", har->p_har_switch);
+    state_hash_int(h, "p_fade_out_left", har->p_fade_out_ticks_left);
+    state_hash_int(h, "p_fade_in_left", har->p_fade_in_ticks_left);
+    state_hash_int(h, "p_sustain_left", har->p_sustain_ticks_left);
+    state_hash_int(h, "linked", har->linked_obj != 0);
+    state_hash_int(h, "walk_destination", har->walk_destination);
+    state_hash_int(h, "walk_done_anim", har->walk_done_anim);
+    state_hash_int(h, "custom_defeat_animation", har->custom_defeat_animation);
+}
+
 void har_bootstrap(object *obj) {
     obj->clone = har_clone;
     obj->clone_free = har_clone_free;
+    obj->serialize = har_serialize;
+    obj->unserialize = har_unserialize;
+    obj->hash = har_hash;
 }
 
 int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id) {
@@ -2255,9 +2443,10 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
     // af_data->health);
     //  The stun cap is calculated as follows
     //  HAR Endurance * 3.6 * (Pilot Endurance + 16) / 23
-    local->endurance_max = local->endurance = af_data->endurance * 3.6 * (pilot->endurance + 16) / 23;
-    log_debug("HAR endurance is %f with pilot endurance %d and base endurance %f", local->endurance, pilot->endurance,
-              af_data->endurance);
+    local->endurance_max = local->endurance =
+        phys_scale(phys_from_float(af_data->endurance), 36 * (pilot->endurance + 16), 230);
+    log_debug("HAR endurance is %f with pilot endurance %d and base endurance %f", phys_to_float(local->endurance),
+              pilot->endurance, af_data->endurance);
     // fwd speed = (Agility + 20) / 30 * fwd speed
     // back speed = (Agility + 20) / 30 * back speed
     // up speed = (Agility + 35) / 45 * up speed (edited)
@@ -2269,15 +2458,16 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
     // Insanius: I went ahead and changed the formulas to use division instead of multiplication since it's more precise
     // for us Insanius: jump speed = speed up * vertical_agility_modifier * 212 / 256 Insanius: superjump speed = speed
     // up * vertical_agility_modifier * 266 / 256
-    float horizontal_agility_modifier = ((float)gp->pilot->agility + 35) / 45;
-    float vertical_agility_modifier = ((float)gp->pilot->agility + 20) / 30;
+    phys horizontal_agility_modifier = phys_from_int(gp->pilot->agility + 35) / 45;
+    phys vertical_agility_modifier = phys_from_int(gp->pilot->agility + 20) / 30;
     obj->horizontal_velocity_modifier = horizontal_agility_modifier;
     obj->vertical_velocity_modifier = vertical_agility_modifier;
-    local->jump_speed = (((float)gp->pilot->agility + 35) / 45) * af_data->jump_speed * 216 / 256;
-    local->superjump_speed = (((float)gp->pilot->agility + 35) / 45) * af_data->jump_speed * 266 / 256;
-    local->fall_speed = (((float)gp->pilot->agility + 20) / 30) * af_data->fall_speed;
-    local->fwd_speed = (((float)gp->pilot->agility + 20) / 30) * af_data->forward_speed;
-    local->back_speed = (((float)gp->pilot->agility + 20) / 30) * af_data->reverse_speed;
+    phys jump_speed = phys_mul(horizontal_agility_modifier, phys_from_float(af_data->jump_speed));
+    local->jump_speed = phys_scale(jump_speed, 216, 256);
+    local->superjump_speed = phys_scale(jump_speed, 266, 256);
+    local->fall_speed = phys_mul(vertical_agility_modifier, phys_from_float(af_data->fall_speed));
+    local->fwd_speed = phys_mul(vertical_agility_modifier, phys_from_float(af_data->forward_speed));
+    local->back_speed = phys_mul(vertical_agility_modifier, phys_from_float(af_data->reverse_speed));
     // TODO calculate a better value here
     local->stride = lrint(1 + (gp->pilot->agility / 20));
     log_debug("setting HAR stride to %d", local->stride);
@@ -2299,7 +2489,7 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
     local->walk_done_anim = 0;
 
     // Last damage value, for convenience
-    local->last_damage_value = 0.0f;
+    local->last_damage_value = 0;
 
     // p<x> stuff
     local->p_fade_in_ticks_left = local->p_fade_in_ticks = 0;
@@ -2315,7 +2505,7 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
     object_set_pal_limit(obj, (player_id + 1) * 48);
 
     // Object related stuff
-    object_set_gravity(obj, local->fall_speed);
+    obj->gravity = local->fall_speed;
     object_set_layers(obj, LAYER_HAR | (player_id == 0 ? LAYER_HAR1 : LAYER_HAR2));
     object_set_direction(obj, dir);
     object_set_repeat(obj, 1);
@@ -2396,7 +2586,7 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
                     if(str && str_size(str) != 0 && !str_equal_c(str, "!")) {
                         // its not the empty string and its not the string '!'
                         // so we should use it
-                        str_set(&move->ani.animation_string, vector_get(&move->ani.extra_strings, fight_mode ? 1 : 0));
+                        animation_set_string(&move->ani, vector_get(&move->ani.extra_strings, fight_mode ? 1 : 0));
                         log_debug("using %s mode string '%s' for animation %d on har %d",
                                   fight_mode ? "hyper" : "normal", str_c(str), i, har_id);
                     }
@@ -2427,7 +2617,7 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
                     if(str && str_size(str) != 0 && !str_equal_c(str, "!")) {
                         // its not the empty string and its not the string '!'
                         // so we should use it
-                        str_set(&move->ani.animation_string, str);
+                        animation_set_string(&move->ani, str);
                         if(pilot->enhancements[har_id] > 0) {
                             log_debug("using enhancement %d string '%s' for animation %d on har %d",
                                       pilot->enhancements[har_id], str_c(str), i, har_id);
@@ -2447,9 +2637,9 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
                         }
                         if(move->ani.extra_string_count > 0) {
                             // sometimes there's not enough extra strings, so take the last available
-                            str_set(&move->ani.animation_string,
-                                    vector_get(&move->ani.extra_strings,
-                                               min2(pilot->arm_speed, move->ani.extra_string_count - 1)));
+                            animation_set_string(&move->ani,
+                                                 vector_get(&move->ani.extra_strings,
+                                                            min2(pilot->arm_speed, move->ani.extra_string_count - 1)));
                         }
                         break;
                     case 2:
@@ -2459,9 +2649,9 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
                         }
                         if(move->ani.extra_string_count > 0) {
                             // sometimes there's not enough extra strings, so take the last available
-                            str_set(&move->ani.animation_string,
-                                    vector_get(&move->ani.extra_strings,
-                                               min2(pilot->leg_speed, move->ani.extra_string_count - 1)));
+                            animation_set_string(&move->ani,
+                                                 vector_get(&move->ani.extra_strings,
+                                                            min2(pilot->leg_speed, move->ani.extra_string_count - 1)));
                         }
                         break;
                     case 3:
@@ -2494,13 +2684,16 @@ int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int
         }
     }
 
+    // The disabled moves must not be found by input matching anymore
+    af_rebuild_move_index(af_data);
+
     // All done
     return 0;
 }
 
 void har_reset(object *obj) {
     har *h = object_get_userdata(obj);
-    object_set_gravity(obj, h->fall_speed);
+    obj->gravity = h->fall_speed;
     h->close = 0;
     h->hard_close = 0;
     h->state = STATE_STANDING;
@@ -134,19 +134,19 @@ typedef struct har_t {
     uint8_t air_attacked;
     uint8_t is_wallhugging;  // HAR is standing right next to a wall
     uint8_t is_grabbed;      // Is being moved by another object. Set by ex, ey tags
-    float last_damage_value; // Last damage value taken
+    phys last_damage_value;  // Last damage value taken
 
-    float jump_speed;      // Agility generated speed modifier for jumping
-    float superjump_speed; // Agility generated speed modifier for jumping
-    float fall_speed;      // Agility generated speed modifier for falling
-    float fwd_speed;       // Agility generated speed modifier for falling
-    float back_speed;      // Agility generated speed modifier for falling
+    phys jump_speed;      // Agility generated speed modifier for jumping
+    phys superjump_speed; // Agility generated speed modifier for jumping
+    phys fall_speed;      // Agility generated speed modifier for falling
+    phys fwd_speed;       // Agility generated speed modifier for falling
+    phys back_speed;      // Agility generated speed modifier for falling
 
     int in_stasis_ticks; // Handle stasis activator
 
     uint8_t stride;
     int16_t health_max, health;
-    float endurance_max, endurance;
+    phys endurance_max, endurance;
     char inputs[11];
     uint8_t hard_close;
 
@@ -195,6 +195,9 @@ int har_is_blocking(har *h, af_move *move);
 void har_copy_actions(object *new, object *old);
 void har_reset(object *obj);
 
+// Adds the directional part of an action to an input buffer, the way HAR move matching reads it
+void add_input(char *buf, int act_type, int direction);
+
 void har_set_delay(object *obj, int delay);
 
 uint8_t har_player_id(object *obj);
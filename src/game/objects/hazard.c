@@ -6,9 +6,11 @@
 #include <math.h>
 #include <stdlib.h>
 
-int orb_almost_there(vec2f a, vec2f b) {
-    vec2f dir = vec2f_sub(a, b);
-    return (dir.x >= -2.0f && dir.x <= 2.0f && dir.y >= -2.0f && dir.y <= 2.0f);
+int orb_almost_there(vec2p a, vec2p b) {
+    phys dir_x = a.x - b.x;
+    phys dir_y = a.y - b.y;
+    return (dir_x >= phys_from_int(-2) && dir_x <= phys_from_int(2) && dir_y >= phys_from_int(-2) &&
+            dir_y <= phys_from_int(2));
 }
 
 void hazard_tick(object *obj) {
@@ -31,19 +33,22 @@ void hazard_tick(object *obj) {
             // XXX come up with a better equation to randomize the destination
             obj->orbit_pos = obj->pos;
             obj->orbit_pos_vary = vec2f_create(0, 0);
-            float mag;
             int limit = 10;
             do {
-                obj->orbit_dest =
-                    vec2f_create(random_float(&obj->gs->rand) * 320.0f, random_float(&obj->gs->rand) * 200.0f);
-                obj->orbit_dest_dir = vec2f_sub(obj->orbit_dest, obj->orbit_pos);
-                mag = sqrtf(obj->orbit_dest_dir.x * obj->orbit_dest_dir.x +
-                            obj->orbit_dest_dir.y * obj->orbit_dest_dir.y);
+                // Drawn in two statements so the order of the draws doesn't depend on the compiler
+                phys x = phys_random(&obj->gs->rand, 320);
+                phys y = phys_random(&obj->gs->rand, 200);
+                obj->orbit_dest = vec2p_create(x, y);
                 limit--;
-            } while(mag < 80.0f && limit > 0);
-
-            obj->orbit_dest_dir.x /= mag;
-            obj->orbit_dest_dir.y /= mag;
+            } while(vec2p_closer_than(obj->orbit_pos, obj->orbit_dest, 80) && limit > 0);
+
+            // Not used by the simulation, so it can stay a float
+            obj->orbit_dest_dir = vec2f_sub(vec2p_to_f(obj->orbit_dest), vec2p_to_f(obj->orbit_pos));
+            float mag = vec2f_mag(obj->orbit_dest_dir);
+            if(mag > 0.0f) {
+                obj->orbit_dest_dir.x /= mag;
+                obj->orbit_dest_dir.y /= mag;
+            }
         }
     }
 }
@@ -76,29 +81,32 @@ void hazard_spawn_cb(object *parent, int id, vec2i pos, vec2f vel, uint8_t mp_fl
     }
 }
 
-vec2f generate_destination(object *obj) {
-    vec2f old = obj->orbit_dest;
-    vec2f new =
-        vec2f_create((random_float(&obj->gs->rand) * 280.0f) + 20.0f, (random_float(&obj->gs->rand) * 160.0f) + 20.0f);
-    while(vec2f_dist(old, new) < 100) {
-        new = vec2f_create((random_float(&obj->gs->rand) * 280.0f) + 20.0f,
-                           (random_float(&obj->gs->rand) * 160.0f) + 20.0f);
+static vec2p random_destination(object *obj) {
+    phys x = phys_random(&obj->gs->rand, 280) + phys_from_int(20);
+    phys y = phys_random(&obj->gs->rand, 160) + phys_from_int(20);
+    return vec2p_create(x, y);
+}
+
+vec2p generate_destination(object *obj) {
+    vec2p new = random_destination(obj);
+    while(vec2p_closer_than(obj->orbit_dest, new, 100)) {
+        new = random_destination(obj);
     }
     return new;
 }
 
 void accelerate_orbit(object *obj) {
-    float x_dist = obj->pos.x - obj->orbit_dest.x;
-    float y_dist = obj->pos.y - obj->orbit_dest.y;
-    float bigger = max2(x_dist, y_dist);
-    if(fabsf(bigger) > 20) {
-        bigger *= -1.0f;
+    phys x_dist = obj->pos.x - obj->orbit_dest.x;
+    phys y_dist = obj->pos.y - obj->orbit_dest.y;
+    phys bigger = max2(x_dist, y_dist);
+    if(phys_abs(bigger) > phys_from_int(20)) {
+        bigger *= -1;
     }
-    if(obj->vel.x < 1.0f) {
-        obj->vel.x += x_dist / (bigger * 10);
+    if(obj->vel.x < phys_from_int(1)) {
+        obj->vel.x += phys_div(x_dist, bigger * 10);
     }
-    if(obj->vel.y < 1.0f) {
-        obj->vel.y += y_dist / (bigger * 10);
+    if(obj->vel.y < phys_from_int(1)) {
+        obj->vel.y += phys_div(y_dist, bigger * 10);
     }
 }
 
@@ -121,45 +129,45 @@ void hazard_move(object *obj) {
             obj->vel.y = 0.0f;
         }*/
 
-        if((dist(obj->pos.x, obj->orbit_pos.x) >= dist(obj->orbit_dest.x, obj->orbit_pos.x)) &&
-           (dist(obj->pos.y, obj->orbit_pos.y) >= dist(obj->orbit_dest.y, obj->orbit_pos.y))) {
+        if((phys_dist(obj->pos.x, obj->orbit_pos.x) >= phys_dist(obj->orbit_dest.x, obj->orbit_pos.x)) &&
+           (phys_dist(obj->pos.y, obj->orbit_pos.y) >= phys_dist(obj->orbit_dest.y, obj->orbit_pos.y))) {
             obj->orbit_pos.x = obj->pos.x;
             obj->orbit_pos.y = obj->pos.y;
             obj->orbit_dest = generate_destination(obj);
-            log_debug("new position is %f, %f", obj->orbit_dest.x, obj->orbit_dest.y);
+            log_debug("new position is %f, %f", phys_to_float(obj->orbit_dest.x), phys_to_float(obj->orbit_dest.y));
         }
 
         // accelerate_orbit(obj);
 
-        float x_dist = obj->pos.x - obj->orbit_dest.x;
-        float y_dist = obj->pos.y - obj->orbit_dest.y;
-        float bigger = fabsf(y_dist);
-        if(fabsf(x_dist) > fabsf(y_dist)) {
+        phys x_dist = obj->pos.x - obj->orbit_dest.x;
+        phys y_dist = obj->pos.y - obj->orbit_dest.y;
+        phys bigger = phys_abs(y_dist);
+        if(phys_abs(x_dist) > phys_abs(y_dist)) {
             bigger = x_dist;
         }
 
         if(obj->orbit_dest.x > obj->pos.x) {
-            if(obj->vel.x < 1.0f) {
-                log_debug("accel +%f", x_dist / (bigger * 10));
-                obj->vel.x += x_dist / (bigger * 10);
+            if(obj->vel.x < phys_from_int(1)) {
+                log_debug("accel +%f", phys_to_float(phys_div(x_dist, bigger * 10)));
+                obj->vel.x += phys_div(x_dist, bigger * 10);
             }
         }
         if(obj->orbit_dest.x < obj->pos.x) {
-            if(obj->vel.x < 1.0f) {
-                log_debug("accel -%f", x_dist / (bigger * 10));
-                obj->vel.x -= x_dist / (bigger * 10);
+            if(obj->vel.x < phys_from_int(1)) {
+                log_debug("accel -%f", phys_to_float(phys_div(x_dist, bigger * 10)));
+                obj->vel.x -= phys_div(x_dist, bigger * 10);
             }
         }
         if(obj->orbit_dest.y > obj->pos.y) {
-            if(obj->vel.y < 1.0f) {
-                log_debug("accel +%f", y_dist / (bigger * 10));
-                obj->vel.y += y_dist / (bigger * 10);
+            if(obj->vel.y < phys_from_int(1)) {
+                log_debug("accel +%f", phys_to_float(phys_div(y_dist, bigger * 10)));
+                obj->vel.y += phys_div(y_dist, bigger * 10);
             }
         }
         if(obj->orbit_dest.y < obj->pos.y) {
-            if(obj->vel.y < 1.0f) {
-                log_debug("accel -%f", y_dist / (bigger * 10));
-                obj->vel.y -= y_dist / (bigger * 10);
+            if(obj->vel.y < phys_from_int(1)) {
+                log_debug("accel -%f", phys_to_float(phys_div(y_dist, bigger * 10)));
+                obj->vel.y -= phys_div(y_dist, bigger * 10);
             }
         }
 
@@ -186,9 +194,8 @@ int hazard_create(object *obj, scene *scene) {
 
     obj->orbit_pos.x = obj->pos.x;
     obj->orbit_pos.y = obj->pos.y;
-    obj->orbit_dest =
-        vec2f_create((random_float(&obj->gs->rand) * 280.0f) + 20.0f, (random_float(&obj->gs->rand) * 160.0f) + 20.0f);
-    log_debug("new position is %f, %f", obj->orbit_dest.x, obj->orbit_dest.y);
+    obj->orbit_dest = random_destination(obj);
+    log_debug("new position is %f, %f", phys_to_float(obj->orbit_dest.x), phys_to_float(obj->orbit_dest.y));
 
     return 0;
 }
@@ -2,11 +2,12 @@
 #include "game/game_player.h"
 #include "game/game_state.h"
 #include "game/objects/arena_constraints.h"
+#include "game/utils/state_hash.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
 #include <stdlib.h>
 
-#define IS_ZERO(n) (n < 0.1 && n > -0.1)
+#define IS_ZERO(n) (n < phys_from_float(0.1f) && n > phys_from_float(-0.1f))
 
 typedef struct projectile_local_t {
     uint8_t player_id;
@@ -49,44 +50,45 @@ void projectile_move(object *obj) {
     game_player *player = game_state_get_player(gs, projectile_get_owner(obj));
     object *obj_har = game_state_find_object(gs, game_player_get_har_obj_id(player));
 
-    obj->pos.x += obj->vel.x * obj_har->horizontal_velocity_modifier;
+    obj->pos.x += phys_mul(obj->vel.x, obj_har->horizontal_velocity_modifier);
     obj->vel.y += obj->gravity;
-    obj->pos.y += obj->vel.y * obj_har->vertical_velocity_modifier;
+    obj->pos.y += phys_mul(obj->vel.y, obj_har->vertical_velocity_modifier);
 
-    float dampen = 0.7f;
+    phys dampen = phys_from_float(0.7f);
 
     // If wall bounce flag is on, bounce the projectile on wall hit
     // Otherwise kill it.
     if(local->wall_bounce) {
-        if(obj->pos.x < ARENA_LEFT_WALL) {
-            obj->pos.x = ARENA_LEFT_WALL;
-            obj->vel.x = -obj->vel.x * dampen;
+        if(obj->pos.x < phys_from_int(ARENA_LEFT_WALL)) {
+            obj->pos.x = phys_from_int(ARENA_LEFT_WALL);
+            obj->vel.x = -phys_mul(obj->vel.x, dampen);
         }
-        if(obj->pos.x > ARENA_RIGHT_WALL) {
-            obj->pos.x = ARENA_RIGHT_WALL;
-            obj->vel.x = -obj->vel.x * dampen;
+        if(obj->pos.x > phys_from_int(ARENA_RIGHT_WALL)) {
+            obj->pos.x = phys_from_int(ARENA_RIGHT_WALL);
+            obj->vel.x = -phys_mul(obj->vel.x, dampen);
         }
     } else if(!local->invincible) {
-        if(obj->pos.x < ARENA_LEFT_WALL) {
-            obj->pos.x = ARENA_LEFT_WALL;
+        if(obj->pos.x < phys_from_int(ARENA_LEFT_WALL)) {
+            obj->pos.x = phys_from_int(ARENA_LEFT_WALL);
             obj->animation_state.finished = 1;
         }
-        if(obj->pos.x > ARENA_RIGHT_WALL) {
-            obj->pos.x = ARENA_RIGHT_WALL;
+        if(obj->pos.x > phys_from_int(ARENA_RIGHT_WALL)) {
+            obj->pos.x = phys_from_int(ARENA_RIGHT_WALL);
             obj->animation_state.finished = 1;
         }
     }
-    if(obj->pos.y > ARENA_FLOOR && local->wall_bounce) {
-        obj->pos.y = ARENA_FLOOR;
-        obj->vel.y = -obj->vel.y * dampen;
-        obj->vel.x = obj->vel.x * dampen;
-    } else if(obj->pos.y > ARENA_FLOOR) {
-        obj->pos.y = ARENA_FLOOR;
+    if(obj->pos.y > phys_from_int(ARENA_FLOOR) && local->wall_bounce) {
+        obj->pos.y = phys_from_int(ARENA_FLOOR);
+        obj->vel.y = -phys_mul(obj->vel.y, dampen);
+        obj->vel.x = phys_mul(obj->vel.x, dampen);
+    } else if(obj->pos.y > phys_from_int(ARENA_FLOOR)) {
+        obj->pos.y = phys_from_int(ARENA_FLOOR);
         obj->animation_state.finished = 1;
         projectile_finished(obj);
     }
-    if(obj->pos.y >= (ARENA_FLOOR - 5) && IS_ZERO(obj->vel.x) && obj->vel.y < obj->gravity * 1.1 &&
-       obj->vel.y > obj->gravity * -1.1 && local->ground_freeze) {
+    if(obj->pos.y >= phys_from_int(ARENA_FLOOR - 5) && IS_ZERO(obj->vel.x) &&
+       obj->vel.y < phys_scale(obj->gravity, 11, 10) && obj->vel.y > phys_scale(obj->gravity, -11, 10) &&
+       local->ground_freeze) {
 
         object_disable_rewind_tag(obj, 1);
     }
@@ -97,6 +99,7 @@ void projectile_move(object *obj) {
 int projectile_clone(object *src, object *dst) {
     projectile_local *local = omf_calloc(1, sizeof(projectile_local));
     memcpy(local, object_get_userdata(src), sizeof(projectile_local));
+    dst->gs->clone_struct_bytes += sizeof(projectile_local);
     object_set_userdata(dst, local);
     return 0;
 }
@@ -108,6 +111,44 @@ int projectile_clone_free(object *obj) {
     return 0;
 }
 
+int projectile_serialize(const object *obj, serial *ser) {
+    const projectile_local *local = object_get_userdata(obj);
+    serial_write_int8(ser, local->player_id);
+    serial_write_ptr(ser, local->af_data);
+    serial_write_int32(ser, local->wall_bounce);
+    serial_write_int32(ser, local->ground_freeze);
+    serial_write_int32(ser, local->invincible);
+    serial_write_int8(ser, local->has_hit);
+    serial_write_uint32(ser, local->linked_obj);
+    return 0;
+}
+
+int projectile_unserialize(object *obj, serial *ser) {
+    projectile_local *local = object_get_userdata(obj);
+    if(local == NULL) {
+        local = omf_calloc(1, sizeof(projectile_local));
+        object_set_userdata(obj, local);
+    }
+    local->player_id = serial_read_int8(ser);
+    serial_read_ptr(ser, local->af_data);
+    local->wall_bounce = serial_read_int32(ser);
+    local->ground_freeze = serial_read_int32(ser);
+    local->invincible = serial_read_int32(ser);
+    local->has_hit = serial_read_int8(ser);
+    local->linked_obj = serial_read_uint32(ser);
+    return 0;
+}
+
+void projectile_hash(const object *obj, state_hash *h) {
+    const projectile_local *local = object_get_userdata(obj);
+    state_hash_int(h, "player_id", local->player_id);
+    state_hash_int(h, "wall_bounce", local->wall_bounce);
+    state_hash_int(h, "ground_freeze", local->ground_freeze);
+    state_hash_int(h, "invincible", local->invincible);
+    state_hash_int(h, "has_hit", local->has_hit);
+    state_hash_int(h, "linked", local->linked_obj != 0);
+}
+
 int projectile_create(object *obj, har *har) {
     // strore the HAR in local userdata instead
     projectile_local *local = omf_calloc(1, sizeof(projectile_local));
@@ -124,6 +165,9 @@ int projectile_create(object *obj, har *har) {
     object_set_finish_cb(obj, projectile_finished);
     obj->clone = projectile_clone;
     obj->clone_free = projectile_clone_free;
+    obj->serialize = projectile_serialize;
+    obj->unserialize = projectile_unserialize;
+    obj->hash = projectile_hash;
     return 0;
 }
 
@@ -1,6 +1,8 @@
 #include <assert.h>
+#include <stdlib.h>
 
 #include "game/protos/intersect.h"
+#include "utils/miscmath.h"
 
 /**
  * \brief Checks if objects hitboxes intersect.
@@ -85,14 +87,14 @@ int intersect_sprite_hitpoint(object *obj, object *target, int level, vec2i *poi
     vec2i size_a = object_get_size(obj);
     vec2i size_b = object_get_size(target);
 
-    if((object_get_direction(obj) == OBJECT_FACE_LEFT && !player_frame_isset(obj, "r")) ||
-       (object_get_direction(obj) == OBJECT_FACE_RIGHT && player_frame_isset(obj, "r"))) {
+    if((object_get_direction(obj) == OBJECT_FACE_LEFT && !player_frame_isset(obj, SD_TAG_R)) ||
+       (object_get_direction(obj) == OBJECT_FACE_RIGHT && player_frame_isset(obj, SD_TAG_R))) {
         object_dir = OBJECT_FACE_LEFT;
         pos_a.x = object_get_pos(obj).x + ((cur_sprite->pos.x * -1) - size_a.x);
     }
 
-    if((object_get_direction(target) == OBJECT_FACE_LEFT && !player_frame_isset(target, "r")) ||
-       (object_get_direction(target) == OBJECT_FACE_RIGHT && player_frame_isset(target, "r"))) {
+    if((object_get_direction(target) == OBJECT_FACE_LEFT && !player_frame_isset(target, SD_TAG_R)) ||
+       (object_get_direction(target) == OBJECT_FACE_RIGHT && player_frame_isset(target, SD_TAG_R))) {
         target_dir = OBJECT_FACE_LEFT;
         pos_b.x = object_get_pos(target).x + ((target_sprite->pos.x * -1) - size_b.x);
     }
@@ -149,3 +151,62 @@ int intersect_sprite_hitpoint(object *obj, object *target, int level, vec2i *poi
 
     return 0;
 }
+
+/**
+ * \brief Computes a box that contains the current sprite and the hitpoints of the current frame.
+ *
+ * The box is mirrored around the object position, so that it is valid for both facing
+ * directions. This makes it a cheap, conservative bound for intersect_sprite_hitpoint.
+ *
+ * \param obj Object to check
+ * \param min Top left corner of the box
+ * \param max Bottom right corner of the box
+ * \return 1 if the object has a sprite, 0 if not.
+ */
+static int intersect_sprite_extents(object *obj, vec2i *min, vec2i *max) {
+    if(obj->cur_sprite_id < 0) {
+        return 0;
+    }
+    sprite *cur_sprite = animation_get_sprite(obj->cur_animation, obj->cur_sprite_id);
+    if(cur_sprite == NULL) {
+        return 0;
+    }
+    vec2i size = object_get_size(obj);
+    int reach = max2(abs(cur_sprite->pos.x), abs(cur_sprite->pos.x + size.x));
+    int top = cur_sprite->pos.y;
+    int bottom = cur_sprite->pos.y + size.y;
+
+    iterator it;
+    collision_coord *cc;
+    vector_iter_begin(&obj->cur_animation->collision_coords, &it);
+    foreach(it, cc) {
+        if(cc->frame_index != obj->cur_sprite_id)
+            continue;
+        reach = max2(reach, abs(cc->pos.x));
+        top = min2(top, cc->pos.y);
+        bottom = max2(bottom, cc->pos.y);
+    }
+
+    vec2i pos = object_get_pos(obj);
+    *min = vec2i_create(pos.x - reach, pos.y + top);
+    *max = vec2i_create(pos.x + reach, pos.y + bottom);
+    return 1;
+}
+
+/**
+ * \brief Checks if two objects are close enough for their hitpoints to hit each other.
+ *
+ * This is a broad phase check for intersect_sprite_hitpoint. If this returns 0, then
+ * intersect_sprite_hitpoint will not find a collision in either direction.
+ *
+ * \param a Object 1 to check
+ * \param b Object 2 to check
+ * \return 1 if a collision is possible, 0 if not.
+ */
+int intersect_sprite_extents_overlap(object *a, object *b) {
+    vec2i min_a, max_a, min_b, max_b;
+    if(!intersect_sprite_extents(a, &min_a, &max_a) || !intersect_sprite_extents(b, &min_b, &max_b)) {
+        return 0;
+    }
+    return !(min_a.x > max_b.x || min_a.y > max_b.y || max_a.x < min_b.x || max_a.y < min_b.y);
+}
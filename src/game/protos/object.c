@@ -2,6 +2,7 @@
 #include "formats/sprite.h"
 #include "game/game_state.h"
 #include "game/objects/arena_constraints.h"
+#include "game/utils/state_hash.h"
 #include "utils/allocator.h"
 #include "utils/c_string_util.h"
 #include "utils/log.h"
@@ -28,11 +29,11 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     obj->id = object_id++;
 
     // Position related
-    obj->pos = vec2i_to_f(pos);
+    obj->pos = vec2i_to_p(pos);
     // remember the place we were spawned, the x= and y= tags are relative to that
-    obj->start = vec2i_to_f(pos);
-    obj->vel = vel;
-    obj->horizontal_velocity_modifier = obj->vertical_velocity_modifier = 1.0f;
+    obj->start = vec2i_to_p(pos);
+    obj->vel = vec2f_to_p(vel);
+    obj->horizontal_velocity_modifier = obj->vertical_velocity_modifier = phys_from_int(1);
     obj->direction = OBJECT_FACE_RIGHT;
     obj->y_percent = 1.0;
     obj->x_percent = 1.0;
@@ -40,7 +41,7 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     // Physics
     obj->layers = OBJECT_DEFAULT_LAYER;
     obj->group = GROUP_UNKNOWN;
-    obj->gravity = 0.0f;
+    obj->gravity = 0;
 
     // Video effect stuff
     obj->animation_video_effects = 0;
@@ -92,17 +93,22 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     obj->debug = NULL;
     obj->clone = NULL;
     obj->clone_free = NULL;
+    obj->serialize = NULL;
+    obj->unserialize = NULL;
+    obj->hash = NULL;
 }
 
 int object_clone(object *src, object *dst, game_state *gs) {
     memcpy(dst, src, sizeof(object));
     dst->gs = gs;
-    player_clone(src, dst);
+    gs->clone_struct_bytes += sizeof(object);
 
     if(src->cur_animation_own == OWNER_OBJECT) {
         dst->cur_animation = omf_calloc(1, sizeof(animation));
         animation_clone(src->cur_animation, dst->cur_animation);
+        gs->clone_struct_bytes += sizeof(animation);
     }
+    player_clone(src, dst);
 
     if(src->clone) {
         src->clone(src, dst);
@@ -111,6 +117,198 @@ int object_clone(object *src, object *dst, game_state *gs) {
     return 0;
 }
 
+/** Writes the object state into a snapshot buffer, field by field. Callbacks, the animation and other pointers
+ * to resources that outlive the snapshot are written as they are, so the snapshot is only valid within the
+ * running process. The object id is written by the game state. The serialize callback writes the userdata,
+ * followed by the animation playback state.
+ * \param obj Object handle
+ * \param ser Snapshot buffer to append to
+ * \return 0 on success, 1 if the object owns its animation and cannot be snapshotted.
+ */
+int object_serialize(const object *obj, serial *ser) {
+    if(obj->cur_animation_own == OWNER_OBJECT) {
+        return 1;
+    }
+    serial_write_vec2p(ser, obj->start);
+    serial_write_vec2p(ser, obj->pos);
+    serial_write_vec2p(ser, obj->vel);
+    serial_write_phys(ser, obj->vertical_velocity_modifier);
+    serial_write_phys(ser, obj->horizontal_velocity_modifier);
+    serial_write_int8(ser, obj->direction);
+    serial_write_int8(ser, obj->group);
+    serial_write_int8(ser, obj->q_counter);
+    serial_write_int8(ser, obj->q_val);
+    serial_write_int8(ser, obj->can_hit);
+    serial_write_int8(ser, obj->orbit);
+    serial_write_float(ser, obj->orbit_tick);
+    serial_write_vec2p(ser, obj->orbit_dest);
+    serial_write_float(ser, obj->orbit_dest_dir.x);
+    serial_write_float(ser, obj->orbit_dest_dir.y);
+    serial_write_vec2p(ser, obj->orbit_pos);
+    serial_write_float(ser, obj->orbit_pos_vary.x);
+    serial_write_float(ser, obj->orbit_pos_vary.y);
+    serial_write_uint32(ser, obj->rand_state.seed);
+    serial_write_float(ser, obj->x_percent);
+    serial_write_float(ser, obj->y_percent);
+    serial_write_phys(ser, obj->gravity);
+    serial_write_uint32(ser, obj->frame_video_effects);
+    serial_write_uint32(ser, obj->animation_video_effects);
+    serial_write_int8(ser, obj->layers);
+    serial_write_ptr(ser, obj->cur_animation);
+    serial_write_int32(ser, obj->cur_sprite_id);
+    serial_write_ptr(ser, obj->sound_translation_table);
+    serial_write_int8(ser, obj->sprite_override);
+    serial_write_uint32(ser, obj->attached_to_id);
+    serial_write_int8(ser, obj->pal_offset);
+    serial_write_int8(ser, obj->pal_limit);
+    serial_write_int8(ser, obj->halt);
+    serial_write_int16(ser, obj->halt_ticks);
+    serial_write_int8(ser, obj->stride);
+    serial_write_int8(ser, obj->cast_shadow);
+    serial_write_ptr(ser, obj->cur_surface);
+    serial_write_uint32(ser, obj->age);
+
+    serial_write_ptr(ser, obj->free);
+    serial_write_ptr(ser, obj->act);
+    serial_write_ptr(ser, obj->static_tick);
+    serial_write_ptr(ser, obj->dynamic_tick);
+    serial_write_ptr(ser, obj->collide);
+    serial_write_ptr(ser, obj->finish);
+    serial_write_ptr(ser, obj->move);
+    serial_write_ptr(ser, obj->palette_transform);
+    serial_write_ptr(ser, obj->debug);
+    serial_write_ptr(ser, obj->clone);
+    serial_write_ptr(ser, obj->clone_free);
+    serial_write_ptr(ser, obj->serialize);
+    serial_write_ptr(ser, obj->unserialize);
+    serial_write_ptr(ser, obj->hash);
+
+    if(obj->serialize != NULL) {
+        obj->serialize(obj, ser);
+    }
+    player_serialize(obj, ser);
+    return 0;
+}
+
+/** Restores the object state from a snapshot buffer written by object_serialize().
+ * Only the fields in the snapshot are touched. The userdata and parser storage of a live object are
+ * overwritten in place; a zeroed object gets its userdata allocated by the unserialize callback.
+ * \param obj Object handle
+ * \param ser Snapshot buffer to read from
+ * \param gs Game state the object belongs to
+ * \return 0
+ */
+int object_unserialize(object *obj, serial *ser, game_state *gs) {
+    obj->gs = gs;
+    obj->start = serial_read_vec2p(ser);
+    obj->pos = serial_read_vec2p(ser);
+    obj->vel = serial_read_vec2p(ser);
+    obj->vertical_velocity_modifier = serial_read_phys(ser);
+    obj->horizontal_velocity_modifier = serial_read_phys(ser);
+    obj->direction = serial_read_int8(ser);
+    obj->group = serial_read_int8(ser);
+    obj->q_counter = serial_read_int8(ser);
+    obj->q_val = serial_read_int8(ser);
+    obj->can_hit = serial_read_int8(ser);
+    obj->orbit = serial_read_int8(ser);
+    obj->orbit_tick = serial_read_float(ser);
+    obj->orbit_dest = serial_read_vec2p(ser);
+    obj->orbit_dest_dir.x = serial_read_float(ser);
+    obj->orbit_dest_dir.y = serial_read_float(ser);
+    obj->orbit_pos = serial_read_vec2p(ser);
+    obj->orbit_pos_vary.x = serial_read_float(ser);
+    obj->orbit_pos_vary.y = serial_read_float(ser);
+    random_seed(&obj->rand_state, serial_read_uint32(ser));
+    obj->x_percent = serial_read_float(ser);
+    obj->y_percent = serial_read_float(ser);
+    obj->gravity = serial_read_phys(ser);
+    obj->frame_video_effects = serial_read_uint32(ser);
+    obj->animation_video_effects = serial_read_uint32(ser);
+    obj->layers = serial_read_int8(ser);
+    obj->cur_animation_own = OWNER_EXTERNAL;
+    serial_read_ptr(ser, obj->cur_animation);
+    obj->cur_sprite_id = serial_read_int32(ser);
+    serial_read_ptr(ser, obj->sound_translation_table);
+    obj->sprite_override = serial_read_int8(ser);
+    obj->attached_to_id = serial_read_uint32(ser);
+    obj->pal_offset = serial_read_int8(ser);
+    obj->pal_limit = serial_read_int8(ser);
+    obj->halt = serial_read_int8(ser);
+    obj->halt_ticks = serial_read_int16(ser);
+    obj->stride = serial_read_int8(ser);
+    obj->cast_shadow = serial_read_int8(ser);
+    serial_read_ptr(ser, obj->cur_surface);
+    obj->age = serial_read_uint32(ser);
+
+    serial_read_ptr(ser, obj->free);
+    serial_read_ptr(ser, obj->act);
+    serial_read_ptr(ser, obj->static_tick);
+    serial_read_ptr(ser, obj->dynamic_tick);
+    serial_read_ptr(ser, obj->collide);
+    serial_read_ptr(ser, obj->finish);
+    serial_read_ptr(ser, obj->move);
+    serial_read_ptr(ser, obj->palette_transform);
+    serial_read_ptr(ser, obj->debug);
+    serial_read_ptr(ser, obj->clone);
+    serial_read_ptr(ser, obj->clone_free);
+    serial_read_ptr(ser, obj->serialize);
+    serial_read_ptr(ser, obj->unserialize);
+    serial_read_ptr(ser, obj->hash);
+
+    if(obj->unserialize != NULL) {
+        obj->unserialize(obj, ser);
+    }
+    player_unserialize(obj, ser);
+    return 0;
+}
+
+/** Feeds the gameplay state of the object into a state hash, followed by whatever the hash callback adds for
+ * userdata. Object ids are left out, since peers number their objects differently. rand_state is left out too;
+ * nothing draws from it, and it is seeded from the unsynchronised global RNG.
+ * \param obj Object handle
+ * \param h State hash, with the section of the object already started
+ */
+void object_hash(const object *obj, state_hash *h) {
+    state_hash_int(h, "group", obj->group);
+    state_hash_int(h, "direction", obj->direction);
+    state_hash_phys(h, "start.x", obj->start.x);
+    state_hash_phys(h, "start.y", obj->start.y);
+    state_hash_phys(h, "pos.x", obj->pos.x);
+    state_hash_phys(h, "pos.y", obj->pos.y);
+    state_hash_phys(h, "vel.x", obj->vel.x);
+    state_hash_phys(h, "vel.y", obj->vel.y);
+    state_hash_phys(h, "vvel_mod", obj->vertical_velocity_modifier);
+    state_hash_phys(h, "hvel_mod", obj->horizontal_velocity_modifier);
+    state_hash_phys(h, "gravity", obj->gravity);
+    state_hash_float(h, "x_percent", obj->x_percent);
+    state_hash_float(h, "y_percent", obj->y_percent);
+    state_hash_int(h, "q_counter", obj->q_counter);
+    state_hash_int(h, "q_val", obj->q_val);
+    state_hash_int(h, "can_hit", obj->can_hit);
+    state_hash_int(h, "orbit", obj->orbit);
+    if(obj->orbit) {
+        state_hash_float(h, "orbit_tick", obj->orbit_tick);
+        state_hash_phys(h, "orbit_dest.x", obj->orbit_dest.x);
+        state_hash_phys(h, "orbit_dest.y", obj->orbit_dest.y);
+        state_hash_phys(h, "orbit_pos.x", obj->orbit_pos.x);
+        state_hash_phys(h, "orbit_pos.y", obj->orbit_pos.y);
+    }
+    state_hash_int(h, "layers", obj->layers);
+    state_hash_int(h, "animation", obj->cur_animation != NULL ? obj->cur_animation->id : -1);
+    state_hash_int(h, "sprite", obj->cur_sprite_id);
+    state_hash_int(h, "sprite_override", obj->sprite_override);
+    state_hash_int(h, "attached", obj->attached_to_id != 0);
+    state_hash_int(h, "animation_effects", obj->animation_video_effects);
+    state_hash_int(h, "halt", obj->halt);
+    state_hash_int(h, "halt_ticks", obj->halt_ticks);
+    state_hash_int(h, "stride", obj->stride);
+    state_hash_int(h, "age", obj->age);
+    player_hash(obj, h);
+    if(obj->hash != NULL) {
+        obj->hash(obj, h);
+    }
+}
+
 // FIXME: This was removed in HEAD, not sure why or what is the replacement
 // TODO: GET RID
 void object_create_static(object *obj, game_state *gs) {
@@ -304,28 +502,28 @@ void object_del_frame_effects(object *obj, uint32_t effects) {
 }
 
 void object_apply_controllable_velocity(object *obj, object *obj_har, char input) {
-    if(player_frame_isset(obj, "cx")) {
-        float cx = player_frame_get(obj, "cx") / 10.0 * obj_har->horizontal_velocity_modifier;
+    if(player_frame_isset(obj, SD_TAG_CX)) {
+        phys cx = phys_scale(obj_har->horizontal_velocity_modifier, player_frame_get(obj, SD_TAG_CX), 10);
         if(input == '4') {
             obj->vel.x -= cx * object_get_direction(obj);
         } else if(input == '6') {
             obj->vel.x += cx * object_get_direction(obj);
         } else if(input == '3' || input == '9') {
-            obj->vel.x += cx * 0.7 * object_get_direction(obj);
+            obj->vel.x += phys_scale(cx, 7, 10) * object_get_direction(obj);
         } else if(input == '1' || input == '7') {
-            obj->vel.x -= cx * 0.7 * object_get_direction(obj);
+            obj->vel.x -= phys_scale(cx, 7, 10) * object_get_direction(obj);
         }
         // CY needs CX to be set
-        if(player_frame_isset(obj, "cy")) {
-            float cy = player_frame_get(obj, "cx") / 10.0 * obj->vertical_velocity_modifier;
+        if(player_frame_isset(obj, SD_TAG_CY)) {
+            phys cy = phys_scale(obj->vertical_velocity_modifier, player_frame_get(obj, SD_TAG_CX), 10);
             if(input == '8') {
                 obj->vel.y -= cy * object_get_direction(obj);
             } else if(input == '2') {
                 obj->vel.y += cy * object_get_direction(obj);
             } else if(input == '3' || input == '1') {
-                obj->vel.y += cy * 0.7 * object_get_direction(obj);
+                obj->vel.y += phys_scale(cy, 7, 10) * object_get_direction(obj);
             } else if(input == '7' || input == '9') {
-                obj->vel.y -= cy * 0.7 * object_get_direction(obj);
+                obj->vel.y -= phys_scale(cy, 7, 10) * object_get_direction(obj);
             }
         }
     }
@@ -354,20 +552,22 @@ void object_render(object *obj) {
 
     // Set Y coord, take into account sprite flipping
     if(rstate->flipmode & FLIP_VERTICAL) {
-        y = obj->pos.y - cur_sprite->pos.y + rstate->o_correction.y - object_get_size(obj).y;
+        y = phys_to_int(obj->pos.y +
+                        phys_from_int(rstate->o_correction.y - cur_sprite->pos.y - object_get_size(obj).y));
 
         if(obj->cur_animation->id == ANIM_JUMPING) {
             y -= 100;
         }
     } else {
-        y = obj->pos.y + cur_sprite->pos.y + rstate->o_correction.y;
+        y = phys_to_int(obj->pos.y + phys_from_int(cur_sprite->pos.y + rstate->o_correction.y));
     }
 
     // Set X coord, take into account the HAR facing.
     if(object_get_direction(obj) == OBJECT_FACE_LEFT) {
-        x = obj->pos.x - cur_sprite->pos.x + rstate->o_correction.x - object_get_size(obj).x;
+        x = phys_to_int(obj->pos.x +
+                        phys_from_int(rstate->o_correction.x - cur_sprite->pos.x - object_get_size(obj).x));
     } else {
-        x = obj->pos.x + cur_sprite->pos.x + rstate->o_correction.x;
+        x = phys_to_int(obj->pos.x + phys_from_int(cur_sprite->pos.x + rstate->o_correction.x));
     }
 
     // Centrify if scaled
@@ -441,9 +641,10 @@ void object_render_shadow(object *obj) {
 
     // Determine X
     int flip_mode = obj->sprite_state.flipmode;
-    int x = obj->pos.x + cur_sprite->pos.x + obj->sprite_state.o_correction.x;
+    int x = phys_to_int(obj->pos.x + phys_from_int(cur_sprite->pos.x + obj->sprite_state.o_correction.x));
     if(object_get_direction(obj) == OBJECT_FACE_LEFT) {
-        x = (obj->pos.x + obj->sprite_state.o_correction.x) - cur_sprite->pos.x - object_get_size(obj).x;
+        x = phys_to_int(obj->pos.x +
+                        phys_from_int(obj->sprite_state.o_correction.x - cur_sprite->pos.x - object_get_size(obj).x));
         flip_mode ^= FLIP_HORIZONTAL;
     }
 
@@ -568,7 +769,7 @@ void object_set_animation(object *obj, animation *ani) {
 
     // Debug texts
     if(obj->cur_animation->id == -1) {
-        log_debug("Custom object set to (x,y) = (%f,%f).", obj->pos.x, obj->pos.y);
+        log_debug("Custom object set to (x,y) = (%f,%f).", phys_to_float(obj->pos.x), phys_to_float(obj->pos.y));
     } else {
         /*log_debug("Animation object %d set to (x,y) = (%f,%f) with \"%s\".", */
         /*obj->cur_animation->id,*/
@@ -664,11 +865,11 @@ void object_set_group(object *obj, int group) {
     obj->group = group;
 }
 void object_set_gravity(object *obj, float gravity) {
-    obj->gravity = gravity;
+    obj->gravity = phys_from_float(gravity);
 }
 
 float object_get_gravity(const object *obj) {
-    return obj->gravity;
+    return phys_to_float(obj->gravity);
 }
 int object_get_group(const object *obj) {
     return obj->group;
@@ -738,42 +939,42 @@ int object_h(const object *obj) {
     return object_get_size(obj).y;
 }
 int object_px(const object *obj) {
-    return vec2f_to_i(obj->pos).x;
+    return phys_to_int(obj->pos.x);
 }
 int object_py(const object *obj) {
-    return vec2f_to_i(obj->pos).y;
+    return phys_to_int(obj->pos.y);
 }
 float object_vx(const object *obj) {
-    return obj->vel.x;
+    return phys_to_float(obj->vel.x);
 }
 float object_vy(const object *obj) {
-    return obj->vel.y;
+    return phys_to_float(obj->vel.y);
 }
 
 void object_set_px(object *obj, int val) {
-    obj->pos.x = val;
+    obj->pos.x = phys_from_int(val);
 }
 void object_set_py(object *obj, int val) {
-    obj->pos.y = val;
+    obj->pos.y = phys_from_int(val);
 }
 void object_set_vx(object *obj, float val) {
-    obj->vel.x = val;
+    obj->vel.x = phys_from_float(val);
 }
 void object_set_vy(object *obj, float val) {
-    obj->vel.y = val;
+    obj->vel.y = phys_from_float(val);
 }
 
 vec2i object_get_pos(const object *obj) {
-    return vec2f_to_i(obj->pos);
+    return vec2p_to_i(obj->pos);
 }
 vec2f object_get_vel(const object *obj) {
-    return obj->vel;
+    return vec2p_to_f(obj->vel);
 }
 void object_set_pos(object *obj, vec2i pos) {
-    obj->pos = vec2i_to_f(pos);
+    obj->pos = vec2i_to_p(pos);
 }
 void object_set_vel(object *obj, vec2f vel) {
-    obj->vel = vel;
+    obj->vel = vec2f_to_p(vel);
 }
 
 vec2i object_get_size(const object *obj) {
@@ -807,7 +1008,7 @@ void object_set_destroy_cb(object *obj, object_state_del_cb cbf, void *userdata)
 }
 
 int object_is_airborne(const object *obj) {
-    return obj->pos.y < ARENA_FLOOR;
+    return obj->pos.y < phys_from_int(ARENA_FLOOR);
 }
 
 /* Attaches one object to another. Positions are synced to this from the attached. */
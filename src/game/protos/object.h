@@ -2,6 +2,7 @@
 #define OBJECT_H
 
 #include "game/protos/player.h"
+#include "game/utils/phys.h"
 #include "game/utils/serial.h"
 #include "resources/animation.h"
 #include "resources/sprite.h"
@@ -59,6 +60,7 @@ enum
 
 typedef struct object_t object;
 typedef struct game_state_t game_state;
+typedef struct state_hash state_hash;
 
 typedef void (*object_free_cb)(object *obj);
 typedef int (*object_act_cb)(object *obj, int action);
@@ -69,16 +71,19 @@ typedef void (*object_finish_cb)(object *obj);
 typedef void (*object_debug_cb)(object *obj);
 typedef int (*object_clone_cb)(object *src, object *dst);
 typedef int (*object_clone_free_cb)(object *obj);
+typedef int (*object_serialize_cb)(const object *obj, serial *ser);
+typedef int (*object_unserialize_cb)(object *obj, serial *ser);
+typedef void (*object_hash_cb)(const object *obj, state_hash *h);
 
 struct object_t {
     uint32_t id;
     game_state *gs;
 
-    vec2f start;
-    vec2f pos;
-    vec2f vel;
-    float vertical_velocity_modifier;
-    float horizontal_velocity_modifier;
+    vec2p start;
+    vec2p pos;
+    vec2p vel;
+    phys vertical_velocity_modifier;
+    phys horizontal_velocity_modifier;
     int8_t direction;
     int8_t group;
 
@@ -89,16 +94,16 @@ struct object_t {
 
     int8_t orbit;
     float orbit_tick;
-    vec2f orbit_dest;
+    vec2p orbit_dest;
     vec2f orbit_dest_dir;
-    vec2f orbit_pos;
+    vec2p orbit_pos;
     vec2f orbit_pos_vary;
 
     struct random_t rand_state;
 
     float x_percent;
     float y_percent;
-    float gravity;
+    phys gravity;
 
     // Bitmask for several video effects (shadow, etc.)
     uint32_t frame_video_effects;     //< Effects that only last for current frame
@@ -145,6 +150,9 @@ struct object_t {
     object_debug_cb debug;
     object_clone_cb clone;
     object_clone_free_cb clone_free;
+    object_serialize_cb serialize;
+    object_unserialize_cb unserialize;
+    object_hash_cb hash;
 };
 
 void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel);
@@ -165,6 +173,10 @@ void object_free(object *obj);
 int object_clone(object *src, object *dst, game_state *gs);
 int object_clone_free(object *obj);
 
+int object_serialize(const object *obj, serial *ser);
+int object_unserialize(object *obj, serial *ser, game_state *gs);
+void object_hash(const object *obj, state_hash *h);
+
 void object_attach_to(object *obj, const object *attach_to);
 
 void object_set_stride(object *obj, int stride);
@@ -258,8 +270,6 @@ void object_set_vx(object *obj, float val);
 void object_set_vy(object *obj, float val);
 
 uint32_t object_get_age(object *obj);
-serial *object_get_last_serialization_point(const object *obj);
-serial *object_get_serialization_point(const object *obj, unsigned int ticks_ago);
 
 void object_set_spawn_cb(object *obj, object_state_add_cb cbf, void *userdata);
 void object_set_destroy_cb(object *obj, object_state_del_cb cbf, void *userdata);
@@ -9,7 +9,9 @@
 #include "game/protos/object.h"
 #include "game/protos/player.h"
 #include "game/utils/settings.h"
+#include "game/utils/state_hash.h"
 #include "resources/ids.h"
+#include "utils/allocator.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
 #include "utils/random.h"
@@ -27,37 +29,387 @@ static void player_clear_frame(object *obj) {
     s->blend_finish = 0xFF;
 }
 
+// Parser for objects that have no animation yet.
+static sd_script empty_script;
+
+// Private parsers are reference counted, so that cloned objects can share them until one of them needs
+// to make changes.
+typedef struct player_script_t {
+    sd_script script; // Must be first, parser pointers point here
+    unsigned int refs;
+} player_script;
+
+static sd_script *player_script_create(void) {
+    player_script *ps = omf_calloc(1, sizeof(player_script));
+    sd_script_create(&ps->script);
+    ps->refs = 1;
+    return &ps->script;
+}
+
+static void player_script_release(sd_script *script) {
+    player_script *ps = (player_script *)script;
+    if(--ps->refs == 0) {
+        sd_script_free(&ps->script);
+        omf_free(ps);
+    }
+}
+
 void player_create(object *obj) {
     memset(&obj->animation_state, 0, sizeof(player_animation_state));
     obj->animation_state.previous_tick = ~0u;
-    sd_script_create(&obj->animation_state.parser);
+    obj->animation_state.parser = &empty_script;
     player_clear_frame(obj);
 }
 
+/*
+ * Private parsers are shared with the clone, and only copied when either side modifies them.
+ * The animation is cloned before this is called. A parser shared with an animation the source object
+ * owns would go away with the source, so the clone follows its own copy of the animation instead.
+ */
 void player_clone(object *src, object *dst) {
-    sd_script_clone(&src->animation_state.parser, &dst->animation_state.parser);
+    player_animation_state *state = &dst->animation_state;
+    if(state->parser_own) {
+        ((player_script *)state->parser)->refs++;
+    } else if(src->cur_animation != dst->cur_animation && state->parser == &src->cur_animation->script) {
+        state->parser = &dst->cur_animation->script;
+    }
 }
 
 void player_free(object *obj) {
-    sd_script_free(&obj->animation_state.parser);
+    player_animation_state *state = &obj->animation_state;
+    if(state->parser_own) {
+        player_script_release(state->parser);
+    }
+    state->parser = &empty_script;
+    state->parser_own = false;
 }
 
-void player_reload_with_str(object *obj, const char *custom_str) {
-    // Free and reload parser
-    sd_script_free(&obj->animation_state.parser);
-    sd_script_create(&obj->animation_state.parser);
-    int ret;
-    int err_pos;
-    ret = sd_script_decode(&obj->animation_state.parser, custom_str, &err_pos);
-    if(ret != SD_SUCCESS) {
-        log_error("Decoder error %s at position %d in string \"%s\"", sd_get_error(ret), err_pos, custom_str);
+// Gives the object a parser nobody else refers to, so that it can be modified.
+static sd_script *player_own_parser(object *obj) {
+    player_animation_state *state = &obj->animation_state;
+    if(!state->parser_own || ((player_script *)state->parser)->refs > 1) {
+        player_script *ps = omf_calloc(1, sizeof(player_script));
+        sd_script_clone(state->parser, &ps->script);
+        ps->refs = 1;
+        player_free(obj);
+        state->parser = &ps->script;
+        state->parser_own = true;
+    }
+    return state->parser;
+}
+
+// How the spawn and destroy callback userdata is written into snapshots. The callbacks are given either the
+// scene or the userdata of an object, like the object itself or the HAR that fired it. Both belong to the
+// game state, so the owner is written instead and looked up again on restore.
+enum
+{
+    SNAPSHOT_LINK_NONE,
+    SNAPSHOT_LINK_SCENE,
+    SNAPSHOT_LINK_OBJECT,
+    SNAPSHOT_LINK_OTHER,
+};
+
+static const object *player_find_userdata_owner(const object *obj, const void *userdata) {
+    if(obj->userdata == userdata) {
+        return obj;
+    }
+    iterator it;
+    render_obj *robj;
+    vector_iter_begin(&obj->gs->objects, &it);
+    foreach(it, robj) {
+        if(robj->obj->userdata == userdata) {
+            return robj->obj;
+        }
+    }
+    return NULL;
+}
+
+static void player_write_userdata_link(const object *obj, const void *userdata, serial *ser) {
+    if(userdata == NULL) {
+        serial_write_int8(ser, SNAPSHOT_LINK_NONE);
+        return;
+    }
+    if(userdata == obj->gs->sc) {
+        serial_write_int8(ser, SNAPSHOT_LINK_SCENE);
+        return;
+    }
+    const object *owner = player_find_userdata_owner(obj, userdata);
+    if(owner != NULL) {
+        serial_write_int8(ser, SNAPSHOT_LINK_OBJECT);
+        serial_write_uint32(ser, owner->id);
+        return;
+    }
+    serial_write_int8(ser, SNAPSHOT_LINK_OTHER);
+}
+
+// Object links are only resolved by player_link_userdata(), once every object is restored.
+static void *player_read_userdata_link(const object *obj, serial *ser, void *current, uint32_t *owner_id) {
+    *owner_id = 0;
+    switch(serial_read_int8(ser)) {
+        case SNAPSHOT_LINK_NONE:
+            return NULL;
+        case SNAPSHOT_LINK_SCENE:
+            return obj->gs->sc;
+        case SNAPSHOT_LINK_OBJECT:
+            *owner_id = serial_read_uint32(ser);
+            return NULL;
+        default:
+            // Not something the snapshot knows about, keep whatever the object has.
+            return current;
+    }
+}
+
+static void *player_owner_userdata(object *obj, uint32_t owner_id) {
+    object *owner = game_state_find_object(obj->gs, owner_id);
+    if(owner == NULL) {
+        log_warn("Object %u lost the owner %u of its callback userdata in a snapshot", obj->id, owner_id);
+        return NULL;
+    }
+    return owner->userdata;
+}
+
+/*
+ * Points the spawn and destroy userdata of a restored object at the objects that own it. The game state calls
+ * this once every object in the snapshot is restored and indexed, since an owner may come later in the snapshot.
+ */
+void player_link_userdata(object *obj) {
+    player_animation_state *ani = &obj->animation_state;
+    if(ani->spawn_owner_id != 0) {
+        ani->spawn_userdata = player_owner_userdata(obj, ani->spawn_owner_id);
+        if(ani->spawn_userdata == NULL) {
+            ani->spawn = NULL;
+        }
+        ani->spawn_owner_id = 0;
+    }
+    if(ani->destroy_owner_id != 0) {
+        ani->destroy_userdata = player_owner_userdata(obj, ani->destroy_owner_id);
+        if(ani->destroy_userdata == NULL) {
+            ani->destroy = NULL;
+        }
+        ani->destroy_owner_id = 0;
     }
+}
+
+/*
+ * Writes the animation playback state and the parser into a state snapshot, field by field. A parser shared
+ * with an animation is written as a pointer. Private parsers are written frame by frame; tag keys and
+ * descriptions point to the static tag list. Either way the snapshot is only valid within the running process.
+ */
+void player_serialize(const object *obj, serial *ser) {
+    const player_sprite_state *spr = &obj->sprite_state;
+    serial_write_int32(ser, spr->flipmode);
+    serial_write_int32(ser, spr->timer);
+    serial_write_int32(ser, spr->duration);
+    serial_write_int32(ser, spr->screen_shake_horizontal);
+    serial_write_int32(ser, spr->screen_shake_vertical);
+    serial_write_int32(ser, spr->o_correction.x);
+    serial_write_int32(ser, spr->o_correction.y);
+    serial_write_int32(ser, spr->disable_gravity);
+    serial_write_int32(ser, spr->blend_start);
+    serial_write_int32(ser, spr->blend_finish);
+    serial_write_int32(ser, spr->pal_ref_index);
+    serial_write_int32(ser, spr->pal_entry_count);
+    serial_write_int32(ser, spr->pal_start_index);
+    serial_write_int32(ser, spr->pal_begin);
+    serial_write_int32(ser, spr->pal_end);
+    serial_write_int32(ser, spr->pal_tint);
+    serial_write_int8(ser, spr->pal_tricks_off);
+    serial_write_int8(ser, spr->bd_flag);
+
+    const player_animation_state *ani = &obj->animation_state;
+    serial_write_uint32(ser, ani->previous_tick);
+    serial_write_uint32(ser, ani->current_tick);
+    serial_write_int32(ser, ani->previous);
+    serial_write_int32(ser, ani->entered_frame);
+    serial_write_int8(ser, ani->repeat);
+    serial_write_int8(ser, ani->reverse);
+    serial_write_int8(ser, ani->finished);
+    serial_write_int8(ser, ani->disable_d);
+    serial_write_int8(ser, ani->shadow_corner_hack);
+    serial_write_int8(ser, ani->looping);
+    serial_write_int8(ser, ani->pal_copy_entries);
+    serial_write_int8(ser, ani->pal_copy_start);
+    serial_write_int8(ser, ani->pal_copy_count);
+    serial_write_uint32(ser, ani->enemy_obj_id);
+    serial_write_ptr(ser, ani->spawn);
+    serial_write_ptr(ser, ani->destroy);
+    player_write_userdata_link(obj, ani->spawn_userdata, ser);
+    player_write_userdata_link(obj, ani->destroy_userdata, ser);
+
+    serial_write_vec2p(ser, obj->slide_state.vel);
+    serial_write_int32(ser, obj->slide_state.timer);
+    serial_write_int32(ser, obj->enemy_slide_state.dest.x);
+    serial_write_int32(ser, obj->enemy_slide_state.dest.y);
+    serial_write_int32(ser, obj->enemy_slide_state.timer);
+    serial_write_int32(ser, obj->enemy_slide_state.duration);
+
+    const sd_script *parser = ani->parser;
+    serial_write_int8(ser, ani->parser_own);
+    if(!ani->parser_own) {
+        serial_write_ptr(ser, parser);
+        return;
+    }
+
+    uint32_t frame_count = vector_size(&parser->frames);
+    serial_write_uint32(ser, frame_count);
+    for(unsigned i = 0; i < frame_count; i++) {
+        const sd_script_frame *frame = vector_get(&parser->frames, i);
+        uint32_t tag_count = vector_size(&frame->tags);
+        serial_write_int32(ser, frame->sprite);
+        serial_write_int32(ser, frame->tick_len);
+        serial_write_uint32(ser, tag_count);
+        for(unsigned k = 0; k < tag_count; k++) {
+            const sd_script_tag *tag = vector_get(&frame->tags, k);
+            serial_write_ptr(ser, tag->key);
+            serial_write_ptr(ser, tag->desc);
+            serial_write_int32(ser, tag->has_param);
+            serial_write_int32(ser, tag->value);
+        }
+    }
+}
+
+/*
+ * Restores the animation playback state and the parser from a state snapshot. Shared parsers are simply
+ * pointed at again. For private parsers not shared with a clone, the existing frame and tag storage is reused,
+ * so this does not allocate unless the snapshot has more frames or tags than the parser has ever held.
+ * Callback userdata owned by objects is left for player_link_userdata().
+ */
+void player_unserialize(object *obj, serial *ser) {
+    player_sprite_state *spr = &obj->sprite_state;
+    spr->flipmode = serial_read_int32(ser);
+    spr->timer = serial_read_int32(ser);
+    spr->duration = serial_read_int32(ser);
+    spr->screen_shake_horizontal = serial_read_int32(ser);
+    spr->screen_shake_vertical = serial_read_int32(ser);
+    spr->o_correction.x = serial_read_int32(ser);
+    spr->o_correction.y = serial_read_int32(ser);
+    spr->disable_gravity = serial_read_int32(ser);
+    spr->blend_start = serial_read_int32(ser);
+    spr->blend_finish = serial_read_int32(ser);
+    spr->pal_ref_index = serial_read_int32(ser);
+    spr->pal_entry_count = serial_read_int32(ser);
+    spr->pal_start_index = serial_read_int32(ser);
+    spr->pal_begin = serial_read_int32(ser);
+    spr->pal_end = serial_read_int32(ser);
+    spr->pal_tint = serial_read_int32(ser);
+    spr->pal_tricks_off = serial_read_int8(ser);
+    spr->bd_flag = serial_read_int8(ser);
+
+    player_animation_state *ani = &obj->animation_state;
+    ani->previous_tick = serial_read_uint32(ser);
+    ani->current_tick = serial_read_uint32(ser);
+    ani->previous = serial_read_int32(ser);
+    ani->entered_frame = serial_read_int32(ser);
+    ani->repeat = serial_read_int8(ser);
+    ani->reverse = serial_read_int8(ser);
+    ani->finished = serial_read_int8(ser);
+    ani->disable_d = serial_read_int8(ser);
+    ani->shadow_corner_hack = serial_read_int8(ser);
+    ani->looping = serial_read_int8(ser);
+    ani->pal_copy_entries = serial_read_int8(ser);
+    ani->pal_copy_start = serial_read_int8(ser);
+    ani->pal_copy_count = serial_read_int8(ser);
+    ani->enemy_obj_id = serial_read_uint32(ser);
+    serial_read_ptr(ser, ani->spawn);
+    serial_read_ptr(ser, ani->destroy);
+    ani->spawn_userdata = player_read_userdata_link(obj, ser, ani->spawn_userdata, &ani->spawn_owner_id);
+    ani->destroy_userdata = player_read_userdata_link(obj, ser, ani->destroy_userdata, &ani->destroy_owner_id);
+
+    obj->slide_state.vel = serial_read_vec2p(ser);
+    obj->slide_state.timer = serial_read_int32(ser);
+    obj->enemy_slide_state.dest.x = serial_read_int32(ser);
+    obj->enemy_slide_state.dest.y = serial_read_int32(ser);
+    obj->enemy_slide_state.timer = serial_read_int32(ser);
+    obj->enemy_slide_state.duration = serial_read_int32(ser);
+
+    if(!serial_read_int8(ser)) {
+        sd_script *shared = NULL;
+        serial_read_ptr(ser, shared);
+        player_free(obj);
+        ani->parser = shared;
+        return;
+    }
+
+    // Overwrite the private parser in place, unless a clone is still using it
+    sd_script *parser = ani->parser;
+    if(!ani->parser_own || ((player_script *)parser)->refs > 1) {
+        parser = player_script_create();
+        player_free(obj);
+        ani->parser = parser;
+        ani->parser_own = true;
+    }
+
+    uint32_t frame_count = serial_read_uint32(ser);
 
-    // Set player state
+    // Drop surplus frames, the rest are overwritten below.
+    while(vector_size(&parser->frames) > frame_count) {
+        sd_script_frame_free(vector_back(&parser->frames));
+        vector_pop(&parser->frames);
+    }
+
+    for(unsigned i = 0; i < frame_count; i++) {
+        int sprite = serial_read_int32(ser);
+        int tick_len = serial_read_int32(ser);
+        uint32_t tag_count = serial_read_uint32(ser);
+
+        sd_script_frame *frame = vector_get(&parser->frames, i);
+        if(frame == NULL) {
+            sd_script_append_frame(parser, tick_len, sprite);
+            frame = vector_back(&parser->frames);
+        }
+        frame->sprite = sprite;
+        frame->tick_len = tick_len;
+        vector_clear(&frame->tags);
+        for(unsigned k = 0; k < tag_count; k++) {
+            sd_script_tag tag;
+            serial_read_ptr(ser, tag.key);
+            serial_read_ptr(ser, tag.desc);
+            tag.has_param = serial_read_int32(ser);
+            tag.value = serial_read_int32(ser);
+            vector_append(&frame->tags, &tag);
+        }
+    }
+    sd_script_reindex(parser);
+}
+
+/*
+ * Feeds the animation playback state into a state hash. The parser itself is not hashed, but the frame it
+ * puts the object on is.
+ */
+void player_hash(const object *obj, state_hash *h) {
+    const player_animation_state *ani = &obj->animation_state;
+    const player_sprite_state *spr = &obj->sprite_state;
+    state_hash_int(h, "tick", ani->current_tick);
+    state_hash_int(h, "previous_tick", ani->previous_tick);
+    state_hash_int(h, "previous", ani->previous);
+    state_hash_int(h, "entered_frame", ani->entered_frame);
+    state_hash_int(h, "frame", ani->parser != NULL ? player_get_frame(obj) : -1);
+    state_hash_int(h, "repeat", ani->repeat);
+    state_hash_int(h, "reverse", ani->reverse);
+    state_hash_int(h, "finished", ani->finished);
+    state_hash_int(h, "disable_d", ani->disable_d);
+    state_hash_int(h, "looping", ani->looping);
+    state_hash_int(h, "enemy", ani->enemy_obj_id != 0);
+    state_hash_int(h, "flipmode", spr->flipmode);
+    state_hash_int(h, "sprite_timer", spr->timer);
+    state_hash_int(h, "sprite_duration", spr->duration);
+    state_hash_int(h, "o_correction.x", spr->o_correction.x);
+    state_hash_int(h, "o_correction.y", spr->o_correction.y);
+    state_hash_int(h, "disable_gravity", spr->disable_gravity);
+    state_hash_phys(h, "slide.x", obj->slide_state.vel.x);
+    state_hash_phys(h, "slide.y", obj->slide_state.vel.y);
+    state_hash_int(h, "slide_timer", obj->slide_state.timer);
+    state_hash_int(h, "enemy_slide.x", obj->enemy_slide_state.dest.x);
+    state_hash_int(h, "enemy_slide.y", obj->enemy_slide_state.dest.y);
+    state_hash_int(h, "enemy_slide_timer", obj->enemy_slide_state.timer);
+    state_hash_int(h, "enemy_slide_duration", obj->enemy_slide_state.duration);
+}
+
+static void player_restart(object *obj) {
     player_reset(obj);
     obj->animation_state.reverse = 0;
     obj->slide_state.timer = 0;
-    obj->slide_state.vel = vec2f_create(0, 0);
+    obj->slide_state.vel = vec2p_create(0, 0);
     obj->enemy_slide_state.timer = 0;
     obj->enemy_slide_state.dest = vec2i_create(0, 0);
     obj->enemy_slide_state.duration = 0;
@@ -66,8 +418,26 @@ void player_reload_with_str(object *obj, const char *custom_str) {
     obj->can_hit = 0;
 }
 
+void player_reload_with_str(object *obj, const char *custom_str) {
+    // Custom strings get a private parser
+    sd_script *parser = player_script_create();
+    int ret;
+    int err_pos;
+    ret = sd_script_decode(parser, custom_str, &err_pos);
+    if(ret != SD_SUCCESS) {
+        log_error("Decoder error %s at position %d in string \"%s\"", sd_get_error(ret), err_pos, custom_str);
+    }
+    player_free(obj);
+    obj->animation_state.parser = parser;
+    obj->animation_state.parser_own = true;
+    player_restart(obj);
+}
+
 void player_reload(object *obj) {
-    player_reload_with_str(obj, str_c(&obj->cur_animation->animation_string));
+    // Share the script compiled when the animation was loaded
+    player_free(obj);
+    obj->animation_state.parser = &obj->cur_animation->script;
+    player_restart(obj);
 }
 
 void player_reset(object *obj) {
@@ -78,16 +448,16 @@ void player_reset(object *obj) {
     obj->animation_state.disable_d = 0;
 }
 
-int player_frame_isset(const object *obj, const char *tag) {
+int player_frame_isset(const object *obj, sd_tag_id tag) {
     const sd_script_frame *frame =
-        sd_script_get_frame_at(&obj->animation_state.parser, obj->animation_state.current_tick);
-    return sd_script_isset(frame, tag);
+        sd_script_get_frame_at(obj->animation_state.parser, obj->animation_state.current_tick);
+    return sd_script_isset_id(frame, tag);
 }
 
-int player_frame_get(const object *obj, const char *tag) {
+int player_frame_get(const object *obj, sd_tag_id tag) {
     const sd_script_frame *frame =
-        sd_script_get_frame_at(&obj->animation_state.parser, obj->animation_state.current_tick);
-    return sd_script_get(frame, tag);
+        sd_script_get_frame_at(obj->animation_state.parser, obj->animation_state.current_tick);
+    return sd_script_get_id(frame, tag);
 }
 
 /*
@@ -95,7 +465,7 @@ int player_frame_get(const object *obj, const char *tag) {
  */
 void player_set_delay(object *obj, int delay) {
     // find the first frame that spawns a projectile, if any
-    int r = sd_script_next_frame_with_tag(&obj->animation_state.parser, "m", 0);
+    int r = sd_script_next_frame_with_tag_id(obj->animation_state.parser, SD_TAG_M, 0);
     int frames = (r >= 0) ? r : 99;
 
     // find the first frame with hit coordinates
@@ -103,7 +473,7 @@ void player_set_delay(object *obj, int delay) {
     collision_coord *cc;
     vector_iter_begin(&obj->cur_animation->collision_coords, &it);
     foreach(it, cc) {
-        r = sd_script_next_frame_with_sprite(&obj->animation_state.parser, cc->frame_index, 0);
+        r = sd_script_next_frame_with_sprite(obj->animation_state.parser, cc->frame_index, 0);
         frames = (r >= 0 && r < frames) ? r : frames;
     }
 
@@ -114,10 +484,12 @@ void player_set_delay(object *obj, int delay) {
 
     log_debug("Animation has %d initializer frames", frames);
 
+    // The frame lengths are changed, so the animation script can't be shared anymore
+    sd_script *parser = player_own_parser(obj);
     int delay_per_frame = delay / frames;
     int rem = delay % frames;
     for(int i = 0; i < frames; i++) {
-        int duration = sd_script_get_tick_len_at_frame(&obj->animation_state.parser, i);
+        int duration = sd_script_get_tick_len_at_frame(parser, i);
         int old_dur = duration;
         int new_duration = duration + delay_per_frame;
         if(rem) {
@@ -125,8 +497,8 @@ void player_set_delay(object *obj, int delay) {
             rem--;
         }
 
-        sd_script_set_tick_len_at_frame(&obj->animation_state.parser, i, new_duration);
-        duration = sd_script_get_tick_len_at_frame(&obj->animation_state.parser, i);
+        sd_script_set_tick_len_at_frame(parser, i, new_duration);
+        duration = sd_script_get_tick_len_at_frame(parser, i);
         log_debug("changed duration of frame %d from %d to %d", i, old_dur, duration);
     }
 }
@@ -146,22 +518,22 @@ void player_describe_frame(const sd_script_frame *frame) {
 
 void player_describe_object(object *obj) {
     log_debug("Object:");
-    log_debug("  - Start: %d, %d", obj->start.x, obj->start.y);
-    log_debug("  - Position: %d, %d", obj->pos.x, obj->pos.y);
-    log_debug("  - Velocity: %d, %d", obj->vel.x, obj->vel.y);
+    log_debug("  - Start: %f, %f", phys_to_float(obj->start.x), phys_to_float(obj->start.y));
+    log_debug("  - Position: %f, %f", phys_to_float(obj->pos.x), phys_to_float(obj->pos.y));
+    log_debug("  - Velocity: %f, %f", phys_to_float(obj->vel.x), phys_to_float(obj->vel.y));
     if(obj->cur_sprite_id) {
         sprite *cur_sprite = animation_get_sprite(obj->cur_animation, obj->cur_sprite_id);
         log_debug("  - Pos: %d, %d", cur_sprite->pos.x, cur_sprite->pos.y);
         log_debug("  - Size: %d, %d", cur_sprite->data->w, cur_sprite->data->h);
         player_sprite_state *rstate = &obj->sprite_state;
-        log_debug("CURRENT = %d - %d + %d - %d", obj->pos.y, cur_sprite->pos.y, rstate->o_correction.y,
+        log_debug("CURRENT = %d - %d + %d - %d", object_py(obj), cur_sprite->pos.y, rstate->o_correction.y,
                   cur_sprite->data->h);
     }
 }
 
 void player_describe_mp_flags(const sd_script_frame *frame, int mp) {
     if(mp != 0) {
-        log_debug("mp flags set for new animation %d:", sd_script_get(frame, "m"));
+        log_debug("mp flags set for new animation %d:", sd_script_get_id(frame, SD_TAG_M));
         if(mp & 0x1)
             log_debug(" * 0x01: NON-HAR Sprite");
         if(mp & 0x2)
@@ -191,13 +563,13 @@ void player_run(object *obj) {
     if(state->finished)
         return;
 
-    const sd_script_frame *frame = sd_script_get_frame_at(&state->parser, state->current_tick);
+    const sd_script_frame *frame = sd_script_get_frame_at(state->parser, state->current_tick);
 
     // Animation has ended ?
     if(frame == NULL) {
         if(state->repeat) {
             player_reset(obj);
-            frame = sd_script_get_frame_at(&state->parser, state->current_tick);
+            frame = sd_script_get_frame_at(state->parser, state->current_tick);
         } else {
             state->finished = 1;
             if(obj->finish != NULL) {
@@ -216,23 +588,23 @@ void player_run(object *obj) {
     assert(frame != NULL);
 
     // Get MP flag content, set to 0 if not set.
-    uint8_t mp = sd_script_isset(frame, "mp") ? sd_script_get(frame, "mp") & 0xFF : 0;
+    uint8_t mp = sd_script_isset_id(frame, SD_TAG_MP) ? sd_script_get_id(frame, SD_TAG_MP) & 0xFF : 0;
 
     // See if x+/- or y+/- are set and save values
     int trans_x = 0, trans_y = 0;
-    if(sd_script_isset(frame, "y-")) {
-        trans_y = sd_script_get(frame, "y-") * -1;
-    } else if(sd_script_isset(frame, "y+")) {
-        trans_y = sd_script_get(frame, "y+");
+    if(sd_script_isset_id(frame, SD_TAG_Y_MINUS)) {
+        trans_y = sd_script_get_id(frame, SD_TAG_Y_MINUS) * -1;
+    } else if(sd_script_isset_id(frame, SD_TAG_Y_PLUS)) {
+        trans_y = sd_script_get_id(frame, SD_TAG_Y_PLUS);
     }
-    if(sd_script_isset(frame, "x-")) {
-        trans_x = sd_script_get(frame, "x-") * -1 * object_get_direction(obj);
-    } else if(sd_script_isset(frame, "x+")) {
-        trans_x = sd_script_get(frame, "x+") * object_get_direction(obj);
+    if(sd_script_isset_id(frame, SD_TAG_X_MINUS)) {
+        trans_x = sd_script_get_id(frame, SD_TAG_X_MINUS) * -1 * object_get_direction(obj);
+    } else if(sd_script_isset_id(frame, SD_TAG_X_PLUS)) {
+        trans_x = sd_script_get_id(frame, SD_TAG_X_PLUS) * object_get_direction(obj);
     }
 
     // Check if frame changed from the previous tick
-    state->entered_frame = sd_script_frame_changed(&state->parser, state->previous_tick, state->current_tick);
+    state->entered_frame = sd_script_frame_changed(state->parser, state->previous_tick, state->current_tick);
     if(state->entered_frame) {
 #ifdef DEBUGMODE
         // player_describe_frame(frame);
@@ -241,32 +613,32 @@ void player_run(object *obj) {
 #endif
         player_clear_frame(obj);
 
-        if(sd_script_isset(frame, "ar")) {
+        if(sd_script_isset_id(frame, SD_TAG_AR)) {
             object_set_direction(obj, object_get_direction(obj) * -1);
         }
 
-        if(sd_script_isset(frame, "ac")) {
+        if(sd_script_isset_id(frame, SD_TAG_AC)) {
             // force the har to face the center of the arena
-            if(obj->pos.x > 160) {
+            if(obj->pos.x > phys_from_int(160)) {
                 object_set_direction(obj, OBJECT_FACE_LEFT);
             } else {
                 object_set_direction(obj, OBJECT_FACE_RIGHT);
             }
         }
 
-        if(sd_script_isset(frame, "bm")) {
+        if(sd_script_isset_id(frame, SD_TAG_BM)) {
             int destination = 160;
-            if(sd_script_isset(frame, "am") && sd_script_isset(frame, "e")) {
+            if(sd_script_isset_id(frame, SD_TAG_AM) && sd_script_isset_id(frame, SD_TAG_E)) {
                 // destination is the enemy's position
                 log_debug("adjusting walkto %d by %d", destination, trans_x);
-                destination = enemy->pos.x - trans_x;
+                destination = phys_to_int(enemy->pos.x - phys_from_int(trans_x));
                 if(obj->pos.x > enemy->pos.x) {
                     object_set_direction(obj, OBJECT_FACE_LEFT);
                 } else {
                     object_set_direction(obj, OBJECT_FACE_RIGHT);
                 }
                 destination = max2(ARENA_LEFT_WALL, min2(ARENA_RIGHT_WALL, destination));
-            } else if(sd_script_isset(frame, "cf")) {
+            } else if(sd_script_isset_id(frame, SD_TAG_CF)) {
                 // shadow's scrap, position is in the corner behind shadow
                 if(object_get_direction(enemy) == OBJECT_FACE_RIGHT) {
                     destination = ARENA_RIGHT_WALL;
@@ -282,23 +654,25 @@ void player_run(object *obj) {
             }
             // clear this
             trans_x = 0;
-            if(sd_script_get(frame, "bm") == 10 && destination > 0 && fabsf(obj->pos.x - destination) > 5.0) {
-                log_debug("HAR walk to %d from %d", destination, obj->pos.x);
+            if(sd_script_get_id(frame, SD_TAG_BM) == 10 && destination > 0 &&
+               phys_abs(obj->pos.x - phys_from_int(destination)) > phys_from_int(5)) {
+                log_debug("HAR walk to %d from %f", destination, phys_to_float(obj->pos.x));
                 har_walk_to(obj, destination);
                 return;
             }
         }
 
-        if(sd_script_isset(frame, "h")) {
+        if(sd_script_isset_id(frame, SD_TAG_H)) {
             // Hover, reset all velocities to 0 on every frame
             obj->vel.x = 0;
             obj->vel.y = 0;
         }
     }
 
-    if(sd_script_isset(frame, "e") && enemy) {
+    if(sd_script_isset_id(frame, SD_TAG_E) && enemy) {
 
-        log_debug("my position %f, %f, their position %f %f", obj->pos.x, obj->pos.y, enemy->pos.x, enemy->pos.y);
+        log_debug("my position %f, %f, their position %f %f", phys_to_float(obj->pos.x), phys_to_float(obj->pos.y),
+                  phys_to_float(enemy->pos.x), phys_to_float(enemy->pos.y));
         // Set speed to 0, since we're being controlled by animation tag system
         obj->vel.x = 0;
         obj->vel.y = 0;
@@ -311,45 +685,46 @@ void player_run(object *obj) {
     }
 
     // Set to ground
-    if(sd_script_isset(frame, "g")) {
+    if(sd_script_isset_id(frame, SD_TAG_G)) {
         obj->vel.y = 0;
-        obj->pos.y = ARENA_FLOOR;
+        obj->pos.y = phys_from_int(ARENA_FLOOR);
     }
 
-    if(sd_script_isset(frame, "at") && enemy) {
+    if(sd_script_isset_id(frame, SD_TAG_AT) && enemy) {
 
-        log_debug("my position %f, %f, their position %f %f", obj->pos.x, obj->pos.y, enemy->pos.x, enemy->pos.y);
+        log_debug("my position %f, %f, their position %f %f", phys_to_float(obj->pos.x), phys_to_float(obj->pos.y),
+                  phys_to_float(enemy->pos.x), phys_to_float(enemy->pos.y));
         // set the object's X position to be behind the opponent
 
         if(obj->pos.x > enemy->pos.x) { // From right to left
-            obj->pos.x = enemy->pos.x - object_get_size(obj).x / 2;
+            obj->pos.x = enemy->pos.x - phys_from_int(object_get_size(obj).x / 2);
         } else { // From left to right
-            obj->pos.x = enemy->pos.x + object_get_size(enemy).x / 2;
+            obj->pos.x = enemy->pos.x + phys_from_int(object_get_size(enemy).x / 2);
         }
         object_set_direction(obj, object_get_direction(obj) * -1);
     }
 
     // Handle vx+/-, vy+/-, x+/-. y+/-
     if(trans_x || trans_y) {
-        if(sd_script_isset(frame, "v")) {
+        if(sd_script_isset_id(frame, SD_TAG_V)) {
             obj->vel.x = (trans_x * (mp & 0x20 ? -1 : 1)) * obj->horizontal_velocity_modifier;
             obj->vel.y = trans_y * obj->vertical_velocity_modifier;
             // log_debug("vel x+%d, y+%d to x=%f, y=%f", trans_x * (mp & 0x20 ? -1 : 1), trans_y, obj->vel.x,
             // obj->vel.y);
         } else {
-            obj->pos.x += trans_x * (mp & 0x20 ? -1 : 1);
-            if(obj->pos.x < ARENA_LEFT_WALL) {
-                if(sd_script_isset(frame, "e") && enemy) {
-                    enemy->pos.x += ARENA_LEFT_WALL - obj->pos.x;
+            obj->pos.x += phys_from_int(trans_x * (mp & 0x20 ? -1 : 1));
+            if(obj->pos.x < phys_from_int(ARENA_LEFT_WALL)) {
+                if(sd_script_isset_id(frame, SD_TAG_E) && enemy) {
+                    enemy->pos.x += phys_from_int(ARENA_LEFT_WALL) - obj->pos.x;
                 }
-                obj->pos.x = ARENA_LEFT_WALL;
-            } else if(obj->pos.x > ARENA_RIGHT_WALL) {
-                if(sd_script_isset(frame, "e") && enemy) {
-                    enemy->pos.x -= obj->pos.x - ARENA_RIGHT_WALL;
+                obj->pos.x = phys_from_int(ARENA_LEFT_WALL);
+            } else if(obj->pos.x > phys_from_int(ARENA_RIGHT_WALL)) {
+                if(sd_script_isset_id(frame, SD_TAG_E) && enemy) {
+                    enemy->pos.x -= obj->pos.x - phys_from_int(ARENA_RIGHT_WALL);
                 }
-                obj->pos.x = ARENA_RIGHT_WALL;
+                obj->pos.x = phys_from_int(ARENA_RIGHT_WALL);
             }
-            obj->pos.y += trans_y;
+            obj->pos.y += phys_from_int(trans_y);
             // log_debug("pos x+%d, y+%d to x=%f, y=%f", trans_x * (mp & 0x20 ? -1 : 1), trans_y, obj->pos.x,
             // obj->pos.y);
         }
@@ -365,136 +740,138 @@ void player_run(object *obj) {
     // Handle slide in relation to enemy
     if(obj->enemy_slide_state.timer > 0 && enemy) {
 
-        log_debug("my position %f, %f, their position %f %f", obj->pos.x, obj->pos.y, enemy->pos.x, enemy->pos.y);
+        log_debug("my position %f, %f, their position %f %f", phys_to_float(obj->pos.x), phys_to_float(obj->pos.y),
+                  phys_to_float(enemy->pos.x), phys_to_float(enemy->pos.y));
         obj->enemy_slide_state.duration++;
-        obj->pos.x = enemy->pos.x + obj->enemy_slide_state.dest.x;
-        obj->pos.y = enemy->pos.y + obj->enemy_slide_state.dest.y;
+        obj->pos.x = enemy->pos.x + phys_from_int(obj->enemy_slide_state.dest.x);
+        obj->pos.y = enemy->pos.y + phys_from_int(obj->enemy_slide_state.dest.y);
         obj->enemy_slide_state.timer--;
     }
 
     if(enemy) {
-        obj->pos.x = max2(ARENA_LEFT_WALL, min2(ARENA_RIGHT_WALL, obj->pos.x));
+        obj->pos.x = phys_from_int(max2(ARENA_LEFT_WALL, min2(ARENA_RIGHT_WALL, phys_to_int(obj->pos.x))));
     }
 
     // If frame changed, do something
     if(state->entered_frame) {
         // Animation creation command
-        if(sd_script_isset(frame, "m") && state->spawn != NULL) {
+        if(sd_script_isset_id(frame, SD_TAG_M) && state->spawn != NULL) {
             int mx = 0;
             int my = 0;
             float vx = 0;
             float vy = 0;
 
-            if(obj->animation_state.shadow_corner_hack && sd_script_get(frame, "m") == 65 && enemy) {
+            if(obj->animation_state.shadow_corner_hack && sd_script_get_id(frame, SD_TAG_M) == 65 && enemy) {
 
-                log_debug("my position %f, %f, their position %f %f", obj->pos.x, obj->pos.y, enemy->pos.x,
-                          enemy->pos.y);
-                mx = enemy->pos.x;
-                my = enemy->pos.y;
+                log_debug("my position %f, %f, their position %f %f", phys_to_float(obj->pos.x),
+                          phys_to_float(obj->pos.y), phys_to_float(enemy->pos.x), phys_to_float(enemy->pos.y));
+                mx = phys_to_int(enemy->pos.x);
+                my = phys_to_int(enemy->pos.y);
             }
 
             // Staring X coordinate for new animation
-            if(sd_script_isset(frame, "mrx")) {
-                int mrx = sd_script_get(frame, "mrx");
-                int mm = sd_script_isset(frame, "mm") ? sd_script_get(frame, "mm") : mrx;
+            if(sd_script_isset_id(frame, SD_TAG_MRX)) {
+                int mrx = sd_script_get_id(frame, SD_TAG_MRX);
+                int mm = sd_script_isset_id(frame, SD_TAG_MM) ? sd_script_get_id(frame, SD_TAG_MM) : mrx;
                 mx = random_int(&obj->gs->rand, 320 - 2 * mm) + mrx;
                 log_debug("randomized mx as %d", mx);
-            } else if(sd_script_isset(frame, "mx")) {
-                mx = obj->start.x + (sd_script_get(frame, "mx") * object_get_direction(obj));
+            } else if(sd_script_isset_id(frame, SD_TAG_MX)) {
+                int mx_offset = sd_script_get_id(frame, SD_TAG_MX) * object_get_direction(obj);
+                mx = phys_to_int(obj->start.x + phys_from_int(mx_offset));
             }
 
             // Staring Y coordinate for new animation
-            if(sd_script_isset(frame, "mry")) {
-                int mry = sd_script_get(frame, "mry");
-                int mm = sd_script_isset(frame, "mm") ? sd_script_get(frame, "mm") : mry;
+            if(sd_script_isset_id(frame, SD_TAG_MRY)) {
+                int mry = sd_script_get_id(frame, SD_TAG_MRY);
+                int mm = sd_script_isset_id(frame, SD_TAG_MM) ? sd_script_get_id(frame, SD_TAG_MM) : mry;
                 my = random_int(&obj->gs->rand, 320 - 2 * mm) + mry;
                 log_debug("randomized my as %d", my);
-            } else if(sd_script_isset(frame, "my")) {
-                my = obj->start.y + sd_script_get(frame, "my");
+            } else if(sd_script_isset_id(frame, SD_TAG_MY)) {
+                my = phys_to_int(obj->start.y + phys_from_int(sd_script_get_id(frame, SD_TAG_MY)));
             }
 
             // Angle/speed for new animation
-            if(sd_script_isset(frame, "ma")) {
-                int ma = sd_script_get(frame, "ma");
-                vx = cosf(ma);
-                vy = sinf(ma);
+            if(sd_script_isset_id(frame, SD_TAG_MA)) {
+                int ma = sd_script_get_id(frame, SD_TAG_MA);
+                vx = phys_to_float(phys_cos(phys_from_int(ma)));
+                vy = phys_to_float(phys_sin(phys_from_int(ma)));
                 log_debug("MA is set! angle = %d, vx = %f, vy = %f", ma, vx, vy);
             }
 
             // Special positioning for certain desert arena sprites
-            int ms = sd_script_isset(frame, "ms");
+            int ms = sd_script_isset_id(frame, SD_TAG_MS);
 
             // Gravity for new object
-            int mg = sd_script_isset(frame, "mg") ? sd_script_get(frame, "mg") : 0;
+            int mg = sd_script_isset_id(frame, SD_TAG_MG) ? sd_script_get_id(frame, SD_TAG_MG) : 0;
 
-            state->spawn(obj, sd_script_get(frame, "m"), vec2i_create(mx, my), vec2f_create(vx, vy), mp, ms, mg,
+            state->spawn(obj, sd_script_get_id(frame, SD_TAG_M), vec2i_create(mx, my), vec2f_create(vx, vy), mp, ms, mg,
                          state->spawn_userdata);
         }
 
         // Animation deletion
-        if(sd_script_isset(frame, "md") && state->destroy != NULL) {
-            state->destroy(obj, sd_script_get(frame, "md"), state->destroy_userdata);
+        if(sd_script_isset_id(frame, SD_TAG_MD) && state->destroy != NULL) {
+            state->destroy(obj, sd_script_get_id(frame, SD_TAG_MD), state->destroy_userdata);
         }
 
         // Music playback
-        if(sd_script_isset(frame, "smo")) {
-            if(sd_script_get(frame, "smo") == 0) {
+        if(sd_script_isset_id(frame, SD_TAG_SMO)) {
+            if(sd_script_get_id(frame, SD_TAG_SMO) == 0) {
                 audio_stop_music();
                 return;
             }
-            audio_play_music(PSM_END + (sd_script_get(frame, "smo") - 1));
+            audio_play_music(PSM_END + (sd_script_get_id(frame, SD_TAG_SMO) - 1));
         }
-        if(sd_script_isset(frame, "smf")) {
+        if(sd_script_isset_id(frame, SD_TAG_SMF)) {
             audio_stop_music();
         }
 
         // Sound playback
-        if(sd_script_isset(frame, "s")) {
+        if(sd_script_isset_id(frame, SD_TAG_S)) {
             float pitch = PITCH_DEFAULT;
             float volume = VOLUME_DEFAULT * (settings_get()->sound.sound_vol / 10.0f);
             float panning = PANNING_DEFAULT;
-            if(sd_script_isset(frame, "sf")) {
-                int p = clamp(sd_script_get(frame, "sf"), -16, 239);
+            if(sd_script_isset_id(frame, SD_TAG_SF)) {
+                int p = clamp(sd_script_get_id(frame, SD_TAG_SF), -16, 239);
                 pitch = clampf((p / 239.0f) * 3.0f + 1.0f, PITCH_MIN, PITCH_MAX);
             }
-            if(sd_script_isset(frame, "l")) {
-                int v = clamp(sd_script_get(frame, "l"), 0, 100);
+            if(sd_script_isset_id(frame, SD_TAG_L)) {
+                int v = clamp(sd_script_get_id(frame, SD_TAG_L), 0, 100);
                 volume = (v / 100.0f) * (settings_get()->sound.sound_vol / 10.0f);
             }
-            if(sd_script_isset(frame, "sb")) {
-                panning = clamp(sd_script_get(frame, "sb"), -100, 100) / 100.0f;
+            if(sd_script_isset_id(frame, SD_TAG_SB)) {
+                panning = clamp(sd_script_get_id(frame, SD_TAG_SB), -100, 100) / 100.0f;
             }
             if(obj->sound_translation_table) {
-                int sound_id = obj->sound_translation_table[sd_script_get(frame, "s")] - 1;
+                int sound_id = obj->sound_translation_table[sd_script_get_id(frame, SD_TAG_S)] - 1;
                 game_state_play_sound(obj->gs, sound_id, volume, panning, pitch);
             }
         }
 
         // Blend mode stuff
-        if(sd_script_isset(frame, "bb")) {
-            rstate->screen_shake_vertical = sd_script_get(frame, "bb");
+        if(sd_script_isset_id(frame, SD_TAG_BB)) {
+            rstate->screen_shake_vertical = sd_script_get_id(frame, SD_TAG_BB);
         }
-        if(sd_script_isset(frame, "bf")) {
-            rstate->blend_finish = sd_script_get(frame, "bf");
+        if(sd_script_isset_id(frame, SD_TAG_BF)) {
+            rstate->blend_finish = sd_script_get_id(frame, SD_TAG_BF);
         }
-        if(sd_script_isset(frame, "bl")) {
-            rstate->screen_shake_horizontal = sd_script_get(frame, "bl");
+        if(sd_script_isset_id(frame, SD_TAG_BL)) {
+            rstate->screen_shake_horizontal = sd_script_get_id(frame, SD_TAG_BL);
         }
-        if(sd_script_isset(frame, "bs")) {
-            rstate->blend_start = sd_script_get(frame, "bs");
+        if(sd_script_isset_id(frame, SD_TAG_BS)) {
+            rstate->blend_start = sd_script_get_id(frame, SD_TAG_BS);
         }
 
         // Palette tricks
-        if(sd_script_isset(frame, "bpd")) {
-            rstate->pal_ref_index = sd_script_get(frame, "bpd");
+        if(sd_script_isset_id(frame, SD_TAG_BPD)) {
+            rstate->pal_ref_index = sd_script_get_id(frame, SD_TAG_BPD);
         }
-        if(sd_script_isset(frame, "bpn")) {
-            rstate->pal_entry_count = sd_script_get(frame, "bpn");
+        if(sd_script_isset_id(frame, SD_TAG_BPN)) {
+            rstate->pal_entry_count = sd_script_get_id(frame, SD_TAG_BPN);
         }
-        if(sd_script_isset(frame, "bps")) {
-            rstate->pal_start_index = sd_script_get(frame, "bps");
+        if(sd_script_isset_id(frame, SD_TAG_BPS)) {
+            rstate->pal_start_index = sd_script_get_id(frame, SD_TAG_BPS);
         }
-        if(sd_script_isset(frame, "bpf")) {
+        if(sd_script_isset_id(frame, SD_TAG_BPF)) {
             // Exact values come from master.dat
             if(game_state_get_player(obj->gs, 0)->har_obj_id == obj->id) {
                 rstate->pal_start_index = 1;
@@ -504,89 +881,90 @@ void player_run(object *obj) {
                 rstate->pal_entry_count = 48;
             }
         }
-        if(sd_script_isset(frame, "bpp")) {
-            rstate->pal_end = COLOR_6TO8(sd_script_get(frame, "bpp"));
-            rstate->pal_begin = COLOR_6TO8(sd_script_get(frame, "bpp"));
+        if(sd_script_isset_id(frame, SD_TAG_BPP)) {
+            rstate->pal_end = COLOR_6TO8(sd_script_get_id(frame, SD_TAG_BPP));
+            rstate->pal_begin = COLOR_6TO8(sd_script_get_id(frame, SD_TAG_BPP));
         }
-        if(sd_script_isset(frame, "bpb")) {
-            rstate->pal_begin = COLOR_6TO8(sd_script_get(frame, "bpb"));
+        if(sd_script_isset_id(frame, SD_TAG_BPB)) {
+            rstate->pal_begin = COLOR_6TO8(sd_script_get_id(frame, SD_TAG_BPB));
         }
-        if(sd_script_isset(frame, "bz")) {
+        if(sd_script_isset_id(frame, SD_TAG_BZ)) {
             rstate->pal_tint = 1;
         }
 
         // CREDITS palette copy tricks
-        rstate->pal_tricks_off = sd_script_isset(frame, "bpo") ? 1 : 0; // Disable the standard palette tricks
-        rstate->bd_flag =
-            sd_script_isset(frame, "bd"); // Read palette from the last frame of animation (we emulate this internally)
+        rstate->pal_tricks_off = sd_script_isset_id(frame, SD_TAG_BPO) ? 1 : 0; // Disable the standard palette tricks
+        // Read palette from the last frame of animation (we emulate this internally)
+        rstate->bd_flag = sd_script_isset_id(frame, SD_TAG_BD);
 
         // These are animation-global instead of per-frame.
-        if(sd_script_isset(frame, "ba")) {
-            state->pal_copy_count = sd_script_get(frame, "ba");   // Number of copies to make after bi + bc
-            state->pal_copy_start = sd_script_get(frame, "bi");   // Start offset for copying
-            state->pal_copy_entries = sd_script_get(frame, "bc"); // Number of indexes to copy
+        if(sd_script_isset_id(frame, SD_TAG_BA)) {
+            state->pal_copy_count = sd_script_get_id(frame, SD_TAG_BA);   // Number of copies to make after bi + bc
+            state->pal_copy_start = sd_script_get_id(frame, SD_TAG_BI);   // Start offset for copying
+            state->pal_copy_entries = sd_script_get_id(frame, SD_TAG_BC); // Number of indexes to copy
         }
 
         // Handle position correction
-        if(sd_script_isset(frame, "ox")) {
-            log_debug("O_CORRECTION: X = %d", sd_script_get(frame, "ox"));
-            rstate->o_correction.x = sd_script_get(frame, "ox");
+        if(sd_script_isset_id(frame, SD_TAG_OX)) {
+            log_debug("O_CORRECTION: X = %d", sd_script_get_id(frame, SD_TAG_OX));
+            rstate->o_correction.x = sd_script_get_id(frame, SD_TAG_OX);
         } else {
             rstate->o_correction.x = 0;
         }
-        if(sd_script_isset(frame, "oy")) {
-            log_debug("O_CORRECTION: Y = %d", sd_script_get(frame, "oy"));
-            rstate->o_correction.y = sd_script_get(frame, "oy");
+        if(sd_script_isset_id(frame, SD_TAG_OY)) {
+            log_debug("O_CORRECTION: Y = %d", sd_script_get_id(frame, SD_TAG_OY));
+            rstate->o_correction.y = sd_script_get_id(frame, SD_TAG_OY);
         } else {
             rstate->o_correction.y = 0;
         }
 
         // If UA is set, force other HAR to damage animation
-        if(sd_script_isset(frame, "ua") && enemy && enemy->cur_animation->id != 9) {
+        if(sd_script_isset_id(frame, SD_TAG_UA) && enemy && enemy->cur_animation->id != 9) {
 
-            log_debug("my position %f, %f, their position %f %f", obj->pos.x, obj->pos.y, enemy->pos.x, enemy->pos.y);
+            log_debug("my position %f, %f, their position %f %f", phys_to_float(obj->pos.x),
+                      phys_to_float(obj->pos.y), phys_to_float(enemy->pos.x), phys_to_float(enemy->pos.y));
             har_set_ani(enemy, 9, 0);
         }
 
         // XXX BJ tag invalidates frame, and probably doesn't do what it's supposed to.
 #if 0
         // BJ sets new animation for our HAR
-        if(sd_script_isset(frame, "bj")) {
-            int new_ani = sd_script_get(frame, "bj");
+        if(sd_script_isset_id(frame, SD_TAG_BJ)) {
+            int new_ani = sd_script_get_id(frame, SD_TAG_BJ);
             har_set_ani(obj, new_ani, 0);
         }
 #endif
 
-        if(sd_script_isset(frame, "bu") && obj->vel.y < 0.0f) {
-            float x_dist = dist(obj->pos.x, 160);
+        if(sd_script_isset_id(frame, SD_TAG_BU) && obj->vel.y < 0) {
+            phys x_dist = phys_dist(obj->pos.x, phys_from_int(160));
             // assume that bu is used in conjunction with 'vy-X' and that we want to land in the center of the arena
-            obj->slide_state.vel.x = x_dist / (obj->vel.y * -2);
-            obj->slide_state.timer = obj->vel.y * -2;
+            obj->slide_state.vel.x = phys_div(x_dist, obj->vel.y * -2);
+            obj->slide_state.timer = phys_to_int(obj->vel.y * -2);
         }
 
         // handle scaling on the Y axis
-        if(sd_script_isset(frame, "y")) {
-            obj->y_percent = sd_script_get(frame, "y") / 100.0f;
+        if(sd_script_isset_id(frame, SD_TAG_Y)) {
+            obj->y_percent = sd_script_get_id(frame, SD_TAG_Y) / 100.0f;
         }
 
         // Handle slides
-        if(sd_script_isset(frame, "x=") || sd_script_isset(frame, "y=")) {
-            obj->slide_state.vel = vec2f_create(0, 0);
+        if(sd_script_isset_id(frame, SD_TAG_X_EQ) || sd_script_isset_id(frame, SD_TAG_Y_EQ)) {
+            obj->slide_state.vel = vec2p_create(0, 0);
         }
-        if(sd_script_isset(frame, "x=")) {
-            obj->pos.x = obj->start.x + (sd_script_get(frame, "x=") * object_get_direction(obj));
+        if(sd_script_isset_id(frame, SD_TAG_X_EQ)) {
+            obj->pos.x = obj->start.x + phys_from_int(sd_script_get_id(frame, SD_TAG_X_EQ) * object_get_direction(obj));
 
             // Find frame ID by tick
-            int frame_id = sd_script_next_frame_with_tag(&state->parser, "x=", state->current_tick);
+            int frame_id = sd_script_next_frame_with_tag_id(state->parser, SD_TAG_X_EQ, state->current_tick);
 
             // Handle it!
             if(frame_id >= 0) {
-                int mr = sd_script_get_tick_pos_at_frame(&state->parser, frame_id);
+                int mr = sd_script_get_tick_pos_at_frame(state->parser, frame_id);
                 int r = mr - state->current_tick - frame->tick_len;
-                int next_x = sd_script_get(sd_script_get_frame(&state->parser, frame_id), "x=");
-                int slide = obj->start.x + (next_x * object_get_direction(obj));
-                if(slide != obj->pos.x) {
-                    obj->slide_state.vel.x = dist(obj->pos.x, slide) / (float)(frame->tick_len + r);
+                int next_x = sd_script_get_id(sd_script_get_frame(state->parser, frame_id), SD_TAG_X_EQ);
+                int slide = phys_to_int(obj->start.x + phys_from_int(next_x * object_get_direction(obj)));
+                if(phys_from_int(slide) != obj->pos.x) {
+                    obj->slide_state.vel.x = phys_dist(obj->pos.x, phys_from_int(slide)) / (frame->tick_len + r);
                     obj->slide_state.timer = frame->tick_len + r;
                     /* log_debug("Slide object %d for X = %f for a total of %d + %d = %d ticks.",
                             obj->cur_animation->id,
@@ -597,20 +975,20 @@ void player_run(object *obj) {
                 }
             }
         }
-        if(sd_script_isset(frame, "y=")) {
-            obj->pos.y = obj->start.y + sd_script_get(frame, "y=");
+        if(sd_script_isset_id(frame, SD_TAG_Y_EQ)) {
+            obj->pos.y = obj->start.y + phys_from_int(sd_script_get_id(frame, SD_TAG_Y_EQ));
 
             // Find frame ID by tick
-            int frame_id = sd_script_next_frame_with_tag(&state->parser, "y=", state->current_tick);
+            int frame_id = sd_script_next_frame_with_tag_id(state->parser, SD_TAG_Y_EQ, state->current_tick);
 
             // handle it!
             if(frame_id >= 0) {
-                int mr = sd_script_get_tick_pos_at_frame(&state->parser, frame_id);
+                int mr = sd_script_get_tick_pos_at_frame(state->parser, frame_id);
                 int r = mr - state->current_tick - frame->tick_len;
-                int next_y = sd_script_get(sd_script_get_frame(&state->parser, frame_id), "y=");
-                int slide = next_y + obj->start.y;
-                if(slide != obj->pos.y) {
-                    obj->slide_state.vel.y = dist(obj->pos.y, slide) / (float)(frame->tick_len + r);
+                int next_y = sd_script_get_id(sd_script_get_frame(state->parser, frame_id), SD_TAG_Y_EQ);
+                int slide = phys_to_int(phys_from_int(next_y) + obj->start.y);
+                if(phys_from_int(slide) != obj->pos.y) {
+                    obj->slide_state.vel.y = phys_dist(obj->pos.y, phys_from_int(slide)) / (frame->tick_len + r);
                     obj->slide_state.timer = frame->tick_len + r;
                     /* log_debug("Slide object %d for Y = %f for a total of %d + %d = %d ticks.",
                             obj->cur_animation->id,
@@ -621,14 +999,14 @@ void player_run(object *obj) {
                 }
             }
         }
-        if(sd_script_isset(frame, "as")) {
+        if(sd_script_isset_id(frame, SD_TAG_AS)) {
             // make the object move around the screen in a circular motion until end of frame
             obj->orbit = 1;
         } else {
             obj->orbit = 0;
         }
-        if(sd_script_isset(frame, "q")) {
-            obj->q_val = sd_script_get(frame, "q");
+        if(sd_script_isset_id(frame, SD_TAG_Q)) {
+            obj->q_val = sd_script_get_id(frame, SD_TAG_Q);
             // Enable hit if the q value is higher than the hit count for this animation
             if(obj->q_val > obj->q_counter) {
                 obj->can_hit = 1;
@@ -637,13 +1015,13 @@ void player_run(object *obj) {
 
         // Set video effects now.
         int effects = EFFECT_NONE;
-        if(player_frame_isset(obj, "bt"))
+        if(player_frame_isset(obj, SD_TAG_BT))
             effects |= EFFECT_DARK_TINT;
-        if(player_frame_isset(obj, "br"))
+        if(player_frame_isset(obj, SD_TAG_BR))
             effects |= EFFECT_GLOW;
-        if(player_frame_isset(obj, "ub"))
+        if(player_frame_isset(obj, SD_TAG_UB))
             effects |= EFFECT_TRAIL;
-        if(player_frame_isset(obj, "bg"))
+        if(player_frame_isset(obj, SD_TAG_BG))
             effects |= EFFECT_ADD;
         object_set_frame_effects(obj, effects);
 
@@ -651,19 +1029,19 @@ void player_run(object *obj) {
         object_select_sprite(obj, frame->sprite);
         if(obj->cur_sprite_id >= 0) {
             rstate->duration = frame->tick_len;
-            if(sd_script_isset(frame, "r")) { // || obj->animation_state.shadow_corner_hack) {
+            if(sd_script_isset_id(frame, SD_TAG_R)) { // || obj->animation_state.shadow_corner_hack) {
                 rstate->flipmode ^= FLIP_HORIZONTAL;
             }
-            if(sd_script_isset(frame, "f")) {
+            if(sd_script_isset_id(frame, SD_TAG_F)) {
                 rstate->flipmode ^= FLIP_VERTICAL;
             }
         }
     }
 
     // Tick management
-    if(sd_script_isset(frame, "d") && !obj->animation_state.disable_d) {
+    if(sd_script_isset_id(frame, SD_TAG_D) && !obj->animation_state.disable_d) {
         state->previous_tick = state->current_tick;
-        state->current_tick = sd_script_get(frame, "d") + 1;
+        state->current_tick = sd_script_get_id(frame, SD_TAG_D) + 1;
         state->looping = true;
         return;
     }
@@ -691,7 +1069,7 @@ void player_jump_to_tick(object *obj, int tick) {
 
 unsigned int player_get_len_ticks(const object *obj) {
     const player_animation_state *state = &obj->animation_state;
-    return sd_script_get_total_ticks(&state->parser);
+    return sd_script_get_total_ticks(state->parser);
 }
 
 void player_set_repeat(object *obj, int repeat) {
@@ -704,14 +1082,14 @@ int player_get_repeat(const object *obj) {
 
 void player_next_frame(object *obj) {
     player_animation_state *state = &obj->animation_state;
-    int current_index = sd_script_get_frame_index_at(&state->parser, state->current_tick);
-    state->current_tick = sd_script_get_tick_pos_at_frame(&state->parser, current_index + 1);
+    int current_index = sd_script_get_frame_index_at(state->parser, state->current_tick);
+    state->current_tick = sd_script_get_tick_pos_at_frame(state->parser, current_index + 1);
     state->previous_tick = state->current_tick - 1;
 }
 
 void player_goto_frame(object *obj, int frame_id) {
     player_animation_state *state = &obj->animation_state;
-    state->current_tick = sd_script_get_tick_pos_at_frame(&state->parser, frame_id);
+    state->current_tick = sd_script_get_tick_pos_at_frame(state->parser, frame_id);
     state->previous_tick = state->current_tick - 1;
 }
 
@@ -721,7 +1099,7 @@ uint32_t player_get_current_tick(const object *obj) {
 
 int player_get_frame(const object *obj) {
     const player_animation_state *state = &obj->animation_state;
-    return sd_script_get_frame_index_at(&state->parser, state->current_tick);
+    return sd_script_get_frame_index_at(state->parser, state->current_tick);
 }
 
 char player_get_frame_letter(const object *obj) {
@@ -730,7 +1108,7 @@ char player_get_frame_letter(const object *obj) {
 
 int player_is_last_frame(const object *obj) {
     const player_animation_state *state = &obj->animation_state;
-    return sd_script_is_last_frame_at(&state->parser, state->current_tick);
+    return sd_script_is_last_frame_at(state->parser, state->current_tick);
 }
 
 bool player_is_looping(const object *obj) {
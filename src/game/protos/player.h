@@ -3,10 +3,13 @@
 
 #include "formats/script.h"
 #include "game/game_state.h"
+#include "game/utils/phys.h"
+#include "game/utils/serial.h"
 #include "utils/vec.h"
 #include <stdint.h>
 
 typedef struct object_t object;
+typedef struct state_hash state_hash;
 
 typedef void (*object_state_add_cb)(object *parent, int id, vec2i pos, vec2f vel, uint8_t mp_flags, int s, int g,
                                     void *userdata);
@@ -37,7 +40,7 @@ typedef struct player_sprite_state_t {
 } player_sprite_state;
 
 typedef struct player_slide_op_t {
-    vec2f vel;
+    vec2p vel;
     int timer;
 } player_slide_state;
 
@@ -52,7 +55,8 @@ typedef struct player_animation_state_t {
     uint32_t current_tick;
     int previous;
     int entered_frame;
-    sd_script parser;
+    sd_script *parser;
+    bool parser_own; // parser is a private copy (shared with clones until modified), otherwise owned by the animation
     uint8_t repeat;
     uint8_t reverse;
     uint8_t finished;
@@ -69,16 +73,24 @@ typedef struct player_animation_state_t {
     uint32_t enemy_obj_id;
     object_state_add_cb spawn;
     object_state_del_cb destroy;
+
+    // Objects owning the spawn and destroy userdata, only set while a snapshot is being restored
+    uint32_t spawn_owner_id;
+    uint32_t destroy_owner_id;
 } player_animation_state;
 
 void player_create(object *obj);
 void player_clone(object *src, object *dst);
 void player_free(object *obj);
+void player_serialize(const object *obj, serial *ser);
+void player_unserialize(object *obj, serial *ser);
+void player_link_userdata(object *obj);
+void player_hash(const object *obj, state_hash *h);
 void player_reload(object *obj);
 void player_reload_with_str(object *obj, const char *str);
 void player_reset(object *obj);
-int player_frame_isset(const object *obj, const char *tag);
-int player_frame_get(const object *obj, const char *tag);
+int player_frame_isset(const object *obj, sd_tag_id tag);
+int player_frame_get(const object *obj, sd_tag_id tag);
 void player_run(object *obj);
 void player_set_repeat(object *obj, int repeat);
 int player_get_repeat(const object *obj);
@@ -1,9 +1,9 @@
 #include "game/protos/scene.h"
 #include "game/game_player.h"
 #include "game/game_state_type.h"
-#include "resources/af_loader.h"
-#include "resources/bk_loader.h"
+#include "game/utils/state_hash.h"
 #include "resources/ids.h"
+#include "resources/resource_cache.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
 #include "utils/vec.h"
@@ -25,7 +25,7 @@ int scene_create(scene *scene, game_state *gs, int scene_id) {
     // Load BK
     int resource_id = scene_to_resource(scene_id);
     scene->bk_data = omf_calloc(1, sizeof(bk));
-    if(load_bk_file(scene->bk_data, resource_id)) {
+    if(resource_cache_load_bk(scene->bk_data, resource_id)) {
         log_error("Unable to load scene %s (%s)!", scene_get_name(scene_id), get_resource_name(resource_id));
         return 1;
     }
@@ -47,6 +47,9 @@ int scene_create(scene *scene, game_state *gs, int scene_id) {
     scene->startup = NULL;
     scene->prio_override = NULL;
     scene->debug = NULL;
+    scene->serialize = NULL;
+    scene->unserialize = NULL;
+    scene->hash = NULL;
 
     // Set base palette
     vga_state_set_base_palette_from(bk_get_palette(scene->bk_data, 0));
@@ -67,13 +70,13 @@ int scene_create(scene *scene, game_state *gs, int scene_id) {
 int scene_load_har(scene *scene, int player_id) {
     game_player *player = game_state_get_player(scene->gs, player_id);
     if(scene->af_data[player_id]) {
-        af_free(scene->af_data[player_id]);
+        resource_cache_free_af(scene->af_data[player_id]);
         omf_free(scene->af_data[player_id]);
     }
     scene->af_data[player_id] = omf_calloc(1, sizeof(af));
 
     int resource_id = har_to_resource(player->pilot->har_id);
-    if(load_af_file(scene->af_data[player_id], resource_id)) {
+    if(resource_cache_load_af(scene->af_data[player_id], resource_id)) {
         log_error("Unable to load HAR %s (%s)!", har_get_name(player->pilot->har_id), get_resource_name(resource_id));
         return 1;
     }
@@ -82,6 +85,22 @@ int scene_load_har(scene *scene, int player_id) {
     return 0;
 }
 
+void scene_prefetch(game_state *gs, int scene_id) {
+    if(scene_id == SCENE_NONE) {
+        return;
+    }
+    resource_cache_prefetch_bk(scene_to_resource(scene_id));
+    if(scene_id < SCENE_ARENA0 || scene_id > SCENE_ARENA4) {
+        return;
+    }
+    for(int i = 0; i < 2; i++) {
+        game_player *player = game_state_get_player(gs, i);
+        if(player->pilot != NULL) {
+            resource_cache_prefetch_af(har_to_resource(player->pilot->har_id));
+        }
+    }
+}
+
 void scene_init(scene *scene) {
     int m_load;
     int m_repeat;
@@ -135,6 +154,29 @@ int scene_clone_free(scene *sc) {
     return 0;
 }
 
+void scene_serialize(const scene *sc, serial *ser) {
+    serial_write_int32(ser, sc->static_ticks_since_start);
+    ticktimer_serialize(&sc->tick_timer, ser);
+    if(sc->serialize) {
+        sc->serialize(sc, ser);
+    }
+}
+
+void scene_unserialize(scene *sc, serial *ser) {
+    sc->static_ticks_since_start = serial_read_int32(ser);
+    ticktimer_unserialize(&sc->tick_timer, ser);
+    if(sc->unserialize) {
+        sc->unserialize(sc, ser);
+    }
+}
+
+void scene_hash(const scene *sc, state_hash *h) {
+    state_hash_int(h, "id", sc->id);
+    if(sc->hash) {
+        sc->hash(sc, h);
+    }
+}
+
 void scene_set_userdata(scene *scene, void *userdata) {
     scene->userdata = userdata;
 }
@@ -223,14 +265,14 @@ void scene_free(scene *scene) {
     if(scene->free != NULL) {
         scene->free(scene);
     }
-    bk_free(scene->bk_data);
+    resource_cache_free_bk(scene->bk_data);
     omf_free(scene->bk_data);
     if(scene->af_data[0]) {
-        af_free(scene->af_data[0]);
+        resource_cache_free_af(scene->af_data[0]);
         omf_free(scene->af_data[0]);
     }
     if(scene->af_data[1]) {
-        af_free(scene->af_data[1]);
+        resource_cache_free_af(scene->af_data[1]);
         omf_free(scene->af_data[1]);
     }
     ticktimer_close(&scene->tick_timer);
@@ -15,6 +15,7 @@
 typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct game_state_t game_state;
+typedef struct state_hash state_hash;
 
 typedef void (*scene_free_cb)(scene *scene);
 typedef int (*scene_event_cb)(scene *scene, SDL_Event *event);
@@ -27,6 +28,9 @@ typedef void (*scene_startup_cb)(scene *scene, int anim_id, int *m_load, int *m_
 typedef int (*scene_anim_prio_override_cb)(scene *scene, int anim_id);
 typedef void (*scene_clone_cb)(scene *src, scene *dst);
 typedef void (*scene_clone_free_cb)(scene *scene);
+typedef void (*scene_serialize_cb)(const scene *scene, serial *ser);
+typedef void (*scene_unserialize_cb)(scene *scene, serial *ser);
+typedef void (*scene_hash_cb)(const scene *scene, state_hash *h);
 
 struct scene_t {
     game_state *gs;
@@ -48,11 +52,20 @@ struct scene_t {
     scene_anim_prio_override_cb prio_override;
     scene_clone_cb clone;
     scene_clone_free_cb clone_free;
+    scene_serialize_cb serialize;
+    scene_unserialize_cb unserialize;
+    scene_hash_cb hash;
     ticktimer tick_timer;
 };
 
 int scene_create(scene *scene, game_state *gs, int scene_id);
 int scene_load_har(scene *scene, int player_id);
+
+/**
+ * Starts loading the files of a scene in the background, so that switching to it later is fast. For arenas,
+ * this includes the HARs of both players.
+ */
+void scene_prefetch(game_state *gs, int scene_id);
 void scene_init(scene *scene);
 void scene_free(scene *scene);
 int scene_event(scene *scene, SDL_Event *event);
@@ -68,6 +81,9 @@ bool scene_is_arena(scene *scene);
 
 int scene_clone(scene *src, scene *dst, game_state *gs);
 int scene_clone_free(scene *sc);
+void scene_serialize(const scene *sc, serial *ser);
+void scene_unserialize(scene *sc, serial *ser);
+void scene_hash(const scene *sc, state_hash *h);
 
 void scene_set_userdata(scene *scene, void *userdata);
 void *scene_get_userdata(const scene *scene);
@@ -28,6 +28,7 @@
 #include "game/scenes/arena.h"
 #include "game/scenes/mechlab/lab_menu_customize.h"
 #include "game/utils/score.h"
+#include "game/utils/state_hash.h"
 #include "game/utils/settings.h"
 #include "game/utils/ticktimer.h"
 #include "resources/languages.h"
@@ -45,6 +46,9 @@
 #define GAME_MENU_RETURN_ID 100
 #define GAME_MENU_QUIT_ID 101
 
+// How often recorded moves are written to disk during the match
+#define REC_FLUSH_TICKS 100
+
 typedef enum
 {
     NONE = 0,
@@ -439,7 +443,7 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
     // log_debug("Player %d hit wall %d", player_id, wall);
 
     // HAR must be in the air to be get faceplanted to a wall.
-    if(o_har->pos.y >= ARENA_FLOOR - 10) {
+    if(o_har->pos.y >= phys_from_int(ARENA_FLOOR - 10)) {
         return;
     }
 
@@ -451,7 +455,7 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
     // The limit here is entirely guesswork, and might not be it at all
     // However, it is a close enough guess.
     // TODO: Find out how this really works.
-    if(h->last_damage_value <= 15) {
+    if(h->last_damage_value <= phys_from_int(15)) {
         return;
     }
 
@@ -474,7 +478,7 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
             // TODO this doesn't track the har's position well...
             info = bk_get_info(scene->bk_data, 22);
             object *obj2 = omf_calloc(1, sizeof(object));
-            object_create(obj2, scene->gs, vec2i_create(o_har->pos.x, o_har->pos.y), vec2f_create(0, 0));
+            object_create(obj2, scene->gs, vec2p_to_i(o_har->pos), vec2f_create(0, 0));
             object_set_stl(obj2, scene->bk_data->sound_translation_table);
             object_set_animation(obj2, &info->ani);
             object_attach_to(obj2, o_har);
@@ -520,8 +524,8 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
             int variance = rand_int(20) - 10;
             int anim_no = rand_int(2) + 24;
             // log_debug("XXX anim = %d, variance = %d", anim_no, variance);
-            int pos_y = o_har->pos.y - object_get_size(o_har).y + variance + i * 25;
-            vec2i coord = vec2i_create(o_har->pos.x, pos_y);
+            int pos_y = phys_to_int(o_har->pos.y) - object_get_size(o_har).y + variance + i * 25;
+            vec2i coord = vec2i_create(phys_to_int(o_har->pos.x), pos_y);
             object *dust = omf_calloc(1, sizeof(object));
             object_create(dust, scene->gs, coord, vec2f_create(0, 0));
             object_set_stl(dust, scene->bk_data->sound_translation_table);
@@ -530,7 +534,7 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
         }
 
         // Wallhit sound
-        float d = ((float)o_har->pos.x) / 640.0f;
+        float d = phys_to_float(o_har->pos.x) / 640.0f;
         float pos_pan = d - 0.25f;
         game_state_play_sound(o_har->gs, 68, 1.0f, pos_pan, 2.0f);
     }
@@ -542,15 +546,15 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
         // Set hit animation
         object_set_animation(o_har, &af_get_move(h->af_data, ANIM_DAMAGE)->ani);
         object_set_repeat(o_har, 0);
-        scene->gs->screen_shake_horizontal = 3 * fabsf(o_har->vel.x);
+        scene->gs->screen_shake_horizontal = 3 * phys_to_float(phys_abs(o_har->vel.x));
         // from MASTER.DAT
         object_set_custom_string(o_har, "hQ1-hQ7-x-3Q5-x-2L5-x-2M900");
 
         if(wall == 1) {
-            o_har->pos.x = ARENA_RIGHT_WALL - 2;
+            o_har->pos.x = phys_from_int(ARENA_RIGHT_WALL - 2);
             object_set_direction(o_har, OBJECT_FACE_RIGHT);
         } else {
-            o_har->pos.x = ARENA_LEFT_WALL + 2;
+            o_har->pos.x = phys_from_int(ARENA_LEFT_WALL + 2);
             object_set_direction(o_har, OBJECT_FACE_LEFT);
         }
     }
@@ -752,37 +756,13 @@ void maybe_install_har_hooks(scene *scene) {
     har_install_hook(har2, &arena_har_hook, scene);
 }
 
-// djb hash
 uint32_t arena_state_hash(game_state *gs) {
-    uint32_t hash = 5381;
-    // include the arena ID
-    hash = ((hash << 5) + hash) + gs->sc->id;
-    for(int i = 0; i < 2; i++) {
-        game_player *player = game_state_get_player(gs, i);
-        object *obj_har = game_state_find_object(gs, game_player_get_har_obj_id(player));
-        har *har = obj_har->userdata;
-        vec2i pos = object_get_pos(obj_har);
-        vec2f vel = object_get_vel(obj_har);
-        uint32_t x = (uint32_t)pos.x;
-        uint32_t y = (uint32_t)pos.y;
-        uint32_t health = (uint32_t)har->health;
-        uint32_t endurance = (uint32_t)har->endurance;
-        hash = ((hash << 5) + hash) + har->id;
-        hash = ((hash << 5) + hash) + player->pilot->power;
-        hash = ((hash << 5) + hash) + player->pilot->agility;
-        hash = ((hash << 5) + hash) + player->pilot->endurance;
-        hash = ((hash << 5) + hash) + x;
-        hash = ((hash << 5) + hash) + y;
-        hash = ((hash << 5) + hash) + health;
-        hash = ((hash << 5) + hash) + endurance;
-        hash = ((hash << 5) + hash) + (uint32_t)vel.x;
-        // we are inconsistent on applying gravity
-        // hash = ((hash << 5) + hash) + (uint32_t)vel.y;
-        hash = ((hash << 5) + hash) + har->state;
-        hash = ((hash << 5) + hash) + har->executing_move;
-        hash = ((hash << 5) + hash) + obj_har->cur_animation->id;
-    }
-    return hash;
+    // The network protocol carries 32 bits, fold the full state hash down.
+    state_hash h;
+    state_hash_init(&h, NULL, NULL);
+    game_state_hash(gs, &h);
+    uint64_t hash = state_hash_finish(&h);
+    return (uint32_t)(hash ^ (hash >> 32));
 }
 
 char *state_name(int state) {
@@ -838,8 +818,8 @@ void arena_state_dump(game_state *gs, char *buf, size_t bufsize) {
                        "player %d  power %d agility %d endurance %d HAR id %d  pos %d,%d, health %d, endurance %f, "
                        "velocity %f,%f, state %s, executing_move %d cur_anim %d\n",
                        i, player->pilot->power, player->pilot->agility, player->pilot->endurance, har->id, pos.x, pos.y,
-                       har->health, (float)har->endurance, vel.x, vel.y, state_name(har->state), har->executing_move,
-                       obj_har->cur_animation->id);
+                       har->health, phys_to_float(har->endurance), vel.x, vel.y, state_name(har->state),
+                       har->executing_move, obj_har->cur_animation->id);
     }
 }
 
@@ -855,7 +835,12 @@ void arena_free(scene *scene) {
 
         if(scene->gs->init_flags->record == 1) {
             // we're supposed to save it
-            sd_rec_save(scene->gs->rec, scene->gs->init_flags->rec_file);
+            if(scene->gs->rec_stream) {
+                sd_rec_stream_close(scene->gs->rec_stream, scene->gs->rec);
+                scene->gs->rec_stream = NULL;
+            } else {
+                sd_rec_save(scene->gs->rec, scene->gs->init_flags->rec_file);
+            }
             sd_rec_free(scene->gs->rec);
             omf_free(scene->gs->rec);
             scene->gs->rec = NULL;
@@ -938,7 +923,7 @@ void write_rec_move(scene *scene, game_player *player, int action) {
 
     int ret;
 
-    if((ret = sd_rec_insert_action(scene->gs->rec, scene->gs->rec->move_count, &move)) != SD_SUCCESS) {
+    if((ret = sd_rec_append_action(scene->gs->rec, &move)) != SD_SUCCESS) {
         log_debug("recoding move failed %d", ret);
     }
 }
@@ -1032,7 +1017,7 @@ bool har_in_defeat_animation(object *obj) {
 }
 
 bool defeated_at_rest(object *obj) {
-    return har_in_defeat_animation(obj) && !object_is_airborne(obj) && obj->vel.x == 0.0f;
+    return har_in_defeat_animation(obj) && !object_is_airborne(obj) && obj->vel.x == 0;
 }
 
 bool har_unfinished_victory(object *obj) {
@@ -1049,6 +1034,13 @@ void arena_dynamic_tick(scene *scene, int paused) {
     arena_local *local = scene_get_userdata(scene);
     game_state *gs = scene->gs;
 
+    // Keep the recording on disk up to date, so that it survives a crash
+    if(gs->rec_stream && gs->int_tick % REC_FLUSH_TICKS == 0) {
+        if(sd_rec_stream_flush(gs->rec_stream, gs->rec) != SD_SUCCESS) {
+            log_error("Failed to write recording %s.", gs->init_flags->rec_file);
+        }
+    }
+
     if(!paused) {
         object *obj_har[2];
         har *hars[2];
@@ -1064,7 +1056,7 @@ void arena_dynamic_tick(scene *scene, int paused) {
         // Set and tick all proggressbars
         for(int i = 0; i < 2; i++) {
             float hp = (float)hars[i]->health / (float)hars[i]->health_max;
-            float en = (float)hars[i]->endurance / (float)hars[i]->endurance_max;
+            float en = phys_to_float(hars[i]->endurance) / phys_to_float(hars[i]->endurance_max);
             progressbar_set_progress(local->health_bars[i], hp * 100, gs->warp_speed ? false : true);
             progressbar_set_progress(local->endurance_bars[i], en * 100, gs->warp_speed ? false : true);
             progressbar_set_flashing(local->endurance_bars[i], (en * 100 < 50), 8);
@@ -1100,7 +1092,7 @@ void arena_dynamic_tick(scene *scene, int paused) {
                 local->win_state = NONE;
             } else if(local->win_state == DONE) {
                 // you win/lose animation is done
-                if(player_frame_isset(obj_har[0], "be") || player_frame_isset(obj_har[1], "be") ||
+                if(player_frame_isset(obj_har[0], SD_TAG_BE) || player_frame_isset(obj_har[1], SD_TAG_BE) ||
                    chr_score_onscreen(s1) || chr_score_onscreen(s2) || har_unfinished_victory(obj_har[0]) ||
                    har_unfinished_victory(obj_har[1])) {
                 } else {
@@ -1162,8 +1154,10 @@ void arena_dynamic_tick(scene *scene, int paused) {
         }
 
         // check some invariants
-        assert(obj_har[0]->pos.x >= ARENA_LEFT_WALL && obj_har[0]->pos.x <= ARENA_RIGHT_WALL);
-        assert(obj_har[1]->pos.x >= ARENA_LEFT_WALL && obj_har[1]->pos.x <= ARENA_RIGHT_WALL);
+        assert(obj_har[0]->pos.x >= phys_from_int(ARENA_LEFT_WALL) &&
+               obj_har[0]->pos.x <= phys_from_int(ARENA_RIGHT_WALL));
+        assert(obj_har[1]->pos.x >= phys_from_int(ARENA_LEFT_WALL) &&
+               obj_har[1]->pos.x <= phys_from_int(ARENA_RIGHT_WALL));
         if(hars[0]->health == 0) {
             assert(hars[0]->state == STATE_DEFEAT || hars[0]->state == STATE_RECOIL || hars[0]->state == STATE_FALLEN ||
                    hars[0]->state == STATE_NONE || hars[0]->state == STATE_WALLDAMAGE);
@@ -1353,7 +1347,7 @@ static void arena_debug(scene *scene) {
             text_render(&tconf_debug, TEXT_DEFAULT, 315 - (strlen(buf) * fnt->w), 48, 250, 6, buf);
         }
 
-        snprintf(buf, sizeof(buf), "vel: %.3f %.3f", obj_har[i]->vel.x, obj_har[i]->vel.y);
+        snprintf(buf, sizeof(buf), "vel: %.3f %.3f", object_vx(obj_har[i]), object_vy(obj_har[i]));
 
         if(i == 0) {
             text_render(&tconf_debug, TEXT_DEFAULT, 5, 56, 250, 6, buf);
@@ -1391,6 +1385,7 @@ void arena_clone(scene *src, scene *dst) {
     arena_local *local = omf_calloc(1, sizeof(arena_local));
     dst->userdata = local;
     memcpy(dst->userdata, src->userdata, sizeof(arena_local));
+    dst->gs->clone_struct_bytes += sizeof(arena_local);
     maybe_install_har_hooks(dst);
 
     component *c = gui_frame_find(local->game_menu, GAME_MENU_QUIT_ID);
@@ -1399,6 +1394,65 @@ void arena_clone(scene *src, scene *dst) {
     button_set_userdata(c, dst);
 }
 
+// The game menu and the health and endurance bars belong to the scene and are not part of the snapshot.
+void arena_serialize(const scene *sc, serial *ser) {
+    const arena_local *local = scene_get_userdata(sc);
+    serial_write_uint32(ser, local->state);
+    serial_write_int32(ser, local->ending_ticks);
+    serial_write_int32(ser, local->round);
+    serial_write_int32(ser, local->rounds);
+    serial_write_int32(ser, local->over);
+    serial_write_int32(ser, local->winner);
+    serial_write_int8(ser, local->tournament);
+    serial_write_int32(ser, local->win_state);
+    for(int i = 0; i < 2; i++) {
+        for(int k = 0; k < 4; k++) {
+            serial_write_int32(ser, local->player_rounds[i][k]);
+        }
+    }
+    serial_write_int32(ser, local->rein_enabled);
+    serial_write_int32(ser, local->rec_last[0]);
+    serial_write_int32(ser, local->rec_last[1]);
+}
+
+void arena_unserialize(scene *sc, serial *ser) {
+    arena_local *local = scene_get_userdata(sc);
+    local->state = serial_read_uint32(ser);
+    local->ending_ticks = serial_read_int32(ser);
+    local->round = serial_read_int32(ser);
+    local->rounds = serial_read_int32(ser);
+    local->over = serial_read_int32(ser);
+    local->winner = serial_read_int32(ser);
+    local->tournament = serial_read_int8(ser);
+    local->win_state = serial_read_int32(ser);
+    for(int i = 0; i < 2; i++) {
+        for(int k = 0; k < 4; k++) {
+            local->player_rounds[i][k] = serial_read_int32(ser);
+        }
+    }
+    local->rein_enabled = serial_read_int32(ser);
+    local->rec_last[0] = serial_read_int32(ser);
+    local->rec_last[1] = serial_read_int32(ser);
+}
+
+void arena_hash(const scene *sc, state_hash *h) {
+    const arena_local *local = scene_get_userdata(sc);
+    state_hash_int(h, "state", local->state);
+    state_hash_int(h, "ending_ticks", local->ending_ticks);
+    state_hash_int(h, "round", local->round);
+    state_hash_int(h, "rounds", local->rounds);
+    state_hash_int(h, "over", local->over);
+    state_hash_int(h, "winner", local->winner);
+    state_hash_int(h, "rein_enabled", local->rein_enabled);
+    char name[16];
+    for(int i = 0; i < 2; i++) {
+        for(int k = 0; k < 4; k++) {
+            snprintf(name, sizeof(name), "p%d_round%d", i + 1, k);
+            state_hash_int(h, name, local->player_rounds[i][k]);
+        }
+    }
+}
+
 void arena_startup(scene *scene, int id, int *m_load, int *m_repeat) {
     if(scene->bk_data->file_id == 64) {
         // Start up & repeat torches on arena startup
@@ -1494,6 +1548,9 @@ int arena_create(scene *scene) {
     pos[0] = vec2i_create(HAR1_START_POS, ARENA_FLOOR);
     pos[1] = vec2i_create(HAR2_START_POS, ARENA_FLOOR);
 
+    // Usually done on the VS screen already. If not, this at least loads both HARs at the same time.
+    scene_prefetch(scene->gs, scene->id);
+
     // init HARs
     for(int i = 0; i < 2; i++) {
         // Declare some vars
@@ -1739,6 +1796,9 @@ int arena_create(scene *scene) {
     scene_set_render_overlay_cb(scene, arena_render_overlay);
     scene_set_debug_cb(scene, arena_debug);
     scene->clone = arena_clone;
+    scene->serialize = arena_serialize;
+    scene->unserialize = arena_unserialize;
+    scene->hash = arena_hash;
 
     // initialize recording, if we're not doing playback
     if(scene->gs->init_flags->playback == 0) {
@@ -1844,6 +1904,16 @@ int arena_create(scene *scene) {
         scene->gs->rec->hazards = scene->gs->match_settings.hazards;
         scene->gs->rec->round_type = scene->gs->match_settings.rounds;
         scene->gs->rec->hyper_mode = scene->gs->match_settings.fight_mode;
+
+        if(scene->gs->init_flags->record == 1) {
+            if(scene->gs->rec_stream) {
+                sd_rec_stream_close(scene->gs->rec_stream, NULL);
+            }
+            scene->gs->rec_stream = sd_rec_stream_open(scene->gs->rec, scene->gs->init_flags->rec_file);
+            if(!scene->gs->rec_stream) {
+                log_error("Unable to open recording %s for writing.", scene->gs->init_flags->rec_file);
+            }
+        }
     }
 
     // All done!
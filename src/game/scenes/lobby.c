@@ -1,6 +1,7 @@
 #include "game/gui/dialog.h"
 #include "game/gui/gui_frame.h"
 #include "game/protos/scene.h"
+#include "game/utils/lobby_protocol.h"
 #include "game/utils/serial.h"
 #include "game/utils/version.h"
 #include "utils/allocator.h"
@@ -27,10 +28,6 @@
 #define LEAVE_COLOR 5
 #define ANNOUNCEMENT_COLOR 48
 
-#define VERSION_BUF_SIZE 30
-// increment this when the protocol with the lobby server changes
-#define PROTOCOL_VERSION 0
-
 enum
 {
     LOBBY_STARTING,
@@ -44,69 +41,12 @@ enum
     LOBBY_ACTION_COUNT
 };
 
-enum
-{
-    PACKET_JOIN = 1,
-    PACKET_YELL,
-    PACKET_WHISPER,
-    PACKET_CHALLENGE,
-    PACKET_DISCONNECT,
-    PACKET_PRESENCE,
-    PACKET_CONNECTED,
-    PACKET_REFRESH,
-    PACKET_ANNOUNCEMENT,
-    PACKET_RELAY,
-};
-
-enum
-{
-    JOIN_SUCCESS = 0,
-    JOIN_ERROR_NAME_USED,
-    JOIN_ERROR_NAME_INVALID,
-    JOIN_ERROR_UNSUPPORTED_PROTOCOL,
-};
-
-enum
-{
-    CHALLENGE_OFFER = 0,
-    CHALLENGE_ACCEPT,
-    CHALLENGE_REJECT,
-    CHALLENGE_CANCEL,
-    CHALLENGE_DONE,
-    CHALLENGE_ERROR,
-};
-
 enum
 {
     ROLE_CHALLENGER,
     ROLE_CHALLENGEE,
 };
 
-enum
-{
-    PRESENCE_UNKNOWN = 1,
-    PRESENCE_STARTING,
-    PRESENCE_AVAILABLE,
-    PRESENCE_PRACTICING,
-    PRESENCE_CHALLENGING,
-    PRESENCE_PONDERING,
-    PRESENCE_FIGHTING,
-    PRESENCE_WATCHING,
-};
-
-typedef struct lobby_user_t {
-    char name[16];
-    char version[VERSION_BUF_SIZE];
-    bool self;
-    ENetAddress address;
-    uint16_t port;     // port the server sees this user connecting from
-    uint16_t ext_port; // port this user claims will route inbound to them (or 0)
-    uint32_t id;
-    uint8_t wins;
-    uint8_t losses;
-    uint8_t status;
-} lobby_user;
-
 typedef struct lobby_local_t {
     ENetHost *client;
     ENetPeer *peer;
@@ -586,12 +526,12 @@ void lobby_entered_name(component *c, void *userdata) {
 
         strncpy_or_truncate(local->name, textinput_value(c), sizeof(local->name));
 
-        char version[VERSION_BUF_SIZE];
+        char version[LOBBY_VERSION_SIZE];
         // TODO support git version when not on a tag
         snprintf(version, sizeof(version), "%s", get_version_string());
         serial ser;
         serial_create(&ser);
-        serial_write_int8(&ser, PACKET_JOIN << 4 | (PROTOCOL_VERSION & 0x0f));
+        serial_write_int8(&ser, PACKET_JOIN << 4 | (LOBBY_PROTOCOL_VERSION & 0x0f));
         // if we mapped an external port, send it to the server
         if(local->nat->type != NAT_TYPE_NONE) {
             serial_write_int16(&ser, local->nat->ext_port ? local->nat->ext_port : local->client->address.port);
@@ -837,7 +777,7 @@ void lobby_tick(scene *scene, int paused) {
         ENetAddress lobby_address;
         enet_address_set_host(&lobby_address, settings_get()->net.net_lobby_address);
         // enet_address_set_host(&address, "127.0.0.1");
-        lobby_address.port = 2098;
+        lobby_address.port = LOBBY_PORT;
         log_debug("server address is %s", settings_get()->net.net_lobby_address);
         /* Initiate the connection, allocating the two channels 0, 1 and 2. */
         local->peer = enet_host_connect(local->client, &lobby_address, 3, 0);
@@ -978,56 +918,12 @@ void lobby_tick(scene *scene, int paused) {
                 switch(control_byte >> 4) {
                     case PACKET_PRESENCE: {
                         lobby_user user;
-                        user.id = serial_read_uint32(&ser);
-                        user.address.host = serial_read_uint32(&ser);
-                        user.port = serial_read_uint16(&ser);
-                        user.ext_port = serial_read_uint16(&ser);
-                        if(user.ext_port != 0) {
-                            user.address.port = user.ext_port;
-                        } else {
-                            user.address.port = user.port;
-                        }
-                        user.wins = serial_read_int8(&ser);
-                        user.losses = serial_read_int8(&ser);
-                        user.status = serial_read_int8(&ser);
-                        uint8_t version_len = serial_read_int8(&ser);
-                        if(version_len < sizeof(user.version)) {
-                            serial_read(&ser, user.version, version_len);
-                            user.version[version_len] = 0;
-                            uint8_t name_len = ser.wpos - ser.rpos;
-                            if(name_len > 0 && name_len < 16) {
-                                serial_read(&ser, user.name, name_len);
-                                user.name[name_len] = 0;
-                                // check if this user already exists and update it if it does
-                                iterator it;
-                                list_iter_begin(&local->users, &it);
-                                lobby_user *u;
-                                bool found = false;
-                                foreach(it, u) {
-                                    if(u->id == user.id) {
-                                        found = true;
-                                        u->wins = user.wins;
-                                        u->losses = user.losses;
-                                        u->status = user.status;
-                                        u->address.host = user.address.host;
-                                        u->port = user.port;
-                                        u->ext_port = user.ext_port;
-                                        u->address.port = user.address.port;
-                                        memcpy(user.version, u->version, sizeof(user.version));
-                                        break;
-                                    }
-                                }
-
-                                if(!found) {
-                                    list_append(&local->users, &user, sizeof(lobby_user));
-                                    if(control_byte & 0x8) {
-                                        log_event log;
-                                        log.color = JOIN_COLOR;
-                                        snprintf(log.msg, sizeof(log.msg), "%s has entered the Arena", user.name),
-                                            list_append(&local->log, &log, sizeof(log));
-                                    }
-                                }
-                            }
+                        if(lobby_presence_read(&ser, &user) && lobby_users_update(&local->users, &user) &&
+                           (control_byte & LOBBY_PRESENCE_JOINED)) {
+                            log_event log;
+                            log.color = JOIN_COLOR;
+                            snprintf(log.msg, sizeof(log.msg), "%s has entered the Arena", user.name);
+                            list_append(&local->log, &log, sizeof(log));
                         }
                     } break;
                     case PACKET_JOIN:
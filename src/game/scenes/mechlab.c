@@ -253,35 +253,40 @@ void mechlab_tick(scene *scene, int paused) {
             mechlab_enter_trnselect_menu(scene);
         } else if(local->dashtype == DASHBOARD_SELECT_TOURNAMENT) {
             sd_tournament_file *trn = lab_dash_trnselect_selected(&local->tw);
-            if(player1->pilot->money < trn->registration_fee) {
-                player1->pilot->money = 0;
+            if(trn == NULL) {
+                // None of the tournaments could be loaded, so there is nothing to register the pilot in
+                log_error("No tournament to register pilot %s in", player1->pilot->name);
             } else {
-                player1->pilot->money = player1->pilot->money - trn->registration_fee;
-            }
-            sd_chr_file *oldchr = player1->chr;
-            player1->chr = omf_calloc(1, sizeof(sd_chr_file));
-            sd_chr_create(player1->chr);
-            memcpy(&player1->chr->pilot, player1->pilot, sizeof(sd_pilot));
-            sd_chr_from_trn(player1->chr, trn, player1->pilot);
-
-            if(oldchr) {
-                if(player1->pilot != &oldchr->pilot) {
-                    sd_sprite_free(player1->pilot->photo);
-                    omf_free(player1->pilot->photo);
+                if(player1->pilot->money < trn->registration_fee) {
+                    player1->pilot->money = 0;
                 } else {
-                    player1->pilot = NULL;
+                    player1->pilot->money = player1->pilot->money - trn->registration_fee;
+                }
+                sd_chr_file *oldchr = player1->chr;
+                player1->chr = omf_calloc(1, sizeof(sd_chr_file));
+                sd_chr_create(player1->chr);
+                memcpy(&player1->chr->pilot, player1->pilot, sizeof(sd_pilot));
+                sd_chr_from_trn(player1->chr, trn, player1->pilot);
+
+                if(oldchr) {
+                    if(player1->pilot != &oldchr->pilot) {
+                        sd_sprite_free(player1->pilot->photo);
+                        omf_free(player1->pilot->photo);
+                    } else {
+                        player1->pilot = NULL;
+                    }
+                    sd_chr_free(oldchr);
+                    omf_free(oldchr);
                 }
-                sd_chr_free(oldchr);
-                omf_free(oldchr);
-            }
 
-            if(sg_save(player1->chr) != SD_SUCCESS) {
-                log_error("Failed to save pilot %s", player1->chr->pilot.name);
-            }
-            // force the character to reload because its just easier
+                if(sg_save(player1->chr) != SD_SUCCESS) {
+                    log_error("Failed to save pilot %s", player1->chr->pilot.name);
+                }
+                // force the character to reload because its just easier
 
-            sd_chr_free(player1->chr);
-            omf_free(player1->chr);
+                sd_chr_free(player1->chr);
+                omf_free(player1->chr);
+            }
 
             bool found = mechlab_find_last_player(scene);
             mechlab_select_dashboard(scene, DASHBOARD_STATS);
@@ -104,7 +104,12 @@ void lab_dash_main_chr_left(component *c, void *userdata) {
         dw->index = list_size(dw->savegames) - 1;
     }
     game_player *p1 = game_state_get_player(dw->scene->gs, 0);
-    p1->pilot = &((sd_chr_file *)list_get(dw->savegames, dw->index))->pilot;
+    sd_chr_file *chr = list_get(dw->savegames, dw->index);
+    if(chr == NULL) {
+        return;
+    }
+    sg_load_photo(chr);
+    p1->pilot = &chr->pilot;
     mechlab_update(dw->scene);
 }
 
@@ -116,7 +121,12 @@ void lab_dash_main_chr_right(component *c, void *userdata) {
         dw->index = 0;
     }
     game_player *p1 = game_state_get_player(dw->scene->gs, 0);
-    p1->pilot = &((sd_chr_file *)list_get(dw->savegames, dw->index))->pilot;
+    sd_chr_file *chr = list_get(dw->savegames, dw->index);
+    if(chr == NULL) {
+        return;
+    }
+    sg_load_photo(chr);
+    p1->pilot = &chr->pilot;
     mechlab_update(dw->scene);
 }
 
@@ -141,6 +151,12 @@ void lab_dash_main_chr_init(component *menu, component *submenu) {
     }
     dw->index = 0;
     chr = list_get(dw->savegames, 0);
+    if(chr == NULL) {
+        // every savegame was filtered out, so there is no other pilot to show
+        log_debug("no other pilots to select");
+        return;
+    }
+    sg_load_photo(chr);
     p1->pilot = &chr->pilot;
     if(!p1->chr) {
         mechlab_load_har(dw->scene, p1->pilot);
@@ -114,7 +114,7 @@ void cb_vs_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t mp
     bk_info *info = bk_get_info(sc->bk_data, id);
     if(info != NULL) {
         object *obj = omf_calloc(1, sizeof(object));
-        object_create(obj, parent->gs, vec2i_add(pos, vec2f_to_i(parent->pos)), vel);
+        object_create(obj, parent->gs, vec2i_add(pos, vec2p_to_i(parent->pos)), vel);
         object_set_stl(obj, object_get_stl(parent));
         object_set_animation(obj, &info->ani);
         object_set_spawn_cb(obj, cb_vs_spawn_object, userdata);
@@ -163,6 +163,7 @@ void vs_handle_action(scene *scene, int action) {
                     }
                     object *arena_select = game_state_find_object(scene->gs, local->arena_select_obj_id);
                     object_select_sprite(arena_select, local->arena);
+                    scene_prefetch(scene->gs, SCENE_ARENA0 + local->arena);
                 }
                 break;
             case ACT_DOWN:
@@ -174,6 +175,7 @@ void vs_handle_action(scene *scene, int action) {
                     }
                     object *arena_select = game_state_find_object(scene->gs, local->arena_select_obj_id);
                     object_select_sprite(arena_select, local->arena);
+                    scene_prefetch(scene->gs, SCENE_ARENA0 + local->arena);
                 }
                 break;
         }
@@ -568,6 +570,10 @@ int vs_create(scene *scene) {
         // pick a random arena for 1 player mode
         local->arena = rand_int(5); // srand was done in melee
     }
+    if(player2->pilot != NULL) {
+        // Load the fight in the background while this screen is up.
+        scene_prefetch(scene->gs, SCENE_ARENA0 + local->arena);
+    }
 
     // Arena
     if(player2->selectable) {
@@ -0,0 +1,72 @@
+#include "game/utils/lobby_protocol.h"
+#include "utils/iterator.h"
+#include <string.h>
+
+void lobby_presence_write(serial *ser, const lobby_user *user, bool joined) {
+    size_t version_len = strlen(user->version);
+    serial_write_int8(ser, PACKET_PRESENCE << 4 | (joined ? LOBBY_PRESENCE_JOINED : 0));
+    serial_write_uint32(ser, user->id);
+    serial_write_uint32(ser, user->address.host);
+    serial_write_int16(ser, user->port);
+    serial_write_int16(ser, user->ext_port);
+    serial_write_int8(ser, user->wins);
+    serial_write_int8(ser, user->losses);
+    serial_write_int8(ser, user->status);
+    serial_write_int8(ser, version_len);
+    serial_write(ser, user->version, version_len);
+    // the name is the rest of the packet
+    serial_write(ser, user->name, strlen(user->name));
+}
+
+bool lobby_presence_read(serial *ser, lobby_user *user) {
+    // id, host, port, ext_port, wins, losses, status and the version length
+    if(ser->wpos - ser->rpos < 16) {
+        return false;
+    }
+    user->self = false;
+    user->id = serial_read_uint32(ser);
+    user->address.host = serial_read_uint32(ser);
+    user->port = serial_read_uint16(ser);
+    user->ext_port = serial_read_uint16(ser);
+    if(user->ext_port != 0) {
+        user->address.port = user->ext_port;
+    } else {
+        user->address.port = user->port;
+    }
+    user->wins = serial_read_int8(ser);
+    user->losses = serial_read_int8(ser);
+    user->status = serial_read_int8(ser);
+    uint8_t version_len = serial_read_int8(ser);
+    if(version_len >= sizeof(user->version) || version_len > ser->wpos - ser->rpos) {
+        return false;
+    }
+    serial_read(ser, user->version, version_len);
+    user->version[version_len] = 0;
+    size_t name_len = ser->wpos - ser->rpos;
+    if(name_len == 0 || name_len >= sizeof(user->name)) {
+        return false;
+    }
+    serial_read(ser, user->name, name_len);
+    user->name[name_len] = 0;
+    return true;
+}
+
+bool lobby_users_update(list *users, const lobby_user *user) {
+    iterator it;
+    lobby_user *u;
+    list_iter_begin(users, &it);
+    foreach(it, u) {
+        if(u->id == user->id) {
+            u->wins = user->wins;
+            u->losses = user->losses;
+            u->status = user->status;
+            u->address = user->address;
+            u->port = user->port;
+            u->ext_port = user->ext_port;
+            memcpy(u->version, user->version, sizeof(u->version));
+            return false;
+        }
+    }
+    list_append(users, user, sizeof(lobby_user));
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef LOBBY_PROTOCOL_H
+#define LOBBY_PROTOCOL_H
+
+#include "game/utils/serial.h"
+#include "utils/list.h"
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Messages between the lobby scene and the lobby server. Every message is one reliable ENet packet on
+ * channel 0, and starts with a control byte of (packet type << 4 | subtype).
+ */
+
+// increment this when the protocol with the lobby server changes
+#define LOBBY_PROTOCOL_VERSION 0
+#define LOBBY_PORT 2098
+
+#define LOBBY_NAME_SIZE 16
+#define LOBBY_VERSION_SIZE 30
+
+// Set in the subtype of a presence packet when the user just joined
+#define LOBBY_PRESENCE_JOINED 0x8
+
+enum
+{
+    PACKET_JOIN = 1,
+    PACKET_YELL,
+    PACKET_WHISPER,
+    PACKET_CHALLENGE,
+    PACKET_DISCONNECT,
+    PACKET_PRESENCE,
+    PACKET_CONNECTED,
+    PACKET_REFRESH,
+    PACKET_ANNOUNCEMENT,
+    PACKET_RELAY,
+};
+
+enum
+{
+    JOIN_SUCCESS = 0,
+    JOIN_ERROR_NAME_USED,
+    JOIN_ERROR_NAME_INVALID,
+    JOIN_ERROR_UNSUPPORTED_PROTOCOL,
+};
+
+enum
+{
+    CHALLENGE_OFFER = 0,
+    CHALLENGE_ACCEPT,
+    CHALLENGE_REJECT,
+    CHALLENGE_CANCEL,
+    CHALLENGE_DONE,
+    CHALLENGE_ERROR,
+};
+
+enum
+{
+    PRESENCE_UNKNOWN = 1,
+    PRESENCE_STARTING,
+    PRESENCE_AVAILABLE,
+    PRESENCE_PRACTICING,
+    PRESENCE_CHALLENGING,
+    PRESENCE_PONDERING,
+    PRESENCE_FIGHTING,
+    PRESENCE_WATCHING,
+};
+
+typedef struct lobby_user_t {
+    char name[LOBBY_NAME_SIZE];
+    char version[LOBBY_VERSION_SIZE];
+    bool self;
+    ENetAddress address;
+    uint16_t port;     // port the server sees this user connecting from
+    uint16_t ext_port; // port this user claims will route inbound to them (or 0)
+    uint32_t id;
+    uint8_t wins;
+    uint8_t losses;
+    uint8_t status;
+} lobby_user;
+
+/**
+ * Writes a presence packet for the user.
+ *
+ * @param joined Whether the user just joined, so the clients announce them
+ */
+void lobby_presence_write(serial *ser, const lobby_user *user, bool joined);
+
+/**
+ * Reads a presence packet, after its control byte. Sets address.port to the port that should be used to
+ * connect to the user.
+ *
+ * @return false if the packet is truncated, or the version or name do not fit
+ */
+bool lobby_presence_read(serial *ser, lobby_user *user);
+
+/**
+ * Updates the entry with the same id as the user in a list of lobby_user, or appends the user if there is none.
+ *
+ * @return true if the user was appended
+ */
+bool lobby_users_update(list *users, const lobby_user *user);
+
+#endif // LOBBY_PROTOCOL_H
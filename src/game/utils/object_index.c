@@ -0,0 +1,112 @@
+#include "game/utils/object_index.h"
+#include "utils/allocator.h"
+#include <string.h>
+
+#define OBJECT_INDEX_MIN_CAPACITY 64
+
+static inline unsigned int object_index_home(const object_index *index, uint32_t id) {
+    // Multiplicative hashing. Object ids are mostly sequential, and consecutive ids get distinct slots.
+    return (id * 2654435769u) & (index->capacity - 1);
+}
+
+static void object_index_insert(object_index *index, uint32_t id, object *obj) {
+    unsigned int mask = index->capacity - 1;
+    unsigned int pos = object_index_home(index, id);
+    while(index->slots[pos].obj != NULL) {
+        if(index->slots[pos].id == id) {
+            index->slots[pos].obj = obj;
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+    index->slots[pos].id = id;
+    index->slots[pos].obj = obj;
+    index->count++;
+}
+
+static void object_index_grow(object_index *index) {
+    object_index_slot *old = index->slots;
+    unsigned int old_capacity = index->capacity;
+
+    index->capacity = old_capacity ? old_capacity * 2 : OBJECT_INDEX_MIN_CAPACITY;
+    index->slots = omf_calloc(index->capacity, sizeof(object_index_slot));
+    index->count = 0;
+    for(unsigned int i = 0; i < old_capacity; i++) {
+        if(old[i].obj != NULL) {
+            object_index_insert(index, old[i].id, old[i].obj);
+        }
+    }
+    omf_free(old);
+}
+
+void object_index_create(object_index *index) {
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+void object_index_free(object_index *index) {
+    omf_free(index->slots);
+    index->capacity = 0;
+    index->count = 0;
+}
+
+void object_index_clear(object_index *index) {
+    if(index->slots != NULL) {
+        memset(index->slots, 0, index->capacity * sizeof(object_index_slot));
+    }
+    index->count = 0;
+}
+
+void object_index_set(object_index *index, uint32_t id, object *obj) {
+    // Keep the load factor at or below one half, so that probe sequences stay short.
+    if((index->count + 1) * 2 > index->capacity) {
+        object_index_grow(index);
+    }
+    object_index_insert(index, id, obj);
+}
+
+void object_index_remove(object_index *index, uint32_t id) {
+    if(index->count == 0) {
+        return;
+    }
+    unsigned int mask = index->capacity - 1;
+    unsigned int pos = object_index_home(index, id);
+    while(index->slots[pos].obj != NULL && index->slots[pos].id != id) {
+        pos = (pos + 1) & mask;
+    }
+    if(index->slots[pos].obj == NULL) {
+        return;
+    }
+
+    // Shift the following entries of the probe sequence back, so that no tombstones are needed.
+    unsigned int hole = pos;
+    unsigned int next = (pos + 1) & mask;
+    while(index->slots[next].obj != NULL) {
+        unsigned int home = object_index_home(index, index->slots[next].id);
+        // The entry can fill the hole if its home slot is not in the range (hole, next]
+        if(((next - home) & mask) >= ((next - hole) & mask)) {
+            index->slots[hole] = index->slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->slots[hole].id = 0;
+    index->slots[hole].obj = NULL;
+    index->count--;
+}
+
+object *object_index_get(const object_index *index, uint32_t id) {
+    if(index->count == 0) {
+        return NULL;
+    }
+    unsigned int mask = index->capacity - 1;
+    unsigned int pos = object_index_home(index, id);
+    while(index->slots[pos].obj != NULL) {
+        if(index->slots[pos].id == id) {
+            return index->slots[pos].obj;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return NULL;
+}
@@ -0,0 +1,31 @@
+#ifndef OBJECT_INDEX_H
+#define OBJECT_INDEX_H
+
+#include <stdint.h>
+
+typedef struct object_t object;
+
+typedef struct object_index_slot_t {
+    uint32_t id;
+    object *obj;
+} object_index_slot;
+
+// Maps object ids to objects. Open addressing with linear probing; empty slots have a NULL object.
+typedef struct object_index_t {
+    object_index_slot *slots;
+    unsigned int capacity; // Always a power of two, or 0 before the first insert
+    unsigned int count;
+} object_index;
+
+void object_index_create(object_index *index);
+void object_index_free(object_index *index);
+void object_index_clear(object_index *index);
+void object_index_set(object_index *index, uint32_t id, object *obj);
+void object_index_remove(object_index *index, uint32_t id);
+object *object_index_get(const object_index *index, uint32_t id);
+
+static inline unsigned int object_index_size(const object_index *index) {
+    return index->count;
+}
+
+#endif // OBJECT_INDEX_H
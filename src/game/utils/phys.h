@@ -0,0 +1,198 @@
+#ifndef PHYS_H
+#define PHYS_H
+
+#include "game/utils/serial.h"
+#include "utils/fixedpt.h"
+#include "utils/random.h"
+#include "utils/vec.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Number type for simulation state that has to match between netplay peers: object positions and velocities,
+ * gravity, and the HAR speeds and endurance.
+ *
+ * This is a float by default. Builds with FIXED_PHYSICS (cmake -DUSE_FIXED_PHYSICS=ON) use 16.16 fixed-point
+ * numbers instead, so that the simulation stays bit-exact between peers that were built with different compilers
+ * or floating point flags. Both peers of a netplay game need to use the same mode.
+ *
+ * Addition, subtraction, comparison, and multiplication or division by an int work on both. Anything that
+ * mixes in a float or another phys goes through the helpers below.
+ */
+#ifdef FIXED_PHYSICS
+typedef fixedpt phys;
+#else
+typedef float phys;
+#endif
+
+typedef struct vec2p_t {
+    phys x;
+    phys y;
+} vec2p;
+
+#ifdef FIXED_PHYSICS
+
+static inline phys phys_from_int(int v) {
+    return fixedpt_from_int(v);
+}
+
+static inline int phys_to_int(phys v) {
+    return fixedpt_to_int(v);
+}
+
+static inline phys phys_from_float(float v) {
+    return fixedpt_from_float(v);
+}
+
+static inline float phys_to_float(phys v) {
+    return fixedpt_to_float(v);
+}
+
+static inline phys phys_mul(phys a, phys b) {
+    return fixedpt_mul(a, b);
+}
+
+static inline phys phys_div(phys a, phys b) {
+    return fixedpt_div(a, b);
+}
+
+static inline phys phys_abs(phys v) {
+    return fixedpt_abs(v);
+}
+
+static inline phys phys_sin(phys angle) {
+    return fixedpt_sin(angle);
+}
+
+static inline phys phys_cos(phys angle) {
+    return fixedpt_cos(angle);
+}
+
+// v * num / den, without rounding in between.
+static inline phys phys_scale(phys v, int num, int den) {
+    return (fixedpt)((int64_t)v * num / den);
+}
+
+// Random whole number in 0 <= r < range, drawn with random_int so that every peer gets the same value.
+static inline phys phys_random(struct random_t *r, int range) {
+    return fixedpt_from_int((int)random_int(r, range));
+}
+
+// Whether a and b are less than dist apart. Compares squared distances, so no square root is needed.
+static inline bool vec2p_closer_than(vec2p a, vec2p b, int dist) {
+    int64_t dx = (int64_t)b.x - a.x;
+    int64_t dy = (int64_t)b.y - a.y;
+    int64_t d = fixedpt_from_int(dist);
+    return dx * dx + dy * dy < d * d;
+}
+
+#else
+
+static inline phys phys_from_int(int v) {
+    return (float)v;
+}
+
+static inline int phys_to_int(phys v) {
+    return (int)v;
+}
+
+static inline phys phys_from_float(float v) {
+    return v;
+}
+
+static inline float phys_to_float(phys v) {
+    return v;
+}
+
+static inline phys phys_mul(phys a, phys b) {
+    return a * b;
+}
+
+static inline phys phys_div(phys a, phys b) {
+    return a / b;
+}
+
+static inline phys phys_abs(phys v) {
+    return fabsf(v);
+}
+
+static inline phys phys_sin(phys angle) {
+    return sinf(angle);
+}
+
+static inline phys phys_cos(phys angle) {
+    return cosf(angle);
+}
+
+// v * num / den, without rounding in between.
+static inline phys phys_scale(phys v, int num, int den) {
+    return (float)((double)v * num / den);
+}
+
+// Random number in 0 <= r <= range.
+static inline phys phys_random(struct random_t *r, int range) {
+    return random_float(r) * range;
+}
+
+// Whether a and b are less than dist apart.
+static inline bool vec2p_closer_than(vec2p a, vec2p b, int dist) {
+    return vec2f_dist(vec2f_create(a.x, a.y), vec2f_create(b.x, b.y)) < dist;
+}
+
+#endif // FIXED_PHYSICS
+
+// Same as dist() in miscmath.h, b - a.
+static inline phys phys_dist(phys a, phys b) {
+    return b - a;
+}
+
+static inline vec2p vec2p_create(phys x, phys y) {
+    vec2p v = {x, y};
+    return v;
+}
+
+static inline vec2p vec2i_to_p(vec2i v) {
+    return vec2p_create(phys_from_int(v.x), phys_from_int(v.y));
+}
+
+static inline vec2i vec2p_to_i(vec2p v) {
+    return vec2i_create(phys_to_int(v.x), phys_to_int(v.y));
+}
+
+static inline vec2p vec2f_to_p(vec2f v) {
+    return vec2p_create(phys_from_float(v.x), phys_from_float(v.y));
+}
+
+static inline vec2f vec2p_to_f(vec2p v) {
+    return vec2f_create(phys_to_float(v.x), phys_to_float(v.y));
+}
+
+// Snapshot helpers. Both float and fixed-point values are written bit for bit, so they restore exactly.
+static inline void serial_write_phys(serial *s, phys v) {
+#ifdef FIXED_PHYSICS
+    serial_write_int32(s, v);
+#else
+    serial_write_float(s, v);
+#endif
+}
+
+static inline phys serial_read_phys(serial *s) {
+#ifdef FIXED_PHYSICS
+    return serial_read_int32(s);
+#else
+    return serial_read_float(s);
+#endif
+}
+
+static inline void serial_write_vec2p(serial *s, vec2p v) {
+    serial_write_phys(s, v.x);
+    serial_write_phys(s, v.y);
+}
+
+static inline vec2p serial_read_vec2p(serial *s) {
+    phys x = serial_read_phys(s);
+    return vec2p_create(x, serial_read_phys(s));
+}
+
+#endif // PHYS_H
@@ -0,0 +1,107 @@
+#include "game/utils/replay_report.h"
+#include "game/game_state.h"
+#include "game/objects/har.h"
+#include "game/protos/scene.h"
+#include "game/scenes/arena.h"
+#include <inttypes.h>
+
+void replay_report_create(replay_report *report) {
+    vector_create_with_size(&report->hashes, sizeof(uint32_t), 4096);
+    report->first_tick = 0;
+    report->last_tick = 0;
+}
+
+void replay_report_free(replay_report *report) {
+    vector_free(&report->hashes);
+}
+
+static har *find_har(game_state *gs, int player_id) {
+    game_player *player = game_state_get_player(gs, player_id);
+    object *obj = game_state_find_object(gs, game_player_get_har_obj_id(player));
+    if(obj == NULL) {
+        return NULL;
+    }
+    return object_get_userdata(obj);
+}
+
+void replay_report_tick(replay_report *report, game_state *gs) {
+    if(gs->sc == NULL || !scene_is_arena(gs->sc) || find_har(gs, 0) == NULL || find_har(gs, 1) == NULL) {
+        return;
+    }
+    if(vector_size(&report->hashes) == 0) {
+        report->first_tick = gs->int_tick;
+    }
+    uint32_t hash = arena_state_hash(gs);
+    vector_append(&report->hashes, &hash);
+    report->last_tick = gs->int_tick;
+}
+
+static void write_string(const char *str, FILE *out) {
+    fputc('"', out);
+    for(const char *c = str; *c != '\0'; c++) {
+        if(*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if((unsigned char)*c < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+void replay_report_write(const replay_report *report, game_state *gs, const char *rec_file, FILE *out) {
+    const fight_stats *stats = &gs->fight_stats;
+    int rounds[2];
+    int health[2] = {-1, -1};
+    int endurance[2] = {-1, -1};
+    for(int i = 0; i < 2; i++) {
+        har *h = scene_is_arena(gs->sc) ? find_har(gs, i) : NULL;
+        rounds[i] = game_state_get_player(gs, i)->pilot->wins;
+        if(h != NULL) {
+            health[i] = h->health;
+            endurance[i] = phys_to_int(h->endurance);
+        }
+    }
+    int winner = rounds[0] == rounds[1] ? -1 : (rounds[0] > rounds[1] ? 0 : 1);
+
+    fprintf(out, "{\"file\":");
+    write_string(rec_file, out);
+    fprintf(out, ",\"result\":\"ok\",\"ticks\":%" PRIu32 ",\"winner\":%d", gs->int_tick, winner);
+    fprintf(out, ",\"rounds_won\":[%d,%d]", rounds[0], rounds[1]);
+    fprintf(out, ",\"health\":[%d,%d],\"endurance\":[%d,%d]", health[0], health[1], endurance[0], endurance[1]);
+    fprintf(out, ",\"hits_landed\":[%u,%u]", stats->hits_landed[0], stats->hits_landed[1]);
+    fprintf(out, ",\"total_attacks\":[%u,%u]", stats->total_attacks[0], stats->total_attacks[1]);
+    fprintf(out, ",\"first_tick\":%" PRIu32 ",\"hashes\":[", report->first_tick);
+    for(unsigned int i = 0; i < vector_size(&report->hashes); i++) {
+        const uint32_t *hash = vector_get(&report->hashes, i);
+        fprintf(out, i == 0 ? "%" PRIu32 : ",%" PRIu32, *hash);
+    }
+    fprintf(out, "]}\n");
+}
+
+void replay_report_write_net(const net_controller_stats *stats, const char *rec_file, const char *role, uint32_t ticks,
+                             uint64_t wall_ms, FILE *out) {
+    // Replays of a few ticks can finish within a millisecond
+    uint64_t replay_ms = stats->replay_ms > 0 ? stats->replay_ms : 1;
+
+    fprintf(out, "{\"file\":");
+    write_string(rec_file, out);
+    fprintf(out, ",\"result\":\"ok\",\"role\":\"%s\",\"ticks\":%" PRIu32 ",\"wall_ms\":%" PRIu64, role, ticks, wall_ms);
+    fprintf(out, ",\"rollbacks\":%u,\"replayed_ticks\":%u", stats->rollbacks, stats->replayed_ticks);
+    fprintf(out, ",\"replayed_ticks_per_sec\":%" PRIu64, stats->replayed_ticks * 1000 / replay_ms);
+    fprintf(out, ",\"max_rollback\":%u,\"replay_ms\":%" PRIu64, stats->max_rollback, stats->replay_ms);
+    fprintf(out, ",\"avg_rtt\":%d,\"frame_advantage\":%d", stats->avg_rtt, stats->frame_advantage);
+    fprintf(out, ",\"hash_tick\":%" PRIu32 ",\"hash\":%" PRIu32 ",\"peer_hash\":%" PRIu32, stats->hash_tick,
+            stats->hash, stats->peer_hash);
+    fprintf(out, ",\"hashes_checked\":%u,\"desynced\":%s", stats->hashes_checked, stats->desynced ? "true" : "false");
+    fprintf(out, ",\"disconnected\":%s}\n", stats->disconnected ? "true" : "false");
+}
+
+void replay_report_write_error(const char *rec_file, const char *error, FILE *out) {
+    fprintf(out, "{\"file\":");
+    write_string(rec_file, out);
+    fprintf(out, ",\"result\":\"error\",\"error\":");
+    write_string(error, out);
+    fprintf(out, "}\n");
+}
@@ -0,0 +1,50 @@
+#ifndef REPLAY_REPORT_H
+#define REPLAY_REPORT_H
+
+#include "controller/net_controller.h"
+#include "game/game_state_type.h"
+#include "utils/vector.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Results of a headless REC replay. Collects the arena state hash after every dynamic tick, and writes
+ * the outcome of the match as a single JSON line.
+ */
+typedef struct replay_report {
+    vector hashes; // uint32_t arena_state_hash() per dynamic tick, starting from first_tick
+    uint32_t first_tick;
+    uint32_t last_tick;
+} replay_report;
+
+void replay_report_create(replay_report *report);
+void replay_report_free(replay_report *report);
+
+/**
+ * Records the state hash of the current tick, if an arena with both HARs is running.
+ */
+void replay_report_tick(replay_report *report, game_state *gs);
+
+/**
+ * Writes the report, final result and fight stats of the game state as one line of JSON.
+ *
+ * @param gs Game state at the end of the replay, or NULL if the replay could not be started.
+ */
+void replay_report_write(const replay_report *report, game_state *gs, const char *rec_file, FILE *out);
+
+/**
+ * Writes the rollback statistics of a headless netplay game as one line of JSON.
+ *
+ * @param role "server" or "client"
+ * @param ticks Ticks played after the peers agreed on a start tick
+ * @param wall_ms Wall clock time of the whole game, including connecting
+ */
+void replay_report_write_net(const net_controller_stats *stats, const char *rec_file, const char *role, uint32_t ticks,
+                             uint64_t wall_ms, FILE *out);
+
+/**
+ * Writes a report line for a replay that did not finish.
+ */
+void replay_report_write_error(const char *rec_file, const char *error, FILE *out);
+
+#endif // REPLAY_REPORT_H
@@ -14,8 +14,12 @@
 #define SCRAP 100000
 #define DESTRUCTION 200000
 
+#define SCORE_TEXT_LEN 64
+// More texts than fit on screen at once, so that restoring a snapshot does not need to grow the list
+#define SCORE_TEXTS_RESERVED 16
+
 typedef struct score_text {
-    char *text;
+    char text[SCORE_TEXT_LEN];
     float position; // Position of text between middle of screen and (x,y). 1.0 at middle, 0.0 at end
     vec2i start;
     int points;
@@ -55,7 +59,7 @@ void chr_score_create(chr_score *score) {
     score->y = 0;
     score->direction = OBJECT_FACE_RIGHT;
     score->multipliers = std_multipliers;
-    list_create(&score->texts);
+    vector_create_with_size(&score->texts, sizeof(score_text), SCORE_TEXTS_RESERVED);
     chr_score_reset(score, 1);
     chr_score_reset_wins(score);
 }
@@ -69,9 +73,6 @@ void chr_score_set_tournament_mode(chr_score *score, bool tournament) {
 }
 
 void chr_score_reset(chr_score *score, bool wipe) {
-    iterator it;
-    score_text *t;
-
     if(wipe) {
         score->score = 0;
     }
@@ -83,11 +84,7 @@ void chr_score_reset(chr_score *score, bool wipe) {
     score->done = false;
     score->scrap = false;
     score->destruction = false;
-    list_iter_begin(&score->texts, &it);
-    foreach(it, t) {
-        omf_free(t->text);
-        list_delete(&score->texts, &it);
-    }
+    vector_clear(&score->texts);
 }
 
 void chr_score_reset_wins(chr_score *score) {
@@ -101,11 +98,11 @@ void chr_score_set_pos(chr_score *score, int x, int y, int direction) {
 }
 
 unsigned int chr_score_get_num_texts(chr_score *score) {
-    return list_size(&score->texts);
+    return vector_size(&score->texts);
 }
 
 int chr_score_onscreen(chr_score *score) {
-    return list_size(&score->texts) > 0;
+    return vector_size(&score->texts) > 0;
 }
 
 float chr_score_get_difficulty_multiplier(chr_score *score) {
@@ -113,14 +110,7 @@ float chr_score_get_difficulty_multiplier(chr_score *score) {
 }
 
 void chr_score_free(chr_score *score) {
-    iterator it;
-    score_text *t;
-
-    list_iter_begin(&score->texts, &it);
-    foreach(it, t) {
-        omf_free(t->text);
-    }
-    list_free(&score->texts);
+    vector_free(&score->texts);
 }
 
 void chr_score_tick(chr_score *score) {
@@ -128,7 +118,7 @@ void chr_score_tick(chr_score *score) {
     score_text *t;
     int lastage = -1;
 
-    list_iter_begin(&score->texts, &it);
+    vector_iter_begin(&score->texts, &it);
     foreach(it, t) {
         // don't allow them to get too close together, if a bunch are added at once
         if(lastage > 0 && (lastage - t->age) < SLIDER_DISTANCE) {
@@ -140,8 +130,7 @@ void chr_score_tick(chr_score *score) {
         lastage = t->age++;
         if(t->position < 0.0f) {
             score->score += t->points;
-            omf_free(t->text);
-            list_delete(&score->texts, &it);
+            vector_delete(&score->texts, &it);
         }
     }
 }
@@ -172,7 +161,7 @@ void chr_score_render(chr_score *score, bool render_total_points) {
     int lastage = -1;
     vec2i pos;
 
-    list_iter_begin(&score->texts, &it);
+    vector_iter_begin(&score->texts, &it);
     foreach(it, t) {
         if(lastage > 0 && (lastage - t->age) < SLIDER_DISTANCE) {
             break;
@@ -186,12 +175,12 @@ void chr_score_render(chr_score *score, bool render_total_points) {
     }
 }
 
-void chr_score_add(chr_score *score, char *text, int points, vec2i pos, float position) {
+void chr_score_add(chr_score *score, const char *text, int points, vec2i pos, float position) {
     // Create texture
     // Add texture to list, set position to 1.0f, set points
     const font *fnt = fonts_get_font(FONT_SMALL);
     score_text s;
-    s.text = text;
+    strncpy_or_truncate(s.text, text, sizeof(s.text));
     s.points = points;
     s.start = pos;
     // center correctly initially, but end up justified
@@ -199,7 +188,7 @@ void chr_score_add(chr_score *score, char *text, int points, vec2i pos, float po
     s.position = position;
     s.age = 0;
 
-    list_append(&score->texts, &s, sizeof(score_text));
+    vector_append(&score->texts, &s);
 }
 
 void chr_score_hit(chr_score *score, int points) {
@@ -215,20 +204,17 @@ void chr_score_victory(chr_score *score, int health) {
     // Add texts for scrap bonus, perfect round, whatever
     score->wins++;
     score->health = health;
-    char *text;
+    char text[SCORE_TEXT_LEN];
     if(health == 100) {
-        text = omf_calloc(64, 1);
-        int len = snprintf(text, 64, "perfect round ");
+        int len = snprintf(text, sizeof(text), "perfect round ");
         int points = DESTRUCTION * chr_score_get_difficulty_multiplier(score);
-        score_format(points, text + len, 64 - len);
+        score_format(points, text + len, sizeof(text) - len);
         // XXX hardcode the y coordinate for now
         chr_score_add(score, text, points, vec2i_create(160, 100), 1.0f);
     }
-    text = omf_calloc(64, 1);
-
-    int len = snprintf(text, 64, "vitality ");
+    int len = snprintf(text, sizeof(text), "vitality ");
     int points = truncf((DESTRUCTION * chr_score_get_difficulty_multiplier(score)) * (health / 100.0f));
-    score_format(points, text + len, 64 - len);
+    score_format(points, text + len, sizeof(text) - len);
     // XXX hardcode the y coordinate for now
     chr_score_add(score, text, points, vec2i_create(160, 100), 1.0f);
 }
@@ -245,18 +231,18 @@ void chr_score_done(chr_score *score) {
     if(!score->done) {
         score->done = true;
         if(score->destruction) {
-            char *text = omf_calloc(64, 1);
-            int len = snprintf(text, 64, "destruction bonus ");
+            char text[SCORE_TEXT_LEN];
+            int len = snprintf(text, sizeof(text), "destruction bonus ");
             int points = DESTRUCTION * chr_score_get_difficulty_multiplier(score);
-            score_format(points, text + len, 64 - len);
+            score_format(points, text + len, sizeof(text) - len);
             // XXX hardcode the y coordinate for now
             chr_score_add(score, text, points, vec2i_create(160, 100), 1.0f);
             score->destruction = false;
         } else if(score->scrap) {
-            char *text = omf_calloc(64, 1);
-            int len = snprintf(text, 64, "scrap bonus ");
+            char text[SCORE_TEXT_LEN];
+            int len = snprintf(text, sizeof(text), "scrap bonus ");
             int points = SCRAP * chr_score_get_difficulty_multiplier(score);
-            score_format(points, text + len, 64 - len);
+            score_format(points, text + len, sizeof(text) - len);
             // XXX hardcode the y coordinate for now
             chr_score_add(score, text, points, vec2i_create(160, 100), 1.0f);
             score->scrap = false;
@@ -272,12 +258,12 @@ int chr_score_interrupt(chr_score *score, vec2i pos) {
     // Enemy interrupted somehow, show consecutive hits or whatevera
     int ret = 0;
     if(score->consecutive_hits > 3) {
-        char *text = omf_calloc(64, 1);
+        char text[SCORE_TEXT_LEN];
         ret = 1;
-        int len = snprintf(text, 64, "%d consecutive hits", score->consecutive_hits);
+        int len = snprintf(text, sizeof(text), "%d consecutive hits", score->consecutive_hits);
         if(score->consecutive_hit_score > 0) {
             text[len++] = ' ';
-            score_format(score->consecutive_hit_score, text + len, 64 - len);
+            score_format(score->consecutive_hit_score, text + len, sizeof(text) - len);
         }
         // XXX hardcode the y coordinate for now
         chr_score_add(score, text, score->consecutive_hit_score, vec2i_create(pos.x, 130), 1.0f);
@@ -291,12 +277,12 @@ int chr_score_end_combo(chr_score *score, vec2i pos) {
     // enemy recovered control, end any combos
     int ret = 0;
     if(score->combo_hits > 1) {
-        char *text = omf_calloc(64, 1);
+        char text[SCORE_TEXT_LEN];
         ret = 1;
-        int len = snprintf(text, 64, "%d hit combo", score->combo_hits);
+        int len = snprintf(text, sizeof(text), "%d hit combo", score->combo_hits);
         if(score->combo_hit_score > 0) {
             text[len++] = ' ';
-            score_format(score->combo_hit_score * 4, text + len, 64 - len);
+            score_format(score->combo_hit_score * 4, text + len, sizeof(text) - len);
         }
         // XXX hardcode the y coordinate for now
         chr_score_add(score, text, score->combo_hit_score * 4, vec2i_create(pos.x, 130), 1.0f);
@@ -306,17 +292,77 @@ int chr_score_end_combo(chr_score *score, vec2i pos) {
     return ret;
 }
 
+void chr_score_serialize(const chr_score *score, serial *ser) {
+    serial_write_int32(ser, score->score);
+    serial_write_int32(ser, score->rounds);
+    serial_write_int32(ser, score->wins);
+    serial_write_int32(ser, score->health);
+    serial_write_int32(ser, score->x);
+    serial_write_int32(ser, score->y);
+    serial_write_int32(ser, score->direction);
+    serial_write_int32(ser, score->difficulty);
+    serial_write_int32(ser, score->consecutive_hits);
+    serial_write_int32(ser, score->consecutive_hit_score);
+    serial_write_int32(ser, score->combo_hits);
+    serial_write_int32(ser, score->combo_hit_score);
+    serial_write_ptr(ser, score->multipliers);
+    serial_write_int8(ser, score->done);
+    serial_write_int8(ser, score->scrap);
+    serial_write_int8(ser, score->destruction);
+
+    uint32_t count = vector_size(&score->texts);
+    serial_write_uint32(ser, count);
+    for(uint32_t i = 0; i < count; i++) {
+        const score_text *t = vector_get(&score->texts, i);
+        uint32_t len = strlen(t->text);
+        serial_write_float(ser, t->position);
+        serial_write_int32(ser, t->start.x);
+        serial_write_int32(ser, t->start.y);
+        serial_write_int32(ser, t->points);
+        serial_write_int32(ser, t->age);
+        serial_write_uint32(ser, len);
+        serial_write(ser, t->text, len);
+    }
+}
+
+void chr_score_unserialize(chr_score *score, serial *ser) {
+    score->score = serial_read_int32(ser);
+    score->rounds = serial_read_int32(ser);
+    score->wins = serial_read_int32(ser);
+    score->health = serial_read_int32(ser);
+    score->x = serial_read_int32(ser);
+    score->y = serial_read_int32(ser);
+    score->direction = serial_read_int32(ser);
+    score->difficulty = serial_read_int32(ser);
+    score->consecutive_hits = serial_read_int32(ser);
+    score->consecutive_hit_score = serial_read_int32(ser);
+    score->combo_hits = serial_read_int32(ser);
+    score->combo_hit_score = serial_read_int32(ser);
+    serial_read_ptr(ser, score->multipliers);
+    score->done = serial_read_int8(ser);
+    score->scrap = serial_read_int8(ser);
+    score->destruction = serial_read_int8(ser);
+
+    uint32_t count = serial_read_uint32(ser);
+    vector_clear(&score->texts);
+    for(uint32_t i = 0; i < count; i++) {
+        score_text *t = vector_append_ptr(&score->texts);
+        t->position = serial_read_float(ser);
+        t->start.x = serial_read_int32(ser);
+        t->start.y = serial_read_int32(ser);
+        t->points = serial_read_int32(ser);
+        t->age = serial_read_int32(ser);
+        uint32_t len = serial_read_uint32(ser);
+        serial_read(ser, t->text, len);
+        t->text[len] = '\0';
+    }
+}
+
 int chr_score_clone(chr_score *src, chr_score *dst) {
-    iterator it;
-    score_text *t;
     memcpy(dst, src, sizeof(chr_score));
-    list_create(&dst->texts);
-    list_iter_begin(&src->texts, &it);
-    foreach(it, t) {
-        score_text t2;
-        memcpy(&t2, t, sizeof(score_text));
-        t2.text = omf_strdup(t->text);
-        list_append(&dst->texts, &t2, sizeof(score_text));
+    vector_create_with_size(&dst->texts, sizeof(score_text), SCORE_TEXTS_RESERVED);
+    for(unsigned int i = 0; i < vector_size(&src->texts); i++) {
+        vector_append(&dst->texts, vector_get(&src->texts, i));
     }
     return 0;
 }
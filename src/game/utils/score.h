@@ -3,7 +3,8 @@
 
 #include "game/gui/text_render.h"
 #include "game/protos/object.h"
-#include "utils/list.h"
+#include "game/utils/serial.h"
+#include "utils/vector.h"
 #include "video/surface.h"
 #include <stdbool.h>
 #include <stdlib.h>
@@ -25,7 +26,7 @@ typedef struct chr_score_t {
     int x, y;
     int direction;
     int difficulty;
-    list texts;
+    vector texts;
 
     int consecutive_hits;
     int consecutive_hit_score;
@@ -60,5 +61,7 @@ int chr_score_end_combo(chr_score *score, vec2i pos);
 int chr_score_interrupt(chr_score *score, vec2i pos);
 
 int chr_score_clone(chr_score *src, chr_score *dst);
+void chr_score_serialize(const chr_score *score, serial *ser);
+void chr_score_unserialize(chr_score *score, serial *ser);
 
 #endif // SCORE_H
@@ -98,6 +98,15 @@ void serial_free(serial *s) {
     s->wpos = 0;
 }
 
+/*
+ * Rewinds the serial for reuse. The buffer is kept, so writes that fit in the
+ * previous length do not allocate.
+ */
+void serial_reset(serial *s) {
+    s->rpos = 0;
+    s->wpos = 0;
+}
+
 size_t serial_len(serial *s) {
     return s->wpos;
 }
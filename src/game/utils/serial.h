@@ -22,6 +22,7 @@ void serial_write_float(serial *s, float v);
 size_t serial_len(serial *s);
 void serial_read(serial *s, char *buf, size_t len);
 void serial_free(serial *s);
+void serial_reset(serial *s);
 void serial_read_reset(serial *s);
 int8_t serial_read_int8(serial *s);
 int16_t serial_read_int16(serial *s);
@@ -33,4 +34,13 @@ float serial_read_float(serial *s);
 void serial_copy(serial *dst, const serial *src);
 serial *serial_calloc_copy(const serial *src);
 
+/*
+ * Writes or reads back a pointer as it is. The value only means something within the running process, so
+ * this is only for state snapshots, and only for pointers to code or to resources that outlive every
+ * snapshot, like callbacks and loaded animations. Anything owned by a game state has to be written out
+ * field by field instead.
+ */
+#define serial_write_ptr(s, ptr) serial_write((s), (const char *)&(ptr), sizeof(ptr))
+#define serial_read_ptr(s, ptr) serial_read((s), (char *)&(ptr), sizeof(ptr))
+
 #endif // SERIAL_H
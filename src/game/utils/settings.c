@@ -70,6 +70,7 @@ const field f_video[] = {
     F_INT(settings_video, scaling, 0),
     F_BOOL(settings_video, instant_console, 0),
     F_BOOL(settings_video, crossfade_on, 1),
+    F_INT(settings_video, asset_cache_mb, 32),
 };
 
 const field f_sound[] = {
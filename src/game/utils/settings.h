@@ -48,6 +48,7 @@ typedef struct {
     int scaling;
     int instant_console;
     int crossfade_on;
+    int asset_cache_mb;
 } settings_video;
 
 typedef struct {
@@ -0,0 +1,208 @@
+#include "game/utils/state_hash.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
+#include "utils/log.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <string.h>
+
+#define STATE_HASH_SEED 0xcbf29ce484222325ULL
+#define STATE_HASH_MULTIPLIER 0xff51afd7ed558ccdULL
+
+typedef struct state_trace_entry {
+    uint64_t hash;
+    uint32_t seen;
+} state_trace_entry;
+
+static inline uint64_t mix(uint64_t h, uint64_t value) {
+    h = (h ^ value) * STATE_HASH_MULTIPLIER;
+    return h ^ (h >> 32);
+}
+
+// Final avalanche from MurmurHash3, so that single bit changes spread over the whole hash.
+static inline uint64_t avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static void end_section(state_hash *h) {
+    if(!h->section_open) {
+        return;
+    }
+    uint64_t section_hash = avalanche(h->section_hash);
+    if(h->section_synced) {
+        h->hash = mix(h->hash, section_hash);
+    }
+    if(h->cb != NULL) {
+        h->cb(h->userdata, h->section, section_hash, h->section_synced, str_c(&h->fields));
+        str_set_c(&h->fields, "");
+    }
+    h->section_open = false;
+}
+
+void state_hash_init(state_hash *h, state_hash_section_cb cb, void *userdata) {
+    h->hash = STATE_HASH_SEED;
+    h->section_hash = 0;
+    h->section[0] = 0;
+    h->section_synced = false;
+    h->section_open = false;
+    h->cb = cb;
+    h->userdata = userdata;
+    str_create(&h->fields);
+}
+
+void state_hash_begin(state_hash *h, const char *name, unsigned int index, bool synced) {
+    end_section(h);
+    snprintf(h->section, sizeof(h->section), "%s.%u", name, index);
+    h->section_hash = STATE_HASH_SEED;
+    for(const char *c = h->section; *c != 0; c++) {
+        h->section_hash = mix(h->section_hash, (uint8_t)*c);
+    }
+    h->section_synced = synced;
+    h->section_open = true;
+}
+
+static void append_field(state_hash *h, const char *name, const char *format, ...) {
+    char buf[96];
+    va_list args;
+    int len = snprintf(buf, sizeof(buf), "%s%s=", str_size(&h->fields) > 0 ? " " : "", name);
+    va_start(args, format);
+    vsnprintf(buf + len, sizeof(buf) - len, format, args);
+    va_end(args);
+    str_append_c(&h->fields, buf);
+}
+
+void state_hash_int(state_hash *h, const char *name, int64_t value) {
+    h->section_hash = mix(h->section_hash, (uint64_t)value);
+    if(h->cb != NULL) {
+        append_field(h, name, "%" PRId64, value);
+    }
+}
+
+void state_hash_float(state_hash *h, const char *name, float value) {
+    uint32_t bits;
+    if(value == 0.0f) {
+        value = 0.0f;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    h->section_hash = mix(h->section_hash, bits);
+    if(h->cb != NULL) {
+        append_field(h, name, "%.9g", value);
+    }
+}
+
+// Fixed-point values are hashed as they are, but written out as floats to keep traces readable.
+void state_hash_phys(state_hash *h, const char *name, phys value) {
+#ifdef FIXED_PHYSICS
+    h->section_hash = mix(h->section_hash, (uint32_t)value);
+    if(h->cb != NULL) {
+        append_field(h, name, "%.9g", phys_to_float(value));
+    }
+#else
+    state_hash_float(h, name, value);
+#endif
+}
+
+void state_hash_buf(state_hash *h, const char *name, const void *buf, size_t len) {
+    const uint8_t *data = buf;
+    char hex[65];
+    size_t shown = len < sizeof(hex) / 2 ? len : sizeof(hex) / 2;
+    for(size_t i = 0; i < len; i++) {
+        h->section_hash = mix(h->section_hash, data[i]);
+    }
+    if(h->cb != NULL) {
+        for(size_t i = 0; i < shown; i++) {
+            snprintf(hex + i * 2, 3, "%02x", data[i]);
+        }
+        hex[shown * 2] = 0;
+        append_field(h, name, "%s", hex);
+    }
+}
+
+uint64_t state_hash_finish(state_hash *h) {
+    end_section(h);
+    str_free(&h->fields);
+    return avalanche(h->hash);
+}
+
+bool state_trace_open(state_trace *trace, const char *filename) {
+    trace->fp = fopen(filename, "w");
+    if(trace->fp == NULL) {
+        log_error("Unable to open state trace file %s.", filename);
+        return false;
+    }
+    hashmap_create(&trace->sections);
+    trace->tick = 0;
+    fprintf(trace->fp, "# openomf state trace 1\n");
+    return true;
+}
+
+void state_trace_close(state_trace *trace) {
+    if(trace->fp == NULL) {
+        return;
+    }
+    fclose(trace->fp);
+    trace->fp = NULL;
+    hashmap_free(&trace->sections);
+}
+
+typedef struct trace_tick {
+    state_trace *trace;
+    str lines;
+} trace_tick;
+
+static void trace_section(void *userdata, const char *name, uint64_t hash, bool synced, const char *fields) {
+    trace_tick *tick = userdata;
+    state_trace_entry *entry;
+    if(hashmap_get_str(&tick->trace->sections, name, (void **)&entry, NULL) == 0) {
+        entry->seen = tick->trace->tick;
+        if(entry->hash == hash) {
+            return;
+        }
+        entry->hash = hash;
+    } else {
+        state_trace_entry fresh = {hash, tick->trace->tick};
+        hashmap_put_str(&tick->trace->sections, name, &fresh, sizeof(fresh));
+    }
+
+    char head[96];
+    snprintf(head, sizeof(head), "S %s %016" PRIx64 " %d ", name, hash, synced ? 1 : 0);
+    str_append_c(&tick->lines, head);
+    str_append_c(&tick->lines, fields);
+    str_append_c(&tick->lines, "\n");
+}
+
+void state_trace_tick(state_trace *trace, game_state *gs) {
+    if(trace->fp == NULL || gs->sc == NULL || !scene_is_arena(gs->sc)) {
+        return;
+    }
+    trace_tick tick;
+    tick.trace = trace;
+    str_create(&tick.lines);
+    trace->tick++;
+
+    state_hash h;
+    state_hash_init(&h, trace_section, &tick);
+    game_state_hash(gs, &h);
+    uint64_t hash = state_hash_finish(&h);
+
+    fprintf(trace->fp, "T %" PRIu32 " %016" PRIx64 "\n", gs->int_tick, hash);
+    fputs(str_c(&tick.lines), trace->fp);
+    str_free(&tick.lines);
+
+    // Anything not seen on this tick is gone
+    iterator it;
+    hashmap_pair *pair;
+    hashmap_iter_begin(&trace->sections, &it);
+    foreach(it, pair) {
+        state_trace_entry *entry = pair->value;
+        if(entry->seen != trace->tick) {
+            fprintf(trace->fp, "D %s\n", (const char *)pair->key);
+            hashmap_delete(&trace->sections, &it);
+        }
+    }
+}
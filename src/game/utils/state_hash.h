@@ -0,0 +1,81 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include "game/game_state_type.h"
+#include "game/utils/phys.h"
+#include "utils/hashmap.h"
+#include "utils/str.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Called for every finished section. fields is a space separated list of name=value pairs, and only
+ * set if the hash was created with a callback.
+ */
+typedef void (*state_hash_section_cb)(void *userdata, const char *name, uint64_t hash, bool synced,
+                                      const char *fields);
+
+/**
+ * 64-bit hash of game state, for finding desyncs.
+ *
+ * State is fed in as sections (an object, a player, ...) made of named fields. Every field is hashed from
+ * its value rather than its memory, so struct layout, padding and pointers do not matter. Floats are hashed
+ * from their bits, with -0.0 folded into 0.0.
+ *
+ * Only synced sections go into the final hash. Sections that are not synced hold state that is allowed to
+ * differ between peers, like scrap that is thrown around with the unsynchronised global RNG. They are still
+ * passed to the section callback, so that traces can show them.
+ */
+typedef struct state_hash {
+    uint64_t hash;
+    uint64_t section_hash;
+    char section[32];
+    bool section_synced;
+    bool section_open;
+    str fields;
+    state_hash_section_cb cb;
+    void *userdata;
+} state_hash;
+
+void state_hash_init(state_hash *h, state_hash_section_cb cb, void *userdata);
+
+/**
+ * Starts a new section, and finishes the previous one. Sections are named name.index.
+ */
+void state_hash_begin(state_hash *h, const char *name, unsigned int index, bool synced);
+
+void state_hash_int(state_hash *h, const char *name, int64_t value);
+void state_hash_float(state_hash *h, const char *name, float value);
+void state_hash_phys(state_hash *h, const char *name, phys value);
+void state_hash_buf(state_hash *h, const char *name, const void *buf, size_t len);
+
+/**
+ * Finishes the last section and frees the hash. Returns the hash of all synced sections.
+ */
+uint64_t state_hash_finish(state_hash *h);
+
+/**
+ * Writes a state hash of every dynamic tick to a file. Sections are only written when they change, so
+ * the trace of a long match stays small. See tools/statebisect for comparing two traces.
+ *
+ * The format is line based:
+ * - "T <tick> <hash>" starts a tick, with the hash of all synced sections,
+ * - "S <section> <hash> <synced> <fields>" is a section that is new or changed since the previous tick,
+ * - "D <section>" is a section that went away.
+ */
+typedef struct state_trace {
+    FILE *fp;
+    hashmap sections; // section name -> state_trace_entry
+    uint32_t tick;
+} state_trace;
+
+bool state_trace_open(state_trace *trace, const char *filename);
+void state_trace_close(state_trace *trace);
+
+/**
+ * Writes the state of the current tick, if an arena is running.
+ */
+void state_trace_tick(state_trace *trace, game_state *gs);
+
+#endif // STATE_HASH_H
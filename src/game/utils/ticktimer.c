@@ -8,8 +8,11 @@ typedef struct {
     void *userdata;
 } ticktimer_unit;
 
+// More than any scene runs at once, so that restoring a snapshot does not need to grow the list
+#define TICKTIMER_UNITS_RESERVED 32
+
 void ticktimer_init(ticktimer *tt) {
-    vector_create(&tt->units, sizeof(ticktimer_unit));
+    vector_create_with_size(&tt->units, sizeof(ticktimer_unit), TICKTIMER_UNITS_RESERVED);
 }
 
 void ticktimer_close(ticktimer *tt) {
@@ -47,3 +50,26 @@ void ticktimer_clone(ticktimer *src, ticktimer *dst) {
         vector_append(&dst->units, unit);
     }
 }
+
+// Timer userdata is not part of snapshots; every timer that runs during a match is added without any.
+void ticktimer_serialize(const ticktimer *tt, serial *ser) {
+    uint32_t count = vector_size(&tt->units);
+    serial_write_uint32(ser, count);
+    for(uint32_t i = 0; i < count; i++) {
+        const ticktimer_unit *unit = vector_get(&tt->units, i);
+        serial_write_ptr(ser, unit->callback);
+        serial_write_int32(ser, unit->ticks);
+    }
+}
+
+void ticktimer_unserialize(ticktimer *tt, serial *ser) {
+    uint32_t count = serial_read_uint32(ser);
+    vector_clear(&tt->units);
+    for(uint32_t i = 0; i < count; i++) {
+        ticktimer_unit unit;
+        serial_read_ptr(ser, unit.callback);
+        unit.ticks = serial_read_int32(ser);
+        unit.userdata = NULL;
+        vector_append(&tt->units, &unit);
+    }
+}
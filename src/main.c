@@ -90,9 +90,18 @@ int main(int argc, char *argv[]) {
     struct arg_file *rec = arg_file0("R", "rec", "<file>", "Record a new recfile");
     struct arg_lit *warp = arg_lit0(NULL, "warp", "run the game at warp speed");
     struct arg_int *speed = arg_int0(NULL, "speed", "<speed>", "game speed to use: 1-10");
+    struct arg_lit *headless =
+        arg_lit0(NULL, "headless", "Replay the --play recfile without rendering, print JSON results. With --listen "
+                                   "or --connect, play it against a peer and print rollback statistics");
+    struct arg_str *replay_dir =
+        arg_str0(NULL, "replay-dir", "<dir>", "Replay all recfiles in <dir> headless, print JSON results");
+    struct arg_int *jobs = arg_int0(NULL, "jobs", "<n>", "Number of worker processes for --replay-dir");
+    struct arg_file *state_trace =
+        arg_file0(NULL, "state-trace", "<file>", "Write a hash of the game state on every tick to <file>");
     struct arg_end *end = arg_end(30);
-    void *argtable[] = {help, vers, listen, lobby, lobbyarg, connect, force_audio_backend, force_renderer, trace,
-                        port, play, rec,    warp,  speed,    end};
+    void *argtable[] = {help,  vers,        listen, lobby, lobbyarg, connect, force_audio_backend, force_renderer,
+                        trace, port,        play,   rec,   warp,     speed,   headless,            replay_dir,
+                        jobs,  state_trace, end};
     const char *progname = "openomf";
 
     // Make sure everything got allocated
@@ -152,6 +161,35 @@ int main(int argc, char *argv[]) {
         strncpy(init_flags.rec_file, rec->filename[0], 254);
     }
 
+    if(replay_dir->count > 0) {
+        init_flags.headless = 1;
+        init_flags.playback = 1;
+    } else if(headless->count > 0) {
+        if(play->count == 0) {
+            fprintf(stderr, "--headless requires a recfile to --play.\n");
+            goto exit_0;
+        }
+        if(init_flags.net_mode == NET_MODE_LOBBY) {
+            fprintf(stderr, "--headless can not be used with --lobby.\n");
+            goto exit_0;
+        }
+        init_flags.headless = 1;
+        if(init_flags.net_mode != NET_MODE_NONE) {
+            // Netplay skips the --play branch above
+            init_flags.playback = 1;
+            strncpy(init_flags.rec_file, play->filename[0], 254);
+        }
+    }
+
+    if(state_trace->count > 0) {
+        if(replay_dir->count > 0) {
+            fprintf(stderr, "--state-trace can not be used with --replay-dir.\n");
+            goto exit_0;
+        }
+        strncpy_or_truncate(init_flags.state_trace_file, state_trace->filename[0],
+                            sizeof(init_flags.state_trace_file));
+    }
+
     if(warp->count > 0) {
         init_flags.warpspeed = 1;
     } else {
@@ -190,7 +228,7 @@ int main(int argc, char *argv[]) {
 #endif
 #if defined(DEBUGMODE)
     log_add_stderr(LOG_DEBUG, true);
-    log_set_level(LOG_DEBUG);
+    log_set_level(init_flags.headless ? LOG_INFO : LOG_DEBUG); // Debug logging would dominate headless replays
 #else
     log_set_level(LOG_INFO); // In release mode, drop debugs.
 #endif
@@ -247,8 +285,13 @@ int main(int argc, char *argv[]) {
         settings_get()->net.net_listen_port_start = listen_port;
     }
 
-    // Init SDL2
-    if(SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO)) {
+    // Init SDL2. Headless replays need no window or input devices.
+    if(init_flags.headless) {
+        if(SDL_Init(SDL_INIT_TIMER)) {
+            err_msgbox("SDL2 Initialization failed: %s", SDL_GetError());
+            goto exit_2;
+        }
+    } else if(SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO)) {
         err_msgbox("SDL2 Initialization failed: %s", SDL_GetError());
         goto exit_2;
     }
@@ -257,14 +300,16 @@ int main(int argc, char *argv[]) {
     log_info("Found SDL v%d.%d.%d", sdl_linked.major, sdl_linked.minor, sdl_linked.patch);
     log_info("Running on platform: %s", SDL_GetPlatform());
 
-    if(SDL_InitSubSystem(SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC)) {
-        err_msgbox("SDL2 Initialization failed: %s", SDL_GetError());
-        goto exit_2;
-    }
+    if(!init_flags.headless) {
+        if(SDL_InitSubSystem(SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC)) {
+            err_msgbox("SDL2 Initialization failed: %s", SDL_GetError());
+            goto exit_2;
+        }
 
-    // Load game controller support
-    joystick_load_external_mappings();
-    scan_game_controllers();
+        // Load game controller support
+        joystick_load_external_mappings();
+        scan_game_controllers();
+    }
 
     // Init enet
     if(enet_initialize() != 0) {
@@ -279,7 +324,16 @@ int main(int argc, char *argv[]) {
     }
 
     // Run
-    engine_run(&init_flags);
+    if(replay_dir->count > 0) {
+        int workers = jobs->count > 0 ? jobs->ival[0] : SDL_GetCPUCount();
+        ret = engine_run_headless_dir(&init_flags, replay_dir->sval[0], workers) == 0 ? 0 : 1;
+    } else if(init_flags.headless && init_flags.net_mode != NET_MODE_NONE) {
+        ret = engine_run_headless_net(&init_flags, stdout) ? 0 : 1;
+    } else if(init_flags.headless) {
+        ret = engine_run_headless(&init_flags, stdout) ? 0 : 1;
+    } else {
+        engine_run(&init_flags);
+    }
 
     // Close everything
     engine_close();
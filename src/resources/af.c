@@ -3,6 +3,36 @@
 #include "resources/sprite.h"
 #include <string.h>
 
+static void af_build_move_index(af *a) {
+    move_trie_create(&a->move_index);
+    move_mask_clear(&a->all_moves);
+    for(int i = 0; i < AF_MOVE_CATEGORIES; i++) {
+        move_mask_clear(&a->category_moves[i]);
+    }
+    for(int i = 0; i < AF_POS_CONSTRAINTS; i++) {
+        move_mask_clear(&a->constraint_moves[i]);
+    }
+
+    iterator it;
+    af_move *move = NULL;
+    array_iter_begin(&a->moves, &it);
+    foreach(it, move) {
+        // "!" marks a move that can not be performed
+        if(!str_equal_c(&move->move_string, "!")) {
+            move_trie_add(&a->move_index, str_c(&move->move_string), move->id);
+        }
+        move_mask_set(&a->all_moves, move->id);
+        if(move->category < AF_MOVE_CATEGORIES) {
+            move_mask_set(&a->category_moves[move->category], move->id);
+        }
+        for(int i = 0; i < AF_POS_CONSTRAINTS; i++) {
+            if(move->pos_constraints & (1 << i)) {
+                move_mask_set(&a->constraint_moves[i], move->id);
+            }
+        }
+    }
+}
+
 void af_create(af *a, void *src) {
     sd_af_file *sdaf = (sd_af_file *)src;
 
@@ -35,6 +65,28 @@ void af_create(af *a, void *src) {
             array_set(&a->moves, i, move);
         }
     }
+    af_build_move_index(a);
+}
+
+void af_clone(af *src, af *dst) {
+    memcpy(dst, src, sizeof(af));
+    array_create(&dst->moves);
+    array_create(&dst->sprites);
+
+    iterator it;
+    af_move *move = NULL;
+    array_iter_begin(&src->moves, &it);
+    foreach(it, move) {
+        af_move *copy = omf_calloc(1, sizeof(af_move));
+        af_move_clone(move, copy);
+        array_set(&dst->moves, move->id, copy);
+    }
+    af_build_move_index(dst);
+}
+
+void af_rebuild_move_index(af *a) {
+    move_trie_free(&a->move_index);
+    af_build_move_index(a);
 }
 
 af_move *af_get_move(const af *a, int id) {
@@ -51,4 +103,5 @@ void af_free(af *a) {
     }
     array_free(&a->moves);
     array_free(&a->sprites);
+    move_trie_free(&a->move_index);
 }
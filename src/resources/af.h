@@ -2,9 +2,13 @@
 #define AF_H
 
 #include "resources/af_move.h"
+#include "resources/move_trie.h"
 #include "utils/allocator.h"
 #include "utils/array.h"
 
+#define AF_MOVE_CATEGORIES 16
+#define AF_POS_CONSTRAINTS 2
+
 typedef struct af_t {
     unsigned int id;
     float endurance;
@@ -16,9 +20,28 @@ typedef struct af_t {
     array sprites;
     array moves;
     char sound_translation_table[30];
+    int resource_id; // Set when the data is handed out by the resource cache
+
+    // Move lookup tables for input matching, built when the moves are loaded
+    move_trie move_index;
+    move_mask all_moves;
+    move_mask category_moves[AF_MOVE_CATEGORIES];
+    move_mask constraint_moves[AF_POS_CONSTRAINTS]; // Moves by position constraint bit
 } af;
 
 void af_create(af *a, void *src);
+
+/**
+ * Makes a modifiable copy of the AF data. Sprite surfaces are shared with src, so src must be kept alive for
+ * as long as dst is in use.
+ */
+void af_clone(af *src, af *dst);
+
+/**
+ * Rebuilds the move lookup tables. Must be called after move strings, categories or position constraints
+ * of the moves change.
+ */
+void af_rebuild_move_index(af *a);
 af_move *af_get_move(const af *a, int id);
 void af_free(af *a);
 
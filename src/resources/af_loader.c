@@ -7,12 +7,13 @@ int load_af_file(af *a, int id) {
     // Get directory + filename
     const char *filename = pm_get_resource_path(id);
 
-    // Load up AF file from libSD
+    // Load up AF file from libSD. The sprites are decoded to surfaces right away, so there is
+    // no need to copy their data out of the file.
     sd_af_file tmp;
     if(sd_af_create(&tmp) != SD_SUCCESS) {
         return 1;
     }
-    if(sd_af_load(&tmp, filename) != SD_SUCCESS) {
+    if(sd_af_load_mapped(&tmp, filename) != SD_SUCCESS) {
         sd_af_free(&tmp);
         return 1;
     }
@@ -1,5 +1,6 @@
 #include "resources/af_move.h"
 #include "formats/move.h"
+#include <string.h>
 
 void af_move_create(af_move *move, array *sprites, void *src, int id) {
     sd_move *sdmv = (sd_move *)src;
@@ -25,6 +26,13 @@ void af_move_create(af_move *move, array *sprites, void *src, int id) {
     }
 }
 
+void af_move_clone(af_move *src, af_move *dst) {
+    memcpy(dst, src, sizeof(af_move));
+    str_from(&dst->move_string, &src->move_string);
+    str_from(&dst->footer_string, &src->footer_string);
+    animation_clone_shared(&src->ani, &dst->ani);
+}
+
 void af_move_free(af_move *move) {
     animation_free(&move->ani);
     str_free(&move->move_string);
@@ -28,6 +28,7 @@ typedef struct af_move_t {
 } af_move;
 
 void af_move_create(af_move *move, array *sprites, void *src, int id);
+void af_move_clone(af_move *src, af_move *dst);
 void af_move_free(af_move *move);
 
 #endif // AF_MOVE_H
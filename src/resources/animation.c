@@ -1,12 +1,25 @@
 #include "resources/animation.h"
 #include "formats/animation.h"
+#include "formats/error.h"
 #include "utils/allocator.h"
+#include "utils/log.h"
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct sprite_reference_t {
     sprite *sprite;
 } sprite_reference;
 
+static void animation_compile(animation *ani) {
+    int err_pos;
+    sd_script_create(&ani->script);
+    int ret = sd_script_decode(&ani->script, str_c(&ani->animation_string), &err_pos);
+    if(ret != SD_SUCCESS) {
+        log_error("Decoder error %s at position %d in string \"%s\"", sd_get_error(ret), err_pos,
+                  str_c(&ani->animation_string));
+    }
+}
+
 void animation_create(animation *ani, array *sprites, void *src, int id) {
     sd_animation *sdani = (sd_animation *)src;
 
@@ -14,6 +27,7 @@ void animation_create(animation *ani, array *sprites, void *src, int id) {
     ani->id = id;
     ani->start_pos = vec2i_create(sdani->start_x, sdani->start_y);
     str_from_c(&ani->animation_string, sdani->anim_string);
+    animation_compile(ani);
 
     // Copy collision coordinates
     vector_create_with_size(&ani->collision_coords, sizeof(collision_coord), sdani->coord_count);
@@ -66,6 +80,7 @@ animation *create_animation_from_single(sprite *sp, vec2i pos) {
     a->start_pos = pos;
     a->id = -1;
     str_from_c(&a->animation_string, "A9999999999");
+    animation_compile(a);
     vector_create_with_size(&a->collision_coords, sizeof(collision_coord), 0);
     vector_create_with_size(&a->extra_strings, sizeof(str), 0);
     vector_create_with_size(&a->sprites, sizeof(sprite_reference), 1);
@@ -75,10 +90,11 @@ animation *create_animation_from_single(sprite *sp, vec2i pos) {
     return a;
 }
 
-int animation_clone(animation *src, animation *dst) {
+static int clone_animation(animation *src, animation *dst, bool share_sprites) {
     iterator it;
     memcpy(dst, src, sizeof(animation));
     str_from(&dst->animation_string, &src->animation_string);
+    sd_script_clone(&src->script, &dst->script);
     vector_create_with_size(&dst->collision_coords, sizeof(collision_coord), vector_size(&src->collision_coords));
     vector_iter_begin(&src->collision_coords, &it);
     collision_coord *tmp_coord = NULL;
@@ -99,13 +115,27 @@ int animation_clone(animation *src, animation *dst) {
     sprite_reference *spr = NULL;
     foreach(it, spr) {
         sprite_reference spr_clone;
-        spr_clone.sprite = sprite_copy(spr->sprite);
+        if(share_sprites) {
+            spr_clone.sprite = omf_calloc(1, sizeof(sprite));
+            memcpy(spr_clone.sprite, spr->sprite, sizeof(sprite));
+            spr_clone.sprite->owned = false;
+        } else {
+            spr_clone.sprite = sprite_copy(spr->sprite);
+        }
         vector_append(&dst->sprites, &spr_clone);
     }
 
     return 0;
 }
 
+int animation_clone(animation *src, animation *dst) {
+    return clone_animation(src, dst, false);
+}
+
+int animation_clone_shared(animation *src, animation *dst) {
+    return clone_animation(src, dst, true);
+}
+
 void animation_fixup_coordinates(animation *ani, int fix_x, int fix_y) {
     iterator it;
     sprite_reference *spr;
@@ -136,11 +166,18 @@ int animation_get_sprite_count(animation *ani) {
     return vector_size(&ani->sprites);
 }
 
+void animation_set_string(animation *ani, const str *string) {
+    str_set(&ani->animation_string, string);
+    sd_script_free(&ani->script);
+    animation_compile(ani);
+}
+
 void animation_free(animation *ani) {
     iterator it;
 
     // Free animation string
     str_free(&ani->animation_string);
+    sd_script_free(&ani->script);
 
     // Free collision coordinates
     vector_free(&ani->collision_coords);
@@ -1,6 +1,7 @@
 #ifndef ANIMATION_H
 #define ANIMATION_H
 
+#include "formats/script.h"
 #include "resources/sprite.h"
 #include "utils/array.h"
 #include "utils/str.h"
@@ -41,6 +42,7 @@ typedef struct animation_t {
     vec2i start_pos;
     vector collision_coords;
     str animation_string;
+    sd_script script; // animation_string compiled, shared by the objects playing this animation
     uint8_t extra_string_count;
     vector extra_strings;
     vector sprites;
@@ -51,10 +53,17 @@ sprite *animation_get_sprite(animation *ani, int sprite_id);
 void animation_free(animation *ani);
 
 int animation_get_sprite_count(animation *ani);
+void animation_set_string(animation *ani, const str *string);
 
 animation *create_animation_from_single(sprite *sp, vec2i pos);
 void animation_fixup_coordinates(animation *ani, int fix_x, int fix_y);
 
 int animation_clone(animation *src, animation *dst);
 
+/**
+ * Clones the animation like animation_clone(), but the sprites of dst reference the surfaces of src instead
+ * of copying them. src must be kept alive for as long as dst is in use.
+ */
+int animation_clone_shared(animation *src, animation *dst);
+
 #endif // ANIMATION_H
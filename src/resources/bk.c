@@ -37,6 +37,31 @@ void bk_create(bk *b, void *src) {
     }
 }
 
+void bk_clone(bk *src, bk *dst) {
+    memcpy(dst, src, sizeof(bk));
+    surface_create_from(&dst->background, &src->background);
+
+    vector_create_with_size(&dst->palettes, sizeof(vga_palette), vector_size(&src->palettes));
+    vector_create_with_size(&dst->remaps, sizeof(vga_remap_tables), vector_size(&src->remaps));
+    for(unsigned int i = 0; i < vector_size(&src->palettes); i++) {
+        vector_append(&dst->palettes, vector_get(&src->palettes, i));
+        vector_append(&dst->remaps, vector_get(&src->remaps, i));
+    }
+
+    array_create(&dst->sprites);
+
+    // Insert in the same order as bk_create(), so that the infos iterate in the same order.
+    hashmap_create(&dst->infos);
+    bk_info tmp_bk_info;
+    for(int i = 0; i < 50; i++) {
+        bk_info *info = bk_get_info(src, i);
+        if(info != NULL) {
+            bk_info_clone(info, &tmp_bk_info);
+            hashmap_put_int(&dst->infos, i, &tmp_bk_info, sizeof(bk_info));
+        }
+    }
+}
+
 bk_info *bk_get_info(bk *b, int id) {
     bk_info *val;
     unsigned int tmp;
@@ -14,9 +14,16 @@ typedef struct bk_t {
     vector remaps;
     array sprites;
     char sound_translation_table[30];
+    int resource_id; // Set when the data is handed out by the resource cache
 } bk;
 
 void bk_create(bk *b, void *src);
+
+/**
+ * Makes a modifiable copy of the BK data. The background is copied, but animation sprite surfaces are shared
+ * with src, so src must be kept alive for as long as dst is in use.
+ */
+void bk_clone(bk *src, bk *dst);
 bk_info *bk_get_info(bk *b, int id);
 vga_palette *bk_get_palette(bk *b, int id);
 vga_remap_tables *bk_get_remaps(bk *b, int id);
@@ -1,5 +1,6 @@
 #include "resources/bk_info.h"
 #include "formats/bkanim.h"
+#include <string.h>
 
 void bk_info_create(bk_info *info, array *sprites, void *src, int id) {
     sd_bk_anim *sdinfo = (sd_bk_anim *)src;
@@ -12,6 +13,12 @@ void bk_info_create(bk_info *info, array *sprites, void *src, int id) {
     str_from_c(&info->footer_string, sdinfo->footer_string);
 }
 
+void bk_info_clone(bk_info *src, bk_info *dst) {
+    memcpy(dst, src, sizeof(bk_info));
+    str_from(&dst->footer_string, &src->footer_string);
+    animation_clone_shared(&src->ani, &dst->ani);
+}
+
 void bk_info_free(bk_info *info) {
     animation_free(&info->ani);
     str_free(&info->footer_string);
@@ -14,6 +14,7 @@ typedef struct bk_info_t {
 } bk_info;
 
 void bk_info_create(bk_info *info, array *sprites, void *src, int id);
+void bk_info_clone(bk_info *src, bk_info *dst);
 void bk_info_free(bk_info *info);
 
 #endif // BK_INFO_H
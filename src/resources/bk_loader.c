@@ -7,12 +7,13 @@ int load_bk_file(bk *b, int id) {
     // Get directory + filename
     const char *filename = pm_get_resource_path(id);
 
-    // Load up BK file from libSD
+    // Load up BK file from libSD. The sprites are decoded to surfaces right away, so there is
+    // no need to copy their data out of the file.
     sd_bk_file tmp;
     if(sd_bk_create(&tmp) != SD_SUCCESS) {
         return 1;
     }
-    if(sd_bk_load(&tmp, filename) != SD_SUCCESS) {
+    if(sd_bk_load_mapped(&tmp, filename) != SD_SUCCESS) {
         sd_bk_free(&tmp);
         return 1;
     }
@@ -0,0 +1,160 @@
+#include "resources/file_index.h"
+#include "formats/internal/reader.h"
+#include "formats/internal/writer.h"
+#include "utils/allocator.h"
+#include "utils/c_string_util.h"
+#include "utils/log.h"
+#include <string.h>
+
+#define FILE_INDEX_MAGIC 0x5844494F // "OIDX"
+
+// Stored in the hashmap, followed by the record.
+typedef struct index_entry {
+    int64_t mtime;
+    int64_t size;
+    bool used;
+} index_entry;
+
+static inline char *entry_record(index_entry *entry) {
+    return (char *)entry + sizeof(index_entry);
+}
+
+static int64_t read_int64(sd_reader *r) {
+    uint64_t lo = sd_read_udword(r);
+    uint64_t hi = sd_read_udword(r);
+    return (int64_t)(lo | (hi << 32));
+}
+
+static void write_int64(sd_writer *w, int64_t value) {
+    sd_write_udword(w, (uint64_t)value & 0xFFFFFFFF);
+    sd_write_udword(w, (uint64_t)value >> 32);
+}
+
+static void put_entry(file_index *index, const char *name, int64_t mtime, int64_t size, const void *record,
+                      bool used) {
+    unsigned int entry_size = sizeof(index_entry) + index->record_size;
+    index_entry *entry = omf_calloc(1, entry_size);
+    entry->mtime = mtime;
+    entry->size = size;
+    entry->used = used;
+    memcpy(entry_record(entry), record, index->record_size);
+    hashmap_put_str(&index->entries, name, entry, entry_size);
+    omf_free(entry);
+}
+
+static void load_entries(file_index *index) {
+    sd_reader *r = sd_reader_open(index->filename);
+    if(r == NULL) {
+        return;
+    }
+    if(sd_read_udword(r) != FILE_INDEX_MAGIC || sd_read_udword(r) != index->version ||
+       sd_read_udword(r) != index->record_size) {
+        log_info("File index %s is outdated, rebuilding it.", index->filename);
+        goto exit_0;
+    }
+
+    char name[256];
+    char *record = omf_calloc(1, index->record_size);
+    uint32_t count = sd_read_udword(r);
+    for(uint32_t i = 0; i < count; i++) {
+        uint8_t name_len = sd_read_ubyte(r);
+        if(!sd_read_buf(r, name, name_len)) {
+            break;
+        }
+        name[name_len] = 0;
+        int64_t mtime = read_int64(r);
+        int64_t size = read_int64(r);
+        if(!sd_read_buf(r, record, index->record_size)) {
+            break;
+        }
+        put_entry(index, name, mtime, size, record, false);
+    }
+    omf_free(record);
+
+exit_0:
+    sd_reader_close(r);
+}
+
+void file_index_open(file_index *index, const char *filename, uint32_t version, uint32_t record_size) {
+    hashmap_create(&index->entries);
+    index->filename = omf_strdup(filename);
+    index->version = version;
+    index->record_size = record_size;
+    index->dirty = false;
+    load_entries(index);
+}
+
+bool file_index_get(file_index *index, const char *name, int64_t mtime, int64_t size, void *record) {
+    index_entry *entry;
+    if(hashmap_get_str(&index->entries, name, (void **)&entry, NULL) != 0) {
+        return false;
+    }
+    if(entry->mtime != mtime || entry->size != size) {
+        return false;
+    }
+    entry->used = true;
+    memcpy(record, entry_record(entry), index->record_size);
+    return true;
+}
+
+void file_index_put(file_index *index, const char *name, int64_t mtime, int64_t size, const void *record) {
+    if(strlen(name) > 255) {
+        return;
+    }
+    put_entry(index, name, mtime, size, record, true);
+    index->dirty = true;
+}
+
+static void save_entries(file_index *index) {
+    iterator it;
+    hashmap_pair *pair;
+    uint32_t count = 0;
+
+    hashmap_iter_begin(&index->entries, &it);
+    foreach(it, pair) {
+        if(((index_entry *)pair->value)->used) {
+            count++;
+        } else {
+            index->dirty = true;
+        }
+    }
+    if(!index->dirty) {
+        return;
+    }
+
+    sd_writer *w = sd_writer_open(index->filename);
+    if(w == NULL) {
+        log_warn("Unable to write file index %s.", index->filename);
+        return;
+    }
+    sd_write_udword(w, FILE_INDEX_MAGIC);
+    sd_write_udword(w, index->version);
+    sd_write_udword(w, index->record_size);
+    sd_write_udword(w, count);
+    hashmap_iter_begin(&index->entries, &it);
+    foreach(it, pair) {
+        index_entry *entry = pair->value;
+        if(!entry->used) {
+            continue;
+        }
+        uint8_t name_len = pair->key_len - 1;
+        sd_write_ubyte(w, name_len);
+        sd_write_buf(w, pair->key, name_len);
+        write_int64(w, entry->mtime);
+        write_int64(w, entry->size);
+        sd_write_buf(w, entry_record(entry), index->record_size);
+    }
+    if(sd_writer_errno(w)) {
+        log_warn("Unable to write file index %s.", index->filename);
+        sd_writer_close(w);
+        remove(index->filename);
+        return;
+    }
+    sd_writer_close(w);
+}
+
+void file_index_close(file_index *index) {
+    save_entries(index);
+    hashmap_free(&index->entries);
+    omf_free(index->filename);
+}
@@ -0,0 +1,42 @@
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include "utils/hashmap.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * On-disk cache of fixed size records parsed from files, keyed by file name. A record is only
+ * valid while the modification time and size of its file stay the same.
+ *
+ * Entries that are not looked up or stored between open and close are dropped when the index is
+ * saved, so that deleted files do not linger in the index.
+ */
+typedef struct file_index {
+    hashmap entries;
+    char *filename;
+    uint32_t version;
+    uint32_t record_size;
+    bool dirty;
+} file_index;
+
+/**
+ * Loads the index from the given file. A missing or outdated index file results in an empty index.
+ * Bump the version when the layout of the record changes.
+ */
+void file_index_open(file_index *index, const char *filename, uint32_t version, uint32_t record_size);
+
+/**
+ * Copies the cached record of a file to record. Returns false if there is no valid record, and the
+ * file needs to be parsed.
+ */
+bool file_index_get(file_index *index, const char *name, int64_t mtime, int64_t size, void *record);
+
+void file_index_put(file_index *index, const char *name, int64_t mtime, int64_t size, const void *record);
+
+/**
+ * Writes the index back to disk if it changed, and frees it.
+ */
+void file_index_close(file_index *index);
+
+#endif // FILE_INDEX_H
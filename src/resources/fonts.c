@@ -14,6 +14,7 @@ static font font_large;
 static font font_net1;
 static font font_net2;
 static int fonts_loaded = 0;
+static unsigned int fonts_gen = 0;
 static unsigned char FIRST_PRINTABLE_CHAR = (unsigned char)' ';
 
 static void free_glyph(void *d) {
@@ -124,6 +125,7 @@ static int pcx_font_load(font *font, const char *filename, int8_t palette_offset
 }
 
 bool fonts_init(void) {
+    fonts_gen++;
     font_create(&font_small);
     font_create(&font_large);
     font_create(&font_net1);
@@ -200,4 +202,9 @@ void fonts_close(void) {
         font_free(&font_net2);
         fonts_loaded = 0;
     }
+    fonts_gen++;
+}
+
+unsigned int fonts_generation(void) {
+    return fonts_gen;
 }
@@ -27,4 +27,10 @@ bool fonts_init(void);
 void fonts_close(void);
 const font *fonts_get_font(font_size font);
 
+/**
+ * Changes every time the fonts are loaded or closed. Anything that holds on to glyph surfaces can compare this
+ * to find out that they are gone.
+ */
+unsigned int fonts_generation(void);
+
 #endif // FONTS_H
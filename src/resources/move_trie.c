@@ -0,0 +1,78 @@
+#include "resources/move_trie.h"
+
+#define NO_NODE 0xFFFF
+
+typedef struct move_trie_node {
+    char c;
+    uint16_t child;
+    uint16_t sibling;
+    move_mask ends; // Moves whose string ends at this node
+} move_trie_node;
+
+static uint16_t new_node(move_trie *trie, char c) {
+    move_trie_node *node = vector_append_ptr(&trie->nodes);
+    node->c = c;
+    node->child = NO_NODE;
+    node->sibling = NO_NODE;
+    move_mask_clear(&node->ends);
+    return vector_size(&trie->nodes) - 1;
+}
+
+static uint16_t find_child(const move_trie *trie, uint16_t parent, char c) {
+    const move_trie_node *node = vector_get(&trie->nodes, parent);
+    uint16_t i = node->child;
+    while(i != NO_NODE) {
+        node = vector_get(&trie->nodes, i);
+        if(node->c == c) {
+            return i;
+        }
+        i = node->sibling;
+    }
+    return NO_NODE;
+}
+
+void move_trie_create(move_trie *trie) {
+    vector_create(&trie->nodes, sizeof(move_trie_node));
+    new_node(trie, 0); // Root
+}
+
+void move_trie_free(move_trie *trie) {
+    vector_free(&trie->nodes);
+}
+
+void move_trie_add(move_trie *trie, const char *move_string, int move_id) {
+    if(move_string[0] == 0) {
+        // An empty string can never be matched
+        return;
+    }
+    uint16_t current = 0;
+    for(const char *c = move_string; *c != 0; c++) {
+        uint16_t next = find_child(trie, current, *c);
+        if(next == NO_NODE) {
+            next = new_node(trie, *c);
+            // The vector may have moved, so look the parent up again after adding.
+            move_trie_node *parent = vector_get(&trie->nodes, current);
+            move_trie_node *node = vector_get(&trie->nodes, next);
+            node->sibling = parent->child;
+            parent->child = next;
+        }
+        current = next;
+    }
+    move_trie_node *node = vector_get(&trie->nodes, current);
+    move_mask_set(&node->ends, move_id);
+}
+
+move_mask move_trie_match(const move_trie *trie, char prefix, const char *inputs) {
+    move_mask result;
+    move_mask_clear(&result);
+    uint16_t current = find_child(trie, 0, prefix);
+    while(current != NO_NODE) {
+        const move_trie_node *node = vector_get(&trie->nodes, current);
+        move_mask_or(&result, &node->ends);
+        if(*inputs == 0) {
+            break;
+        }
+        current = find_child(trie, current, *inputs++);
+    }
+    return result;
+}
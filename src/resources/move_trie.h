@@ -0,0 +1,86 @@
+#ifndef MOVE_TRIE_H
+#define MOVE_TRIE_H
+
+#include "utils/vector.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MOVE_MASK_BITS 128
+
+/**
+ * Set of move ids. Move ids are below 70, so two words are enough.
+ */
+typedef struct move_mask {
+    uint64_t bits[MOVE_MASK_BITS / 64];
+} move_mask;
+
+/**
+ * Trie over move strings. The first level is keyed by the move prefix character (K or P), and the levels
+ * below it by the rest of the move string, so that walking the input buffer finds every move whose string
+ * matches the start of the buffer in one pass.
+ */
+typedef struct move_trie {
+    vector nodes;
+} move_trie;
+
+void move_trie_create(move_trie *trie);
+void move_trie_free(move_trie *trie);
+
+/**
+ * Adds a move string. The first character is the prefix, the rest must match the start of the input buffer.
+ */
+void move_trie_add(move_trie *trie, const char *move_string, int move_id);
+
+/**
+ * Returns the moves that have the given prefix, and whose remaining string is a prefix of the input buffer.
+ */
+move_mask move_trie_match(const move_trie *trie, char prefix, const char *inputs);
+
+static inline void move_mask_clear(move_mask *mask) {
+    for(int i = 0; i < MOVE_MASK_BITS / 64; i++) {
+        mask->bits[i] = 0;
+    }
+}
+
+static inline void move_mask_set(move_mask *mask, int id) {
+    mask->bits[id / 64] |= (uint64_t)1 << (id % 64);
+}
+
+static inline bool move_mask_isset(const move_mask *mask, int id) {
+    return (mask->bits[id / 64] >> (id % 64)) & 1;
+}
+
+static inline void move_mask_or(move_mask *dst, const move_mask *src) {
+    for(int i = 0; i < MOVE_MASK_BITS / 64; i++) {
+        dst->bits[i] |= src->bits[i];
+    }
+}
+
+static inline void move_mask_and(move_mask *dst, const move_mask *src) {
+    for(int i = 0; i < MOVE_MASK_BITS / 64; i++) {
+        dst->bits[i] &= src->bits[i];
+    }
+}
+
+static inline void move_mask_andnot(move_mask *dst, const move_mask *src) {
+    for(int i = 0; i < MOVE_MASK_BITS / 64; i++) {
+        dst->bits[i] &= ~src->bits[i];
+    }
+}
+
+/**
+ * Returns the lowest move id in the mask that is at least start, or -1 if there is none.
+ */
+static inline int move_mask_next(const move_mask *mask, int start) {
+    for(int id = start; id < MOVE_MASK_BITS; id++) {
+        uint64_t word = mask->bits[id / 64] >> (id % 64);
+        if(word == 0) {
+            id |= 63; // Nothing left in this word, skip to the next one
+        } else if(word & 1) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+#endif // MOVE_TRIE_H
@@ -0,0 +1,302 @@
+#include "resources/resource_cache.h"
+#include "resources/af_loader.h"
+#include "resources/bk_loader.h"
+#include "resources/ids.h"
+#include "utils/allocator.h"
+#include "utils/jobs.h"
+#include "utils/log.h"
+#include <string.h>
+
+// A file being loaded on a worker thread. Only the job touches it until the job is done.
+typedef struct prefetch {
+    job *job;
+    int resource_id;
+    bk *bk_data;
+    af *af_data;
+    int ret;
+} prefetch;
+
+typedef struct cache_entry {
+    bk *bk_data;
+    af *af_data;
+    prefetch *pending;
+    unsigned int refs;
+    unsigned int last_used;
+    size_t size;
+} cache_entry;
+
+typedef struct resource_cache {
+    bool enabled;
+    size_t budget;
+    unsigned int clock;
+    unsigned int pending_count;
+    cache_entry entries[NUMBER_OF_RESOURCES];
+    resource_cache_stats stats;
+} resource_cache;
+
+static resource_cache cache;
+
+static size_t animation_size(animation *ani) {
+    size_t size = 0;
+    for(int i = 0; i < animation_get_sprite_count(ani); i++) {
+        sprite *sp = animation_get_sprite(ani, i);
+        if(sp->owned && sp->data != NULL) {
+            size += sp->data->w * sp->data->h;
+        }
+    }
+    return size;
+}
+
+static size_t bk_size(bk *b) {
+    size_t size = b->background.w * b->background.h;
+    iterator it;
+    hashmap_pair *pair = NULL;
+    hashmap_iter_begin(&b->infos, &it);
+    foreach(it, pair) {
+        size += animation_size(&((bk_info *)pair->value)->ani);
+    }
+    return size;
+}
+
+static size_t af_size(af *a) {
+    size_t size = 0;
+    iterator it;
+    af_move *move = NULL;
+    array_iter_begin(&a->moves, &it);
+    foreach(it, move) {
+        size += animation_size(&move->ani);
+    }
+    return size;
+}
+
+static bool entry_is_cached(const cache_entry *entry) {
+    return entry->bk_data != NULL || entry->af_data != NULL;
+}
+
+static void entry_free(cache_entry *entry) {
+    if(entry->bk_data != NULL) {
+        bk_free(entry->bk_data);
+        omf_free(entry->bk_data);
+    }
+    if(entry->af_data != NULL) {
+        af_free(entry->af_data);
+        omf_free(entry->af_data);
+    }
+    cache.stats.bytes -= entry->size;
+    cache.stats.entries--;
+    entry->size = 0;
+}
+
+/**
+ * Evicts the least recently used unreferenced entries until the cache fits in the budget.
+ */
+static void enforce_budget(void) {
+    while(cache.stats.bytes > cache.budget) {
+        cache_entry *oldest = NULL;
+        for(int i = 0; i < NUMBER_OF_RESOURCES; i++) {
+            cache_entry *entry = &cache.entries[i];
+            if(!entry_is_cached(entry) || entry->refs > 0) {
+                continue;
+            }
+            if(oldest == NULL || entry->last_used < oldest->last_used) {
+                oldest = entry;
+            }
+        }
+        if(oldest == NULL) {
+            return;
+        }
+        log_debug("Resource cache: evicting %s.", get_resource_name(oldest - cache.entries));
+        entry_free(oldest);
+        cache.stats.evictions++;
+    }
+}
+
+static void acquire(int resource_id) {
+    cache_entry *entry = &cache.entries[resource_id];
+    entry->refs++;
+    entry->last_used = ++cache.clock;
+}
+
+static void release(int resource_id) {
+    cache_entry *entry = &cache.entries[resource_id];
+    entry->refs--;
+    enforce_budget();
+}
+
+static void prefetch_run(void *userdata) {
+    prefetch *p = userdata;
+    if(p->bk_data != NULL) {
+        p->ret = load_bk_file(p->bk_data, p->resource_id);
+    } else {
+        p->ret = load_af_file(p->af_data, p->resource_id);
+    }
+}
+
+static void prefetch_start(int resource_id, bool is_bk) {
+    cache_entry *entry = &cache.entries[resource_id];
+    // Prefetched files are not referenced, so a zero budget would evict them right away.
+    if(!cache.enabled || cache.budget == 0 || entry_is_cached(entry) || entry->pending != NULL) {
+        return;
+    }
+    prefetch *p = omf_calloc(1, sizeof(prefetch));
+    p->resource_id = resource_id;
+    if(is_bk) {
+        p->bk_data = omf_calloc(1, sizeof(bk));
+    } else {
+        p->af_data = omf_calloc(1, sizeof(af));
+    }
+    entry->pending = p;
+    cache.pending_count++;
+    p->job = job_submit(prefetch_run, p);
+}
+
+/**
+ * Waits for a prefetch to finish, and moves the loaded file to its cache entry.
+ */
+static void prefetch_finish(cache_entry *entry) {
+    prefetch *p = entry->pending;
+    job_free(p->job);
+    entry->pending = NULL;
+    cache.pending_count--;
+    if(p->ret) {
+        log_warn("Resource cache: prefetching %s failed.", get_resource_name(p->resource_id));
+        omf_free(p->bk_data);
+        omf_free(p->af_data);
+        omf_free(p);
+        return;
+    }
+    entry->bk_data = p->bk_data;
+    entry->af_data = p->af_data;
+    entry->size = entry->bk_data != NULL ? bk_size(entry->bk_data) : af_size(entry->af_data);
+    entry->last_used = ++cache.clock;
+    cache.stats.bytes += entry->size;
+    cache.stats.entries++;
+    cache.stats.prefetches++;
+    omf_free(p);
+}
+
+void resource_cache_prefetch_bk(int resource_id) {
+    prefetch_start(resource_id, true);
+}
+
+void resource_cache_prefetch_af(int resource_id) {
+    prefetch_start(resource_id, false);
+}
+
+void resource_cache_collect(void) {
+    if(cache.pending_count == 0) {
+        return;
+    }
+    for(int i = 0; i < NUMBER_OF_RESOURCES; i++) {
+        cache_entry *entry = &cache.entries[i];
+        if(entry->pending != NULL && job_is_done(entry->pending->job)) {
+            prefetch_finish(entry);
+        }
+    }
+    enforce_budget();
+}
+
+void resource_cache_init(size_t budget) {
+    memset(&cache, 0, sizeof(resource_cache));
+    cache.budget = budget;
+    cache.enabled = true;
+    log_info("Resource cache initialized with a budget of %zu bytes.", budget);
+}
+
+void resource_cache_close(void) {
+    if(!cache.enabled) {
+        return;
+    }
+    for(int i = 0; i < NUMBER_OF_RESOURCES; i++) {
+        cache_entry *entry = &cache.entries[i];
+        if(entry->pending != NULL) {
+            prefetch_finish(entry);
+        }
+        if(!entry_is_cached(entry)) {
+            continue;
+        }
+        if(entry->refs > 0) {
+            log_warn("Resource cache: %s is still in use on close.", get_resource_name(i));
+        }
+        entry_free(entry);
+    }
+    log_info("Resource cache closed: %u hits, %u misses, %u evictions, %u prefetches.", cache.stats.hits,
+             cache.stats.misses, cache.stats.evictions, cache.stats.prefetches);
+    cache.enabled = false;
+}
+
+int resource_cache_load_bk(bk *b, int resource_id) {
+    b->resource_id = -1;
+    if(!cache.enabled) {
+        return load_bk_file(b, resource_id);
+    }
+    cache_entry *entry = &cache.entries[resource_id];
+    if(entry->pending != NULL) {
+        prefetch_finish(entry);
+    }
+    if(entry->bk_data == NULL) {
+        bk *loaded = omf_calloc(1, sizeof(bk));
+        if(load_bk_file(loaded, resource_id)) {
+            omf_free(loaded);
+            return 1;
+        }
+        entry->bk_data = loaded;
+        entry->size = bk_size(loaded);
+        cache.stats.bytes += entry->size;
+        cache.stats.entries++;
+        cache.stats.misses++;
+    } else {
+        cache.stats.hits++;
+    }
+    acquire(resource_id);
+    bk_clone(entry->bk_data, b);
+    b->resource_id = resource_id;
+    return 0;
+}
+
+void resource_cache_free_bk(bk *b) {
+    bk_free(b);
+    if(b->resource_id >= 0) {
+        release(b->resource_id);
+    }
+}
+
+int resource_cache_load_af(af *a, int resource_id) {
+    a->resource_id = -1;
+    if(!cache.enabled) {
+        return load_af_file(a, resource_id);
+    }
+    cache_entry *entry = &cache.entries[resource_id];
+    if(entry->pending != NULL) {
+        prefetch_finish(entry);
+    }
+    if(entry->af_data == NULL) {
+        af *loaded = omf_calloc(1, sizeof(af));
+        if(load_af_file(loaded, resource_id)) {
+            omf_free(loaded);
+            return 1;
+        }
+        entry->af_data = loaded;
+        entry->size = af_size(loaded);
+        cache.stats.bytes += entry->size;
+        cache.stats.entries++;
+        cache.stats.misses++;
+    } else {
+        cache.stats.hits++;
+    }
+    acquire(resource_id);
+    af_clone(entry->af_data, a);
+    a->resource_id = resource_id;
+    return 0;
+}
+
+void resource_cache_free_af(af *a) {
+    af_free(a);
+    if(a->resource_id >= 0) {
+        release(a->resource_id);
+    }
+}
+
+void resource_cache_get_stats(resource_cache_stats *stats) {
+    *stats = cache.stats;
+}
@@ -0,0 +1,65 @@
+#ifndef RESOURCE_CACHE_H
+#define RESOURCE_CACHE_H
+
+#include "resources/af.h"
+#include "resources/bk.h"
+#include <stddef.h>
+
+/**
+ * Keeps decoded BK and AF files in memory between scene loads, so that entering an already seen scene or
+ * HAR does no file I/O or decoding.
+ *
+ * Callers get their own modifiable copy of the data, which shares the sprite surfaces with the cached
+ * original. The original is reference counted, and is only evicted when no copies are in use and the
+ * cache is over its memory budget.
+ */
+
+typedef struct resource_cache_stats {
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+    unsigned int prefetches; // Files loaded ahead of time by a prefetch
+    unsigned int entries;
+    size_t bytes; // Estimated size of the cached surfaces
+} resource_cache_stats;
+
+/**
+ * Enables the cache. Until this is called, files are loaded and freed directly.
+ *
+ * @param budget Memory budget in bytes for unreferenced cached files.
+ */
+void resource_cache_init(size_t budget);
+void resource_cache_close(void);
+
+/**
+ * Loads a BK file through the cache. The result must be released with resource_cache_free_bk().
+ *
+ * @return 0 on success, 1 if the file could not be loaded.
+ */
+int resource_cache_load_bk(bk *b, int resource_id);
+void resource_cache_free_bk(bk *b);
+
+/**
+ * Loads an AF file through the cache. The result must be released with resource_cache_free_af().
+ *
+ * @return 0 on success, 1 if the file could not be loaded.
+ */
+int resource_cache_load_af(af *a, int resource_id);
+void resource_cache_free_af(af *a);
+
+/**
+ * Starts loading a file on a worker thread, so that a later load finds it in the cache. Does nothing if the
+ * file is already cached or being loaded, or if the cache has no budget to keep it in.
+ */
+void resource_cache_prefetch_bk(int resource_id);
+void resource_cache_prefetch_af(int resource_id);
+
+/**
+ * Moves finished prefetches into the cache. Call this from the main thread between ticks.
+ * A load of a file that is still being prefetched waits for it instead.
+ */
+void resource_cache_collect(void);
+
+void resource_cache_get_stats(resource_cache_stats *stats);
+
+#endif // RESOURCE_CACHE_H
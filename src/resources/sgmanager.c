@@ -2,14 +2,19 @@
 #include "formats/chr.h"
 #include "formats/error.h"
 #include "game/utils/settings.h"
+#include "resources/file_index.h"
 #include "resources/pathmanager.h"
 #include "utils/allocator.h"
 #include "utils/c_string_util.h"
+#include "utils/io.h"
 #include "utils/log.h"
 #include "utils/scandir.h"
 #include <stdio.h>
 #include <string.h>
 
+#define SG_INDEX_FILE "savegames.idx"
+#define SG_INDEX_VERSION 1
+
 int sg_init(void) {
     int ret;
     list dirlist;
@@ -80,6 +85,26 @@ int sg_count(void) {
     return size;
 }
 
+/**
+ * Loads the pilot of a savegame, using the pilot block from the index if the file has not changed.
+ */
+static int sg_load_header(file_index *index, sd_chr_file *chr, const char *path, const char *chrfile) {
+    char header[SD_CHR_HEADER_SIZE];
+    int64_t mtime, size;
+    if(!file_get_info(path, &mtime, &size)) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    if(!file_index_get(index, chrfile, mtime, size, header)) {
+        int ret = sd_chr_read_header(path, header);
+        if(ret != SD_SUCCESS) {
+            return ret;
+        }
+        file_index_put(index, chrfile, mtime, size, header);
+    }
+    sd_chr_create(chr);
+    return sd_chr_load_header(chr, header);
+}
+
 list *sg_load_all(void) {
 
     if(sg_init()) {
@@ -90,35 +115,46 @@ list *sg_load_all(void) {
     list dirlist;
     // Seek all files
     list_create(&dirlist);
-    scan_directory(&dirlist, dirname);
+    scan_directory_suffix(&dirlist, dirname, ".CHR");
 
-    log_debug("Found %d savegames.", list_size(&dirlist) - 2);
+    log_debug("Found %d savegames.", list_size(&dirlist));
 
     list *chrlist = omf_calloc(1, sizeof(list));
 
+    file_index index;
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s%s", dirname, SG_INDEX_FILE);
+    file_index_open(&index, tmp, SG_INDEX_VERSION, SD_CHR_HEADER_SIZE);
+
     iterator it;
     list_iter_begin(&dirlist, &it);
     char *chrfile;
-    char *ext;
     foreach(it, chrfile) {
-        if(strcmp(".", chrfile) == 0 || strcmp("..", chrfile) == 0) {
-            continue;
-        }
-        if((ext = strrchr(chrfile, '.')) && strcmp(".CHR", ext) == 0) {
-            sd_chr_file *chr = omf_calloc(1, sizeof(sd_chr_file));
-            ext[0] = 0;
-            log_debug("%s", chrfile);
-            if(sg_load(chr, chrfile) == SD_SUCCESS) {
-                list_append(chrlist, chr, sizeof(sd_chr_file));
-            }
-            omf_free(chr);
+        sd_chr_file chr;
+        snprintf(tmp, sizeof(tmp), "%s%s", dirname, chrfile);
+        if(sg_load_header(&index, &chr, tmp, chrfile) == SD_SUCCESS) {
+            list_append(chrlist, &chr, sizeof(sd_chr_file));
+        } else {
+            log_error("Unable to read savegame file '%s'.", tmp);
         }
     }
+    file_index_close(&index);
 
     list_free(&dirlist);
     return chrlist;
 }
 
+int sg_load_photo(sd_chr_file *chr) {
+    char tmp[1024];
+    const char *dirname = pm_get_local_path(SAVE_PATH);
+    snprintf(tmp, sizeof(tmp), "%s%s.CHR", dirname, chr->pilot.name);
+    int ret = sd_chr_load_photo(chr, tmp);
+    if(ret != SD_SUCCESS) {
+        log_error("Unable to load photo from savegame file '%s'.", tmp);
+    }
+    return ret;
+}
+
 int sg_load(sd_chr_file *chr, const char *pilotname) {
     char tmp[1024];
 
@@ -6,7 +6,13 @@
 
 int sg_init(void);
 int sg_count(void);
+
+/**
+ * Lists the savegames. Only the pilot of each savegame is loaded, and the pilot blocks are cached in
+ * an index file. Use sg_load_photo() to load the photo of a listed pilot, or sg_load() to load it fully.
+ */
 list *sg_load_all(void);
+int sg_load_photo(sd_chr_file *chr);
 int sg_load(sd_chr_file *chr, const char *pilotname);
 int sg_save(sd_chr_file *chr);
 int sg_delete(const char *pilotname);
@@ -1,19 +1,72 @@
 #include "resources/trnmanager.h"
 #include "formats/error.h"
 #include "formats/tournament.h"
+#include "resources/file_index.h"
 #include "resources/pathmanager.h"
 #include "utils/allocator.h"
+#include "utils/io.h"
 #include "utils/list.h"
 #include "utils/log.h"
 #include "utils/scandir.h"
 #include <stdio.h>
 #include <string.h>
 
+#define TRN_INDEX_FILE "tournaments.idx"
+#define TRN_INDEX_VERSION 1
+
+// Header fields of a tournament, as stored in the index.
+typedef struct trn_index_record {
+    uint32_t enemy_count;
+    char bk_name[14];
+    float winnings_multiplier;
+    int32_t unknown_a;
+    int32_t registration_fee;
+    int32_t assumed_initial_value;
+    int32_t tournament_id;
+} trn_index_record;
+
 static void trnlist_node_free_callback(void *data) {
     sd_tournament_file *trn = data;
     sd_tournament_free(trn);
 }
 
+/**
+ * Fills in the header fields of a tournament, from the index if the file has not changed.
+ */
+static int trn_load_header(file_index *index, sd_tournament_file *trn, const char *path, const char *trn_file) {
+    trn_index_record record;
+    int64_t mtime, size;
+    if(!file_get_info(path, &mtime, &size)) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    if(file_index_get(index, trn_file, mtime, size, &record)) {
+        snprintf(trn->filename, sizeof(trn->filename), "%s", trn_file);
+        memcpy(trn->bk_name, record.bk_name, sizeof(trn->bk_name));
+        trn->enemy_count = record.enemy_count;
+        trn->winnings_multiplier = record.winnings_multiplier;
+        trn->unknown_a = record.unknown_a;
+        trn->registration_fee = record.registration_fee;
+        trn->assumed_initial_value = record.assumed_initial_value;
+        trn->tournament_id = record.tournament_id;
+        return SD_SUCCESS;
+    }
+
+    int ret = sd_tournament_load_header(trn, path);
+    if(ret != SD_SUCCESS) {
+        return ret;
+    }
+    memset(&record, 0, sizeof(record));
+    memcpy(record.bk_name, trn->bk_name, sizeof(record.bk_name));
+    record.enemy_count = trn->enemy_count;
+    record.winnings_multiplier = trn->winnings_multiplier;
+    record.unknown_a = trn->unknown_a;
+    record.registration_fee = trn->registration_fee;
+    record.assumed_initial_value = trn->assumed_initial_value;
+    record.tournament_id = trn->tournament_id;
+    file_index_put(index, trn_file, mtime, size, &record);
+    return SD_SUCCESS;
+}
+
 list *trnlist_init(void) {
     int ret;
     list dirlist;
@@ -38,23 +91,28 @@ list *trnlist_init(void) {
     list_create(trnlist);
     list_set_node_free_cb(trnlist, trnlist_node_free_callback);
 
+    file_index index;
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s%s", pm_get_local_path(SAVE_PATH), TRN_INDEX_FILE);
+    file_index_open(&index, tmp, TRN_INDEX_VERSION, sizeof(trn_index_record));
+
     iterator it;
     list_iter_begin(&dirlist, &it);
     char *trn_file;
-    char tmp[1024];
     foreach(it, trn_file) {
         sd_tournament_file trn;
         sd_tournament_create(&trn);
         snprintf(tmp, 1024, "%s%s", dirname, trn_file);
-        if(SD_SUCCESS == sd_tournament_load(&trn, tmp)) {
+        if(trn_load_header(&index, &trn, tmp, trn_file) == SD_SUCCESS) {
             list_append(trnlist, &trn, sizeof(sd_tournament_file));
         } else {
             log_error("Could not load tournament %s", trn_file);
         }
     }
     list_iter_end(&dirlist, &it);
+    file_index_close(&index);
 
-    log_debug("Loaded %d tournaments", list_size(trnlist));
+    log_debug("Indexed %d tournaments", list_size(trnlist));
 
     list_free(&dirlist);
     return trnlist;
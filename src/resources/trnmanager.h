@@ -4,6 +4,10 @@
 #include "formats/tournament.h"
 #include "utils/list.h"
 
+/**
+ * Lists the tournaments in the resource directory. Only the header fields of each tournament are
+ * filled in, and they are cached in an index file. Use trn_load() to load a tournament fully.
+ */
 list *trnlist_init(void);
 int trn_load(sd_tournament_file *trn, const char *trnname);
 
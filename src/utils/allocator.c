@@ -3,3 +3,6 @@
 const char *_text_malloc_error = "malloc(%zu) failed on %s:%d\n";
 const char *_text_calloc_error = "calloc(%zu, %zu) failed on %s:%d\n";
 const char *_text_realloc_error = "realloc(%p, %zu) failed on %s:%d\n";
+
+size_t _omf_alloc_count = 0;
+size_t _omf_free_count = 0;
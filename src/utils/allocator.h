@@ -1,11 +1,17 @@
 #ifndef ALLOCATOR_H
 #define ALLOCATOR_H
 
+#include <stddef.h>
+
 // format strings for use in platform-specific allocator header
 extern const char *_text_malloc_error;
 extern const char *_text_calloc_error;
 extern const char *_text_realloc_error;
 
+// running allocation counters, see omf_alloc_count() and omf_free_count()
+extern size_t _omf_alloc_count;
+extern size_t _omf_free_count;
+
 // Add ifdefs here to include platform-specific allocators.
 #include "utils/allocator_default.h"
 
@@ -64,4 +70,20 @@ extern const char *_text_realloc_error;
         (ptr) = NULL;                                                                                                  \
     } while(0)
 
+/**
+ * @brief Number of allocations made so far
+ * @details Counts every successful omf_malloc, omf_calloc and omf_realloc call since startup, including the
+ * ones made by omf_strdup and omf_strndup. Meant for tests and tools that check that some code does not
+ * allocate: take the count before and after and compare. The counter is not synchronized, so only compare
+ * counts while no other thread is allocating.
+ */
+#define omf_alloc_count() ((size_t)_omf_alloc_count)
+
+/**
+ * @brief Number of non-NULL pointers freed so far
+ * @details Counts every omf_free call that released an allocation since startup. Same caveats as
+ * omf_alloc_count().
+ */
+#define omf_free_count() ((size_t)_omf_free_count)
+
 #endif // ALLOCATOR_H
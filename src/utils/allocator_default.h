@@ -6,13 +6,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define omf_free_real(ptr) free(ptr)
+static inline void omf_free_real(void *ptr) {
+    if(ptr != NULL) {
+        _omf_free_count++;
+    }
+    free(ptr);
+}
 
 static inline void *omf_malloc_real(size_t size, const char *file, int line) {
     assert(size > 0);
     void *ret = malloc(size);
-    if(ret != NULL)
+    if(ret != NULL) {
+        _omf_alloc_count++;
         return ret;
+    }
     fprintf(stderr, _text_malloc_error, size, file, line);
     abort();
 }
@@ -21,8 +28,10 @@ static inline void *omf_calloc_real(size_t nmemb, size_t size, const char *file,
     assert(size > 0);
     assert(nmemb > 0);
     void *ret = calloc(nmemb, size);
-    if(ret != NULL)
+    if(ret != NULL) {
+        _omf_alloc_count++;
         return ret;
+    }
     fprintf(stderr, _text_calloc_error, nmemb, size, file, line);
     abort();
 }
@@ -31,6 +40,7 @@ static inline void *omf_realloc_real(void *ptr, size_t size, const char *file, i
     assert(size > 0);
     void *ret = realloc(ptr, size);
     if(ret != NULL) {
+        _omf_alloc_count++;
         return ret;
     }
     fprintf(stderr, _text_realloc_error, ptr, size, file, line);
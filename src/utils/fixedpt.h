@@ -0,0 +1,101 @@
+#ifndef FIXEDPT_H
+#define FIXEDPT_H
+
+#include <stdint.h>
+
+/**
+ * Signed 16.16 fixed-point numbers.
+ *
+ * Everything here is integer math, so unlike with floats, the results do not depend on the compiler, its
+ * floating point flags (-ffast-math, FMA contraction) or the FPU. Conversions from and to float are exact
+ * in both directions for values below 256, and round to nearest otherwise.
+ */
+typedef int32_t fixedpt;
+
+#define FIXEDPT_FRAC_BITS 16
+#define FIXEDPT_ONE (1 << FIXEDPT_FRAC_BITS)
+
+static inline fixedpt fixedpt_from_int(int v) {
+    return v * FIXEDPT_ONE;
+}
+
+// Rounds toward zero, like casting a float to int does.
+static inline int fixedpt_to_int(fixedpt v) {
+    return v / FIXEDPT_ONE;
+}
+
+static inline fixedpt fixedpt_from_float(float v) {
+    double scaled = (double)v * FIXEDPT_ONE;
+    return (fixedpt)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+static inline float fixedpt_to_float(fixedpt v) {
+    return (float)((double)v / FIXEDPT_ONE);
+}
+
+// Rounds toward negative infinity.
+static inline fixedpt fixedpt_mul(fixedpt a, fixedpt b) {
+    return (fixedpt)(((int64_t)a * b) >> FIXEDPT_FRAC_BITS);
+}
+
+// Rounds toward zero. Results that do not fit, including division by zero, saturate instead of trapping.
+static inline fixedpt fixedpt_div(fixedpt a, fixedpt b) {
+    if(b == 0) {
+        return a == 0 ? 0 : (a > 0 ? INT32_MAX : INT32_MIN);
+    }
+    int64_t q = ((int64_t)a * FIXEDPT_ONE) / b;
+    if(q > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if(q < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (fixedpt)q;
+}
+
+static inline fixedpt fixedpt_abs(fixedpt v) {
+    return v < 0 ? -v : v;
+}
+
+// pi and pi / 2 in 2.30 fixed-point, the precision the sine below works in
+#define FIXEDPT_PI_30 INT64_C(3373259426)
+#define FIXEDPT_HALF_PI_30 INT64_C(1686629713)
+
+// Sine of an angle in radians, given in 2.30 fixed-point. Any angle that fits an int64_t works.
+static inline fixedpt fixedpt_sin_30(int64_t x) {
+    // Reduce to [-pi, pi], and then mirror into [-pi/2, pi/2]
+    x %= 2 * FIXEDPT_PI_30;
+    if(x > FIXEDPT_PI_30) {
+        x -= 2 * FIXEDPT_PI_30;
+    } else if(x < -FIXEDPT_PI_30) {
+        x += 2 * FIXEDPT_PI_30;
+    }
+    if(x > FIXEDPT_HALF_PI_30) {
+        x = FIXEDPT_PI_30 - x;
+    } else if(x < -FIXEDPT_HALF_PI_30) {
+        x = -FIXEDPT_PI_30 - x;
+    }
+
+    // Taylor series up to x^11, which is well within 16.16 precision on [-pi/2, pi/2]
+    const int64_t one = INT64_C(1) << 30;
+    int64_t x2 = (x * x) >> 30;
+    int64_t t = one - x2 / 110;
+    t = one - ((x2 * t) >> 30) / 72;
+    t = one - ((x2 * t) >> 30) / 42;
+    t = one - ((x2 * t) >> 30) / 20;
+    t = one - ((x2 * t) >> 30) / 6;
+    int64_t sin = (x * t) >> 30;
+    return (fixedpt)((sin + (1 << 13)) >> 14);
+}
+
+// Sine of an angle in radians
+static inline fixedpt fixedpt_sin(fixedpt angle) {
+    return fixedpt_sin_30((int64_t)angle * (1 << 14));
+}
+
+// Cosine of an angle in radians
+static inline fixedpt fixedpt_cos(fixedpt angle) {
+    return fixedpt_sin_30((int64_t)angle * (1 << 14) + FIXEDPT_HALF_PI_30);
+}
+
+#endif // FIXEDPT_H
@@ -1,15 +1,22 @@
 #include "utils/hashmap.h"
 #include "utils/allocator.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define FNV_32_PRIME ((uint32_t)0x01000193)
 #define FNV1_32_INIT ((uint32_t)2166136261)
-#define ENLARGE_LIMIT 1024
 #define INITIAL_SIZE 4
+#define MAX_PAGE_SHIFT 12
 
-uint32_t fnv_32a_buf(const void *buf, unsigned int len, unsigned int max_size) {
+// Storage for a value of up to HASHMAP_INLINE_SIZE bytes. Free blocks are chained through next.
+typedef union hashmap_block {
+    union hashmap_block *next;
+    char data[HASHMAP_INLINE_SIZE];
+} hashmap_block;
+
+static uint32_t fnv_32a_buf(const void *buf, unsigned int len) {
     unsigned char *bp = (unsigned char *)buf;
     unsigned char *be = bp + len;
     uint32_t val = FNV1_32_INIT;
@@ -17,7 +24,175 @@ uint32_t fnv_32a_buf(const void *buf, unsigned int len, unsigned int max_size) {
         val ^= (uint32_t)*bp++;
         val *= FNV_32_PRIME;
     }
-    return val % max_size;
+    return val;
+}
+
+/**
+ * Number of overflow slots after the last home slot. Robin Hood probe lengths grow roughly with
+ * the logarithm of the table size, so this rarely forces an early resize.
+ */
+static unsigned int hashmap_tail_size(unsigned int capacity) {
+    unsigned int tail = 8;
+    for(unsigned int c = capacity; c > 1; c >>= 1) {
+        tail += 2;
+    }
+    return tail;
+}
+
+static void hashmap_alloc(hashmap *hm, unsigned int capacity) {
+    hm->capacity = capacity;
+    hm->tail = hashmap_tail_size(capacity);
+    hm->buckets = omf_calloc(capacity + hm->tail + 1, sizeof(hashmap_node));
+}
+
+/**
+ * Takes a small value block from the pool. When the pool runs out, a new page is added; every page is
+ * twice the size of the previous one, up to a limit.
+ */
+static void *hashmap_block_alloc(hashmap *hm) {
+    if(hm->free_blocks == NULL) {
+        unsigned int count = INITIAL_SIZE << (hm->page_count < MAX_PAGE_SHIFT ? hm->page_count : MAX_PAGE_SHIFT);
+        hashmap_block *page = omf_malloc(count * sizeof(hashmap_block));
+        hm->pages = omf_realloc(hm->pages, (hm->page_count + 1) * sizeof(void *));
+        hm->pages[hm->page_count++] = page;
+        for(unsigned int i = count; i > 0; i--) {
+            page[i - 1].next = hm->free_blocks;
+            hm->free_blocks = &page[i - 1];
+        }
+    }
+    hashmap_block *block = hm->free_blocks;
+    hm->free_blocks = block->next;
+    return block;
+}
+
+static void hashmap_block_free(hashmap *hm, void *value) {
+    hashmap_block *block = value;
+    block->next = hm->free_blocks;
+    hm->free_blocks = block;
+}
+
+/**
+ * Points the pair at the inline key storage, if used. Must be called every time a node is moved.
+ */
+static inline void hashmap_node_fix(hashmap_node *node) {
+    if(node->pair.key_len <= HASHMAP_INLINE_SIZE) {
+        node->pair.key = node->key_data;
+    }
+}
+
+static void hashmap_node_free(hashmap *hm, hashmap_node *node) {
+    if(hm->free_cb != NULL) {
+        hm->free_cb(node->pair.value);
+    }
+    if(node->pair.key_len > HASHMAP_INLINE_SIZE) {
+        omf_free(node->pair.key);
+    }
+    if(node->pair.value_len > HASHMAP_INLINE_SIZE) {
+        omf_free(node->pair.value);
+    } else {
+        hashmap_block_free(hm, node->pair.value);
+    }
+}
+
+/**
+ * Sets the value of a node. Values that keep to the same storage class stay at the same address; a new
+ * node must have a NULL value.
+ */
+static void hashmap_node_set_value(hashmap *hm, hashmap_node *node, const void *val, unsigned int value_len) {
+    bool was_small = node->pair.value_len <= HASHMAP_INLINE_SIZE;
+    if(value_len <= HASHMAP_INLINE_SIZE) {
+        if(node->pair.value == NULL || !was_small) {
+            void *block = hashmap_block_alloc(hm);
+            memcpy(block, val, value_len);
+            if(node->pair.value != NULL) {
+                omf_free(node->pair.value);
+            }
+            node->pair.value = block;
+        } else {
+            memmove(node->pair.value, val, value_len);
+        }
+    } else if(!was_small) {
+        node->pair.value = omf_realloc(node->pair.value, value_len);
+        memcpy(node->pair.value, val, value_len);
+    } else {
+        void *value = omf_malloc(value_len);
+        memcpy(value, val, value_len);
+        if(node->pair.value != NULL) {
+            hashmap_block_free(hm, node->pair.value);
+        }
+        node->pair.value = value;
+    }
+    node->pair.value_len = value_len;
+}
+
+static void hashmap_resize(hashmap *hm, unsigned int new_size);
+
+/**
+ * Places a node to the table.
+ *
+ * Robin Hood probing keeps the nodes of a run ordered by their home slot, so the node goes in front of
+ * the first node that is closer to its home than the new one would be, and the rest of the run is
+ * shifted forward by one slot.
+ *
+ * If the run would spill past the overflow slots, the table is enlarged and NULL is returned.
+ * Otherwise returns the slot where the node was placed.
+ */
+static hashmap_node *hashmap_place(hashmap *hm, const hashmap_node *node) {
+    unsigned int end = hm->capacity + hm->tail;
+    unsigned int pos = node->hash & (hm->capacity - 1);
+    uint32_t dist = 1;
+    while(hm->buckets[pos].dist >= dist) {
+        pos++;
+        dist++;
+    }
+    unsigned int empty = pos;
+    while(hm->buckets[empty].dist != 0) {
+        empty++;
+    }
+    if(empty >= end) {
+        hashmap_resize(hm, hm->capacity << 1);
+        hashmap_place(hm, node);
+        return NULL;
+    }
+
+    if(empty > pos) {
+        memmove(&hm->buckets[pos + 1], &hm->buckets[pos], (empty - pos) * sizeof(hashmap_node));
+        for(unsigned int i = pos + 1; i <= empty; i++) {
+            hm->buckets[i].dist++;
+            hashmap_node_fix(&hm->buckets[i]);
+        }
+    }
+    hashmap_node *slot = &hm->buckets[pos];
+    *slot = *node;
+    slot->dist = dist;
+    hashmap_node_fix(slot);
+    return slot;
+}
+
+static hashmap_node *hashmap_find(const hashmap *hm, const void *key, unsigned int key_len, uint32_t hash) {
+    hashmap_node *node = &hm->buckets[hash & (hm->capacity - 1)];
+    for(uint32_t dist = 1; node->dist >= dist; node++, dist++) {
+        if(node->hash == hash && node->pair.key_len == key_len && memcmp(node->pair.key, key, key_len) == 0) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Removes the node in the given slot, and shifts the following nodes of the probe sequence back by one.
+ */
+static void hashmap_remove(hashmap *hm, hashmap_node *node) {
+    hashmap_node_free(hm, node);
+    hashmap_node *next = node + 1;
+    while(next->dist > 1) {
+        *node = *next;
+        node->dist--;
+        hashmap_node_fix(node);
+        node = next++;
+    }
+    memset(node, 0, sizeof(hashmap_node));
+    hm->reserved--;
 }
 
 /** \brief Creates a new hashmap
@@ -26,10 +201,12 @@ uint32_t fnv_32a_buf(const void *buf, unsigned int len, unsigned int max_size) {
  * \param initial_capacity Size of the hashmap.
  */
 void hashmap_create(hashmap *hm) {
-    hm->buckets = omf_calloc(INITIAL_SIZE, sizeof(hashmap_node *));
+    hashmap_alloc(hm, INITIAL_SIZE);
     hm->reserved = 0;
-    hm->capacity = INITIAL_SIZE;
     hm->free_cb = NULL;
+    hm->free_blocks = NULL;
+    hm->pages = NULL;
+    hm->page_count = 0;
 }
 
 /** \brief Creates a new hashmap with an object free callback.
@@ -48,45 +225,30 @@ void hashmap_create_cb(hashmap *hm, hashmap_free_cb free_cb) {
 /**
  * Resizes the hashmap to a new capacity.
  *
- * All existing key-value pairs are rehashed, so this has some CPU impact.
+ * All existing key-value pairs are moved to a new slot array. Hashes are kept in the slots, so keys
+ * are not hashed again.
  */
 static void hashmap_resize(hashmap *hm, unsigned int new_size) {
     if(new_size <= hm->capacity)
         return;
 
-    // Allocate and zero out a new memory blocks for the resized bucket list
-    size_t new_bytes = new_size * sizeof(hashmap_node *);
-    hm->buckets = omf_realloc(hm->buckets, new_bytes);
-    memset(&hm->buckets[hm->capacity], 0, (new_size - hm->capacity) * sizeof(hashmap_node *));
-
-    // Rehash
-    hashmap_node *node = NULL;
-    hashmap_node *this = NULL;
-    unsigned int index;
-    for(unsigned int i = 0; i < hm->capacity; i++) {
-        node = hm->buckets[i];
-        hm->buckets[i] = NULL;
-        while(node != NULL) {
-            this = node;
-            node = node->next;
-
-            // Recalculate index, and prepend the new index to the bucket list
-            index = fnv_32a_buf(this->pair.key, this->pair.key_len, new_size);
-            this->next = hm->buckets[index];
-            hm->buckets[index] = this;
+    hashmap_node *old = hm->buckets;
+    unsigned int old_end = hm->capacity + hm->tail;
+    hashmap_alloc(hm, new_size);
+    for(unsigned int i = 0; i < old_end; i++) {
+        if(old[i].dist != 0) {
+            hashmap_place(hm, &old[i]);
         }
     }
-    hm->capacity = new_size;
+    omf_free(old);
 }
 
 /**
  * Check if hashmap pressure is high enough for automatic resize, and resize if yes.
  */
 static void hashmap_enlarge_check(hashmap *hm) {
-    if(hm->capacity >= ENLARGE_LIMIT)
-        return;
     unsigned int q = hm->capacity - (hm->capacity >> 2);
-    if(hm->reserved > q) {
+    if(hm->reserved + 1 > q) {
         hashmap_resize(hm, hm->capacity << 1);
     }
 }
@@ -99,23 +261,15 @@ static void hashmap_enlarge_check(hashmap *hm) {
  * \param hm Hashmap to clear
  */
 void hashmap_clear(hashmap *hm) {
-    hashmap_node *node = NULL;
-    hashmap_node *tmp = NULL;
-    for(unsigned int i = 0; i < hashmap_size(hm); i++) {
-        node = hm->buckets[i];
-        while(node != NULL) {
-            tmp = node;
-            node = node->next;
-            if(hm->free_cb != NULL) {
-                hm->free_cb(tmp->pair.value);
-            }
-            omf_free(tmp->pair.key);
-            omf_free(tmp->pair.value);
-            omf_free(tmp);
-            hm->reserved--;
+    if(hm->buckets == NULL)
+        return;
+    for(unsigned int i = 0; i < hm->capacity + hm->tail; i++) {
+        if(hm->buckets[i].dist != 0) {
+            hashmap_node_free(hm, &hm->buckets[i]);
         }
-        hm->buckets[i] = NULL;
     }
+    memset(hm->buckets, 0, (hm->capacity + hm->tail + 1) * sizeof(hashmap_node));
+    hm->reserved = 0;
 }
 
 /** \brief Free hashmap
@@ -128,8 +282,15 @@ void hashmap_clear(hashmap *hm) {
 void hashmap_free(hashmap *hm) {
     hashmap_clear(hm);
     omf_free(hm->buckets);
+    for(unsigned int i = 0; i < hm->page_count; i++) {
+        omf_free(hm->pages[i]);
+    }
+    omf_free(hm->pages);
+    hm->free_blocks = NULL;
+    hm->page_count = 0;
     hm->capacity = 0;
     hm->reserved = 0;
+    hm->tail = 0;
 }
 
 /** \brief Puts an item to the hashmap
@@ -143,49 +304,39 @@ void hashmap_free(hashmap *hm) {
  * \param key_len Length of the key memory block
  * \param val Pointer to value memory block
  * \param value_len Length of the value memory block
- * \return Returns a pointer to the newly reserved hashmap pair.
+ * \return Returns a pointer to the value in the hashmap. It stays valid until the key is deleted or put again.
  */
 void *hashmap_put(hashmap *hm, const void *key, unsigned int key_len, const void *val, unsigned int value_len) {
-    unsigned int index = fnv_32a_buf(key, key_len, hm->capacity);
-    hashmap_node *root = hm->buckets[index];
-    hashmap_node *seek = root;
-
-    // See if the key already exists in the buckets list
-    int found = 0;
-    while(seek) {
-        if(seek->pair.key_len == key_len && memcmp(seek->pair.key, key, key_len) == 0) {
-            found = 1;
-            break;
-        }
-        seek = seek->next;
-    }
+    uint32_t hash = fnv_32a_buf(key, key_len);
 
-    if(found) {
-        // The key is already in the hashmap, so just realloc and reset the contents.
-        seek->pair.value = omf_realloc(seek->pair.value, value_len);
-        memcpy(seek->pair.value, val, value_len);
-        seek->pair.value_len = value_len;
-
-        hashmap_enlarge_check(hm);
+    // If the key is already in the hashmap, just reset the contents.
+    hashmap_node *seek = hashmap_find(hm, key, key_len, hash);
+    if(seek != NULL) {
+        hashmap_node_set_value(hm, seek, val, value_len);
         return seek->pair.value;
-    } else {
-        // Key is not yet in the hashmap, so create a new node and set it
-        // as the first entry in the buckets list.
-        hashmap_node *node = omf_calloc(1, sizeof(hashmap_node));
-        node->pair.key_len = key_len;
-        node->pair.value_len = value_len;
-        node->pair.key = omf_calloc(1, key_len);
-        node->pair.value = omf_calloc(1, value_len);
-        memcpy(node->pair.key, key, key_len);
-        memcpy(node->pair.value, val, value_len);
+    }
 
-        node->next = root;
-        hm->buckets[index] = node;
-        hm->reserved++;
+    // Key is not yet in the hashmap, so create a new node and place it.
+    hashmap_enlarge_check(hm);
+    hashmap_node node;
+    memset(&node, 0, sizeof(hashmap_node));
+    node.hash = hash;
+    node.pair.key_len = key_len;
+    if(key_len > HASHMAP_INLINE_SIZE) {
+        node.pair.key = omf_malloc(key_len);
+        memcpy(node.pair.key, key, key_len);
+    } else {
+        memcpy(node.key_data, key, key_len);
+    }
+    hashmap_node_set_value(hm, &node, val, value_len);
+    hm->reserved++;
 
-        hashmap_enlarge_check(hm);
-        return node->pair.value;
+    seek = hashmap_place(hm, &node);
+    if(seek == NULL) {
+        // The table was enlarged while placing the node, so look it up from its new slot.
+        seek = hashmap_find(hm, key, key_len, hash);
     }
+    return seek->pair.value;
 }
 
 /** \brief Deletes an item from the hashmap
@@ -200,44 +351,11 @@ void *hashmap_put(hashmap *hm, const void *key, unsigned int key_len, const void
  * \return Returns 0 on success, 1 on error (not found).
  */
 int hashmap_del(hashmap *hm, const void *key, unsigned int key_len) {
-    unsigned int index = fnv_32a_buf(key, key_len, hm->capacity);
-
-    // Get node
-    hashmap_node *node = hm->buckets[index];
-    hashmap_node *prev = NULL;
+    hashmap_node *node = hashmap_find(hm, key, key_len, fnv_32a_buf(key, key_len));
     if(node == NULL)
         return 1;
-
-    // Find the node we want to delete
-    int found = 0;
-    while(node) {
-        if(node->pair.key_len == key_len && memcmp(node->pair.key, key, key_len) == 0) {
-            found = 1;
-            break;
-        }
-        prev = node;
-        node = node->next;
-    }
-
-    // If node was found, handle delete
-    if(found) {
-        if(prev != NULL) {
-            // If node is not first in chain, set correct links
-            prev->next = node->next;
-        } else {
-            // If node is first in chain, set possible next entry as first
-            hm->buckets[index] = node->next;
-        }
-        if(hm->free_cb != NULL) {
-            hm->free_cb(node->pair.value);
-        }
-        omf_free(node->pair.key);
-        omf_free(node->pair.value);
-        omf_free(node);
-        hm->reserved--;
-        return 0;
-    }
-    return 1;
+    hashmap_remove(hm, node);
+    return 0;
 }
 
 /** \brief Gets an item from the hashmap
@@ -250,30 +368,17 @@ int hashmap_del(hashmap *hm, const void *key, unsigned int key_len) {
  * \return Returns 0 on success, 1 on error (not found).
  */
 int hashmap_get(hashmap *hm, const void *key, unsigned int key_len, void **value, unsigned int *value_len) {
-    unsigned int index = fnv_32a_buf(key, key_len, hm->capacity);
-
-    // Set defaults for error cases
-    *value = NULL;
-    if(value_len != NULL)
-        *value_len = 0;
-
-    // Get node
-    hashmap_node *node = hm->buckets[index];
-    if(node == NULL)
+    hashmap_node *node = hashmap_find(hm, key, key_len, fnv_32a_buf(key, key_len));
+    if(node == NULL) {
+        *value = NULL;
+        if(value_len != NULL)
+            *value_len = 0;
         return 1;
-
-    // Find the node we want
-    while(node) {
-        if(node->pair.key_len == key_len && memcmp(node->pair.key, key, key_len) == 0) {
-            *value = node->pair.value;
-            if(value_len != NULL)
-                *value_len = node->pair.value_len;
-            return 0;
-        }
-        node = node->next;
     }
-
-    return 1;
+    *value = node->pair.value;
+    if(value_len != NULL)
+        *value_len = node->pair.value_len;
+    return 0;
 }
 
 /** \brief Deletes an item from the hashmap by iterator key
@@ -287,97 +392,31 @@ int hashmap_get(hashmap *hm, const void *key, unsigned int key_len, void **value
  * \return Returns 0 on success, 1 on error (not found).
  */
 int hashmap_delete(hashmap *hm, iterator *iter) {
-    int index = iter->inow - 1;
-
-    if(iter->ended) {
+    if(iter->ended || iter->vnow == NULL) {
         return 1;
     }
 
-    // Find correct node
-    hashmap_node *node = hm->buckets[index];
-    hashmap_node *prev = NULL;
-    hashmap_node *seek = iter->vnow;
-    if(node == NULL || seek == NULL)
-        return 1;
-
-    // Find the node we want to delete
-    int found = 0;
-    while(node) {
-        if(node == seek) {
-            found = 1;
-            break;
-        }
-        prev = node;
-        node = node->next;
-    }
-
-    // If node was found, handle delete
-    if(found) {
-        // If node is not first in chain, set correct links
-        // Otherwise set possible next entry as first
-        if(prev != NULL) {
-            prev->next = node->next;
-            iter->vnow = prev;
-        } else {
-            hm->buckets[index] = node->next;
-            iter->vnow = NULL;
-            iter->inow--;
-        }
-
-        // Got one, free up memory.
-        if(hm->free_cb != NULL) {
-            hm->free_cb(node->pair.value);
-        }
-        omf_free(node->pair.key);
-        omf_free(node->pair.value);
-        omf_free(node);
-        hm->reserved--;
-        return 0;
-    }
-    return 1;
-}
-
-static void _hashmap_seek_next(hashmap *hm, iterator *iter) {
-    if(iter->inow >= (int)hashmap_size(hm)) {
-        iter->vnow = NULL;
-        iter->ended = 1;
-        return;
-    }
-    do {
-        iter->vnow = hm->buckets[iter->inow++];
-    } while(iter->vnow == NULL && iter->inow < (int)hashmap_size(hm));
+    // Probes never wrap around, so the nodes shifted back by the removal are all ahead of the
+    // iterator. The next one may land in the current slot, so it needs to be visited again.
+    hashmap_remove(hm, iter->vnow);
+    iter->vnow = NULL;
+    iter->inow--;
+    return 0;
 }
 
 void *hashmap_iter_next(iterator *iter) {
-    hashmap_node *tmp = NULL;
     hashmap *hm = (hashmap *)iter->data;
-
-    // Find next non-empty bucket
-    if(iter->vnow == NULL) {
-        _hashmap_seek_next(hm, iter);
-        if(iter->vnow == NULL) {
-            return NULL;
+    unsigned int end = hm->capacity + hm->tail;
+    while((unsigned int)iter->inow < end) {
+        hashmap_node *node = &hm->buckets[iter->inow++];
+        if(node->dist != 0) {
+            iter->vnow = node;
+            return &node->pair;
         }
-        tmp = (hashmap_node *)iter->vnow;
-        return &tmp->pair;
-    }
-
-    // We already are in a non-empty bucket. See if it has any
-    // other non-empty buckets in list. If it does, return it.
-    tmp = (hashmap_node *)iter->vnow;
-    if(tmp->next != NULL) {
-        iter->vnow = tmp->next;
-        return &tmp->next->pair;
     }
-
-    // We are in the end of the list for this bucket.
-    // Find next non-empty bucket.
-    _hashmap_seek_next(hm, iter);
-    if(iter->vnow == NULL) {
-        return NULL;
-    }
-    tmp = (hashmap_node *)iter->vnow;
-    return &tmp->pair;
+    iter->vnow = NULL;
+    iter->ended = 1;
+    return NULL;
 }
 
 void hashmap_iter_begin(const hashmap *hm, iterator *iter) {
@@ -2,8 +2,12 @@
 #define HASHMAP_H
 
 #include "utils/iterator.h"
+#include <stdint.h>
 #include <string.h>
 
+// Keys up to this size are stored in the table slot itself, and values up to this size in pooled blocks
+#define HASHMAP_INLINE_SIZE 16
+
 typedef struct hashmap_pair hashmap_pair;
 typedef struct hashmap_node hashmap_node;
 typedef struct hashmap hashmap;
@@ -16,16 +20,30 @@ struct hashmap_pair {
     void *value;
 };
 
+// Table slot. Empty slots have dist 0, otherwise dist is the distance from the home slot plus one.
 struct hashmap_node {
     hashmap_pair pair;
-    hashmap_node *next;
+    uint32_t hash;
+    uint32_t dist;
+    char key_data[HASHMAP_INLINE_SIZE];
 };
 
+// Open addressing with Robin Hood probing. Probes never wrap around: the slot array has capacity + tail
+// slots, plus an empty one at the end that stops the probe loops.
+//
+// Values never live in the slots, so the value pointers returned by hashmap_put, hashmap_get and the
+// iterator stay valid until that key is deleted or put again, like they did with chained buckets. Small
+// values are kept in blocks carved out of pages that are only freed with the map. Inline keys and the
+// hashmap_pair handed out by the iterator do move when the map is modified.
 struct hashmap {
-    hashmap_node **buckets;
+    hashmap_node *buckets;
     unsigned int capacity;
     unsigned int reserved;
+    unsigned int tail;
     hashmap_free_cb free_cb;
+    void *free_blocks;
+    void **pages;
+    unsigned int page_count;
 };
 
 void hashmap_create(hashmap *hm);
@@ -45,3 +45,13 @@ void file_read(FILE *handle, char *buffer, long size) {
 void file_close(FILE *handle) {
     fclose(handle);
 }
+
+bool file_get_info(const char *file_name, int64_t *mtime, int64_t *size) {
+    struct stat info;
+    if(stat(file_name, &info) != 0) {
+        return false;
+    }
+    *mtime = info.st_mtime;
+    *size = info.st_size;
+    return true;
+}
@@ -1,6 +1,8 @@
 #ifndef UTILS_IO_H
 #define UTILS_IO_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
 FILE *file_open(const char *file_name, const char *mode);
@@ -8,4 +10,9 @@ long file_size(FILE *handle);
 void file_read(FILE *handle, char *buffer, long size);
 void file_close(FILE *handle);
 
+/**
+ * Reads the modification time and size of a file without opening it. Returns false if the file does not exist.
+ */
+bool file_get_info(const char *file_name, int64_t *mtime, int64_t *size);
+
 #endif // UTILS_IO_H
@@ -0,0 +1,168 @@
+#include "utils/jobs.h"
+
+#include <SDL_atomic.h>
+#include <SDL_cpuinfo.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+
+#define MAX_WORKERS 4
+
+struct job {
+    job_run_cb run;
+    void *userdata;
+    SDL_atomic_t done;
+    job *next;
+};
+
+typedef struct job_pool {
+    SDL_mutex *lock;
+    SDL_cond *work;     // Signaled when a job is queued, or on close
+    SDL_cond *finished; // Signaled when a job is done
+    job *head;
+    job *tail;
+    bool stop;
+    int worker_count;
+    SDL_Thread *workers[MAX_WORKERS];
+} job_pool;
+
+static job_pool *pool = NULL;
+
+static void run_job(job *j) {
+    j->run(j->userdata);
+    SDL_AtomicSet(&j->done, 1);
+}
+
+static int worker_thread(void *userdata) {
+    SDL_LockMutex(pool->lock);
+    while(1) {
+        while(pool->head == NULL && !pool->stop) {
+            SDL_CondWait(pool->work, pool->lock);
+        }
+        job *j = pool->head;
+        if(j == NULL) {
+            break;
+        }
+        pool->head = j->next;
+        if(pool->head == NULL) {
+            pool->tail = NULL;
+        }
+        SDL_UnlockMutex(pool->lock);
+        run_job(j);
+        SDL_LockMutex(pool->lock);
+        SDL_CondBroadcast(pool->finished);
+    }
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+void jobs_init(int thread_count) {
+    if(pool != NULL) {
+        return;
+    }
+    if(thread_count <= 0) {
+        // Leave one core for the main thread.
+        thread_count = SDL_GetCPUCount() - 1;
+    }
+    thread_count = clamp(thread_count, 1, MAX_WORKERS);
+
+    pool = omf_calloc(1, sizeof(job_pool));
+    pool->lock = SDL_CreateMutex();
+    pool->work = SDL_CreateCond();
+    pool->finished = SDL_CreateCond();
+    for(int i = 0; i < thread_count; i++) {
+        pool->workers[i] = SDL_CreateThread(worker_thread, "job worker", NULL);
+        if(pool->workers[i] == NULL) {
+            log_warn("Unable to start job worker: %s", SDL_GetError());
+            break;
+        }
+        pool->worker_count++;
+    }
+    log_info("Job pool started with %d workers.", pool->worker_count);
+}
+
+void jobs_close(void) {
+    if(pool == NULL) {
+        return;
+    }
+    SDL_LockMutex(pool->lock);
+    pool->stop = true;
+    SDL_CondBroadcast(pool->work);
+    SDL_UnlockMutex(pool->lock);
+    for(int i = 0; i < pool->worker_count; i++) {
+        SDL_WaitThread(pool->workers[i], NULL);
+    }
+
+    // Without workers there can still be queued jobs; run them here so that nobody waits forever.
+    while(pool->head != NULL) {
+        job *j = pool->head;
+        pool->head = j->next;
+        run_job(j);
+    }
+    SDL_DestroyCond(pool->finished);
+    SDL_DestroyCond(pool->work);
+    SDL_DestroyMutex(pool->lock);
+    omf_free(pool);
+}
+
+void jobs_after_fork(void) {
+    if(pool == NULL) {
+        return;
+    }
+    // The lock may have been held by a worker that was not copied into this process.
+    pool->lock = SDL_CreateMutex();
+    pool->worker_count = 0;
+    while(pool->head != NULL) {
+        job *j = pool->head;
+        pool->head = j->next;
+        run_job(j);
+    }
+    pool->tail = NULL;
+}
+
+job *job_submit(job_run_cb run, void *userdata) {
+    job *j = omf_calloc(1, sizeof(job));
+    j->run = run;
+    j->userdata = userdata;
+    SDL_AtomicSet(&j->done, 0);
+    if(pool == NULL || pool->worker_count == 0) {
+        run_job(j);
+        return j;
+    }
+    SDL_LockMutex(pool->lock);
+    if(pool->tail != NULL) {
+        pool->tail->next = j;
+    } else {
+        pool->head = j;
+    }
+    pool->tail = j;
+    SDL_CondSignal(pool->work);
+    SDL_UnlockMutex(pool->lock);
+    return j;
+}
+
+bool job_is_done(job *j) {
+    return SDL_AtomicGet(&j->done) != 0;
+}
+
+void job_wait(job *j) {
+    if(job_is_done(j)) {
+        return;
+    }
+    SDL_LockMutex(pool->lock);
+    while(!job_is_done(j)) {
+        SDL_CondWait(pool->finished, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+}
+
+void job_free(job *j) {
+    if(j == NULL) {
+        return;
+    }
+    job_wait(j);
+    omf_free(j);
+}
@@ -0,0 +1,50 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdbool.h>
+
+/**
+ * Small pool of worker threads for loading and decoding data off the main thread.
+ *
+ * Jobs must only touch data that nothing else uses until the job is done. The submitter picks up the
+ * results with job_wait() or after job_is_done() returns true, so all shared state is only modified on
+ * the submitting thread.
+ */
+
+typedef struct job job;
+typedef void (*job_run_cb)(void *userdata);
+
+/**
+ * Starts the worker threads. With zero threads, a count is picked from the number of CPUs.
+ * Until this is called, jobs run inline in job_submit().
+ */
+void jobs_init(int thread_count);
+
+/**
+ * Finishes all queued jobs and stops the worker threads.
+ */
+void jobs_close(void);
+
+/**
+ * Call in the child after fork(). The worker threads do not exist in the child, so jobs run inline there.
+ */
+void jobs_after_fork(void);
+
+/**
+ * Queues a job. The returned handle must be freed with job_free().
+ */
+job *job_submit(job_run_cb run, void *userdata);
+
+bool job_is_done(job *j);
+
+/**
+ * Blocks until the job has run.
+ */
+void job_wait(job *j);
+
+/**
+ * Waits for the job and frees the handle.
+ */
+void job_free(job *j);
+
+#endif // JOBS_H
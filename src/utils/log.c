@@ -1,29 +1,68 @@
 #include "utils/log.h"
 
+#include <SDL_atomic.h>
 #include <SDL_mutex.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #include "utils/allocator.h"
 
 #define MAX_TARGETS 3
+#define MAX_RINGS 16
+#define RING_SIZE 256 // Records per thread, must be a power of two
+#define RECORD_TEXT_SIZE 500
+#define WRITER_INTERVAL_MS 20
 
 typedef struct log_target {
     FILE *fp;
     log_level level;
     bool colors;
     bool close;
-    SDL_mutex *lock;
 } log_target;
 
+typedef struct log_record {
+    int seq;
+    log_level level;
+    time_t time;
+    char text[RECORD_TEXT_SIZE];
+} log_record;
+
+/**
+ * Single producer, single consumer ring of records. The owning thread only moves the tail, and the writer
+ * thread only moves the head.
+ */
+typedef struct log_ring {
+    SDL_atomic_t owned;
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+    log_record *records;
+} log_ring;
+
 typedef struct log_state {
     bool colors;
     log_level level;
     log_target targets[MAX_TARGETS];
     int target_count;
     uint32_t tick;
+
+    SDL_TLSID ring_id;
+    SDL_atomic_t seq;
+    SDL_atomic_t dropped;
+    SDL_atomic_t stop;
+    SDL_atomic_t busy;
+    SDL_sem *wake;
+    SDL_mutex *write_lock; // Held while writing to targets
+    SDL_Thread *writer;
+
+    // Writer thread only
+    time_t last_time;
+    char last_stamp[16];
+    unsigned int reported_drops;
 } log_state;
 
 static const char *level_names[] = {
@@ -42,12 +81,141 @@ static const char *level_colors[] = {
 
 static log_state *state = NULL;
 
+// Rings live outside of the state, so that thread exit destructors never touch freed memory.
+static log_ring rings[MAX_RINGS];
+
+static void release_ring(void *ptr) {
+    log_ring *ring = ptr;
+    SDL_AtomicSet(&ring->owned, 0);
+}
+
+/**
+ * Finds the ring of the calling thread, or claims a free one for it.
+ */
+static log_ring *get_ring(void) {
+    log_ring *ring = SDL_TLSGet(state->ring_id);
+    if(ring != NULL) {
+        return ring;
+    }
+    for(int i = 0; i < MAX_RINGS; i++) {
+        if(SDL_AtomicCAS(&rings[i].owned, 0, 1)) {
+            ring = &rings[i];
+            SDL_TLSSet(state->ring_id, ring, release_ring);
+            return ring;
+        }
+    }
+    return NULL;
+}
+
+static bool ring_is_empty(log_ring *ring) {
+    return SDL_AtomicGet(&ring->head) == SDL_AtomicGet(&ring->tail);
+}
+
+// Sequence numbers wrap around, compare them by distance
+static inline bool seq_before(int a, int b) {
+    return (int)((unsigned int)a - (unsigned int)b) < 0;
+}
+
+static void format_timestamp(time_t t) {
+    if(t != state->last_time || state->last_stamp[0] == 0) {
+        struct tm *tm = localtime(&t);
+        strftime(state->last_stamp, sizeof(state->last_stamp), "%H:%M:%S", tm);
+        state->last_stamp[sizeof(state->last_stamp) - 1] = 0;
+        state->last_time = t;
+    }
+}
+
+static void write_line(log_level level, time_t t, const char *text) {
+    log_target *target;
+    format_timestamp(t);
+    for(int i = 0; i < state->target_count; i++) {
+        target = &state->targets[i];
+        if(level < target->level) {
+            continue;
+        }
+        if(state->colors && target->colors) {
+            fprintf(target->fp, "%s %s%-5s\x1b[0m \x1b[0m %s\n", state->last_stamp, level_colors[level],
+                    level_names[level], text);
+        } else {
+            fprintf(target->fp, "%s %-5s %s\n", state->last_stamp, level_names[level], text);
+        }
+    }
+}
+
+static void flush_targets(void) {
+    for(int i = 0; i < state->target_count; i++) {
+        fflush(state->targets[i].fp);
+    }
+}
+
+/**
+ * Writes out everything that is in the rings, oldest record first, and then flushes the targets once.
+ */
+static void drain_rings(void) {
+    SDL_LockMutex(state->write_lock);
+    SDL_AtomicSet(&state->busy, 1);
+    bool wrote = false;
+    while(true) {
+        log_ring *oldest = NULL;
+        const log_record *oldest_record = NULL;
+        for(int i = 0; i < MAX_RINGS; i++) {
+            log_ring *ring = &rings[i];
+            if(ring_is_empty(ring)) {
+                continue;
+            }
+            const log_record *record = &ring->records[SDL_AtomicGet(&ring->head) & (RING_SIZE - 1)];
+            if(oldest_record == NULL || seq_before(record->seq, oldest_record->seq)) {
+                oldest = ring;
+                oldest_record = record;
+            }
+        }
+        if(oldest == NULL) {
+            break;
+        }
+        write_line(oldest_record->level, oldest_record->time, oldest_record->text);
+        SDL_AtomicAdd(&oldest->head, 1);
+        wrote = true;
+    }
+
+    unsigned int dropped = SDL_AtomicGet(&state->dropped);
+    if(dropped != state->reported_drops) {
+        char text[64];
+        unsigned int count = dropped - state->reported_drops;
+        snprintf(text, sizeof(text), "%u log messages dropped, log buffer was full.", count);
+        write_line(LOG_WARN, time(NULL), text);
+        state->reported_drops = dropped;
+        wrote = true;
+    }
+    if(wrote) {
+        flush_targets();
+    }
+    SDL_AtomicSet(&state->busy, 0);
+    SDL_UnlockMutex(state->write_lock);
+}
+
+static int writer_thread(void *userdata) {
+    while(!SDL_AtomicGet(&state->stop)) {
+        SDL_SemWaitTimeout(state->wake, WRITER_INTERVAL_MS);
+        drain_rings();
+    }
+    return 0;
+}
+
 void log_init(void) {
     assert(state == NULL);
     state = omf_calloc(1, sizeof(log_state));
     state->level = LOG_DEBUG;
     state->colors = false;
     state->target_count = 0;
+    state->ring_id = SDL_TLSCreate();
+    state->wake = SDL_CreateSemaphore(0);
+    state->write_lock = SDL_CreateMutex();
+    for(int i = 0; i < MAX_RINGS; i++) {
+        SDL_AtomicSet(&rings[i].owned, 0);
+        SDL_AtomicSet(&rings[i].head, 0);
+        SDL_AtomicSet(&rings[i].tail, 0);
+    }
+    state->writer = SDL_CreateThread(writer_thread, "log writer", NULL);
 }
 
 static void close_targets(void) {
@@ -58,16 +226,25 @@ static void close_targets(void) {
         if(target->close) {
             fclose(target->fp);
         }
-        if(target->lock) {
-            SDL_DestroyMutex(target->lock);
-        }
     }
     state->target_count = 0;
 }
 
 void log_close(void) {
     if(state != NULL) {
+        if(state->writer != NULL) {
+            SDL_AtomicSet(&state->stop, 1);
+            SDL_SemPost(state->wake);
+            SDL_WaitThread(state->writer, NULL);
+            state->writer = NULL;
+        }
+        drain_rings();
         close_targets();
+        for(int i = 0; i < MAX_RINGS; i++) {
+            omf_free(rings[i].records);
+        }
+        SDL_DestroySemaphore(state->wake);
+        SDL_DestroyMutex(state->write_lock);
         omf_free(state);
     }
 }
@@ -85,12 +262,13 @@ void log_set_colors(bool toggle) {
 static void log_add_fp(FILE *fp, bool close, log_level level, bool colors) {
     assert(state != NULL);
     assert(state->target_count < MAX_TARGETS - 1);
+    SDL_LockMutex(state->write_lock);
     log_target *target = &state->targets[state->target_count++];
     target->close = close;
     target->fp = fp;
     target->level = level;
     target->colors = colors;
-    target->lock = SDL_CreateMutex();
+    SDL_UnlockMutex(state->write_lock);
 }
 
 void log_add_stderr(log_level level, bool colors) {
@@ -104,44 +282,83 @@ void log_add_file(const char *filename, log_level level) {
     }
 }
 
-static void format_timestamp(char *buffer, size_t len) {
-    time_t t = time(NULL);
-    struct tm *tm = localtime(&t);
-    strftime(buffer, len, "%H:%M:%S", tm);
-    buffer[len - 1] = 0;
-}
-
 void log_msg(log_level level, const char *fmt, ...) {
     assert(state != NULL);
-    char dt[16];
     va_list args;
-    log_target *target;
-    const char *color = level_colors[level];
-    const char *name = level_names[level];
 
     if(level < state->level) {
         return;
     }
 
-    format_timestamp(dt, 16);
-    for(int i = 0; i < state->target_count; i++) {
-        target = &state->targets[i];
-        if(level < target->level) {
-            continue;
-        }
-        if(SDL_LockMutex(target->lock) != 0) {
-            continue;
+    log_ring *ring = get_ring();
+    if(ring == NULL) {
+        SDL_AtomicAdd(&state->dropped, 1);
+        return;
+    }
+    if(ring->records == NULL) {
+        ring->records = omf_calloc(RING_SIZE, sizeof(log_record));
+    }
+
+    int tail = SDL_AtomicGet(&ring->tail);
+    int used = tail - SDL_AtomicGet(&ring->head);
+    if(used >= RING_SIZE && level >= LOG_ERROR) {
+        // Errors are not dropped, make room for them.
+        drain_rings();
+        used = 0;
+    }
+    if(used >= RING_SIZE) {
+        SDL_AtomicAdd(&state->dropped, 1);
+        SDL_SemPost(state->wake);
+        return;
+    }
+
+    log_record *record = &ring->records[tail & (RING_SIZE - 1)];
+    record->level = level;
+    record->time = time(NULL);
+    va_start(args, fmt);
+    vsnprintf(record->text, sizeof(record->text), fmt, args);
+    va_end(args);
+    record->seq = SDL_AtomicAdd(&state->seq, 1);
+    SDL_AtomicSet(&ring->tail, tail + 1);
+
+    if(state->writer == NULL || level >= LOG_ERROR) {
+        // No writer thread, write out right away. Errors are written out right away too, since they are
+        // often followed by abort() and would never reach the writer thread.
+        drain_rings();
+    } else if(level >= LOG_WARN || used == RING_SIZE / 2) {
+        SDL_SemPost(state->wake);
+    }
+}
+
+void log_flush(void) {
+    assert(state != NULL);
+    if(state->writer == NULL) {
+        drain_rings();
+        return;
+    }
+    SDL_SemPost(state->wake);
+    while(true) {
+        bool empty = true;
+        for(int i = 0; i < MAX_RINGS; i++) {
+            empty = empty && ring_is_empty(&rings[i]);
         }
-        if(state->colors && target->colors) {
-            fprintf(target->fp, "%s %s%-5s\x1b[0m \x1b[0m ", dt, color, name);
-        } else {
-            fprintf(target->fp, "%s %-5s ", dt, name);
+        if(empty && !SDL_AtomicGet(&state->busy)) {
+            return;
         }
-        va_start(args, fmt);
-        vfprintf(target->fp, fmt, args);
-        va_end(args);
-        fprintf(target->fp, "\n");
-        fflush(target->fp);
-        SDL_UnlockMutex(target->lock);
+        SDL_Delay(1);
     }
 }
+
+void log_after_fork(void) {
+    assert(state != NULL);
+    // The writer thread and the locks it may have held were not copied into this process.
+    state->writer = NULL;
+    state->write_lock = SDL_CreateMutex();
+    SDL_AtomicSet(&state->busy, 0);
+    drain_rings();
+}
+
+unsigned int log_dropped_count(void) {
+    assert(state != NULL);
+    return SDL_AtomicGet(&state->dropped);
+}
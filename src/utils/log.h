@@ -12,10 +12,29 @@ typedef enum log_level
     LOG_ERROR
 } log_level;
 
-#define log_debug(...) log_msg(LOG_DEBUG, __VA_ARGS__)
-#define log_info(...) log_msg(LOG_INFO, __VA_ARGS__)
-#define log_warn(...) log_msg(LOG_WARN, __VA_ARGS__)
-#define log_error(...) log_msg(LOG_ERROR, __VA_ARGS__)
+/**
+ * Messages below this level are compiled out, including the evaluation of their arguments. Release builds
+ * run with LOG_INFO anyway, so debug messages are dropped there by default.
+ */
+#ifndef LOG_MIN_LEVEL
+#if defined(DEBUGMODE)
+#define LOG_MIN_LEVEL LOG_DEBUG
+#else
+#define LOG_MIN_LEVEL LOG_INFO
+#endif
+#endif
+
+#define LOG_AT_LEVEL(level, ...)                                                                                       \
+    do {                                                                                                               \
+        if((level) >= LOG_MIN_LEVEL) {                                                                                 \
+            log_msg((level), __VA_ARGS__);                                                                             \
+        }                                                                                                              \
+    } while(0)
+
+#define log_debug(...) LOG_AT_LEVEL(LOG_DEBUG, __VA_ARGS__)
+#define log_info(...) LOG_AT_LEVEL(LOG_INFO, __VA_ARGS__)
+#define log_warn(...) LOG_AT_LEVEL(LOG_WARN, __VA_ARGS__)
+#define log_error(...) LOG_AT_LEVEL(LOG_ERROR, __VA_ARGS__)
 
 void log_init(void);
 void log_close(void);
@@ -25,6 +44,27 @@ void log_set_colors(bool toggle);
 void log_add_stderr(log_level level, bool colors);
 void log_add_file(const char *filename, log_level level);
 
+/**
+ * Formats the message into a per-thread ring buffer. A background thread writes the messages out in batches.
+ * If the ring is full, the message is dropped and counted. Errors are never dropped, and are written out
+ * before this returns, so that they survive a following abort().
+ */
 void log_msg(log_level level, const char *fmt, ...);
 
+/**
+ * Blocks until every message logged so far has been written out.
+ */
+void log_flush(void);
+
+/**
+ * Call in the child after fork(). The writer thread does not exist in the child, so the child writes
+ * its messages out directly instead.
+ */
+void log_after_fork(void);
+
+/**
+ * Number of messages dropped because a ring buffer was full.
+ */
+unsigned int log_dropped_count(void);
+
 #endif // LOG_H
@@ -87,8 +87,8 @@ error_0:
 
 #else // PNG_FOUND
 
-bool png_read_paletted(const char *filename, unsigned char *dst) {
-    PERROR("PNG reading is not supported in current build!");
+bool read_paletted_png(const char *filename, unsigned char *dst) {
+    log_error("PNG reading is not supported in current build!");
     return false;
 }
 
@@ -60,13 +60,13 @@ bool write_paletted_png(const char *filename, int w, int h, const vga_palette *p
 
 #else // PNG_FOUND
 
-bool png_write_rgb(const char *filename, int w, int h, const unsigned char *data, bool has_alpha, bool flip) {
-    PERROR("PNG writing is not supported in current build!");
+bool write_rgb_png(const char *filename, int w, int h, const unsigned char *data, bool has_alpha, bool flip) {
+    log_error("PNG writing is not supported in current build!");
     return false;
 }
 
-bool png_write_paletted(const char *filename, int w, int h, const vga_palette *pal, const unsigned char *data) {
-    PERROR("PNG writing is not supported in current build!");
+bool write_paletted_png(const char *filename, int w, int h, const vga_palette *pal, const unsigned char *data) {
+    log_error("PNG writing is not supported in current build!");
     return false;
 }
 
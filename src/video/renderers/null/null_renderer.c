@@ -65,6 +65,11 @@ static void signal_scene_change(void *userdata) {
 }
 static void signal_draw_atlas(void *userdata, bool toggle) {
 }
+static void signal_surface_released(void *userdata, unsigned int guid) {
+}
+static bool get_atlas_stats(void *userdata, unsigned int *items, float *occupancy, float *fragmentation) {
+    return false;
+}
 
 static void renderer_create(renderer *gl3_renderer) {
 }
@@ -95,4 +100,6 @@ void null_renderer_set_callbacks(renderer *gl3_renderer) {
     gl3_renderer->capture_screen = capture_screen;
     gl3_renderer->signal_scene_change = signal_scene_change;
     gl3_renderer->signal_draw_atlas = signal_draw_atlas;
+    gl3_renderer->signal_surface_released = signal_surface_released;
+    gl3_renderer->get_atlas_stats = get_atlas_stats;
 }
@@ -203,6 +203,7 @@ static void move_target(void *userdata, int x, int y) {
 
 static void render_prepare(void *userdata) {
     gl3_context *ctx = userdata;
+    atlas_flush_released(ctx->atlas);
     object_array_prepare(ctx->objects);
 }
 
@@ -348,6 +349,26 @@ static void signal_draw_atlas(void *userdata, bool toggle) {
     ctx->draw_atlas = toggle;
 }
 
+static void signal_surface_released(void *userdata, unsigned int guid) {
+    gl3_context *ctx = userdata;
+    if(ctx->atlas != NULL) {
+        atlas_release(ctx->atlas, guid);
+    }
+}
+
+static bool get_atlas_stats(void *userdata, unsigned int *items, float *occupancy, float *fragmentation) {
+    gl3_context *ctx = userdata;
+    if(ctx->atlas == NULL) {
+        return false;
+    }
+    texture_atlas_stats stats;
+    atlas_get_stats(ctx->atlas, &stats);
+    *items = stats.items;
+    *occupancy = stats.occupancy;
+    *fragmentation = stats.fragmentation;
+    return true;
+}
+
 static void renderer_create(renderer *gl3_renderer) {
     gl3_renderer->ctx = omf_calloc(1, sizeof(gl3_context));
 }
@@ -380,4 +401,6 @@ void gl3_renderer_set_callbacks(renderer *gl3_renderer) {
     gl3_renderer->capture_screen = capture_screen;
     gl3_renderer->signal_scene_change = signal_scene_change;
     gl3_renderer->signal_draw_atlas = signal_draw_atlas;
+    gl3_renderer->signal_surface_released = signal_surface_released;
+    gl3_renderer->get_atlas_stats = get_atlas_stats;
 }
@@ -8,7 +8,10 @@
 #include "video/renderers/opengl3/helpers/texture.h"
 #include "video/renderers/opengl3/helpers/texture_atlas.h"
 
-// WIP
+// Rebuild the atlas when at least this much of the free space is outside of the largest free block,
+// and the free space is split into at least this many blocks.
+#define DEFRAG_FRAGMENTATION 0.75f
+#define DEFRAG_MIN_ZONES 32
 
 typedef struct {
     uint16_t x;
@@ -21,26 +24,36 @@ static_assert(8 == sizeof(zone), "zone should pack into 8 bytes");
 typedef struct texture_atlas {
     hashmap items;
     vector free_space;
+    vector released; // Areas of released surfaces, returned to free space at the start of the next frame.
     GLuint texture_id;
     uint16_t w;
     uint16_t h;
     GLuint tex_unit;
+    unsigned int used_area;
+    unsigned int defrags;
+    bool insert_failed;
 } texture_atlas;
 
 static inline int zone_perimeter(zone *zone) {
     return zone->w * 2 + zone->h * 2;
 }
 
-texture_atlas *atlas_create(GLuint tex_unit, uint16_t width, uint16_t height) {
+texture_atlas *atlas_create_unbacked(uint16_t width, uint16_t height) {
     texture_atlas *atlas = omf_calloc(1, sizeof(texture_atlas));
     hashmap_create(&atlas->items);
     vector_create(&atlas->free_space, sizeof(zone));
+    vector_create(&atlas->released, sizeof(zone));
     atlas->w = width;
     atlas->h = height;
-    atlas->tex_unit = tex_unit;
-    atlas->texture_id = texture_create(tex_unit, width, height, GL_R8, GL_RED);
     zone item = {0, 0, width, height};
     vector_append(&atlas->free_space, &item);
+    return atlas;
+}
+
+texture_atlas *atlas_create(GLuint tex_unit, uint16_t width, uint16_t height) {
+    texture_atlas *atlas = atlas_create_unbacked(width, height);
+    atlas->tex_unit = tex_unit;
+    atlas->texture_id = texture_create(tex_unit, width, height, GL_R8, GL_RED);
     log_debug("Texture atlas %dx%d created", width, height);
     return atlas;
 }
@@ -50,7 +63,10 @@ void atlas_free(texture_atlas **atlas) {
     if(obj != NULL) {
         hashmap_free(&obj->items);
         vector_free(&obj->free_space);
-        texture_free(obj->tex_unit, obj->texture_id);
+        vector_free(&obj->released);
+        if(obj->texture_id != 0) {
+            texture_free(obj->tex_unit, obj->texture_id);
+        }
         omf_free(obj);
         *atlas = NULL;
         log_debug("Texture atlas freed");
@@ -129,7 +145,10 @@ bool atlas_insert(texture_atlas *atlas, const char *bytes, uint16_t w, uint16_t
     zone free;
     int index;
     if(!find_free_space(atlas, w, h, &index, &free)) {
-        log_error("Texture atlas has no room for %dx%d area", w, h);
+        if(!atlas->insert_failed) {
+            log_error("Texture atlas has no room for %dx%d area", w, h);
+        }
+        atlas->insert_failed = true;
         return false;
     }
 
@@ -157,7 +176,10 @@ bool atlas_insert(texture_atlas *atlas, const char *bytes, uint16_t w, uint16_t
     }
 
     // Split found, add the area to the atlas.
-    texture_update(atlas->tex_unit, atlas->texture_id, free.x, free.y, w, h, GL_RED, bytes);
+    if(atlas->texture_id != 0) {
+        texture_update(atlas->tex_unit, atlas->texture_id, free.x, free.y, w, h, GL_RED, bytes);
+    }
+    atlas->used_area += w * h;
     *nx = free.x;
     *ny = free.y;
     return true;
@@ -192,7 +214,119 @@ bool atlas_get(texture_atlas *atlas, const surface *surface, uint16_t *x, uint16
 void atlas_reset(texture_atlas *atlas) {
     hashmap_clear(&atlas->items);
     vector_clear(&atlas->free_space);
+    vector_clear(&atlas->released);
     zone item = {0, 0, atlas->w, atlas->h};
     vector_append(&atlas->free_space, &item);
+    atlas->used_area = 0;
+    atlas->insert_failed = false;
     log_info("Texture atlas reset");
 }
+
+void atlas_release(texture_atlas *atlas, unsigned int guid) {
+    zone *coords;
+    if(hashmap_get_int(&atlas->items, guid, (void **)&coords, NULL) != 0) {
+        return;
+    }
+    // Objects queued earlier in this frame may still sample this area, so it is only reused from the next frame.
+    vector_append(&atlas->released, coords);
+    atlas->used_area -= coords->w * coords->h;
+    hashmap_del_int(&atlas->items, guid);
+}
+
+/**
+ * Merges two free areas if they share a full edge.
+ */
+static bool merge_zones(zone *a, const zone *b) {
+    if(a->x == b->x && a->w == b->w) {
+        if(a->y + a->h == b->y) {
+            a->h += b->h;
+            return true;
+        }
+        if(b->y + b->h == a->y) {
+            a->y = b->y;
+            a->h += b->h;
+            return true;
+        }
+    }
+    if(a->y == b->y && a->h == b->h) {
+        if(a->x + a->w == b->x) {
+            a->w += b->w;
+            return true;
+        }
+        if(b->x + b->w == a->x) {
+            a->x = b->x;
+            a->w += b->w;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Merges neighbouring free areas until no more merges are possible.
+ */
+static void coalesce_free_space(texture_atlas *atlas) {
+    bool merged = true;
+    while(merged) {
+        merged = false;
+        for(unsigned int i = 0; i < vector_size(&atlas->free_space); i++) {
+            zone *a = vector_get(&atlas->free_space, i);
+            for(unsigned int k = i + 1; k < vector_size(&atlas->free_space); k++) {
+                if(merge_zones(a, vector_get(&atlas->free_space, k))) {
+                    vector_delete_at(&atlas->free_space, k);
+                    merged = true;
+                    k--;
+                }
+            }
+        }
+    }
+    vector_sort(&atlas->free_space, space_sort);
+}
+
+static float free_space_fragmentation(const texture_atlas *atlas) {
+    unsigned int total = 0, largest = 0;
+    iterator it;
+    zone *item;
+    vector_iter_begin(&atlas->free_space, &it);
+    foreach(it, item) {
+        unsigned int area = item->w * item->h;
+        total += area;
+        if(area > largest) {
+            largest = area;
+        }
+    }
+    if(total == 0) {
+        return 0.0f;
+    }
+    return 1.0f - (float)largest / total;
+}
+
+void atlas_flush_released(texture_atlas *atlas) {
+    if(vector_size(&atlas->released) > 0) {
+        iterator it;
+        zone *item;
+        vector_iter_begin(&atlas->released, &it);
+        foreach(it, item) {
+            vector_append(&atlas->free_space, item);
+        }
+        vector_clear(&atlas->released);
+        coalesce_free_space(atlas);
+    }
+
+    // Surfaces that are still alive are uploaded again when they are next drawn.
+    if(atlas->insert_failed || (vector_size(&atlas->free_space) >= DEFRAG_MIN_ZONES &&
+                                free_space_fragmentation(atlas) >= DEFRAG_FRAGMENTATION)) {
+        log_debug("Texture atlas defragmented: %u items, %u free areas", hashmap_reserved(&atlas->items),
+                  vector_size(&atlas->free_space));
+        atlas_reset(atlas);
+        atlas->defrags++;
+    }
+}
+
+void atlas_get_stats(const texture_atlas *atlas, texture_atlas_stats *stats) {
+    stats->items = hashmap_reserved(&atlas->items);
+    stats->free_areas = vector_size(&atlas->free_space);
+    stats->defrags = atlas->defrags;
+    stats->occupancy = (float)atlas->used_area / (atlas->w * atlas->h);
+    stats->fragmentation = free_space_fragmentation(atlas);
+}
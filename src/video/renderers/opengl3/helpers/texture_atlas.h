@@ -7,11 +7,37 @@
 
 typedef struct texture_atlas texture_atlas;
 
+typedef struct texture_atlas_stats {
+    unsigned int items;
+    unsigned int free_areas;
+    unsigned int defrags;
+    float occupancy;     // Fraction of the atlas that is in use
+    float fragmentation; // Fraction of the free space that is outside of the largest free block
+} texture_atlas_stats;
+
 texture_atlas *atlas_create(GLuint tex_unit, uint16_t width, uint16_t height);
+
+/**
+ * Creates an atlas that only keeps track of the space, without a texture behind it. Does not need a GL context.
+ */
+texture_atlas *atlas_create_unbacked(uint16_t width, uint16_t height);
 void atlas_free(texture_atlas **atlas);
 
 bool atlas_insert(texture_atlas *atlas, const char *bytes, uint16_t w, uint16_t h, uint16_t *nx, uint16_t *ny);
 bool atlas_get(texture_atlas *atlas, const surface *surface, uint16_t *x, uint16_t *y, uint16_t *w, uint16_t *h);
 void atlas_reset(texture_atlas *atlas);
 
+/**
+ * Drops the area of a surface from the atlas. The area becomes free on the next atlas_flush_released() call.
+ */
+void atlas_release(texture_atlas *atlas, unsigned int guid);
+
+/**
+ * Returns released areas to the free space, and rebuilds the atlas if it is too fragmented or ran out of room.
+ * Call at the start of a frame, before anything is drawn.
+ */
+void atlas_flush_released(texture_atlas *atlas);
+
+void atlas_get_stats(const texture_atlas *atlas, texture_atlas_stats *stats);
+
 #endif // TEXTURE_ATLAS_H
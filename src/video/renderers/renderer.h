@@ -44,6 +44,10 @@ typedef void (*capture_screen_fn)(void *ctx, video_screenshot_signal screenshot_
 // Extra signals, implemented only if renderer implementation supports and/or requires it
 typedef void (*signal_scene_change_fn)(void *ctx);
 typedef void (*signal_draw_atlas_fn)(void *ctx, bool toggle);
+typedef void (*signal_surface_released_fn)(void *ctx, unsigned int guid);
+
+// Texture atlas statistics, implemented only by renderers that have an atlas.
+typedef bool (*get_atlas_stats_fn)(void *ctx, unsigned int *items, float *occupancy, float *fragmentation);
 
 struct renderer {
     is_available_fn is_available;
@@ -71,6 +75,8 @@ struct renderer {
 
     signal_scene_change_fn signal_scene_change;
     signal_draw_atlas_fn signal_draw_atlas;
+    signal_surface_released_fn signal_surface_released;
+    get_atlas_stats_fn get_atlas_stats;
 
     void *ctx;
 };
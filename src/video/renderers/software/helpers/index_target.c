@@ -0,0 +1,249 @@
+#include <math.h>
+#include <string.h>
+
+#include "utils/allocator.h"
+#include "video/enums.h"
+#include "video/renderers/software/helpers/index_target.h"
+#include "video/renderers/software/helpers/row_blit.h"
+
+typedef enum
+{
+    WRITE_SET,
+    WRITE_ADD,
+    WRITE_REMAP,
+} write_mode;
+
+typedef struct index_target {
+    int w;
+    int h;
+    uint8_t *index;  // R: palette index
+    uint8_t *remap;  // G: remap table
+    uint8_t *rounds; // B: remap rounds
+    uint8_t *add;    // A: added to index before remapping
+    uint8_t *levels; // Lowest opacity at which each pixel is drawn
+    uint8_t *raw;    // Row scratch buffers
+    uint8_t *vals;
+    uint8_t *mask;
+    int *cols;
+} index_target;
+
+static inline int clamp_int(int value, int low, int high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+/**
+ * Opacity decimation noise from palette.frag. The value only depends on the pixel position, so it is
+ * turned into an opacity level once, and drawing just compares bytes. This is evaluated in double precision
+ * so that the pattern does not depend on the float accuracy of the C library.
+ */
+static uint8_t opacity_level(int x, int y, int h) {
+    const double phi = 1.61803398874989484820459;
+    double vx = x + 0.5;
+    double vy = (h - 1 - y) + 0.5; // gl_FragCoord has its origin at the bottom left corner
+    double dx = vx * phi - vx;
+    double dy = vy * phi - vy;
+    double noise = tan(sqrt(dx * dx + dy * dy)) * vx;
+    noise = noise - floor(noise);
+    if(isnan(noise)) {
+        return 0;
+    }
+    for(int level = 0; level < 255; level++) {
+        if(noise <= level / 255.0) {
+            return level;
+        }
+    }
+    return 255;
+}
+
+index_target *index_target_create(int w, int h) {
+    index_target *target = omf_calloc(1, sizeof(index_target));
+    target->w = w;
+    target->h = h;
+    target->index = omf_calloc(w * h, 1);
+    target->remap = omf_calloc(w * h, 1);
+    target->rounds = omf_calloc(w * h, 1);
+    target->add = omf_calloc(w * h, 1);
+    target->levels = omf_calloc(w * h, 1);
+    target->raw = omf_calloc(w, 1);
+    target->vals = omf_calloc(w, 1);
+    target->mask = omf_calloc(w, 1);
+    target->cols = omf_calloc(w, sizeof(int));
+    for(int y = 0; y < h; y++) {
+        for(int x = 0; x < w; x++) {
+            target->levels[y * w + x] = opacity_level(x, y, h);
+        }
+    }
+    return target;
+}
+
+void index_target_free(index_target **target) {
+    index_target *obj = *target;
+    if(obj != NULL) {
+        omf_free(obj->index);
+        omf_free(obj->remap);
+        omf_free(obj->rounds);
+        omf_free(obj->add);
+        omf_free(obj->levels);
+        omf_free(obj->raw);
+        omf_free(obj->vals);
+        omf_free(obj->mask);
+        omf_free(obj->cols);
+        omf_free(obj);
+        *target = NULL;
+    }
+}
+
+void index_target_clear(index_target *target) {
+    size_t size = target->w * target->h;
+    memset(target->index, 0, size);
+    memset(target->remap, 0, size);
+    memset(target->rounds, 0, size);
+    memset(target->add, 0, size);
+}
+
+/**
+ * Builds the per-draw lookup from a source index to the value written to the target. This folds the palette
+ * offset and limit, the sprite remap, the mask option and the output encoding of the blend mode together.
+ *
+ * @return true if the lookup is an identity, and can be skipped.
+ */
+static bool build_lookup(uint8_t *lut, const vga_remap_tables *remaps, write_mode mode, int remap_offset,
+                         int palette_offset, int palette_limit, unsigned int options) {
+    const vga_remap_table *table = &remaps->tables[clamp_int(remap_offset, 0, VGA_REMAP_COUNT - 1)];
+    bool identity = true;
+    for(int i = 0; i < 256; i++) {
+        int value = i;
+        if(value <= palette_limit) {
+            value = clamp_int(value + palette_offset, 0, palette_limit);
+        }
+        value = clamp_int(value, 0, 255);
+        if(options & REMAP_SPRITE) {
+            value = table->data[value];
+        }
+        if(options & SPRITE_MASK) {
+            value = 1;
+        }
+        if(mode == WRITE_REMAP) {
+            value = clamp_int(remap_offset + value, 0, 255);
+        } else if(mode == WRITE_ADD) {
+            value = clamp_int(value * 60, 0, 255);
+        }
+        lut[i] = value;
+        identity = identity && value == i;
+    }
+    return identity;
+}
+
+void index_target_draw(index_target *target, const vga_remap_tables *remaps, const surface *src, const SDL_Rect *dst,
+                       int remap_offset, int remap_rounds, int palette_offset, int palette_limit, int opacity,
+                       unsigned int flip_mode, unsigned int options) {
+    if(dst->w <= 0 || dst->h <= 0 || src->w <= 0 || src->h <= 0 || opacity < 0) {
+        return;
+    }
+    int x0 = clamp_int(dst->x, 0, target->w);
+    int x1 = clamp_int(dst->x + dst->w, 0, target->w);
+    int y0 = clamp_int(dst->y, 0, target->h);
+    int y1 = clamp_int(dst->y + dst->h, 0, target->h);
+    if(x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    write_mode mode = WRITE_SET;
+    if(remap_rounds > 0) {
+        mode = WRITE_REMAP;
+    } else if(options & SPRITE_INDEX_ADD) {
+        mode = WRITE_ADD;
+    }
+    uint8_t rounds = clamp_int(remap_rounds, 0, 255);
+    uint8_t lut[256];
+    bool identity = build_lookup(lut, remaps, mode, remap_offset, palette_offset, palette_limit, options);
+
+    // Nearest neighbour sampling at pixel centers, like the GL rasterizer does.
+    int n = x1 - x0;
+    bool flip_x = flip_mode & FLIP_HORIZONTAL;
+    bool flip_y = flip_mode & FLIP_VERTICAL;
+    bool direct = dst->w == src->w && !flip_x;
+    if(!direct) {
+        for(int i = 0; i < n; i++) {
+            int64_t u = x0 + i - dst->x;
+            int sx = (int)(((2 * u + 1) * src->w) / (2 * (int64_t)dst->w));
+            target->cols[i] = flip_x ? src->w - 1 - sx : sx;
+        }
+    }
+
+    for(int y = y0; y < y1; y++) {
+        int64_t v = y - dst->y;
+        int sy = (int)(((2 * v + 1) * src->h) / (2 * (int64_t)dst->h));
+        if(flip_y) {
+            sy = src->h - 1 - sy;
+        }
+        const uint8_t *src_row = src->data + sy * src->w;
+        const uint8_t *raw = target->raw;
+        if(direct) {
+            raw = src_row + (x0 - dst->x);
+        } else {
+            for(int i = 0; i < n; i++) {
+                target->raw[i] = src_row[target->cols[i]];
+            }
+        }
+
+        row_blit_mask(target->mask, raw, src->transparent, n);
+        int offset = y * target->w + x0;
+        if(opacity < 255) {
+            row_blit_mask_opacity(target->mask, target->levels + offset, opacity, n);
+        }
+
+        const uint8_t *vals = raw;
+        if(!identity) {
+            for(int i = 0; i < n; i++) {
+                target->vals[i] = lut[raw[i]];
+            }
+            vals = target->vals;
+        }
+
+        switch(mode) {
+            case WRITE_SET:
+                row_blit_copy(target->index + offset, vals, target->mask, n);
+                row_blit_fill(target->remap + offset, 0, target->mask, n);
+                row_blit_fill(target->rounds + offset, 0, target->mask, n);
+                row_blit_fill(target->add + offset, 0, target->mask, n);
+                break;
+            case WRITE_ADD:
+                row_blit_copy(target->add + offset, vals, target->mask, n);
+                break;
+            case WRITE_REMAP:
+                row_blit_copy(target->remap + offset, vals, target->mask, n);
+                row_blit_fill(target->rounds + offset, rounds, target->mask, n);
+                row_blit_fill(target->add + offset, 0, target->mask, n);
+                break;
+        }
+    }
+}
+
+void index_target_resolve(const index_target *target, const vga_remap_tables *remaps, unsigned char *dst) {
+    int size = target->w * target->h;
+    row_blit_add_saturate(dst, target->index, target->add, size);
+    for(int i = 0; i < size; i++) {
+        int count = target->rounds[i];
+        if(count == 0) {
+            continue;
+        }
+        const vga_remap_table *table = &remaps->tables[clamp_int(target->remap[i], 0, VGA_REMAP_COUNT - 1)];
+        unsigned char value = dst[i];
+        for(int k = 0; k < count; k++) {
+            value = table->data[value];
+        }
+        dst[i] = value;
+    }
+}
+
+void index_target_read_area(const index_target *target, const SDL_Rect *area, unsigned char *dst) {
+    for(int row = 0; row < area->h; row++) {
+        int ty = target->h - 1 - (area->y + row);
+        for(int col = 0; col < area->w; col++) {
+            int tx = area->x + col;
+            bool inside = tx >= 0 && tx < target->w && ty >= 0 && ty < target->h;
+            dst[row * area->w + col] = inside ? target->index[ty * target->w + tx] : 0;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef INDEX_TARGET_H
+#define INDEX_TARGET_H
+
+#include "video/surface.h"
+#include "video/vga_remap.h"
+#include <SDL.h>
+#include <stdint.h>
+
+/**
+ * CPU version of the indexed offscreen target used by the OpenGL3 renderer.
+ *
+ * The GL target is an RGBA8 texture where R is the palette index, G the remap table, B the number of
+ * remap rounds and A an index added on top. Here each channel is a separate byte plane of the same size,
+ * and index_target_draw() runs the palette.frag logic for each pixel of the drawn surface.
+ */
+typedef struct index_target index_target;
+
+index_target *index_target_create(int w, int h);
+void index_target_free(index_target **target);
+
+/**
+ * Clears all planes to zero.
+ */
+void index_target_clear(index_target *target);
+
+/**
+ * Draws a surface to the target. Arguments are as for the renderer draw_surface callback.
+ */
+void index_target_draw(index_target *target, const vga_remap_tables *remaps, const surface *src, const SDL_Rect *dst,
+                       int remap_offset, int remap_rounds, int palette_offset, int palette_limit, int opacity,
+                       unsigned int flip_mode, unsigned int options);
+
+/**
+ * Resolves the planes to final palette indexes, as done by rgba.frag before the palette lookup.
+ *
+ * @param dst Output buffer of w * h bytes
+ */
+void index_target_resolve(const index_target *target, const vga_remap_tables *remaps, unsigned char *dst);
+
+/**
+ * Reads the index plane like glReadPixels does: area coordinates have their origin at the bottom left
+ * corner, and rows are written bottom to top. Pixels outside the target are set to zero.
+ *
+ * @param dst Output buffer of area->w * area->h bytes
+ */
+void index_target_read_area(const index_target *target, const SDL_Rect *area, unsigned char *dst);
+
+#endif // INDEX_TARGET_H
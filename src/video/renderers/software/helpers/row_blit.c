@@ -0,0 +1,121 @@
+#include "video/renderers/software/helpers/row_blit.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ROW_BLIT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ROW_BLIT_NEON
+#include <arm_neon.h>
+#endif
+
+void row_blit_mask(uint8_t *mask, const uint8_t *src, int transparent, int n) {
+    int i = 0;
+    if(transparent < 0 || transparent > 255) {
+        for(; i < n; i++) {
+            mask[i] = 0xFF;
+        }
+        return;
+    }
+#if defined(ROW_BLIT_SSE2)
+    const __m128i key = _mm_set1_epi8((char)transparent);
+    const __m128i ones = _mm_set1_epi8((char)0xFF);
+    for(; i + 16 <= n; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(mask + i), _mm_andnot_si128(_mm_cmpeq_epi8(s, key), ones));
+    }
+#elif defined(ROW_BLIT_NEON)
+    const uint8x16_t key = vdupq_n_u8((uint8_t)transparent);
+    for(; i + 16 <= n; i += 16) {
+        vst1q_u8(mask + i, vmvnq_u8(vceqq_u8(vld1q_u8(src + i), key)));
+    }
+#endif
+    for(; i < n; i++) {
+        mask[i] = (src[i] != transparent) ? 0xFF : 0;
+    }
+}
+
+void row_blit_mask_opacity(uint8_t *mask, const uint8_t *levels, uint8_t opacity, int n) {
+    int i = 0;
+#if defined(ROW_BLIT_SSE2)
+    const __m128i op = _mm_set1_epi8((char)opacity);
+    for(; i + 16 <= n; i += 16) {
+        __m128i l = _mm_loadu_si128((const __m128i *)(levels + i));
+        __m128i m = _mm_loadu_si128((const __m128i *)(mask + i));
+        __m128i keep = _mm_cmpeq_epi8(_mm_max_epu8(l, op), op);
+        _mm_storeu_si128((__m128i *)(mask + i), _mm_and_si128(m, keep));
+    }
+#elif defined(ROW_BLIT_NEON)
+    const uint8x16_t op = vdupq_n_u8(opacity);
+    for(; i + 16 <= n; i += 16) {
+        uint8x16_t keep = vcleq_u8(vld1q_u8(levels + i), op);
+        vst1q_u8(mask + i, vandq_u8(vld1q_u8(mask + i), keep));
+    }
+#endif
+    for(; i < n; i++) {
+        if(levels[i] > opacity) {
+            mask[i] = 0;
+        }
+    }
+}
+
+void row_blit_copy(uint8_t *dst, const uint8_t *src, const uint8_t *mask, int n) {
+    int i = 0;
+#if defined(ROW_BLIT_SSE2)
+    for(; i + 16 <= n; i += 16) {
+        __m128i m = _mm_loadu_si128((const __m128i *)(mask + i));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_and_si128(m, s), _mm_andnot_si128(m, d)));
+    }
+#elif defined(ROW_BLIT_NEON)
+    for(; i + 16 <= n; i += 16) {
+        vst1q_u8(dst + i, vbslq_u8(vld1q_u8(mask + i), vld1q_u8(src + i), vld1q_u8(dst + i)));
+    }
+#endif
+    for(; i < n; i++) {
+        if(mask[i]) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+void row_blit_fill(uint8_t *dst, uint8_t value, const uint8_t *mask, int n) {
+    int i = 0;
+#if defined(ROW_BLIT_SSE2)
+    const __m128i v = _mm_set1_epi8((char)value);
+    for(; i + 16 <= n; i += 16) {
+        __m128i m = _mm_loadu_si128((const __m128i *)(mask + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, d)));
+    }
+#elif defined(ROW_BLIT_NEON)
+    const uint8x16_t v = vdupq_n_u8(value);
+    for(; i + 16 <= n; i += 16) {
+        vst1q_u8(dst + i, vbslq_u8(vld1q_u8(mask + i), v, vld1q_u8(dst + i)));
+    }
+#endif
+    for(; i < n; i++) {
+        if(mask[i]) {
+            dst[i] = value;
+        }
+    }
+}
+
+void row_blit_add_saturate(uint8_t *dst, const uint8_t *a, const uint8_t *b, int n) {
+    int i = 0;
+#if defined(ROW_BLIT_SSE2)
+    for(; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epu8(va, vb));
+    }
+#elif defined(ROW_BLIT_NEON)
+    for(; i + 16 <= n; i += 16) {
+        vst1q_u8(dst + i, vqaddq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    }
+#endif
+    for(; i < n; i++) {
+        int sum = a[i] + b[i];
+        dst[i] = (sum > 255) ? 255 : sum;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef ROW_BLIT_H
+#define ROW_BLIT_H
+
+#include <stdint.h>
+
+/**
+ * Byte row kernels for the software renderer. These use SSE2 or NEON when the compiler targets them,
+ * and plain C otherwise. Buffers need no particular alignment. Masks are 0xFF for pixels to write, 0 otherwise.
+ */
+
+// mask = (src != transparent). If transparent is not a valid index, every pixel is set.
+void row_blit_mask(uint8_t *mask, const uint8_t *src, int transparent, int n);
+
+// mask &= (levels <= opacity)
+void row_blit_mask_opacity(uint8_t *mask, const uint8_t *levels, uint8_t opacity, int n);
+
+// dst = mask ? src : dst
+void row_blit_copy(uint8_t *dst, const uint8_t *src, const uint8_t *mask, int n);
+
+// dst = mask ? value : dst
+void row_blit_fill(uint8_t *dst, uint8_t value, const uint8_t *mask, int n);
+
+// dst = min(255, a + b)
+void row_blit_add_saturate(uint8_t *dst, const uint8_t *a, const uint8_t *b, int n);
+
+#endif // ROW_BLIT_H
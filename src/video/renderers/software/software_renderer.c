@@ -0,0 +1,335 @@
+#include "video/renderers/software/software_renderer.h"
+#include "video/renderers/software/helpers/index_target.h"
+
+#include "game/utils/version.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "video/vga_state.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NATIVE_W 320
+#define NATIVE_H 200
+
+typedef struct sw_context {
+    SDL_Window *window;
+    SDL_Surface *frame;
+    index_target *target;
+    unsigned char *indexes;
+    vga_remap_tables remaps;
+    Uint32 colors[256];
+
+    int screen_w;
+    int screen_h;
+    bool fullscreen;
+    bool vsync;
+    int target_move_x;
+    int target_move_y;
+    SDL_Rect area;
+
+    video_screenshot_signal screenshot_cb;
+} sw_context;
+
+static bool is_available(void) {
+    return true;
+}
+
+static const char *get_description(void) {
+    return "Software renderer";
+}
+
+static const char *get_name(void) {
+    return "Software";
+}
+
+static bool set_fullscreen(SDL_Window *window, bool fullscreen) {
+    if(SDL_SetWindowFullscreen(window, fullscreen ? SDL_WINDOW_FULLSCREEN : 0) != 0) {
+        log_error("Could not set fullscreen mode: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+static void log_vsync(bool vsync) {
+    if(vsync) {
+        log_info("VSYNC is not supported by the software renderer!");
+    } else {
+        log_info("VSYNC is disabled!");
+    }
+}
+
+static bool setup_context(void *userdata, int window_w, int window_h, bool fullscreen, bool vsync) {
+    sw_context *ctx = userdata;
+    ctx->screen_w = window_w;
+    ctx->screen_h = window_h;
+    ctx->fullscreen = fullscreen;
+    ctx->vsync = vsync;
+    ctx->target_move_x = 0;
+    ctx->target_move_y = 0;
+
+    // Headless runs and the unit tests don't initialize SDL video. Frames are then rendered and can be
+    // captured as usual, but there is no window to show them in.
+    if(SDL_WasInit(SDL_INIT_VIDEO)) {
+        char title[32];
+        snprintf(title, 32, "OpenOMF v%s", get_version_string());
+        ctx->window = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_w, window_h,
+                                       SDL_WINDOW_SHOWN);
+        if(ctx->window == NULL) {
+            log_error("Could not create window: %s", SDL_GetError());
+            goto error_0;
+        }
+        if(fullscreen && set_fullscreen(ctx->window, true)) {
+            log_info("Fullscreen mode enabled!");
+        }
+        SDL_DisableScreenSaver();
+        log_vsync(vsync);
+    } else {
+        ctx->window = NULL;
+        log_info("SDL video is not initialized, rendering without a window.");
+    }
+
+    ctx->frame = SDL_CreateRGBSurfaceWithFormat(0, NATIVE_W, NATIVE_H, 32, SDL_PIXELFORMAT_RGB888);
+    if(ctx->frame == NULL) {
+        log_error("Could not create frame surface: %s", SDL_GetError());
+        goto error_1;
+    }
+
+    ctx->target = index_target_create(NATIVE_W, NATIVE_H);
+    ctx->indexes = omf_calloc(NATIVE_W * NATIVE_H, 1);
+    vga_remaps_init(&ctx->remaps);
+    vga_state_mark_dirty();
+
+    log_info("Software renderer initialized!");
+    return true;
+
+error_1:
+    if(ctx->window != NULL) {
+        SDL_DestroyWindow(ctx->window);
+    }
+
+error_0:
+    return false;
+}
+
+static void get_context_state(void *userdata, int *window_w, int *window_h, bool *fullscreen, bool *vsync) {
+    sw_context *ctx = userdata;
+    if(window_w != NULL)
+        *window_w = ctx->screen_w;
+    if(window_h != NULL)
+        *window_h = ctx->screen_h;
+    if(fullscreen != NULL)
+        *fullscreen = ctx->fullscreen;
+    if(vsync != NULL)
+        *vsync = ctx->vsync;
+}
+
+static bool reset_context_with(void *userdata, int window_w, int window_h, bool fullscreen, bool vsync) {
+    sw_context *ctx = userdata;
+    ctx->screen_w = window_w;
+    ctx->screen_h = window_h;
+    ctx->fullscreen = fullscreen;
+    ctx->vsync = vsync;
+    if(ctx->window == NULL) {
+        return true;
+    }
+    SDL_SetWindowSize(ctx->window, window_w, window_h);
+    bool success = set_fullscreen(ctx->window, fullscreen);
+    log_vsync(vsync);
+    log_info("Software renderer reset.");
+    return success;
+}
+
+static void reset_context(void *userdata) {
+    return;
+}
+
+static void close_context(void *userdata) {
+    sw_context *ctx = userdata;
+    omf_free(ctx->indexes);
+    index_target_free(&ctx->target);
+    SDL_FreeSurface(ctx->frame);
+    if(ctx->window != NULL) {
+        SDL_DestroyWindow(ctx->window);
+    }
+    log_info("Software renderer closed.");
+}
+
+/**
+ * If remaps are dirty, take a copy. Surfaces are rasterized as soon as they are drawn, so this is checked
+ * before each draw.
+ */
+static inline void flush_remaps(sw_context *ctx) {
+    vga_remap_tables *tables;
+    if(vga_state_is_remap_dirty(&tables)) {
+        memcpy(&ctx->remaps, tables, sizeof(vga_remap_tables));
+        vga_state_mark_remaps_flushed();
+    }
+}
+
+/**
+ * If palette is dirty, refresh the frame colors of the dirty range. Note that the range is
+ * inclusive (dirty area is start <= x <= end).
+ */
+static inline void flush_palettes(sw_context *ctx) {
+    vga_index range_start, range_end;
+    vga_palette *palette;
+    if(vga_state_is_palette_dirty(&palette, &range_start, &range_end)) {
+        for(int i = range_start; i <= range_end; i++) {
+            const vga_color *color = &palette->colors[i];
+            ctx->colors[i] = SDL_MapRGB(ctx->frame->format, color->r, color->g, color->b);
+        }
+        vga_state_mark_palette_flushed();
+    }
+}
+
+static void draw_surface(void *userdata, const surface *src_surface, SDL_Rect *dst, int remap_offset, int remap_rounds,
+                         int palette_offset, int palette_limit, int opacity, unsigned int flip_mode,
+                         unsigned int options) {
+    sw_context *ctx = userdata;
+    flush_remaps(ctx);
+    index_target_draw(ctx->target, &ctx->remaps, src_surface, dst, remap_offset, remap_rounds, palette_offset,
+                      palette_limit, opacity, flip_mode, options);
+}
+
+static void move_target(void *userdata, int x, int y) {
+    sw_context *ctx = userdata;
+    ctx->target_move_x = x;
+    ctx->target_move_y = y;
+}
+
+static void render_prepare(void *userdata) {
+    sw_context *ctx = userdata;
+    index_target_clear(ctx->target);
+}
+
+/**
+ * Convert the resolved indexes to frame colors. Screen shakes move the image right by x and up by y,
+ * like the viewport offset of the OpenGL3 renderer.
+ */
+static void convert_frame(sw_context *ctx) {
+    SDL_Surface *frame = ctx->frame;
+    for(int y = 0; y < NATIVE_H; y++) {
+        Uint32 *row = (Uint32 *)((Uint8 *)frame->pixels + y * frame->pitch);
+        int src_y = y + ctx->target_move_y;
+        if(src_y < 0 || src_y >= NATIVE_H) {
+            memset(row, 0, NATIVE_W * sizeof(Uint32));
+            continue;
+        }
+        const unsigned char *src = ctx->indexes + src_y * NATIVE_W;
+        for(int x = 0; x < NATIVE_W; x++) {
+            int src_x = x - ctx->target_move_x;
+            row[x] = (src_x >= 0 && src_x < NATIVE_W) ? ctx->colors[src[src_x]] : 0;
+        }
+    }
+}
+
+static void capture_screenshot(sw_context *ctx) {
+    SDL_Rect r = {0, 0, NATIVE_W, NATIVE_H};
+    unsigned char *buffer = omf_malloc(r.w * r.h * 3);
+    for(int y = 0; y < r.h; y++) {
+        const Uint32 *row = (const Uint32 *)((const Uint8 *)ctx->frame->pixels + y * ctx->frame->pitch);
+        for(int x = 0; x < r.w; x++) {
+            unsigned char *out = &buffer[(y * r.w + x) * 3];
+            SDL_GetRGB(row[x], ctx->frame->format, &out[0], &out[1], &out[2]);
+        }
+    }
+    ctx->screenshot_cb(&r, buffer, false);
+    omf_free(buffer);
+}
+
+static void render_finish(void *userdata) {
+    sw_context *ctx = userdata;
+    flush_palettes(ctx);
+    flush_remaps(ctx);
+    index_target_resolve(ctx->target, &ctx->remaps, ctx->indexes);
+    convert_frame(ctx);
+
+    // Snap screenshot from the freshly rendered state.
+    if(ctx->screenshot_cb) {
+        capture_screenshot(ctx);
+        ctx->screenshot_cb = NULL;
+    }
+
+    if(ctx->window == NULL) {
+        return;
+    }
+    SDL_Surface *window_surface = SDL_GetWindowSurface(ctx->window);
+    if(window_surface == NULL) {
+        log_error("Could not get window surface: %s", SDL_GetError());
+        return;
+    }
+    SDL_FillRect(window_surface, NULL, 0);
+    SDL_BlitScaled(ctx->frame, NULL, window_surface, NULL);
+    SDL_UpdateWindowSurface(ctx->window);
+}
+
+static void render_area_prepare(void *userdata, const SDL_Rect *area) {
+    sw_context *ctx = userdata;
+    index_target_clear(ctx->target);
+    ctx->area = *area;
+}
+
+static void render_area_finish(void *userdata, surface *dst) {
+    sw_context *ctx = userdata;
+    SDL_Rect *r = &ctx->area;
+    unsigned char *buffer = omf_malloc(r->w * r->h);
+    index_target_read_area(ctx->target, r, buffer);
+    surface_create_from_data_flip(dst, r->w, r->h, buffer);
+    surface_set_transparency(dst, -1);
+    omf_free(buffer);
+}
+
+static void capture_screen(void *userdata, video_screenshot_signal screenshot_cb) {
+    sw_context *ctx = userdata;
+    ctx->screenshot_cb = screenshot_cb;
+}
+
+static void signal_scene_change(void *userdata) {
+}
+
+static void signal_draw_atlas(void *userdata, bool toggle) {
+}
+
+static void signal_surface_released(void *userdata, unsigned int guid) {
+}
+
+static bool get_atlas_stats(void *userdata, unsigned int *items, float *occupancy, float *fragmentation) {
+    return false;
+}
+
+static void renderer_create(renderer *sw_renderer) {
+    sw_renderer->ctx = omf_calloc(1, sizeof(sw_context));
+}
+
+static void renderer_destroy(renderer *sw_renderer) {
+    omf_free(sw_renderer->ctx);
+}
+
+void software_renderer_set_callbacks(renderer *sw_renderer) {
+    sw_renderer->is_available = is_available;
+    sw_renderer->get_description = get_description;
+    sw_renderer->get_name = get_name;
+
+    sw_renderer->create = renderer_create;
+    sw_renderer->destroy = renderer_destroy;
+
+    sw_renderer->setup_context = setup_context;
+    sw_renderer->get_context_state = get_context_state;
+    sw_renderer->reset_context_with = reset_context_with;
+    sw_renderer->reset_context = reset_context;
+    sw_renderer->close_context = close_context;
+
+    sw_renderer->draw_surface = draw_surface;
+    sw_renderer->move_target = move_target;
+    sw_renderer->render_prepare = render_prepare;
+    sw_renderer->render_finish = render_finish;
+    sw_renderer->render_area_prepare = render_area_prepare;
+    sw_renderer->render_area_finish = render_area_finish;
+
+    sw_renderer->capture_screen = capture_screen;
+    sw_renderer->signal_scene_change = signal_scene_change;
+    sw_renderer->signal_draw_atlas = signal_draw_atlas;
+    sw_renderer->signal_surface_released = signal_surface_released;
+    sw_renderer->get_atlas_stats = get_atlas_stats;
+}
@@ -2,15 +2,27 @@
 #include "utils/allocator.h"
 #include "utils/miscmath.h"
 #include "utils/png_writer.h"
+#include "video/video.h"
+#include <SDL_atomic.h>
 #include <stdlib.h>
 
 // Each surface is tagged with a unique key. This is then used for texture atlas.
-// This keeps track of the last index used.
-static unsigned int guid = 0;
+// This keeps track of the last index used. Surfaces are also created by loader jobs on worker threads.
+static SDL_atomic_t guid;
+
+static inline unsigned int next_guid(void) {
+    return (unsigned int)SDL_AtomicAdd(&guid, 1);
+}
+
+// Surface contents changed, so the renderer copy under the old key is no longer needed.
+static inline void refresh_guid(surface *sur) {
+    video_signal_surface_released(sur->guid);
+    sur->guid = next_guid();
+}
 
 void surface_create(surface *sur, int w, int h) {
     sur->data = omf_calloc(1, w * h);
-    sur->guid = guid++;
+    sur->guid = next_guid();
     sur->w = w;
     sur->h = h;
     sur->transparent = 0;
@@ -57,12 +69,13 @@ void surface_set_transparency(surface *sur, int index) {
 }
 
 void surface_free(surface *sur) {
+    video_signal_surface_released(sur->guid);
     omf_free(sur->data);
 }
 
 void surface_clear(surface *sur) {
     memset(sur->data, 0, sur->w * sur->h);
-    sur->guid = guid++;
+    refresh_guid(sur);
 }
 
 void surface_create_from(surface *dst, const surface *src) {
@@ -89,7 +102,7 @@ void surface_sub(surface *dst, const surface *src, int dst_x, int dst_y, int src
             dst->data[dst_offset] = src->data[src_offset];
         }
     }
-    dst->guid = guid++;
+    refresh_guid(dst);
 }
 
 static uint8_t find_closest_gray(const vga_palette *pal, int range_start, int range_end, int ref) {
@@ -123,7 +136,7 @@ void surface_flatten_to_mask(surface *sur, uint8_t value) {
             continue;
         sur->data[i] = value;
     }
-    sur->guid = guid++;
+    refresh_guid(sur);
 }
 
 void surface_convert_to_grayscale(surface *sur, const vga_palette *pal, int range_start, int range_end,
@@ -151,7 +164,7 @@ void surface_convert_to_grayscale(surface *sur, const vga_palette *pal, int rang
             continue;
         sur->data[i] = mapping[idx];
     }
-    sur->guid = guid++;
+    refresh_guid(sur);
 }
 
 void surface_convert_har_to_grayscale(surface *sur, uint8_t brightness) {
@@ -162,7 +175,7 @@ void surface_convert_har_to_grayscale(surface *sur, uint8_t brightness) {
             sur->data[i] = 0xD0 + brightness * (idx % 0x10) / 0x0F;
         }
     }
-    sur->guid = guid++;
+    refresh_guid(sur);
 }
 
 void surface_compress_index_blocks(surface *sur, int range_start, int range_end, int block_size, int amount) {
@@ -176,7 +189,7 @@ void surface_compress_index_blocks(surface *sur, int range_start, int range_end,
             sur->data[i] = idx - old_idx + new_idx;
         }
     }
-    sur->guid = guid++;
+    refresh_guid(sur);
 }
 
 void surface_compress_remap(surface *sur, int range_start, int range_end, int remap_to, int amount) {
@@ -191,7 +204,7 @@ void surface_compress_remap(surface *sur, int range_start, int range_end, int re
             }
         }
     }
-    sur->guid = guid++;
+    refresh_guid(sur);
 }
 
 bool surface_write_png(const surface *sur, const vga_palette *pal, const char *filename) {
@@ -9,6 +9,9 @@
 #ifdef ENABLE_OPENGL3_RENDERER
 #include "video/renderers/opengl3/gl3_renderer.h"
 #endif
+#ifdef ENABLE_SOFTWARE_RENDERER
+#include "video/renderers/software/software_renderer.h"
+#endif
 #ifdef ENABLE_NULL_RENDERER
 #include "video/renderers/null/null_renderer.h"
 #endif
@@ -23,6 +26,9 @@ static renderer_init all_renderers[] = {
 #ifdef ENABLE_OPENGL3_RENDERER
     gl3_renderer_set_callbacks,
 #endif
+#ifdef ENABLE_SOFTWARE_RENDERER
+    software_renderer_set_callbacks,
+#endif
 #ifdef ENABLE_NULL_RENDERER
     null_renderer_set_callbacks,
 #endif
@@ -161,6 +167,19 @@ void video_signal_scene_change(void) {
     current_renderer.signal_scene_change(current_renderer.ctx);
 }
 
+void video_signal_surface_released(unsigned int guid) {
+    if(current_renderer.signal_surface_released != NULL && current_renderer.ctx != NULL) {
+        current_renderer.signal_surface_released(current_renderer.ctx, guid);
+    }
+}
+
+bool video_get_atlas_stats(unsigned int *items, float *occupancy, float *fragmentation) {
+    if(current_renderer.get_atlas_stats == NULL || current_renderer.ctx == NULL) {
+        return false;
+    }
+    return current_renderer.get_atlas_stats(current_renderer.ctx, items, occupancy, fragmentation);
+}
+
 void video_render_prepare(void) {
     current_renderer.render_prepare(current_renderer.ctx);
 }
@@ -180,6 +199,8 @@ void video_render_area_finish(surface *dst) {
 void video_close(void) {
     current_renderer.close_context(current_renderer.ctx);
     current_renderer.destroy(&current_renderer);
+    // Surfaces freed after this point have nothing to notify.
+    current_renderer.ctx = NULL;
 }
 
 void video_move_target(int x, int y) {
@@ -94,6 +94,18 @@ void video_draw_full(const surface *src_surface, int x, int y, int w, int h, int
 
 void video_signal_scene_change(void);
 
+/**
+ * Tells the renderer that a surface key is no longer in use, so that its cached copy can be dropped.
+ * Safe to call when no renderer is running.
+ */
+void video_signal_surface_released(unsigned int guid);
+
+/**
+ * Texture atlas usage. Occupancy is the used fraction of the atlas, and fragmentation is the fraction of free
+ * space that is not in the largest free block. Returns false if the renderer has no atlas.
+ */
+bool video_get_atlas_stats(unsigned int *items, float *occupancy, float *fragmentation);
+
 void video_render_prepare(void);
 void video_render_finish(void);
 void video_render_area_prepare(const SDL_Rect *area);
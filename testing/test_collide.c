@@ -0,0 +1,194 @@
+#include "game/game_state.h"
+#include "game/objects/har.h"
+#include "game/protos/intersect.h"
+#include "game/protos/object.h"
+#include "utils/allocator.h"
+#include "utils/random.h"
+#include <CUnit/CUnit.h>
+
+#define COLLIDE_SCRAP 300
+#define COLLIDE_MAX_PAIRS 4096
+
+static game_state gs;
+static uint32_t pairs[COLLIDE_MAX_PAIRS][2];
+static int pair_count;
+
+static void record_collide(object *a, object *b) {
+    if(pair_count < COLLIDE_MAX_PAIRS) {
+        pairs[pair_count][0] = a->id;
+        pairs[pair_count][1] = b->id;
+    }
+    pair_count++;
+}
+
+static object *add_object(int layers, int group, bool collides) {
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, &gs, vec2i_create(0, 0), vec2f_create(0.0f, 0.0f));
+    object_set_layers(obj, layers);
+    object_set_group(obj, group);
+    if(collides) {
+        object_set_collide_cb(obj, record_collide);
+    }
+    game_state_add_object(&gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+    return obj;
+}
+
+// Every pair, in the order the collision pass has always visited them.
+static void reference_collide(void) {
+    unsigned int size = vector_size(&gs.objects);
+    for(unsigned i = 0; i < size; i++) {
+        object *a = ((render_obj *)vector_get(&gs.objects, i))->obj;
+        for(unsigned k = i + 1; k < size; k++) {
+            object *b = ((render_obj *)vector_get(&gs.objects, k))->obj;
+            if(a->group != b->group || a->group == GROUP_UNKNOWN || b->group == GROUP_UNKNOWN) {
+                if(a->layers & b->layers) {
+                    object_collide(a, b);
+                }
+            }
+        }
+    }
+}
+
+void test_collide_create(void) {
+    memset(&gs, 0, sizeof(game_state));
+    vector_create(&gs.objects, sizeof(render_obj));
+    object_index_create(&gs.obj_index);
+
+    // A fight after a destruction: two HARs, some projectiles and a lot of scrap
+    add_object(LAYER_SCRAP, GROUP_UNKNOWN, false);
+    add_object(LAYER_HAR | LAYER_HAR1, GROUP_UNKNOWN, true);
+    add_object(LAYER_PROJECTILE | LAYER_HAR1, GROUP_PROJECTILE, false);
+    add_object(LAYER_HAR | LAYER_HAR2, GROUP_UNKNOWN, true);
+    for(int i = 0; i < COLLIDE_SCRAP; i++) {
+        add_object(LAYER_SCRAP, GROUP_UNKNOWN, false);
+        if(i % 50 == 0) {
+            add_object(LAYER_PROJECTILE | (i % 100 ? LAYER_HAR1 : LAYER_HAR2), GROUP_PROJECTILE, false);
+        }
+    }
+    add_object(LAYER_HAZARD | LAYER_HAR1 | LAYER_HAR2, GROUP_UNKNOWN, false);
+    CU_ASSERT(vector_size(&gs.objects) > COLLIDE_SCRAP);
+}
+
+void test_collide_free(void) {
+    iterator it;
+    render_obj *robj;
+    vector_iter_begin(&gs.objects, &it);
+    foreach(it, robj) {
+        object_free(robj->obj);
+        omf_free(robj->obj);
+    }
+    vector_free(&gs.objects);
+    object_index_free(&gs.obj_index);
+}
+
+void test_collide_order(void) {
+    uint32_t expected[COLLIDE_MAX_PAIRS][2];
+    pair_count = 0;
+    reference_collide();
+    int expected_count = pair_count;
+    CU_ASSERT(expected_count > 0);
+    CU_ASSERT_FATAL(expected_count <= COLLIDE_MAX_PAIRS);
+    memcpy(expected, pairs, sizeof(pairs));
+
+    pair_count = 0;
+    game_state_call_collide(&gs);
+    CU_ASSERT_EQUAL(pair_count, expected_count);
+    CU_ASSERT(memcmp(expected, pairs, sizeof(uint32_t) * 2 * expected_count) == 0);
+}
+
+// A solid sprite, so that every hitpoint that lands on it counts
+static void set_hit_sprite(object *obj, vec2i pos, int w, int h, bool flip) {
+    surface *sfc = omf_calloc(1, sizeof(surface));
+    surface_create(sfc, w, h);
+    memset(sfc->data, 1, w * h);
+    sprite *sp = omf_calloc(1, sizeof(sprite));
+    sprite_create_custom(sp, pos, sfc);
+    sp->owned = true;
+    animation *ani = create_animation_from_single(sp, vec2i_create(0, 0));
+    object_set_animation(obj, ani);
+    object_set_animation_owner(obj, OWNER_OBJECT);
+    object_set_custom_string(obj, flip ? "rA100" : "A100");
+    obj->cur_sprite_id = 0;
+}
+
+static void add_hit_coord(object *obj, int x, int y) {
+    collision_coord cc;
+    cc.pos = vec2i_create(x, y);
+    cc.frame_index = 0;
+    vector_append(&obj->cur_animation->collision_coords, &cc);
+}
+
+// The culling may only skip pairs that the hitpoint check would not have hit either
+static int check_culling(object *a, object *b) {
+    vec2i point;
+    int hit = intersect_sprite_hitpoint(a, b, 1, &point) || intersect_sprite_hitpoint(b, a, 1, &point);
+    if(hit) {
+        CU_ASSERT(intersect_sprite_extents_overlap(a, b));
+        CU_ASSERT(intersect_sprite_extents_overlap(b, a));
+    }
+    return hit;
+}
+
+void test_collide_culling(void) {
+    struct random_t rand;
+    random_seed(&rand, 1234);
+    object a, b;
+    object_create(&a, &gs, vec2i_create(0, 0), vec2f_create(0.0f, 0.0f));
+    object_create(&b, &gs, vec2i_create(0, 0), vec2f_create(0.0f, 0.0f));
+
+    // Random sprites of all sizes, offsets and hitpoints, facing and flipped both ways
+    int hits = 0;
+    for(int i = 0; i < 5000; i++) {
+        object *objs[2] = {&a, &b};
+        for(int k = 0; k < 2; k++) {
+            int w = 1 + random_int(&rand, k == 0 ? 40 : 200);
+            int h = 1 + random_int(&rand, k == 0 ? 40 : 200);
+            vec2i pos = vec2i_create((int)random_int(&rand, 240) - 200, (int)random_int(&rand, 240) - 200);
+            set_hit_sprite(objs[k], pos, w, h, random_int(&rand, 2));
+            for(int c = random_int(&rand, 4); c > 0; c--) {
+                add_hit_coord(objs[k], (int)random_int(&rand, 300) - 150, (int)random_int(&rand, 300) - 200);
+            }
+            object_set_direction(objs[k], random_int(&rand, 2) ? OBJECT_FACE_LEFT : OBJECT_FACE_RIGHT);
+        }
+        object_set_pos(&a, vec2i_create(random_int(&rand, 320), 100 + random_int(&rand, 100)));
+        object_set_pos(&b, vec2i_add(object_get_pos(&a), vec2i_create((int)random_int(&rand, 400) - 200,
+                                                                       (int)random_int(&rand, 400) - 200)));
+        hits += check_culling(&a, &b);
+    }
+    CU_ASSERT(hits > 0);
+
+    // Sweep a small target past the edges of a hitpoint at the far end of the extents
+    for(int flip = 0; flip < 4; flip++) {
+        set_hit_sprite(&a, vec2i_create(-10, -20), 20, 20, flip & 1);
+        add_hit_coord(&a, 60, -40);
+        object_set_direction(&a, (flip & 2) ? OBJECT_FACE_LEFT : OBJECT_FACE_RIGHT);
+        object_set_pos(&a, vec2i_create(160, 150));
+        set_hit_sprite(&b, vec2i_create(-1, -1), 3, 3, flip & 1);
+        hits = 0;
+        for(int y = 80; y < 160; y++) {
+            for(int x = 60; x < 260; x++) {
+                object_set_pos(&b, vec2i_create(x, y));
+                hits += check_culling(&a, &b);
+            }
+        }
+        CU_ASSERT(hits > 0);
+    }
+
+    object_free(&a);
+    object_free(&b);
+}
+
+void collide_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of collision setup", test_collide_create) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of collision pair order", test_collide_order) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of hitpoint culling", test_collide_culling) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of collision teardown", test_collide_free) == NULL) {
+        return;
+    }
+}
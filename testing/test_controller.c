@@ -0,0 +1,184 @@
+#include "console/console.h"
+#include "controller/controller.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
+#include "utils/allocator.h"
+#include "video/video.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+static const int test_actions[] = {ACT_LEFT, ACT_UP, ACT_PUNCH, ACT_DOWN | ACT_RIGHT, ACT_KICK, ACT_STOP};
+
+// Acts like an AI controller, issuing a handful of commands every tick
+static int test_tick(controller *ctrl, uint32_t ticks, ctrl_event **ev) {
+    ctrl->last = 0;
+    for(unsigned i = 0; i < sizeof(test_actions) / sizeof(test_actions[0]); i++) {
+        controller_cmd(ctrl, test_actions[i], ev);
+    }
+    return 0;
+}
+
+static int test_poll(controller *ctrl, ctrl_event **ev) {
+    return test_tick(ctrl, 0, ev);
+}
+
+static void test_free(controller *ctrl) {
+}
+
+static int polled_events;
+
+// Polls the player controllers and frees the events right away, like the fight scenes do
+static void test_input_poll(scene *sc) {
+    for(int i = 0; i < game_state_num_players(sc->gs); i++) {
+        ctrl_event *ev = NULL;
+        controller_poll(game_player_get_ctrl(game_state_get_player(sc->gs, i)), &ev);
+        for(ctrl_event *e = ev; e != NULL; e = e->next) {
+            polled_events++;
+        }
+        controller_free_chain(ev);
+    }
+}
+
+static void test_ctrl_init(controller *ctrl, game_state *gs) {
+    memset(gs, 0, sizeof(game_state));
+    memset(ctrl, 0, sizeof(controller));
+    controller_init(ctrl, gs);
+    ctrl->tick_fun = test_tick;
+    ctrl->free_fun = test_free;
+}
+
+void test_controller_event_order(void) {
+    game_state gs;
+    controller ctrl;
+    test_ctrl_init(&ctrl, &gs);
+
+    ctrl_event *ev = NULL;
+    controller_tick(&ctrl, 0, &ev);
+    controller_tick(&ctrl, 1, &ev);
+    int n = 0;
+    for(ctrl_event *i = ev; i != NULL; i = i->next) {
+        CU_ASSERT_EQUAL(i->type, EVENT_TYPE_ACTION);
+        CU_ASSERT_EQUAL(i->event_data.action, test_actions[n % 6]);
+        n++;
+    }
+    CU_ASSERT_EQUAL(n, 12);
+
+    // A close event replaces everything before it
+    controller_close(&ctrl, &ev);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ev);
+    CU_ASSERT_EQUAL(ev->type, EVENT_TYPE_CLOSE);
+    CU_ASSERT_PTR_NULL(ev->next);
+    controller_free_chain(ev);
+
+    controller_free(&ctrl);
+}
+
+void test_controller_event_allocations(void) {
+    game_state gs;
+    controller ctrl;
+    test_ctrl_init(&ctrl, &gs);
+
+    // Events pushed every tick and freed at the end of it never touch the heap
+    for(uint32_t tick = 0; tick < 10000; tick++) {
+        controller_tick(&ctrl, tick, &ctrl.extra_events);
+        for(ctrl_event *i = ctrl.extra_events; i != NULL; i = i->next) {
+            CU_ASSERT_PTR_EQUAL(i->pool, &ctrl.pool);
+        }
+        controller_free_chain(ctrl.extra_events);
+        ctrl.extra_events = NULL;
+    }
+    CU_ASSERT_EQUAL(ctrl.pool.overflows, 0);
+
+    // Going past the pool size still works, the rest comes from the heap.
+    ctrl_event *ev = NULL;
+    int ticks = CTRL_EVENT_POOL_SIZE / 6 + 2;
+    for(int tick = 0; tick < ticks; tick++) {
+        controller_tick(&ctrl, tick, &ev);
+    }
+    int n = 0;
+    for(ctrl_event *i = ev; i != NULL; i = i->next) {
+        CU_ASSERT_EQUAL(i->event_data.action, test_actions[n % 6]);
+        n++;
+    }
+    CU_ASSERT_EQUAL(n, ticks * 6);
+    CU_ASSERT_EQUAL(ctrl.pool.overflows, ticks * 6 - CTRL_EVENT_POOL_SIZE);
+    controller_free_chain(ev);
+
+    // Heap events are not put back in the pool
+    ev = NULL;
+    controller_tick(&ctrl, 0, &ev);
+    CU_ASSERT_EQUAL(ctrl.pool.overflows, ticks * 6 - CTRL_EVENT_POOL_SIZE);
+    ctrl.extra_events = ev;
+    controller_free(&ctrl);
+}
+
+void test_controller_dynamic_tick_allocations(void) {
+    game_state gs;
+    scene sc;
+    memset(&gs, 0, sizeof(game_state));
+    memset(&sc, 0, sizeof(scene));
+    ticktimer_init(&sc.tick_timer);
+    scene_set_input_poll_cb(&sc, test_input_poll);
+    sc.gs = &gs;
+    sc.static_ticks_since_start = 25;
+    gs.sc = &sc;
+    gs.speed_slowdown_time = -1;
+    vector_create(&gs.objects, sizeof(render_obj));
+    object_index_create(&gs.obj_index);
+    gs.menu_ctrl = omf_calloc(1, sizeof(controller));
+    controller_init(gs.menu_ctrl, &gs);
+    for(int i = 0; i < game_state_num_players(&gs); i++) {
+        controller *ctrl = omf_calloc(1, sizeof(controller));
+        controller_init(ctrl, &gs);
+        ctrl->dyntick_fun = test_tick;
+        ctrl->poll_fun = test_poll;
+        ctrl->free_fun = test_free;
+        gs.players[i] = omf_calloc(1, sizeof(game_player));
+        game_player_create(gs.players[i]);
+        game_player_set_ctrl(gs.players[i], ctrl);
+    }
+    video_scan_renderers();
+    CU_ASSERT_FATAL(video_init("NULL", 320, 200, false, false));
+    CU_ASSERT_FATAL(console_init());
+
+    // Every tick, the controllers push events at dyntick and poll time, and all of them are freed again.
+    // None of that may touch the heap.
+    polled_events = 0;
+    size_t allocs = omf_alloc_count();
+    size_t frees = omf_free_count();
+    for(int tick = 0; tick < 100; tick++) {
+        game_state_dynamic_tick(&gs, false);
+    }
+    CU_ASSERT_EQUAL(omf_alloc_count(), allocs);
+    CU_ASSERT_EQUAL(omf_free_count(), frees);
+    CU_ASSERT_EQUAL(polled_events, 100 * 2 * 6);
+    for(int i = 0; i < game_state_num_players(&gs); i++) {
+        CU_ASSERT_EQUAL(gs.players[i]->ctrl->pool.overflows, 0);
+        CU_ASSERT_PTR_NULL(gs.players[i]->ctrl->extra_events);
+    }
+
+    console_close();
+    video_close();
+    for(int i = 0; i < game_state_num_players(&gs); i++) {
+        game_player_free(gs.players[i]);
+        omf_free(gs.players[i]);
+    }
+    omf_free(gs.menu_ctrl);
+    object_index_free(&gs.obj_index);
+    vector_free(&gs.objects);
+    ticktimer_close(&sc.tick_timer);
+}
+
+void controller_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of controller event order", test_controller_event_order) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of controller event allocations", test_controller_event_allocations) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of game state tick allocations", test_controller_dynamic_tick_allocations) ==
+       NULL) {
+        return;
+    }
+}
@@ -0,0 +1,72 @@
+#include "resources/file_index.h"
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+
+#define INDEX_TEST_FILE "test_file_index.idx"
+
+typedef struct test_record {
+    int a;
+    char b[10];
+} test_record;
+
+void test_file_index_roundtrip(void) {
+    file_index index;
+    test_record in = {42, "first"};
+    test_record out;
+    remove(INDEX_TEST_FILE);
+
+    file_index_open(&index, INDEX_TEST_FILE, 1, sizeof(test_record));
+    CU_ASSERT_FALSE(file_index_get(&index, "A.CHR", 100, 200, &out));
+    file_index_put(&index, "A.CHR", 100, 200, &in);
+    in.a = 43;
+    file_index_put(&index, "B.CHR", 101, 201, &in);
+    file_index_close(&index);
+
+    file_index_open(&index, INDEX_TEST_FILE, 1, sizeof(test_record));
+    CU_ASSERT(file_index_get(&index, "A.CHR", 100, 200, &out));
+    CU_ASSERT_EQUAL(out.a, 42);
+    CU_ASSERT_STRING_EQUAL(out.b, "first");
+    CU_ASSERT(file_index_get(&index, "B.CHR", 101, 201, &out));
+    CU_ASSERT_EQUAL(out.a, 43);
+    file_index_close(&index);
+    remove(INDEX_TEST_FILE);
+}
+
+void test_file_index_invalidation(void) {
+    file_index index;
+    test_record in = {1, "x"};
+    test_record out;
+    remove(INDEX_TEST_FILE);
+
+    file_index_open(&index, INDEX_TEST_FILE, 1, sizeof(test_record));
+    file_index_put(&index, "A.TRN", 100, 200, &in);
+    file_index_put(&index, "B.TRN", 100, 200, &in);
+    file_index_close(&index);
+
+    // Changed files miss, and files that were not seen are dropped on save
+    file_index_open(&index, INDEX_TEST_FILE, 1, sizeof(test_record));
+    CU_ASSERT_FALSE(file_index_get(&index, "A.TRN", 101, 200, &out));
+    CU_ASSERT_FALSE(file_index_get(&index, "A.TRN", 100, 201, &out));
+    CU_ASSERT(file_index_get(&index, "A.TRN", 100, 200, &out));
+    file_index_close(&index);
+
+    file_index_open(&index, INDEX_TEST_FILE, 1, sizeof(test_record));
+    CU_ASSERT(file_index_get(&index, "A.TRN", 100, 200, &out));
+    CU_ASSERT_FALSE(file_index_get(&index, "B.TRN", 100, 200, &out));
+    file_index_close(&index);
+
+    // A new version discards the old records
+    file_index_open(&index, INDEX_TEST_FILE, 2, sizeof(test_record));
+    CU_ASSERT_FALSE(file_index_get(&index, "A.TRN", 100, 200, &out));
+    file_index_close(&index);
+    remove(INDEX_TEST_FILE);
+}
+
+void file_index_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of file index roundtrip", test_file_index_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of file index invalidation", test_file_index_invalidation) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,67 @@
+#include "utils/fixedpt.h"
+#include <CUnit/CUnit.h>
+#include <math.h>
+
+void test_fixedpt_convert(void) {
+    CU_ASSERT_EQUAL(fixedpt_from_int(3), 3 * FIXEDPT_ONE);
+    CU_ASSERT_EQUAL(fixedpt_to_int(fixedpt_from_int(-190)), -190);
+    CU_ASSERT_EQUAL(fixedpt_from_float(0.5f), FIXEDPT_ONE / 2);
+    CU_ASSERT_EQUAL(fixedpt_from_float(-0.25f), -FIXEDPT_ONE / 4);
+
+    // Casting a float to int truncates toward zero, and so does this
+    CU_ASSERT_EQUAL(fixedpt_to_int(fixedpt_from_float(2.75f)), 2);
+    CU_ASSERT_EQUAL(fixedpt_to_int(fixedpt_from_float(-2.75f)), -2);
+
+    // Every 16.16 value below 256 fits a float's mantissa, so the round trip is exact
+    for(fixedpt v = -256 * FIXEDPT_ONE; v < 256 * FIXEDPT_ONE; v += 12345) {
+        CU_ASSERT_EQUAL(fixedpt_from_float(fixedpt_to_float(v)), v);
+    }
+
+    // Floats that do not fit round to the nearest value
+    CU_ASSERT_EQUAL(fixedpt_from_float(0.1f), 6554);
+    CU_ASSERT_EQUAL(fixedpt_from_float(-0.1f), -6554);
+}
+
+void test_fixedpt_math(void) {
+    fixedpt a = fixedpt_from_float(1.5f);
+    fixedpt b = fixedpt_from_float(-2.25f);
+    CU_ASSERT_EQUAL(fixedpt_mul(a, b), fixedpt_from_float(-3.375f));
+    CU_ASSERT_EQUAL(fixedpt_div(b, a), fixedpt_from_float(-1.5f));
+    CU_ASSERT_EQUAL(fixedpt_div(fixedpt_from_int(1), fixedpt_from_int(3)), 21845);
+    CU_ASSERT_EQUAL(fixedpt_div(fixedpt_from_int(-1), fixedpt_from_int(3)), -21845);
+    CU_ASSERT_EQUAL(fixedpt_abs(b), fixedpt_from_float(2.25f));
+
+    // Results that do not fit saturate, instead of wrapping around or trapping
+    CU_ASSERT_EQUAL(fixedpt_div(fixedpt_from_int(10000), fixedpt_from_float(0.01f)), INT32_MAX);
+    CU_ASSERT_EQUAL(fixedpt_div(a, 0), INT32_MAX);
+    CU_ASSERT_EQUAL(fixedpt_div(b, 0), INT32_MIN);
+    CU_ASSERT_EQUAL(fixedpt_div(0, 0), 0);
+}
+
+void test_fixedpt_trig(void) {
+    // Within a couple of units of the float result, for the whole range of MA tag angles and beyond
+    for(int deg = -720; deg <= 720; deg++) {
+        fixedpt a = fixedpt_from_float(deg * 0.0174532925f);
+        CU_ASSERT(fixedpt_abs(fixedpt_sin(a) - fixedpt_from_float(sinf(fixedpt_to_float(a)))) <= 2);
+        CU_ASSERT(fixedpt_abs(fixedpt_cos(a) - fixedpt_from_float(cosf(fixedpt_to_float(a)))) <= 2);
+    }
+    for(int ma = -400; ma <= 400; ma++) {
+        CU_ASSERT(fixedpt_abs(fixedpt_sin(fixedpt_from_int(ma)) - fixedpt_from_float(sinf(ma))) <= 2);
+        CU_ASSERT(fixedpt_abs(fixedpt_cos(fixedpt_from_int(ma)) - fixedpt_from_float(cosf(ma))) <= 2);
+    }
+    CU_ASSERT_EQUAL(fixedpt_sin(0), 0);
+    CU_ASSERT_EQUAL(fixedpt_cos(0), FIXEDPT_ONE);
+    CU_ASSERT_EQUAL(fixedpt_sin(fixedpt_from_float(1.5707963f)), FIXEDPT_ONE);
+}
+
+void fixedpt_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of fixed point conversions", test_fixedpt_convert) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of fixed point math", test_fixedpt_math) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of fixed point sine and cosine", test_fixedpt_trig) == NULL) {
+        return;
+    }
+}
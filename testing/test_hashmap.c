@@ -1,4 +1,5 @@
 #include <CUnit/CUnit.h>
+#include <stdio.h>
 #include <utils/hashmap.h>
 #include <utils/iterator.h>
 
@@ -116,6 +117,105 @@ void hashmap_test_autoresize(void) {
     hashmap_free(&test_map);
 }
 
+void test_hashmap_many(void) {
+    hashmap test_map;
+    hashmap_create(&test_map);
+    char key[32];
+    char value[32];
+    const unsigned int count = 20000;
+
+    // Short keys and values are stored inline, long ones are allocated
+    for(unsigned int i = 0; i < count; i++) {
+        int len = snprintf(key, sizeof(key), i % 2 ? "%u" : "a much longer key %u", i);
+        memset(value, 0, sizeof(value));
+        memcpy(value, &i, sizeof(unsigned int));
+        hashmap_put(&test_map, key, len + 1, value, i % 3 ? sizeof(unsigned int) : sizeof(value));
+    }
+    CU_ASSERT(hashmap_reserved(&test_map) == count);
+
+    // Overwrite some, delete some
+    for(unsigned int i = 0; i < count; i += 5) {
+        int len = snprintf(key, sizeof(key), i % 2 ? "%u" : "a much longer key %u", i);
+        CU_ASSERT(hashmap_del(&test_map, key, len + 1) == 0);
+        CU_ASSERT(hashmap_del(&test_map, key, len + 1) == 1);
+    }
+    for(unsigned int i = 1; i < count; i += 5) {
+        int len = snprintf(key, sizeof(key), i % 2 ? "%u" : "a much longer key %u", i);
+        memset(value, 0, sizeof(value));
+        memcpy(value, &i, sizeof(unsigned int));
+        hashmap_put(&test_map, key, len + 1, value, sizeof(value));
+    }
+    CU_ASSERT(hashmap_reserved(&test_map) == count - count / 5);
+
+    for(unsigned int i = 0; i < count; i++) {
+        int len = snprintf(key, sizeof(key), i % 2 ? "%u" : "a much longer key %u", i);
+        unsigned int *val;
+        unsigned int val_len;
+        int ret = hashmap_get(&test_map, key, len + 1, (void **)&val, &val_len);
+        if(i % 5 == 0) {
+            CU_ASSERT(ret == 1);
+        } else {
+            CU_ASSERT_FATAL(ret == 0);
+            CU_ASSERT(*val == i);
+            CU_ASSERT(val_len == (i % 5 == 1 || i % 3 == 0 ? sizeof(value) : sizeof(unsigned int)));
+        }
+    }
+
+    // Deleting while iterating visits every pair exactly once
+    iterator it;
+    hashmap_pair *pair;
+    unsigned int seen = 0;
+    unsigned int sum = 0;
+    hashmap_iter_begin(&test_map, &it);
+    foreach(it, pair) {
+        seen++;
+        sum += *(unsigned int *)pair->value;
+        if(*(unsigned int *)pair->value % 2) {
+            CU_ASSERT(hashmap_delete(&test_map, &it) == 0);
+        }
+    }
+    unsigned int expected_sum = 0;
+    for(unsigned int i = 0; i < count; i++) {
+        expected_sum += i % 5 ? i : 0;
+    }
+    CU_ASSERT(seen == count - count / 5);
+    CU_ASSERT(sum == expected_sum);
+    CU_ASSERT(hashmap_reserved(&test_map) == (count - count / 5) / 2);
+
+    hashmap_free(&test_map);
+}
+
+void test_hashmap_stable_values(void) {
+    hashmap test_map;
+    hashmap_create(&test_map);
+    char big[64];
+    memset(big, 'x', sizeof(big));
+    unsigned int key = 0;
+    unsigned int *small = hashmap_put(&test_map, &key, sizeof(unsigned int), &key, sizeof(unsigned int));
+    char *large = hashmap_put(&test_map, "large", 6, big, sizeof(big));
+
+    // Growing the table and shifting slots around does not move the values
+    for(unsigned int i = 1; i < 1000; i++) {
+        hashmap_put_int(&test_map, i, &i, sizeof(unsigned int));
+    }
+    for(unsigned int i = 1; i < 1000; i += 2) {
+        hashmap_del_int(&test_map, i);
+    }
+    unsigned int *val;
+    CU_ASSERT(hashmap_get_int(&test_map, 0, (void **)&val, NULL) == 0);
+    CU_ASSERT_PTR_EQUAL(val, small);
+    CU_ASSERT(hashmap_get_str(&test_map, "large", (void **)&val, NULL) == 0);
+    CU_ASSERT_PTR_EQUAL(val, large);
+
+    // Neither does putting a small value again
+    hashmap_put_int(&test_map, 0, &key, sizeof(unsigned int));
+    CU_ASSERT(hashmap_get_int(&test_map, 0, (void **)&val, NULL) == 0);
+    CU_ASSERT_PTR_EQUAL(val, small);
+    CU_ASSERT(*val == 0);
+
+    hashmap_free(&test_map);
+}
+
 void hashmap_test_suite(CU_pSuite suite) {
     // Add tests
     if(CU_add_test(suite, "Test for hashmap create", test_hashmap_create) == NULL) {
@@ -136,4 +236,10 @@ void hashmap_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "Test for hashmap auto resize", hashmap_test_autoresize) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "Test for hashmap with many entries", test_hashmap_many) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for hashmap value addresses", test_hashmap_stable_values) == NULL) {
+        return;
+    }
 }
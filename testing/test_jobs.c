@@ -0,0 +1,80 @@
+#include "utils/jobs.h"
+#include <CUnit/CUnit.h>
+#include <SDL_atomic.h>
+
+#define JOB_COUNT 64
+
+typedef struct test_job {
+    int input;
+    int output;
+} test_job;
+
+static SDL_atomic_t ran;
+
+static void square(void *userdata) {
+    test_job *t = userdata;
+    t->output = t->input * t->input;
+    SDL_AtomicAdd(&ran, 1);
+}
+
+static void run_jobs(void) {
+    test_job data[JOB_COUNT];
+    job *jobs[JOB_COUNT];
+    SDL_AtomicSet(&ran, 0);
+    for(int i = 0; i < JOB_COUNT; i++) {
+        data[i].input = i;
+        data[i].output = -1;
+        jobs[i] = job_submit(square, &data[i]);
+    }
+    for(int i = JOB_COUNT - 1; i >= 0; i--) {
+        job_wait(jobs[i]);
+        CU_ASSERT(job_is_done(jobs[i]));
+        CU_ASSERT_EQUAL(data[i].output, i * i);
+        job_free(jobs[i]);
+    }
+    CU_ASSERT_EQUAL(SDL_AtomicGet(&ran), JOB_COUNT);
+}
+
+void test_jobs_inline(void) {
+    // Without a pool, jobs are done by the time they are submitted
+    test_job data = {3, 0};
+    job *j = job_submit(square, &data);
+    CU_ASSERT(job_is_done(j));
+    CU_ASSERT_EQUAL(data.output, 9);
+    job_free(j);
+    run_jobs();
+}
+
+void test_jobs_pool(void) {
+    jobs_init(3);
+    run_jobs();
+    jobs_close();
+}
+
+void test_jobs_close_finishes_queue(void) {
+    test_job data[JOB_COUNT];
+    job *jobs[JOB_COUNT];
+    jobs_init(2);
+    for(int i = 0; i < JOB_COUNT; i++) {
+        data[i].input = i;
+        jobs[i] = job_submit(square, &data[i]);
+    }
+    jobs_close();
+    for(int i = 0; i < JOB_COUNT; i++) {
+        CU_ASSERT(job_is_done(jobs[i]));
+        CU_ASSERT_EQUAL(data[i].output, i * i);
+        job_free(jobs[i]);
+    }
+}
+
+void jobs_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of inline jobs", test_jobs_inline) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of jobs on worker threads", test_jobs_pool) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of finishing jobs on close", test_jobs_close_finishes_queue) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,102 @@
+#include "game/utils/lobby_protocol.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+static void make_user(lobby_user *user, uint32_t id, const char *name) {
+    memset(user, 0, sizeof(*user));
+    user->id = id;
+    user->address.host = 0x0100007F;
+    user->port = 40000;
+    user->ext_port = 0;
+    user->wins = 3;
+    user->losses = 200;
+    user->status = PRESENCE_AVAILABLE;
+    strcpy(user->version, "0.6.5");
+    strcpy(user->name, name);
+}
+
+void test_lobby_presence_roundtrip(void) {
+    lobby_user in, out;
+    serial ser;
+
+    make_user(&in, 0xCAFEBABE, "Crystal");
+    serial_create(&ser);
+    lobby_presence_write(&ser, &in, true);
+    CU_ASSERT_EQUAL((uint8_t)serial_read_int8(&ser), PACKET_PRESENCE << 4 | LOBBY_PRESENCE_JOINED);
+    CU_ASSERT_TRUE(lobby_presence_read(&ser, &out));
+    CU_ASSERT_EQUAL(out.id, in.id);
+    CU_ASSERT_EQUAL(out.address.host, in.address.host);
+    CU_ASSERT_EQUAL(out.port, in.port);
+    CU_ASSERT_EQUAL(out.address.port, in.port);
+    CU_ASSERT_EQUAL(out.wins, 3);
+    CU_ASSERT_EQUAL(out.losses, 200);
+    CU_ASSERT_EQUAL(out.status, PRESENCE_AVAILABLE);
+    CU_ASSERT_STRING_EQUAL(out.version, "0.6.5");
+    CU_ASSERT_STRING_EQUAL(out.name, "Crystal");
+    serial_free(&ser);
+
+    // The claimed external port is the one to connect to
+    in.ext_port = 2097;
+    serial_create(&ser);
+    lobby_presence_write(&ser, &in, false);
+    CU_ASSERT_EQUAL((uint8_t)serial_read_int8(&ser), PACKET_PRESENCE << 4);
+    CU_ASSERT_TRUE(lobby_presence_read(&ser, &out));
+    CU_ASSERT_EQUAL(out.port, 40000);
+    CU_ASSERT_EQUAL(out.address.port, 2097);
+    serial_free(&ser);
+}
+
+void test_lobby_presence_truncated(void) {
+    lobby_user in, out;
+    serial ser, cut;
+
+    make_user(&in, 1, "Steffan");
+    serial_create(&ser);
+    lobby_presence_write(&ser, &in, false);
+
+    // The name is the rest of the packet, so only prefixes that end before it are invalid
+    for(size_t len = 1; len <= serial_len(&ser) - strlen(in.name); len++) {
+        serial_create_from(&cut, ser.data, len);
+        serial_read_int8(&cut);
+        CU_ASSERT_FALSE(lobby_presence_read(&cut, &out));
+        serial_free(&cut);
+    }
+    serial_free(&ser);
+}
+
+void test_lobby_users_update(void) {
+    lobby_user user;
+    list users;
+    list_create(&users);
+
+    make_user(&user, 1, "Milano");
+    CU_ASSERT_TRUE(lobby_users_update(&users, &user));
+    make_user(&user, 2, "Ibrahim");
+    CU_ASSERT_TRUE(lobby_users_update(&users, &user));
+
+    user.wins = 4;
+    user.status = PRESENCE_FIGHTING;
+    strcpy(user.version, "0.7.0");
+    CU_ASSERT_FALSE(lobby_users_update(&users, &user));
+    CU_ASSERT_EQUAL(list_size(&users), 2);
+
+    lobby_user *updated = list_get(&users, 1);
+    CU_ASSERT_EQUAL(updated->wins, 4);
+    CU_ASSERT_EQUAL(updated->status, PRESENCE_FIGHTING);
+    CU_ASSERT_STRING_EQUAL(updated->version, "0.7.0");
+    CU_ASSERT_STRING_EQUAL(((lobby_user *)list_get(&users, 0))->name, "Milano");
+
+    list_free(&users);
+}
+
+void lobby_protocol_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of lobby presence serialization", test_lobby_presence_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of truncated lobby presence packets", test_lobby_presence_truncated) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of lobby user list updates", test_lobby_users_update) == NULL) {
+        return;
+    }
+}
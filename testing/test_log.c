@@ -0,0 +1,120 @@
+// Compile info messages out of this file, to check that their arguments are not evaluated.
+#define LOG_MIN_LEVEL LOG_WARN
+
+#include "utils/log.h"
+#include <CUnit/CUnit.h>
+#include <SDL_thread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_TEST_FILE "test_log.txt"
+#define THREAD_MESSAGES 100
+
+static int count_lines(const char *filename, const char *needle) {
+    char line[512];
+    int count = 0;
+    FILE *fp = fopen(filename, "r");
+    if(fp == NULL) {
+        return -1;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL) {
+        if(strstr(line, needle) != NULL) {
+            count++;
+        }
+    }
+    fclose(fp);
+    return count;
+}
+
+static int log_thread(void *userdata) {
+    const char *name = userdata;
+    for(int i = 0; i < THREAD_MESSAGES; i++) {
+        log_warn("%s message %d", name, i);
+    }
+    return 0;
+}
+
+void test_log_order(void) {
+    log_init();
+    log_add_file(LOG_TEST_FILE, LOG_DEBUG);
+    log_warn("first %d", 1);
+    log_error("second %s", "message");
+    log_flush();
+    CU_ASSERT_EQUAL(count_lines(LOG_TEST_FILE, "WARN  first 1"), 1);
+    log_warn("third");
+    log_close();
+
+    char line[512];
+    FILE *fp = fopen(LOG_TEST_FILE, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    CU_ASSERT_PTR_NOT_NULL(fgets(line, sizeof(line), fp));
+    CU_ASSERT_PTR_NOT_NULL(strstr(line, "first 1"));
+    CU_ASSERT_PTR_NOT_NULL(fgets(line, sizeof(line), fp));
+    CU_ASSERT_PTR_NOT_NULL(strstr(line, "ERROR second message"));
+    CU_ASSERT_PTR_NOT_NULL(fgets(line, sizeof(line), fp));
+    CU_ASSERT_PTR_NOT_NULL(strstr(line, "third"));
+    fclose(fp);
+    remove(LOG_TEST_FILE);
+}
+
+void test_log_threads(void) {
+    log_init();
+    log_add_file(LOG_TEST_FILE, LOG_DEBUG);
+    SDL_Thread *a = SDL_CreateThread(log_thread, "log test a", "thread-a");
+    SDL_Thread *b = SDL_CreateThread(log_thread, "log test b", "thread-b");
+    log_thread("main");
+    SDL_WaitThread(a, NULL);
+    SDL_WaitThread(b, NULL);
+    unsigned int dropped = log_dropped_count();
+    log_close();
+
+    // Everything that was not dropped is written out, and drops are reported.
+    int written = count_lines(LOG_TEST_FILE, "thread-a message") + count_lines(LOG_TEST_FILE, "thread-b message") +
+                  count_lines(LOG_TEST_FILE, "main message");
+    CU_ASSERT_EQUAL(written + (int)dropped, 3 * THREAD_MESSAGES);
+    CU_ASSERT_EQUAL(count_lines(LOG_TEST_FILE, "log messages dropped") > 0, dropped > 0);
+    remove(LOG_TEST_FILE);
+}
+
+void test_log_min_level(void) {
+    int evaluated = 0;
+    log_init();
+    log_add_file(LOG_TEST_FILE, LOG_DEBUG);
+    log_debug("debug %d", ++evaluated);
+    log_info("info %d", ++evaluated);
+    log_warn("warn %d", ++evaluated);
+    log_close();
+    CU_ASSERT_EQUAL(evaluated, 1);
+    CU_ASSERT_EQUAL(count_lines(LOG_TEST_FILE, "info"), 0);
+    CU_ASSERT_EQUAL(count_lines(LOG_TEST_FILE, "warn 1"), 1);
+    remove(LOG_TEST_FILE);
+}
+
+void test_log_error_sync(void) {
+    log_init();
+    log_add_file(LOG_TEST_FILE, LOG_DEBUG);
+    // More than fits in the ring of this thread
+    for(int i = 0; i < 1000; i++) {
+        log_warn("filler %d", i);
+    }
+    // Errors are on disk as soon as log_msg returns, without a flush
+    log_error("fatal %d", 1);
+    CU_ASSERT_EQUAL(count_lines(LOG_TEST_FILE, "ERROR fatal 1"), 1);
+    log_close();
+    remove(LOG_TEST_FILE);
+}
+
+void log_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of log message order", test_log_order) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of logging from threads", test_log_threads) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of compiled out log levels", test_log_min_level) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of synchronous error messages", test_log_error_sync) == NULL) {
+        return;
+    }
+}
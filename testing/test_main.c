@@ -5,6 +5,8 @@ void af_test_suite(CU_pSuite suite);
 void bk_test_suite(CU_pSuite suite);
 void palette_test_suite(CU_pSuite suite);
 void rec_test_suite(CU_pSuite suite);
+void rec_controller_test_suite(CU_pSuite suite);
+void controller_test_suite(CU_pSuite suite);
 void trn_test_suite(CU_pSuite suite);
 void script_test_suite(CU_pSuite suite);
 void str_test_suite(CU_pSuite suite);
@@ -14,6 +16,21 @@ void list_test_suite(CU_pSuite suite);
 void array_test_suite(CU_pSuite suite);
 void text_render_test_suite(CU_pSuite suite);
 void cp437_test_suite(CU_pSuite suite);
+void snapshot_test_suite(CU_pSuite suite);
+void collide_test_suite(CU_pSuite suite);
+void sound_cache_test_suite(CU_pSuite suite);
+void software_renderer_test_suite(CU_pSuite suite);
+void texture_atlas_test_suite(CU_pSuite suite);
+void resource_cache_test_suite(CU_pSuite suite);
+void log_test_suite(CU_pSuite suite);
+void move_trie_test_suite(CU_pSuite suite);
+void file_index_test_suite(CU_pSuite suite);
+void reader_test_suite(CU_pSuite suite);
+void jobs_test_suite(CU_pSuite suite);
+void sprite_test_suite(CU_pSuite suite);
+void state_hash_test_suite(CU_pSuite suite);
+void fixedpt_test_suite(CU_pSuite suite);
+void lobby_protocol_test_suite(CU_pSuite suite);
 
 int main(int argc, char **argv) {
     CU_pSuite suite = NULL;
@@ -79,6 +96,11 @@ int main(int argc, char **argv) {
         goto end;
     rec_test_suite(suite);
 
+    suite = CU_add_suite("REC controller", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    rec_controller_test_suite(suite);
+
     suite = CU_add_suite("TRN files", NULL, NULL);
     if(suite == NULL)
         goto end;
@@ -89,6 +111,86 @@ int main(int argc, char **argv) {
         goto end;
     script_test_suite(suite);
 
+    suite = CU_add_suite("Snapshots", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    snapshot_test_suite(suite);
+
+    suite = CU_add_suite("Collisions", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    collide_test_suite(suite);
+
+    suite = CU_add_suite("Sound cache", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    sound_cache_test_suite(suite);
+
+    suite = CU_add_suite("Software renderer", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    software_renderer_test_suite(suite);
+
+    suite = CU_add_suite("Texture atlas", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    texture_atlas_test_suite(suite);
+
+    suite = CU_add_suite("Resource cache", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    resource_cache_test_suite(suite);
+
+    suite = CU_add_suite("Log", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    log_test_suite(suite);
+
+    suite = CU_add_suite("Move trie", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    move_trie_test_suite(suite);
+
+    suite = CU_add_suite("File index", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    file_index_test_suite(suite);
+
+    suite = CU_add_suite("Reader", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    reader_test_suite(suite);
+
+    suite = CU_add_suite("Jobs", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    jobs_test_suite(suite);
+
+    suite = CU_add_suite("Sprites", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    sprite_test_suite(suite);
+
+    suite = CU_add_suite("Controller", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    controller_test_suite(suite);
+
+    suite = CU_add_suite("State hash", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    state_hash_test_suite(suite);
+
+    suite = CU_add_suite("Fixed point", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    fixedpt_test_suite(suite);
+
+    suite = CU_add_suite("Lobby protocol", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    lobby_protocol_test_suite(suite);
+
     // Run tests
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
@@ -0,0 +1,233 @@
+#include "controller/controller.h"
+#include "formats/error.h"
+#include "formats/rec.h"
+#include "game/objects/har.h"
+#include "resources/af.h"
+#include "resources/move_trie.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+static int mask_count(const move_mask *mask) {
+    int count = 0;
+    for(int i = move_mask_next(mask, 0); i >= 0; i = move_mask_next(mask, i + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void test_move_trie_match(void) {
+    move_trie trie;
+    move_trie_create(&trie);
+    move_trie_add(&trie, "K", 60);
+    move_trie_add(&trie, "K2", 3);
+    move_trie_add(&trie, "K23", 64);
+    move_trie_add(&trie, "K3", 12);
+    move_trie_add(&trie, "P2", 20);
+    move_trie_add(&trie, "", 30);
+
+    move_mask m = move_trie_match(&trie, 'K', "2345");
+    CU_ASSERT_EQUAL(mask_count(&m), 3);
+    CU_ASSERT(move_mask_isset(&m, 60));
+    CU_ASSERT(move_mask_isset(&m, 3));
+    CU_ASSERT(move_mask_isset(&m, 64));
+
+    // Lowest id first, regardless of the string length
+    CU_ASSERT_EQUAL(move_mask_next(&m, 0), 3);
+    CU_ASSERT_EQUAL(move_mask_next(&m, 4), 60);
+    CU_ASSERT_EQUAL(move_mask_next(&m, 61), 64);
+    CU_ASSERT_EQUAL(move_mask_next(&m, 65), -1);
+
+    m = move_trie_match(&trie, 'K', "");
+    CU_ASSERT_EQUAL(mask_count(&m), 1);
+    CU_ASSERT(move_mask_isset(&m, 60));
+
+    m = move_trie_match(&trie, 'P', "32");
+    CU_ASSERT_EQUAL(mask_count(&m), 0);
+    m = move_trie_match(&trie, 'P', "2");
+    CU_ASSERT(move_mask_isset(&m, 20));
+    m = move_trie_match(&trie, 1, "2");
+    CU_ASSERT_EQUAL(mask_count(&m), 0);
+
+    move_trie_free(&trie);
+}
+
+void test_move_mask_ops(void) {
+    move_mask a, b;
+    move_mask_clear(&a);
+    move_mask_clear(&b);
+    move_mask_set(&a, 0);
+    move_mask_set(&a, 63);
+    move_mask_set(&a, 69);
+    move_mask_set(&b, 63);
+    move_mask_andnot(&a, &b);
+    CU_ASSERT_EQUAL(move_mask_next(&a, 0), 0);
+    CU_ASSERT_EQUAL(move_mask_next(&a, 1), 69);
+    move_mask_or(&a, &b);
+    move_mask_and(&a, &b);
+    CU_ASSERT_EQUAL(move_mask_next(&a, 0), 63);
+    CU_ASSERT_EQUAL(mask_count(&a), 1);
+}
+
+// Move strings in the style of the HAR files. Index is the move id, NULL means no move.
+static const char *test_move_strings[] = {
+    "K",     "P",    "K2",   "P2",  "K3",   "P3",   "K6",   "P6",    "K4",   "P4",   "K1",   "K8",  "P8",
+    "K9",    "P9",   "K7",   "P7",  "P26",  "K26",  "P236", "K214", "P632", "K412", NULL,   "P",   "K66",
+    "P66",   "!",    "!",    "K2",  "P412", "K62",  "P5",   "K5",   "P25",  "K28",  "P82",  "K3",  "P123",
+    "K3214", "P41236", "K6321", NULL, "P2", "K2", "P6", "K6", "K24", "P24", "K86", "!", "P",
+};
+
+static void test_af_create(af *a) {
+    memset(a, 0, sizeof(*a));
+    array_create(&a->moves);
+    array_create(&a->sprites);
+    for(int i = 0; i < (int)(sizeof(test_move_strings) / sizeof(test_move_strings[0])); i++) {
+        if(test_move_strings[i] != NULL) {
+            af_move *move = omf_calloc(1, sizeof(af_move));
+            move->id = i;
+            str_from_c(&move->move_string, test_move_strings[i]);
+            array_set(&a->moves, i, move);
+        }
+    }
+    move_trie_create(&a->move_index);
+    af_rebuild_move_index(a);
+}
+
+static void test_af_free(af *a) {
+    iterator it;
+    af_move *move;
+    array_iter_begin(&a->moves, &it);
+    foreach(it, move) {
+        str_free(&move->move_string);
+        omf_free(move);
+    }
+    array_free(&a->moves);
+    array_free(&a->sprites);
+    move_trie_free(&a->move_index);
+}
+
+// The straightforward scan over all move strings that the trie replaces
+static move_mask match_linear(const af *a, char prefix, const char *inputs) {
+    move_mask mask;
+    move_mask_clear(&mask);
+    for(int i = 0; i < 70; i++) {
+        af_move *move = af_get_move(a, i);
+        if(move == NULL) {
+            continue;
+        }
+        size_t len = str_size(&move->move_string);
+        if(str_at(&move->move_string, 0) != prefix ||
+           (len != 1 && strncmp(str_c(&move->move_string) + 1, inputs, len - 1))) {
+            continue;
+        }
+        move_mask_set(&mask, i);
+    }
+    return mask;
+}
+
+static bool masks_equal(const move_mask *a, const move_mask *b) {
+    return memcmp(a->bits, b->bits, sizeof(a->bits)) == 0;
+}
+
+// Feeds the inputs of a REC file through the HAR input buffer, and checks both matchers after every input.
+static void check_rec_inputs(const af *a, const char *filename) {
+    sd_rec_file rec;
+    char inputs[2][11];
+    const char prefixes[] = {'K', 'P', 1};
+
+    CU_ASSERT_FATAL(sd_rec_create(&rec) == SD_SUCCESS);
+    CU_ASSERT_FATAL(sd_rec_load(&rec, filename) == SD_SUCCESS);
+    memset(inputs, 0, sizeof(inputs));
+
+    int checked = 0;
+    for(unsigned i = 0; i < rec.move_count; i++) {
+        const sd_rec_move *mv = &rec.moves[i];
+        if(mv->lookup_id != 2 || mv->player_id > 1) {
+            continue;
+        }
+        // Same translation as the REC controller does
+        int action = 0;
+        if(mv->action == SD_ACT_NONE) {
+            action = ACT_STOP;
+        }
+        action |= (mv->action & SD_ACT_UP) ? ACT_UP : 0;
+        action |= (mv->action & SD_ACT_DOWN) ? ACT_DOWN : 0;
+        action |= (mv->action & SD_ACT_LEFT) ? ACT_LEFT : 0;
+        action |= (mv->action & SD_ACT_RIGHT) ? ACT_RIGHT : 0;
+        action |= (mv->action & SD_ACT_PUNCH) ? ACT_PUNCH : 0;
+        action |= (mv->action & SD_ACT_KICK) ? ACT_KICK : 0;
+        // Opposite directions at once do not map to a numpad direction
+        if((action & (ACT_UP | ACT_DOWN)) == (ACT_UP | ACT_DOWN) ||
+           (action & (ACT_LEFT | ACT_RIGHT)) == (ACT_LEFT | ACT_RIGHT)) {
+            continue;
+        }
+
+        // Players face each other at the start of a match
+        char *buf = inputs[mv->player_id];
+        add_input(buf, action, mv->player_id == 0 ? OBJECT_FACE_RIGHT : OBJECT_FACE_LEFT);
+        for(int p = 0; p < 3; p++) {
+            move_mask trie = move_trie_match(&a->move_index, prefixes[p], buf);
+            move_mask linear = match_linear(a, prefixes[p], buf);
+            CU_ASSERT(masks_equal(&trie, &linear));
+            checked++;
+        }
+    }
+    CU_ASSERT(checked > 0);
+    sd_rec_free(&rec);
+}
+
+void test_move_trie_rec_inputs(void) {
+    const char *recs[] = {
+        TESTS_ROOT_DIR "/recs/crystal-shirro.rec",
+        TESTS_ROOT_DIR "/../rectests/65K6P.REC",
+        TESTS_ROOT_DIR "/../rectests/6P.REC",
+        TESTS_ROOT_DIR "/../rectests/OHT.REC",
+    };
+    af a;
+    test_af_create(&a);
+    for(int i = 0; i < 4; i++) {
+        check_rec_inputs(&a, recs[i]);
+    }
+    test_af_free(&a);
+}
+
+void test_move_trie_disabled_moves(void) {
+    af a;
+    test_af_create(&a);
+
+    // Moves that start out disabled never match
+    move_mask m = move_trie_match(&a.move_index, '!', "");
+    CU_ASSERT_EQUAL(mask_count(&m), 0);
+
+    // Disabling a move the way har_create does takes it out of the index once rebuilt
+    m = move_trie_match(&a.move_index, 'K', "2");
+    CU_ASSERT(move_mask_isset(&m, 2));
+    CU_ASSERT(move_mask_isset(&m, 29));
+    str_set_c(&af_get_move(&a, 2)->move_string, "!");
+    af_rebuild_move_index(&a);
+    m = move_trie_match(&a.move_index, 'K', "2");
+    CU_ASSERT_FALSE(move_mask_isset(&m, 2));
+    CU_ASSERT(move_mask_isset(&m, 29));
+    move_mask linear = match_linear(&a, 'K', "2");
+    CU_ASSERT(masks_equal(&m, &linear));
+
+    // The move is still a move, it just can not be input
+    CU_ASSERT(move_mask_isset(&a.all_moves, 2));
+
+    test_af_free(&a);
+}
+
+void move_trie_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of move trie matching", test_move_trie_match) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of move mask operations", test_move_mask_ops) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of move trie against a linear scan of REC inputs", test_move_trie_rec_inputs) ==
+       NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of disabled moves in the move index", test_move_trie_disabled_moves) == NULL) {
+        return;
+    }
+}
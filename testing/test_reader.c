@@ -0,0 +1,172 @@
+#include "formats/af.h"
+#include "formats/error.h"
+#include "formats/internal/reader.h"
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+#include <string.h>
+
+#define READER_TEST_FILE "test_reader.bin"
+#define READER_TEST_AF "test_reader.af"
+
+static void write_test_file(void) {
+    const char data[] = "\x01\x02\x03\x04\x05\x06\x07\x08line one\nline two";
+    FILE *fp = fopen(READER_TEST_FILE, "wb");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    fwrite(data, 1, sizeof(data) - 1, fp);
+    fclose(fp);
+}
+
+static void check_reader_semantics(sd_reader_backend backend) {
+    char buf[32];
+    write_test_file();
+    sd_reader_set_backend(backend);
+    sd_reader *r = sd_reader_open(READER_TEST_FILE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(r);
+    CU_ASSERT_EQUAL(sd_reader_filesize(r), 25);
+
+    // Peeking and matching do not advance
+    CU_ASSERT_EQUAL(sd_peek_ubyte(r), 1);
+    CU_ASSERT(sd_match(r, "\x01\x02", 2));
+    CU_ASSERT_FALSE(sd_match(r, "\x02", 1));
+    CU_ASSERT_EQUAL(sd_reader_pos(r), 0);
+
+    CU_ASSERT_EQUAL(sd_read_ubyte(r), 1);
+    CU_ASSERT_EQUAL(sd_read_uword(r), 0x0302);
+    sd_skip(r, 1);
+    CU_ASSERT_EQUAL(sd_read_udword(r), 0x08070605);
+    CU_ASSERT_EQUAL(sd_reader_pos(r), 8);
+
+    CU_ASSERT_EQUAL(sd_read_line(r, buf, sizeof(buf)), 0);
+    CU_ASSERT_STRING_EQUAL(buf, "line one\n");
+    CU_ASSERT_EQUAL(sd_read_line(r, buf, sizeof(buf)), 0);
+    CU_ASSERT_STRING_EQUAL(buf, "line two");
+    CU_ASSERT_EQUAL(sd_read_line(r, buf, sizeof(buf)), 1);
+
+    // Reading exactly to the end is fine, reading past it is not
+    CU_ASSERT(sd_reader_set(r, 21));
+    CU_ASSERT(sd_read_buf(r, buf, 4));
+    CU_ASSERT(sd_reader_ok(r));
+    CU_ASSERT(sd_reader_set(r, 23));
+    CU_ASSERT_EQUAL(sd_peek_uword(r), 0x6f77);
+    sd_peek_udword(r);
+    CU_ASSERT(sd_reader_ok(r));
+    CU_ASSERT_EQUAL(sd_reader_pos(r), 23);
+    CU_ASSERT_EQUAL(sd_read_udword(r) & 0xFFFF, 0x6f77);
+    CU_ASSERT_FALSE(sd_reader_ok(r));
+
+    // Seeking clears the end of file state
+    CU_ASSERT(sd_reader_set(r, 100));
+    CU_ASSERT(sd_reader_ok(r));
+    CU_ASSERT_EQUAL(sd_reader_pos(r), 100);
+    CU_ASSERT_EQUAL(sd_read_ubyte(r), 0);
+    CU_ASSERT_FALSE(sd_reader_ok(r));
+
+    sd_reader_close(r);
+    sd_reader_set_backend(SD_READER_MEMORY);
+    remove(READER_TEST_FILE);
+}
+
+void test_reader_memory(void) {
+    check_reader_semantics(SD_READER_MEMORY);
+}
+
+void test_reader_stdio(void) {
+    check_reader_semantics(SD_READER_STDIO);
+}
+
+void test_reader_shared(void) {
+    write_test_file();
+    sd_reader *r = sd_reader_open_shared(READER_TEST_FILE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(r);
+    CU_ASSERT(sd_reader_is_shared(r));
+    sd_skip(r, 8);
+    const char *ref = sd_read_ref(r, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ref);
+    CU_ASSERT_PTR_NULL(sd_read_ref(r, 100));
+    CU_ASSERT_EQUAL(sd_reader_pos(r), 12);
+
+    // The data outlives the reader while referenced
+    sd_reader_data *data = sd_reader_retain(r);
+    sd_reader_close(r);
+    CU_ASSERT(memcmp(ref, "line", 4) == 0);
+    sd_reader_release(data);
+
+    // Stdio readers never share
+    sd_reader_set_backend(SD_READER_STDIO);
+    r = sd_reader_open_shared(READER_TEST_FILE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(r);
+    CU_ASSERT_FALSE(sd_reader_is_shared(r));
+    CU_ASSERT_PTR_NULL(sd_read_ref(r, 4));
+    sd_reader_close(r);
+    sd_reader_set_backend(SD_READER_MEMORY);
+    remove(READER_TEST_FILE);
+}
+
+void test_reader_mapped_af(void) {
+    sd_af_file af, copied, mapped;
+    sd_move move;
+    sd_animation ani;
+    sd_sprite spr;
+    sd_vga_image img;
+    sd_af_create(&af);
+    sd_move_create(&move);
+    sd_animation_create(&ani);
+    sd_sprite_create(&spr);
+    sd_vga_image_create(&img, 4, 3);
+    for(int i = 0; i < 4 * 3; i++) {
+        img.data[i] = i;
+    }
+    sd_sprite_vga_encode(&spr, &img);
+    sd_animation_push_sprite(&ani, &spr);
+    sd_animation_push_sprite(&ani, &spr);
+    sd_move_set_animation(&move, &ani);
+    sd_af_set_move(&af, 5, &move);
+    CU_ASSERT_FATAL(sd_af_save(&af, READER_TEST_AF) == SD_SUCCESS);
+
+    sd_af_create(&copied);
+    sd_af_create(&mapped);
+    CU_ASSERT_FATAL(sd_af_load(&copied, READER_TEST_AF) == SD_SUCCESS);
+    CU_ASSERT_FATAL(sd_af_load_mapped(&mapped, READER_TEST_AF) == SD_SUCCESS);
+    remove(READER_TEST_AF);
+
+    sd_animation *a = copied.moves[5]->animation;
+    sd_animation *b = mapped.moves[5]->animation;
+    CU_ASSERT_EQUAL_FATAL(b->sprite_count, 2);
+    for(int i = 0; i < b->sprite_count; i++) {
+        CU_ASSERT_PTR_NULL(a->sprites[i]->source);
+        CU_ASSERT_PTR_NOT_NULL(b->sprites[i]->source);
+        CU_ASSERT_EQUAL_FATAL(a->sprites[i]->len, spr.len);
+        CU_ASSERT_EQUAL_FATAL(b->sprites[i]->len, spr.len);
+        CU_ASSERT(memcmp(b->sprites[i]->data, spr.data, spr.len) == 0);
+    }
+
+    // Copies of borrowed sprites own their data
+    sd_sprite copy;
+    sd_sprite_copy(&copy, b->sprites[0]);
+    CU_ASSERT_PTR_NULL(copy.source);
+    CU_ASSERT_PTR_NOT_EQUAL(copy.data, b->sprites[0]->data);
+    sd_sprite_free(&copy);
+
+    sd_af_free(&mapped);
+    sd_af_free(&copied);
+    sd_vga_image_free(&img);
+    sd_sprite_free(&spr);
+    sd_animation_free(&ani);
+    sd_move_free(&move);
+    sd_af_free(&af);
+}
+
+void reader_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of memory backed reader", test_reader_memory) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of stdio backed reader", test_reader_stdio) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of shared reader data", test_reader_shared) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of mapped af loading", test_reader_mapped_af) == NULL) {
+        return;
+    }
+}
@@ -4,6 +4,7 @@
 #include <CUnit/CUnit.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 sd_rec_file rec;
 
@@ -70,6 +71,101 @@ void test_crystal_shirro_load(void) {
     sd_rec_free(&rec);
 }
 
+static sd_rec_move make_move(uint32_t tick, uint8_t player_id, sd_action action) {
+    sd_rec_move mv;
+    memset(&mv, 0, sizeof(mv));
+    mv.tick = tick;
+    mv.lookup_id = 2;
+    mv.player_id = player_id;
+    mv.action = action;
+    return mv;
+}
+
+void test_rec_append_growth(void) {
+    sd_rec_file r;
+    CU_ASSERT(sd_rec_create(&r) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_append_action(NULL, NULL) == SD_INVALID_INPUT);
+
+    unsigned int reallocs = 0;
+    unsigned int capacity = r.move_capacity;
+    for(unsigned i = 0; i < 10000; i++) {
+        sd_rec_move mv = make_move(i, i % 2, SD_ACT_PUNCH);
+        CU_ASSERT_FATAL(sd_rec_append_action(&r, &mv) == SD_SUCCESS);
+        if(r.move_capacity != capacity) {
+            capacity = r.move_capacity;
+            reallocs++;
+        }
+    }
+    CU_ASSERT_EQUAL(r.move_count, 10000);
+    CU_ASSERT(r.move_capacity >= r.move_count);
+    CU_ASSERT(reallocs < 10);
+    CU_ASSERT_EQUAL(r.moves[1234].tick, 1234);
+    CU_ASSERT_EQUAL(r.moves[1235].player_id, 1);
+
+    // Deleting keeps the storage around, inserting still keeps the order
+    capacity = r.move_capacity;
+    CU_ASSERT(sd_rec_delete_action(&r, 0) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_delete_action(&r, r.move_count) == SD_INVALID_INPUT);
+    CU_ASSERT_EQUAL(r.move_capacity, capacity);
+    CU_ASSERT_EQUAL(r.moves[0].tick, 1);
+    sd_rec_move first = make_move(0, 0, SD_ACT_KICK);
+    CU_ASSERT(sd_rec_insert_action(&r, 0, &first) == SD_SUCCESS);
+    CU_ASSERT_EQUAL(r.moves[0].action, SD_ACT_KICK);
+    CU_ASSERT_EQUAL(r.moves[1].tick, 1);
+
+    // Reserving never shrinks
+    CU_ASSERT(sd_rec_reserve(&r, 10) == SD_SUCCESS);
+    CU_ASSERT_EQUAL(r.move_capacity, capacity);
+    CU_ASSERT(sd_rec_reserve(&r, capacity + 100) == SD_SUCCESS);
+    CU_ASSERT_EQUAL(r.move_capacity, capacity + 100);
+    sd_rec_free(&r);
+}
+
+void test_rec_stream(void) {
+    sd_rec_file r, loaded;
+    CU_ASSERT(sd_rec_create(&r) == SD_SUCCESS);
+    r.arena_id = 3;
+    r.scores[1] = 1000;
+    sd_rec_move mv = make_move(1, 0, SD_ACT_UP);
+    sd_rec_append_action(&r, &mv);
+
+    sd_rec_stream *stream = sd_rec_stream_open(&r, "test_stream.rec");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(stream);
+    for(unsigned i = 2; i < 50; i++) {
+        mv = make_move(i, i % 2, SD_ACT_DOWN | SD_ACT_KICK);
+        sd_rec_append_action(&r, &mv);
+    }
+    CU_ASSERT(sd_rec_stream_flush(stream, &r) == SD_SUCCESS);
+
+    // The file is a valid recording while the match is still running
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT_FATAL(sd_rec_load(&loaded, "test_stream.rec") == SD_SUCCESS);
+    CU_ASSERT_EQUAL(loaded.move_count, 49);
+    CU_ASSERT_EQUAL(loaded.arena_id, 3);
+    CU_ASSERT_EQUAL(loaded.scores[1], 1000);
+    CU_ASSERT_EQUAL(loaded.moves[0].action, SD_ACT_UP);
+    CU_ASSERT_EQUAL(loaded.moves[48].tick, 49);
+    sd_rec_free(&loaded);
+
+    mv = make_move(50, 1, SD_ACT_NONE);
+    sd_rec_append_action(&r, &mv);
+    sd_rec_finish(&r, 60);
+    CU_ASSERT(sd_rec_stream_close(stream, &r) == SD_SUCCESS);
+
+    // The finished stream matches a file saved in one go
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT_FATAL(sd_rec_load(&loaded, "test_stream.rec") == SD_SUCCESS);
+    CU_ASSERT_EQUAL(loaded.move_count, r.move_count);
+    for(unsigned i = 0; i < r.move_count; i++) {
+        CU_ASSERT_EQUAL(loaded.moves[i].tick, r.moves[i].tick);
+        CU_ASSERT_EQUAL(loaded.moves[i].player_id, r.moves[i].player_id);
+        CU_ASSERT_EQUAL(loaded.moves[i].action, r.moves[i].action);
+    }
+    sd_rec_free(&loaded);
+    sd_rec_free(&r);
+    remove("test_stream.rec");
+}
+
 void rec_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of sd_rec_create", test_sd_rec_create) == NULL) {
         return;
@@ -83,4 +179,10 @@ void rec_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test loading crystal-shirro.rec", test_crystal_shirro_load) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of REC move growth", test_rec_append_growth) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of REC streaming", test_rec_stream) == NULL) {
+        return;
+    }
 }
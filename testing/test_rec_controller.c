@@ -0,0 +1,133 @@
+#include "controller/rec_controller.h"
+#include "formats/error.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+static void add_move(sd_rec_file *rec, uint32_t tick, uint8_t player_id, sd_action action) {
+    sd_rec_move mv;
+    memset(&mv, 0, sizeof(mv));
+    mv.tick = tick;
+    mv.lookup_id = 2;
+    mv.player_id = player_id;
+    mv.action = action;
+    sd_rec_append_action(rec, &mv);
+}
+
+// Polls the controller at the given tick, and returns the actions it produced
+static int poll_at(controller *ctrl, game_state *gs, uint32_t tick, int *count) {
+    ctrl_event *ev = NULL;
+    int actions = 0;
+    *count = 0;
+    gs->int_tick = tick;
+    ctrl->last = 0;
+    controller_poll(ctrl, &ev);
+    for(ctrl_event *i = ev; i != NULL; i = i->next) {
+        if(i->type == EVENT_TYPE_ACTION) {
+            actions |= i->event_data.action;
+            (*count)++;
+        }
+    }
+    controller_free_chain(ev);
+    return actions;
+}
+
+void test_rec_controller_playback(void) {
+    sd_rec_file rec;
+    game_state gs;
+    controller ctrl;
+    int count;
+    memset(&gs, 0, sizeof(gs));
+    CU_ASSERT(sd_rec_create(&rec) == SD_SUCCESS);
+    add_move(&rec, 5, 0, SD_ACT_PUNCH);
+    add_move(&rec, 5, 1, SD_ACT_LEFT);
+    add_move(&rec, 5, 0, SD_ACT_UP);
+    add_move(&rec, 8, 0, SD_ACT_KICK);
+    add_move(&rec, 7, 0, SD_ACT_DOWN); // Out of order
+    add_move(&rec, 20, 0, SD_ACT_NONE);
+
+    controller_init(&ctrl, &gs);
+    rec_controller_create(&ctrl, 0, &rec);
+
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 4, &count), 0);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 5, &count), ACT_PUNCH | ACT_UP);
+    CU_ASSERT_EQUAL(count, 2);
+
+    // A second poll during the same tick does not replay the events
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 5, &count), 0);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 7, &count), ACT_DOWN);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 8, &count), ACT_KICK);
+
+    // Going back in time finds the earlier events again
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 5, &count), ACT_PUNCH | ACT_UP);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 8, &count), ACT_KICK);
+    CU_ASSERT_EQUAL(count, 1);
+
+    controller_free(&ctrl);
+    sd_rec_free(&rec);
+}
+
+void test_rec_controller_seek(void) {
+    sd_rec_file rec;
+    game_state gs;
+    controller ctrl;
+    int count;
+    memset(&gs, 0, sizeof(gs));
+    CU_ASSERT(sd_rec_create(&rec) == SD_SUCCESS);
+    for(uint32_t tick = 10; tick < 1000; tick += 10) {
+        add_move(&rec, tick, 1, tick % 20 == 0 ? SD_ACT_KICK : SD_ACT_PUNCH);
+    }
+
+    controller_init(&ctrl, &gs);
+    rec_controller_create(&ctrl, 1, &rec);
+
+    rec_controller_seek(&ctrl, 500);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 500, &count), ACT_KICK);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 510, &count), ACT_PUNCH);
+
+    // Seeking between events plays the next one on time
+    rec_controller_seek(&ctrl, 25);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 25, &count), 0);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 30, &count), ACT_PUNCH);
+
+    controller_free(&ctrl);
+    sd_rec_free(&rec);
+}
+
+void test_rec_controller_start_tick(void) {
+    sd_rec_file rec;
+    game_state gs;
+    controller ctrl;
+    int count;
+    memset(&gs, 0, sizeof(gs));
+    CU_ASSERT(sd_rec_create(&rec) == SD_SUCCESS);
+    add_move(&rec, 5, 0, SD_ACT_PUNCH);
+    add_move(&rec, 9, 0, SD_ACT_KICK);
+
+    controller_init(&ctrl, &gs);
+    rec_controller_create(&ctrl, 0, &rec);
+
+    // Nothing plays while the start is on hold
+    rec_controller_set_start_tick(&ctrl, UINT32_MAX);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 5, &count), 0);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 200, &count), 0);
+
+    rec_controller_set_start_tick(&ctrl, 300);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 5, &count), 0);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 305, &count), ACT_PUNCH);
+    CU_ASSERT_EQUAL(poll_at(&ctrl, &gs, 309, &count), ACT_KICK);
+
+    controller_free(&ctrl);
+    sd_rec_free(&rec);
+}
+
+void rec_controller_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of REC controller playback", test_rec_controller_playback) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of REC controller seeking", test_rec_controller_seek) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of REC controller start tick", test_rec_controller_start_tick) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,130 @@
+#include "formats/af.h"
+#include "formats/bk.h"
+#include "formats/error.h"
+#include "resources/af.h"
+#include "resources/bk.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+#define OPENOMF_BK TESTS_ROOT_DIR "/../resources/openomf.bk"
+
+static int load_bk(bk *b) {
+    sd_bk_file tmp;
+    if(sd_bk_create(&tmp) != SD_SUCCESS) {
+        return 1;
+    }
+    if(sd_bk_load(&tmp, OPENOMF_BK) != SD_SUCCESS) {
+        sd_bk_free(&tmp);
+        return 1;
+    }
+    bk_create(b, &tmp);
+    sd_bk_free(&tmp);
+    return 0;
+}
+
+static void make_af(af *a) {
+    sd_af_file tmp;
+    sd_move move;
+    sd_animation ani;
+    sd_sprite spr;
+    sd_vga_image img;
+    sd_af_create(&tmp);
+    sd_move_create(&move);
+    sd_animation_create(&ani);
+    sd_sprite_create(&spr);
+    sd_vga_image_create(&img, 4, 3);
+    for(int i = 0; i < 4 * 3; i++) {
+        img.data[i] = i;
+    }
+    sd_sprite_vga_encode(&spr, &img);
+    sd_animation_push_sprite(&ani, &spr);
+    sd_animation_push_sprite(&ani, &spr);
+    sd_move_set_animation(&move, &ani);
+    move.damage_amount = 10;
+    sd_af_set_move(&tmp, 20, &move);
+    sd_animation_set_anim_string(tmp.moves[20]->animation, "A10-B10");
+    af_create(a, &tmp);
+    sd_vga_image_free(&img);
+    sd_sprite_free(&spr);
+    sd_animation_free(&ani);
+    sd_move_free(&move);
+    sd_af_free(&tmp);
+}
+
+void test_af_clone_shares_sprites(void) {
+    af orig, copy;
+    make_af(&orig);
+    af_clone(&orig, &copy);
+
+    af_move *a = af_get_move(&orig, 20);
+    af_move *b = af_get_move(&copy, 20);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(a);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(b);
+    CU_ASSERT_PTR_NOT_EQUAL(a, b);
+    CU_ASSERT_PTR_NULL(af_get_move(&copy, 19));
+    CU_ASSERT(move_mask_isset(&copy.all_moves, 20));
+    CU_ASSERT_FALSE(move_mask_isset(&copy.all_moves, 19));
+    CU_ASSERT_EQUAL(animation_get_sprite_count(&b->ani), 2);
+    for(int i = 0; i < animation_get_sprite_count(&a->ani); i++) {
+        sprite *sa = animation_get_sprite(&a->ani, i);
+        sprite *sb = animation_get_sprite(&b->ani, i);
+        CU_ASSERT_PTR_NOT_EQUAL(sa, sb);
+        CU_ASSERT_PTR_NOT_NULL(sb->data);
+        CU_ASSERT_PTR_EQUAL(sa->data, sb->data);
+        CU_ASSERT_FALSE(sb->owned);
+    }
+
+    // Pilot stats and hyper mode strings are applied to the copy only
+    str modified;
+    str_from_c(&modified, "A1");
+    animation_set_string(&b->ani, &modified);
+    str_free(&modified);
+    b->damage = 99;
+    CU_ASSERT_STRING_EQUAL(str_c(&a->ani.animation_string), "A10-B10");
+    CU_ASSERT_DOUBLE_EQUAL(a->damage, 10, 0.001);
+
+    // The original and its surfaces stay intact after the copy is gone
+    af_free(&copy);
+    sprite *sa = animation_get_sprite(&a->ani, 1);
+    CU_ASSERT_EQUAL(sa->data->data[5], 5);
+    af_free(&orig);
+}
+
+void test_bk_clone_background(void) {
+    bk orig, copy;
+    CU_ASSERT_FATAL(load_bk(&orig) == 0);
+    bk_clone(&orig, &copy);
+
+    CU_ASSERT_EQUAL(hashmap_size(&copy.infos), hashmap_size(&orig.infos));
+    CU_ASSERT_EQUAL(vector_size(&copy.palettes), vector_size(&orig.palettes));
+    CU_ASSERT_EQUAL(copy.file_id, orig.file_id);
+
+    // Infos iterate in the same order as in the original
+    iterator ia, ib;
+    hashmap_pair *pa, *pb;
+    hashmap_iter_begin(&orig.infos, &ia);
+    hashmap_iter_begin(&copy.infos, &ib);
+    while((pa = iter_next(&ia)) != NULL) {
+        pb = iter_next(&ib);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(pb);
+        CU_ASSERT_EQUAL(((bk_info *)pa->value)->ani.id, ((bk_info *)pb->value)->ani.id);
+    }
+
+    // The background is a private copy, since scenes draw over it.
+    CU_ASSERT_PTR_NOT_EQUAL(copy.background.data, orig.background.data);
+    CU_ASSERT(memcmp(copy.background.data, orig.background.data, orig.background.w * orig.background.h) == 0);
+    copy.background.data[0] ^= 0xFF;
+    CU_ASSERT_NOT_EQUAL(copy.background.data[0], orig.background.data[0]);
+
+    bk_free(&copy);
+    bk_free(&orig);
+}
+
+void resource_cache_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of af clone sprite sharing", test_af_clone_shares_sprites) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of bk clone background", test_bk_clone_background) == NULL) {
+        return;
+    }
+}
@@ -213,6 +213,50 @@ void test_script_all(void) {
     }
 }
 
+// The tag index and frame tick positions must agree with the plain tag list and frame lengths
+static void check_script_index(const sd_script *s) {
+    int pos = 0;
+    for(unsigned f = 0; f < vector_size(&s->frames); f++) {
+        const sd_script_frame *frame = vector_get(&s->frames, f);
+        CU_ASSERT(frame->tick_start == pos);
+        for(int t = 0; t < frame->tick_len; t++) {
+            CU_ASSERT(sd_script_get_frame_at(s, pos + t) == frame);
+            CU_ASSERT(sd_script_get_frame_index_at(s, pos + t) == (int)f);
+        }
+        pos += frame->tick_len;
+        for(int id = 0; id < SD_TAG_COUNT; id++) {
+            CU_ASSERT(sd_script_isset_id(frame, id) == sd_script_isset(frame, sd_taglist[id].tag));
+            CU_ASSERT(sd_script_get_id(frame, id) == sd_script_get(frame, sd_taglist[id].tag));
+        }
+    }
+    CU_ASSERT(sd_script_get_total_ticks(s) == (unsigned)pos);
+    CU_ASSERT(sd_script_get_frame_at(s, pos) == NULL);
+}
+
+void test_script_index(void) {
+    for(int i = 0; i < TEST_STRING_COUNT; i++) {
+        sd_script s, c;
+        CU_ASSERT_FATAL(sd_script_create(&s) == SD_SUCCESS);
+        CU_ASSERT(sd_script_decode(&s, test_strings[i], NULL) == SD_SUCCESS);
+        check_script_index(&s);
+        sd_script_clone(&s, &c);
+        check_script_index(&c);
+        sd_script_free(&c);
+        sd_script_free(&s);
+    }
+
+    // Duplicate tags resolve to the first one, like the string lookups
+    sd_script s;
+    sd_script_create(&s);
+    sd_script_decode(&s, "x+10x+20x-5A1", NULL);
+    const sd_script_frame *frame = sd_script_get_frame(&s, 0);
+    CU_ASSERT(sd_script_get_id(frame, SD_TAG_X_PLUS) == 10);
+    CU_ASSERT(sd_script_get_id(frame, SD_TAG_X_MINUS) == 5);
+    CU_ASSERT(sd_script_isset_id(frame, SD_TAG_X) == 0);
+    CU_ASSERT(sd_script_isset_id(NULL, SD_TAG_X) == 0);
+    sd_script_free(&s);
+}
+
 void test_next_frame_with_sprite(void) {
     CU_ASSERT(sd_script_next_frame_with_sprite(NULL, 0, 0) == -1);       // script NULL
     CU_ASSERT(sd_script_next_frame_with_sprite(&script, -1, 0) == -1);   // nonexistent frame id
@@ -463,4 +507,7 @@ void script_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of all OMF strings", test_script_all) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of script tag and tick indexes", test_script_index) == NULL) {
+        return;
+    }
 }
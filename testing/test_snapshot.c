@@ -0,0 +1,320 @@
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/object.h"
+#include "game/protos/scene.h"
+#include "utils/allocator.h"
+#include <CUnit/CUnit.h>
+
+#define SNAP_OBJECTS 200
+#define SNAP_RESTORES 10
+#define SNAP_SCRIPT "s05bpd1bps1bpn64A100-s1sf3B10-C34"
+
+static game_state gs;
+static scene sc;
+
+static object *add_object(int x) {
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, &gs, vec2i_create(x, 100), vec2f_create(1.0f, 0.0f));
+    object_set_custom_string(obj, SNAP_SCRIPT);
+    game_state_add_object(&gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+    return obj;
+}
+
+static object *object_at(unsigned int index) {
+    render_obj *robj = vector_get(&gs.objects, index);
+    return robj->obj;
+}
+
+void test_snapshot_create(void) {
+    memset(&gs, 0, sizeof(game_state));
+    memset(&sc, 0, sizeof(scene));
+    ticktimer_init(&sc.tick_timer);
+    gs.sc = &sc;
+    gs.clone = true;
+    vector_create(&gs.objects, sizeof(render_obj));
+    object_index_create(&gs.obj_index);
+    vector_create(&gs.sounds, sizeof(playing_sound));
+    game_state_set_keep_deleted(&gs, true);
+    for(int i = 0; i < 2; i++) {
+        gs.players[i] = omf_calloc(1, sizeof(game_player));
+        game_player_create(gs.players[i]);
+    }
+    for(int i = 0; i < SNAP_OBJECTS; i++) {
+        add_object(i);
+    }
+    CU_ASSERT(vector_size(&gs.objects) == SNAP_OBJECTS);
+}
+
+void test_snapshot_free(void) {
+    game_state_set_keep_deleted(&gs, false);
+    for(unsigned int i = 0; i < vector_size(&gs.objects); i++) {
+        object *obj = object_at(i);
+        object_free(obj);
+        omf_free(obj);
+    }
+    vector_free(&gs.objects);
+    object_index_free(&gs.obj_index);
+    vector_free(&gs.sounds);
+    for(int i = 0; i < 2; i++) {
+        game_player_free(gs.players[i]);
+        omf_free(gs.players[i]);
+    }
+    ticktimer_close(&sc.tick_timer);
+}
+
+void test_snapshot_restore(void) {
+    serial ser;
+    serial_create(&ser);
+    gs.tick = 1234;
+    game_player_get_score(gs.players[0])->score = 500;
+    game_state_serialize(&gs, &ser);
+
+    // Mess up the state: move things around, drop a few objects and spawn a new one
+    object *first = object_at(0);
+    uint32_t first_id = first->id;
+    first->pos.x = -1.0f;
+    object_set_custom_string(first, "A1");
+    for(int i = 0; i < 10; i++) {
+        game_state_del_object(&gs, object_at(5));
+    }
+    add_object(9999);
+    gs.tick = 0;
+    game_player_get_score(gs.players[0])->score = 0;
+
+    // The recording stream and clone size belong to the state instance, not to the snapshot
+    sd_rec_stream *stream = (sd_rec_stream *)&ser;
+    gs.rec_stream = stream;
+    gs.clone_struct_bytes = 42;
+
+    serial_read_reset(&ser);
+    CU_ASSERT(game_state_unserialize(&gs, &ser) == 0);
+    CU_ASSERT(ser.rpos == ser.wpos);
+    CU_ASSERT_PTR_EQUAL(gs.rec_stream, stream);
+    CU_ASSERT(gs.clone_struct_bytes == 42);
+    gs.rec_stream = NULL;
+    gs.clone_struct_bytes = 0;
+    CU_ASSERT(gs.tick == 1234);
+    CU_ASSERT(game_player_get_score(gs.players[0])->score == 500);
+    CU_ASSERT(vector_size(&gs.objects) == SNAP_OBJECTS);
+
+    // Live objects are restored in place, dropped ones are recreated in their original order
+    CU_ASSERT_PTR_EQUAL(object_at(0), first);
+    CU_ASSERT(first->id == first_id);
+    CU_ASSERT(first->pos.x == 0.0f);
+    CU_ASSERT(vector_size(&first->animation_state.parser->frames) == 3);
+    for(int i = 0; i < SNAP_OBJECTS; i++) {
+        object *obj = object_at(i);
+        CU_ASSERT(obj->pos.x == (float)i);
+        CU_ASSERT(obj->gs == &gs);
+        CU_ASSERT(vector_size(&obj->animation_state.parser->frames) == 3);
+    }
+    serial_free(&ser);
+}
+
+static void spawn_nothing(object *parent, int id, vec2i pos, vec2f vel, uint8_t mp_flags, int s, int g,
+                          void *userdata) {
+}
+
+static void destroy_nothing(object *parent, int id, void *userdata) {
+}
+
+void test_snapshot_links(void) {
+    static int owner_data;
+    serial ser;
+    serial_create(&ser);
+    object *owner = object_at(0);
+    owner->userdata = &owner_data;
+    object_set_spawn_cb(object_at(5), spawn_nothing, &owner_data);
+    object_set_destroy_cb(object_at(6), destroy_nothing, &sc);
+    game_state_serialize(&gs, &ser);
+
+    game_state_del_object(&gs, object_at(6));
+    game_state_del_object(&gs, object_at(5));
+    gs.delay = 7;
+    gs.paused = 1;
+    serial_read_reset(&ser);
+    CU_ASSERT(game_state_unserialize(&gs, &ser) == 0);
+
+    // Recreated objects find the scene and the object owning their callback userdata again
+    object *spawner = object_at(5);
+    object *destroyer = object_at(6);
+    CU_ASSERT(spawner->animation_state.spawn == spawn_nothing);
+    CU_ASSERT_PTR_EQUAL(spawner->animation_state.spawn_userdata, &owner_data);
+    CU_ASSERT(spawner->animation_state.spawn_owner_id == 0);
+    CU_ASSERT(destroyer->animation_state.destroy == destroy_nothing);
+    CU_ASSERT_PTR_EQUAL(destroyer->animation_state.destroy_userdata, &sc);
+
+    // The net controller delay and the pause flag belong to the state instance
+    CU_ASSERT(gs.delay == 7);
+    CU_ASSERT(gs.paused == 1);
+
+    gs.delay = 0;
+    gs.paused = 0;
+    owner->userdata = NULL;
+    object_set_spawn_cb(spawner, NULL, NULL);
+    object_set_destroy_cb(destroyer, NULL, NULL);
+    serial_free(&ser);
+}
+
+void test_snapshot_restore_allocations(void) {
+    serial ser;
+    serial_create(&ser);
+    game_player_get_score(gs.players[0])->combo_hits = 5;
+    chr_score_end_combo(game_player_get_score(gs.players[0]), vec2i_create(100, 100));
+    playing_sound sound = {0};
+    vector_append(&gs.sounds, &sound);
+    game_state_serialize(&gs, &ser);
+
+    object *objs[SNAP_OBJECTS];
+    for(int i = 0; i < SNAP_OBJECTS; i++) {
+        objs[i] = object_at(i);
+    }
+
+    // Roll back over deleted objects, dropped score texts and sounds, the way a rollback does every tick
+    for(int i = 0; i < SNAP_RESTORES; i++) {
+        game_state_del_object(&gs, object_at(i));
+        game_state_del_object(&gs, object_at(SNAP_OBJECTS - 20));
+        chr_score_reset(game_player_get_score(gs.players[0]), false);
+        vector_clear(&gs.sounds);
+
+        size_t allocs = omf_alloc_count();
+        size_t frees = omf_free_count();
+        serial_read_reset(&ser);
+        CU_ASSERT(game_state_unserialize(&gs, &ser) == 0);
+        CU_ASSERT(omf_alloc_count() == allocs);
+        CU_ASSERT(omf_free_count() == frees);
+    }
+    CU_ASSERT(chr_score_get_num_texts(game_player_get_score(gs.players[0])) == 1);
+    CU_ASSERT(vector_size(&gs.sounds) == 1);
+
+    // The objects came back from the graveyard instead of being reallocated
+    for(int i = 0; i < SNAP_OBJECTS; i++) {
+        CU_ASSERT_PTR_EQUAL(object_at(i), objs[i]);
+    }
+
+    chr_score_reset(game_player_get_score(gs.players[0]), false);
+    vector_clear(&gs.sounds);
+    serial_free(&ser);
+}
+
+void test_snapshot_clone(void) {
+    serial ser;
+    serial_create(&ser);
+    game_state_serialize(&gs, &ser);
+    object_set_custom_string(object_at(1), "A1");
+
+    game_state dst;
+    CU_ASSERT(game_state_clone(&gs, &dst) == 0);
+    CU_ASSERT(vector_size(&dst.objects) == SNAP_OBJECTS);
+
+    // Animation parsers are shared with the clone instead of copied
+    for(int i = 0; i < SNAP_OBJECTS; i++) {
+        object *obj = object_at(i);
+        object *copy = ((render_obj *)vector_get(&dst.objects, i))->obj;
+        CU_ASSERT_PTR_EQUAL(copy->animation_state.parser, obj->animation_state.parser);
+    }
+    size_t expected = sizeof(game_state) + SNAP_OBJECTS * (sizeof(render_obj) + sizeof(object)) +
+                      2 * sizeof(game_player) + sizeof(scene);
+    CU_ASSERT(dst.clone_struct_bytes == expected);
+
+    // Changing the clone leaves the original alone
+    object *copy = ((render_obj *)vector_get(&dst.objects, 0))->obj;
+    object_set_custom_string(copy, "A1");
+    CU_ASSERT(vector_size(&copy->animation_state.parser->frames) == 1);
+    CU_ASSERT(vector_size(&object_at(0)->animation_state.parser->frames) == 3);
+
+    // Restoring the original must not write through to the parsers it shares with the clone
+    copy = ((render_obj *)vector_get(&dst.objects, 1))->obj;
+    serial_read_reset(&ser);
+    CU_ASSERT(game_state_unserialize(&gs, &ser) == 0);
+    CU_ASSERT(vector_size(&object_at(1)->animation_state.parser->frames) == 3);
+    CU_ASSERT(vector_size(&copy->animation_state.parser->frames) == 1);
+    serial_free(&ser);
+
+    game_state_clone_free(&dst);
+}
+
+// Every object in the list can be found by its id, and the index holds nothing else
+static void check_index(game_state *state) {
+    CU_ASSERT(object_index_size(&state->obj_index) == vector_size(&state->objects));
+    for(unsigned int i = 0; i < vector_size(&state->objects); i++) {
+        object *obj = ((render_obj *)vector_get(&state->objects, i))->obj;
+        CU_ASSERT_PTR_EQUAL(game_state_find_object(state, obj->id), obj);
+    }
+}
+
+void test_snapshot_index(void) {
+    check_index(&gs);
+
+    // Deleted objects are gone from the index, new ones are added
+    uint32_t gone = object_at(3)->id;
+    game_state_del_object(&gs, object_at(3));
+    CU_ASSERT_PTR_NULL(game_state_find_object(&gs, gone));
+    object *added = add_object(500);
+    CU_ASSERT_PTR_EQUAL(game_state_find_object(&gs, added->id), added);
+    check_index(&gs);
+
+    // Clones get an index of their own, and freeing them leaves the original intact
+    for(int round = 0; round < 3; round++) {
+        game_state dst;
+        CU_ASSERT(game_state_clone(&gs, &dst) == 0);
+        check_index(&dst);
+        object *copy = game_state_find_object(&dst, added->id);
+        CU_ASSERT(copy != NULL && copy != added);
+        game_state_del_object(&dst, copy);
+        CU_ASSERT_PTR_NULL(game_state_find_object(&dst, added->id));
+        check_index(&dst);
+        game_state_clone_free(&dst);
+        check_index(&gs);
+    }
+
+    // Restoring a snapshot rebuilds the index
+    serial ser;
+    serial_create(&ser);
+    game_state_serialize(&gs, &ser);
+    game_state_del_object(&gs, object_at(0));
+    add_object(501);
+    serial_read_reset(&ser);
+    CU_ASSERT(game_state_unserialize(&gs, &ser) == 0);
+    CU_ASSERT_PTR_EQUAL(game_state_find_object(&gs, added->id), added);
+    check_index(&gs);
+    serial_free(&ser);
+
+    // A scene change only keeps the persistent objects
+    object *kept = omf_calloc(1, sizeof(object));
+    object_create(kept, &gs, vec2i_create(0, 0), vec2f_create(0.0f, 0.0f));
+    game_state_add_object(&gs, kept, RENDER_LAYER_MIDDLE, 0, 1);
+    uint32_t dropped = object_at(0)->id;
+    uint32_t added_id = added->id;
+    game_state_clear_scene_objects(&gs);
+    CU_ASSERT(vector_size(&gs.objects) == 1);
+    CU_ASSERT_PTR_EQUAL(game_state_find_object(&gs, kept->id), kept);
+    CU_ASSERT_PTR_NULL(game_state_find_object(&gs, dropped));
+    CU_ASSERT_PTR_NULL(game_state_find_object(&gs, added_id));
+    check_index(&gs);
+}
+
+void snapshot_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of game state snapshot create", test_snapshot_create) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of game state snapshot restore", test_snapshot_restore) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of game state snapshot links", test_snapshot_links) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of game state snapshot restore allocations", test_snapshot_restore_allocations) ==
+       NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of game state clone", test_snapshot_clone) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of object index", test_snapshot_index) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of game state snapshot free", test_snapshot_free) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,305 @@
+#include "utils/png_reader.h"
+#include "video/enums.h"
+#include "video/renderers/software/helpers/index_target.h"
+#include "video/renderers/software/helpers/row_blit.h"
+#include "video/renderers/software/software_renderer.h"
+#include "video/vga_state.h"
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SCENE_W 320
+#define SCENE_H 200
+#define GOLDEN_SCENE TESTS_ROOT_DIR "/golden/software_scene.png"
+
+static unsigned char sprite_data[24][32];
+static unsigned char background_data[40][64];
+static vga_remap_tables remaps;
+static renderer sw; // Drawn to through its vtable when the scene has no index target
+static unsigned char screenshot[SCENE_W * SCENE_H * 3];
+
+static void make_scene_data(void) {
+    for(int y = 0; y < 24; y++) {
+        for(int x = 0; x < 32; x++) {
+            bool border = x < 2 || y < 2 || x > 29 || y > 21;
+            sprite_data[y][x] = border ? 0 : (unsigned char)(16 + x * 3 + y * 5);
+        }
+    }
+    for(int y = 0; y < 40; y++) {
+        for(int x = 0; x < 64; x++) {
+            background_data[y][x] = (unsigned char)(((x / 8 + y / 8) & 1) ? 200 + x % 8 : 100 + y % 8);
+        }
+    }
+    for(int t = 0; t < VGA_REMAP_COUNT; t++) {
+        for(int i = 0; i < 256; i++) {
+            remaps.tables[t].data[i] = (unsigned char)(i / 2 + t * 11);
+        }
+    }
+}
+
+static void draw(index_target *target, const surface *src, int x, int y, int w, int h, int remap_offset,
+                 int remap_rounds, int palette_offset, int palette_limit, int opacity, unsigned int flip_mode,
+                 unsigned int options) {
+    SDL_Rect dst = {x, y, w, h};
+    if(target == NULL) {
+        sw.draw_surface(sw.ctx, src, &dst, remap_offset, remap_rounds, palette_offset, palette_limit, opacity,
+                        flip_mode, options);
+        return;
+    }
+    index_target_draw(target, &remaps, src, &dst, remap_offset, remap_rounds, palette_offset, palette_limit, opacity,
+                      flip_mode, options);
+}
+
+static void grab_screenshot(const SDL_Rect *rect, unsigned char *data, bool flipped) {
+    CU_ASSERT(rect->w == SCENE_W && rect->h == SCENE_H);
+    CU_ASSERT_FALSE(flipped);
+    memcpy(screenshot, data, sizeof(screenshot));
+}
+
+/**
+ * Draws one of each kind of draw call the game makes, on top of a scaled background.
+ */
+static void render_scene(index_target *target) {
+    surface sprite = {0, 32, 24, 0, &sprite_data[0][0]};
+    surface background = {0, 64, 40, -1, &background_data[0][0]};
+
+    if(target != NULL) {
+        index_target_clear(target);
+    } else {
+        sw.render_prepare(sw.ctx);
+    }
+    draw(target, &background, 0, 0, SCENE_W, SCENE_H, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+
+    // Placement, flipping, scaling and clipping
+    draw(target, &sprite, 10, 10, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+    draw(target, &sprite, 50, 10, 32, 24, 0, 0, 0, 255, 255, FLIP_HORIZONTAL, 0);
+    draw(target, &sprite, 90, 10, 48, 36, 0, 0, 0, 255, 255, FLIP_VERTICAL, 0);
+    draw(target, &sprite, 150, 10, 16, 12, 0, 0, 0, 255, 255, FLIP_HORIZONTAL | FLIP_VERTICAL, 0);
+    draw(target, &sprite, -10, 185, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+    draw(target, &sprite, 300, -5, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+
+    // Palette offset and limit, sprite remaps and masks
+    draw(target, &sprite, 180, 10, 32, 24, 0, 0, 16, 100, 255, FLIP_NONE, 0);
+    draw(target, &sprite, 220, 10, 32, 24, 0, 0, -20, 255, 255, FLIP_NONE, 0);
+    draw(target, &sprite, 260, 10, 32, 24, 3, 0, 0, 255, 255, FLIP_NONE, REMAP_SPRITE);
+    draw(target, &sprite, 10, 60, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, SPRITE_MASK);
+
+    // Opacity decimation
+    draw(target, &sprite, 50, 60, 32, 24, 0, 0, 0, 255, 128, FLIP_NONE, 0);
+    draw(target, &sprite, 90, 60, 32, 24, 0, 0, 0, 255, 16, FLIP_NONE, 0);
+
+    // Index add, on its own and on top of other sprites
+    draw(target, &sprite, 130, 60, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, SPRITE_MASK | SPRITE_INDEX_ADD);
+    draw(target, &sprite, 170, 60, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, SPRITE_INDEX_ADD);
+    draw(target, &sprite, 10, 70, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, SPRITE_MASK | SPRITE_INDEX_ADD);
+
+    // Remap rounds, as used for shadows and lightning
+    draw(target, &sprite, 210, 60, 32, 24, 5, 2, 0, 255, 255, FLIP_NONE, SPRITE_MASK);
+    draw(target, &sprite, 250, 60, 32, 24, 0, 1, 0, 255, 255, FLIP_NONE, 0);
+    draw(target, &sprite, 20, 110, 64, 48, 2, 3, 0, 255, 255, FLIP_HORIZONTAL, SPRITE_MASK);
+
+    // Set over a remapped area resets it
+    draw(target, &sprite, 40, 120, 32, 24, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+}
+
+void test_row_blit_kernels(void) {
+    uint8_t src[80], other[80], levels[80], mask[80], dst[80], expect[80];
+    for(int i = 0; i < 80; i++) {
+        src[i] = (i * 37) % 7;
+        other[i] = 200 + i;
+        levels[i] = (i * 53) & 0xFF;
+    }
+
+    // Odd lengths and offsets exercise both the vector and the tail loops
+    for(int n = 0; n <= 67; n += 11) {
+        int off = n % 5;
+
+        row_blit_mask(mask, src + off, 3, n);
+        for(int i = 0; i < n; i++) {
+            CU_ASSERT_EQUAL(mask[i], src[off + i] != 3 ? 0xFF : 0);
+        }
+
+        row_blit_mask_opacity(mask, levels + off, 100, n);
+        for(int i = 0; i < n; i++) {
+            bool keep = src[off + i] != 3 && levels[off + i] <= 100;
+            CU_ASSERT_EQUAL(mask[i], keep ? 0xFF : 0);
+        }
+
+        memcpy(dst, other, sizeof(dst));
+        row_blit_copy(dst, src + off, mask, n);
+        for(int i = 0; i < n; i++) {
+            CU_ASSERT_EQUAL(dst[i], mask[i] ? src[off + i] : other[i]);
+        }
+
+        memcpy(dst, other, sizeof(dst));
+        row_blit_fill(dst, 42, mask, n);
+        for(int i = 0; i < n; i++) {
+            CU_ASSERT_EQUAL(dst[i], mask[i] ? 42 : other[i]);
+        }
+
+        row_blit_add_saturate(dst, other, levels + off, n);
+        for(int i = 0; i < n; i++) {
+            int sum = other[i] + levels[off + i];
+            expect[i] = sum > 255 ? 255 : sum;
+            CU_ASSERT_EQUAL(dst[i], expect[i]);
+        }
+    }
+
+    // Surfaces without a transparent index draw everything
+    row_blit_mask(mask, src, -1, 80);
+    for(int i = 0; i < 80; i++) {
+        CU_ASSERT_EQUAL(mask[i], 0xFF);
+    }
+}
+
+void test_software_scene(void) {
+    static unsigned char frame[SCENE_W * SCENE_H];
+    static unsigned char golden[SCENE_W * SCENE_H];
+    make_scene_data();
+    index_target *target = index_target_create(SCENE_W, SCENE_H);
+    render_scene(target);
+    index_target_resolve(target, &remaps, frame);
+    index_target_free(&target);
+    CU_ASSERT_PTR_NULL(target);
+
+    FILE *handle = fopen(GOLDEN_SCENE, "rb");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(handle);
+    fclose(handle);
+    if(!read_paletted_png(GOLDEN_SCENE, golden)) {
+        // Build without libpng; the scene has still been exercised.
+        return;
+    }
+    int mismatches = 0;
+    for(int i = 0; i < SCENE_W * SCENE_H; i++) {
+        if(frame[i] != golden[i]) {
+            if(mismatches++ == 0) {
+                printf("\nFirst mismatch at %d,%d: got %d, expected %d\n", i % SCENE_W, i / SCENE_W, frame[i],
+                       golden[i]);
+            }
+        }
+    }
+    CU_ASSERT_EQUAL(mismatches, 0);
+}
+
+void test_software_read_area(void) {
+    unsigned char data[4] = {1, 2, 3, 4};
+    surface block = {0, 2, 2, -1, data};
+    make_scene_data();
+    index_target *target = index_target_create(SCENE_W, SCENE_H);
+    draw(target, &block, 10, 20, 2, 2, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+
+    // Area origin is at the bottom left corner, and rows come out bottom to top like glReadPixels.
+    unsigned char out[9];
+    SDL_Rect area = {10, SCENE_H - 22, 3, 3};
+    index_target_read_area(target, &area, out);
+    unsigned char expect[9] = {3, 4, 0, 1, 2, 0, 0, 0, 0};
+    CU_ASSERT(memcmp(out, expect, sizeof(out)) == 0);
+
+    // Outside of the target reads as zero
+    SDL_Rect outside = {SCENE_W - 1, -1, 3, 3};
+    memset(out, 0xFF, sizeof(out));
+    index_target_read_area(target, &outside, out);
+    for(int i = 0; i < 9; i++) {
+        CU_ASSERT_EQUAL(out[i], 0);
+    }
+    index_target_free(&target);
+}
+
+static bool pixel_is(int x, int y, const vga_color *color) {
+    const unsigned char *rgb = &screenshot[(y * SCENE_W + x) * 3];
+    return rgb[0] == color->r && rgb[1] == color->g && rgb[2] == color->b;
+}
+
+void test_software_renderer_vtable(void) {
+    static unsigned char golden[SCENE_W * SCENE_H];
+    vga_palette palette;
+    vga_color black = {0, 0, 0};
+    for(int i = 0; i < 256; i++) {
+        palette.colors[i].r = i;
+        palette.colors[i].g = 255 - i;
+        palette.colors[i].b = (i * 7) & 0xFF;
+    }
+    make_scene_data();
+    vga_state_init();
+    vga_state_set_base_palette_from(&palette);
+    vga_state_set_remaps_from(&remaps);
+
+    // The unit tests don't initialize SDL video, so this has to work without a window
+    software_renderer_set_callbacks(&sw);
+    CU_ASSERT(sw.is_available());
+    sw.create(&sw);
+    CU_ASSERT_FATAL(sw.setup_context(sw.ctx, SCENE_W * 2, SCENE_H * 2, false, false));
+    CU_ASSERT(sw.reset_context_with(sw.ctx, SCENE_W * 3, SCENE_H * 3, false, true));
+    int w, h;
+    bool fullscreen, vsync;
+    sw.get_context_state(sw.ctx, &w, &h, &fullscreen, &vsync);
+    CU_ASSERT(w == SCENE_W * 3 && h == SCENE_H * 3 && !fullscreen && vsync);
+    sw.reset_context(sw.ctx);
+    sw.signal_scene_change(sw.ctx);
+    sw.signal_draw_atlas(sw.ctx, true);
+    vga_state_render();
+
+    // The whole frame, palette included, matches the golden scene
+    bool have_golden = read_paletted_png(GOLDEN_SCENE, golden);
+    render_scene(NULL);
+    sw.capture_screen(sw.ctx, grab_screenshot);
+    sw.render_finish(sw.ctx);
+    int mismatches = 0;
+    for(int i = 0; have_golden && i < SCENE_W * SCENE_H; i++) {
+        mismatches += !pixel_is(i % SCENE_W, i / SCENE_W, &palette.colors[golden[i]]);
+    }
+    CU_ASSERT_EQUAL(mismatches, 0);
+
+    // Screen shakes move the frame right by x and up by y, and uncover black
+    sw.move_target(sw.ctx, 4, 3);
+    render_scene(NULL);
+    sw.capture_screen(sw.ctx, grab_screenshot);
+    sw.render_finish(sw.ctx);
+    sw.move_target(sw.ctx, 0, 0);
+    mismatches = 0;
+    for(int y = 0; have_golden && y < SCENE_H; y++) {
+        for(int x = 0; x < SCENE_W; x++) {
+            bool uncovered = x < 4 || y >= SCENE_H - 3;
+            const vga_color *expect = uncovered ? &black : &palette.colors[golden[(y + 3) * SCENE_W + x - 4]];
+            mismatches += !pixel_is(x, y, expect);
+        }
+    }
+    CU_ASSERT_EQUAL(mismatches, 0);
+
+    // Areas are read back into surfaces top to bottom
+    unsigned char data[4] = {1, 2, 3, 4};
+    surface block = {0, 2, 2, -1, data};
+    surface area_surface;
+    SDL_Rect area = {10, SCENE_H - 22, 3, 3};
+    sw.render_area_prepare(sw.ctx, &area);
+    draw(NULL, &block, 10, 20, 2, 2, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+    sw.render_area_finish(sw.ctx, &area_surface);
+    unsigned char expect[9] = {0, 0, 0, 1, 2, 0, 3, 4, 0};
+    CU_ASSERT(area_surface.w == 3 && area_surface.h == 3);
+    CU_ASSERT(memcmp(area_surface.data, expect, sizeof(expect)) == 0);
+    sw.signal_surface_released(sw.ctx, area_surface.guid);
+    surface_free(&area_surface);
+
+    unsigned int items;
+    float occupancy, fragmentation;
+    CU_ASSERT_FALSE(sw.get_atlas_stats(sw.ctx, &items, &occupancy, &fragmentation));
+    sw.close_context(sw.ctx);
+    sw.destroy(&sw);
+    CU_ASSERT_PTR_NULL(sw.ctx);
+    vga_state_close();
+}
+
+void software_renderer_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of row blit kernels", test_row_blit_kernels) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of software rendered scene", test_software_scene) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of software area readback", test_software_read_area) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of software renderer callbacks", test_software_renderer_vtable) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,89 @@
+#include "audio/sound_cache.h"
+#include "utils/allocator.h"
+#include <CUnit/CUnit.h>
+
+static const sound_cache_format format = {48000, 0x8010, 2};
+
+static char *converted(size_t len) {
+    return omf_calloc(1, len);
+}
+
+void test_sound_cache_hit(void) {
+    sound_cache cache;
+    sound_cache_create(&cache, 1024);
+
+    CU_ASSERT_PTR_NULL(sound_cache_acquire(&cache, 0, 8000, &format));
+    char *buf = converted(100);
+    sound_cache_entry *entry = sound_cache_add(&cache, 0, 8000, &format, buf, 100);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+    CU_ASSERT_PTR_EQUAL(entry->buf, buf);
+    sound_cache_release(&cache, entry);
+
+    // Same sample at the same pitch and output format is found; other samples, pitches and formats are not
+    sound_cache_format mono = format;
+    mono.channels = 1;
+    CU_ASSERT_PTR_EQUAL(sound_cache_acquire(&cache, 0, 8000, &format), entry);
+    CU_ASSERT_PTR_NULL(sound_cache_acquire(&cache, 1, 8000, &format));
+    CU_ASSERT_PTR_NULL(sound_cache_acquire(&cache, 0, 8001, &format));
+    CU_ASSERT_PTR_NULL(sound_cache_acquire(&cache, 0, 8000, &mono));
+    CU_ASSERT(entry->users == 1);
+    sound_cache_release(&cache, entry);
+
+    // Looking up without acquiring does not count
+    CU_ASSERT(sound_cache_contains(&cache, 0, 8000, &format));
+    CU_ASSERT_FALSE(sound_cache_contains(&cache, 0, 8000, &mono));
+    CU_ASSERT(entry->users == 0);
+
+    CU_ASSERT(cache.hits == 1);
+    CU_ASSERT(cache.misses == 4);
+    CU_ASSERT(cache.bytes == 100);
+    sound_cache_free(&cache);
+}
+
+void test_sound_cache_evict(void) {
+    sound_cache cache;
+    sound_cache_create(&cache, 300);
+
+    sound_cache_entry *a = sound_cache_add(&cache, 0, 8000, &format, converted(100), 100);
+    sound_cache_entry *b = sound_cache_add(&cache, 1, 8000, &format, converted(100), 100);
+    sound_cache_entry *c = sound_cache_add(&cache, 2, 8000, &format, converted(100), 100);
+    sound_cache_release(&cache, a);
+    sound_cache_release(&cache, b);
+
+    // The least recently used sample goes first
+    sound_cache_release(&cache, sound_cache_acquire(&cache, 0, 8000, &format));
+    sound_cache_entry *d = sound_cache_add(&cache, 3, 8000, &format, converted(100), 100);
+    CU_ASSERT_PTR_NOT_NULL(d);
+    CU_ASSERT(cache.evictions == 1);
+    CU_ASSERT(cache.bytes == 300);
+    CU_ASSERT_PTR_NULL(sound_cache_acquire(&cache, 1, 8000, &format));
+    sound_cache_entry *found = sound_cache_acquire(&cache, 0, 8000, &format);
+    CU_ASSERT_PTR_NOT_NULL(found);
+    sound_cache_release(&cache, found);
+
+    // Samples that are still playing are never evicted
+    CU_ASSERT_FALSE(sound_cache_has_room(&cache, 1));
+    char *big = converted(250);
+    CU_ASSERT_PTR_NULL(sound_cache_add(&cache, 1, 8000, &format, big, 250));
+    omf_free(big);
+    found = sound_cache_acquire(&cache, 2, 8000, &format);
+    CU_ASSERT_PTR_EQUAL(found, c);
+    sound_cache_release(&cache, found);
+    sound_cache_release(&cache, c);
+    sound_cache_release(&cache, d);
+
+    // Flushing keeps nothing that is not in use
+    sound_cache_flush(&cache);
+    CU_ASSERT(cache.count == 0);
+    CU_ASSERT(cache.bytes == 0);
+    sound_cache_free(&cache);
+}
+
+void sound_cache_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of sound cache lookup", test_sound_cache_hit) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of sound cache eviction", test_sound_cache_evict) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,201 @@
+#include "formats/error.h"
+#include "formats/sprite.h"
+#include "utils/allocator.h"
+#include <CUnit/CUnit.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_ROUNDS 3000
+
+static uint32_t fuzz_state;
+
+static uint32_t fuzz_next(void) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 17;
+    fuzz_state ^= fuzz_state << 5;
+    return fuzz_state;
+}
+
+/**
+ * The pixel-at-a-time decoder that sd_sprite_vga_decode and sd_sprite_rgba_decode replaced. It did no bounds
+ * checking, so this copy stops at the first read or write it would have done out of bounds, and reports it.
+ * Pass bpp 1 for VGA output, or 4 for RGBA output.
+ */
+static int reference_decode(unsigned char *dst, int bpp, const sd_sprite *src, const vga_palette *pal,
+                            bool *undefined) {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    int i = 0;
+    uint16_t c = 0;
+    uint16_t data = 0;
+    char op = 0;
+    int size = src->width * src->height;
+
+    *undefined = false;
+    while(i < src->len) {
+        if(i + 1 >= src->len) {
+            *undefined = true;
+            return 0;
+        }
+        c = (uint8_t)src->data[i] + ((uint8_t)src->data[i + 1] << 8);
+        op = c % 4;
+        data = c / 4;
+        i += 2;
+        switch(op) {
+            case 0:
+                x = data;
+                break;
+            case 2:
+                y = data;
+                break;
+            case 1:
+                while(data > 0) {
+                    int pos = ((y * src->width) + x);
+                    if(i >= src->len || pos >= size) {
+                        *undefined = true;
+                        return 0;
+                    }
+                    uint8_t b = src->data[i];
+                    if(bpp == 1) {
+                        dst[pos] = b;
+                    } else {
+                        dst[pos * 4 + 0] = (uint8_t)pal->colors[b].r;
+                        dst[pos * 4 + 1] = (uint8_t)pal->colors[b].g;
+                        dst[pos * 4 + 2] = (uint8_t)pal->colors[b].b;
+                        dst[pos * 4 + 3] = (uint8_t)255;
+                    }
+                    i++;
+                    x++;
+                    data--;
+                }
+                x = 0;
+                break;
+            case 3:
+                if(i != src->len) {
+                    return SD_INVALID_INPUT;
+                }
+                break;
+        }
+    }
+    return SD_SUCCESS;
+}
+
+static void make_sprite(sd_sprite *spr, int mode) {
+    int w = 1 + fuzz_next() % 48;
+    int h = 1 + fuzz_next() % 48;
+    sd_vga_image img;
+    sd_vga_image_create(&img, w, h);
+    uint32_t fill = fuzz_next() % 4;
+    for(int i = 0; i < w * h; i++) {
+        img.data[i] = (fuzz_next() % 4 < fill) ? 0 : fuzz_next() % 256;
+    }
+    sd_sprite_create(spr);
+    sd_sprite_vga_encode(spr, &img);
+    sd_vga_image_free(&img);
+
+    if(mode == 1) {
+        // Corrupt a few bytes of a valid sprite
+        int count = 1 + fuzz_next() % 4;
+        for(int i = 0; i < count; i++) {
+            spr->data[fuzz_next() % spr->len] = fuzz_next() % 256;
+        }
+    } else if(mode == 2) {
+        // Random garbage of random length
+        omf_free(spr->data);
+        spr->len = 1 + fuzz_next() % 64;
+        spr->data = omf_calloc(1, spr->len);
+        for(int i = 0; i < spr->len; i++) {
+            spr->data[i] = fuzz_next() % 256;
+        }
+    }
+    if(mode != 0 && fuzz_next() % 4 == 0) {
+        spr->width = 1 + fuzz_next() % 64;
+        spr->height = 1 + fuzz_next() % 64;
+    }
+}
+
+static void check_decode(const sd_sprite *spr, const vga_palette *pal, int *compared) {
+    sd_vga_image vga;
+    sd_rgba_image rgba;
+    bool undefined;
+
+    int ret = sd_sprite_vga_decode(&vga, spr);
+    unsigned char *expected = omf_calloc(1, vga.len);
+    int expected_ret = reference_decode(expected, 1, spr, pal, &undefined);
+    if(undefined) {
+        // The old decoder would have touched memory out of bounds; now this is an error.
+        CU_ASSERT_EQUAL(ret, SD_INVALID_INPUT);
+    } else {
+        CU_ASSERT_EQUAL(ret, expected_ret);
+        CU_ASSERT(memcmp(vga.data, expected, vga.len) == 0);
+        (*compared)++;
+    }
+    omf_free(expected);
+    sd_vga_image_free(&vga);
+
+    ret = sd_sprite_rgba_decode(&rgba, spr, pal);
+    expected = omf_calloc(1, rgba.len);
+    expected_ret = reference_decode(expected, 4, spr, pal, &undefined);
+    if(undefined) {
+        CU_ASSERT_EQUAL(ret, SD_INVALID_INPUT);
+    } else {
+        CU_ASSERT_EQUAL(ret, expected_ret);
+        CU_ASSERT(memcmp(rgba.data, expected, rgba.len) == 0);
+    }
+    omf_free(expected);
+    sd_rgba_image_free(&rgba);
+}
+
+void test_sprite_decode_fuzz(void) {
+    vga_palette pal;
+    sd_sprite spr;
+    int compared[3] = {0, 0, 0};
+    fuzz_state = 0x12345678;
+    for(int i = 0; i < 256; i++) {
+        pal.colors[i].r = fuzz_next() % 256;
+        pal.colors[i].g = fuzz_next() % 256;
+        pal.colors[i].b = fuzz_next() % 256;
+    }
+    for(int round = 0; round < FUZZ_ROUNDS; round++) {
+        int mode = round % 3;
+        make_sprite(&spr, mode);
+        check_decode(&spr, &pal, &compared[mode]);
+        sd_sprite_free(&spr);
+    }
+
+    // Valid sprites must always decode the same, and the broken ones should still hit the identical path often.
+    CU_ASSERT_EQUAL(compared[0], FUZZ_ROUNDS / 3);
+    CU_ASSERT(compared[1] > 0);
+    CU_ASSERT(compared[2] > 0);
+}
+
+void test_sprite_decode_roundtrip(void) {
+    sd_vga_image img, out;
+    sd_sprite spr;
+    sd_vga_image_create(&img, 5, 4);
+    for(int i = 0; i < 5 * 4; i++) {
+        img.data[i] = (i % 3) ? i : 0;
+    }
+    sd_sprite_create(&spr);
+    CU_ASSERT(sd_sprite_vga_encode(&spr, &img) == SD_SUCCESS);
+    CU_ASSERT(sd_sprite_vga_decode(&out, &spr) == SD_SUCCESS);
+    CU_ASSERT(memcmp(img.data, out.data, img.len) == 0);
+
+    // A run past the end of the image is rejected
+    spr.height = 3;
+    sd_vga_image_free(&out);
+    CU_ASSERT(sd_sprite_vga_decode(&out, &spr) == SD_INVALID_INPUT);
+
+    sd_vga_image_free(&out);
+    sd_vga_image_free(&img);
+    sd_sprite_free(&spr);
+}
+
+void sprite_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of sprite decode roundtrip", test_sprite_decode_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of sprite decoding against the reference decoder", test_sprite_decode_fuzz) == NULL) {
+        return;
+    }
+}
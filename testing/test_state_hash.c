@@ -0,0 +1,96 @@
+#include "game/utils/state_hash.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+static uint64_t hash_fields(int64_t a, int64_t b, float f) {
+    state_hash h;
+    state_hash_init(&h, NULL, NULL);
+    state_hash_begin(&h, "obj", 0, true);
+    state_hash_int(&h, "a", a);
+    state_hash_int(&h, "b", b);
+    state_hash_float(&h, "f", f);
+    return state_hash_finish(&h);
+}
+
+void test_state_hash_fields(void) {
+    uint64_t base = hash_fields(1, 2, 1.5f);
+    CU_ASSERT_EQUAL(base, hash_fields(1, 2, 1.5f));
+    CU_ASSERT_NOT_EQUAL(base, hash_fields(2, 1, 1.5f));
+    CU_ASSERT_NOT_EQUAL(base, hash_fields(1, 3, 1.5f));
+    CU_ASSERT_NOT_EQUAL(base, hash_fields(1, 2, 1.5000001f));
+    CU_ASSERT_EQUAL(hash_fields(1, 2, 0.0f), hash_fields(1, 2, -0.0f));
+}
+
+void test_state_hash_sections(void) {
+    state_hash h;
+    uint64_t hashes[3];
+    for(int i = 0; i < 3; i++) {
+        state_hash_init(&h, NULL, NULL);
+        state_hash_begin(&h, "obj", 0, true);
+        state_hash_int(&h, "x", 10);
+        state_hash_begin(&h, "scrap", 0, false);
+        state_hash_int(&h, "x", i);
+        if(i == 2) {
+            state_hash_begin(&h, "obj", 1, true);
+            state_hash_int(&h, "x", 10);
+        }
+        hashes[i] = state_hash_finish(&h);
+    }
+
+    // Sections that are not synced do not change the hash, but a new synced section does
+    CU_ASSERT_EQUAL(hashes[0], hashes[1]);
+    CU_ASSERT_NOT_EQUAL(hashes[0], hashes[2]);
+}
+
+typedef struct section_log {
+    int count;
+    char names[4][32];
+    char fields[4][128];
+    bool synced[4];
+} section_log;
+
+static void log_section(void *userdata, const char *name, uint64_t hash, bool synced, const char *fields) {
+    section_log *log = userdata;
+    if(log->count < 4) {
+        strncpy(log->names[log->count], name, sizeof(log->names[0]) - 1);
+        strncpy(log->fields[log->count], fields, sizeof(log->fields[0]) - 1);
+        log->synced[log->count] = synced;
+    }
+    log->count++;
+}
+
+void test_state_hash_callback(void) {
+    section_log log;
+    memset(&log, 0, sizeof(log));
+    uint8_t buf[] = {0xde, 0xad};
+
+    state_hash h;
+    state_hash_init(&h, log_section, &log);
+    state_hash_begin(&h, "har", 1, true);
+    state_hash_int(&h, "health", -5);
+    state_hash_float(&h, "vel_y", 0.25f);
+    state_hash_buf(&h, "inputs", buf, sizeof(buf));
+    state_hash_begin(&h, "scrap", 3, false);
+    state_hash_int(&h, "age", 7);
+    state_hash_finish(&h);
+
+    CU_ASSERT_EQUAL(log.count, 2);
+    CU_ASSERT_STRING_EQUAL(log.names[0], "har.1");
+    CU_ASSERT_STRING_EQUAL(log.fields[0], "health=-5 vel_y=0.25 inputs=dead");
+    CU_ASSERT(log.synced[0]);
+    CU_ASSERT_STRING_EQUAL(log.names[1], "scrap.3");
+    CU_ASSERT_STRING_EQUAL(log.fields[1], "age=7");
+    CU_ASSERT_FALSE(log.synced[1]);
+}
+
+void state_hash_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of state hash fields", test_state_hash_fields) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of state hash sections", test_state_hash_sections) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of state hash callback", test_state_hash_callback) == NULL) {
+        return;
+    }
+}
@@ -1,6 +1,7 @@
 #include <CUnit/Basic.h>
 #include <CUnit/CUnit.h>
 #include <game/gui/text_render.h>
+#include <stdio.h>
 
 void test_text_find_max_strlen(void) {
     text_settings tconf;
@@ -156,6 +157,102 @@ static void test_text_find_max_strlen_pilot_bio(void) {
         text_find_max_strlen(&tconf, 26, "her reclusive disposition and strong will, little is known of her."), 26);
 }
 
+// Renders the text and tells whether its layout came from the cache. The fonts are not loaded in the tests, so
+// nothing is drawn, but the layouts are still computed and cached.
+static bool render_cached(const text_settings *settings, int w, const char *text) {
+    text_cache_stats before, after;
+    text_render_cache_stats(&before);
+    text_render(settings, TEXT_UNSELECTED, 0, 0, w, 100, text);
+    text_render_cache_stats(&after);
+    CU_ASSERT_EQUAL(after.hits + after.misses, before.hits + before.misses + 1);
+    return after.hits > before.hits;
+}
+
+static void test_text_render_cache_hits(void) {
+    text_settings tconf;
+    text_defaults(&tconf);
+    text_render_cache_clear();
+
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "PLAYER 1"));
+    CU_ASSERT_TRUE(render_cached(&tconf, 100, "PLAYER 1"));
+    CU_ASSERT_TRUE(render_cached(&tconf, 100, "PLAYER 1"));
+
+    // Different text, box size or layout settings are different layouts
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "PLAYER 2"));
+    CU_ASSERT_FALSE(render_cached(&tconf, 50, "PLAYER 1"));
+    tconf.halign = TEXT_CENTER;
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "PLAYER 1"));
+    CU_ASSERT_TRUE(render_cached(&tconf, 100, "PLAYER 1"));
+
+    // Colors and shadows do not change the layout
+    tconf.cforeground = 0x10;
+    tconf.shadow = TEXT_SHADOW_RIGHT;
+    CU_ASSERT_TRUE(render_cached(&tconf, 100, "PLAYER 1"));
+
+    // text_render_str shares the layouts with text_render
+    str text;
+    str_from_c(&text, "PLAYER 1 WINS");
+    str_cut(&text, 5);
+    text_cache_stats before, after;
+    text_render_cache_stats(&before);
+    text_render_str(&tconf, TEXT_UNSELECTED, 0, 0, 100, 100, &text);
+    text_render_cache_stats(&after);
+    CU_ASSERT_EQUAL(after.hits, before.hits + 1);
+    str_free(&text);
+}
+
+static void test_text_render_cache_invalidation(void) {
+    text_settings tconf;
+    text_defaults(&tconf);
+    text_render_cache_clear();
+
+    // Every font is a layout of its own
+    tconf.font = FONT_BIG;
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "ROUND 1"));
+    tconf.font = FONT_SMALL;
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "ROUND 1"));
+    tconf.font = FONT_BIG;
+    CU_ASSERT_TRUE(render_cached(&tconf, 100, "ROUND 1"));
+
+    // Freeing the glyphs drops every layout that points at them
+    fonts_close();
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "ROUND 1"));
+    CU_ASSERT_TRUE(render_cached(&tconf, 100, "ROUND 1"));
+
+    text_render_cache_clear();
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "ROUND 1"));
+}
+
+static void test_text_render_cache_eviction(void) {
+    text_settings tconf;
+    text_defaults(&tconf);
+    text_render_cache_clear();
+    char buf[32];
+    text_cache_stats before, after;
+
+    // A layout that is used on every frame stays cached, however many other texts come and go
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "HOT"));
+    text_render_cache_stats(&before);
+    for(int i = 0; i < 2000; i++) {
+        snprintf(buf, sizeof(buf), "COLD %d", i);
+        text_render(&tconf, TEXT_UNSELECTED, 0, 0, 100, 100, buf);
+        CU_ASSERT_TRUE(render_cached(&tconf, 100, "HOT"));
+    }
+    text_render_cache_stats(&after);
+    CU_ASSERT(after.evictions > before.evictions);
+
+    // The cache holds at most 64 sets of 4, so one that is not used again gets evicted
+    CU_ASSERT_FALSE(render_cached(&tconf, 100, "COLD 0"));
+
+    // Recently used layouts survive a few misses in between
+    for(int i = 0; i < 3; i++) {
+        snprintf(buf, sizeof(buf), "WARM %d", i);
+        text_render(&tconf, TEXT_UNSELECTED, 0, 0, 100, 100, buf);
+    }
+    CU_ASSERT_TRUE(render_cached(&tconf, 100, "WARM 0"));
+    text_render_cache_clear();
+}
+
 void text_render_test_suite(CU_pSuite suite) {
     // Add tests
     if(CU_add_test(suite, "Test for text_find_max_strlen", test_text_find_max_strlen) == NULL) {
@@ -176,4 +273,13 @@ void text_render_test_suite(CU_pSuite suite) {
        NULL) {
         return;
     }
+    if(CU_add_test(suite, "Test for text layout cache hits", test_text_render_cache_hits) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for text layout cache invalidation", test_text_render_cache_invalidation) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for text layout cache eviction", test_text_render_cache_eviction) == NULL) {
+        return;
+    }
 }
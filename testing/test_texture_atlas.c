@@ -0,0 +1,244 @@
+#include "video/renderers/opengl3/helpers/texture_atlas.h"
+#include <CUnit/CUnit.h>
+
+#define ATLAS_SIZE 64
+#define TILE_SIZE 16
+#define TILES_PER_ROW (ATLAS_SIZE / TILE_SIZE)
+#define TILE_COUNT (TILES_PER_ROW * TILES_PER_ROW)
+
+static surface tiles[TILE_COUNT];
+static uint16_t tile_x[TILE_COUNT];
+static uint16_t tile_y[TILE_COUNT];
+
+// Same sized tiles fill the atlas exactly
+static texture_atlas *create_full_atlas(void) {
+    texture_atlas *atlas = atlas_create_unbacked(ATLAS_SIZE, ATLAS_SIZE);
+    uint16_t w, h;
+    for(int i = 0; i < TILE_COUNT; i++) {
+        surface_create(&tiles[i], TILE_SIZE, TILE_SIZE);
+        CU_ASSERT_FATAL(atlas_get(atlas, &tiles[i], &tile_x[i], &tile_y[i], &w, &h));
+    }
+    return atlas;
+}
+
+static void free_tiles(void) {
+    for(int i = 0; i < TILE_COUNT; i++) {
+        surface_free(&tiles[i]);
+    }
+}
+
+static int tile_at(uint16_t x, uint16_t y) {
+    for(int i = 0; i < TILE_COUNT; i++) {
+        if(tile_x[i] == x && tile_y[i] == y) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void test_atlas_release(void) {
+    texture_atlas_stats stats;
+    texture_atlas *atlas = create_full_atlas();
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.items, TILE_COUNT);
+    CU_ASSERT_EQUAL(stats.free_areas, 0);
+    CU_ASSERT_DOUBLE_EQUAL(stats.occupancy, 1.0, 0.0001);
+
+    // The area is not free until the next flush, since draws queued this frame may still use it
+    uint16_t x, y, w, h;
+    surface extra;
+    surface_create(&extra, TILE_SIZE, TILE_SIZE);
+    atlas_release(atlas, tiles[5].guid);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.items, TILE_COUNT - 1);
+    CU_ASSERT_EQUAL(stats.free_areas, 0);
+    CU_ASSERT_FALSE(atlas_get(atlas, &extra, &x, &y, &w, &h));
+
+    // Releasing something that is not in the atlas does nothing
+    atlas_release(atlas, extra.guid);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.items, TILE_COUNT - 1);
+
+    atlas_free(&atlas);
+    CU_ASSERT_PTR_NULL(atlas);
+    surface_free(&extra);
+    free_tiles();
+}
+
+void test_atlas_reinsert(void) {
+    texture_atlas_stats stats;
+    texture_atlas *atlas = create_full_atlas();
+
+    uint16_t x, y, w, h;
+    atlas_release(atlas, tiles[5].guid);
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.free_areas, 1);
+
+    // The freed area is handed out again
+    surface extra;
+    surface_create(&extra, TILE_SIZE, TILE_SIZE);
+    CU_ASSERT_TRUE(atlas_get(atlas, &extra, &x, &y, &w, &h));
+    CU_ASSERT_EQUAL(x, tile_x[5]);
+    CU_ASSERT_EQUAL(y, tile_y[5]);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.items, TILE_COUNT);
+    CU_ASSERT_EQUAL(stats.free_areas, 0);
+
+    // Smaller surfaces use a part of the freed area, and leave the rest free
+    surface small;
+    surface_create(&small, 4, 4);
+    atlas_release(atlas, extra.guid);
+    atlas_flush_released(atlas);
+    CU_ASSERT_TRUE(atlas_get(atlas, &small, &x, &y, &w, &h));
+    CU_ASSERT(x >= tile_x[5] && x + 4 <= tile_x[5] + TILE_SIZE);
+    CU_ASSERT(y >= tile_y[5] && y + 4 <= tile_y[5] + TILE_SIZE);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT(stats.free_areas > 0);
+    CU_ASSERT_EQUAL(stats.defrags, 0);
+
+    // The freed area is the only place anything fits
+    surface big;
+    surface_create(&big, TILE_SIZE + 1, TILE_SIZE);
+    CU_ASSERT_FALSE(atlas_get(atlas, &big, &x, &y, &w, &h));
+
+    atlas_free(&atlas);
+    surface_free(&big);
+    surface_free(&small);
+    surface_free(&extra);
+    free_tiles();
+}
+
+void test_atlas_coalesce(void) {
+    texture_atlas_stats stats;
+    texture_atlas *atlas = create_full_atlas();
+    uint16_t x, y, w, h;
+
+    // Two neighbours in a row merge into one area that fits a surface twice as wide
+    int left = tile_at(0, 0);
+    int right = tile_at(TILE_SIZE, 0);
+    CU_ASSERT_FATAL(left >= 0 && right >= 0);
+    atlas_release(atlas, tiles[left].guid);
+    atlas_release(atlas, tiles[right].guid);
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.free_areas, 1);
+    surface wide;
+    surface_create(&wide, TILE_SIZE * 2, TILE_SIZE);
+    CU_ASSERT_TRUE(atlas_get(atlas, &wide, &x, &y, &w, &h));
+    CU_ASSERT_EQUAL(x, 0);
+    CU_ASSERT_EQUAL(y, 0);
+
+    // Areas that only touch at a corner or by a part of an edge stay apart
+    int a = tile_at(2 * TILE_SIZE, TILE_SIZE);
+    int b = tile_at(3 * TILE_SIZE, 2 * TILE_SIZE);
+    CU_ASSERT_FATAL(a >= 0 && b >= 0);
+    atlas_release(atlas, tiles[a].guid);
+    atlas_release(atlas, tiles[b].guid);
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.free_areas, 2);
+
+    // Releasing everything merges it all back into one block, released in any order
+    atlas_release(atlas, wide.guid);
+    for(int i = TILE_COUNT - 1; i >= 0; i--) {
+        atlas_release(atlas, tiles[i].guid);
+    }
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.items, 0);
+    CU_ASSERT_EQUAL(stats.free_areas, 1);
+    CU_ASSERT_DOUBLE_EQUAL(stats.occupancy, 0.0, 0.0001);
+    CU_ASSERT_DOUBLE_EQUAL(stats.fragmentation, 0.0, 0.0001);
+    CU_ASSERT_EQUAL(stats.defrags, 0);
+
+    atlas_free(&atlas);
+    surface_free(&wide);
+    free_tiles();
+}
+
+void test_atlas_defrag(void) {
+    texture_atlas_stats stats;
+    uint16_t x, y, w, h;
+
+    // A few scattered holes are left alone
+    texture_atlas *atlas = create_full_atlas();
+    for(int i = 0; i < TILE_COUNT; i += 3) {
+        atlas_release(atlas, tiles[i].guid);
+    }
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.defrags, 0);
+    CU_ASSERT(stats.fragmentation > 0.5f);
+    atlas_free(&atlas);
+    free_tiles();
+
+    // Running out of room rebuilds the atlas on the next flush, and everything is uploaded again when drawn
+    atlas = create_full_atlas();
+    surface extra;
+    surface_create(&extra, TILE_SIZE, TILE_SIZE);
+    CU_ASSERT_FALSE(atlas_get(atlas, &extra, &x, &y, &w, &h));
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.defrags, 1);
+    CU_ASSERT_EQUAL(stats.items, 0);
+    CU_ASSERT_EQUAL(stats.free_areas, 1);
+    CU_ASSERT_TRUE(atlas_get(atlas, &extra, &x, &y, &w, &h));
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.defrags, 1);
+    atlas_free(&atlas);
+    surface_free(&extra);
+    free_tiles();
+}
+
+void test_atlas_defrag_fragmented(void) {
+    texture_atlas_stats stats;
+    uint16_t x, y, w, h;
+
+    // Small tiles, so that there can be enough free areas to trigger a rebuild
+    texture_atlas *atlas = atlas_create_unbacked(256, 256);
+    surface small[1024];
+    for(int i = 0; i < 1024; i++) {
+        surface_create(&small[i], 8, 8);
+        CU_ASSERT_FATAL(atlas_get(atlas, &small[i], &x, &y, &w, &h));
+    }
+
+    // Every other tile in a checkerboard, so that no two holes can merge
+    int released = 0;
+    for(int i = 0; i < 1024; i++) {
+        atlas_get(atlas, &small[i], &x, &y, &w, &h);
+        if(((x / 8) + (y / 8)) % 2 == 0) {
+            atlas_release(atlas, small[i].guid);
+            released++;
+        }
+    }
+    CU_ASSERT_EQUAL(released, 512);
+    atlas_flush_released(atlas);
+    atlas_get_stats(atlas, &stats);
+    CU_ASSERT_EQUAL(stats.defrags, 1);
+    CU_ASSERT_EQUAL(stats.items, 0);
+
+    atlas_free(&atlas);
+    for(int i = 0; i < 1024; i++) {
+        surface_free(&small[i]);
+    }
+}
+
+void texture_atlas_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of atlas release", test_atlas_release) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of reinserting into released space", test_atlas_reinsert) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of coalescing free space", test_atlas_coalesce) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of atlas rebuild when full", test_atlas_defrag) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of atlas rebuild when fragmented", test_atlas_defrag_fragmented) == NULL) {
+        return;
+    }
+}
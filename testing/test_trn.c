@@ -51,6 +51,19 @@ void test_sd_trn_roundtripping(void) {
 
     CU_ASSERT_STRING_EQUAL(n_trn.enemies[0]->name, l_trn.enemies[0]->name);
 
+    // Header only loading skips the enemies and the locales
+    sd_tournament_file h_trn;
+    CU_ASSERT(sd_tournament_create(&h_trn) == SD_SUCCESS);
+    CU_ASSERT(sd_tournament_load_header(&h_trn, "test.trn") == SD_SUCCESS);
+    CU_ASSERT(h_trn.enemy_count == l_trn.enemy_count);
+    CU_ASSERT(h_trn.registration_fee == l_trn.registration_fee);
+    CU_ASSERT(h_trn.tournament_id == l_trn.tournament_id);
+    CU_ASSERT_STRING_EQUAL(h_trn.filename, l_trn.filename);
+    CU_ASSERT_STRING_EQUAL(h_trn.bk_name, l_trn.bk_name);
+    CU_ASSERT_PTR_NULL(h_trn.enemies[0]);
+    CU_ASSERT_PTR_NULL(h_trn.locales[0]);
+    sd_tournament_free(&h_trn);
+
     sd_tournament_free(&n_trn);
     sd_tournament_free(&l_trn);
 }
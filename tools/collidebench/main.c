@@ -0,0 +1,157 @@
+/** @file main.c
+ * @brief Collision pass benchmark tool
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "game/game_state.h"
+#include "game/objects/har.h"
+#include "game/protos/object.h"
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+#include "utils/iterator.h"
+
+static game_state gs;
+static unsigned int collisions;
+
+static void count_collide(object *a, object *b) {
+    collisions++;
+}
+
+static void add_object(int layers, int group, bool collides) {
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, &gs, vec2i_create(0, 0), vec2f_create(0.0f, 0.0f));
+    object_set_layers(obj, layers);
+    object_set_group(obj, group);
+    if(collides) {
+        object_set_collide_cb(obj, count_collide);
+    }
+    game_state_add_object(&gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+}
+
+// A fight after a destruction: two HARs, some projectiles and a lot of scrap
+static void create_scene(int scrap) {
+    memset(&gs, 0, sizeof(game_state));
+    vector_create(&gs.objects, sizeof(render_obj));
+    object_index_create(&gs.obj_index);
+
+    add_object(LAYER_SCRAP, GROUP_UNKNOWN, false);
+    add_object(LAYER_HAR | LAYER_HAR1, GROUP_UNKNOWN, true);
+    add_object(LAYER_PROJECTILE | LAYER_HAR1, GROUP_PROJECTILE, false);
+    add_object(LAYER_HAR | LAYER_HAR2, GROUP_UNKNOWN, true);
+    for(int i = 0; i < scrap; i++) {
+        add_object(LAYER_SCRAP, GROUP_UNKNOWN, false);
+        if(i % 50 == 0) {
+            add_object(LAYER_PROJECTILE | (i % 100 ? LAYER_HAR1 : LAYER_HAR2), GROUP_PROJECTILE, false);
+        }
+    }
+    add_object(LAYER_HAZARD | LAYER_HAR1 | LAYER_HAR2, GROUP_UNKNOWN, false);
+}
+
+static void free_scene(void) {
+    iterator it;
+    render_obj *robj;
+    vector_iter_begin(&gs.objects, &it);
+    foreach(it, robj) {
+        object_free(robj->obj);
+        omf_free(robj->obj);
+    }
+    vector_free(&gs.objects);
+    object_index_free(&gs.obj_index);
+}
+
+// Every pair, the way the collision pass visited them before the culling.
+static void all_pairs_collide(void) {
+    unsigned int size = vector_size(&gs.objects);
+    for(unsigned i = 0; i < size; i++) {
+        object *a = ((render_obj *)vector_get(&gs.objects, i))->obj;
+        for(unsigned k = i + 1; k < size; k++) {
+            object *b = ((render_obj *)vector_get(&gs.objects, k))->obj;
+            if(a->group != b->group || a->group == GROUP_UNKNOWN || b->group == GROUP_UNKNOWN) {
+                if(a->layers & b->layers) {
+                    object_collide(a, b);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *scrap = arg_int0("s", "scrap", "<n>", "How many scrap objects to add (default 300)");
+    struct arg_int *rounds = arg_int0("n", "rounds", "<n>", "How many collision passes to time (default 1000)");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, scrap, rounds, end};
+    const char *progname = "collidebench";
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 collision pass benchmark.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    int scrap_count = scrap->count > 0 ? scrap->ival[0] : 300;
+    int round_count = rounds->count > 0 ? rounds->ival[0] : 1000;
+    if(scrap_count < 0 || round_count <= 0) {
+        printf("Scrap count must not be negative, and round count must be positive.\n");
+        goto exit_0;
+    }
+
+    create_scene(scrap_count);
+    uint64_t freq = SDL_GetPerformanceFrequency();
+    uint64_t start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < round_count; i++) {
+        all_pairs_collide();
+    }
+    uint64_t mid = SDL_GetPerformanceCounter();
+    for(int i = 0; i < round_count; i++) {
+        game_state_call_collide(&gs);
+    }
+    uint64_t end_time = SDL_GetPerformanceCounter();
+
+    printf("%u objects: all pairs %.2f us, culled %.2f us per tick (%u collisions per tick)\n",
+           vector_size(&gs.objects), (double)(mid - start) * 1000000.0 / freq / round_count,
+           (double)(end_time - mid) * 1000000.0 / freq / round_count, collisions / (round_count * 2));
+    free_scene();
+
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "chained_hashmap.h"
+#include "utils/allocator.h"
+#include <stdint.h>
+#include <string.h>
+
+#define FNV_32_PRIME ((uint32_t)0x01000193)
+#define FNV1_32_INIT ((uint32_t)2166136261)
+#define ENLARGE_LIMIT 1024
+#define INITIAL_SIZE 4
+
+static uint32_t chained_fnv_32a_buf(const void *buf, unsigned int len, unsigned int max_size) {
+    unsigned char *bp = (unsigned char *)buf;
+    unsigned char *be = bp + len;
+    uint32_t val = FNV1_32_INIT;
+    while(bp < be) {
+        val ^= (uint32_t)*bp++;
+        val *= FNV_32_PRIME;
+    }
+    return val % max_size;
+}
+
+void chained_hashmap_create(chained_hashmap *hm) {
+    hm->buckets = omf_calloc(INITIAL_SIZE, sizeof(chained_hashmap_node *));
+    hm->reserved = 0;
+    hm->capacity = INITIAL_SIZE;
+}
+
+static void chained_hashmap_resize(chained_hashmap *hm, unsigned int new_size) {
+    hm->buckets = omf_realloc(hm->buckets, new_size * sizeof(chained_hashmap_node *));
+    memset(&hm->buckets[hm->capacity], 0, (new_size - hm->capacity) * sizeof(chained_hashmap_node *));
+    for(unsigned int i = 0; i < hm->capacity; i++) {
+        chained_hashmap_node *node = hm->buckets[i];
+        hm->buckets[i] = NULL;
+        while(node != NULL) {
+            chained_hashmap_node *this = node;
+            node = node->next;
+            unsigned int index = chained_fnv_32a_buf(this->pair.key, this->pair.key_len, new_size);
+            this->next = hm->buckets[index];
+            hm->buckets[index] = this;
+        }
+    }
+    hm->capacity = new_size;
+}
+
+static void chained_hashmap_enlarge_check(chained_hashmap *hm) {
+    if(hm->capacity >= ENLARGE_LIMIT)
+        return;
+    unsigned int q = hm->capacity - (hm->capacity >> 2);
+    if(hm->reserved > q) {
+        chained_hashmap_resize(hm, hm->capacity << 1);
+    }
+}
+
+void chained_hashmap_free(chained_hashmap *hm) {
+    for(unsigned int i = 0; i < hm->capacity; i++) {
+        chained_hashmap_node *node = hm->buckets[i];
+        while(node != NULL) {
+            chained_hashmap_node *tmp = node;
+            node = node->next;
+            omf_free(tmp->pair.key);
+            omf_free(tmp->pair.value);
+            omf_free(tmp);
+        }
+    }
+    omf_free(hm->buckets);
+    hm->capacity = 0;
+    hm->reserved = 0;
+}
+
+void *chained_hashmap_put(chained_hashmap *hm, const void *key, unsigned int key_len, const void *val,
+                          unsigned int value_len) {
+    unsigned int index = chained_fnv_32a_buf(key, key_len, hm->capacity);
+    chained_hashmap_node *seek = hm->buckets[index];
+    while(seek) {
+        if(seek->pair.key_len == key_len && memcmp(seek->pair.key, key, key_len) == 0) {
+            seek->pair.value = omf_realloc(seek->pair.value, value_len);
+            memcpy(seek->pair.value, val, value_len);
+            seek->pair.value_len = value_len;
+            chained_hashmap_enlarge_check(hm);
+            return seek->pair.value;
+        }
+        seek = seek->next;
+    }
+
+    chained_hashmap_node *node = omf_calloc(1, sizeof(chained_hashmap_node));
+    node->pair.key_len = key_len;
+    node->pair.value_len = value_len;
+    node->pair.key = omf_calloc(1, key_len);
+    node->pair.value = omf_calloc(1, value_len);
+    memcpy(node->pair.key, key, key_len);
+    memcpy(node->pair.value, val, value_len);
+    node->next = hm->buckets[index];
+    hm->buckets[index] = node;
+    hm->reserved++;
+    chained_hashmap_enlarge_check(hm);
+    return node->pair.value;
+}
+
+int chained_hashmap_get(chained_hashmap *hm, const void *key, unsigned int key_len, void **value,
+                        unsigned int *value_len) {
+    unsigned int index = chained_fnv_32a_buf(key, key_len, hm->capacity);
+    for(chained_hashmap_node *node = hm->buckets[index]; node != NULL; node = node->next) {
+        if(node->pair.key_len == key_len && memcmp(node->pair.key, key, key_len) == 0) {
+            *value = node->pair.value;
+            if(value_len != NULL)
+                *value_len = node->pair.value_len;
+            return 0;
+        }
+    }
+    *value = NULL;
+    if(value_len != NULL)
+        *value_len = 0;
+    return 1;
+}
+
+static void *chained_hashmap_iter_next(iterator *iter) {
+    const chained_hashmap *hm = iter->data;
+    chained_hashmap_node *node = iter->vnow;
+    if(node != NULL && node->next != NULL) {
+        iter->vnow = node->next;
+        return &node->next->pair;
+    }
+    while(iter->inow < (int)hm->capacity) {
+        node = hm->buckets[iter->inow++];
+        if(node != NULL) {
+            iter->vnow = node;
+            return &node->pair;
+        }
+    }
+    iter->vnow = NULL;
+    iter->ended = 1;
+    return NULL;
+}
+
+void chained_hashmap_iter_begin(const chained_hashmap *hm, iterator *iter) {
+    iter->data = hm;
+    iter->vnow = NULL;
+    iter->inow = 0;
+    iter->next = chained_hashmap_iter_next;
+    iter->peek = NULL;
+    iter->prev = NULL;
+    iter->ended = (hm->reserved == 0);
+}
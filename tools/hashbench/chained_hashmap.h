@@ -0,0 +1,29 @@
+#ifndef CHAINED_HASHMAP_H
+#define CHAINED_HASHMAP_H
+
+// The old chained bucket hashmap, kept around as a baseline for hashbench.
+
+#include "utils/hashmap.h"
+
+typedef struct chained_hashmap_node chained_hashmap_node;
+
+struct chained_hashmap_node {
+    hashmap_pair pair;
+    chained_hashmap_node *next;
+};
+
+typedef struct chained_hashmap {
+    chained_hashmap_node **buckets;
+    unsigned int capacity;
+    unsigned int reserved;
+} chained_hashmap;
+
+void chained_hashmap_create(chained_hashmap *hm);
+void chained_hashmap_free(chained_hashmap *hm);
+void *chained_hashmap_put(chained_hashmap *hm, const void *key, unsigned int key_len, const void *val,
+                          unsigned int value_len);
+int chained_hashmap_get(chained_hashmap *hm, const void *key, unsigned int key_len, void **value,
+                        unsigned int *value_len);
+void chained_hashmap_iter_begin(const chained_hashmap *hm, iterator *iter);
+
+#endif // CHAINED_HASHMAP_H
@@ -0,0 +1,161 @@
+/** @file main.c
+ * @brief Hashmap benchmark tool
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <SDL.h>
+#include <stdio.h>
+
+#include "chained_hashmap.h"
+#include "utils/c_array_util.h"
+#include "utils/hashmap.h"
+#include "utils/iterator.h"
+
+// The chained map stops growing at 1024 buckets, so at a million entries every put and get walks a
+// chain of about a thousand nodes and the baseline alone takes minutes. It is skipped above this size
+// unless asked for.
+#define CHAINED_BENCH_MAX 100000
+
+static double elapsed_us(uint64_t start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Times put, get and iteration over count integer keys. Returns false if a lookup came back wrong.
+static bool bench_open(unsigned int count, double us[3]) {
+    unsigned int found = 0;
+    unsigned int *val;
+    iterator it;
+    hashmap_pair *pair;
+    hashmap map;
+    uint64_t start;
+
+    hashmap_create(&map);
+    start = SDL_GetPerformanceCounter();
+    for(unsigned int i = 0; i < count; i++) {
+        hashmap_put_int(&map, i, &i, sizeof(unsigned int));
+    }
+    us[0] = elapsed_us(start);
+    start = SDL_GetPerformanceCounter();
+    for(unsigned int i = 0; i < count; i++) {
+        found += hashmap_get_int(&map, i, (void **)&val, NULL) == 0 && *val == i;
+    }
+    us[1] = elapsed_us(start);
+    start = SDL_GetPerformanceCounter();
+    hashmap_iter_begin(&map, &it);
+    foreach(it, pair) {
+        found++;
+    }
+    us[2] = elapsed_us(start);
+    hashmap_free(&map);
+    return found == count * 2;
+}
+
+static bool bench_chained(unsigned int count, double us[3]) {
+    unsigned int found = 0;
+    unsigned int *val;
+    iterator it;
+    hashmap_pair *pair;
+    chained_hashmap map;
+    uint64_t start;
+
+    chained_hashmap_create(&map);
+    start = SDL_GetPerformanceCounter();
+    for(unsigned int i = 0; i < count; i++) {
+        chained_hashmap_put(&map, &i, sizeof(unsigned int), &i, sizeof(unsigned int));
+    }
+    us[0] = elapsed_us(start);
+    start = SDL_GetPerformanceCounter();
+    for(unsigned int i = 0; i < count; i++) {
+        found += chained_hashmap_get(&map, &i, sizeof(unsigned int), (void **)&val, NULL) == 0 && *val == i;
+    }
+    us[1] = elapsed_us(start);
+    start = SDL_GetPerformanceCounter();
+    chained_hashmap_iter_begin(&map, &it);
+    foreach(it, pair) {
+        found++;
+    }
+    us[2] = elapsed_us(start);
+    chained_hashmap_free(&map);
+    return found == count * 2;
+}
+
+int main(int argc, char *argv[]) {
+    const int default_sizes[] = {100, 10000, 100000, 1000000};
+    double open_us[3];
+    double chained_us[3];
+
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *sizes = arg_intn("s", "size", "<n>", 0, 8, "Entry count to benchmark, can be repeated");
+    struct arg_lit *all = arg_lit0(NULL, "all-chained", "Also run the chained baseline above 100000 entries");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, sizes, all, end};
+    const char *progname = "hashbench";
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 hashmap benchmark.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    int size_count = sizes->count > 0 ? sizes->count : (int)N_ELEMENTS(default_sizes);
+    for(int s = 0; s < size_count; s++) {
+        int count = sizes->count > 0 ? sizes->ival[s] : default_sizes[s];
+        if(count <= 0) {
+            printf("Entry count must be positive.\n");
+            goto exit_0;
+        }
+        if(!bench_open(count, open_us)) {
+            printf("Open addressing hashmap lost entries at %d entries!\n", count);
+            goto exit_0;
+        }
+        if(count > CHAINED_BENCH_MAX && all->count == 0) {
+            printf("%8d entries: put %.0f us, get %.0f us, iterate %.0f us (open, chained skipped)\n", count,
+                   open_us[0], open_us[1], open_us[2]);
+            continue;
+        }
+        if(!bench_chained(count, chained_us)) {
+            printf("Chained hashmap lost entries at %d entries!\n", count);
+            goto exit_0;
+        }
+        printf("%8d entries: put %.0f/%.0f us, get %.0f/%.0f us, iterate %.0f/%.0f us (open/chained)\n", count,
+               open_us[0], chained_us[0], open_us[1], chained_us[1], open_us[2], chained_us[2]);
+    }
+
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return 0;
+}
@@ -0,0 +1,261 @@
+/** @file main.c
+ * @brief Resource loading benchmark tool
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "formats/af.h"
+#include "formats/bk.h"
+#include "formats/error.h"
+#include "formats/internal/reader.h"
+#include "utils/c_array_util.h"
+#include "utils/iterator.h"
+#include "utils/list.h"
+#include "utils/scandir.h"
+#include "utils/str.h"
+
+typedef enum
+{
+    MODE_STDIO,
+    MODE_MEMORY,
+    MODE_MAPPED,
+    MODE_COUNT
+} bench_mode;
+
+static const char *mode_names[] = {"stdio", "memory", "mapped"};
+
+static int load_file(const char *filename, bench_mode mode) {
+    size_t len = strlen(filename);
+    bool is_af = len >= 3 && strcmp(filename + len - 3, ".AF") == 0;
+    int ret;
+    if(is_af) {
+        sd_af_file af;
+        sd_af_create(&af);
+        ret = mode == MODE_MAPPED ? sd_af_load_mapped(&af, filename) : sd_af_load(&af, filename);
+        sd_af_free(&af);
+    } else {
+        sd_bk_file bk;
+        sd_bk_create(&bk);
+        ret = mode == MODE_MAPPED ? sd_bk_load_mapped(&bk, filename) : sd_bk_load(&bk, filename);
+        sd_bk_free(&bk);
+    }
+    return ret;
+}
+
+// Returns the time it took to load all files the given number of times, in seconds.
+static double run_mode(list *files, bench_mode mode, int iterations) {
+    iterator it;
+    str *filename;
+    sd_reader_set_backend(mode == MODE_STDIO ? SD_READER_STDIO : SD_READER_MEMORY);
+    uint64_t start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < iterations; i++) {
+        list_iter_begin(files, &it);
+        foreach(it, filename) {
+            int ret = load_file(str_c(filename), mode);
+            if(ret != SD_SUCCESS) {
+                printf("Unable to load %s! [%d] %s.\n", str_c(filename), ret, sd_get_error(ret));
+                return -1;
+            }
+        }
+    }
+    uint64_t end = SDL_GetPerformanceCounter();
+    return (double)(end - start) / SDL_GetPerformanceFrequency();
+}
+
+// Decodes every sprite of the animation to both VGA and RGBA. Returns the number of decoded sprites, or -1.
+static int decode_animation(const sd_animation *ani, const vga_palette *pal) {
+    if(ani == NULL) {
+        return 0;
+    }
+    for(int i = 0; i < ani->sprite_count; i++) {
+        const sd_sprite *spr = ani->sprites[i];
+        sd_vga_image vga;
+        sd_rgba_image rgba;
+        if(spr->missing || spr->len == 0) {
+            continue;
+        }
+        if(sd_sprite_vga_decode(&vga, spr) != SD_SUCCESS) {
+            return -1;
+        }
+        sd_vga_image_free(&vga);
+        if(sd_sprite_rgba_decode(&rgba, spr, pal) != SD_SUCCESS) {
+            return -1;
+        }
+        sd_rgba_image_free(&rgba);
+    }
+    return ani->sprite_count;
+}
+
+static int decode_file(const char *filename, const vga_palette *pal) {
+    size_t len = strlen(filename);
+    bool is_af = len >= 3 && strcmp(filename + len - 3, ".AF") == 0;
+    int count = 0;
+    int ret = 0;
+    if(is_af) {
+        sd_af_file af;
+        sd_af_create(&af);
+        if(sd_af_load(&af, filename) == SD_SUCCESS) {
+            for(int m = 0; m < MAX_AF_MOVES && ret >= 0; m++) {
+                if(af.moves[m] != NULL) {
+                    count += (ret = decode_animation(af.moves[m]->animation, pal));
+                }
+            }
+        }
+        sd_af_free(&af);
+    } else {
+        sd_bk_file bk;
+        sd_bk_create(&bk);
+        if(sd_bk_load(&bk, filename) == SD_SUCCESS) {
+            for(int a = 0; a < MAX_BK_ANIMS && ret >= 0; a++) {
+                if(bk.anims[a] != NULL) {
+                    count += (ret = decode_animation(bk.anims[a]->animation, pal));
+                }
+            }
+        }
+        sd_bk_free(&bk);
+    }
+    return ret < 0 ? -1 : count;
+}
+
+// Decodes all sprites of all files the given number of times, and prints the time it took per sprite.
+static void run_decode(list *files, int iterations) {
+    iterator it;
+    str *filename;
+    vga_palette pal;
+    long sprites = 0;
+    for(int i = 0; i < 256; i++) {
+        pal.colors[i].r = pal.colors[i].g = pal.colors[i].b = i;
+    }
+    uint64_t start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < iterations; i++) {
+        list_iter_begin(files, &it);
+        foreach(it, filename) {
+            int count = decode_file(str_c(filename), &pal);
+            if(count < 0) {
+                printf("Unable to decode sprites of %s!\n", str_c(filename));
+                return;
+            }
+            sprites += count;
+        }
+    }
+    uint64_t end = SDL_GetPerformanceCounter();
+    double secs = (double)(end - start) / SDL_GetPerformanceFrequency();
+    printf("decode   %10.3f ms/iteration %8.3f us/sprite (%ld sprites, includes loading)\n",
+           secs * 1000.0 / iterations, sprites ? secs * 1000000.0 / sprites : 0.0, sprites / iterations);
+}
+
+static void free_filename(void *data) {
+    str_free((str *)data);
+}
+
+static void find_files(list *files, const char *dir, const char *suffix) {
+    list names;
+    iterator it;
+    char *name;
+    list_create(&names);
+    scan_directory_suffix(&names, dir, suffix);
+    list_iter_begin(&names, &it);
+    foreach(it, name) {
+        str filename;
+        str_from_format(&filename, "%s/%s", dir, name);
+        list_append(files, &filename, sizeof(str));
+    }
+    list_free(&names);
+}
+
+int main(int argc, char *argv[]) {
+    list files;
+    double times[MODE_COUNT];
+
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_file *dir = arg_file1("d", "dir", "<dir>", "Resource directory containing the .BK and .AF files");
+    struct arg_int *iters = arg_int0("n", "iterations", "<n>", "How many times to load every file (default 10)");
+    struct arg_lit *decode = arg_lit0(NULL, "decode", "Also decode every sprite to VGA and RGBA images");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, dir, iters, decode, end};
+    const char *progname = "loadbench";
+
+    list_create(&files);
+    list_set_node_free_cb(&files, free_filename);
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 resource loading benchmark.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    int iterations = iters->count > 0 ? iters->ival[0] : 10;
+    if(iterations <= 0) {
+        printf("Iteration count must be positive.\n");
+        goto exit_0;
+    }
+
+    find_files(&files, dir->filename[0], ".BK");
+    find_files(&files, dir->filename[0], ".AF");
+    if(list_size(&files) == 0) {
+        printf("No .BK or .AF files found in %s.\n", dir->filename[0]);
+        goto exit_0;
+    }
+    printf("Loading %u files %d times.\n", list_size(&files), iterations);
+
+    // Warm up the OS file cache, so that the first mode is not penalized.
+    if(run_mode(&files, MODE_STDIO, 1) < 0) {
+        goto exit_0;
+    }
+    for(int m = 0; m < MODE_COUNT; m++) {
+        if((times[m] = run_mode(&files, m, iterations)) < 0) {
+            goto exit_0;
+        }
+    }
+
+    for(int m = 0; m < MODE_COUNT; m++) {
+        printf("%-8s %10.3f ms/iteration %8.2fx\n", mode_names[m], times[m] * 1000.0 / iterations,
+               times[MODE_STDIO] / times[m]);
+    }
+    if(decode->count > 0) {
+        run_decode(&files, iterations);
+    }
+
+exit_0:
+    sd_reader_set_backend(SD_READER_MEMORY);
+    list_free(&files);
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return 0;
+}
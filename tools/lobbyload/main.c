@@ -0,0 +1,453 @@
+/** @file main.c
+ * @brief Lobby load generator. Joins a lobby server with many simulated clients and measures how long messages
+ * take to reach all of them, and what keeping a large user list costs the clients.
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <SDL.h>
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game/utils/lobby_protocol.h"
+#include "game/utils/serial.h"
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+#include "utils/iterator.h"
+#include "utils/list.h"
+
+// ENet can not address more peers than this
+#define MAX_CLIENTS 4095
+
+typedef struct sim_client {
+    ENetPeer *peer;
+    int index;
+    uint32_t id;
+    bool joined;
+    bool failed;
+    list users; // lobby_user, kept the same way the lobby scene keeps it
+    unsigned presences;
+} sim_client;
+
+typedef struct load_test {
+    ENetHost *host;
+    sim_client *clients;
+    int count;
+    int joined;
+    int failed;
+    int disconnected;
+
+    uint64_t *yell_sent; // performance counter value when each yell was sent
+    float *yell_last;    // latency of the last delivery of each yell, in ms
+    float *latencies;    // latency of every delivery, in ms
+    int yells;
+    int latency_count;
+
+    uint64_t presence_ticks; // performance counter ticks spent updating the user lists
+    unsigned presence_count;
+} load_test;
+
+static double ticks_to_ms(uint64_t ticks) {
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static void send_serial(sim_client *client, serial *ser) {
+    ENetPacket *packet = enet_packet_create(ser->data, serial_len(ser), ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(client->peer, 0, packet);
+}
+
+static void send_join(load_test *t, sim_client *client) {
+    char name[LOBBY_NAME_SIZE];
+    const char *version = "lobbyload";
+    snprintf(name, sizeof(name), "load%d", client->index);
+
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, PACKET_JOIN << 4 | (LOBBY_PROTOCOL_VERSION & 0x0f));
+    serial_write_int16(&ser, t->host->address.port);
+    serial_write_int8(&ser, strlen(version));
+    serial_write(&ser, version, strlen(version));
+    serial_write(&ser, name, strlen(name));
+    send_serial(client, &ser);
+    serial_free(&ser);
+}
+
+static void send_yell(sim_client *client, int seq) {
+    char text[16];
+    snprintf(text, sizeof(text), "#%d", seq);
+
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, PACKET_YELL << 4);
+    serial_write(&ser, text, strlen(text));
+    send_serial(client, &ser);
+    serial_free(&ser);
+}
+
+static void send_refresh(sim_client *client) {
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, (uint8_t)(PACKET_REFRESH << 4));
+    send_serial(client, &ser);
+    serial_free(&ser);
+}
+
+static void handle_presence(load_test *t, sim_client *client, serial *ser) {
+    lobby_user user;
+    uint64_t start = SDL_GetPerformanceCounter();
+    if(lobby_presence_read(ser, &user)) {
+        lobby_users_update(&client->users, &user);
+    }
+    t->presence_ticks += SDL_GetPerformanceCounter() - start;
+    t->presence_count++;
+    client->presences++;
+}
+
+static void handle_user_left(sim_client *client, serial *ser) {
+    iterator it;
+    lobby_user *user;
+    uint32_t id = serial_read_uint32(ser);
+    list_iter_begin(&client->users, &it);
+    foreach(it, user) {
+        if(user->id == id) {
+            list_delete(&client->users, &it);
+            break;
+        }
+    }
+}
+
+// Yells are "name: #seq"
+static void handle_yell(load_test *t, ENetPacket *packet) {
+    char text[160];
+    size_t len = packet->dataLength - 1 < sizeof(text) - 1 ? packet->dataLength - 1 : sizeof(text) - 1;
+    memcpy(text, packet->data + 1, len);
+    text[len] = 0;
+    char *hash = strrchr(text, '#');
+    if(hash == NULL) {
+        return;
+    }
+    int seq = atoi(hash + 1);
+    if(seq < 0 || seq >= t->yells || t->latency_count >= t->yells * t->count) {
+        return;
+    }
+    float latency = ticks_to_ms(SDL_GetPerformanceCounter() - t->yell_sent[seq]);
+    t->latencies[t->latency_count++] = latency;
+    if(latency > t->yell_last[seq]) {
+        t->yell_last[seq] = latency;
+    }
+}
+
+static void handle_packet(load_test *t, sim_client *client, ENetPacket *packet) {
+    if(packet->dataLength == 0) {
+        return;
+    }
+    serial ser;
+    serial_create_from(&ser, (const char *)packet->data, packet->dataLength);
+    uint8_t control = serial_read_int8(&ser);
+    switch(control >> 4) {
+        case PACKET_JOIN:
+            if((control & 0xf) == JOIN_SUCCESS) {
+                client->id = serial_read_uint32(&ser);
+                client->joined = true;
+                t->joined++;
+            } else {
+                if(t->failed == 0) {
+                    printf("Joining failed with error %d.\n", control & 0xf);
+                }
+                client->failed = true;
+                t->failed++;
+            }
+            break;
+        case PACKET_PRESENCE:
+            handle_presence(t, client, &ser);
+            break;
+        case PACKET_DISCONNECT:
+            handle_user_left(client, &ser);
+            break;
+        case PACKET_YELL:
+            handle_yell(t, packet);
+            break;
+    }
+    serial_free(&ser);
+}
+
+static void handle_event(load_test *t, ENetEvent *event) {
+    sim_client *client = event->peer->data;
+    switch(event->type) {
+        case ENET_EVENT_TYPE_CONNECT:
+            send_join(t, client);
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+            handle_packet(t, client, event->packet);
+            enet_packet_destroy(event->packet);
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+            if(!client->joined && !client->failed) {
+                client->failed = true;
+                t->failed++;
+            }
+            t->disconnected++;
+            break;
+        case ENET_EVENT_TYPE_NONE:
+            break;
+    }
+}
+
+typedef bool (*done_cb)(load_test *t);
+
+// Handles events until done returns true, or the timeout passes. Returns false on timeout.
+static bool service(load_test *t, enet_uint32 timeout_ms, done_cb done) {
+    ENetEvent event;
+    enet_uint32 start = enet_time_get();
+    while(done == NULL || !done(t)) {
+        int ret = enet_host_service(t->host, &event, 1);
+        while(ret > 0) {
+            handle_event(t, &event);
+            ret = enet_host_check_events(t->host, &event);
+        }
+        if(ret < 0) {
+            return false;
+        }
+        if(enet_time_get() - start >= timeout_ms) {
+            return done == NULL || done(t);
+        }
+    }
+    return true;
+}
+
+static bool all_joined(load_test *t) {
+    return t->joined + t->failed >= t->count;
+}
+
+static bool all_listed(load_test *t) {
+    for(int i = 0; i < t->count; i++) {
+        if(t->clients[i].joined && (int)list_size(&t->clients[i].users) < t->joined) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool all_yells_delivered(load_test *t) {
+    return t->latency_count >= t->yells * t->joined;
+}
+
+static bool all_refreshed(load_test *t) {
+    for(int i = 0; i < t->count; i++) {
+        if(t->clients[i].joined && (int)t->clients[i].presences < t->joined) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool all_disconnected(load_test *t) {
+    return t->disconnected >= t->count;
+}
+
+static int compare_floats(const void *a, const void *b) {
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+static void print_latencies(load_test *t) {
+    if(t->latency_count == 0) {
+        printf("No yells were delivered.\n");
+        return;
+    }
+    qsort(t->latencies, t->latency_count, sizeof(float), compare_floats);
+    double sum = 0.0;
+    for(int i = 0; i < t->latency_count; i++) {
+        sum += t->latencies[i];
+    }
+    printf("Yell fan-out: %d of %d deliveries, latency avg %.2f ms, median %.2f ms, 99th %.2f ms, max %.2f ms\n",
+           t->latency_count, t->yells * t->joined, sum / t->latency_count, t->latencies[t->latency_count / 2],
+           t->latencies[t->latency_count * 99 / 100], t->latencies[t->latency_count - 1]);
+
+    double last_sum = 0.0;
+    float last_max = 0.0f;
+    for(int i = 0; i < t->yells; i++) {
+        last_sum += t->yell_last[i];
+        last_max = t->yell_last[i] > last_max ? t->yell_last[i] : last_max;
+    }
+    printf("Time for a yell to reach everyone: avg %.2f ms, max %.2f ms\n", last_sum / t->yells, last_max);
+}
+
+static int run_test(load_test *t, ENetAddress *server, int yells, int interval, enet_uint32 timeout_ms) {
+    uint64_t start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < t->count; i++) {
+        t->clients[i].peer = enet_host_connect(t->host, server, 3, 0);
+        if(t->clients[i].peer == NULL) {
+            printf("No available peers for client %d.\n", i);
+            return 1;
+        }
+        t->clients[i].peer->data = &t->clients[i];
+    }
+    bool ok = service(t, timeout_ms, all_joined);
+    printf("%d of %d clients joined in %.1f ms.\n", t->joined, t->count,
+           ticks_to_ms(SDL_GetPerformanceCounter() - start));
+    if(!ok || t->joined == 0) {
+        return 1;
+    }
+    ok = service(t, timeout_ms, all_listed);
+    printf("User lists %s after %.1f ms, %u presence packets handled.\n", ok ? "complete" : "incomplete",
+           ticks_to_ms(SDL_GetPerformanceCounter() - start), t->presence_count);
+
+    // Yells, from each client in turn
+    int sender = 0;
+    for(int i = 0; i < yells; i++) {
+        while(!t->clients[sender].joined) {
+            sender = (sender + 1) % t->count;
+        }
+        t->yell_sent[i] = SDL_GetPerformanceCounter();
+        send_yell(&t->clients[sender], i);
+        enet_host_flush(t->host);
+        sender = (sender + 1) % t->count;
+        service(t, interval, NULL);
+    }
+    service(t, timeout_ms, all_yells_delivered);
+    print_latencies(t);
+
+    // Everyone refreshes at once, which is the worst case for the user lists
+    for(int i = 0; i < t->count; i++) {
+        t->clients[i].presences = 0;
+        if(t->clients[i].joined) {
+            send_refresh(&t->clients[i]);
+        }
+    }
+    t->presence_ticks = 0;
+    t->presence_count = 0;
+    start = SDL_GetPerformanceCounter();
+    ok = service(t, timeout_ms, all_refreshed);
+    printf("Refresh of %d users by all clients %s in %.1f ms.\n", t->joined, ok ? "finished" : "timed out",
+           ticks_to_ms(SDL_GetPerformanceCounter() - start));
+    if(t->presence_count > 0) {
+        printf("Client user list upkeep: %.2f us per presence packet, %.3f ms per refresh of %d users.\n",
+               ticks_to_ms(t->presence_ticks) * 1000.0 / t->presence_count,
+               ticks_to_ms(t->presence_ticks) / t->joined, t->joined);
+    }
+
+    for(int i = 0; i < t->count; i++) {
+        enet_peer_disconnect(t->clients[i].peer, 0);
+    }
+    service(t, 3000, all_disconnected);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    load_test t;
+    int ret = 0;
+    memset(&t, 0, sizeof(t));
+
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_str *server = arg_str0("s", "server", "<host>", "Address of the lobby server (default: 127.0.0.1)");
+    struct arg_int *port = arg_int0("p", "port", "<port>", "Port of the lobby server (default: 2098)");
+    struct arg_int *clients = arg_int0("c", "clients", "<count>", "Number of simulated clients (default: 200)");
+    struct arg_int *yells = arg_int0("y", "yells", "<count>", "Number of yells to send (default: 50)");
+    struct arg_int *interval = arg_int0("i", "interval", "<ms>", "Time between yells (default: 20)");
+    struct arg_int *timeout = arg_int0("t", "timeout", "<seconds>", "Time to wait for each phase (default: 10)");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, server, port, clients, yells, interval, timeout, end};
+    const char *progname = "lobbyload";
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 lobby load generator.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    t.count = clients->count > 0 ? clients->ival[0] : 200;
+    t.yells = yells->count > 0 ? yells->ival[0] : 50;
+    int yell_interval = interval->count > 0 ? interval->ival[0] : 20;
+    int timeout_secs = timeout->count > 0 ? timeout->ival[0] : 10;
+    if(t.count < 1 || t.count > MAX_CLIENTS || t.yells < 1 || yell_interval < 0 || timeout_secs < 1) {
+        printf("Clients must be between 1 and %d, and yells and the timeout at least 1.\n", MAX_CLIENTS);
+        ret = 1;
+        goto exit_0;
+    }
+
+    if(enet_initialize() != 0) {
+        printf("Failed to initialize enet.\n");
+        ret = 1;
+        goto exit_0;
+    }
+    ENetAddress address;
+    if(enet_address_set_host(&address, server->count > 0 ? server->sval[0] : "127.0.0.1") < 0) {
+        printf("Unable to resolve the server address.\n");
+        ret = 1;
+        goto exit_1;
+    }
+    address.port = port->count > 0 ? port->ival[0] : LOBBY_PORT;
+
+    // All the clients share one host, so that servicing them is one call
+    t.host = enet_host_create(NULL, t.count, 3, 0, 0);
+    if(t.host == NULL) {
+        printf("Unable to create the client host.\n");
+        ret = 1;
+        goto exit_1;
+    }
+    t.clients = omf_calloc(t.count, sizeof(sim_client));
+    for(int i = 0; i < t.count; i++) {
+        t.clients[i].index = i;
+        list_create(&t.clients[i].users);
+    }
+    t.yell_sent = omf_calloc(t.yells, sizeof(uint64_t));
+    t.yell_last = omf_calloc(t.yells, sizeof(float));
+    t.latencies = omf_calloc((size_t)t.yells * t.count, sizeof(float));
+
+    printf("Joining %d clients to port %d.\n", t.count, address.port);
+    fflush(stdout);
+    ret = run_test(&t, &address, t.yells, yell_interval, (enet_uint32)timeout_secs * 1000);
+
+    for(int i = 0; i < t.count; i++) {
+        list_free(&t.clients[i].users);
+    }
+    omf_free(t.clients);
+    omf_free(t.yell_sent);
+    omf_free(t.yell_last);
+    omf_free(t.latencies);
+    enet_host_destroy(t.host);
+
+exit_1:
+    enet_deinitialize();
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
@@ -0,0 +1,601 @@
+/** @file main.c
+ * @brief Stand-in lobby server for testing the lobby scene and its protocol locally
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "game/utils/lobby_protocol.h"
+#include "game/utils/serial.h"
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+
+// Same as the log message buffer of the lobby scene, including the terminating zero
+#define MAX_MESSAGE 150
+
+// ENet can not address more peers than this
+#define MAX_CLIENTS 4095
+
+typedef struct server_user {
+    lobby_user info;
+    ENetPeer *peer;
+    struct server_user *opponent; // the user we challenged or were challenged by
+    bool joined;
+    bool challenger;
+    bool relayed; // game packets go through the server to the opponent
+    uint8_t connect_failures;
+} server_user;
+
+typedef struct lobby_server {
+    ENetHost *host;
+    const char *motd;
+    bool verbose;
+    unsigned users;
+    unsigned peak_users;
+    unsigned received;
+    unsigned sent;
+    unsigned relayed;
+} lobby_server;
+
+static void send_serial(lobby_server *server, server_user *user, serial *ser) {
+    ENetPacket *packet = enet_packet_create(ser->data, serial_len(ser), ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(user->peer, 0, packet);
+    server->sent++;
+}
+
+// Sends the same packet to every user that has joined.
+static void broadcast_serial(lobby_server *server, serial *ser) {
+    ENetPacket *packet = enet_packet_create(ser->data, serial_len(ser), ENET_PACKET_FLAG_RELIABLE);
+    for(size_t i = 0; i < server->host->peerCount; i++) {
+        server_user *user = server->host->peers[i].data;
+        if(user != NULL && user->joined) {
+            enet_peer_send(user->peer, 0, packet);
+            server->sent++;
+        }
+    }
+    if(packet->referenceCount == 0) {
+        enet_packet_destroy(packet);
+    }
+}
+
+static void send_control(lobby_server *server, server_user *user, uint8_t control) {
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, control);
+    send_serial(server, user, &ser);
+    serial_free(&ser);
+}
+
+// Text messages are shown by the client as they are, so they need the terminating zero.
+static void write_text(serial *ser, uint8_t control, const char *text) {
+    serial_write_int8(ser, control);
+    serial_write(ser, text, strlen(text) + 1);
+}
+
+static void send_text(lobby_server *server, server_user *user, uint8_t control, const char *text) {
+    serial ser;
+    serial_create(&ser);
+    write_text(&ser, control, text);
+    send_serial(server, user, &ser);
+    serial_free(&ser);
+}
+
+static void send_challenge_error(lobby_server *server, server_user *user, const char *error) {
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, PACKET_CHALLENGE << 4 | CHALLENGE_ERROR);
+    // the client takes the rest of the packet as the message
+    serial_write(&ser, error, strlen(error));
+    send_serial(server, user, &ser);
+    serial_free(&ser);
+}
+
+static void broadcast_presence(lobby_server *server, server_user *user, bool joined) {
+    serial ser;
+    serial_create(&ser);
+    lobby_presence_write(&ser, &user->info, joined);
+    broadcast_serial(server, &ser);
+    serial_free(&ser);
+}
+
+static server_user *find_user(lobby_server *server, uint32_t id) {
+    for(size_t i = 0; i < server->host->peerCount; i++) {
+        server_user *user = server->host->peers[i].data;
+        if(user != NULL && user->joined && user->info.id == id) {
+            return user;
+        }
+    }
+    return NULL;
+}
+
+static bool name_in_use(lobby_server *server, const char *name) {
+    for(size_t i = 0; i < server->host->peerCount; i++) {
+        server_user *user = server->host->peers[i].data;
+        if(user != NULL && user->joined && strcmp(user->info.name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool valid_name(const char *name) {
+    bool has_visible = false;
+    for(const char *c = name; *c; c++) {
+        if(*c < ' ' || *c > '~') {
+            return false;
+        }
+        has_visible |= *c != ' ';
+    }
+    return has_visible;
+}
+
+// Reads the rest of the packet as text, without any terminating zeroes.
+static void read_text(serial *ser, char *buf, size_t size) {
+    size_t len = ser->wpos - ser->rpos;
+    if(len > size - 1) {
+        len = size - 1;
+    }
+    serial_read(ser, buf, len);
+    buf[len] = 0;
+}
+
+static size_t remaining(serial *ser) {
+    return ser->wpos - ser->rpos;
+}
+
+// Ends the challenge or match between the user and their opponent, and makes both available again.
+static void end_challenge(lobby_server *server, server_user *user) {
+    server_user *opponent = user->opponent;
+    user->opponent = NULL;
+    user->relayed = false;
+    user->connect_failures = 0;
+    user->info.status = PRESENCE_AVAILABLE;
+    broadcast_presence(server, user, false);
+    if(opponent != NULL) {
+        opponent->opponent = NULL;
+        opponent->relayed = false;
+        opponent->connect_failures = 0;
+        opponent->info.status = PRESENCE_AVAILABLE;
+        broadcast_presence(server, opponent, false);
+    }
+}
+
+static void handle_join(lobby_server *server, server_user *user, uint8_t control, serial *ser) {
+    char version[LOBBY_VERSION_SIZE];
+    char name[MAX_MESSAGE];
+
+    if(user->joined) {
+        // When relaying, the clients greet their opponent through the server. Nothing to do.
+        return;
+    }
+    if((control & 0xf) != LOBBY_PROTOCOL_VERSION) {
+        send_control(server, user, PACKET_JOIN << 4 | JOIN_ERROR_UNSUPPORTED_PROTOCOL);
+        return;
+    }
+    if(remaining(ser) < 3) {
+        send_control(server, user, PACKET_JOIN << 4 | JOIN_ERROR_NAME_INVALID);
+        return;
+    }
+    uint16_t ext_port = serial_read_uint16(ser);
+    uint8_t version_len = serial_read_int8(ser);
+    if(version_len >= sizeof(version) || version_len > remaining(ser)) {
+        send_control(server, user, PACKET_JOIN << 4 | JOIN_ERROR_NAME_INVALID);
+        return;
+    }
+    serial_read(ser, version, version_len);
+    version[version_len] = 0;
+    read_text(ser, name, sizeof(name));
+    if(strlen(name) >= sizeof(user->info.name) || !valid_name(name)) {
+        send_control(server, user, PACKET_JOIN << 4 | JOIN_ERROR_NAME_INVALID);
+        return;
+    }
+    if(name_in_use(server, name)) {
+        send_control(server, user, PACKET_JOIN << 4 | JOIN_ERROR_NAME_USED);
+        return;
+    }
+
+    memcpy(user->info.name, name, strlen(name) + 1);
+    memcpy(user->info.version, version, version_len + 1);
+    user->info.id = user->peer->connectID;
+    user->info.address = user->peer->address;
+    user->info.port = user->peer->address.port;
+    user->info.ext_port = ext_port;
+    user->info.status = PRESENCE_AVAILABLE;
+
+    serial reply;
+    serial_create(&reply);
+    serial_write_int8(&reply, PACKET_JOIN << 4 | JOIN_SUCCESS);
+    serial_write_uint32(&reply, user->info.id);
+    send_serial(server, user, &reply);
+
+    // tell the new user about everyone else, and then everyone (including the new user) about them
+    for(size_t i = 0; i < server->host->peerCount; i++) {
+        server_user *other = server->host->peers[i].data;
+        if(other != NULL && other->joined) {
+            serial_reset(&reply);
+            lobby_presence_write(&reply, &other->info, false);
+            send_serial(server, user, &reply);
+        }
+    }
+    serial_free(&reply);
+    user->joined = true;
+    broadcast_presence(server, user, true);
+
+    if(server->motd) {
+        send_text(server, user, PACKET_ANNOUNCEMENT << 4, server->motd);
+    }
+
+    server->users++;
+    if(server->users > server->peak_users) {
+        server->peak_users = server->users;
+    }
+    if(server->verbose) {
+        printf("%s joined with version %s, %u users.\n", user->info.name, user->info.version, server->users);
+    }
+}
+
+static void handle_yell(lobby_server *server, server_user *user, serial *ser) {
+    char text[MAX_MESSAGE];
+    char msg[MAX_MESSAGE];
+    read_text(ser, text, sizeof(text));
+    snprintf(msg, sizeof(msg), "%s: %s", user->info.name, text);
+
+    serial out;
+    serial_create(&out);
+    write_text(&out, PACKET_YELL << 4, msg);
+    broadcast_serial(server, &out);
+    serial_free(&out);
+}
+
+static void handle_whisper(lobby_server *server, server_user *user, serial *ser) {
+    char text[MAX_MESSAGE];
+    char msg[MAX_MESSAGE];
+    if(remaining(ser) < 4) {
+        return;
+    }
+    server_user *target = find_user(server, serial_read_uint32(ser));
+    read_text(ser, text, sizeof(text));
+    if(target == NULL) {
+        send_text(server, user, PACKET_WHISPER << 4, "Nobody by that name is in the Arena.");
+        return;
+    }
+    snprintf(msg, sizeof(msg), "%s whispers: %s", user->info.name, text);
+    send_text(server, target, PACKET_WHISPER << 4, msg);
+    if(target != user) {
+        snprintf(msg, sizeof(msg), "You whisper to %s: %s", target->info.name, text);
+        send_text(server, user, PACKET_WHISPER << 4, msg);
+    }
+}
+
+static void handle_challenge(lobby_server *server, server_user *user, uint8_t control, serial *ser) {
+    server_user *opponent = user->opponent;
+    switch(control & 0xf) {
+        case CHALLENGE_OFFER: {
+            if(remaining(ser) < 4) {
+                return;
+            }
+            server_user *target = find_user(server, serial_read_uint32(ser));
+            if(opponent != NULL) {
+                send_challenge_error(server, user, "You already have a challenge pending.");
+            } else if(target == NULL) {
+                send_challenge_error(server, user, "That player has left the Arena.");
+            } else if(target == user) {
+                send_challenge_error(server, user, "This server does not host 1-player games.");
+            } else if(target->opponent != NULL || target->info.status != PRESENCE_AVAILABLE) {
+                send_challenge_error(server, user, "That player is busy.");
+            } else {
+                user->opponent = target;
+                user->challenger = true;
+                user->info.status = PRESENCE_CHALLENGING;
+                target->opponent = user;
+                target->challenger = false;
+                target->info.status = PRESENCE_PONDERING;
+
+                serial out;
+                serial_create(&out);
+                serial_write_int8(&out, PACKET_CHALLENGE << 4 | CHALLENGE_OFFER);
+                serial_write_uint32(&out, user->info.id);
+                send_serial(server, target, &out);
+                serial_free(&out);
+                broadcast_presence(server, user, false);
+                broadcast_presence(server, target, false);
+            }
+        } break;
+        case CHALLENGE_ACCEPT:
+            if(opponent != NULL && !user->challenger) {
+                send_control(server, opponent, control);
+            }
+            break;
+        case CHALLENGE_REJECT:
+            if(opponent != NULL && !user->challenger) {
+                send_control(server, opponent, control);
+                end_challenge(server, user);
+            }
+            break;
+        case CHALLENGE_CANCEL:
+            if(opponent != NULL) {
+                send_control(server, opponent, control);
+                end_challenge(server, user);
+            }
+            break;
+        case CHALLENGE_DONE: {
+            // Both players report the result. The first report counts.
+            if(opponent == NULL || remaining(ser) < 1) {
+                return;
+            }
+            // 1 if the user reporting the result won
+            bool user_won = serial_read_int8(ser) == 1;
+            server_user *won = user_won ? user : opponent;
+            server_user *lost = user_won ? opponent : user;
+            if(won->info.wins < UINT8_MAX) {
+                won->info.wins++;
+            }
+            if(lost->info.losses < UINT8_MAX) {
+                lost->info.losses++;
+            }
+            if(server->verbose) {
+                printf("%s beat %s.\n", won->info.name, lost->info.name);
+            }
+            end_challenge(server, user);
+        } break;
+    }
+}
+
+static void handle_connected(lobby_server *server, server_user *user, uint8_t control) {
+    server_user *opponent = user->opponent;
+    if(opponent == NULL) {
+        return;
+    }
+    if((control & 0xf) == 0) {
+        user->info.status = PRESENCE_FIGHTING;
+        opponent->info.status = PRESENCE_FIGHTING;
+        broadcast_presence(server, user, false);
+        broadcast_presence(server, opponent, false);
+        return;
+    }
+
+    // 1 and 2 are the first and second failed attempt to reach the opponent directly
+    user->connect_failures = control & 0xf;
+    if(user->connect_failures >= 2 && opponent->connect_failures >= 2 && !user->relayed) {
+        user->relayed = true;
+        opponent->relayed = true;
+        send_control(server, user, PACKET_RELAY << 4);
+        send_control(server, opponent, PACKET_RELAY << 4);
+        if(server->verbose) {
+            printf("Relaying between %s and %s.\n", user->info.name, opponent->info.name);
+        }
+    }
+}
+
+static void handle_refresh(lobby_server *server, server_user *user) {
+    if(user->info.status == PRESENCE_FIGHTING) {
+        // back in the lobby after a match that had no result
+        end_challenge(server, user);
+    }
+    serial out;
+    serial_create(&out);
+    for(size_t i = 0; i < server->host->peerCount; i++) {
+        server_user *other = server->host->peers[i].data;
+        if(other != NULL && other->joined) {
+            serial_reset(&out);
+            lobby_presence_write(&out, &other->info, false);
+            send_serial(server, user, &out);
+        }
+    }
+    serial_free(&out);
+}
+
+static void handle_packet(lobby_server *server, server_user *user, ENetEvent *event) {
+    server->received++;
+    if(event->channelID != 0) {
+        // Game packets. Clients copy their inputs to the server, but only relayed ones need to go anywhere.
+        if(user->relayed && user->opponent != NULL) {
+            ENetPacket *packet =
+                enet_packet_create(event->packet->data, event->packet->dataLength, event->packet->flags);
+            enet_peer_send(user->opponent->peer, event->channelID, packet);
+            server->relayed++;
+        }
+        return;
+    }
+    if(event->packet->dataLength == 0) {
+        return;
+    }
+
+    serial ser;
+    serial_create_from(&ser, (const char *)event->packet->data, event->packet->dataLength);
+    uint8_t control = serial_read_int8(&ser);
+    if(!user->joined && control >> 4 != PACKET_JOIN) {
+        serial_free(&ser);
+        return;
+    }
+    switch(control >> 4) {
+        case PACKET_JOIN:
+            handle_join(server, user, control, &ser);
+            break;
+        case PACKET_YELL:
+            handle_yell(server, user, &ser);
+            break;
+        case PACKET_WHISPER:
+            handle_whisper(server, user, &ser);
+            break;
+        case PACKET_CHALLENGE:
+            handle_challenge(server, user, control, &ser);
+            break;
+        case PACKET_CONNECTED:
+            handle_connected(server, user, control);
+            break;
+        case PACKET_REFRESH:
+            handle_refresh(server, user);
+            break;
+        default:
+            if(server->verbose) {
+                printf("Unknown packet type %d from %s.\n", control >> 4, user->info.name);
+            }
+            break;
+    }
+    serial_free(&ser);
+}
+
+static void handle_disconnect(lobby_server *server, server_user *user) {
+    user->peer->data = NULL;
+    if(user->joined) {
+        server->users--;
+        if(user->opponent != NULL) {
+            if(user->opponent->info.status != PRESENCE_FIGHTING) {
+                send_control(server, user->opponent, PACKET_CHALLENGE << 4 | CHALLENGE_CANCEL);
+            }
+            user->opponent->opponent = NULL;
+            end_challenge(server, user->opponent);
+        }
+
+        serial ser;
+        serial_create(&ser);
+        serial_write_int8(&ser, PACKET_DISCONNECT << 4);
+        serial_write_uint32(&ser, user->info.id);
+        broadcast_serial(server, &ser);
+        serial_free(&ser);
+        if(server->verbose) {
+            printf("%s left, %u users.\n", user->info.name, server->users);
+        }
+    }
+    omf_free(user);
+}
+
+static int run_server(lobby_server *server, int run_time) {
+    ENetEvent event;
+    enet_uint32 start = enet_time_get();
+    while(run_time <= 0 || enet_time_get() - start < (enet_uint32)run_time * 1000) {
+        int ret = enet_host_service(server->host, &event, 100);
+        if(ret < 0) {
+            printf("Servicing the host failed.\n");
+            return 1;
+        }
+        // handle everything that is waiting before sending anything out
+        while(ret > 0) {
+            switch(event.type) {
+                case ENET_EVENT_TYPE_CONNECT: {
+                    server_user *user = omf_calloc(1, sizeof(server_user));
+                    user->peer = event.peer;
+                    user->info.status = PRESENCE_STARTING;
+                    event.peer->data = user;
+                } break;
+                case ENET_EVENT_TYPE_RECEIVE:
+                    if(event.peer->data != NULL) {
+                        handle_packet(server, event.peer->data, &event);
+                    }
+                    enet_packet_destroy(event.packet);
+                    break;
+                case ENET_EVENT_TYPE_DISCONNECT:
+                    if(event.peer->data != NULL) {
+                        handle_disconnect(server, event.peer->data);
+                    }
+                    break;
+                case ENET_EVENT_TYPE_NONE:
+                    break;
+            }
+            ret = enet_host_check_events(server->host, &event);
+        }
+        enet_host_flush(server->host);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    lobby_server server;
+    int ret = 0;
+    memset(&server, 0, sizeof(server));
+
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *port = arg_int0("p", "port", "<port>", "Port to listen on (default: 2098)");
+    struct arg_int *clients = arg_int0("c", "clients", "<count>", "Maximum number of connections (default: 512)");
+    struct arg_str *motd = arg_str0("m", "motd", "<text>", "Announcement shown to users when they join");
+    struct arg_int *run_time = arg_int0("t", "time", "<seconds>", "Stop after this long (default: never)");
+    struct arg_lit *verbose = arg_lit0(NULL, "verbose", "Print joins, leaves and results");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, port, clients, motd, run_time, verbose, end};
+    const char *progname = "lobbyserver";
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 lobby server.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    int max_clients = clients->count > 0 ? clients->ival[0] : 512;
+    if(max_clients < 1 || max_clients > MAX_CLIENTS) {
+        printf("The number of connections must be between 1 and %d.\n", MAX_CLIENTS);
+        ret = 1;
+        goto exit_0;
+    }
+    server.motd = motd->count > 0 ? motd->sval[0] : NULL;
+    server.verbose = verbose->count > 0;
+
+    if(enet_initialize() != 0) {
+        printf("Failed to initialize enet.\n");
+        ret = 1;
+        goto exit_0;
+    }
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = port->count > 0 ? port->ival[0] : LOBBY_PORT;
+    server.host = enet_host_create(&address, max_clients, 3, 0, 0);
+    if(server.host == NULL) {
+        printf("Unable to listen on port %d.\n", address.port);
+        ret = 1;
+        goto exit_1;
+    }
+
+    printf("Lobby server listening on port %d for up to %d users.\n", address.port, max_clients);
+    fflush(stdout);
+    ret = run_server(&server, run_time->count > 0 ? run_time->ival[0] : 0);
+    printf("%u packets received, %u sent, %u relayed, at most %u users.\n", server.received, server.sent,
+           server.relayed, server.peak_users);
+
+    for(size_t i = 0; i < server.host->peerCount; i++) {
+        omf_free(server.host->peers[i].data);
+    }
+    enet_host_destroy(server.host);
+
+exit_1:
+    enet_deinitialize();
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
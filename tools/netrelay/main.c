@@ -0,0 +1,310 @@
+/** @file main.c
+ * @brief UDP relay that adds latency, jitter, reordering and loss between two netplay peers
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+#include "utils/random.h"
+
+#define MAX_PACKET 2048
+#define MAX_PENDING 4096
+
+// Extra time a reordered packet is held back, so that the packets after it overtake it.
+#define REORDER_HOLD_MS 20
+
+enum
+{
+    TO_SERVER,
+    TO_CLIENT
+};
+
+typedef struct pending_packet {
+    enet_uint32 deliver_at;
+    int direction;
+    size_t len;
+    unsigned char data[MAX_PACKET];
+} pending_packet;
+
+typedef struct relay_stats {
+    unsigned received;
+    unsigned dropped;
+    unsigned reordered;
+    unsigned overflowed;
+    unsigned sent;
+} relay_stats;
+
+typedef struct relay {
+    ENetSocket client_socket; // The client connects here
+    ENetSocket server_socket; // Talks to the server on behalf of the client
+    ENetAddress client;
+    ENetAddress server;
+    bool has_client;
+    int delay;
+    int jitter;
+    int loss;
+    int reorder;
+    struct random_t rand;
+    pending_packet *pending;
+    int pending_count;
+    relay_stats stats[2];
+} relay;
+
+static const char *direction_names[] = {"client -> server", "server -> client"};
+
+static void queue_packet(relay *r, int direction, const unsigned char *data, size_t len, enet_uint32 now) {
+    relay_stats *stats = &r->stats[direction];
+    stats->received++;
+    if(r->loss > 0 && (int)random_int(&r->rand, 100) < r->loss) {
+        stats->dropped++;
+        return;
+    }
+    if(r->pending_count >= MAX_PENDING) {
+        stats->overflowed++;
+        return;
+    }
+    pending_packet *p = &r->pending[r->pending_count++];
+    p->deliver_at = now + r->delay + (r->jitter > 0 ? random_int(&r->rand, r->jitter + 1) : 0);
+    if(r->reorder > 0 && (int)random_int(&r->rand, 100) < r->reorder) {
+        p->deliver_at += REORDER_HOLD_MS;
+        stats->reordered++;
+    }
+    p->direction = direction;
+    p->len = len;
+    memcpy(p->data, data, len);
+}
+
+// Sends the packets that are due, and returns how long until the next one is, capped to max_wait.
+static enet_uint32 deliver_packets(relay *r, enet_uint32 now, enet_uint32 max_wait) {
+    enet_uint32 wait = max_wait;
+    int i = 0;
+    while(i < r->pending_count) {
+        pending_packet *p = &r->pending[i];
+        if(p->deliver_at > now) {
+            if(p->deliver_at - now < wait) {
+                wait = p->deliver_at - now;
+            }
+            i++;
+            continue;
+        }
+        ENetBuffer buf;
+        buf.data = p->data;
+        buf.dataLength = p->len;
+        if(p->direction == TO_SERVER) {
+            enet_socket_send(r->server_socket, &r->server, &buf, 1);
+        } else {
+            enet_socket_send(r->client_socket, &r->client, &buf, 1);
+        }
+        r->stats[p->direction].sent++;
+
+        // Keep the queue in arrival order, so that packets with the same deadline go out in order.
+        r->pending_count--;
+        memmove(p, p + 1, (r->pending_count - i) * sizeof(pending_packet));
+    }
+    return wait;
+}
+
+// Reads everything that is waiting on the socket. Returns the number of packets read.
+static int receive_packets(relay *r, ENetSocket socket, int direction, enet_uint32 now) {
+    unsigned char data[MAX_PACKET];
+    ENetAddress from;
+    ENetBuffer buf;
+    int count = 0;
+    while(true) {
+        buf.data = data;
+        buf.dataLength = sizeof(data);
+        int len = enet_socket_receive(socket, &from, &buf, 1);
+        if(len <= 0) {
+            return count;
+        }
+        if(direction == TO_SERVER) {
+            // The first peer to send anything is the client. Packets from anyone else are not ours.
+            if(!r->has_client) {
+                r->client = from;
+                r->has_client = true;
+                printf("Client connected from port %d.\n", from.port);
+            } else if(from.host != r->client.host || from.port != r->client.port) {
+                continue;
+            }
+        }
+        queue_packet(r, direction, data, len, now);
+        count++;
+    }
+}
+
+static void print_stats(relay *r) {
+    for(int i = 0; i < 2; i++) {
+        relay_stats *s = &r->stats[i];
+        printf("%s: %u received, %u dropped, %u reordered, %u overflowed, %u sent\n", direction_names[i], s->received,
+               s->dropped, s->reordered, s->overflowed, s->sent);
+    }
+}
+
+static int run_relay(relay *r, int idle_timeout) {
+    enet_uint32 last_packet = enet_time_get();
+    while(true) {
+        enet_uint32 now = enet_time_get();
+        if(now - last_packet > (enet_uint32)idle_timeout * 1000) {
+            printf("No traffic for %d seconds, stopping.\n", idle_timeout);
+            return 0;
+        }
+
+        enet_uint32 wait = deliver_packets(r, now, 100);
+        ENetSocketSet set;
+        ENET_SOCKETSET_EMPTY(set);
+        ENET_SOCKETSET_ADD(set, r->client_socket);
+        ENET_SOCKETSET_ADD(set, r->server_socket);
+        ENetSocket max_socket = r->client_socket > r->server_socket ? r->client_socket : r->server_socket;
+        if(enet_socketset_select(max_socket, &set, NULL, wait) < 0) {
+            printf("Waiting for packets failed.\n");
+            return 1;
+        }
+
+        now = enet_time_get();
+        int count = 0;
+        if(ENET_SOCKETSET_CHECK(set, r->client_socket)) {
+            count += receive_packets(r, r->client_socket, TO_SERVER, now);
+        }
+        if(ENET_SOCKETSET_CHECK(set, r->server_socket) && r->has_client) {
+            count += receive_packets(r, r->server_socket, TO_CLIENT, now);
+        }
+        if(count > 0) {
+            last_packet = now;
+        }
+    }
+}
+
+static ENetSocket open_socket(enet_uint16 port) {
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = port;
+    ENetSocket socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if(socket == ENET_SOCKET_NULL) {
+        return ENET_SOCKET_NULL;
+    }
+    if(enet_socket_bind(socket, &address) < 0) {
+        enet_socket_destroy(socket);
+        return ENET_SOCKET_NULL;
+    }
+    enet_socket_set_option(socket, ENET_SOCKOPT_NONBLOCK, 1);
+    return socket;
+}
+
+int main(int argc, char *argv[]) {
+    relay r;
+    int ret = 0;
+    memset(&r, 0, sizeof(r));
+    r.client_socket = ENET_SOCKET_NULL;
+    r.server_socket = ENET_SOCKET_NULL;
+
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *port = arg_int0("p", "port", "<port>", "Port for the client to connect to (default: 2098)");
+    struct arg_str *server = arg_str0("s", "server", "<host>", "Address of the server (default: 127.0.0.1)");
+    struct arg_int *server_port = arg_int0(NULL, "server-port", "<port>", "Port of the server (default: 2097)");
+    struct arg_int *delay = arg_int0("d", "delay", "<ms>", "One way delay added to every packet");
+    struct arg_int *jitter = arg_int0("j", "jitter", "<ms>", "Random extra delay of up to this much");
+    struct arg_int *loss = arg_int0("l", "loss", "<percent>", "Chance of dropping a packet");
+    struct arg_int *reorder =
+        arg_int0("r", "reorder", "<percent>", "Chance of holding a packet back behind later ones");
+    struct arg_int *seed = arg_int0(NULL, "seed", "<seed>", "Random seed (default: 1)");
+    struct arg_int *idle = arg_int0("t", "idle", "<seconds>", "Stop after this long without traffic (default: 10)");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, port, server, server_port, delay, jitter, loss, reorder, seed, idle, end};
+    const char *progname = "netrelay";
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 netplay network emulator.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    r.delay = delay->count > 0 ? delay->ival[0] : 0;
+    r.jitter = jitter->count > 0 ? jitter->ival[0] : 0;
+    r.loss = loss->count > 0 ? loss->ival[0] : 0;
+    r.reorder = reorder->count > 0 ? reorder->ival[0] : 0;
+    if(r.delay < 0 || r.jitter < 0 || r.loss < 0 || r.loss > 100 || r.reorder < 0 || r.reorder > 100) {
+        printf("Delays can not be negative, and chances must be between 0 and 100.\n");
+        ret = 1;
+        goto exit_0;
+    }
+    random_seed(&r.rand, seed->count > 0 ? seed->ival[0] : 1);
+
+    if(enet_initialize() != 0) {
+        printf("Failed to initialize enet.\n");
+        ret = 1;
+        goto exit_0;
+    }
+    if(enet_address_set_host(&r.server, server->count > 0 ? server->sval[0] : "127.0.0.1") < 0) {
+        printf("Unable to resolve the server address.\n");
+        ret = 1;
+        goto exit_1;
+    }
+    r.server.port = server_port->count > 0 ? server_port->ival[0] : 2097;
+    r.client_socket = open_socket(port->count > 0 ? port->ival[0] : 2098);
+    r.server_socket = open_socket(0);
+    if(r.client_socket == ENET_SOCKET_NULL || r.server_socket == ENET_SOCKET_NULL) {
+        printf("Unable to open the relay sockets.\n");
+        ret = 1;
+        goto exit_2;
+    }
+    r.pending = omf_calloc(MAX_PENDING, sizeof(pending_packet));
+
+    printf("Relaying to port %d with %d ms delay, %d ms jitter, %d%% loss and %d%% reordering.\n", r.server.port,
+           r.delay, r.jitter, r.loss, r.reorder);
+    fflush(stdout);
+    ret = run_relay(&r, idle->count > 0 ? idle->ival[0] : 10);
+    print_stats(&r);
+    omf_free(r.pending);
+
+exit_2:
+    if(r.client_socket != ENET_SOCKET_NULL) {
+        enet_socket_destroy(r.client_socket);
+    }
+    if(r.server_socket != ENET_SOCKET_NULL) {
+        enet_socket_destroy(r.server_socket);
+    }
+exit_1:
+    enet_deinitialize();
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
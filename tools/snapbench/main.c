@@ -0,0 +1,146 @@
+/** @file main.c
+ * @brief Game state snapshot restore benchmark tool
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/object.h"
+#include "game/protos/scene.h"
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+
+#define SNAP_SCRIPT "s05bpd1bps1bpn64A100-s1sf3B10-C34"
+
+static game_state gs;
+static scene sc;
+
+static void add_object(int x) {
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, &gs, vec2i_create(x, 100), vec2f_create(1.0f, 0.0f));
+    object_set_custom_string(obj, SNAP_SCRIPT);
+    game_state_add_object(&gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+}
+
+// A bare game state with a number of animated objects, kept around for rollbacks like the net controller does
+static void create_state(int objects) {
+    memset(&gs, 0, sizeof(game_state));
+    memset(&sc, 0, sizeof(scene));
+    ticktimer_init(&sc.tick_timer);
+    gs.sc = &sc;
+    gs.clone = true;
+    vector_create(&gs.objects, sizeof(render_obj));
+    object_index_create(&gs.obj_index);
+    vector_create(&gs.sounds, sizeof(playing_sound));
+    game_state_set_keep_deleted(&gs, true);
+    for(int i = 0; i < 2; i++) {
+        gs.players[i] = omf_calloc(1, sizeof(game_player));
+        game_player_create(gs.players[i]);
+    }
+    for(int i = 0; i < objects; i++) {
+        add_object(i);
+    }
+}
+
+static void free_state(void) {
+    game_state_set_keep_deleted(&gs, false);
+    for(unsigned int i = 0; i < vector_size(&gs.objects); i++) {
+        object *obj = ((render_obj *)vector_get(&gs.objects, i))->obj;
+        object_free(obj);
+        omf_free(obj);
+    }
+    vector_free(&gs.objects);
+    object_index_free(&gs.obj_index);
+    vector_free(&gs.sounds);
+    for(int i = 0; i < 2; i++) {
+        game_player_free(gs.players[i]);
+        omf_free(gs.players[i]);
+    }
+    ticktimer_close(&sc.tick_timer);
+}
+
+int main(int argc, char *argv[]) {
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *objects = arg_int0("o", "objects", "<n>", "How many objects the game state has (default 200)");
+    struct arg_int *rounds = arg_int0("n", "rounds", "<n>", "How many restores to time (default 1000)");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, objects, rounds, end};
+    const char *progname = "snapbench";
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 game state snapshot benchmark.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    int object_count = objects->count > 0 ? objects->ival[0] : 200;
+    int round_count = rounds->count > 0 ? rounds->ival[0] : 1000;
+    if(object_count <= 0 || round_count <= 0) {
+        printf("Object and round counts must be positive.\n");
+        goto exit_0;
+    }
+
+    create_state(object_count);
+    serial ser;
+    serial_create(&ser);
+    game_state_serialize(&gs, &ser);
+
+    size_t allocs = omf_alloc_count();
+    uint64_t freq = SDL_GetPerformanceFrequency();
+    uint64_t start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < round_count; i++) {
+        // Every rollback undoes a deletion, like a projectile that hit something after the snapshot
+        game_state_del_object(&gs, ((render_obj *)vector_get(&gs.objects, i % object_count))->obj);
+        serial_read_reset(&ser);
+        game_state_unserialize(&gs, &ser);
+    }
+    uint64_t end_time = SDL_GetPerformanceCounter();
+
+    printf("restoring %d objects (%zu bytes) took %.2f us per tick, %zu allocations in %d restores\n", object_count,
+           ser.wpos, (double)(end_time - start) * 1000000.0 / freq / round_count, omf_alloc_count() - allocs,
+           round_count);
+    serial_free(&ser);
+    free_state();
+
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return 0;
+}
@@ -0,0 +1,271 @@
+/** @file main.c
+ * @brief Finds the first tick and field where two state traces diverge
+ * @license MIT
+ */
+
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "utils/c_array_util.h"
+#include "utils/hashmap.h"
+#include "utils/iterator.h"
+
+#define MAX_LINE 16384
+
+// Replays the section changes of a trace file written by openomf --state-trace, one tick at a time.
+typedef struct trace_reader {
+    const char *filename;
+    FILE *fp;
+    char line[MAX_LINE];
+    bool has_line;
+    uint32_t tick;
+    char hash[17];
+    hashmap sections; // section name -> "<hash> <synced> <fields>"
+} trace_reader;
+
+static bool reader_open(trace_reader *r, const char *filename) {
+    memset(r, 0, sizeof(trace_reader));
+    r->filename = filename;
+    r->fp = fopen(filename, "r");
+    if(r->fp == NULL) {
+        printf("Unable to open %s.\n", filename);
+        return false;
+    }
+    hashmap_create(&r->sections);
+    return true;
+}
+
+static void reader_close(trace_reader *r) {
+    if(r->fp != NULL) {
+        fclose(r->fp);
+        hashmap_free(&r->sections);
+    }
+}
+
+static bool read_line(trace_reader *r) {
+    if(r->has_line) {
+        return true;
+    }
+    while(fgets(r->line, sizeof(r->line), r->fp) != NULL) {
+        r->line[strcspn(r->line, "\r\n")] = 0;
+        if(r->line[0] != 0 && r->line[0] != '#') {
+            r->has_line = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Splits "<name> <rest>" in place, and returns rest.
+static char *split_name(char *line) {
+    char *space = strchr(line, ' ');
+    if(space == NULL) {
+        return line + strlen(line);
+    }
+    *space = 0;
+    return space + 1;
+}
+
+// Moves to the next tick, and applies all of its section changes.
+static bool reader_next(trace_reader *r) {
+    if(!read_line(r)) {
+        return false;
+    }
+    r->has_line = false;
+    if(sscanf(r->line, "T %" SCNu32 " %16s", &r->tick, r->hash) != 2) {
+        printf("%s: expected a tick, got '%s'.\n", r->filename, r->line);
+        return false;
+    }
+    while(read_line(r) && r->line[0] != 'T') {
+        r->has_line = false;
+        char *name = r->line + 2;
+        if(r->line[0] == 'S') {
+            char *rest = split_name(name);
+            hashmap_put_str(&r->sections, name, rest, strlen(rest) + 1);
+        } else if(r->line[0] == 'D') {
+            hashmap_del_str(&r->sections, name);
+        }
+    }
+    return true;
+}
+
+static const char *section_fields(const char *section) {
+    const char *fields = strchr(section, ' ');
+    fields = fields ? strchr(fields + 1, ' ') : NULL;
+    return fields ? fields + 1 : "";
+}
+
+static bool section_synced(const char *section) {
+    const char *synced = strchr(section, ' ');
+    return synced != NULL && synced[1] == '1';
+}
+
+// Finds the value of name in a "name=value name=value" list. Returns its length, or -1 if it is missing.
+static int find_field(const char *fields, const char *name, size_t name_len, const char **value) {
+    const char *p = fields;
+    while(*p) {
+        const char *end = strchr(p, ' ');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if(len > name_len && p[name_len] == '=' && strncmp(p, name, name_len) == 0) {
+            *value = p + name_len + 1;
+            return (int)(len - name_len - 1);
+        }
+        p += end ? len + 1 : len;
+    }
+    return -1;
+}
+
+static void print_field_diff(const char *a, const char *b) {
+    const char *p = a;
+    while(*p) {
+        const char *end = strchr(p, ' ');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        const char *eq = memchr(p, '=', len);
+        if(eq != NULL) {
+            size_t name_len = eq - p;
+            int a_len = (int)(len - name_len - 1);
+            const char *b_value;
+            int b_len = find_field(b, p, name_len, &b_value);
+            if(b_len < 0) {
+                printf("    %.*s: %.*s -> (missing)\n", (int)name_len, p, a_len, eq + 1);
+            } else if(a_len != b_len || strncmp(eq + 1, b_value, a_len) != 0) {
+                printf("    %.*s: %.*s -> %.*s\n", (int)name_len, p, a_len, eq + 1, b_len, b_value);
+            }
+        }
+        p += end ? len + 1 : len;
+    }
+}
+
+// Prints the sections that differ between the traces. Returns the number of differing synced sections.
+static int print_diff(trace_reader *a, trace_reader *b, bool cosmetic) {
+    iterator it;
+    hashmap_pair *pair;
+    char *other;
+    int synced_count = 0;
+
+    hashmap_iter_begin(&a->sections, &it);
+    foreach(it, pair) {
+        const char *name = pair->key;
+        const char *mine = pair->value;
+        bool synced = section_synced(mine);
+        if(!synced && !cosmetic) {
+            continue;
+        }
+        if(hashmap_get_str(&b->sections, name, (void **)&other, NULL) != 0) {
+            printf("  %s%s: only in %s\n", name, synced ? "" : " (cosmetic)", a->filename);
+            synced_count += synced;
+        } else if(strcmp(mine, other) != 0) {
+            printf("  %s%s:\n", name, synced ? "" : " (cosmetic)");
+            print_field_diff(section_fields(mine), section_fields(other));
+            synced_count += synced;
+        }
+    }
+
+    hashmap_iter_begin(&b->sections, &it);
+    foreach(it, pair) {
+        bool synced = section_synced(pair->value);
+        if((synced || cosmetic) && hashmap_get_str(&a->sections, pair->key, (void **)&other, NULL) != 0) {
+            printf("  %s%s: only in %s\n", (const char *)pair->key, synced ? "" : " (cosmetic)", b->filename);
+            synced_count += synced;
+        }
+    }
+    return synced_count;
+}
+
+// Returns 1 if the traces diverge, 0 if not.
+static int compare_traces(trace_reader *a, trace_reader *b, bool cosmetic) {
+    uint32_t ticks = 0;
+    bool has_a = reader_next(a);
+    bool has_b = reader_next(b);
+    while(has_a && has_b) {
+        // A peer may start tracing later than the other, so line the ticks up first.
+        if(a->tick < b->tick) {
+            has_a = reader_next(a);
+            continue;
+        }
+        if(b->tick < a->tick) {
+            has_b = reader_next(b);
+            continue;
+        }
+        if(strcmp(a->hash, b->hash) != 0) {
+            printf("First divergence at tick %" PRIu32 ", after %" PRIu32 " matching ticks.\n", a->tick, ticks);
+            if(print_diff(a, b, cosmetic) == 0) {
+                printf("  No differing sections found; the traces were written by different versions?\n");
+            }
+            return 1;
+        }
+        ticks++;
+        has_a = reader_next(a);
+        has_b = reader_next(b);
+    }
+    printf("No divergence in %" PRIu32 " matching ticks.\n", ticks);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    trace_reader readers[2];
+    int ret = 0;
+    memset(readers, 0, sizeof(readers));
+
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_file *files = arg_filen(NULL, NULL, "<file>", 2, 2, "Two state traces written with --state-trace");
+    struct arg_lit *cosmetic = arg_lit0("c", "cosmetic", "Also show sections that are not synced between peers");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, files, cosmetic, end};
+    const char *progname = "statebisect";
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 state trace comparison tool.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    if(!reader_open(&readers[0], files->filename[0]) || !reader_open(&readers[1], files->filename[1])) {
+        ret = 2;
+        goto exit_1;
+    }
+    ret = compare_traces(&readers[0], &readers[1], cosmetic->count > 0);
+
+exit_1:
+    reader_close(&readers[0]);
+    reader_close(&readers[1]);
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}